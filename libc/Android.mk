@@ -15,16 +15,24 @@ libc_common_src_files := \
 	stdio/asprintf.c \
 	stdio/fflush.c \
 	stdio/fgetc.c \
+	stdio/fgets.c \
 	stdio/findfp.c \
+	stdio/fmemopen.c \
 	stdio/fprintf.c \
 	stdio/fputc.c \
+	stdio/fputs.c \
 	stdio/fread.c \
 	stdio/freopen.c \
 	stdio/fscanf.c \
 	stdio/fseek.c \
+	stdio/fsetlocking.c \
 	stdio/ftell.c \
 	stdio/fvwrite.c \
+	stdio/fwrite.c \
 	stdio/gets.c \
+	stdio/grisu.c \
+	stdio/makebuf.c \
+	stdio/open_memstream.c \
 	stdio/printf.c \
 	stdio/refill.c \
 	stdio/rewind.c \
@@ -37,11 +45,15 @@ libc_common_src_files := \
 	stdio/vasprintf.c \
 	stdio/vfprintf.c \
 	stdio/vfscanf.c \
+	stdio/vfwprintf.c \
+	stdio/vfwscanf.c \
 	stdio/vprintf.c \
 	stdio/vsnprintf.c \
 	stdio/vsprintf.c \
 	stdio/vscanf.c \
 	stdio/vsscanf.c \
+	stdio/vswprintf.c \
+	stdio/vswscanf.c \
 	stdio/wbuf.c \
 	stdlib/atexit.c \
 	stdlib/ctype_.c \
@@ -50,20 +62,12 @@ libc_common_src_files := \
 	stdlib/putenv.c \
 	stdlib/setenv.c \
 	stdlib/strtod.c \
-	stdlib/strtoimax.c \
-	stdlib/strtol.c \
-	stdlib/strtoll.c \
-	stdlib/strtoul.c \
-	stdlib/strtoull.c \
-	stdlib/strtoumax.c \
 	stdlib/tolower_.c \
 	stdlib/toupper_.c \
 	string/strcasecmp.c \
-	string/strcspn.c \
 	string/strdup.c \
 	string/strpbrk.c \
 	string/strsep.c \
-	string/strspn.c \
 	string/strstr.c \
 	string/strtok.c \
 	wchar/wcswidth.c \
@@ -202,19 +206,37 @@ libc_common_src_files += \
 
 libc_bionic_src_files := \
     bionic/abort.cpp \
+    bionic/android_copy_fd.cpp \
+    bionic/android_cpu_topology.cpp \
+    bionic/android_futex.cpp \
+    bionic/android_realpath_cache.cpp \
+    bionic/android_remote_memory.cpp \
+    bionic/android_trace_events.cpp \
+    bionic/android_tree_walk.cpp \
     bionic/assert.cpp \
     bionic/brk.cpp \
     bionic/dirent.cpp \
+    bionic/elf_tls.cpp \
+    bionic/epoll_pwait.cpp \
     bionic/__errno.c \
     bionic/eventfd_read.cpp \
     bionic/eventfd_write.cpp \
+    bionic/fallocate.cpp \
     bionic/futimens.cpp \
     bionic/getauxval.cpp \
     bionic/getcwd.cpp \
+    bionic/gettid.cpp \
+    bionic/hsearch.cpp \
+    bionic/hugepage.cpp \
+    bionic/libc_counters.cpp \
     bionic/libc_init_common.cpp \
     bionic/libc_logging.cpp \
     bionic/libgen.cpp \
     bionic/mmap.cpp \
+    bionic/posix_fadvise.cpp \
+    bionic/posix_spawn.cpp \
+    bionic/ppoll.cpp \
+    bionic/preadv.cpp \
     bionic/pthread_attr.cpp \
     bionic/pthread_detach.cpp \
     bionic/pthread_equal.cpp \
@@ -227,22 +249,29 @@ libc_bionic_src_files := \
     bionic/pthread_setname_np.cpp \
     bionic/pthread_setschedparam.cpp \
     bionic/pthread_sigmask.cpp \
+    bionic/qsort.cpp \
     bionic/raise.cpp \
     bionic/sbrk.cpp \
     bionic/scandir.cpp \
     bionic/sched_getaffinity.cpp \
     bionic/__set_errno.cpp \
     bionic/setlocale.cpp \
+    bionic/sha1_x4.cpp \
+    bionic/sigaction.cpp \
     bionic/signalfd.cpp \
     bionic/sigwait.cpp \
     bionic/statvfs.cpp \
     bionic/strerror.cpp \
     bionic/strerror_r.cpp \
     bionic/strsignal.cpp \
+    bionic/strtol.cpp \
     bionic/stubs.cpp \
+    bionic/sync_file_range.cpp \
     bionic/sysconf.cpp \
     bionic/tdestroy.cpp \
+    bionic/tsearch.cpp \
     bionic/tmpfile.cpp \
+    bionic/vdso.cpp \
     bionic/wait.cpp \
     bionic/wchar.cpp \
 
@@ -261,19 +290,15 @@ libc_upstream_freebsd_src_files := \
     upstream-freebsd/lib/libc/stdio/ferror.c \
     upstream-freebsd/lib/libc/stdio/fgetln.c \
     upstream-freebsd/lib/libc/stdio/fgetpos.c \
-    upstream-freebsd/lib/libc/stdio/fgets.c \
     upstream-freebsd/lib/libc/stdio/fileno.c \
     upstream-freebsd/lib/libc/stdio/flags.c \
     upstream-freebsd/lib/libc/stdio/fopen.c \
     upstream-freebsd/lib/libc/stdio/fpurge.c \
-    upstream-freebsd/lib/libc/stdio/fputs.c \
     upstream-freebsd/lib/libc/stdio/fsetpos.c \
     upstream-freebsd/lib/libc/stdio/funopen.c \
     upstream-freebsd/lib/libc/stdio/fwalk.c \
-    upstream-freebsd/lib/libc/stdio/fwrite.c \
     upstream-freebsd/lib/libc/stdio/getc.c \
     upstream-freebsd/lib/libc/stdio/getchar.c \
-    upstream-freebsd/lib/libc/stdio/makebuf.c \
     upstream-freebsd/lib/libc/stdio/mktemp.c \
     upstream-freebsd/lib/libc/stdio/putc.c \
     upstream-freebsd/lib/libc/stdio/putchar.c \
@@ -293,7 +318,6 @@ libc_upstream_freebsd_src_files := \
     upstream-freebsd/lib/libc/stdlib/imaxdiv.c \
     upstream-freebsd/lib/libc/stdlib/labs.c \
     upstream-freebsd/lib/libc/stdlib/llabs.c \
-    upstream-freebsd/lib/libc/stdlib/qsort.c \
     upstream-freebsd/lib/libc/stdlib/realpath.c \
     upstream-freebsd/lib/libc/string/wcpcpy.c \
     upstream-freebsd/lib/libc/string/wcpncpy.c \
@@ -351,9 +375,6 @@ libc_upstream_netbsd_src_files := \
     upstream-netbsd/libc/stdlib/_rand48.c \
     upstream-netbsd/libc/stdlib/seed48.c \
     upstream-netbsd/libc/stdlib/srand48.c \
-    upstream-netbsd/libc/stdlib/tdelete.c \
-    upstream-netbsd/libc/stdlib/tfind.c \
-    upstream-netbsd/libc/stdlib/tsearch.c \
     upstream-netbsd/libc/string/memccpy.c \
     upstream-netbsd/libc/string/strcasestr.c \
     upstream-netbsd/libc/string/strcoll.c \
@@ -369,20 +390,14 @@ libc_common_src_files += \
 	string/strncmp.c \
 	string/strncat.c \
 	string/strncpy.c \
-	bionic/strchr.cpp \
 	string/strrchr.c \
-	bionic/memchr.c \
-	bionic/memrchr.c \
 	string/index.c \
 	bionic/strnlen.c \
 	string/strlcat.c \
 	string/strlcpy.c \
-	upstream-freebsd/lib/libc/string/wcschr.c \
 	upstream-freebsd/lib/libc/string/wcsrchr.c \
-	upstream-freebsd/lib/libc/string/wcscmp.c \
 	upstream-freebsd/lib/libc/string/wcscpy.c \
 	upstream-freebsd/lib/libc/string/wmemcmp.c \
-	upstream-freebsd/lib/libc/string/wcslen.c \
 	upstream-freebsd/lib/libc/string/wcscat.c
 
 # These files need to be arm so that gdbserver
@@ -427,6 +442,8 @@ libc_common_src_files += \
 	string/strncpy.c \
 	bionic/strchr.cpp \
 	string/strrchr.c \
+	string/strcspn.c \
+	string/strspn.c \
 	bionic/memchr.c \
 	bionic/memrchr.c \
 	string/index.c \
@@ -638,10 +655,12 @@ $(GEN): $(TARGET_OUT_INTERMEDIATE_LIBRARIES)/crtend_so.o
 ALL_GENERATED_SOURCES += $(GEN)
 
 
+# crtbegin_static is position-independent so that it can start static PIEs
+# too: __libc_init relocates those itself.
 GEN := $(TARGET_OUT_INTERMEDIATE_LIBRARIES)/crtbegin_static1.o
 $(GEN): $(libc_crt_target_crtbegin_file)
 	@mkdir -p $(dir $@)
-	$(hide) $(TARGET_CC) $(libc_crt_target_cflags) \
+	$(hide) $(TARGET_CC) $(libc_crt_target_cflags) -fPIE \
 		-MD -MF $(@:%.o=%.d) -o $@ -c $<
 	$(transform-d-to-p)
 -include $(GEN:%.o=%.P)
@@ -854,7 +873,10 @@ LOCAL_SRC_FILES := \
 	$(libc_arch_static_src_files) \
 	$(libc_static_common_src_files) \
 	bionic/dlmalloc.c \
+	bionic/malloc_arena.cpp \
 	bionic/malloc_debug_common.cpp \
+	bionic/malloc_slab.cpp \
+	bionic/malloc_thread_cache.cpp \
 	bionic/libc_init_static.cpp
 
 LOCAL_CFLAGS := $(libc_common_cflags) \
@@ -887,7 +909,10 @@ LOCAL_SRC_FILES := \
 	$(libc_arch_dynamic_src_files) \
 	$(libc_static_common_src_files) \
 	bionic/dlmalloc.c \
+	bionic/malloc_arena.cpp \
 	bionic/malloc_debug_common.cpp \
+	bionic/malloc_slab.cpp \
+	bionic/malloc_thread_cache.cpp \
 	bionic/pthread_debug.cpp \
 	bionic/libc_init_dynamic.cpp
 
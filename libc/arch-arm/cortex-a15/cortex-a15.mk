@@ -1,9 +1,18 @@
+$(call libc-add-cpu-variant-src,MEMCHR,arch-arm/cortex-a15/bionic/memchr.S)
+$(call libc-add-cpu-variant-src,MEMCMP,arch-arm/cortex-a15/bionic/memcmp.S)
 $(call libc-add-cpu-variant-src,MEMCPY,arch-arm/cortex-a15/bionic/memcpy.S)
+$(call libc-add-cpu-variant-src,MEMRCHR,arch-arm/cortex-a15/bionic/memrchr.S)
 $(call libc-add-cpu-variant-src,MEMSET,arch-arm/cortex-a15/bionic/memset.S)
 $(call libc-add-cpu-variant-src,STRCAT,arch-arm/cortex-a15/bionic/strcat.S)
+$(call libc-add-cpu-variant-src,STRCHR,arch-arm/cortex-a15/bionic/strchr.S)
 $(call libc-add-cpu-variant-src,STRCMP,arch-arm/cortex-a15/bionic/strcmp.S)
 $(call libc-add-cpu-variant-src,STRCPY,arch-arm/cortex-a15/bionic/strcpy.S)
+$(call libc-add-cpu-variant-src,STRCSPN,arch-arm/cortex-a15/bionic/strcspn.S)
 $(call libc-add-cpu-variant-src,STRLEN,arch-arm/cortex-a15/bionic/strlen.S)
+$(call libc-add-cpu-variant-src,STRSPN,arch-arm/cortex-a15/bionic/strspn.S)
+$(call libc-add-cpu-variant-src,WCSCHR,arch-arm/cortex-a15/bionic/wcschr.S)
+$(call libc-add-cpu-variant-src,WCSCMP,arch-arm/cortex-a15/bionic/wcscmp.S)
+$(call libc-add-cpu-variant-src,WCSLEN,arch-arm/cortex-a15/bionic/wcslen.S)
 $(call libc-add-cpu-variant-src,__STRCAT_CHK,arch-arm/cortex-a15/bionic/__strcat_chk.S)
 $(call libc-add-cpu-variant-src,__STRCPY_CHK,arch-arm/cortex-a15/bionic/__strcpy_chk.S)
 
@@ -6,5 +6,14 @@ $(call libc-add-cpu-variant-src,STRCPY,arch-arm/cortex-a9/bionic/strcpy.S)
 $(call libc-add-cpu-variant-src,STRLEN,arch-arm/cortex-a9/bionic/strlen.S)
 $(call libc-add-cpu-variant-src,__STRCAT_CHK,arch-arm/cortex-a9/bionic/__strcat_chk.S)
 $(call libc-add-cpu-variant-src,__STRCPY_CHK,arch-arm/cortex-a9/bionic/__strcpy_chk.S)
+# Use cortex-a15 versions of memchr/memrchr/strchr/strcspn/strspn/wcschr/wcscmp/wcslen.
+$(call libc-add-cpu-variant-src,MEMCHR,arch-arm/cortex-a15/bionic/memchr.S)
+$(call libc-add-cpu-variant-src,MEMRCHR,arch-arm/cortex-a15/bionic/memrchr.S)
+$(call libc-add-cpu-variant-src,STRCHR,arch-arm/cortex-a15/bionic/strchr.S)
+$(call libc-add-cpu-variant-src,STRCSPN,arch-arm/cortex-a15/bionic/strcspn.S)
+$(call libc-add-cpu-variant-src,STRSPN,arch-arm/cortex-a15/bionic/strspn.S)
+$(call libc-add-cpu-variant-src,WCSCHR,arch-arm/cortex-a15/bionic/wcschr.S)
+$(call libc-add-cpu-variant-src,WCSCMP,arch-arm/cortex-a15/bionic/wcscmp.S)
+$(call libc-add-cpu-variant-src,WCSLEN,arch-arm/cortex-a15/bionic/wcslen.S)
 
 include bionic/libc/arch-arm/generic/generic.mk
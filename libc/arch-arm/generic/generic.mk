@@ -1,8 +1,17 @@
+$(call libc-add-cpu-variant-src,MEMCHR,bionic/memchr.c)
+$(call libc-add-cpu-variant-src,MEMCMP,arch-arm/bionic/memcmp.S)
 $(call libc-add-cpu-variant-src,MEMCPY,arch-arm/generic/bionic/memcpy.S)
+$(call libc-add-cpu-variant-src,MEMRCHR,bionic/memrchr.c)
 $(call libc-add-cpu-variant-src,MEMSET,arch-arm/generic/bionic/memset.S)
 $(call libc-add-cpu-variant-src,STRCAT,string/strcat.c)
+$(call libc-add-cpu-variant-src,STRCHR,bionic/strchr.cpp)
 $(call libc-add-cpu-variant-src,STRCMP,arch-arm/generic/bionic/strcmp.S)
 $(call libc-add-cpu-variant-src,STRCPY,arch-arm/generic/bionic/strcpy.S)
+$(call libc-add-cpu-variant-src,STRCSPN,string/strcspn.c)
 $(call libc-add-cpu-variant-src,STRLEN,arch-arm/generic/bionic/strlen.c)
+$(call libc-add-cpu-variant-src,STRSPN,string/strspn.c)
+$(call libc-add-cpu-variant-src,WCSCHR,upstream-freebsd/lib/libc/string/wcschr.c)
+$(call libc-add-cpu-variant-src,WCSCMP,upstream-freebsd/lib/libc/string/wcscmp.c)
+$(call libc-add-cpu-variant-src,WCSLEN,upstream-freebsd/lib/libc/string/wcslen.c)
 $(call libc-add-cpu-variant-src,__STRCAT_CHK,bionic/__strcat_chk.cpp)
 $(call libc-add-cpu-variant-src,__STRCPY_CHK,bionic/__strcpy_chk.cpp)
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#undef _FORTIFY_SOURCE
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/auxv.h>
+#include <unistd.h>
+
+#include "../../../bionic/libc_init_common.h"
+
+// From the kernel's <asm/hwcap.h>.
+#define HWCAP_NEON (1 << 12)
+
+// The variants' own entry points (see the other files in this directory).
+#define DECLARE_CPU_VARIANT(v) \
+  extern "C" void* memcpy_##v(void*, const void*, size_t); \
+  extern "C" void* __memcpy_chk_##v(void*, const void*, size_t, size_t); \
+  extern "C" void* memset_##v(void*, int, size_t); \
+  extern "C" void* __memset_chk_##v(void*, int, size_t, size_t); \
+  extern "C" void bzero_##v(void*, size_t); \
+  extern "C" int strcmp_##v(const char*, const char*)
+
+// Krait has no strcat, strcpy or strlen of its own.
+#define DECLARE_CPU_VARIANT_STR(v) \
+  extern "C" char* strcat_##v(char*, const char*); \
+  extern "C" char* strcpy_##v(char*, const char*); \
+  extern "C" size_t strlen_##v(const char*)
+
+DECLARE_CPU_VARIANT(generic);
+DECLARE_CPU_VARIANT(a9);
+DECLARE_CPU_VARIANT(a15);
+DECLARE_CPU_VARIANT(krait);
+DECLARE_CPU_VARIANT_STR(generic);
+DECLARE_CPU_VARIANT_STR(a9);
+DECLARE_CPU_VARIANT_STR(a15);
+
+struct StringFunctions {
+  void* (*memcpy_fn)(void*, const void*, size_t);
+  void* (*memcpy_chk_fn)(void*, const void*, size_t, size_t);
+  void* (*memset_fn)(void*, int, size_t);
+  void* (*memset_chk_fn)(void*, int, size_t, size_t);
+  void (*bzero_fn)(void*, size_t);
+  int (*strcmp_fn)(const char*, const char*);
+  char* (*strcat_fn)(char*, const char*);
+  char* (*strcpy_fn)(char*, const char*);
+  size_t (*strlen_fn)(const char*);
+};
+
+#define CPU_VARIANT_FUNCTIONS(v, str_v) \
+  { memcpy_##v, __memcpy_chk_##v, memset_##v, __memset_chk_##v, bzero_##v, strcmp_##v, \
+    strcat_##str_v, strcpy_##str_v, strlen_##str_v }
+
+static const StringFunctions gA9Functions = CPU_VARIANT_FUNCTIONS(a9, a9);
+static const StringFunctions gA15Functions = CPU_VARIANT_FUNCTIONS(a15, a15);
+static const StringFunctions gKraitFunctions = CPU_VARIANT_FUNCTIONS(krait, a15);
+
+// The variant chosen by __libc_init_cpu_variant(), before any other thread can
+// exist. Until then, the generic routines are called directly: the dynamic
+// linker has its own copy of these functions and uses them before relocating
+// itself, when a pointer to the generic table wouldn't be valid yet.
+static const StringFunctions* gStringFunctions = NULL;
+
+void* memcpy(void* dst, const void* src, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memcpy_generic(dst, src, n);
+  }
+  return fns->memcpy_fn(dst, src, n);
+}
+
+extern "C" void* __memcpy_chk(void* dst, const void* src, size_t n, size_t dst_len) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return __memcpy_chk_generic(dst, src, n, dst_len);
+  }
+  return fns->memcpy_chk_fn(dst, src, n, dst_len);
+}
+
+void* memset(void* s, int c, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memset_generic(s, c, n);
+  }
+  return fns->memset_fn(s, c, n);
+}
+
+extern "C" void* __memset_chk(void* s, int c, size_t n, size_t dst_len) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return __memset_chk_generic(s, c, n, dst_len);
+  }
+  return fns->memset_chk_fn(s, c, n, dst_len);
+}
+
+void bzero(void* s, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    bzero_generic(s, n);
+    return;
+  }
+  fns->bzero_fn(s, n);
+}
+
+int strcmp(const char* lhs, const char* rhs) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strcmp_generic(lhs, rhs);
+  }
+  return fns->strcmp_fn(lhs, rhs);
+}
+
+char* strcat(char* dst, const char* src) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strcat_generic(dst, src);
+  }
+  return fns->strcat_fn(dst, src);
+}
+
+char* strcpy(char* dst, const char* src) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strcpy_generic(dst, src);
+  }
+  return fns->strcpy_fn(dst, src);
+}
+
+size_t strlen(const char* s) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strlen_generic(s);
+  }
+  return fns->strlen_fn(s);
+}
+
+// Returns the value of the first "name : value" line in 'cpuinfo', or 0.
+static unsigned long cpuinfo_field(const char* cpuinfo, const char* name) {
+  const char* line = strstr(cpuinfo, name);
+  if (line == NULL) {
+    return 0;
+  }
+  const char* colon = strchr(line, ':');
+  if (colon == NULL) {
+    return 0;
+  }
+  return strtoul(colon + 1, NULL, 0);
+}
+
+// User space can't read MIDR, so the core comes from /proc/cpuinfo. Only the
+// first core's lines are looked at: the cores of a big.LITTLE pair map to the
+// same variant. Unknown cores, and unreadable /proc/cpuinfo, get the cortex-a15
+// routines.
+static const StringFunctions* cpu_variant_functions() {
+  int fd = open("/proc/cpuinfo", O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return &gA15Functions;
+  }
+  char cpuinfo[4096];
+  size_t length = 0;
+  while (length < sizeof(cpuinfo) - 1) {
+    ssize_t n = read(fd, cpuinfo + length, sizeof(cpuinfo) - 1 - length);
+    if (n <= 0) {
+      break;
+    }
+    length += n;
+  }
+  close(fd);
+  cpuinfo[length] = '\0';
+
+  unsigned long implementer = cpuinfo_field(cpuinfo, "CPU implementer");
+  unsigned long part = cpuinfo_field(cpuinfo, "CPU part");
+  if (implementer == 0x41) {
+    switch (part) {
+      case 0xc07: // Cortex-A7.
+      case 0xc08: // Cortex-A8.
+      case 0xc0f: // Cortex-A15.
+        return &gA15Functions;
+      case 0xc09: // Cortex-A9.
+        return &gA9Functions;
+    }
+  } else if (implementer == 0x51) {
+    switch (part) {
+      case 0x04d: // Krait 200.
+      case 0x06f: // Krait 300 and later.
+        return &gKraitFunctions;
+    }
+  }
+  // Any other core with NEON is at least an ARMv7-A, which is all that the
+  // cortex-a15 routines assume.
+  return &gA15Functions;
+}
+
+// Every variant but the generic one uses NEON, which not every Cortex-A9 has.
+void __libc_init_cpu_variant() {
+  if ((getauxval(AT_HWCAP) & HWCAP_NEON) != 0) {
+    gStringFunctions = cpu_variant_functions();
+  }
+}
@@ -0,0 +1,30 @@
+# For images that run on more than one of the other variants' cores. Each
+# variant's memcpy, memset, strcat, strcmp, strcpy and strlen is built under
+# names of its own, and cpu_variant.cpp picks one set at startup. The generic
+# versions take the variant slots so that generic.mk doesn't add its own.
+$(call libc-add-cpu-variant-src,MEMCPY,arch-arm/runtime/bionic/memcpy_generic.S)
+$(call libc-add-cpu-variant-src,MEMSET,arch-arm/runtime/bionic/memset_generic.S)
+$(call libc-add-cpu-variant-src,STRCAT,arch-arm/runtime/bionic/strcat_generic.c)
+$(call libc-add-cpu-variant-src,STRCMP,arch-arm/runtime/bionic/strcmp_generic.S)
+$(call libc-add-cpu-variant-src,STRCPY,arch-arm/runtime/bionic/strcpy_generic.S)
+$(call libc-add-cpu-variant-src,STRLEN,arch-arm/runtime/bionic/strlen_generic.c)
+
+_LIBC_ARCH_COMMON_SRC_FILES += \
+    arch-arm/runtime/bionic/cpu_variant.cpp \
+    arch-arm/runtime/bionic/memcpy_a15.S \
+    arch-arm/runtime/bionic/memcpy_a9.S \
+    arch-arm/runtime/bionic/memcpy_krait.S \
+    arch-arm/runtime/bionic/memset_a15.S \
+    arch-arm/runtime/bionic/memset_a9.S \
+    arch-arm/runtime/bionic/memset_krait.S \
+    arch-arm/runtime/bionic/strcat_a15.S \
+    arch-arm/runtime/bionic/strcat_a9.S \
+    arch-arm/runtime/bionic/strcmp_a15.S \
+    arch-arm/runtime/bionic/strcmp_a9.S \
+    arch-arm/runtime/bionic/strcmp_krait.S \
+    arch-arm/runtime/bionic/strcpy_a15.S \
+    arch-arm/runtime/bionic/strcpy_a9.S \
+    arch-arm/runtime/bionic/strlen_a15.S \
+    arch-arm/runtime/bionic/strlen_a9.S \
+
+include bionic/libc/arch-arm/generic/generic.mk
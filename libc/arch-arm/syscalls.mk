@@ -14,7 +14,8 @@ syscall_src += arch-arm/syscalls/geteuid.S
 syscall_src += arch-arm/syscalls/getegid.S
 syscall_src += arch-arm/syscalls/getresuid.S
 syscall_src += arch-arm/syscalls/getresgid.S
-syscall_src += arch-arm/syscalls/gettid.S
+syscall_src += arch-arm/syscalls/__gettid.S
+syscall_src += arch-arm/syscalls/__set_tid_address.S
 syscall_src += arch-arm/syscalls/readahead.S
 syscall_src += arch-arm/syscalls/getgroups.S
 syscall_src += arch-arm/syscalls/getpgid.S
@@ -27,6 +28,8 @@ syscall_src += arch-arm/syscalls/__setresuid.S
 syscall_src += arch-arm/syscalls/setresgid.S
 syscall_src += arch-arm/syscalls/__brk.S
 syscall_src += arch-arm/syscalls/__ptrace.S
+syscall_src += arch-arm/syscalls/process_vm_readv.S
+syscall_src += arch-arm/syscalls/process_vm_writev.S
 syscall_src += arch-arm/syscalls/__getpriority.S
 syscall_src += arch-arm/syscalls/setpriority.S
 syscall_src += arch-arm/syscalls/setrlimit.S
@@ -34,7 +37,6 @@ syscall_src += arch-arm/syscalls/getrlimit.S
 syscall_src += arch-arm/syscalls/getrusage.S
 syscall_src += arch-arm/syscalls/setgroups.S
 syscall_src += arch-arm/syscalls/setpgid.S
-syscall_src += arch-arm/syscalls/vfork.S
 syscall_src += arch-arm/syscalls/setregid.S
 syscall_src += arch-arm/syscalls/chroot.S
 syscall_src += arch-arm/syscalls/prctl.S
@@ -46,6 +48,8 @@ syscall_src += arch-arm/syscalls/read.S
 syscall_src += arch-arm/syscalls/write.S
 syscall_src += arch-arm/syscalls/pread64.S
 syscall_src += arch-arm/syscalls/pwrite64.S
+syscall_src += arch-arm/syscalls/__preadv64.S
+syscall_src += arch-arm/syscalls/__pwritev64.S
 syscall_src += arch-arm/syscalls/__open.S
 syscall_src += arch-arm/syscalls/__openat.S
 syscall_src += arch-arm/syscalls/close.S
@@ -73,17 +77,24 @@ syscall_src += arch-arm/syscalls/dup.S
 syscall_src += arch-arm/syscalls/pipe.S
 syscall_src += arch-arm/syscalls/pipe2.S
 syscall_src += arch-arm/syscalls/dup2.S
+syscall_src += arch-arm/syscalls/dup3.S
 syscall_src += arch-arm/syscalls/select.S
 syscall_src += arch-arm/syscalls/ftruncate.S
 syscall_src += arch-arm/syscalls/ftruncate64.S
 syscall_src += arch-arm/syscalls/getdents.S
 syscall_src += arch-arm/syscalls/fsync.S
 syscall_src += arch-arm/syscalls/fdatasync.S
+syscall_src += arch-arm/syscalls/__arm_fadvise64_64.S
+syscall_src += arch-arm/syscalls/__sync_file_range2.S
+syscall_src += arch-arm/syscalls/fallocate64.S
 syscall_src += arch-arm/syscalls/fchown.S
 syscall_src += arch-arm/syscalls/sync.S
 syscall_src += arch-arm/syscalls/__fcntl64.S
 syscall_src += arch-arm/syscalls/__fstatfs64.S
 syscall_src += arch-arm/syscalls/sendfile.S
+syscall_src += arch-arm/syscalls/splice.S
+syscall_src += arch-arm/syscalls/tee.S
+syscall_src += arch-arm/syscalls/vmsplice.S
 syscall_src += arch-arm/syscalls/fstatat.S
 syscall_src += arch-arm/syscalls/mkdirat.S
 syscall_src += arch-arm/syscalls/fchownat.S
@@ -129,11 +140,11 @@ syscall_src += arch-arm/syscalls/unshare.S
 syscall_src += arch-arm/syscalls/swapon.S
 syscall_src += arch-arm/syscalls/swapoff.S
 syscall_src += arch-arm/syscalls/pause.S
-syscall_src += arch-arm/syscalls/gettimeofday.S
+syscall_src += arch-arm/syscalls/__gettimeofday.S
 syscall_src += arch-arm/syscalls/settimeofday.S
 syscall_src += arch-arm/syscalls/times.S
 syscall_src += arch-arm/syscalls/nanosleep.S
-syscall_src += arch-arm/syscalls/clock_gettime.S
+syscall_src += arch-arm/syscalls/__clock_gettime.S
 syscall_src += arch-arm/syscalls/clock_settime.S
 syscall_src += arch-arm/syscalls/clock_getres.S
 syscall_src += arch-arm/syscalls/clock_nanosleep.S
@@ -149,8 +160,7 @@ syscall_src += arch-arm/syscalls/utimensat.S
 syscall_src += arch-arm/syscalls/timerfd_create.S
 syscall_src += arch-arm/syscalls/timerfd_settime.S
 syscall_src += arch-arm/syscalls/timerfd_gettime.S
-syscall_src += arch-arm/syscalls/sigaction.S
-syscall_src += arch-arm/syscalls/sigprocmask.S
+syscall_src += arch-arm/syscalls/__sigaction.S
 syscall_src += arch-arm/syscalls/__sigsuspend.S
 syscall_src += arch-arm/syscalls/__rt_sigaction.S
 syscall_src += arch-arm/syscalls/__rt_sigprocmask.S
@@ -163,6 +173,7 @@ syscall_src += arch-arm/syscalls/bind.S
 syscall_src += arch-arm/syscalls/connect.S
 syscall_src += arch-arm/syscalls/listen.S
 syscall_src += arch-arm/syscalls/accept.S
+syscall_src += arch-arm/syscalls/accept4.S
 syscall_src += arch-arm/syscalls/getsockname.S
 syscall_src += arch-arm/syscalls/getpeername.S
 syscall_src += arch-arm/syscalls/sendto.S
@@ -172,6 +183,8 @@ syscall_src += arch-arm/syscalls/setsockopt.S
 syscall_src += arch-arm/syscalls/getsockopt.S
 syscall_src += arch-arm/syscalls/sendmsg.S
 syscall_src += arch-arm/syscalls/recvmsg.S
+syscall_src += arch-arm/syscalls/sendmmsg.S
+syscall_src += arch-arm/syscalls/recvmmsg.S
 syscall_src += arch-arm/syscalls/sched_setscheduler.S
 syscall_src += arch-arm/syscalls/sched_getscheduler.S
 syscall_src += arch-arm/syscalls/sched_yield.S
@@ -197,12 +210,21 @@ syscall_src += arch-arm/syscalls/personality.S
 syscall_src += arch-arm/syscalls/perf_event_open.S
 syscall_src += arch-arm/syscalls/futex.S
 syscall_src += arch-arm/syscalls/epoll_create.S
+syscall_src += arch-arm/syscalls/epoll_create1.S
 syscall_src += arch-arm/syscalls/epoll_ctl.S
 syscall_src += arch-arm/syscalls/epoll_wait.S
+syscall_src += arch-arm/syscalls/__epoll_pwait.S
 syscall_src += arch-arm/syscalls/inotify_init.S
+syscall_src += arch-arm/syscalls/inotify_init1.S
 syscall_src += arch-arm/syscalls/inotify_add_watch.S
 syscall_src += arch-arm/syscalls/inotify_rm_watch.S
 syscall_src += arch-arm/syscalls/poll.S
+syscall_src += arch-arm/syscalls/__ppoll.S
 syscall_src += arch-arm/syscalls/eventfd.S
+syscall_src += arch-arm/syscalls/io_setup.S
+syscall_src += arch-arm/syscalls/io_destroy.S
+syscall_src += arch-arm/syscalls/io_submit.S
+syscall_src += arch-arm/syscalls/io_getevents.S
+syscall_src += arch-arm/syscalls/io_cancel.S
 syscall_src += arch-arm/syscalls/__set_tls.S
 syscall_src += arch-arm/syscalls/cacheflush.S
@@ -15,7 +15,8 @@ syscall_src += arch-mips/syscalls/geteuid.S
 syscall_src += arch-mips/syscalls/getegid.S
 syscall_src += arch-mips/syscalls/getresuid.S
 syscall_src += arch-mips/syscalls/getresgid.S
-syscall_src += arch-mips/syscalls/gettid.S
+syscall_src += arch-mips/syscalls/__gettid.S
+syscall_src += arch-mips/syscalls/__set_tid_address.S
 syscall_src += arch-mips/syscalls/readahead.S
 syscall_src += arch-mips/syscalls/getgroups.S
 syscall_src += arch-mips/syscalls/getpgid.S
@@ -31,6 +32,8 @@ syscall_src += arch-mips/syscalls/kill.S
 syscall_src += arch-mips/syscalls/tkill.S
 syscall_src += arch-mips/syscalls/tgkill.S
 syscall_src += arch-mips/syscalls/__ptrace.S
+syscall_src += arch-mips/syscalls/process_vm_readv.S
+syscall_src += arch-mips/syscalls/process_vm_writev.S
 syscall_src += arch-mips/syscalls/__set_thread_area.S
 syscall_src += arch-mips/syscalls/__getpriority.S
 syscall_src += arch-mips/syscalls/setpriority.S
@@ -50,6 +53,8 @@ syscall_src += arch-mips/syscalls/read.S
 syscall_src += arch-mips/syscalls/write.S
 syscall_src += arch-mips/syscalls/pread64.S
 syscall_src += arch-mips/syscalls/pwrite64.S
+syscall_src += arch-mips/syscalls/__preadv64.S
+syscall_src += arch-mips/syscalls/__pwritev64.S
 syscall_src += arch-mips/syscalls/__open.S
 syscall_src += arch-mips/syscalls/__openat.S
 syscall_src += arch-mips/syscalls/close.S
@@ -76,17 +81,24 @@ syscall_src += arch-mips/syscalls/fchmod.S
 syscall_src += arch-mips/syscalls/dup.S
 syscall_src += arch-mips/syscalls/pipe2.S
 syscall_src += arch-mips/syscalls/dup2.S
+syscall_src += arch-mips/syscalls/dup3.S
 syscall_src += arch-mips/syscalls/select.S
 syscall_src += arch-mips/syscalls/ftruncate.S
 syscall_src += arch-mips/syscalls/ftruncate64.S
 syscall_src += arch-mips/syscalls/getdents.S
 syscall_src += arch-mips/syscalls/fsync.S
 syscall_src += arch-mips/syscalls/fdatasync.S
+syscall_src += arch-mips/syscalls/__fadvise64.S
+syscall_src += arch-mips/syscalls/__sync_file_range.S
+syscall_src += arch-mips/syscalls/fallocate64.S
 syscall_src += arch-mips/syscalls/fchown.S
 syscall_src += arch-mips/syscalls/sync.S
 syscall_src += arch-mips/syscalls/__fcntl64.S
 syscall_src += arch-mips/syscalls/__fstatfs64.S
 syscall_src += arch-mips/syscalls/sendfile.S
+syscall_src += arch-mips/syscalls/splice.S
+syscall_src += arch-mips/syscalls/tee.S
+syscall_src += arch-mips/syscalls/vmsplice.S
 syscall_src += arch-mips/syscalls/fstatat.S
 syscall_src += arch-mips/syscalls/mkdirat.S
 syscall_src += arch-mips/syscalls/fchownat.S
@@ -132,11 +144,11 @@ syscall_src += arch-mips/syscalls/unshare.S
 syscall_src += arch-mips/syscalls/swapon.S
 syscall_src += arch-mips/syscalls/swapoff.S
 syscall_src += arch-mips/syscalls/pause.S
-syscall_src += arch-mips/syscalls/gettimeofday.S
+syscall_src += arch-mips/syscalls/__gettimeofday.S
 syscall_src += arch-mips/syscalls/settimeofday.S
 syscall_src += arch-mips/syscalls/times.S
 syscall_src += arch-mips/syscalls/nanosleep.S
-syscall_src += arch-mips/syscalls/clock_gettime.S
+syscall_src += arch-mips/syscalls/__clock_gettime.S
 syscall_src += arch-mips/syscalls/clock_settime.S
 syscall_src += arch-mips/syscalls/clock_getres.S
 syscall_src += arch-mips/syscalls/clock_nanosleep.S
@@ -152,8 +164,7 @@ syscall_src += arch-mips/syscalls/utimensat.S
 syscall_src += arch-mips/syscalls/timerfd_create.S
 syscall_src += arch-mips/syscalls/timerfd_settime.S
 syscall_src += arch-mips/syscalls/timerfd_gettime.S
-syscall_src += arch-mips/syscalls/sigaction.S
-syscall_src += arch-mips/syscalls/sigprocmask.S
+syscall_src += arch-mips/syscalls/__sigaction.S
 syscall_src += arch-mips/syscalls/__sigsuspend.S
 syscall_src += arch-mips/syscalls/__rt_sigaction.S
 syscall_src += arch-mips/syscalls/__rt_sigprocmask.S
@@ -166,6 +177,7 @@ syscall_src += arch-mips/syscalls/bind.S
 syscall_src += arch-mips/syscalls/connect.S
 syscall_src += arch-mips/syscalls/listen.S
 syscall_src += arch-mips/syscalls/accept.S
+syscall_src += arch-mips/syscalls/accept4.S
 syscall_src += arch-mips/syscalls/getsockname.S
 syscall_src += arch-mips/syscalls/getpeername.S
 syscall_src += arch-mips/syscalls/sendto.S
@@ -175,6 +187,8 @@ syscall_src += arch-mips/syscalls/setsockopt.S
 syscall_src += arch-mips/syscalls/getsockopt.S
 syscall_src += arch-mips/syscalls/sendmsg.S
 syscall_src += arch-mips/syscalls/recvmsg.S
+syscall_src += arch-mips/syscalls/sendmmsg.S
+syscall_src += arch-mips/syscalls/recvmmsg.S
 syscall_src += arch-mips/syscalls/sched_setscheduler.S
 syscall_src += arch-mips/syscalls/sched_getscheduler.S
 syscall_src += arch-mips/syscalls/sched_yield.S
@@ -200,12 +214,21 @@ syscall_src += arch-mips/syscalls/personality.S
 syscall_src += arch-mips/syscalls/perf_event_open.S
 syscall_src += arch-mips/syscalls/futex.S
 syscall_src += arch-mips/syscalls/epoll_create.S
+syscall_src += arch-mips/syscalls/epoll_create1.S
 syscall_src += arch-mips/syscalls/epoll_ctl.S
 syscall_src += arch-mips/syscalls/epoll_wait.S
+syscall_src += arch-mips/syscalls/__epoll_pwait.S
 syscall_src += arch-mips/syscalls/inotify_init.S
+syscall_src += arch-mips/syscalls/inotify_init1.S
 syscall_src += arch-mips/syscalls/inotify_add_watch.S
 syscall_src += arch-mips/syscalls/inotify_rm_watch.S
 syscall_src += arch-mips/syscalls/poll.S
+syscall_src += arch-mips/syscalls/__ppoll.S
 syscall_src += arch-mips/syscalls/eventfd.S
+syscall_src += arch-mips/syscalls/io_setup.S
+syscall_src += arch-mips/syscalls/io_destroy.S
+syscall_src += arch-mips/syscalls/io_submit.S
+syscall_src += arch-mips/syscalls/io_getevents.S
+syscall_src += arch-mips/syscalls/io_cancel.S
 syscall_src += arch-mips/syscalls/_flush_cache.S
 syscall_src += arch-mips/syscalls/syscall.S
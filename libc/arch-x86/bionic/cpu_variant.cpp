@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cpuid.h>
+#include <string.h>
+
+#include "../../bionic/libc_init_common.h"
+
+// The routines to choose from (see the files in ../string).
+extern "C" void* memcpy_atom(void*, const void*, size_t);
+extern "C" void* memset_atom(void*, int, size_t);
+extern "C" void* memchr_atom(const void*, int, size_t);
+extern "C" int memcmp_atom(const void*, const void*, size_t);
+extern "C" int strcmp_atom(const char*, const char*);
+extern "C" size_t strlen_atom(const char*);
+
+extern "C" void* memcpy_avx2(void*, const void*, size_t);
+extern "C" void* memset_avx2(void*, int, size_t);
+extern "C" void* memchr_avx2(const void*, int, size_t);
+extern "C" int memcmp_avx2(const void*, const void*, size_t);
+extern "C" int strcmp_sse4(const char*, const char*);
+extern "C" size_t strlen_avx2(const char*);
+
+struct StringFunctions {
+  void* (*memcpy_fn)(void*, const void*, size_t);
+  void* (*memset_fn)(void*, int, size_t);
+  void* (*memchr_fn)(const void*, int, size_t);
+  int (*memcmp_fn)(const void*, const void*, size_t);
+  int (*strcmp_fn)(const char*, const char*);
+  size_t (*strlen_fn)(const char*);
+};
+
+static const StringFunctions gSse4Functions = {
+  memcpy_atom, memset_atom, memchr_atom, memcmp_atom, strcmp_sse4, strlen_atom
+};
+
+static const StringFunctions gAvx2Functions = {
+  memcpy_avx2, memset_avx2, memchr_avx2, memcmp_avx2, strcmp_sse4, strlen_avx2
+};
+
+// The functions chosen by __libc_init_cpu_variant(), before any other thread
+// can exist. Until then, and on cores with neither SSE4.2 nor AVX2, the atom
+// routines are called directly: the dynamic linker has its own copy of these
+// functions and uses them before relocating itself, when a pointer to a table
+// wouldn't be valid yet.
+static const StringFunctions* gStringFunctions = NULL;
+
+void* memcpy(void* dst, const void* src, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memcpy_atom(dst, src, n);
+  }
+  return fns->memcpy_fn(dst, src, n);
+}
+
+void* memset(void* s, int c, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memset_atom(s, c, n);
+  }
+  return fns->memset_fn(s, c, n);
+}
+
+void* memchr(const void* s, int c, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memchr_atom(s, c, n);
+  }
+  return fns->memchr_fn(s, c, n);
+}
+
+int memcmp(const void* lhs, const void* rhs, size_t n) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return memcmp_atom(lhs, rhs, n);
+  }
+  return fns->memcmp_fn(lhs, rhs, n);
+}
+
+int strcmp(const char* lhs, const char* rhs) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strcmp_atom(lhs, rhs);
+  }
+  return fns->strcmp_fn(lhs, rhs);
+}
+
+size_t strlen(const char* s) {
+  const StringFunctions* fns = gStringFunctions;
+  if (__predict_false(fns == NULL)) {
+    return strlen_atom(s);
+  }
+  return fns->strlen_fn(s);
+}
+
+// AVX2 needs the kernel to save the upper halves of the ymm registers, which
+// it says by setting OSXSAVE and those bits of XCR0.
+static bool cpu_has_avx2(unsigned int cpuid1_ecx) {
+  if ((cpuid1_ecx & (bit_OSXSAVE | bit_AVX)) != (bit_OSXSAVE | bit_AVX)) {
+    return false;
+  }
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__ (".byte 0x0f, 0x01, 0xd0" /* xgetbv */ : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0_lo & 6) != 6) { // XMM and YMM state.
+    return false;
+  }
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_max(0, NULL) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1 << 5)) != 0; // bit_AVX2, which older <cpuid.h> lack.
+}
+
+void __libc_init_cpu_variant() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_SSE4_2) == 0) {
+    return;
+  }
+  gStringFunctions = cpu_has_avx2(ecx) ? &gAvx2Functions : &gSse4Functions;
+}
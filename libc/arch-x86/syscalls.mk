@@ -15,7 +15,8 @@ syscall_src += arch-x86/syscalls/geteuid.S
 syscall_src += arch-x86/syscalls/getegid.S
 syscall_src += arch-x86/syscalls/getresuid.S
 syscall_src += arch-x86/syscalls/getresgid.S
-syscall_src += arch-x86/syscalls/gettid.S
+syscall_src += arch-x86/syscalls/__gettid.S
+syscall_src += arch-x86/syscalls/__set_tid_address.S
 syscall_src += arch-x86/syscalls/readahead.S
 syscall_src += arch-x86/syscalls/getgroups.S
 syscall_src += arch-x86/syscalls/getpgid.S
@@ -31,6 +32,8 @@ syscall_src += arch-x86/syscalls/kill.S
 syscall_src += arch-x86/syscalls/tkill.S
 syscall_src += arch-x86/syscalls/tgkill.S
 syscall_src += arch-x86/syscalls/__ptrace.S
+syscall_src += arch-x86/syscalls/process_vm_readv.S
+syscall_src += arch-x86/syscalls/process_vm_writev.S
 syscall_src += arch-x86/syscalls/__set_thread_area.S
 syscall_src += arch-x86/syscalls/__getpriority.S
 syscall_src += arch-x86/syscalls/setpriority.S
@@ -50,6 +53,8 @@ syscall_src += arch-x86/syscalls/read.S
 syscall_src += arch-x86/syscalls/write.S
 syscall_src += arch-x86/syscalls/pread64.S
 syscall_src += arch-x86/syscalls/pwrite64.S
+syscall_src += arch-x86/syscalls/__preadv64.S
+syscall_src += arch-x86/syscalls/__pwritev64.S
 syscall_src += arch-x86/syscalls/__open.S
 syscall_src += arch-x86/syscalls/__openat.S
 syscall_src += arch-x86/syscalls/close.S
@@ -77,17 +82,24 @@ syscall_src += arch-x86/syscalls/dup.S
 syscall_src += arch-x86/syscalls/pipe.S
 syscall_src += arch-x86/syscalls/pipe2.S
 syscall_src += arch-x86/syscalls/dup2.S
+syscall_src += arch-x86/syscalls/dup3.S
 syscall_src += arch-x86/syscalls/select.S
 syscall_src += arch-x86/syscalls/ftruncate.S
 syscall_src += arch-x86/syscalls/ftruncate64.S
 syscall_src += arch-x86/syscalls/getdents.S
 syscall_src += arch-x86/syscalls/fsync.S
 syscall_src += arch-x86/syscalls/fdatasync.S
+syscall_src += arch-x86/syscalls/__fadvise64.S
+syscall_src += arch-x86/syscalls/__sync_file_range.S
+syscall_src += arch-x86/syscalls/fallocate64.S
 syscall_src += arch-x86/syscalls/fchown.S
 syscall_src += arch-x86/syscalls/sync.S
 syscall_src += arch-x86/syscalls/__fcntl64.S
 syscall_src += arch-x86/syscalls/__fstatfs64.S
 syscall_src += arch-x86/syscalls/sendfile.S
+syscall_src += arch-x86/syscalls/splice.S
+syscall_src += arch-x86/syscalls/tee.S
+syscall_src += arch-x86/syscalls/vmsplice.S
 syscall_src += arch-x86/syscalls/fstatat.S
 syscall_src += arch-x86/syscalls/mkdirat.S
 syscall_src += arch-x86/syscalls/fchownat.S
@@ -133,11 +145,11 @@ syscall_src += arch-x86/syscalls/unshare.S
 syscall_src += arch-x86/syscalls/swapon.S
 syscall_src += arch-x86/syscalls/swapoff.S
 syscall_src += arch-x86/syscalls/pause.S
-syscall_src += arch-x86/syscalls/gettimeofday.S
+syscall_src += arch-x86/syscalls/__gettimeofday.S
 syscall_src += arch-x86/syscalls/settimeofday.S
 syscall_src += arch-x86/syscalls/times.S
 syscall_src += arch-x86/syscalls/nanosleep.S
-syscall_src += arch-x86/syscalls/clock_gettime.S
+syscall_src += arch-x86/syscalls/__clock_gettime.S
 syscall_src += arch-x86/syscalls/clock_settime.S
 syscall_src += arch-x86/syscalls/clock_getres.S
 syscall_src += arch-x86/syscalls/clock_nanosleep.S
@@ -153,8 +165,7 @@ syscall_src += arch-x86/syscalls/utimensat.S
 syscall_src += arch-x86/syscalls/timerfd_create.S
 syscall_src += arch-x86/syscalls/timerfd_settime.S
 syscall_src += arch-x86/syscalls/timerfd_gettime.S
-syscall_src += arch-x86/syscalls/sigaction.S
-syscall_src += arch-x86/syscalls/sigprocmask.S
+syscall_src += arch-x86/syscalls/__sigaction.S
 syscall_src += arch-x86/syscalls/__sigsuspend.S
 syscall_src += arch-x86/syscalls/__rt_sigaction.S
 syscall_src += arch-x86/syscalls/__rt_sigprocmask.S
@@ -176,6 +187,9 @@ syscall_src += arch-x86/syscalls/setsockopt.S
 syscall_src += arch-x86/syscalls/getsockopt.S
 syscall_src += arch-x86/syscalls/sendmsg.S
 syscall_src += arch-x86/syscalls/recvmsg.S
+syscall_src += arch-x86/syscalls/accept4.S
+syscall_src += arch-x86/syscalls/recvmmsg.S
+syscall_src += arch-x86/syscalls/sendmmsg.S
 syscall_src += arch-x86/syscalls/sched_setscheduler.S
 syscall_src += arch-x86/syscalls/sched_getscheduler.S
 syscall_src += arch-x86/syscalls/sched_yield.S
@@ -201,10 +215,19 @@ syscall_src += arch-x86/syscalls/personality.S
 syscall_src += arch-x86/syscalls/perf_event_open.S
 syscall_src += arch-x86/syscalls/futex.S
 syscall_src += arch-x86/syscalls/epoll_create.S
+syscall_src += arch-x86/syscalls/epoll_create1.S
 syscall_src += arch-x86/syscalls/epoll_ctl.S
 syscall_src += arch-x86/syscalls/epoll_wait.S
+syscall_src += arch-x86/syscalls/__epoll_pwait.S
 syscall_src += arch-x86/syscalls/inotify_init.S
+syscall_src += arch-x86/syscalls/inotify_init1.S
 syscall_src += arch-x86/syscalls/inotify_add_watch.S
 syscall_src += arch-x86/syscalls/inotify_rm_watch.S
 syscall_src += arch-x86/syscalls/poll.S
+syscall_src += arch-x86/syscalls/__ppoll.S
 syscall_src += arch-x86/syscalls/eventfd.S
+syscall_src += arch-x86/syscalls/io_setup.S
+syscall_src += arch-x86/syscalls/io_destroy.S
+syscall_src += arch-x86/syscalls/io_submit.S
+syscall_src += arch-x86/syscalls/io_getevents.S
+syscall_src += arch-x86/syscalls/io_cancel.S
@@ -12,20 +12,35 @@ _LIBC_ARCH_COMMON_SRC_FILES := \
     arch-x86/bionic/vfork.S \
     arch-x86/string/ffs.S
 
+# With SSSE3, memcpy, memset, memchr, memcmp, strcmp and strlen choose
+# between the atom routines and SSE4.2 or AVX2 ones at startup (see
+# arch-x86/bionic/cpu_variant.cpp). Every SSSE3 core has SSE2 too.
 ifeq ($(ARCH_X86_HAVE_SSSE3),true)
 _LIBC_ARCH_COMMON_SRC_FILES += \
-	arch-x86/string/ssse3-memcpy-atom.S \
+	arch-x86/bionic/cpu_variant.cpp \
+	arch-x86/string/memcpy_atom.S \
+	arch-x86/string/memset_atom.S \
+	arch-x86/string/memchr_atom.S \
+	arch-x86/string/memcmp_atom.S \
+	arch-x86/string/strcmp_atom.S \
+	arch-x86/string/strlen_atom.S \
+	arch-x86/string/avx2-memcpy.S \
+	arch-x86/string/avx2-memset.S \
+	arch-x86/string/avx2-memchr.S \
+	arch-x86/string/avx2-memcmp.S \
+	arch-x86/string/avx2-strlen.S \
+	arch-x86/string/sse4-strcmp.S \
+	arch-x86/string/ssse3-strcspn.S \
+	arch-x86/string/ssse3-strspn.S \
 	arch-x86/string/ssse3-memmove-atom.S \
 	arch-x86/string/ssse3-bcopy-atom.S \
 	arch-x86/string/ssse3-strncat-atom.S \
 	arch-x86/string/ssse3-strncpy-atom.S \
 	arch-x86/string/ssse3-strlcat-atom.S \
 	arch-x86/string/ssse3-strlcpy-atom.S \
-	arch-x86/string/ssse3-strcmp-atom.S \
 	arch-x86/string/ssse3-strncmp-atom.S \
 	arch-x86/string/ssse3-strcat-atom.S \
 	arch-x86/string/ssse3-strcpy-atom.S \
-	arch-x86/string/ssse3-memcmp-atom.S \
 	arch-x86/string/ssse3-wmemcmp-atom.S \
 	arch-x86/string/ssse3-memcmp16-atom.S \
 	arch-x86/string/ssse3-wcscat-atom.S \
@@ -40,6 +55,8 @@ _LIBC_ARCH_COMMON_SRC_FILES += \
 	arch-x86/string/strcat.S \
 	arch-x86/string/memcmp.S \
 	string/memcmp16.c \
+	string/strcspn.c \
+	string/strspn.c \
 	string/strcpy.c \
 	string/strncat.c \
 	string/strncpy.c \
@@ -51,15 +68,18 @@ _LIBC_ARCH_COMMON_SRC_FILES += \
 endif
 
 ifeq ($(ARCH_X86_HAVE_SSE2),true)
+ifneq ($(ARCH_X86_HAVE_SSSE3),true)
 _LIBC_ARCH_COMMON_SRC_FILES += \
 	arch-x86/string/sse2-memset-atom.S \
-	arch-x86/string/sse2-bzero-atom.S \
 	arch-x86/string/sse2-memchr-atom.S \
+	arch-x86/string/sse2-strlen-atom.S
+endif
+_LIBC_ARCH_COMMON_SRC_FILES += \
+	arch-x86/string/sse2-bzero-atom.S \
 	arch-x86/string/sse2-memrchr-atom.S \
 	arch-x86/string/sse2-strchr-atom.S \
 	arch-x86/string/sse2-strrchr-atom.S \
 	arch-x86/string/sse2-index-atom.S \
-	arch-x86/string/sse2-strlen-atom.S \
 	arch-x86/string/sse2-strnlen-atom.S \
 	arch-x86/string/sse2-wcschr-atom.S \
 	arch-x86/string/sse2-wcsrchr-atom.S \
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/copy_fd.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Big enough that a large copy takes few system calls, and small enough for any byte count
+// sendfile(2) or splice(2) takes.
+static const size_t kChunkSize = 16 * 1024 * 1024;
+
+// What a pipe holds by default, and so the most one splice(2) into an empty one moves.
+static const size_t kPipeSize = 64 * 1024;
+
+static const size_t kBufferSize = 64 * 1024;
+
+// How a way of copying went. kCopyUnsupported means it can't copy any more, though another
+// way might, carrying on from wherever it stopped.
+enum CopyResult {
+  kCopyDone,
+  kCopyUnsupported,
+  kCopyFailed,
+};
+
+class Copier {
+ public:
+  Copier(int out_fd, int in_fd, uint64_t count)
+      : out_fd_(out_fd), in_fd_(in_fd), count_(count), copied_(0) {
+  }
+
+  uint64_t copied() {
+    return copied_;
+  }
+
+  CopyResult Sendfile() {
+    while (copied_ < count_) {
+      ssize_t n = sendfile(out_fd_, in_fd_, NULL, Next(kChunkSize));
+      if (n > 0) {
+        copied_ += n;
+      } else if (n == 0) {
+        return kCopyDone;
+      } else if (errno != EINTR) {
+        return Unsupported(0) ? kCopyUnsupported : kCopyFailed;
+      }
+    }
+    return kCopyDone;
+  }
+
+  CopyResult Splice() {
+    struct stat in_sb;
+    struct stat out_sb;
+    if (fstat(in_fd_, &in_sb) == -1 || fstat(out_fd_, &out_sb) == -1) {
+      return kCopyFailed;
+    }
+    if (S_ISFIFO(in_sb.st_mode) || S_ISFIFO(out_sb.st_mode)) {
+      return SpliceDirectly();
+    }
+
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+      return kCopyUnsupported;
+    }
+    CopyResult result = SpliceThroughPipe(pipe_fds[0], pipe_fds[1]);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return result;
+  }
+
+  CopyResult ReadWrite() {
+    char* buf = reinterpret_cast<char*>(malloc(kBufferSize));
+    if (buf == NULL) {
+      errno = ENOMEM;
+      return kCopyFailed;
+    }
+    CopyResult result = kCopyDone;
+    while (copied_ < count_) {
+      ssize_t n = TEMP_FAILURE_RETRY(read(in_fd_, buf, Next(kBufferSize)));
+      if (n == 0) {
+        break;
+      }
+      if (n == -1 || !WriteAll(buf, n)) {
+        result = kCopyFailed;
+        break;
+      }
+    }
+    free(buf);
+    return result;
+  }
+
+ private:
+  int out_fd_;
+  int in_fd_;
+  uint64_t count_;
+  uint64_t copied_;
+
+  size_t Next(size_t limit) {
+    uint64_t left = count_ - copied_;
+    return (left < limit) ? left : limit;
+  }
+
+  // EINVAL and ENOSYS, before a way of copying has copied anything, mean it doesn't work for
+  // these descriptors.
+  bool Unsupported(uint64_t copied_before) {
+    return copied_ == copied_before && (errno == EINVAL || errno == ENOSYS);
+  }
+
+  CopyResult SpliceDirectly() {
+    uint64_t copied_before = copied_;
+    while (copied_ < count_) {
+      ssize_t n = splice(in_fd_, NULL, out_fd_, NULL, Next(kChunkSize), SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (n > 0) {
+        copied_ += n;
+      } else if (n == 0) {
+        return kCopyDone;
+      } else if (errno != EINTR) {
+        return Unsupported(copied_before) ? kCopyUnsupported : kCopyFailed;
+      }
+    }
+    return kCopyDone;
+  }
+
+  CopyResult SpliceThroughPipe(int read_fd, int write_fd) {
+    uint64_t copied_before = copied_;
+    while (copied_ < count_) {
+      ssize_t n = splice(in_fd_, NULL, write_fd, NULL, Next(kPipeSize), SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (n == 0) {
+        return kCopyDone;
+      }
+      if (n == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return Unsupported(copied_before) ? kCopyUnsupported : kCopyFailed;
+      }
+
+      size_t in_pipe = n;
+      while (in_pipe > 0) {
+        ssize_t m = splice(read_fd, NULL, out_fd_, NULL, in_pipe, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (m > 0) {
+          in_pipe -= m;
+          copied_ += m;
+        } else if (m == -1 && errno == EINTR) {
+          continue;
+        } else if (m == -1 && Unsupported(copied_before)) {
+          // 'out_fd_' can't be spliced to, but what's in the pipe has already left 'in_fd_'.
+          return DrainPipe(read_fd, in_pipe) ? kCopyUnsupported : kCopyFailed;
+        } else {
+          return kCopyFailed;
+        }
+      }
+    }
+    return kCopyDone;
+  }
+
+  bool DrainPipe(int read_fd, size_t in_pipe) {
+    char buf[4096];
+    while (in_pipe > 0) {
+      ssize_t n = TEMP_FAILURE_RETRY(read(read_fd, buf, (in_pipe < sizeof(buf)) ? in_pipe : sizeof(buf)));
+      if (n <= 0 || !WriteAll(buf, n)) {
+        return false;
+      }
+      in_pipe -= n;
+    }
+    return true;
+  }
+
+  bool WriteAll(const char* buf, size_t n) {
+    while (n > 0) {
+      ssize_t m = TEMP_FAILURE_RETRY(write(out_fd_, buf, n));
+      if (m == -1) {
+        return false;
+      }
+      buf += m;
+      n -= m;
+      copied_ += m;
+    }
+    return true;
+  }
+
+  // Disallow copy and assignment.
+  Copier(const Copier&);
+  void operator=(const Copier&);
+};
+
+int android_copy_fd(int out_fd, int in_fd, uint64_t count, uint64_t* copied) {
+  Copier copier(out_fd, in_fd, count);
+  CopyResult result = copier.Sendfile();
+  if (result == kCopyUnsupported) {
+    result = copier.Splice();
+  }
+  if (result == kCopyUnsupported) {
+    result = copier.ReadWrite();
+  }
+  if (copied != NULL) {
+    *copied = copier.copied();
+  }
+  return (result == kCopyDone) ? 0 : -1;
+}
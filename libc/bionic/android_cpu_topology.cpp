@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE 1
+#include <android/cpu_topology.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+// The topology is read from sysfs once and then handed out from this copy, so that thread
+// pools can ask for it as often as they like.
+static pthread_mutex_t gTopologyLock = PTHREAD_MUTEX_INITIALIZER;
+static android_cpu_topology_t gTopology;
+static bool gTopologyValid = false;
+
+static bool ReadSysfsFile(const char* path, char* buf, size_t buf_size) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  ssize_t n = TEMP_FAILURE_RETRY(read(fd, buf, buf_size - 1));
+  close(fd);
+  if (n <= 0) {
+    return false;
+  }
+  buf[n] = '\0';
+  return true;
+}
+
+static bool ReadCpuFile(int cpu, const char* name, char* buf, size_t buf_size) {
+  char path[128];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, name);
+  return ReadSysfsFile(path, buf, buf_size);
+}
+
+static unsigned ReadCpuUnsigned(int cpu, const char* name) {
+  char buf[32];
+  if (!ReadCpuFile(cpu, name, buf, sizeof(buf))) {
+    return 0;
+  }
+  return strtoul(buf, NULL, 10);
+}
+
+// Parses the kernel's cpu list format ("0-3,6,8-9") into 'set'.
+static bool ParseCpuList(const char* s, cpu_set_t* set) {
+  CPU_ZERO(set);
+  while (*s != '\0' && *s != '\n') {
+    char* end;
+    unsigned long first = strtoul(s, &end, 10);
+    if (end == s) {
+      return false;
+    }
+    unsigned long last = first;
+    if (*end == '-') {
+      s = end + 1;
+      last = strtoul(s, &end, 10);
+      if (end == s || last < first) {
+        return false;
+      }
+    }
+    for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, set);
+    }
+    s = end;
+    if (*s == ',') {
+      ++s;
+    }
+  }
+  return true;
+}
+
+static bool ReadCpuList(const char* path, cpu_set_t* set) {
+  char buf[256];
+  return ReadSysfsFile(path, buf, sizeof(buf)) && ParseCpuList(buf, set);
+}
+
+static void ReadL2Siblings(int cpu, cpu_set_t* set) {
+  char buf[256];
+  for (int index = 0; index < 8; ++index) {
+    char name[64];
+    snprintf(name, sizeof(name), "cache/index%d/level", index);
+    if (!ReadCpuFile(cpu, name, buf, sizeof(buf))) {
+      break;
+    }
+    if (atoi(buf) != 2) {
+      continue;
+    }
+    snprintf(name, sizeof(name), "cache/index%d/shared_cpu_list", index);
+    if (ReadCpuFile(cpu, name, buf, sizeof(buf)) && ParseCpuList(buf, set) && CPU_ISSET(cpu, set)) {
+      return;
+    }
+    break;
+  }
+  // No L2 information: assume the cache is private.
+  CPU_ZERO(set);
+  CPU_SET(cpu, set);
+}
+
+static void SortClusters(android_cpu_topology_t* t) {
+  // Insertion sort keeps clusters of equal capacity in CPU order.
+  for (size_t i = 1; i < t->cluster_count; ++i) {
+    android_cpu_cluster_t c = t->clusters[i];
+    size_t j = i;
+    while (j > 0 && t->clusters[j - 1].capacity > c.capacity) {
+      t->clusters[j] = t->clusters[j - 1];
+      --j;
+    }
+    t->clusters[j] = c;
+  }
+  for (size_t i = 0; i < t->cluster_count; ++i) {
+    for (int cpu = 0; cpu < t->cpu_count; ++cpu) {
+      if (CPU_ISSET(cpu, &t->clusters[i].cpus)) {
+        t->cluster_of_cpu[cpu] = i;
+      }
+    }
+  }
+}
+
+static bool ReadTopologyLocked(android_cpu_topology_t* t) {
+  memset(t, 0, sizeof(*t));
+
+  cpu_set_t possible;
+  if (!ReadCpuList("/sys/devices/system/cpu/possible", &possible)) {
+    return false;
+  }
+  t->cpu_count = 0;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &possible)) {
+      t->cpu_count = cpu + 1;
+    }
+  }
+  if (t->cpu_count == 0) {
+    return false;
+  }
+
+  if (!ReadCpuList("/sys/devices/system/cpu/online", &t->online)) {
+    t->online = possible;
+  }
+
+  for (int cpu = 0; cpu < t->cpu_count; ++cpu) {
+    t->cluster_of_cpu[cpu] = -1;
+    ReadL2Siblings(cpu, &t->l2_shared[cpu]);
+  }
+
+  // A cluster is a set of cores the kernel reports as siblings; on ARM that's a
+  // physical cluster sharing a clock. Offline CPUs may have no topology directory,
+  // in which case they are found in an online sibling's list, or become their own cluster.
+  for (int cpu = 0; cpu < t->cpu_count; ++cpu) {
+    if (t->cluster_of_cpu[cpu] != -1) {
+      continue;
+    }
+    char buf[256];
+    cpu_set_t siblings;
+    if (!ReadCpuFile(cpu, "topology/core_siblings_list", buf, sizeof(buf)) ||
+        !ParseCpuList(buf, &siblings) || !CPU_ISSET(cpu, &siblings)) {
+      CPU_ZERO(&siblings);
+      CPU_SET(cpu, &siblings);
+    }
+
+    size_t index = t->cluster_count;
+    if (index == ANDROID_CPU_CLUSTERS_MAX) {
+      index = ANDROID_CPU_CLUSTERS_MAX - 1;
+    } else {
+      t->cluster_count++;
+    }
+    android_cpu_cluster_t* cluster = &t->clusters[index];
+    for (int sibling = 0; sibling < t->cpu_count; ++sibling) {
+      if (CPU_ISSET(sibling, &siblings) && t->cluster_of_cpu[sibling] == -1) {
+        CPU_SET(sibling, &cluster->cpus);
+        t->cluster_of_cpu[sibling] = index;
+      }
+    }
+    if (cluster->max_freq_khz == 0) {
+      cluster->max_freq_khz = ReadCpuUnsigned(cpu, "cpufreq/cpuinfo_max_freq");
+    }
+    if (cluster->capacity == 0) {
+      cluster->capacity = ReadCpuUnsigned(cpu, "cpu_capacity");
+      if (cluster->capacity == 0) {
+        cluster->capacity = cluster->max_freq_khz;
+      }
+    }
+  }
+
+  SortClusters(t);
+  return true;
+}
+
+static bool GetTopologyLocked() {
+  if (!gTopologyValid) {
+    ErrnoRestorer errno_restorer;
+    gTopologyValid = ReadTopologyLocked(&gTopology);
+  }
+  return gTopologyValid;
+}
+
+int android_get_cpu_topology(android_cpu_topology_t* topology) {
+  ScopedPthreadMutexLocker locker(&gTopologyLock);
+  if (!GetTopologyLocked()) {
+    errno = ENOENT;
+    return -1;
+  }
+  *topology = gTopology;
+  return 0;
+}
+
+int android_refresh_cpu_topology() {
+  ScopedPthreadMutexLocker locker(&gTopologyLock);
+  gTopologyValid = false;
+  if (!GetTopologyLocked()) {
+    errno = ENOENT;
+    return -1;
+  }
+  return 0;
+}
+
+int android_set_thread_cluster(pid_t tid, size_t cluster) {
+  cpu_set_t cpus;
+  {
+    ScopedPthreadMutexLocker locker(&gTopologyLock);
+    if (!GetTopologyLocked()) {
+      errno = ENOENT;
+      return -1;
+    }
+    if (cluster >= gTopology.cluster_count) {
+      errno = EINVAL;
+      return -1;
+    }
+    cpus = gTopology.clusters[cluster].cpus;
+  }
+  return sched_setaffinity(tid, sizeof(cpus), &cpus);
+}
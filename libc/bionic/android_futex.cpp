@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/futex.h>
+
+#include <errno.h>
+#include <limits.h>
+
+#include "private/bionic_atomic_inline.h"
+#include "private/bionic_futex.h"
+
+// Converts a relative timeout into a CLOCK_MONOTONIC deadline, so that a wait
+// that goes back to sleep after a spurious wakeup doesn't start the full
+// timeout again. A NULL timeout means no deadline.
+class Deadline {
+ public:
+  explicit Deadline(const timespec* timeout) : forever_(timeout == NULL) {
+    if (!forever_) {
+      clock_gettime(CLOCK_MONOTONIC, &end_);
+      end_.tv_sec += timeout->tv_sec;
+      end_.tv_nsec += timeout->tv_nsec;
+      if (end_.tv_nsec >= 1000000000) {
+        end_.tv_sec++;
+        end_.tv_nsec -= 1000000000;
+      }
+    }
+  }
+
+  // Returns the time left for the next futex wait, NULL for forever, or
+  // sets 'expired' if the deadline has passed.
+  const timespec* Remaining(timespec* remaining, bool* expired) {
+    *expired = false;
+    if (forever_) {
+      return NULL;
+    }
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    remaining->tv_sec = end_.tv_sec - now.tv_sec;
+    remaining->tv_nsec = end_.tv_nsec - now.tv_nsec;
+    if (remaining->tv_nsec < 0) {
+      remaining->tv_sec--;
+      remaining->tv_nsec += 1000000000;
+    }
+    if (remaining->tv_sec < 0 || (remaining->tv_sec == 0 && remaining->tv_nsec == 0)) {
+      *expired = true;
+    }
+    return remaining;
+  }
+
+ private:
+  bool forever_;
+  timespec end_;
+
+  // Disallow copy and assignment.
+  Deadline(const Deadline&);
+  void operator=(const Deadline&);
+};
+
+static bool IsValidTimeout(const timespec* timeout) {
+  return timeout == NULL ||
+      (timeout->tv_sec >= 0 && timeout->tv_nsec >= 0 && timeout->tv_nsec < 1000000000);
+}
+
+int android_futex_wait(volatile int32_t* addr, int32_t expected, const timespec* timeout) {
+  if (!IsValidTimeout(timeout)) {
+    return EINVAL;
+  }
+  // __futex_wait_ex returns 0 or a negated errno; EWOULDBLOCK is EAGAIN.
+  return -__futex_wait_ex(addr, 0, expected, timeout);
+}
+
+int android_futex_wake(volatile int32_t* addr, int count) {
+  int rc = __futex_wake_ex(addr, 0, count);
+  return (rc < 0) ? 0 : rc;
+}
+
+// Event states. A waiter only sleeps once the event is in
+// kEventClearWithWaiters, so a set that replaces any other state knows
+// nobody needs waking.
+enum {
+  kEventClear = 0,
+  kEventSet = 1,
+  kEventClearWithWaiters = 2,
+};
+
+void android_event_init(android_event_t* event, int flags, int initially_set) {
+  event->state = initially_set ? kEventSet : kEventClear;
+  event->flags = flags;
+}
+
+void android_event_set(android_event_t* event) {
+  ANDROID_MEMBAR_FULL();
+  if (__bionic_swap(kEventSet, &event->state) == kEventClearWithWaiters) {
+    bool manual_reset = (event->flags & ANDROID_EVENT_MANUAL_RESET) != 0;
+    __futex_wake_ex(&event->state, 0, manual_reset ? INT_MAX : 1);
+  }
+}
+
+void android_event_reset(android_event_t* event) {
+  // Sleepers that were woken but haven't run yet mark the event again
+  // before going back to sleep, so the waiters state can be dropped here.
+  __bionic_cmpxchg(kEventSet, kEventClear, &event->state);
+}
+
+int android_event_timedwait(android_event_t* event, const timespec* timeout) {
+  if (!IsValidTimeout(timeout)) {
+    return EINVAL;
+  }
+  bool manual_reset = (event->flags & ANDROID_EVENT_MANUAL_RESET) != 0;
+  Deadline deadline(timeout);
+  bool slept = false;
+  for (;;) {
+    int32_t state = event->state;
+    if (state == kEventSet) {
+      if (manual_reset) {
+        break;
+      }
+      // Consuming an auto-reset event. Once we've slept, other waiters may
+      // still be asleep, so leave the event marked for the next set to wake one.
+      int32_t cleared = slept ? kEventClearWithWaiters : kEventClear;
+      if (__bionic_cmpxchg(kEventSet, cleared, &event->state) == 0) {
+        break;
+      }
+      continue;
+    }
+    if (state == kEventClear &&
+        __bionic_cmpxchg(kEventClear, kEventClearWithWaiters, &event->state) != 0) {
+      continue;
+    }
+
+    timespec remaining;
+    bool expired;
+    const timespec* rel = deadline.Remaining(&remaining, &expired);
+    if (expired) {
+      return ETIMEDOUT;
+    }
+    __futex_wait_ex(&event->state, 0, kEventClearWithWaiters, rel);
+    slept = true;
+  }
+  ANDROID_MEMBAR_FULL();
+  return 0;
+}
+
+int android_event_wait(android_event_t* event) {
+  return android_event_timedwait(event, NULL);
+}
+
+void android_latch_init(android_latch_t* latch, int32_t count) {
+  latch->count = (count > 0) ? count : 0;
+}
+
+void android_latch_count_down(android_latch_t* latch) {
+  ANDROID_MEMBAR_FULL();
+  for (;;) {
+    int32_t count = latch->count;
+    if (count <= 0) {
+      return;
+    }
+    if (__bionic_cmpxchg(count, count - 1, &latch->count) == 0) {
+      // Waiters sleep on whatever count they saw, so only opening the latch wakes them.
+      if (count == 1) {
+        __futex_wake_ex(&latch->count, 0, INT_MAX);
+      }
+      return;
+    }
+  }
+}
+
+int android_latch_timedwait(android_latch_t* latch, const timespec* timeout) {
+  if (!IsValidTimeout(timeout)) {
+    return EINVAL;
+  }
+  Deadline deadline(timeout);
+  for (;;) {
+    int32_t count = latch->count;
+    if (count <= 0) {
+      break;
+    }
+    timespec remaining;
+    bool expired;
+    const timespec* rel = deadline.Remaining(&remaining, &expired);
+    if (expired) {
+      return ETIMEDOUT;
+    }
+    __futex_wait_ex(&latch->count, 0, count, rel);
+  }
+  ANDROID_MEMBAR_FULL();
+  return 0;
+}
+
+int android_latch_wait(android_latch_t* latch) {
+  return android_latch_timedwait(latch, NULL);
+}
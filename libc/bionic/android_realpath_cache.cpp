@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/realpath_cache.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// What lstat(2), and readlink(2) for a link, said about one path.
+struct CacheEntry {
+  CacheEntry* next;
+  size_t hash;
+  mode_t mode;
+  char* link;
+  char path[0];
+};
+
+struct android_realpath_cache {
+  CacheEntry** buckets;
+  size_t bucket_count;
+  size_t entry_count;
+  char* cwd;
+};
+
+static size_t HashPath(const char* path) {
+  // FNV-1a.
+  size_t hash = 2166136261u;
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(path); *p != '\0'; ++p) {
+    hash = (hash ^ *p) * 16777619u;
+  }
+  return hash;
+}
+
+static bool Grow(android_realpath_cache_t* cache) {
+  size_t new_count = (cache->bucket_count == 0) ? 64 : cache->bucket_count * 2;
+  CacheEntry** new_buckets = reinterpret_cast<CacheEntry**>(calloc(new_count, sizeof(CacheEntry*)));
+  if (new_buckets == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < cache->bucket_count; ++i) {
+    CacheEntry* e = cache->buckets[i];
+    while (e != NULL) {
+      CacheEntry* next = e->next;
+      e->next = new_buckets[e->hash & (new_count - 1)];
+      new_buckets[e->hash & (new_count - 1)] = e;
+      e = next;
+    }
+  }
+  free(cache->buckets);
+  cache->buckets = new_buckets;
+  cache->bucket_count = new_count;
+  return true;
+}
+
+// Returns what lstat said about 'path', asking it if the cache doesn't know,
+// or returns NULL and sets errno.
+static const CacheEntry* Lstat(android_realpath_cache_t* cache, const char* path) {
+  size_t hash = HashPath(path);
+  if (cache->bucket_count != 0) {
+    for (CacheEntry* e = cache->buckets[hash & (cache->bucket_count - 1)]; e != NULL; e = e->next) {
+      if (e->hash == hash && strcmp(e->path, path) == 0) {
+        return e;
+      }
+    }
+  }
+
+  struct stat sb;
+  if (lstat(path, &sb) != 0) {
+    return NULL;
+  }
+  char target[PATH_MAX];
+  ssize_t target_length = 0;
+  if (S_ISLNK(sb.st_mode)) {
+    target_length = readlink(path, target, sizeof(target) - 1);
+    if (target_length < 0) {
+      return NULL;
+    }
+    target[target_length] = '\0';
+  }
+
+  if (cache->entry_count >= cache->bucket_count && !Grow(cache)) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  size_t path_length = strlen(path);
+  size_t size = sizeof(CacheEntry) + path_length + 1 + (S_ISLNK(sb.st_mode) ? target_length + 1 : 0);
+  CacheEntry* e = reinterpret_cast<CacheEntry*>(malloc(size));
+  if (e == NULL) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  e->hash = hash;
+  e->mode = sb.st_mode;
+  memcpy(e->path, path, path_length + 1);
+  e->link = NULL;
+  if (S_ISLNK(sb.st_mode)) {
+    e->link = e->path + path_length + 1;
+    memcpy(e->link, target, target_length + 1);
+  }
+  e->next = cache->buckets[hash & (cache->bucket_count - 1)];
+  cache->buckets[hash & (cache->bucket_count - 1)] = e;
+  ++cache->entry_count;
+  return e;
+}
+
+android_realpath_cache_t* android_realpath_cache_create() {
+  return reinterpret_cast<android_realpath_cache_t*>(calloc(1, sizeof(android_realpath_cache_t)));
+}
+
+void android_realpath_cache_destroy(android_realpath_cache_t* cache) {
+  if (cache == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < cache->bucket_count; ++i) {
+    CacheEntry* e = cache->buckets[i];
+    while (e != NULL) {
+      CacheEntry* next = e->next;
+      free(e);
+      e = next;
+    }
+  }
+  free(cache->buckets);
+  free(cache->cwd);
+  free(cache);
+}
+
+static char* Fail(char* resolved, bool allocated, int error) {
+  if (allocated) {
+    free(resolved);
+  }
+  errno = error;
+  return NULL;
+}
+
+// Removes the last component of 'resolved', leaving the '/' before it, unless it's just "/".
+static void StripLastComponent(char* resolved, size_t* resolved_length) {
+  if (*resolved_length > 1) {
+    resolved[*resolved_length - 1] = '\0';
+    char* q = strrchr(resolved, '/') + 1;
+    *q = '\0';
+    *resolved_length = q - resolved;
+  }
+}
+
+// This is upstream-freebsd/lib/libc/stdlib/realpath.c, asking the cache instead of lstat and readlink.
+char* android_realpath_cached(android_realpath_cache_t* cache, const char* path, char* resolved) {
+  if (path == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+  if (path[0] == '\0') {
+    errno = ENOENT;
+    return NULL;
+  }
+  bool allocated = false;
+  if (resolved == NULL) {
+    resolved = reinterpret_cast<char*>(malloc(PATH_MAX));
+    if (resolved == NULL) {
+      return NULL;
+    }
+    allocated = true;
+  }
+
+  char left[PATH_MAX];
+  size_t left_length;
+  size_t resolved_length;
+  if (path[0] == '/') {
+    resolved[0] = '/';
+    resolved[1] = '\0';
+    if (path[1] == '\0') {
+      return resolved;
+    }
+    resolved_length = 1;
+    left_length = strlcpy(left, path + 1, sizeof(left));
+  } else {
+    if (cache->cwd == NULL && (cache->cwd = getcwd(NULL, 0)) == NULL) {
+      return Fail(resolved, allocated, errno);
+    }
+    resolved_length = strlcpy(resolved, cache->cwd, PATH_MAX);
+    left_length = strlcpy(left, path, sizeof(left));
+  }
+  if (left_length >= sizeof(left) || resolved_length >= PATH_MAX) {
+    return Fail(resolved, allocated, ENAMETOOLONG);
+  }
+
+  unsigned symlinks = 0;
+  while (left_length != 0) {
+    // Take the next component off the front of 'left'.
+    char next_token[PATH_MAX];
+    char* p = strchr(left, '/');
+    char* s = (p != NULL) ? p : left + left_length;
+    memcpy(next_token, left, s - left);
+    next_token[s - left] = '\0';
+    left_length -= s - left;
+    if (p != NULL) {
+      memmove(left, s + 1, left_length + 1);
+    }
+    if (resolved[resolved_length - 1] != '/') {
+      if (resolved_length + 1 >= PATH_MAX) {
+        return Fail(resolved, allocated, ENAMETOOLONG);
+      }
+      resolved[resolved_length++] = '/';
+      resolved[resolved_length] = '\0';
+    }
+
+    if (next_token[0] == '\0') {
+      // Consecutive or trailing slashes: what's before has to be a directory.
+      const CacheEntry* e = Lstat(cache, resolved);
+      if (e == NULL) {
+        return Fail(resolved, allocated, errno);
+      }
+      if (!S_ISDIR(e->mode)) {
+        return Fail(resolved, allocated, ENOTDIR);
+      }
+      continue;
+    } else if (strcmp(next_token, ".") == 0) {
+      continue;
+    } else if (strcmp(next_token, "..") == 0) {
+      StripLastComponent(resolved, &resolved_length);
+      continue;
+    }
+
+    resolved_length = strlcat(resolved, next_token, PATH_MAX);
+    if (resolved_length >= PATH_MAX) {
+      return Fail(resolved, allocated, ENAMETOOLONG);
+    }
+    const CacheEntry* e = Lstat(cache, resolved);
+    if (e == NULL) {
+      return Fail(resolved, allocated, errno);
+    }
+    if (S_ISLNK(e->mode)) {
+      if (symlinks++ > MAXSYMLINKS) {
+        return Fail(resolved, allocated, ELOOP);
+      }
+      char symlink[PATH_MAX];
+      size_t symlink_length = strlcpy(symlink, e->link, sizeof(symlink));
+      if (symlink[0] == '/') {
+        resolved[1] = '\0';
+        resolved_length = 1;
+      } else {
+        StripLastComponent(resolved, &resolved_length);
+      }
+
+      // The link's target goes in front of whatever is left.
+      if (p != NULL) {
+        if (symlink_length == 0 || symlink[symlink_length - 1] != '/') {
+          if (symlink_length + 1 >= sizeof(symlink)) {
+            return Fail(resolved, allocated, ENAMETOOLONG);
+          }
+          symlink[symlink_length] = '/';
+          symlink[symlink_length + 1] = '\0';
+        }
+        left_length = strlcat(symlink, left, sizeof(symlink));
+        if (left_length >= sizeof(left)) {
+          return Fail(resolved, allocated, ENAMETOOLONG);
+        }
+      }
+      left_length = strlcpy(left, symlink, sizeof(left));
+    }
+  }
+
+  // Remove any trailing slash, unless the whole thing is "/".
+  if (resolved_length > 1 && resolved[resolved_length - 1] == '/') {
+    resolved[resolved_length - 1] = '\0';
+  }
+  return resolved;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/remote_memory.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+
+// Set once the kernel has said it has no process_vm_readv(2), so that later calls go
+// straight to ptrace(2).
+static volatile bool gNoProcessVm = false;
+
+// Reads the word at 'addr', which must be aligned.
+static bool peek_word(pid_t pid, uintptr_t addr, long* word) {
+  errno = 0;
+  *word = ptrace(PTRACE_PEEKDATA, pid, reinterpret_cast<void*>(addr), NULL);
+  return errno == 0;
+}
+
+static ssize_t ptrace_read(pid_t pid, void* local, const void* remote, size_t size) {
+  uint8_t* out = reinterpret_cast<uint8_t*>(local);
+  uintptr_t addr = reinterpret_cast<uintptr_t>(remote);
+  size_t done = 0;
+  while (done < size) {
+    uintptr_t word_addr = (addr + done) & ~(sizeof(long) - 1);
+    size_t offset = (addr + done) - word_addr;
+    long word;
+    if (!peek_word(pid, word_addr, &word)) {
+      break;
+    }
+    size_t n = sizeof(long) - offset;
+    if (n > size - done) {
+      n = size - done;
+    }
+    memcpy(out + done, reinterpret_cast<uint8_t*>(&word) + offset, n);
+    done += n;
+  }
+  return (done > 0 || size == 0) ? static_cast<ssize_t>(done) : -1;
+}
+
+static ssize_t ptrace_write(pid_t pid, void* remote, const void* local, size_t size) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(local);
+  uintptr_t addr = reinterpret_cast<uintptr_t>(remote);
+  size_t done = 0;
+  while (done < size) {
+    uintptr_t word_addr = (addr + done) & ~(sizeof(long) - 1);
+    size_t offset = (addr + done) - word_addr;
+    size_t n = sizeof(long) - offset;
+    if (n > size - done) {
+      n = size - done;
+    }
+    // Only whole words can be written, so a partial one is read first.
+    long word;
+    if (n != sizeof(long) && !peek_word(pid, word_addr, &word)) {
+      break;
+    }
+    memcpy(reinterpret_cast<uint8_t*>(&word) + offset, in + done, n);
+    if (ptrace(PTRACE_POKEDATA, pid, reinterpret_cast<void*>(word_addr),
+               reinterpret_cast<void*>(word)) == -1) {
+      break;
+    }
+    done += n;
+  }
+  return (done > 0 || size == 0) ? static_cast<ssize_t>(done) : -1;
+}
+
+// The kernel stops at the first page it can't copy, so the rest of the range is
+// retried until a call copies nothing: that tells a hole from a short copy.
+template <typename Fn>
+static ssize_t process_vm_copy(Fn fn, pid_t pid, uint8_t* local, uint8_t* remote, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    iovec local_iov = { local + done, size - done };
+    iovec remote_iov = { remote + done, size - done };
+    ssize_t n = fn(pid, &local_iov, 1, &remote_iov, 1, 0);
+    if (n <= 0) {
+      break;
+    }
+    done += n;
+  }
+  return (done > 0 || size == 0) ? static_cast<ssize_t>(done) : -1;
+}
+
+ssize_t android_read_remote(pid_t pid, void* local, const void* remote, size_t size) {
+  if (!gNoProcessVm) {
+    ssize_t result = process_vm_copy(process_vm_readv, pid, reinterpret_cast<uint8_t*>(local),
+                                     reinterpret_cast<uint8_t*>(const_cast<void*>(remote)), size);
+    if (result != -1 || errno != ENOSYS) {
+      return result;
+    }
+    gNoProcessVm = true;
+  }
+  return ptrace_read(pid, local, remote, size);
+}
+
+ssize_t android_write_remote(pid_t pid, void* remote, const void* local, size_t size) {
+  if (!gNoProcessVm) {
+    ssize_t result = process_vm_copy(process_vm_writev, pid,
+                                     reinterpret_cast<uint8_t*>(const_cast<void*>(local)),
+                                     reinterpret_cast<uint8_t*>(remote), size);
+    if (result != -1 || errno != ENOSYS) {
+      return result;
+    }
+    gNoProcessVm = true;
+  }
+  return ptrace_write(pid, remote, local, size);
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/trace_events.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "pthread_internal.h"
+#include "private/bionic_name_mem.h"
+#include "private/bionic_trace.h"
+#include "private/ScopedPthreadMutexLocker.h"
+
+extern "C" int tgkill(int tgid, int tid, int sig);
+
+volatile int __libc_trace_enabled = 0;
+
+// Every buffer there's ever been, newest first. Only ever pushed onto.
+static bionic_trace_buffer* volatile gTraceBuffers = NULL;
+
+static volatile uint32_t gTraceCapacity = 0;
+
+static pthread_mutex_t gTraceReadLock = PTHREAD_MUTEX_INITIALIZER;
+
+// A buffer is free once its owner has exited: either it gave the buffer up in
+// pthread_exit, or it's gone without, as every thread but one does in a fork
+// child, and tgkill(2) can't find it.
+static bool trace_buffer_take(bionic_trace_buffer* buffer, pid_t tid) {
+  pid_t owner = buffer->owner;
+  if (owner != 0 && !(tgkill(getpid(), owner, 0) == -1 && errno == ESRCH)) {
+    return false;
+  }
+  return __sync_bool_compare_and_swap(&buffer->owner, owner, tid);
+}
+
+static bionic_trace_buffer* trace_buffer_get(pthread_internal_t* thread) {
+  int saved_errno = errno;
+  for (bionic_trace_buffer* buffer = gTraceBuffers; buffer != NULL; buffer = buffer->next) {
+    if (trace_buffer_take(buffer, thread->tid)) {
+      // What the last owner dropped would be reported as ours.
+      buffer->dropped = 0;
+      buffer->enabled = __libc_trace_enabled;
+      errno = saved_errno;
+      return buffer;
+    }
+  }
+  errno = saved_errno;
+
+  // Not malloc(3): the heap traces its own slow path.
+  uint32_t capacity = gTraceCapacity;
+  size_t size = sizeof(bionic_trace_buffer) + capacity * sizeof(android_trace_event);
+  void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    errno = saved_errno;
+    return NULL;
+  }
+  __bionic_name_mem(map, size, "libc_trace");
+  errno = saved_errno;
+
+  bionic_trace_buffer* buffer = reinterpret_cast<bionic_trace_buffer*>(map);
+  buffer->owner = thread->tid;
+  buffer->enabled = __libc_trace_enabled;
+  buffer->mask = capacity - 1;
+  do {
+    buffer->next = gTraceBuffers;
+  } while (!__sync_bool_compare_and_swap(&gTraceBuffers, buffer->next, buffer));
+  return buffer;
+}
+
+void __libc_trace_event(uint32_t type, uint64_t arg) {
+  pthread_internal_t* thread = __get_thread();
+  bionic_trace_buffer* buffer = thread->trace_buffer;
+  if (buffer == NULL) {
+    buffer = trace_buffer_get(thread);
+    if (buffer == NULL) {
+      return;
+    }
+    thread->trace_buffer = buffer;
+  }
+  __bionic_trace_append(buffer, thread->tid, type, arg);
+}
+
+void __libc_trace_thread_exit(pthread_internal_t* thread) {
+  bionic_trace_buffer* buffer = thread->trace_buffer;
+  if (buffer != NULL) {
+    thread->trace_buffer = NULL;
+    __sync_synchronize();
+    buffer->owner = 0;
+  }
+}
+
+int android_trace_start(size_t events_per_thread) {
+  if (events_per_thread == 0 || events_per_thread > (1U << 24)) {
+    errno = EINVAL;
+    return -1;
+  }
+  uint32_t capacity = 16;
+  while (capacity < events_per_thread) {
+    capacity *= 2;
+  }
+  gTraceCapacity = capacity;
+
+  __libc_trace_enabled = 1;
+  __sync_synchronize();
+  for (bionic_trace_buffer* buffer = gTraceBuffers; buffer != NULL; buffer = buffer->next) {
+    buffer->enabled = 1;
+  }
+
+  pthread_internal_t* thread = __get_thread();
+  if (thread->trace_buffer == NULL) {
+    thread->trace_buffer = trace_buffer_get(thread);
+    if (thread->trace_buffer == NULL) {
+      android_trace_stop();
+      errno = ENOMEM;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void android_trace_stop() {
+  __libc_trace_enabled = 0;
+  __sync_synchronize();
+  for (bionic_trace_buffer* buffer = gTraceBuffers; buffer != NULL; buffer = buffer->next) {
+    buffer->enabled = 0;
+  }
+}
+
+size_t android_trace_read(android_trace_event* events, size_t count) {
+  ScopedPthreadMutexLocker locker(&gTraceReadLock);
+  size_t n = 0;
+  for (bionic_trace_buffer* buffer = gTraceBuffers; buffer != NULL && n < count; buffer = buffer->next) {
+    uint32_t tail = buffer->tail;
+    uint32_t head = buffer->head;
+    __sync_synchronize();
+    while (tail != head && n < count) {
+      events[n++] = buffer->events[tail++ & buffer->mask];
+    }
+    // The owner mustn't reuse the slots before we've copied them.
+    __sync_synchronize();
+    buffer->tail = tail;
+  }
+  return n;
+}
+
+ssize_t android_trace_dump(int fd) {
+  android_trace_event events[64];
+  ssize_t total = 0;
+  size_t n;
+  while ((n = android_trace_read(events, sizeof(events) / sizeof(events[0]))) > 0) {
+    const char* p = reinterpret_cast<const char*>(events);
+    size_t left = n * sizeof(events[0]);
+    while (left > 0) {
+      ssize_t written = TEMP_FAILURE_RETRY(write(fd, p, left));
+      if (written == -1) {
+        return -1;
+      }
+      p += written;
+      left -= written;
+    }
+    total += n;
+  }
+  return total;
+}
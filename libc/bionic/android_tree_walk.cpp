@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/tree_walk.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "private/ScopedPthreadMutexLocker.h"
+
+static unsigned char ModeToType(mode_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG: return DT_REG;
+    case S_IFDIR: return DT_DIR;
+    case S_IFLNK: return DT_LNK;
+    case S_IFCHR: return DT_CHR;
+    case S_IFBLK: return DT_BLK;
+    case S_IFIFO: return DT_FIFO;
+    case S_IFSOCK: return DT_SOCK;
+  }
+  return DT_UNKNOWN;
+}
+
+// A directory found but not read yet.
+struct PendingDir {
+  PendingDir* next;
+  int depth;
+  char path[0];
+};
+
+class TreeWalk {
+ public:
+  TreeWalk(int flags, android_tree_walk_callback_t callback, void* arg)
+      : flags_(flags), callback_(callback), arg_(arg),
+        stack_(NULL), pending_(0), stopped_(false), result_(0), error_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&cond_, NULL);
+  }
+
+  ~TreeWalk() {
+    while (stack_ != NULL) {
+      PendingDir* dir = stack_;
+      stack_ = dir->next;
+      free(dir);
+    }
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  // Reports 'root' and queues it if it's a directory. Returns false if there's nothing more to do.
+  bool Start(const char* root) {
+    struct stat sb;
+    if (stat(root, &sb) == -1) {
+      Stop(-1, errno);
+      return false;
+    }
+    const char* name = strrchr(root, '/');
+    android_tree_walk_entry entry;
+    entry.path = root;
+    entry.name = (name != NULL && name[1] != '\0') ? name + 1 : root;
+    entry.depth = 0;
+    entry.type = ModeToType(sb.st_mode);
+    entry.stat = &sb;
+    entry.error = 0;
+    return Report(&entry) && entry.type == DT_DIR && Push(root, strlen(root), 0);
+  }
+
+  // Reads directories until there are none left, with any number of threads at once.
+  void Work() {
+    while (true) {
+      PendingDir* dir;
+      {
+        ScopedPthreadMutexLocker locker(&mutex_);
+        while (stack_ == NULL && pending_ != 0 && !stopped_) {
+          pthread_cond_wait(&cond_, &mutex_);
+        }
+        if (stack_ == NULL || stopped_) {
+          return;
+        }
+        // Last in, first out, so the stack stays about as deep as the tree.
+        dir = stack_;
+        stack_ = dir->next;
+      }
+
+      Read(dir);
+      free(dir);
+
+      ScopedPthreadMutexLocker locker(&mutex_);
+      if (--pending_ == 0) {
+        pthread_cond_broadcast(&cond_);
+      }
+    }
+  }
+
+  int Result(int* error) {
+    *error = error_;
+    return result_;
+  }
+
+ private:
+  int flags_;
+  android_tree_walk_callback_t callback_;
+  void* arg_;
+
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  PendingDir* stack_;
+  size_t pending_;  // Directories queued or being read.
+  volatile bool stopped_;
+  int result_;
+  int error_;
+
+  // Calls the callback, and returns whether to go into 'entry' if it's a directory.
+  bool Report(const android_tree_walk_entry* entry) {
+    int rc = callback_(entry, arg_);
+    if (rc != 0 && rc != ANDROID_TREE_WALK_SKIP) {
+      Stop(rc, 0);
+    }
+    return rc == 0;
+  }
+
+  // Ends the walk early. Only the first reason is kept.
+  void Stop(int result, int error) {
+    ScopedPthreadMutexLocker locker(&mutex_);
+    if (!stopped_) {
+      stopped_ = true;
+      result_ = result;
+      error_ = error;
+      pthread_cond_broadcast(&cond_);
+    }
+  }
+
+  bool Push(const char* path, size_t length, int depth) {
+    PendingDir* dir = reinterpret_cast<PendingDir*>(malloc(sizeof(PendingDir) + length + 1));
+    if (dir == NULL) {
+      Stop(-1, ENOMEM);
+      return false;
+    }
+    dir->depth = depth;
+    memcpy(dir->path, path, length + 1);
+
+    ScopedPthreadMutexLocker locker(&mutex_);
+    dir->next = stack_;
+    stack_ = dir;
+    ++pending_;
+    pthread_cond_signal(&cond_);
+    return true;
+  }
+
+  void Read(PendingDir* dir) {
+    android_tree_walk_entry entry;
+    entry.depth = dir->depth + 1;
+
+    // Anything but the root was a directory when getdents or stat said so, and
+    // mustn't be followed if it's since been replaced by a link.
+    int fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC | ((dir->depth > 0) ? O_NOFOLLOW : 0));
+    DIR* d = (fd != -1) ? fdopendir(fd) : NULL;
+    if (d == NULL) {
+      if (fd != -1) {
+        close(fd);
+      }
+      ReportUnreadable(dir, errno);
+      return;
+    }
+
+    char path[PATH_MAX];
+    size_t prefix = strlen(dir->path);
+    memcpy(path, dir->path, prefix);
+    if (prefix == 0 || path[prefix - 1] != '/') {
+      path[prefix++] = '/';
+    }
+    entry.path = path;
+    entry.name = path + prefix;
+
+    int error = 0;
+    while (!stopped_) {
+      errno = 0;
+      dirent* e = readdir(d);
+      if (e == NULL) {
+        error = errno;
+        break;
+      }
+      if (e->d_name[0] == '.' && (e->d_name[1] == '\0' || (e->d_name[1] == '.' && e->d_name[2] == '\0'))) {
+        continue;
+      }
+      size_t length = prefix + strlen(e->d_name);
+      if (length >= sizeof(path)) {
+        // Too long to open or stat; report it with the name alone.
+        entry.path = entry.name = e->d_name;
+        entry.type = e->d_type;
+        entry.stat = NULL;
+        entry.error = ENAMETOOLONG;
+        Report(&entry);
+        entry.path = path;
+        entry.name = path + prefix;
+        continue;
+      }
+      memcpy(path + prefix, e->d_name, length - prefix + 1);
+
+      struct stat sb;
+      entry.type = e->d_type;
+      entry.stat = NULL;
+      entry.error = 0;
+      if ((flags_ & ANDROID_TREE_WALK_STAT) != 0 || entry.type == DT_UNKNOWN) {
+        if (fstatat(fd, e->d_name, &sb, AT_SYMLINK_NOFOLLOW) == 0) {
+          entry.type = ModeToType(sb.st_mode);
+          entry.stat = &sb;
+        } else {
+          entry.type = DT_UNKNOWN;
+          entry.error = errno;
+        }
+      }
+      if (Report(&entry) && entry.type == DT_DIR && !Push(path, length, entry.depth)) {
+        break;
+      }
+    }
+    closedir(d);
+    if (error != 0 && !stopped_) {
+      ReportUnreadable(dir, error);
+    }
+  }
+
+  void ReportUnreadable(const PendingDir* dir, int error) {
+    const char* name = strrchr(dir->path, '/');
+    android_tree_walk_entry entry;
+    entry.path = dir->path;
+    entry.name = (name != NULL && name[1] != '\0') ? name + 1 : dir->path;
+    entry.depth = dir->depth;
+    entry.type = DT_DIR;
+    entry.stat = NULL;
+    entry.error = error;
+    Report(&entry);
+  }
+
+  // Disallow copy and assignment.
+  TreeWalk(const TreeWalk&);
+  void operator=(const TreeWalk&);
+};
+
+static void* TreeWalkThread(void* arg) {
+  reinterpret_cast<TreeWalk*>(arg)->Work();
+  return NULL;
+}
+
+int android_tree_walk(const char* root, int flags, int threads,
+                      android_tree_walk_callback_t callback, void* arg) {
+  if (threads <= 0) {
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) {
+      threads = 1;
+    }
+  }
+
+  TreeWalk walk(flags, callback, arg);
+  if (walk.Start(root)) {
+    pthread_t* workers = reinterpret_cast<pthread_t*>(malloc((threads - 1) * sizeof(pthread_t)));
+    int started = 0;
+    if (workers != NULL) {
+      // Fewer threads than asked for still finish the walk, just more slowly.
+      while (started < threads - 1 && pthread_create(&workers[started], NULL, TreeWalkThread, &walk) == 0) {
+        ++started;
+      }
+    }
+    walk.Work();
+    for (int i = 0; i < started; ++i) {
+      pthread_join(workers[i], NULL);
+    }
+    free(workers);
+  }
+
+  int error;
+  int result = walk.Result(&error);
+  if (result == -1 && error != 0) {
+    errno = error;
+  }
+  return result;
+}
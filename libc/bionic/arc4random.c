@@ -18,31 +18,55 @@
  */
 
 /*
- * Arc4 random number generator for OpenBSD.
+ * Arc4 random number generator for OpenBSD, now built on the ChaCha20
+ * stream cipher rather than RC4.
  *
- * This code is derived from section 17.1 of Applied Cryptography,
- * second edition, which describes a stream cipher allegedly
- * compatible with RSA Labs "RC4" cipher (the actual description of
- * which is a trade secret).  The same algorithm is used as a stream
- * cipher called "arcfour" in Tatu Ylonen's ssh package.
+ * Each thread has its own generator, keyed from a process-wide one that is
+ * in turn keyed from /dev/urandom, so callers neither share a lock nor a
+ * cache line in the common case. Each generator fills a buffer with a
+ * thousand bytes of keystream at a time, immediately rekeys itself from
+ * the start of it, and wipes what it hands out, so that a later read of
+ * its memory can't recover earlier output.
  *
- * Here the stream cipher has been modified always to include the time
- * when initializing the state.  That makes it impossible to
- * regenerate the same random sequence twice, so this can't be used
- * for encryption, but will generate good random numbers.
- *
- * RC4 is a registered trademark of RSA Laboratories.
+ * A fork child mustn't replay its parent's stream, so fork() tells us
+ * (see __arc4random_after_fork) rather than every call comparing getpid(),
+ * which costs a system call here. A child made some other way, by a raw
+ * clone(2) for instance, inherits the parent's streams.
  */
 
 #include <fcntl.h>
 #include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/param.h>
 #include <sys/time.h>
+#include "bionic_name_mem.h"
+#include "pthread_internal.h"
 #include "thread_private.h"
 
+#define KEYSZ   32
+#define IVSZ    8
+#define BLOCKSZ 64
+#define RSBUFSZ (16 * BLOCKSZ)
+
+/* How much one key may produce before it's replaced with a fresh one. */
+#define REKEY_BYTES 1600000
+
+struct chacha_ctx {
+        uint32_t input[16];
+};
+
+struct arc4_state {
+        struct chacha_ctx ctx;
+        size_t have;                    /* unused bytes at the end of buf */
+        size_t count;                   /* bytes until the next rekey */
+        uint8_t buf[RSBUFSZ];
+};
+
 /* BIONIC-BEGIN */
 /* this lock should protect the global variables in this file */
 static pthread_mutex_t  _arc4_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -50,125 +74,259 @@ static pthread_mutex_t  _arc4_lock = PTHREAD_MUTEX_INITIALIZER;
 #define  _ARC4_UNLOCK()    pthread_mutex_unlock(&_arc4_lock)
 /* BIONIC-END */
 
-#ifdef __GNUC__
-#define inline __inline
-#else                           /* !__GNUC__ */
-#define inline
-#endif                          /* !__GNUC__ */
+/* Keys the threads' generators, and stands in for them where there's no thread yet. */
+static struct arc4_state rs_global;
 
-struct arc4_stream {
-        u_int8_t i;
-        u_int8_t j;
-        u_int8_t s[256];
-};
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
 
-static int rs_initialized;
-static struct arc4_stream rs;
-static pid_t arc4_stir_pid;
-static int arc4_count;
+#define QUARTERROUND(a, b, c, d) \
+        a += b; d = ROTL32(d ^ a, 16); \
+        c += d; b = ROTL32(b ^ c, 12); \
+        a += b; d = ROTL32(d ^ a, 8); \
+        c += d; b = ROTL32(b ^ c, 7)
 
-static inline u_int8_t arc4_getbyte(void);
+static inline uint32_t
+load32_le(const uint8_t *p)
+{
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+            ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
 static inline void
-arc4_init(void)
+store32_le(uint8_t *p, uint32_t v)
 {
-        int     n;
+        p[0] = v;
+        p[1] = v >> 8;
+        p[2] = v >> 16;
+        p[3] = v >> 24;
+}
 
-        for (n = 0; n < 256; n++)
-                rs.s[n] = n;
-        rs.i = 0;
-        rs.j = 0;
+static void
+chacha_setup(struct chacha_ctx *x, const uint8_t *key, const uint8_t *iv)
+{
+        int i;
+
+        /* "expand 32-byte k" */
+        x->input[0] = 0x61707865;
+        x->input[1] = 0x3320646e;
+        x->input[2] = 0x79622d32;
+        x->input[3] = 0x6b206574;
+        for (i = 0; i < 8; i++)
+                x->input[4 + i] = load32_le(key + 4 * i);
+        x->input[12] = 0;
+        x->input[13] = 0;
+        x->input[14] = load32_le(iv);
+        x->input[15] = load32_le(iv + 4);
 }
 
-static inline void
-arc4_addrandom(u_char *dat, int datlen)
+/* Writes 'blocks' blocks of keystream to 'out'. */
+static void
+chacha_keystream(struct chacha_ctx *x, uint8_t *out, size_t blocks)
 {
-        int     n;
-        u_int8_t si;
-
-        rs.i--;
-        for (n = 0; n < 256; n++) {
-                rs.i = (rs.i + 1);
-                si = rs.s[rs.i];
-                rs.j = (rs.j + si + dat[n % datlen]);
-                rs.s[rs.i] = rs.s[rs.j];
-                rs.s[rs.j] = si;
+        uint32_t s[16];
+        int i;
+
+        while (blocks-- > 0) {
+                memcpy(s, x->input, sizeof(s));
+                for (i = 0; i < 10; i++) {
+                        QUARTERROUND(s[0], s[4], s[8], s[12]);
+                        QUARTERROUND(s[1], s[5], s[9], s[13]);
+                        QUARTERROUND(s[2], s[6], s[10], s[14]);
+                        QUARTERROUND(s[3], s[7], s[11], s[15]);
+                        QUARTERROUND(s[0], s[5], s[10], s[15]);
+                        QUARTERROUND(s[1], s[6], s[11], s[12]);
+                        QUARTERROUND(s[2], s[7], s[8], s[13]);
+                        QUARTERROUND(s[3], s[4], s[9], s[14]);
+                }
+                for (i = 0; i < 16; i++)
+                        store32_le(out + 4 * i, s[i] + x->input[i]);
+                if (++x->input[12] == 0)
+                        x->input[13]++;
+                out += BLOCKSZ;
         }
-        rs.j = rs.i;
+        memset(s, 0, sizeof(s));
+}
+
+/*
+ * Refills the buffer and takes the generator's next key and IV from the
+ * start of it, mixing in 'dat' if there is any.
+ */
+static void
+arc4_rekey(struct arc4_state *rs, const uint8_t *dat, size_t datlen)
+{
+        size_t i;
+
+        chacha_keystream(&rs->ctx, rs->buf, RSBUFSZ / BLOCKSZ);
+        if (datlen > KEYSZ + IVSZ)
+                datlen = KEYSZ + IVSZ;
+        for (i = 0; i < datlen; i++)
+                rs->buf[i] ^= dat[i];
+        chacha_setup(&rs->ctx, rs->buf, rs->buf + KEYSZ);
+        memset(rs->buf, 0, KEYSZ + IVSZ);
+        rs->have = RSBUFSZ - KEYSZ - IVSZ;
 }
 
 static void
-arc4_stir(void)
+arc4_seed(struct arc4_state *rs, const uint8_t *seed)
+{
+        chacha_setup(&rs->ctx, seed, seed + KEYSZ);
+        rs->have = 0;
+        rs->count = REKEY_BYTES;
+        /* Don't hand out the keystream straight from the seed. */
+        arc4_rekey(rs, NULL, 0);
+}
+
+static void arc4_random_buf(struct arc4_state *rs, void *_buf, size_t n);
+
+/* Called with _arc4_lock held. */
+static void
+arc4_stir_global(void)
 {
 #if 1  /* BIONIC-BEGIN */
-	int     i, fd;
-	union {
-		struct timeval tv;
-		u_int rnd[128 / sizeof(u_int)];
-	}       rdat;
-	int	n;
-
-        if (!rs_initialized) {
-                arc4_init();
-                rs_initialized = 1;
+        int fd;
+        union {
+                struct timeval tv;
+                uint8_t rnd[KEYSZ + IVSZ];
+        } rdat;
+
+        fd = open("/dev/urandom", O_RDONLY);
+        if (fd == -1 || read(fd, rdat.rnd, sizeof(rdat.rnd)) != sizeof(rdat.rnd)) {
+                /* fd < 0 ?  Ah, what the heck. We'll just take
+                 * whatever was on the stack. just add a little more
+                 * time-based randomness though
+                 */
+                gettimeofday(&rdat.tv, NULL);
         }
+        if (fd != -1)
+                close(fd);
+#endif /* BIONIC-END */
 
-	fd = open("/dev/urandom", O_RDONLY);
-	if (fd != -1) {
-		read(fd, rdat.rnd, sizeof(rdat.rnd));
-		close(fd);
-	}
-        else
-        {
-	    /* fd < 0 ?  Ah, what the heck. We'll just take
-	     * whatever was on the stack. just add a little more
-             * time-based randomness though
-             */
-            gettimeofday(&rdat.tv, NULL);
+        if (rs_global.count == 0)
+                arc4_seed(&rs_global, rdat.rnd);
+        else {
+                /* Keep what we had, in case /dev/urandom let us down. */
+                arc4_rekey(&rs_global, rdat.rnd, sizeof(rdat.rnd));
+                rs_global.count = REKEY_BYTES;
         }
+        memset(&rdat, 0, sizeof(rdat));
+}
 
-        arc4_stir_pid = getpid();
-	arc4_addrandom((void *) &rdat, sizeof(rdat));
-#else  /* BIONIC-END */
-        int     i, mib[2];
-        size_t        len;
-        u_char rnd[128];
+static void
+arc4_stir(struct arc4_state *rs)
+{
+        uint8_t seed[KEYSZ + IVSZ];
 
-        if (!rs_initialized) {
-                arc4_init();
-                rs_initialized = 1;
+        if (rs == &rs_global) {
+                arc4_stir_global();
+                return;
+        }
+        _ARC4_LOCK();
+        arc4_random_buf(&rs_global, seed, sizeof(seed));
+        _ARC4_UNLOCK();
+        arc4_seed(rs, seed);
+        memset(seed, 0, sizeof(seed));
+}
+
+static inline void
+arc4_stir_if_needed(struct arc4_state *rs, size_t len)
+{
+        if (rs->count <= len)
+                arc4_stir(rs);
+        else
+                rs->count -= len;
+}
+
+static void
+arc4_random_buf(struct arc4_state *rs, void *_buf, size_t n)
+{
+        uint8_t *buf = (uint8_t *)_buf;
+        uint8_t *keystream;
+        size_t m;
+
+        arc4_stir_if_needed(rs, n);
+        while (n > 0) {
+                if (rs->have > 0) {
+                        m = n < rs->have ? n : rs->have;
+                        keystream = rs->buf + RSBUFSZ - rs->have;
+                        memcpy(buf, keystream, m);
+                        memset(keystream, 0, m);
+                        buf += m;
+                        n -= m;
+                        rs->have -= m;
+                }
+                if (rs->have == 0)
+                        arc4_rekey(rs, NULL, 0);
         }
+}
 
-        mib[0] = CTL_KERN;
-        mib[1] = KERN_ARND;
+static inline uint32_t
+arc4_random_u32(struct arc4_state *rs)
+{
+        uint8_t *keystream;
+        uint32_t val;
+
+        arc4_stir_if_needed(rs, sizeof(val));
+        if (rs->have < sizeof(val))
+                arc4_rekey(rs, NULL, 0);
+        keystream = rs->buf + RSBUFSZ - rs->have;
+        memcpy(&val, keystream, sizeof(val));
+        memset(keystream, 0, sizeof(val));
+        rs->have -= sizeof(val);
+        return val;
+}
 
-        len = sizeof(rnd);
-        sysctl(mib, 2, rnd, &len, NULL, 0);
+/*
+ * Returns the calling thread's generator, or NULL if it has none and can't
+ * get one, in which case the caller uses rs_global under the lock.
+ */
+static struct arc4_state *
+arc4_thread_state(void)
+{
+        pthread_internal_t *thread = __get_thread();
+        struct arc4_state *rs;
+
+        if (__predict_false(thread == NULL))
+                return NULL;
+        rs = thread->arc4random_state;
+        if (__predict_false(rs == NULL)) {
+                /* Not malloc(3): that may want random numbers of its own. */
+                rs = mmap(NULL, sizeof(*rs), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (rs == MAP_FAILED)
+                        return NULL;
+                __bionic_name_mem(rs, sizeof(*rs), "arc4random state");
+                /* A zero count makes the first use key it. */
+                thread->arc4random_state = rs;
+        }
+        return rs;
+}
 
-        arc4_stir_pid = getpid();
-        arc4_addrandom(rnd, sizeof(rnd));
-#endif
-        /*
-         * Discard early keystream, as per recommendations in:
-         * http://www.wisdom.weizmann.ac.il/~itsik/RC4/Papers/Rc4_ksa.ps
-         */
-        for (i = 0; i < 256; i++)
-                (void)arc4_getbyte();
-        arc4_count = 1600000;
+void
+__arc4random_thread_exit(pthread_internal_t *thread)
+{
+        struct arc4_state *rs = thread->arc4random_state;
+
+        if (rs != NULL) {
+                thread->arc4random_state = NULL;
+                memset(rs, 0, sizeof(*rs));
+                munmap(rs, sizeof(*rs));
+        }
 }
 
-static inline u_int8_t
-arc4_getbyte(void)
+void
+__arc4random_after_fork(void)
 {
-        u_int8_t si, sj;
-
-        rs.i = (rs.i + 1);
-        si = rs.s[rs.i];
-        rs.j = (rs.j + si);
-        sj = rs.s[rs.j];
-        rs.s[rs.i] = sj;
-        rs.s[rs.j] = si;
-        return (rs.s[(si + sj) & 0xff]);
+        pthread_internal_t *thread = __get_thread();
+
+        /*
+         * Another thread may have held the lock when we forked. The calling
+         * thread is the only one the child has, and its generator and the
+         * process-wide one both start again from /dev/urandom.
+         */
+        pthread_mutex_init(&_arc4_lock, NULL);
+        memset(&rs_global, 0, sizeof(rs_global));
+        if (thread != NULL && thread->arc4random_state != NULL)
+                memset(thread->arc4random_state, 0, sizeof(struct arc4_state));
 }
 
 u_int8_t
@@ -176,68 +334,66 @@ __arc4_getbyte(void)
 {
         u_int8_t val;
 
-        _ARC4_LOCK();
-        if (--arc4_count == 0 || !rs_initialized)
-                arc4_stir();
-        val = arc4_getbyte();
-        _ARC4_UNLOCK();
-        return val;
-}
-
-static inline u_int32_t
-arc4_getword(void)
-{
-        u_int32_t val;
-        val = arc4_getbyte() << 24;
-        val |= arc4_getbyte() << 16;
-        val |= arc4_getbyte() << 8;
-        val |= arc4_getbyte();
+        arc4random_buf(&val, sizeof(val));
         return val;
 }
 
 void
 arc4random_stir(void)
 {
+        struct arc4_state *rs;
+
         _ARC4_LOCK();
-        arc4_stir();
+        arc4_stir_global();
         _ARC4_UNLOCK();
+        rs = arc4_thread_state();
+        if (rs != NULL)
+                rs->count = 0;
 }
 
 void
 arc4random_addrandom(u_char *dat, int datlen)
 {
-        _ARC4_LOCK();
-        if (!rs_initialized)
-                arc4_stir();
-        arc4_addrandom(dat, datlen);
-        _ARC4_UNLOCK();
+        struct arc4_state *rs = arc4_thread_state();
+
+        if (datlen <= 0)
+                return;
+        if (rs == NULL) {
+                _ARC4_LOCK();
+                arc4_stir_if_needed(&rs_global, 0);
+                arc4_rekey(&rs_global, dat, datlen);
+                _ARC4_UNLOCK();
+                return;
+        }
+        arc4_stir_if_needed(rs, 0);
+        arc4_rekey(rs, dat, datlen);
 }
 
 u_int32_t
 arc4random(void)
 {
+        struct arc4_state *rs = arc4_thread_state();
         u_int32_t val;
+
+        if (__predict_true(rs != NULL))
+                return arc4_random_u32(rs);
         _ARC4_LOCK();
-        arc4_count -= 4;
-        if (arc4_count <= 0 || !rs_initialized || arc4_stir_pid != getpid())
-                arc4_stir();
-        val = arc4_getword();
+        val = arc4_random_u32(&rs_global);
         _ARC4_UNLOCK();
         return val;
 }
 
 void
-arc4random_buf(void *_buf, size_t n)
+arc4random_buf(void *buf, size_t n)
 {
-        u_char *buf = (u_char *)_buf;
-        _ARC4_LOCK();
-        if (!rs_initialized || arc4_stir_pid != getpid())
-                arc4_stir();
-        while (n--) {
-                if (--arc4_count <= 0)
-                        arc4_stir();
-                buf[n] = arc4_getbyte();
+        struct arc4_state *rs = arc4_thread_state();
+
+        if (__predict_true(rs != NULL)) {
+                arc4_random_buf(rs, buf, n);
+                return;
         }
+        _ARC4_LOCK();
+        arc4_random_buf(&rs_global, buf, n);
         _ARC4_UNLOCK();
 }
 
@@ -285,24 +441,3 @@ arc4random_uniform(u_int32_t upper_bound)
 
         return r % upper_bound;
 }
-
-#if 0
-/*-------- Test code for i386 --------*/
-#include <stdio.h>
-#include <machine/pctr.h>
-int
-main(int argc, char **argv)
-{
-        const int iter = 1000000;
-        int     i;
-        pctrval v;
-
-        v = rdtsc();
-        for (i = 0; i < iter; i++)
-                arc4random();
-        v = rdtsc() - v;
-        v /= iter;
-
-        printf("%qd cycles\n", v);
-}
-#endif
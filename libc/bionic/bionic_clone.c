@@ -31,6 +31,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+#include "pthread_internal.h"
+
 extern int  __bionic_clone(unsigned long   clone_flags,
                            void*           newsp,
                            int            *parent_tidptr,
@@ -51,9 +53,32 @@ __bionic_clone_entry( int (*fn)(void *), void *arg )
     _exit_thread(ret);
 }
 
+/* A child that doesn't share our memory has a copy of our pthread_internal_t,
+ * tid and all, so it has to fix that before gettid() can return the cached tid.
+ * A child that shares our memory without getting its own TLS shares our
+ * pthread_internal_t too, so we flag it and gettid() asks the kernel: until the
+ * child execs or exits with CLONE_VFORK, and for good without. */
+struct clone_child_args {
+    int (*fn)(void *);
+    void *arg;
+};
+
+static int
+__clone_child_fix_tid(void *raw_args)
+{
+    /* The child's copy of our stack still holds the args. */
+    struct clone_child_args *args = (struct clone_child_args *) raw_args;
+    pthread_internal_t *thread = __get_thread();
+    if (thread != NULL) {
+        thread->tid = __gettid();
+    }
+    return (*args->fn)(args->arg);
+}
+
 int
 clone(int (*fn)(void *), void *child_stack, int flags, void*  arg, ...)
 {
+    struct clone_child_args child_args;
     va_list  args;
     int     *parent_tidptr = NULL;
     void    *new_tls = NULL;
@@ -72,5 +97,24 @@ clone(int (*fn)(void *), void *child_stack, int flags, void*  arg, ...)
     }
     va_end(args);
 
-    return __bionic_clone(flags, child_stack, parent_tidptr, new_tls, child_tidptr, fn, arg);
+    if ((flags & CLONE_VM) == 0) {
+        child_args.fn = fn;
+        child_args.arg = arg;
+        return __bionic_clone(flags, child_stack, parent_tidptr, new_tls, child_tidptr,
+                              __clone_child_fix_tid, &child_args);
+    }
+
+    pthread_internal_t *thread = __get_thread();
+    int shared_flag = 0;
+    if ((flags & CLONE_SETTLS) == 0 && thread != NULL) {
+        shared_flag = (flags & CLONE_VFORK) ? PTHREAD_INTERNAL_FLAG_VFORKED
+                                            : PTHREAD_INTERNAL_FLAG_TID_SHARED;
+        thread->internal_flags |= shared_flag;
+    }
+    int result = __bionic_clone(flags, child_stack, parent_tidptr, new_tls, child_tidptr, fn, arg);
+    if (shared_flag == PTHREAD_INTERNAL_FLAG_VFORKED) {
+        /* The child has exec'ed or exited (or never started), and given it back. */
+        thread->internal_flags &= ~PTHREAD_INTERNAL_FLAG_VFORKED;
+    }
+    return result;
 }
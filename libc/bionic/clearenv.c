@@ -28,6 +28,9 @@
 
 #include <stddef.h>
 
+#include "private/bionic_env.h"
+#include "private/bionic_time.h"
+
 extern char** environ;
 
 int clearenv(void)
@@ -38,5 +41,7 @@ int clearenv(void)
         for (; *P; ++P)
             *P = NULL;
     }
+    __bionic_env_changed();
+    __bionic_tz_env_changed("TZ");
     return 0;
 }
@@ -32,29 +32,80 @@
 #include "cpuacct.h"
 #include <fcntl.h>
 
+/*
+ * Every setuid-style call made before dropping root (that is, once per
+ * process spawned by something like the zygote) lands here, so we keep
+ * /acct/uid open and only look up the last two path components each time.
+ * A process is free to close our fd and get the number back for something
+ * else, so the cached fd is only trusted while it's still the same directory.
+ * There's no lock, because this is typically called in a fresh fork child where
+ * a lock held by some other thread at fork time would never be released. Two
+ * threads racing here can at worst each open the directory and leak one fd.
+ */
+static int g_acct_uid_fd = -1;
+static dev_t g_acct_uid_dev;
+static ino_t g_acct_uid_ino;
+
+static int get_acct_uid_fd(void)
+{
+    struct stat st;
+    int fd;
+
+    if (g_acct_uid_fd != -1 &&
+            fstat(g_acct_uid_fd, &st) == 0 &&
+            st.st_dev == g_acct_uid_dev && st.st_ino == g_acct_uid_ino) {
+        return g_acct_uid_fd;
+    }
+
+    /* Don't close a stale fd: it belongs to someone else now. */
+    g_acct_uid_fd = -1;
+    fd = open("/acct/uid", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+    if (fstat(fd, &st) == -1) {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+    g_acct_uid_fd = fd;
+    g_acct_uid_dev = st.st_dev;
+    g_acct_uid_ino = st.st_ino;
+    return fd;
+}
+
 int cpuacct_add(uid_t uid)
 {
     int count;
+    int dir_fd;
     int fd;
-    char buf[80];
+    char buf[32];
     ssize_t n;
     int ret = 0;
 
-    count = snprintf(buf, sizeof(buf), "/acct/uid/%d/tasks", uid);
-    fd = open(buf, O_RDWR | O_CREAT, 0666);
+    dir_fd = get_acct_uid_fd();
+    if (dir_fd == -1)
+        return -errno;
+
+    count = snprintf(buf, sizeof(buf), "%d/tasks", uid);
+    fd = openat(dir_fd, buf, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
     if (fd == -1) {
         /* Note: sizeof("tasks") returns 6, which includes the NULL char */
         buf[count - sizeof("tasks")] = 0;
-        if (mkdir(buf, 0775) < 0)
+        if (mkdirat(dir_fd, buf, 0775) < 0)
             return -errno;
 
         /* Note: sizeof("tasks") returns 6, which includes the NULL char */
         buf[count - sizeof("tasks")] = '/';
-        fd = open(buf, O_RDWR | O_CREAT, 0666);
+        fd = openat(dir_fd, buf, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
     }
     if (fd == -1)
         return -errno;
 
+    /*
+     * "0" means the calling thread. The tasks file only takes one tid per
+     * write, and we only ever have the one to move.
+     */
     n = TEMP_FAILURE_RETRY(write(fd, "0", 1));
     if (n < 0)
         ret = -errno;
@@ -26,71 +26,192 @@
  * SUCH DAMAGE.
  */
 
+#include <android/dlext.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "dlmalloc.h"
 #include "debug_mapinfo.h"
 
+// Symbolizing a leak report looks up every frame of tens of thousands of
+// backtraces, so the mappings are kept in an array sorted by address rather
+// than a list. Reading /proc/<pid>/maps again is only worth it when the
+// linker's generation says a library has come or gone; mappings that are
+// still there are carried over, and those that have gone are kept until the
+// index is destroyed, since a caller may still be printing one's name.
+struct mapinfo_index_t {
+  pid_t pid;
+  unsigned generation;  // The linker's, when the maps were last read.
+  pthread_mutex_t lock;
+  mapinfo_t** maps;
+  size_t count;
+  size_t capacity;
+  mapinfo_t* gone;
+};
+
 // 6f000000-6f01e000 rwxp 00000000 00:0c 16389419   /system/lib/libcomposer.so
 // 012345678901234567890123456789012345678901234567890123456789
 // 0         1         2         3         4         5
 
-static mapinfo_t* parse_maps_line(char* line) {
+// Parses an executable mapping's line, setting 'name' to point into it.
+static bool parse_maps_line(char* line, unsigned* start, unsigned* end, const char** name) {
   int len = strlen(line);
 
-  if (len < 1) return 0;
+  if (len < 1) return false;
   line[--len] = 0;
 
-  if (len < 50) return 0;
-  if (line[20] != 'x') return 0;
+  if (len < 50) return false;
+  if (line[20] != 'x') return false;
 
-  mapinfo_t* mi = static_cast<mapinfo_t*>(dlmalloc(sizeof(mapinfo_t) + (len - 47)));
-  if (mi == 0) return 0;
+  *start = strtoul(line, 0, 16);
+  *end = strtoul(line + 9, 0, 16);
+  *name = line + 49;
+  return true;
+}
 
-  mi->start = strtoul(line, 0, 16);
-  mi->end = strtoul(line + 9, 0, 16);
-  mi->next = 0;
-  strcpy(mi->name, line + 49);
+static bool mapinfo_add(mapinfo_index_t* index, mapinfo_t* mi) {
+  if (index->count == index->capacity) {
+    size_t capacity = (index->capacity == 0) ? 64 : 2 * index->capacity;
+    void* maps = dlrealloc(index->maps, capacity * sizeof(mapinfo_t*));
+    if (maps == NULL) {
+      return false;
+    }
+    index->maps = reinterpret_cast<mapinfo_t**>(maps);
+    index->capacity = capacity;
+  }
+  index->maps[index->count++] = mi;
+  return true;
+}
 
-  return mi;
+static void mapinfo_retire(mapinfo_index_t* index, mapinfo_t* mi) {
+  mi->next = index->gone;
+  index->gone = mi;
 }
 
-__LIBC_HIDDEN__ mapinfo_t* mapinfo_create(pid_t pid) {
-  struct mapinfo_t* milist = NULL;
+// Rebuilds the array from /proc/<pid>/maps, which is in address order.
+static void mapinfo_read(mapinfo_index_t* index) {
+  mapinfo_t** old_maps = index->maps;
+  size_t old_count = index->count;
+  index->maps = NULL;
+  index->count = 0;
+  index->capacity = 0;
+
   char data[1024]; // Used to read lines as well as to construct the filename.
-  snprintf(data, sizeof(data), "/proc/%d/maps", pid);
+  snprintf(data, sizeof(data), "/proc/%d/maps", index->pid);
   FILE* fp = fopen(data, "r");
+  size_t old_i = 0;
   if (fp != NULL) {
     while (fgets(data, sizeof(data), fp) != NULL) {
-      mapinfo_t* mi = parse_maps_line(data);
-      if (mi) {
-        mi->next = milist;
-        milist = mi;
+      unsigned start;
+      unsigned end;
+      const char* name;
+      if (!parse_maps_line(data, &start, &end, &name)) {
+        continue;
+      }
+
+      mapinfo_t* mi = NULL;
+      while (old_i < old_count && old_maps[old_i]->start <= start) {
+        mapinfo_t* old = old_maps[old_i++];
+        if (old->start == start && old->end == end && strcmp(old->name, name) == 0) {
+          mi = old;
+          break;
+        }
+        mapinfo_retire(index, old);
+      }
+      if (mi == NULL) {
+        mi = static_cast<mapinfo_t*>(dlmalloc(sizeof(mapinfo_t) + strlen(name) + 1));
+        if (mi == NULL) {
+          continue;
+        }
+        mi->next = NULL;
+        mi->start = start;
+        mi->end = end;
+        strcpy(mi->name, name);
+      }
+      if (!mapinfo_add(index, mi)) {
+        mapinfo_retire(index, mi);
       }
     }
     fclose(fp);
   }
-  return milist;
+
+  while (old_i < old_count) {
+    mapinfo_retire(index, old_maps[old_i++]);
+  }
+  dlfree(old_maps);
 }
 
-__LIBC_HIDDEN__ void mapinfo_destroy(mapinfo_t* mi) {
+__LIBC_HIDDEN__ mapinfo_index_t* mapinfo_create(pid_t pid) {
+  mapinfo_index_t* index = static_cast<mapinfo_index_t*>(dlmalloc(sizeof(mapinfo_index_t)));
+  if (index == NULL) {
+    return NULL;
+  }
+  index->pid = pid;
+  index->generation = android_dl_get_generation();
+  // Reading the maps allocates, and so might report a heap error with a backtrace.
+  pthread_mutex_t lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER;
+  index->lock = lock;
+  index->maps = NULL;
+  index->count = 0;
+  index->capacity = 0;
+  index->gone = NULL;
+  mapinfo_read(index);
+  return index;
+}
+
+__LIBC_HIDDEN__ void mapinfo_destroy(mapinfo_index_t* index) {
+  if (index == NULL) {
+    return;
+  }
+  for (size_t i = 0; i < index->count; ++i) {
+    dlfree(index->maps[i]);
+  }
+  dlfree(index->maps);
+  mapinfo_t* mi = index->gone;
   while (mi != NULL) {
     mapinfo_t* del = mi;
     mi = mi->next;
     dlfree(del);
   }
+  pthread_mutex_destroy(&index->lock);
+  dlfree(index);
 }
 
 // Find the containing map info for the PC.
-__LIBC_HIDDEN__ const mapinfo_t* mapinfo_find(mapinfo_t* mi, uintptr_t pc, uintptr_t* rel_pc) {
-  for (; mi != NULL; mi = mi->next) {
-    if ((pc >= mi->start) && (pc < mi->end)) {
-      *rel_pc = pc - mi->start;
-      return mi;
+__LIBC_HIDDEN__ const mapinfo_t* mapinfo_find(mapinfo_index_t* index, uintptr_t pc, uintptr_t* rel_pc) {
+  pthread_mutex_lock(&index->lock);
+  if (index->pid == getpid()) {
+    unsigned generation = android_dl_get_generation();
+    if (generation != index->generation) {
+      index->generation = generation;
+      mapinfo_read(index);
     }
   }
-  *rel_pc = pc;
-  return NULL;
+
+  // Find the last mapping starting at or before 'pc'.
+  const mapinfo_t* result = NULL;
+  size_t lo = 0;
+  size_t hi = index->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (index->maps[mid]->start <= pc) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo > 0 && pc < index->maps[lo - 1]->end) {
+    result = index->maps[lo - 1];
+  }
+  pthread_mutex_unlock(&index->lock);
+
+  if (result == NULL) {
+    *rel_pc = pc;
+    return NULL;
+  }
+  *rel_pc = pc - result->start;
+  return result;
 }
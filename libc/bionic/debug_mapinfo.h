@@ -29,17 +29,25 @@
 #ifndef DEBUG_MAPINFO_H
 #define DEBUG_MAPINFO_H
 
+#include <stdint.h>
 #include <sys/cdefs.h>
+#include <sys/types.h>
 
 struct mapinfo_t {
-  struct mapinfo_t* next;
+  struct mapinfo_t* next;  // Used by the index to keep mappings that have gone.
   unsigned start;
   unsigned end;
   char name[];
 };
 
-__LIBC_HIDDEN__ mapinfo_t* mapinfo_create(pid_t pid);
-__LIBC_HIDDEN__ void mapinfo_destroy(mapinfo_t* mi);
-__LIBC_HIDDEN__ const mapinfo_t* mapinfo_find(mapinfo_t* mi, uintptr_t pc, uintptr_t* rel_pc);
+// The executable mappings of a process, sorted by address. The index of the
+// calling process is brought up to date whenever the linker reports that a
+// library has been loaded or unloaded since it was last read.
+struct mapinfo_index_t;
+
+__LIBC_HIDDEN__ mapinfo_index_t* mapinfo_create(pid_t pid);
+__LIBC_HIDDEN__ void mapinfo_destroy(mapinfo_index_t* index);
+// The mapping returned stays valid until the index is destroyed. Thread-safe.
+__LIBC_HIDDEN__ const mapinfo_t* mapinfo_find(mapinfo_index_t* index, uintptr_t pc, uintptr_t* rel_pc);
 
 #endif /* DEBUG_MAPINFO_H */
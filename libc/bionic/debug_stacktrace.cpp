@@ -28,13 +28,17 @@
 
 #include "debug_stacktrace.h"
 
+#include <android/dlext.h>
 #include <dlfcn.h>
+#include <string.h>
 #include <unistd.h>
 #include <unwind.h>
+#include <sys/system_properties.h>
 #include <sys/types.h>
 
 #include "debug_mapinfo.h"
 #include "libc_logging.h"
+#include "pthread_internal.h"
 
 /* depends how the system includes define this */
 #ifdef HAVE_UNWIND_CONTEXT_STRUCT
@@ -43,12 +47,26 @@ typedef struct _Unwind_Context __unwind_context;
 typedef _Unwind_Context __unwind_context;
 #endif
 
-static mapinfo_t* gMapInfo = NULL;
+static mapinfo_index_t* gMapInfo = NULL;
 static void* gDemangler;
 typedef char* (*DemanglerFn)(const char*, char*, size_t*, int*);
 static DemanglerFn gDemanglerFn = NULL;
 
+// Whether get_backtrace() tries the fast unwinder below before libgcc's. On
+// x86 it relies on frame pointers, which code is usually built without, so
+// there it has to be asked for by setting libc.debug.malloc.unwind to "fast".
+#if defined(__arm__)
+static bool gFastUnwind = true;
+#else
+static bool gFastUnwind = false;
+#endif
+
 __LIBC_HIDDEN__ void backtrace_startup() {
+  char value[PROP_VALUE_MAX];
+  if (__system_property_get("libc.debug.malloc.unwind", value) > 0) {
+    gFastUnwind = (strcmp(value, "fast") == 0);
+  }
+
   gMapInfo = mapinfo_create(getpid());
   gDemangler = dlopen("libgccdemangle.so", RTLD_NOW);
   if (gDemangler != NULL) {
@@ -80,6 +98,23 @@ struct stack_crawl_state_t {
   }
 };
 
+#ifdef __arm__
+/*
+ * The instruction pointer is pointing at the instruction after the bl(x), and
+ * the Thumb mode indicator (LSB in PC) has already been masked. So we need to
+ * do a quick check here to find out if the previous instruction is a
+ * Thumb-mode BLX(2). If so subtract 2 otherwise 4 from PC.
+ */
+static uintptr_t adjust_return_address(uintptr_t ip) {
+  short* ptr = reinterpret_cast<short*>(ip);
+  // Thumb BLX(2)
+  if ((*(ptr-1) & 0xff80) == 0x4780) {
+    return ip - 2;
+  }
+  return ip - 4;
+}
+#endif
+
 static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg) {
   stack_crawl_state_t* state = static_cast<stack_crawl_state_t*>(arg);
 
@@ -92,20 +127,8 @@ static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg)
   }
 
 #ifdef __arm__
-  /*
-   * The instruction pointer is pointing at the instruction after the bl(x), and
-   * the _Unwind_Backtrace routine already masks the Thumb mode indicator (LSB
-   * in PC). So we need to do a quick check here to find out if the previous
-   * instruction is a Thumb-mode BLX(2). If so subtract 2 otherwise 4 from PC.
-   */
   if (ip != 0) {
-    short* ptr = reinterpret_cast<short*>(ip);
-    // Thumb BLX(2)
-    if ((*(ptr-1) & 0xff80) == 0x4780) {
-      ip -= 2;
-    } else {
-      ip -= 4;
-    }
+    ip = adjust_return_address(ip);
   }
 #endif
 
@@ -113,7 +136,430 @@ static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg)
   return (state->frame_count >= state->max_depth) ? _URC_END_OF_STACK : _URC_NO_REASON;
 }
 
+// _Unwind_Backtrace is slow for what we want from it. It interprets the
+// unwind tables in full for every frame, and on ARM asks the linker which
+// library each frame is in, which costs a search and a pair of atomic
+// operations every time. All we need is the return addresses, and those can
+// be had much more cheaply. If the fast unwinder can't get past the first
+// frame, we fall back to libgcc's.
+
+#if defined(__arm__) || defined(__i386__)
+// The part of the calling thread's stack that's in use, which is the only
+// memory the fast unwinder reads other than unwind tables. Returns false if
+// 'sp' isn't on the thread's stack, as on an alternate signal stack.
+static bool get_stack_bounds(uintptr_t sp, uintptr_t* lo, uintptr_t* hi) {
+  pthread_internal_t* thread = __get_thread();
+  uintptr_t base = reinterpret_cast<uintptr_t>(thread->attr.stack_base);
+  if (sp < base || sp >= base + thread->attr.stack_size) {
+    return false;
+  }
+  *lo = sp;
+  *hi = base + thread->attr.stack_size;
+  return true;
+}
+#endif
+
+#if defined(__arm__)
+
+// ARM EHABI unwinding ("Exception Handling ABI for the ARM Architecture",
+// section 9). Each function's .ARM.exidx entry leads to a few bytes of
+// opcodes that undo its prologue, and that's all we run: no personality
+// routines, no unwinding of the VFP registers, no landing pads.
+
+// <link.h> declares this with an _Unwind_Ptr that clashes with <unwind.h>'s.
+extern "C" void* dl_unwind_find_exidx(void* pc, int* pcount);
+
+#define EXIDX_CANTUNWIND 1
+
+// Decodes a prel31 field: a 31-bit signed offset from the field's address.
+static uintptr_t prel31_to_addr(const uint32_t* p) {
+  int32_t offset = static_cast<int32_t>(*p << 1) >> 1;
+  return reinterpret_cast<uintptr_t>(p) + offset;
+}
+
+// A backtrace's frames are nearly always in the same few libraries, so the
+// PC ranges of the tables the linker found are cached. Entries are written by
+// whichever thread missed, under a sequence count so that readers never wait
+// and never see half an entry. They're only believed while the linker's
+// generation is the one they were found under: a library could have been
+// unloaded since, and another loaded into its place.
+#define EXIDX_CACHE_SIZE 16
+
+struct exidx_cache_entry_t {
+  volatile unsigned sequence;  // Odd while being written.
+  unsigned generation;
+  uintptr_t first_pc;          // Where the table's first and last functions start.
+  uintptr_t last_pc;
+  const uint32_t* table;
+  size_t count;
+};
+
+static exidx_cache_entry_t gExidxCache[EXIDX_CACHE_SIZE];
+static volatile unsigned gExidxCacheNext;
+
+static bool exidx_cache_find(uintptr_t pc, unsigned generation,
+                             const uint32_t** table, size_t* count) {
+  for (size_t i = 0; i < EXIDX_CACHE_SIZE; ++i) {
+    exidx_cache_entry_t* entry = &gExidxCache[i];
+    unsigned sequence = entry->sequence;
+    __sync_synchronize();
+    if ((sequence & 1) != 0 || entry->generation != generation ||
+        pc < entry->first_pc || pc > entry->last_pc) {
+      continue;
+    }
+    *table = entry->table;
+    *count = entry->count;
+    __sync_synchronize();
+    if (entry->sequence == sequence) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void exidx_cache_add(unsigned generation, const uint32_t* table, size_t count) {
+  exidx_cache_entry_t* entry =
+      &gExidxCache[__sync_fetch_and_add(&gExidxCacheNext, 1) % EXIDX_CACHE_SIZE];
+  unsigned sequence = entry->sequence;
+  if ((sequence & 1) != 0 || !__sync_bool_compare_and_swap(&entry->sequence, sequence, sequence + 1)) {
+    return;  // Another thread is writing it; ours can wait for the next miss.
+  }
+  entry->generation = generation;
+  entry->first_pc = prel31_to_addr(&table[0]);
+  entry->last_pc = prel31_to_addr(&table[2 * (count - 1)]);
+  entry->table = table;
+  entry->count = count;
+  __sync_synchronize();
+  entry->sequence = sequence + 2;
+}
+
+// Returns the exidx entry of the function containing 'pc', or NULL if 'pc'
+// isn't in a library with an exidx table.
+static const uint32_t* find_exidx_entry(uintptr_t pc, unsigned generation) {
+  const uint32_t* table;
+  size_t count;
+  if (!exidx_cache_find(pc, generation, &table, &count)) {
+    int n;
+    table = reinterpret_cast<const uint32_t*>(dl_unwind_find_exidx(reinterpret_cast<void*>(pc), &n));
+    if (table == NULL || n <= 0) {
+      return NULL;
+    }
+    count = n;
+    exidx_cache_add(generation, table, count);
+  }
+
+  // The entries are sorted by function; find the last one starting at or before 'pc'.
+  if (pc < prel31_to_addr(&table[0])) {
+    return NULL;
+  }
+  size_t lo = 0;
+  size_t hi = count;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (prel31_to_addr(&table[2 * mid]) <= pc) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return &table[2 * lo];
+}
+
+// Hands out a function's unwind opcodes, most significant byte of each word
+// first, from the exidx entry itself or the .ARM.extab entry it points to.
+class ArmUnwindOpcodes {
+ public:
+  ArmUnwindOpcodes() : next_word_(NULL), word_(0), bytes_left_(0), words_left_(0) {
+  }
+
+  // Returns false for entries that can't be unwound through, or that use a
+  // personality routine whose data we don't understand.
+  bool Init(const uint32_t* entry) {
+    uint32_t data = entry[1];
+    if (data == EXIDX_CANTUNWIND) {
+      return false;
+    }
+    if ((data & 0x80000000) != 0) {
+      // The opcodes are right here, for personality routine 0.
+      return InitCompact(data);
+    }
+    const uint32_t* extab = reinterpret_cast<const uint32_t*>(prel31_to_addr(&entry[1]));
+    if ((extab[0] & 0x80000000) != 0) {
+      next_word_ = extab + 1;
+      return InitCompact(extab[0]);
+    }
+    // A generic personality routine, such as __gxx_personality_v0, which uses
+    // the same format as personality routine 1 after its address.
+    word_ = extab[1];
+    bytes_left_ = 3;
+    words_left_ = word_ >> 24;
+    next_word_ = extab + 2;
+    return true;
+  }
+
+  // Returns false when there are no opcodes left, meaning "finish".
+  bool Next(uint8_t* opcode) {
+    if (bytes_left_ == 0) {
+      if (words_left_ == 0) {
+        return false;
+      }
+      word_ = *next_word_++;
+      --words_left_;
+      bytes_left_ = 4;
+    }
+    --bytes_left_;
+    *opcode = (word_ >> (bytes_left_ * 8)) & 0xff;
+    return true;
+  }
+
+ private:
+  bool InitCompact(uint32_t data) {
+    word_ = data;
+    switch ((data >> 24) & 0xf) {
+      case 0:
+        bytes_left_ = 3;
+        words_left_ = 0;
+        return true;
+      case 1:
+      case 2:
+        bytes_left_ = 2;
+        words_left_ = (data >> 16) & 0xff;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  const uint32_t* next_word_;
+  uint32_t word_;
+  size_t bytes_left_;
+  size_t words_left_;
+
+  // Disallow copy and assignment.
+  ArmUnwindOpcodes(const ArmUnwindOpcodes&);
+  void operator=(const ArmUnwindOpcodes&);
+};
+
+// Pops the core registers in 'mask' from the virtual stack pointer, regs[13].
+static bool arm_pop(uint32_t* regs, uint32_t mask, uintptr_t stack_lo, uintptr_t stack_hi) {
+  uintptr_t vsp = regs[13];
+  for (int i = 0; i < 16; ++i) {
+    if ((mask & (1 << i)) == 0) {
+      continue;
+    }
+    if (vsp < stack_lo || vsp + 4 > stack_hi || (vsp & 3) != 0) {
+      return false;
+    }
+    regs[i] = *reinterpret_cast<const uint32_t*>(vsp);
+    vsp += 4;
+  }
+  // Popping r13 sets the stack pointer to what was on the stack.
+  if ((mask & (1 << 13)) == 0) {
+    regs[13] = vsp;
+  }
+  return true;
+}
+
+// Runs the unwind opcodes of 'entry' on 'regs', leaving the caller's
+// registers, or at least its sp and pc, in 'regs'.
+static bool arm_unwind_frame(uint32_t* regs, const uint32_t* entry,
+                             uintptr_t stack_lo, uintptr_t stack_hi) {
+  ArmUnwindOpcodes opcodes;
+  if (!opcodes.Init(entry)) {
+    return false;
+  }
+  bool pc_set = false;
+  uint8_t op;
+  while (opcodes.Next(&op)) {
+    if ((op & 0xc0) == 0x00) {
+      regs[13] += ((op & 0x3f) << 2) + 4;
+    } else if ((op & 0xc0) == 0x40) {
+      regs[13] -= ((op & 0x3f) << 2) + 4;
+    } else if ((op & 0xf0) == 0x80) {
+      uint8_t op2;
+      if (!opcodes.Next(&op2)) {
+        return false;
+      }
+      uint32_t mask = (((op & 0x0f) << 8) | op2) << 4;
+      if (mask == 0) {
+        return false;  // "Refuse to unwind".
+      }
+      if (!arm_pop(regs, mask, stack_lo, stack_hi)) {
+        return false;
+      }
+      pc_set = pc_set || (mask & (1 << 15)) != 0;
+    } else if ((op & 0xf0) == 0x90) {
+      if ((op & 0x0f) == 13 || (op & 0x0f) == 15) {
+        return false;
+      }
+      regs[13] = regs[op & 0x0f];
+    } else if ((op & 0xf0) == 0xa0) {
+      // r4 to r[4+nnn], and r14 too if bit 3 is set.
+      uint32_t mask = ((1 << ((op & 0x07) + 1)) - 1) << 4;
+      if ((op & 0x08) != 0) {
+        mask |= 1 << 14;
+      }
+      if (!arm_pop(regs, mask, stack_lo, stack_hi)) {
+        return false;
+      }
+    } else if (op == 0xb0) {
+      break;
+    } else if (op == 0xb1) {
+      uint8_t op2;
+      if (!opcodes.Next(&op2) || op2 == 0 || (op2 & 0xf0) != 0) {
+        return false;
+      }
+      if (!arm_pop(regs, op2, stack_lo, stack_hi)) {
+        return false;
+      }
+    } else if (op == 0xb2) {
+      uint32_t value = 0;
+      int shift = 0;
+      uint8_t op2;
+      do {
+        if (!opcodes.Next(&op2) || shift > 28) {
+          return false;
+        }
+        value |= (op2 & 0x7f) << shift;
+        shift += 7;
+      } while ((op2 & 0x80) != 0);
+      regs[13] += 0x204 + (value << 2);
+    } else if (op == 0xb3 || op == 0xc8 || op == 0xc9 || op == 0xc6) {
+      // VFP D[ssss]-D[ssss+cccc], or iWMMXt wR[ssss]-wR[ssss+cccc]. FSTMFDX
+      // (0xb3) leaves an extra word.
+      uint8_t op2;
+      if (!opcodes.Next(&op2)) {
+        return false;
+      }
+      regs[13] += ((op2 & 0x0f) + 1) * 8 + ((op == 0xb3) ? 4 : 0);
+    } else if ((op & 0xf8) == 0xb8 || (op & 0xf8) == 0xd0) {
+      // VFP D[8]-D[8+nnn], with an extra word for FSTMFDX (0xb8).
+      regs[13] += ((op & 0x07) + 1) * 8 + (((op & 0xf8) == 0xb8) ? 4 : 0);
+    } else if (op == 0xc7) {
+      // iWMMXt wCGR registers under a mask.
+      uint8_t op2;
+      if (!opcodes.Next(&op2) || op2 == 0 || (op2 & 0xf0) != 0) {
+        return false;
+      }
+      regs[13] += __builtin_popcount(op2) * 4;
+    } else if ((op & 0xf8) == 0xc0) {
+      // iWMMXt wR[10]-wR[10+nnn].
+      regs[13] += ((op & 0x07) + 1) * 8;
+    } else {
+      return false;  // Spare.
+    }
+  }
+  if (!pc_set) {
+    regs[15] = regs[14];
+  }
+  return true;
+}
+
+__attribute__((noinline))
+static size_t fast_backtrace(uintptr_t* frames, size_t max_depth) {
+  // Unwinding starts here, in this function, with the registers as they are
+  // now: the opcodes describe the state of a function's whole body. Only the
+  // callee-saved registers matter, and the compiler only touches those it
+  // saved, which the unwinding restores, so they needn't be read all at once.
+  uint32_t regs[16] = { 0 };
+#define READ_REGISTER(n, name) asm volatile("mov %0, " #name : "=r"(regs[n]))
+  READ_REGISTER(4, r4);
+  READ_REGISTER(5, r5);
+  READ_REGISTER(6, r6);
+  READ_REGISTER(7, r7);
+  READ_REGISTER(8, r8);
+  READ_REGISTER(9, r9);
+  READ_REGISTER(10, r10);
+  READ_REGISTER(11, r11);
+  READ_REGISTER(13, sp);
+  READ_REGISTER(14, lr);
+#undef READ_REGISTER
+  regs[15] = reinterpret_cast<uintptr_t>(&fast_backtrace) & ~1;
+
+  uintptr_t stack_lo;
+  uintptr_t stack_hi;
+  if (!get_stack_bounds(regs[13], &stack_lo, &stack_hi)) {
+    return 0;
+  }
+
+  unsigned generation = android_dl_get_generation();
+  const uint32_t* entry = find_exidx_entry(regs[15], generation);
+  size_t frame_count = 0;
+  bool have_skipped_self = false;
+  while (entry != NULL && frame_count < max_depth) {
+    uintptr_t sp = regs[13];
+    uintptr_t pc = regs[15];
+    if (!arm_unwind_frame(regs, entry, stack_lo, stack_hi)) {
+      break;
+    }
+    uintptr_t ip = regs[15] & ~1;
+    if (ip == 0 || regs[13] < sp || (regs[13] == sp && ip == pc)) {
+      break;
+    }
+    regs[15] = ip;
+
+    // The first frame we get to is get_backtrace itself. Skip it.
+    if (have_skipped_self) {
+      frames[frame_count++] = adjust_return_address(ip);
+    } else {
+      have_skipped_self = true;
+    }
+
+    // A return address can be just past the end of a function that ends in
+    // a call, so look up the call.
+    entry = find_exidx_entry(ip - 1, generation);
+  }
+  return frame_count;
+}
+
+#elif defined(__i386__)
+
+// Follows the chain of saved frame pointers up from 'fp', the caller's frame.
+// The chain is only as long as the run of functions built with frame
+// pointers, and ends at the first frame pointer that isn't further up the
+// stack than the last.
+static size_t fast_backtrace(uintptr_t* frames, size_t max_depth, uintptr_t fp) {
+  uintptr_t stack_lo;
+  uintptr_t stack_hi;
+  if (!get_stack_bounds(fp, &stack_lo, &stack_hi)) {
+    return 0;
+  }
+
+  size_t frame_count = 0;
+  while (frame_count < max_depth) {
+    if (fp < stack_lo || fp + 2 * sizeof(uintptr_t) > stack_hi || (fp & 3) != 0) {
+      break;
+    }
+    const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+    if (frame[1] == 0) {
+      break;
+    }
+    frames[frame_count++] = frame[1];
+    if (frame[0] <= fp) {
+      break;
+    }
+    fp = frame[0];
+  }
+  return frame_count;
+}
+
+#endif
+
 __LIBC_HIDDEN__ int get_backtrace(uintptr_t* frames, size_t max_depth) {
+  if (gFastUnwind) {
+#if defined(__arm__)
+    size_t frame_count = fast_backtrace(frames, max_depth);
+#elif defined(__i386__)
+    size_t frame_count = fast_backtrace(frames, max_depth,
+                                        reinterpret_cast<uintptr_t>(__builtin_frame_address(0)));
+#else
+    size_t frame_count = 0;
+#endif
+    if (frame_count > 0) {
+      return frame_count;
+    }
+  }
+
   stack_crawl_state_t state(frames, max_depth);
   _Unwind_Backtrace(trace_function, &state);
   return state.frame_count;
@@ -30,19 +30,47 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "private/ErrnoRestorer.h"
-#include "private/ScopedPthreadMutexLocker.h"
+#include "private/thread_private.h"
+
+// Enough for several hundred typical entries per getdents(2), so scanning a large
+// directory doesn't cost a system call every dozen entries.
+#define DIR_BUFFER_SIZE (32 * 1024)
 
 struct DIR {
   int fd_;
   size_t available_bytes_;
   dirent* next_;
   pthread_mutex_t mutex_;
-  dirent buff_[15];
+  dirent* buff_;
+};
+
+// Until there's a second thread, nobody else can be using a DIR, so there's no need to lock it.
+class DirLocker {
+ public:
+  explicit DirLocker(DIR* d) : mutex_(__isthreaded ? &d->mutex_ : NULL) {
+    if (mutex_ != NULL) {
+      pthread_mutex_lock(mutex_);
+    }
+  }
+
+  ~DirLocker() {
+    if (mutex_ != NULL) {
+      pthread_mutex_unlock(mutex_);
+    }
+  }
+
+ private:
+  pthread_mutex_t* mutex_;
+
+  // Disallow copy and assignment.
+  DirLocker(const DirLocker&);
+  void operator=(const DirLocker&);
 };
 
 static DIR* __allocate_DIR(int fd) {
@@ -50,6 +78,11 @@ static DIR* __allocate_DIR(int fd) {
   if (d == NULL) {
     return NULL;
   }
+  d->buff_ = reinterpret_cast<dirent*>(malloc(DIR_BUFFER_SIZE));
+  if (d->buff_ == NULL) {
+    free(d);
+    return NULL;
+  }
   d->fd_ = fd;
   d->available_bytes_ = 0;
   d->next_ = NULL;
@@ -81,7 +114,7 @@ DIR* opendir(const char* path) {
 }
 
 static bool __fill_DIR(DIR* d) {
-  int rc = TEMP_FAILURE_RETRY(getdents(d->fd_, d->buff_, sizeof(d->buff_)));
+  int rc = TEMP_FAILURE_RETRY(getdents(d->fd_, d->buff_, DIR_BUFFER_SIZE));
   if (rc <= 0) {
     return false;
   }
@@ -102,7 +135,7 @@ static dirent* __readdir_locked(DIR* d) {
 }
 
 dirent* readdir(DIR* d) {
-  ScopedPthreadMutexLocker locker(&d->mutex_);
+  DirLocker locker(d);
   return __readdir_locked(d);
 }
 
@@ -112,7 +145,7 @@ int readdir_r(DIR* d, dirent* entry, dirent** result) {
   *result = NULL;
   errno = 0;
 
-  ScopedPthreadMutexLocker locker(&d->mutex_);
+  DirLocker locker(d);
 
   dirent* next = __readdir_locked(d);
   if (errno != 0 && next == NULL) {
@@ -134,12 +167,13 @@ int closedir(DIR* d) {
 
   int fd = d->fd_;
   pthread_mutex_destroy(&d->mutex_);
+  free(d->buff_);
   free(d);
   return close(fd);
 }
 
 void rewinddir(DIR* d) {
-  ScopedPthreadMutexLocker locker(&d->mutex_);
+  DirLocker locker(d);
   lseek(d->fd_, 0, SEEK_SET);
   d->available_bytes_ = 0;
 }
@@ -27,56 +27,67 @@
  */
 
 #include <elf.h>
+#include <pthread.h>
 #include <sys/auxv.h>
 #include <sys/types.h>
 #include <link.h>
 
 /* ld provides this to us in the default link script */
-extern void* __executable_start;
+extern Elf32_Ehdr __executable_start;
 
-int dl_iterate_phdr(int (*cb)(struct dl_phdr_info* info, size_t size, void* data), void* data) {
-    Elf32_Ehdr* ehdr = (Elf32_Ehdr*) &__executable_start;
-
-    // TODO: again, copied from linker.c. Find a better home for this later.
-    if (ehdr->e_ident[EI_MAG0] != ELFMAG0) return -1;
-    if (ehdr->e_ident[EI_MAG1] != ELFMAG1) return -1;
-    if (ehdr->e_ident[EI_MAG2] != ELFMAG2) return -1;
-    if (ehdr->e_ident[EI_MAG3] != ELFMAG3) return -1;
+// Dynamic binaries get their dl_iterate_phdr from the dynamic linker, but
+// static binaries get this. We don't have a list of shared objects to
+// iterate over, since there's really only a single monolithic blob of
+// code/data, plus optionally a VDSO. Neither moves once we're running, so
+// their dl_phdr_info is worked out once (unwinders call this for every
+// frame) and handed out from here after that.
+static struct dl_phdr_info g_phdr_infos[2];
+static size_t g_phdr_info_count;
+static pthread_once_t g_phdr_infos_once = PTHREAD_ONCE_INIT;
 
-    // Dynamic binaries get their dl_iterate_phdr from the dynamic linker, but
-    // static binaries get this. We don't have a list of shared objects to
-    // iterate over, since there's really only a single monolithic blob of
-    // code/data, plus optionally a VDSO.
+// Returns the address the VDSO was loaded at less the address it was linked at.
+static Elf32_Addr vdso_load_bias(const Elf32_Phdr* phdr, size_t phnum, Elf32_Addr loaded_at) {
+    for (size_t i = 0; i < phnum; ++i) {
+        if (phdr[i].p_type == PT_LOAD) {
+            return loaded_at - phdr[i].p_vaddr;
+        }
+    }
+    return 0;
+}
 
-    struct dl_phdr_info exe_info;
-    exe_info.dlpi_addr = 0;
-    exe_info.dlpi_name = NULL;
-    exe_info.dlpi_phdr = (Elf32_Phdr*) ((unsigned long) ehdr + ehdr->e_phoff);
-    exe_info.dlpi_phnum = ehdr->e_phnum;
+static void init_phdr_infos(void) {
+    // The executable. This works for a static PIE too: its load bias is
+    // where its entry point ended up less where it was linked.
+    struct dl_phdr_info* exe_info = &g_phdr_infos[g_phdr_info_count++];
+    exe_info->dlpi_name = NULL;
+    exe_info->dlpi_phdr = (Elf32_Phdr*) getauxval(AT_PHDR);
+    exe_info->dlpi_phnum = getauxval(AT_PHNUM);
+    exe_info->dlpi_addr = getauxval(AT_ENTRY) - __executable_start.e_entry;
 
 #ifdef AT_SYSINFO_EHDR
-    // Try the executable first.
-    int rc = cb(&exe_info, sizeof(exe_info), data);
-    if (rc != 0) {
-        return rc;
+    // The VDSO, if the kernel gave us one. Its ELF header is at the start of its first PT_LOAD.
+    Elf32_Ehdr* ehdr_vdso = (Elf32_Ehdr*) getauxval(AT_SYSINFO_EHDR);
+    if (ehdr_vdso != NULL) {
+        struct dl_phdr_info* vdso_info = &g_phdr_infos[g_phdr_info_count++];
+        vdso_info->dlpi_name = NULL;
+        vdso_info->dlpi_phdr = (Elf32_Phdr*) ((char*) ehdr_vdso + ehdr_vdso->e_phoff);
+        vdso_info->dlpi_phnum = ehdr_vdso->e_phnum;
+        vdso_info->dlpi_addr = vdso_load_bias(vdso_info->dlpi_phdr, vdso_info->dlpi_phnum,
+                                              (Elf32_Addr) ehdr_vdso);
     }
+#endif
+}
 
-    // Try the VDSO if that didn't work.
-    Elf32_Ehdr* ehdr_vdso = (Elf32_Ehdr*) getauxval(AT_SYSINFO_EHDR);
-    struct dl_phdr_info vdso_info;
-    vdso_info.dlpi_addr = 0;
-    vdso_info.dlpi_name = NULL;
-    vdso_info.dlpi_phdr = (Elf32_Phdr*) ((char*) ehdr_vdso + ehdr_vdso->e_phoff);
-    vdso_info.dlpi_phnum = ehdr_vdso->e_phnum;
-    for (size_t i = 0; i < vdso_info.dlpi_phnum; ++i) {
-        if (vdso_info.dlpi_phdr[i].p_type == PT_LOAD) {
-            vdso_info.dlpi_addr = (Elf32_Addr) ehdr_vdso - vdso_info.dlpi_phdr[i].p_vaddr;
+int dl_iterate_phdr(int (*cb)(struct dl_phdr_info* info, size_t size, void* data), void* data) {
+    pthread_once(&g_phdr_infos_once, init_phdr_infos);
+
+    // Try the executable first, then the VDSO if that didn't work.
+    int rc = 0;
+    for (size_t i = 0; i < g_phdr_info_count; ++i) {
+        rc = cb(&g_phdr_infos[i], sizeof(g_phdr_infos[i]), data);
+        if (rc != 0) {
             break;
         }
     }
-    return cb(&vdso_info, sizeof(vdso_info), data);
-#else
-    // There's only the executable to try.
-    return cb(&exe_info, sizeof(exe_info), data);
-#endif
+    return rc;
 }
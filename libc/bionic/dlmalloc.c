@@ -16,7 +16,10 @@
 
 #include "dlmalloc.h"
 
+#include "private/bionic_counters.h"
+#include "private/bionic_hugepage.h"
 #include "private/bionic_name_mem.h"
+#include "private/bionic_trace.h"
 #include "private/libc_logging.h"
 
 // Send dlmalloc errors to the log.
@@ -31,6 +34,13 @@ static void* named_anonymous_mmap(size_t length);
 #define MMAP(s) named_anonymous_mmap(s)
 #define DIRECT_MMAP(s) named_anonymous_mmap(s)
 
+/* Trace the heap going to the kernel for more memory (see <android/trace_events.h>). */
+static void* traced_sbrk(ptrdiff_t increment);
+#define MORECORE(s) traced_sbrk(s)
+
+/* dlmalloc passes a "may move" boolean where mremap wants flags. */
+#define MREMAP(addr, osz, nsz, mv) mremap((addr), (osz), (nsz), (mv) ? MREMAP_MAYMOVE : 0)
+
 // Ugly inclusion of C file so that bionic specific #defines configure dlmalloc.
 #include "../upstream-dlmalloc/malloc.c"
 
@@ -52,7 +62,9 @@ static void __bionic_heap_usage_error(const char* function, void* address) {
 static void* named_anonymous_mmap(size_t length)
 {
     void* ret;
-    ret = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    __libc_trace(ANDROID_TRACE_MALLOC_SYSTEM, length);
+    __libc_counter_add(ANDROID_LIBC_COUNTER_MALLOC_SYSTEM, 1);
+    ret = __bionic_hugepage_mmap(length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS);
     if (ret == MAP_FAILED)
         return ret;
 
@@ -60,3 +72,40 @@ static void* named_anonymous_mmap(size_t length)
 
     return ret;
 }
+
+static void* traced_sbrk(ptrdiff_t increment)
+{
+    void* ret;
+    /* dlmalloc also calls this with 0 to find the break, and to shrink the heap. */
+    if (increment > 0) {
+        __libc_trace(ANDROID_TRACE_MALLOC_SYSTEM, increment);
+        __libc_counter_add(ANDROID_LIBC_COUNTER_MALLOC_SYSTEM, 1);
+    }
+    ret = sbrk(increment);
+    if (increment > 0 && ret != (void*) -1) {
+        __bionic_hugepage_advise(ret, increment);
+    }
+    return ret;
+}
+
+int __bionic_dlmalloc_is_mmapped(void* mem)
+{
+    return is_mmapped(mem2chunk(mem));
+}
+
+int __bionic_malloc_set_hugepages(int enable)
+{
+    static size_t default_granularity;
+    ensure_initialization();
+    if (default_granularity == 0) {
+        default_granularity = mparams.granularity;
+    }
+    __bionic_hugepages_enabled = (enable != 0);
+    /* Growing the heap a huge page at a time keeps segments huge page sized. */
+    if (enable && default_granularity < BIONIC_HUGEPAGE_SIZE) {
+        mparams.granularity = BIONIC_HUGEPAGE_SIZE;
+    } else {
+        mparams.granularity = default_granularity;
+    }
+    return 1;
+}
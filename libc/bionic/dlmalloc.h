@@ -20,7 +20,8 @@
 /* Configure dlmalloc. */
 #define HAVE_GETPAGESIZE 1
 #define MALLOC_INSPECT_ALL 1
-#define MSPACES 0
+#define MSPACES 1
+#define FOOTERS 1 /* So that frees find a chunk's mspace (see malloc_arena.h). */
 #define REALLOC_ZERO_BYTES_FREES 1
 #define USE_DL_PREFIX 1
 #define USE_LOCKS 1
@@ -28,8 +29,21 @@
 #define USE_RECURSIVE_LOCK 0
 #define USE_SPIN_LOCKS 0
 #define DEFAULT_MMAP_THRESHOLD (64U * 1024U)
+/* Grow and shrink mmapped chunks with mremap rather than by copying. Don't
+ * rely on "linux" being predefined, which it isn't in strict modes. */
+#define HAVE_MREMAP 1
 
 /* Include the proper definitions. */
 #include "../upstream-dlmalloc/malloc.h"
 
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/* Whether 'mem', from the global heap or an mspace, is a chunk with a mapping
+ * of its own, and so still zero when new. */
+__LIBC_HIDDEN__ int __bionic_dlmalloc_is_mmapped(void* mem);
+
+__END_DECLS
+
 #endif  // LIBC_BIONIC_DLMALLOC_H_
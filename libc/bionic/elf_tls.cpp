@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+
+#include "bionic_tls.h"
+#include "private/libc_logging.h"
+#include "pthread_internal.h"
+
+// The dynamic linker's table of TLS modules, from the kernel argument block (see
+// __libc_init_common). It's NULL in static executables, which get no dynamic TLS.
+__LIBC_HIDDEN__ bionic_tls_modules_t* __libc_tls_modules = NULL;
+
+// What general- and local-dynamic TLS code passes to __tls_get_addr: the module id and
+// offset in its TLS block from R_*_TLS_DTPMOD32 and R_*_TLS_DTPOFF32 relocations.
+struct tls_index {
+  unsigned long module;
+  unsigned long offset;
+};
+
+// A thread's copy of a module's TLS block.
+struct elf_tls_block_t {
+  void* block;
+  uint32_t generation;
+};
+
+// Each thread's "dynamic thread vector" of TLS blocks, indexed by module id.
+struct elf_tls_dtv_t {
+  elf_tls_block_t blocks[BIONIC_TLS_MODULES_MAX];
+};
+
+static void* elf_tls_allocate(pthread_internal_t* thread, unsigned long module) {
+  if (__libc_tls_modules == NULL || module == 0 || module >= BIONIC_TLS_MODULES_MAX ||
+      __libc_tls_modules->modules[module].generation == 0) {
+    __libc_fatal("__tls_get_addr: invalid TLS module %lu", module);
+  }
+  const bionic_tls_module_t* m = &__libc_tls_modules->modules[module];
+
+  elf_tls_dtv_t* dtv = reinterpret_cast<elf_tls_dtv_t*>(thread->elf_tls_dtv);
+  if (dtv == NULL) {
+    dtv = reinterpret_cast<elf_tls_dtv_t*>(calloc(1, sizeof(elf_tls_dtv_t)));
+    if (dtv == NULL) {
+      __libc_fatal("__tls_get_addr: out of memory allocating the thread's TLS vector");
+    }
+    thread->elf_tls_dtv = dtv;
+  }
+
+  // Any block we already have belonged to an unloaded module that had the same id.
+  elf_tls_block_t* b = &dtv->blocks[module];
+  free(b->block);
+
+  size_t align = (m->align > sizeof(void*)) ? m->align : sizeof(void*);
+  uint8_t* block = reinterpret_cast<uint8_t*>(memalign(align, m->block_size > 0 ? m->block_size : 1));
+  if (block == NULL) {
+    __libc_fatal("__tls_get_addr: out of memory allocating %u bytes of TLS for module %lu",
+                 m->block_size, module);
+  }
+  memcpy(block, m->init_image, m->init_size);
+  memset(block + m->init_size, 0, m->block_size - m->init_size);
+
+  b->block = block;
+  b->generation = m->generation;
+  return block;
+}
+
+extern "C" void* __tls_get_addr(tls_index* ti) {
+  pthread_internal_t* thread = __get_thread();
+  elf_tls_dtv_t* dtv = reinterpret_cast<elf_tls_dtv_t*>(thread->elf_tls_dtv);
+
+  // The common case: this thread has already used this module's TLS.
+  if (__predict_true(dtv != NULL && ti->module < BIONIC_TLS_MODULES_MAX)) {
+    elf_tls_block_t* b = &dtv->blocks[ti->module];
+    if (__predict_true(b->block != NULL &&
+                       b->generation == __libc_tls_modules->modules[ti->module].generation)) {
+      return reinterpret_cast<uint8_t*>(b->block) + ti->offset;
+    }
+  }
+
+  return reinterpret_cast<uint8_t*>(elf_tls_allocate(thread, ti->module)) + ti->offset;
+}
+
+#if defined(__i386__)
+// The GNU TLS dialect used on x86 calls this variant, which takes its argument in %eax.
+extern "C" __attribute__((__regparm__(1))) void* ___tls_get_addr(tls_index* ti) {
+  return __tls_get_addr(ti);
+}
+#endif
+
+// Called from pthread_exit() once the thread's TLS destructors have run.
+__LIBC_HIDDEN__ void __elf_tls_thread_exit(pthread_internal_t* thread) {
+  elf_tls_dtv_t* dtv = reinterpret_cast<elf_tls_dtv_t*>(thread->elf_tls_dtv);
+  if (dtv == NULL) {
+    return;
+  }
+  thread->elf_tls_dtv = NULL;
+  for (size_t i = 0; i < BIONIC_TLS_MODULES_MAX; ++i) {
+    free(dtv->blocks[i].block);
+  }
+  free(dtv);
+}
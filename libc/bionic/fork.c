@@ -28,6 +28,7 @@
 #include <unistd.h>
 #include "pthread_internal.h"
 #include "bionic_pthread.h"
+#include "bionic_thread_table.h"
 #include "cpuacct.h"
 
 extern int  __fork(void);
@@ -49,8 +50,18 @@ int  fork(void)
         __timer_table_start_stop(0);
         __bionic_atfork_run_parent();
     } else {
-        // Fix the tid in the pthread_internal_t struct after a fork.
-        __pthread_settid(pthread_self(), gettid());
+        // Fix the tid in the pthread_internal_t struct after a fork. The kernel
+        // doesn't carry set_tid_address over a fork, so ask again, so that this
+        // thread can still be joined.
+        pthread_internal_t* self = (pthread_internal_t*) pthread_self();
+        __pthread_settid(pthread_self(), __set_tid_address(&self->tid));
+        self->internal_flags |= PTHREAD_INTERNAL_FLAG_CLEARS_TID;
+        __bionic_thread_table_after_fork((pthread_internal_t*) pthread_self());
+        // Don't let the child replay the parent's random numbers.
+        __arc4random_after_fork();
+
+        // Our SIGEV_THREAD timer threads didn't survive the fork.
+        __timer_table_after_fork_child();
 
         /*
          * Newly created process must update cpu accounting.
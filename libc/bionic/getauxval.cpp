@@ -34,7 +34,25 @@
 
 __LIBC_HIDDEN__ Elf32_auxv_t* __libc_auxv = NULL;
 
+// Every AT_ type the kernel passes today is below 64, so they're copied into a
+// table indexed by type. A type that isn't there reads as 0, which is also what
+// getauxval returns for a missing entry.
+static const unsigned long int kAuxvTableSize = 64;
+static unsigned long int g_auxv_values[kAuxvTableSize];
+
+__LIBC_HIDDEN__ void __libc_init_auxv(Elf32_auxv_t* auxv) {
+  __libc_auxv = auxv;
+  for (Elf32_auxv_t* v = auxv; v->a_type != AT_NULL; ++v) {
+    if (v->a_type < kAuxvTableSize) {
+      g_auxv_values[v->a_type] = v->a_un.a_val;
+    }
+  }
+}
+
 extern "C" unsigned long int getauxval(unsigned long int type) {
+  if (type < kAuxvTableSize) {
+    return g_auxv_values[type];
+  }
   for (Elf32_auxv_t* v = __libc_auxv; v->a_type != AT_NULL; ++v) {
     if (v->a_type == type) {
       return v->a_un.a_val;
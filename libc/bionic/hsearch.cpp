@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <search.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The hsearch family as an open-addressing table of (hash, entry) slots with
+// linear probing, doubled whenever it's three quarters full. The entries
+// themselves live in chunks that never move, since callers keep the ENTRY*
+// that hsearch returns and update its data; only the slots are rehashed.
+// POSIX has no way to remove entries, so there are no tombstones either.
+
+struct hsearch_slot {
+  uint32_t hash;
+  ENTRY* entry;  // NULL if the slot is empty.
+};
+
+struct hsearch_chunk {
+  hsearch_chunk* next;
+  size_t used;
+  size_t capacity;
+  ENTRY entries[0];
+};
+
+struct __hsearch {
+  hsearch_slot* slots;
+  size_t mask;  // The slot count is a power of two.
+  size_t filled;
+  hsearch_chunk* chunks;  // Newest first.
+};
+
+// FNV-1a.
+static uint32_t hash_key(const char* key) {
+  uint32_t h = 2166136261U;
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(key); *p != '\0'; ++p) {
+    h = (h ^ *p) * 16777619U;
+  }
+  return h;
+}
+
+static hsearch_slot* find_slot(hsearch_slot* slots, size_t mask, uint32_t hash, const char* key) {
+  for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+    hsearch_slot* slot = &slots[i];
+    if (slot->entry == NULL || (slot->hash == hash && strcmp(slot->entry->key, key) == 0)) {
+      return slot;
+    }
+  }
+}
+
+static bool grow(__hsearch* table) {
+  size_t new_mask = table->mask * 2 + 1;
+  hsearch_slot* new_slots = reinterpret_cast<hsearch_slot*>(calloc(new_mask + 1, sizeof(hsearch_slot)));
+  if (new_slots == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i <= table->mask; ++i) {
+    hsearch_slot* slot = &table->slots[i];
+    if (slot->entry != NULL) {
+      *find_slot(new_slots, new_mask, slot->hash, slot->entry->key) = *slot;
+    }
+  }
+  free(table->slots);
+  table->slots = new_slots;
+  table->mask = new_mask;
+  return true;
+}
+
+static ENTRY* new_entry(__hsearch* table) {
+  hsearch_chunk* chunk = table->chunks;
+  if (chunk == NULL || chunk->used == chunk->capacity) {
+    // Each chunk is as big as all the others together, so there are few of them.
+    size_t capacity = (chunk != NULL) ? table->filled : (table->mask + 1) / 2;
+    chunk = reinterpret_cast<hsearch_chunk*>(malloc(sizeof(hsearch_chunk) + capacity * sizeof(ENTRY)));
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = table->chunks;
+    chunk->used = 0;
+    chunk->capacity = capacity;
+    table->chunks = chunk;
+  }
+  return &chunk->entries[chunk->used++];
+}
+
+int hcreate_r(size_t nel, hsearch_data* htab) {
+  if (htab == NULL || htab->__hsearch != NULL) {
+    errno = EINVAL;
+    return 0;
+  }
+
+  // Room for nel entries without growing, and at least a few.
+  if (nel > static_cast<size_t>(-1) / 4 / sizeof(hsearch_slot)) {
+    errno = ENOMEM;
+    return 0;
+  }
+  size_t slot_count = 16;
+  while (slot_count / 4 * 3 < nel) {
+    slot_count *= 2;
+  }
+  __hsearch* table = reinterpret_cast<__hsearch*>(calloc(1, sizeof(__hsearch)));
+  if (table == NULL) {
+    return 0;
+  }
+  table->slots = reinterpret_cast<hsearch_slot*>(calloc(slot_count, sizeof(hsearch_slot)));
+  if (table->slots == NULL) {
+    free(table);
+    return 0;
+  }
+  table->mask = slot_count - 1;
+  htab->__hsearch = table;
+  return 1;
+}
+
+void hdestroy_r(hsearch_data* htab) {
+  if (htab == NULL || htab->__hsearch == NULL) {
+    return;
+  }
+  // The keys and data belong to the caller.
+  __hsearch* table = htab->__hsearch;
+  hsearch_chunk* chunk = table->chunks;
+  while (chunk != NULL) {
+    hsearch_chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(table->slots);
+  free(table);
+  htab->__hsearch = NULL;
+}
+
+int hsearch_r(ENTRY item, ACTION action, ENTRY** retval, hsearch_data* htab) {
+  __hsearch* table = (htab != NULL) ? htab->__hsearch : NULL;
+  if (table == NULL) {
+    *retval = NULL;
+    errno = EINVAL;
+    return 0;
+  }
+
+  uint32_t hash = hash_key(item.key);
+  hsearch_slot* slot = find_slot(table->slots, table->mask, hash, item.key);
+  if (slot->entry != NULL) {
+    *retval = slot->entry;
+    return 1;
+  }
+  if (action == FIND) {
+    *retval = NULL;
+    errno = ESRCH;
+    return 0;
+  }
+
+  if (table->filled + 1 > (table->mask + 1) / 4 * 3) {
+    if (!grow(table)) {
+      *retval = NULL;
+      errno = ENOMEM;
+      return 0;
+    }
+    slot = find_slot(table->slots, table->mask, hash, item.key);
+  }
+  ENTRY* entry = new_entry(table);
+  if (entry == NULL) {
+    *retval = NULL;
+    errno = ENOMEM;
+    return 0;
+  }
+  *entry = item;
+  slot->hash = hash;
+  slot->entry = entry;
+  ++table->filled;
+  *retval = entry;
+  return 1;
+}
+
+static hsearch_data gHsearchTable;
+
+int hcreate(size_t nel) {
+  return hcreate_r(nel, &gHsearchTable);
+}
+
+void hdestroy() {
+  hdestroy_r(&gHsearchTable);
+}
+
+ENTRY* hsearch(ENTRY item, ACTION action) {
+  ENTRY* result;
+  hsearch_r(item, action, &result, &gHsearchTable);
+  return result;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "private/bionic_hugepage.h"
+
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "private/ErrnoRestorer.h"
+
+int __bionic_hugepages_enabled;
+
+void* __bionic_hugepage_mmap(size_t length, int prot, int flags) {
+  size_t rounded = (length + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  if (!__bionic_hugepages_enabled || rounded < BIONIC_HUGEPAGE_SIZE ||
+      rounded > static_cast<size_t>(-1) - BIONIC_HUGEPAGE_SIZE) {
+    return mmap(NULL, length, prot, flags, -1, 0);
+  }
+
+  // Over-allocate, so that some huge page boundary falls early enough in
+  // the mapping, and trim the ends off.
+  size_t padded = rounded + BIONIC_HUGEPAGE_SIZE - PAGE_SIZE;
+  void* map = mmap(NULL, padded, prot, flags, -1, 0);
+  if (map == MAP_FAILED) {
+    return mmap(NULL, length, prot, flags, -1, 0);
+  }
+  uintptr_t map_start = reinterpret_cast<uintptr_t>(map);
+  uintptr_t map_end = map_start + padded;
+  uintptr_t start = (map_start + BIONIC_HUGEPAGE_SIZE - 1) & ~(BIONIC_HUGEPAGE_SIZE - 1);
+  uintptr_t end = start + rounded;
+  if (start > map_start) {
+    munmap(map, start - map_start);
+  }
+  if (map_end > end) {
+    munmap(reinterpret_cast<void*>(end), map_end - end);
+  }
+
+  void* result = reinterpret_cast<void*>(start);
+  __bionic_hugepage_advise(result, rounded);
+  return result;
+}
+
+void __bionic_hugepage_advise(void* addr, size_t length) {
+  if (!__bionic_hugepages_enabled) {
+    return;
+  }
+  uintptr_t start = (reinterpret_cast<uintptr_t>(addr) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + length) & ~(PAGE_SIZE - 1);
+  if (end > start) {
+    // Kernels without transparent huge pages say EINVAL; that's fine.
+    ErrnoRestorer errno_restorer;
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/libc_counters.h>
+
+#include <android/format.h>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pthread_internal.h"
+#include "private/bionic_counters.h"
+
+// What threads that have exited had counted. Taken before any thread list shard's lock.
+static pthread_mutex_t gCountersLock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t gExitedCounters[ANDROID_LIBC_COUNTER_COUNT];
+
+static const char* const kCounterNames[ANDROID_LIBC_COUNTER_COUNT] = {
+  "mutex_waits",
+  "malloc_system",
+  "dlopen",
+  "dlopen_ns",
+  "dns_cache_hits",
+  "dns_cache_misses",
+  "property_lookups",
+};
+
+void __libc_counter_add(int counter, uint64_t n) {
+  pthread_internal_t* thread = __get_thread();
+  // Early in startup, before the main thread has been set up, there's nowhere to count.
+  if (__predict_true(thread != NULL)) {
+    thread->counters[counter] += n;
+  }
+}
+
+void __libc_counters_thread_exit(pthread_internal_t* thread) {
+  pthread_mutex_lock(&gCountersLock);
+  for (size_t i = 0; i < ANDROID_LIBC_COUNTER_COUNT; ++i) {
+    gExitedCounters[i] += thread->counters[i];
+    thread->counters[i] = 0;
+  }
+  pthread_mutex_unlock(&gCountersLock);
+}
+
+size_t android_libc_counters_read(uint64_t* values, size_t count) {
+  uint64_t totals[ANDROID_LIBC_COUNTER_COUNT];
+  // Holding gCountersLock throughout means an exiting thread's counts are either all in
+  // gExitedCounters or all still its own, so they're counted once. Nothing that holds a shard
+  // lock waits for gCountersLock, so taking the shard locks inside it is safe.
+  pthread_mutex_lock(&gCountersLock);
+  memcpy(totals, gExitedCounters, sizeof(totals));
+  for (size_t i = 0; i < PTHREAD_LIST_SHARDS; ++i) {
+    pthread_list_shard_t* shard = &gThreadListShards[i];
+    pthread_mutex_lock(&shard->lock);
+    for (pthread_internal_t* thread = shard->head; thread != NULL; thread = thread->next) {
+      // Another thread's counters may be a moment stale, or on 32-bit torn mid-carry.
+      for (size_t j = 0; j < ANDROID_LIBC_COUNTER_COUNT; ++j) {
+        totals[j] += thread->counters[j];
+      }
+    }
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_mutex_unlock(&gCountersLock);
+
+  if (count > ANDROID_LIBC_COUNTER_COUNT) {
+    count = ANDROID_LIBC_COUNTER_COUNT;
+  }
+  memcpy(values, totals, count * sizeof(uint64_t));
+  return ANDROID_LIBC_COUNTER_COUNT;
+}
+
+const char* android_libc_counter_name(int counter) {
+  if (counter < 0 || counter >= ANDROID_LIBC_COUNTER_COUNT) {
+    return NULL;
+  }
+  return kCounterNames[counter];
+}
+
+int android_libc_counters_dump(int fd) {
+  uint64_t values[ANDROID_LIBC_COUNTER_COUNT];
+  android_libc_counters_read(values, ANDROID_LIBC_COUNTER_COUNT);
+  for (size_t i = 0; i < ANDROID_LIBC_COUNTER_COUNT; ++i) {
+    char line[64];
+    int length = android_format_buffer(line, sizeof(line), "%s %llu\n", kCounterNames[i],
+                                       static_cast<unsigned long long>(values[i]));
+    if (android_format_fd(fd, "%s", line) != length) {
+      return -1;
+    }
+  }
+  return 0;
+}
@@ -48,8 +48,8 @@
 #include "pthread_internal.h"
 
 extern "C" abort_msg_t** __abort_message_ptr;
+extern "C" bionic_tls_modules_t* __libc_tls_modules;
 extern "C" unsigned __get_sp(void);
-extern "C" int __system_properties_init(void);
 
 // Not public, but well-known in the BSDs.
 const char* __progname;
@@ -84,14 +84,14 @@ static size_t get_stack_size() {
  * apply to linker-private copies and will not be visible from libc later on.
  *
  * Note: this function creates a pthread_internal_t for the initial thread and
- * stores the pointer in TLS, but does not add it to pthread's gThreadList. This
+ * stores the pointer in TLS, but does not add it to pthread's thread list. This
  * has to be done later from libc itself (see __libc_init_common).
  *
  * This function also stores a pointer to the kernel argument block in a TLS slot to be
  * picked up by the libc constructor.
  */
 void __libc_init_tls(KernelArgumentBlock& args) {
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
 
   uintptr_t stack_top = (__get_sp() & ~(PAGE_SIZE - 1)) + PAGE_SIZE;
   size_t stack_size = get_stack_size();
@@ -99,7 +99,9 @@ void __libc_init_tls(KernelArgumentBlock& args) {
 
   static void* tls[BIONIC_TLS_SLOTS];
   static pthread_internal_t thread;
-  thread.tid = gettid();
+  // So that the main thread can be joined too.
+  thread.tid = __set_tid_address(&thread.tid);
+  thread.internal_flags |= PTHREAD_INTERNAL_FLAG_CLEARS_TID;
   thread.tls = tls;
   pthread_attr_init(&thread.attr);
   pthread_attr_setstack(&thread.attr, (void*) stack_bottom, stack_size);
@@ -112,19 +114,31 @@ void __libc_init_common(KernelArgumentBlock& args) {
   // Initialize various globals.
   environ = args.envp;
   errno = 0;
-  __libc_auxv = args.auxv;
+  __libc_init_auxv(args.auxv);
   __progname = args.argv[0] ? args.argv[0] : "<unknown>";
   __abort_message_ptr = args.abort_message_ptr;
+  __libc_tls_modules = args.tls_modules;
+
+  // Route clock_gettime and gettimeofday through the vDSO. Requires '__libc_auxv'.
+  __libc_init_vdso();
 
   // AT_RANDOM is a pointer to 16 bytes of randomness on the stack.
   __stack_chk_guard = *reinterpret_cast<uintptr_t*>(getauxval(AT_RANDOM));
 
+  // Pick this CPU's string routines, on ARM (memcpy, memset, strcmp, strcat, strcpy
+  // and strlen) and x86 (memcpy, memset, memchr, memcmp, strcmp and strlen) alike.
+  // Requires '__libc_auxv'.
+  if (__libc_init_cpu_variant != NULL) {
+    __libc_init_cpu_variant();
+  }
+
   // Get the main thread from TLS and add it to the thread list.
   pthread_internal_t* main_thread = __get_thread();
   main_thread->allocated_on_heap = false;
   _pthread_internal_add(main_thread);
 
-  __system_properties_init(); // Requires 'environ'.
+  // The system property area is mapped on first use (see system_properties.c),
+  // not here: most short-lived processes never read a property.
 }
 
 /* This function will be called during normal program termination
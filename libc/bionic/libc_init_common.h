@@ -51,6 +51,10 @@ __END_DECLS
 #if defined(__cplusplus)
 struct KernelArgumentBlock;
 void __LIBC_HIDDEN__ __libc_init_common(KernelArgumentBlock& args);
+void __LIBC_HIDDEN__ __libc_init_vdso();
+// Only arm libcs built for TARGET_CPU_VARIANT=runtime, and x86 libcs built
+// with SSSE3, have this.
+void __LIBC_HIDDEN__ __libc_init_cpu_variant() __attribute__((weak));
 #endif
 
 #endif
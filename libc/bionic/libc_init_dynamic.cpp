@@ -51,14 +51,34 @@
 #include "atexit.h"
 #include "KernelArgumentBlock.h"
 #include "libc_init_common.h"
+#include "libc_logging.h"
+#include "StartupTrace.h"
 #include <bionic_tls.h>
 
 extern "C" {
   extern void pthread_debug_init(void);
-  extern void malloc_debug_init(void);
   extern void malloc_debug_fini(void);
 };
 
+// Set from the kernel argument block when the dynamic linker is tracing startup.
+static StartupTrace* gStartupTrace = NULL;
+
+// Logs how long each phase of startup took, as one line: the time from
+// each mark to the next, and the total.
+static void log_startup_trace(const char* progname, const StartupTrace* trace) {
+  char buf[256];
+  size_t used = 0;
+  for (size_t i = 1; i < trace->count && used < sizeof(buf); ++i) {
+    long long us = (trace->phases[i].ns - trace->phases[i - 1].ns) / 1000;
+    used += __libc_format_buffer(buf + used, sizeof(buf) - used, " %s %lld us,",
+                                 trace->phases[i - 1].name, us);
+  }
+  long long total_us = (trace->phases[trace->count - 1].ns - trace->phases[0].ns) / 1000;
+  __libc_format_log(ANDROID_LOG_INFO, "libc", "%s: startup:%s %lld us to %s",
+                    progname, (used > 0) ? buf : "", total_us,
+                    trace->phases[trace->count - 1].name);
+}
+
 // We flag the __libc_preinit function as a constructor to ensure
 // that its address is listed in libc.so's .init_array section.
 // This ensures that the function is called by the dynamic linker
@@ -73,11 +93,16 @@ __attribute__((constructor)) static void __libc_preinit() {
   // __libc_init_common() will change the TLS area so the old one won't be accessible anyway.
   *args_slot = NULL;
 
+  if (args->startup_trace != NULL) {
+    args->startup_trace->Mark("libc");
+    gStartupTrace = args->startup_trace;
+  }
+
   __libc_init_common(*args);
 
-  // Hooks for the debug malloc and pthread libraries to let them know that we're starting up.
+  // Hook for the pthread debugging code to let it know that we're starting up.
+  // Debug malloc is set up by the first allocation (see malloc_debug_common.cpp).
   pthread_debug_init();
-  malloc_debug_init();
 }
 
 __LIBC_HIDDEN__ void __libc_postfini() {
@@ -109,5 +134,10 @@ __noreturn void __libc_init(void* raw_args,
     __cxa_atexit(__libc_fini,structors->fini_array,NULL);
   }
 
+  if (gStartupTrace != NULL) {
+    gStartupTrace->Mark("main");
+    log_startup_trace(args.argv[0], gStartupTrace);
+  }
+
   exit(slingshot(args.argc, args.argv, args.envp));
 }
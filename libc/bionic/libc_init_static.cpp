@@ -66,17 +66,84 @@ static void call_array(void(**list)()) {
   }
 }
 
+// ld provides this to us in the default link script. It's hidden, so taking its address
+// is pc-relative and works before we've been relocated.
+extern "C" __LIBC_HIDDEN__ Elf32_Ehdr __executable_start;
+
+// Returns the difference between where the executable was linked to run and where the
+// kernel loaded it: zero for an ordinary static executable, but anything for a static PIE.
+// Not every linker gives a static PIE a PT_PHDR, but they all have an entry point.
+static Elf32_Addr get_load_bias(unsigned long entry) {
+  return entry - __executable_start.e_entry;
+}
+
+#if defined(__arm__)
+#define R_RELATIVE R_ARM_RELATIVE
+#elif defined(__i386__)
+#define R_RELATIVE R_386_RELATIVE
+#endif
+
+// A static PIE has nobody to relocate it, so it has to relocate itself before anything
+// reads a pointer from its data. That means nothing here may touch a global (or call
+// anything that does), and the arguments have to come straight from the kernel's block.
+// With everything resolved at link time, only RELATIVE relocations are left. (MIPS uses
+// a GOT rather than relocations for this, and doesn't support static PIE.)
+static void apply_static_pie_relocations(KernelArgumentBlock& args) {
+#if defined(R_RELATIVE)
+  Elf32_Phdr* phdr_start = reinterpret_cast<Elf32_Phdr*>(args.getauxval(AT_PHDR));
+  size_t phdr_ct = args.getauxval(AT_PHNUM);
+  Elf32_Addr load_bias = get_load_bias(args.getauxval(AT_ENTRY));
+  if (load_bias == 0) {
+    return;
+  }
+
+  Elf32_Dyn* dynamic = NULL;
+  for (Elf32_Phdr* phdr = phdr_start; phdr < (phdr_start + phdr_ct); phdr++) {
+    if (phdr->p_type == PT_DYNAMIC) {
+      dynamic = reinterpret_cast<Elf32_Dyn*>(load_bias + phdr->p_vaddr);
+      break;
+    }
+  }
+  if (dynamic == NULL) {
+    return;
+  }
+
+  Elf32_Rel* rel = NULL;
+  size_t rel_count = 0;
+  for (Elf32_Dyn* d = dynamic; d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_REL) {
+      rel = reinterpret_cast<Elf32_Rel*>(load_bias + d->d_un.d_ptr);
+    } else if (d->d_tag == DT_RELSZ) {
+      rel_count = d->d_un.d_val / sizeof(Elf32_Rel);
+    }
+  }
+
+  for (size_t i = 0; i < rel_count; ++i) {
+    if (rel[i].r_info == R_RELATIVE) {
+      *reinterpret_cast<Elf32_Addr*>(load_bias + rel[i].r_offset) += load_bias;
+    } else {
+      // Only a static PIE linked against the wrong crt or libc gets here, and we've no
+      // working libc to report it with.
+      __builtin_trap();
+    }
+  }
+#else
+  (void) args;
+#endif
+}
+
 static void apply_gnu_relro() {
   Elf32_Phdr* phdr_start = reinterpret_cast<Elf32_Phdr*>(getauxval(AT_PHDR));
   unsigned long int phdr_ct = getauxval(AT_PHNUM);
+  Elf32_Addr load_bias = get_load_bias(getauxval(AT_ENTRY));
 
   for (Elf32_Phdr* phdr = phdr_start; phdr < (phdr_start + phdr_ct); phdr++) {
     if (phdr->p_type != PT_GNU_RELRO) {
       continue;
     }
 
-    Elf32_Addr seg_page_start = PAGE_START(phdr->p_vaddr);
-    Elf32_Addr seg_page_end = PAGE_END(phdr->p_vaddr + phdr->p_memsz);
+    Elf32_Addr seg_page_start = PAGE_START(load_bias + phdr->p_vaddr);
+    Elf32_Addr seg_page_end = PAGE_END(load_bias + phdr->p_vaddr + phdr->p_memsz);
 
     // Check return value here? What do we do if we fail?
     mprotect(reinterpret_cast<void*>(seg_page_start), seg_page_end - seg_page_start, PROT_READ);
@@ -88,6 +155,7 @@ __noreturn void __libc_init(void* raw_args,
                             int (*slingshot)(int, char**, char**),
                             structors_array_t const * const structors) {
   KernelArgumentBlock args(raw_args);
+  apply_static_pie_relocations(args);
   __libc_init_tls(args);
   __libc_init_common(args);
 
@@ -29,6 +29,8 @@
 #include <../private/libc_logging.h> // Relative path so we can #include this .cpp file for testing.
 #include <../private/ScopedPthreadMutexLocker.h>
 
+#include <android/format.h>
+
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -38,6 +40,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
@@ -53,10 +56,15 @@ enum AndroidEventLogType {
   EVENT_TYPE_LIST     = 3,
 };
 
+// Counts everything sent, like snprintf(3), but only keeps what fits.
 struct BufferOutputStream {
  public:
   BufferOutputStream(char* buffer, size_t size) : total(0) {
     buffer_ = buffer;
+    if (size == 0) {
+      end_ = pos_ = NULL;
+      return;
+    }
     end_ = buffer + size - 1;
     pos_ = buffer_;
     pos_[0] = '\0';
@@ -69,6 +77,7 @@ struct BufferOutputStream {
     if (len < 0) {
       len = strlen(data);
     }
+    total += len;
 
     while (len > 0) {
       int avail = end_ - pos_;
@@ -82,7 +91,6 @@ struct BufferOutputStream {
       pos_ += avail;
       pos_[0] = '\0';
       len -= avail;
-      total += avail;
     }
   }
 
@@ -207,6 +215,57 @@ static void format_integer(char* buf, size_t buf_size, uint64_t value, char conv
   format_unsigned(buf, buf_size, value, base, caps);
 }
 
+// Writes 'value' with 'prec' digits after the point into 'buf', which must
+// hold kFormatMaxDouble bytes. This is plain double arithmetic rather than the
+// exact conversion printf(3) does, so only about 15 significant digits are
+// right, which is plenty for diagnostics.
+static const int kMaxDoublePrecision = 17;
+static const size_t kFormatMaxDouble = 1 + 309 + 1 + kMaxDoublePrecision + 1;
+
+static void format_double(char* buf, double value, int prec) {
+  if (__builtin_signbit(value)) {
+    *buf++ = '-';
+    value = -value;
+  }
+  if (__builtin_isnan(value) || __builtin_isinf(value)) {
+    strcpy(buf, __builtin_isnan(value) ? "nan" : "inf");
+    return;
+  }
+  if (prec > kMaxDoublePrecision) {
+    prec = kMaxDoublePrecision;
+  }
+
+  int zeros = 0;
+  while (value >= 1e19) {
+    value /= 10;
+    ++zeros;
+  }
+  uint64_t scale = 1;
+  for (int i = 0; i < prec; ++i) {
+    scale *= 10;
+  }
+  uint64_t int_part = static_cast<uint64_t>(value);
+  uint64_t frac_part = static_cast<uint64_t>((value - int_part) * scale + 0.5);
+  if (frac_part >= scale) {
+    frac_part -= scale;
+    ++int_part;
+  }
+
+  format_unsigned(buf, 21, int_part, 10, false);
+  buf += strlen(buf);
+  memset(buf, '0', zeros);
+  buf += zeros;
+  if (prec > 0) {
+    *buf++ = '.';
+    for (int i = prec - 1; i >= 0; --i) {
+      buf[i] = '0' + (frac_part % 10);
+      frac_part /= 10;
+    }
+    buf += prec;
+  }
+  *buf = '\0';
+}
+
 template <typename Out>
 static void SendRepeat(Out& o, char ch, int count) {
   char pad[8];
@@ -237,7 +296,7 @@ static void out_vformat(Out& o, const char* format, va_list args) {
         int prec  = -1;
         size_t bytelen = sizeof(int);
         int slen;
-        char buffer[32];  /* temporary buffer used to format numbers */
+        char buffer[kFormatMaxDouble];  /* temporary buffer used to format numbers */
 
         char  c;
 
@@ -291,11 +350,28 @@ static void out_vformat(Out& o, const char* format, va_list args) {
             nn --;
             width = (int)parse_decimal(format, &nn);
             c = format[nn++];
+        } else if (c == '*') {
+            /* a negative width is a '-' flag and a width */
+            width = va_arg(args, int);
+            if (width < 0) {
+                padLeft = 1;
+                width = -width;
+            }
+            c = format[nn++];
         }
 
         /* parse precision */
         if (c == '.') {
-            prec = (int)parse_decimal(format, &nn);
+            if (format[nn] == '*') {
+                /* a negative precision is no precision at all */
+                prec = va_arg(args, int);
+                if (prec < 0) {
+                    prec = -1;
+                }
+                nn++;
+            } else {
+                prec = (int)parse_decimal(format, &nn);
+            }
             c = format[nn++];
         }
 
@@ -337,6 +413,8 @@ static void out_vformat(Out& o, const char* format, va_list args) {
             if (str == NULL) {
                 str = "(null)";
             }
+        } else if (c == 'f' || c == 'F') {
+            format_double(buffer, va_arg(args, double), (prec == -1) ? 6 : prec);
         } else if (c == 'c') {
             /* character */
             /* NOTE: char is promoted to int when passed through the stack */
@@ -381,10 +459,33 @@ static void out_vformat(Out& o, const char* format, va_list args) {
         /* if we are here, 'str' points to the content that must be
          * outputted. handle padding and alignment now */
 
-        slen = strlen(str);
+        if (prec != -1 && c != 's' && c != 'f' && c != 'F') {
+            __assert(__FILE__, __LINE__, "precision unsupported");
+        }
+        if (sign != '\0' && c != 'd' && c != 'i' && c != 'f' && c != 'F') {
+            __assert(__FILE__, __LINE__, "sign unsupported");
+        }
+
+        if (c == 's' && prec != -1) {
+            /* the string needn't be terminated within the precision */
+            for (slen = 0; slen < prec && str[slen] != '\0'; ++slen) {
+            }
+        } else {
+            slen = strlen(str);
+        }
 
-        if (sign != '\0' || prec != -1) {
-            __assert(__FILE__, __LINE__, "sign/precision unsupported");
+        /* the sign goes before any zeros */
+        char signChar = sign;
+        if (str[0] == '-' && c != 's' && c != 'c') {
+            signChar = '-';
+            str++;
+            slen--;
+        }
+        if (signChar != '\0') {
+            width--;
+            if (padZero && !padLeft) {
+                o.Send(&signChar, 1);
+            }
         }
 
         if (slen < width && !padLeft) {
@@ -392,11 +493,13 @@ static void out_vformat(Out& o, const char* format, va_list args) {
             SendRepeat(o, padChar, width - slen);
         }
 
+        if (signChar != '\0' && !(padZero && !padLeft)) {
+            o.Send(&signChar, 1);
+        }
         o.Send(str, slen);
 
         if (slen < width && padLeft) {
-            char padChar = padZero ? '0' : ' ';
-            SendRepeat(o, padChar, width - slen);
+            SendRepeat(o, ' ', width - slen);
         }
     }
 }
@@ -419,12 +522,112 @@ int __libc_format_fd(int fd, const char* format, ...) {
   return os.total;
 }
 
-static int __libc_write_log(int priority, const char* tag, const char* msg) {
-  int main_log_fd = TEMP_FAILURE_RETRY(open("/dev/log/main", O_CLOEXEC | O_WRONLY));
-  if (main_log_fd == -1) {
+int android_vformat_buffer(char* buffer, size_t size, const char* format, va_list args) {
+  BufferOutputStream os(buffer, size);
+  out_vformat(os, format, args);
+  return os.total;
+}
+
+int android_format_buffer(char* buffer, size_t size, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int result = android_vformat_buffer(buffer, size, format, args);
+  va_end(args);
+  return result;
+}
+
+int android_format_append(char* buffer, size_t size, size_t* length, const char* format, ...) {
+  size_t used = (*length < size) ? *length : size;
+  va_list args;
+  va_start(args, format);
+  int result = android_vformat_buffer(buffer + used, size - used, format, args);
+  va_end(args);
+  *length += result;
+  return result;
+}
+
+int android_vformat_fd(int fd, const char* format, va_list args) {
+  FdOutputStream os(fd);
+  out_vformat(os, format, args);
+  return os.total;
+}
+
+int android_format_fd(int fd, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int result = android_vformat_fd(fd, format, args);
+  va_end(args);
+  return result;
+}
+
+// A log device, opened the first time it's written to and then kept open. The caller may close
+// the descriptor behind our back, as daemons closing everything after a fork do, and the number
+// may then be reused for something else, so it's checked to still be the device before each
+// write. No lock is held, so a fork can't leave one locked, and the child simply inherits the
+// descriptor.
+struct LogDevice {
+  const char* path;
+  volatile int fd;
+  volatile dev_t rdev;
+};
+
+static LogDevice gMainLog = { "/dev/log/main", -1, 0 };
+static LogDevice gEventsLog = { "/dev/log/events", -1, 0 };
+
+// Returns a descriptor for 'device', and sets 'owned' if it's one just for this write that the
+// caller must close.
+static int __libc_log_device_fd(LogDevice* device, bool* owned) {
+  *owned = false;
+  int fd = device->fd;
+  if (fd != -1) {
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && S_ISCHR(sb.st_mode) && sb.st_rdev == device->rdev) {
+      return fd;
+    }
+    // Whatever 'fd' is now, it isn't ours to close.
+    __sync_bool_compare_and_swap(&device->fd, fd, -1);
+  }
+
+  fd = TEMP_FAILURE_RETRY(open(device->path, O_CLOEXEC | O_WRONLY));
+  if (fd == -1) {
+    return -1;
+  }
+  struct stat sb;
+  if (fstat(fd, &sb) == -1) {
+    close(fd);
     return -1;
   }
+  // Every descriptor for the device has the same rdev, so it doesn't matter which thread sets this.
+  device->rdev = sb.st_rdev;
+  __sync_synchronize();
+  if (!__sync_bool_compare_and_swap(&device->fd, -1, fd)) {
+    // Another thread got there first, so this one is just for this write.
+    *owned = true;
+  }
+  return fd;
+}
 
+static int __libc_write_log_device(LogDevice* device, iovec* vec, int count) {
+  // A second go, in case the descriptor was closed between being checked and being written to.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    bool owned;
+    int fd = __libc_log_device_fd(device, &owned);
+    if (fd == -1) {
+      return -1;
+    }
+    int result = TEMP_FAILURE_RETRY(writev(fd, vec, count));
+    if (owned) {
+      close(fd);
+    } else if (result == -1 && errno == EBADF) {
+      __sync_bool_compare_and_swap(&device->fd, fd, -1);
+      continue;
+    }
+    return result;
+  }
+  return -1;
+}
+
+static int __libc_write_log(int priority, const char* tag, const char* msg) {
   iovec vec[3];
   vec[0].iov_base = &priority;
   vec[0].iov_len = 1;
@@ -433,9 +636,7 @@ static int __libc_write_log(int priority, const char* tag, const char* msg) {
   vec[2].iov_base = const_cast<char*>(msg);
   vec[2].iov_len = strlen(msg) + 1;
 
-  int result = TEMP_FAILURE_RETRY(writev(main_log_fd, vec, 3));
-  close(main_log_fd);
-  return result;
+  return __libc_write_log_device(&gMainLog, vec, 3);
 }
 
 int __libc_format_log_va_list(int priority, const char* tag, const char* format, va_list args) {
@@ -462,13 +663,7 @@ static int __libc_android_log_event(int32_t tag, char type, const void* payload,
   vec[2].iov_base = const_cast<void*>(payload);
   vec[2].iov_len = len;
 
-  int event_log_fd = TEMP_FAILURE_RETRY(open("/dev/log/events", O_CLOEXEC | O_WRONLY));
-  if (event_log_fd == -1) {
-    return -1;
-  }
-  int result = TEMP_FAILURE_RETRY(writev(event_log_fd, vec, 3));
-  close(event_log_fd);
-  return result;
+  return __libc_write_log_device(&gEventsLog, vec, 3);
 }
 
 void __libc_android_log_event_int(int32_t tag, int value) {
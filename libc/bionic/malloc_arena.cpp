@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "malloc_arena.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "pthread_internal.h"
+
+#define MALLOC_ARENAS_MAX 16
+
+static mspace gMallocArenas[MALLOC_ARENAS_MAX];
+static size_t gMallocArenaCount; // 0 means everything uses the global heap.
+static bool gMallocArenasByThread;
+
+void __malloc_arenas_init(size_t count, bool by_thread) {
+  if (count > MALLOC_ARENAS_MAX) {
+    count = MALLOC_ARENAS_MAX;
+  }
+  size_t created = 0;
+  while (created < count) {
+    gMallocArenas[created] = create_mspace(0, 1);
+    if (gMallocArenas[created] == NULL) {
+      break;
+    }
+    ++created;
+  }
+  gMallocArenasByThread = by_thread;
+  gMallocArenaCount = (created > 1) ? created : 0;
+}
+
+// Returns the arena the caller should allocate from, or NULL for the global heap.
+static inline mspace malloc_arena_choose() {
+  size_t count = gMallocArenaCount;
+  if (__predict_true(count == 0)) {
+    return NULL;
+  }
+  size_t key;
+  if (gMallocArenasByThread) {
+    key = reinterpret_cast<uintptr_t>(__get_thread()) >> 4;
+  } else {
+    key = sched_getcpu();
+  }
+  return gMallocArenas[key % count];
+}
+
+void* __malloc_arena_malloc(size_t bytes) {
+  mspace arena = malloc_arena_choose();
+  return (arena == NULL) ? dlmalloc(bytes) : mspace_malloc(arena, bytes);
+}
+
+// calloc requests at least this big are cleared by dropping their whole
+// pages rather than by writing zeroes over them.
+#define MALLOC_CALLOC_MADVISE_THRESHOLD (256U * 1024U)
+
+void* __malloc_arena_calloc(size_t n_elements, size_t elem_size) {
+  size_t bytes = n_elements * elem_size;
+  if (bytes < MALLOC_CALLOC_MADVISE_THRESHOLD ||
+      (n_elements != 0 && bytes / n_elements != elem_size)) {
+    // dlcalloc already skips clearing chunks that are fresh mappings.
+    mspace arena = malloc_arena_choose();
+    return (arena == NULL) ? dlcalloc(n_elements, elem_size) : mspace_calloc(arena, n_elements, elem_size);
+  }
+
+  // A chunk this big from the middle of the heap may have been used before,
+  // but its pages mostly haven't been touched since. Writing zeroes would
+  // fault every page in, so instead give the whole pages back to the kernel,
+  // which will supply zero pages if and when they're touched.
+  char* mem = reinterpret_cast<char*>(__malloc_arena_malloc(bytes));
+  if (mem == NULL || __bionic_dlmalloc_is_mmapped(mem)) {
+    return mem; // A fresh mapping: already zero, and untouched.
+  }
+  char* first_page = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(mem) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+  char* last_page = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(mem + bytes) & ~(PAGE_SIZE - 1));
+  if (madvise(first_page, last_page - first_page, MADV_DONTNEED) == -1) {
+    memset(first_page, 0, last_page - first_page); // Locked pages, say.
+  }
+  memset(mem, 0, first_page - mem);
+  memset(last_page, 0, (mem + bytes) - last_page);
+  return mem;
+}
+
+void* __malloc_arena_realloc(void* mem, size_t bytes) {
+  // dlrealloc keeps an existing chunk in the arena it came from.
+  if (mem == NULL) {
+    return __malloc_arena_malloc(bytes);
+  }
+  return dlrealloc(mem, bytes);
+}
+
+void* __malloc_arena_memalign(size_t alignment, size_t bytes) {
+  mspace arena = malloc_arena_choose();
+  return (arena == NULL) ? dlmemalign(alignment, bytes) : mspace_memalign(arena, alignment, bytes);
+}
+
+void** __malloc_arena_independent_comalloc(size_t n_elements, size_t sizes[], void* chunks[]) {
+  mspace arena = malloc_arena_choose();
+  return (arena == NULL) ? dlindependent_comalloc(n_elements, sizes, chunks)
+                         : mspace_independent_comalloc(arena, n_elements, sizes, chunks);
+}
+
+void __malloc_arena_bulk_free(void* chunks[], size_t n_elements) {
+  // dlbulk_free frees the global heap's chunks and clears their entries,
+  // leaving any from the arenas behind.
+  if (dlbulk_free(chunks, n_elements) != 0) {
+    for (size_t i = 0; i < n_elements; ++i) {
+      if (chunks[i] != NULL) {
+        dlfree(chunks[i]);
+      }
+    }
+  }
+}
+
+// A dlmalloc_inspect_all handler that releases the whole pages of free
+// chunks. dlmalloc's bookkeeping for a free chunk is outside [start, end),
+// so the pages in between hold nothing it needs.
+static void malloc_arena_purge_chunk(void* start, void* end, size_t used_bytes, void* arg) {
+  if (used_bytes != 0) {
+    return;
+  }
+  uintptr_t first_page = (reinterpret_cast<uintptr_t>(start) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  uintptr_t last_page = reinterpret_cast<uintptr_t>(end) & ~(PAGE_SIZE - 1);
+  if (first_page < last_page) {
+    madvise(reinterpret_cast<void*>(first_page), last_page - first_page, MADV_DONTNEED);
+    *reinterpret_cast<size_t*>(arg) += last_page - first_page;
+  }
+}
+
+bool __malloc_arenas_trim(size_t pad) {
+  bool released = dlmalloc_trim(pad);
+  size_t purged = 0;
+  dlmalloc_inspect_all(malloc_arena_purge_chunk, &purged);
+  for (size_t i = 0; i < gMallocArenaCount; ++i) {
+    released |= mspace_trim(gMallocArenas[i], pad);
+    mspace_inspect_all(gMallocArenas[i], malloc_arena_purge_chunk, &purged);
+  }
+  return released || purged != 0;
+}
+
+static void mallinfo_add(struct mallinfo* total, const struct mallinfo& mi) {
+  total->arena += mi.arena;
+  total->ordblks += mi.ordblks;
+  total->smblks += mi.smblks;
+  total->hblks += mi.hblks;
+  total->hblkhd += mi.hblkhd;
+  total->usmblks += mi.usmblks;
+  total->fsmblks += mi.fsmblks;
+  total->uordblks += mi.uordblks;
+  total->fordblks += mi.fordblks;
+  total->keepcost += mi.keepcost;
+}
+
+struct mallinfo __malloc_arenas_mallinfo() {
+  struct mallinfo total = dlmallinfo();
+  for (size_t i = 0; i < gMallocArenaCount; ++i) {
+    mallinfo_add(&total, mspace_mallinfo(gMallocArenas[i]));
+  }
+  return total;
+}
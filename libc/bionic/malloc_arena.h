@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef LIBC_BIONIC_MALLOC_ARENA_H_
+#define LIBC_BIONIC_MALLOC_ARENA_H_
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+#include "dlmalloc.h"
+
+__BEGIN_DECLS
+
+/*
+ * Arena mode. By default everything is allocated from dlmalloc's single
+ * global heap. After __malloc_arenas_init(n), allocations instead come from
+ * one of n dlmalloc mspaces, each with its own lock, chosen by the CPU the
+ * caller is running on (or, if 'by_thread', a hash of the calling thread).
+ * dlmalloc is built with FOOTERS, so every chunk records its owning mspace
+ * and dlfree, dlrealloc and dlbulk_free route it back there whichever
+ * thread calls them.
+ */
+__LIBC_HIDDEN__ void __malloc_arenas_init(size_t count, bool by_thread);
+
+__LIBC_HIDDEN__ void* __malloc_arena_malloc(size_t bytes);
+__LIBC_HIDDEN__ void* __malloc_arena_calloc(size_t n_elements, size_t elem_size);
+__LIBC_HIDDEN__ void* __malloc_arena_realloc(void* mem, size_t bytes);
+__LIBC_HIDDEN__ void* __malloc_arena_memalign(size_t alignment, size_t bytes);
+__LIBC_HIDDEN__ void** __malloc_arena_independent_comalloc(size_t n_elements, size_t sizes[],
+                                                           void* chunks[]);
+
+/* Frees every chunk in 'chunks', whichever arena it came from. */
+__LIBC_HIDDEN__ void __malloc_arena_bulk_free(void* chunks[], size_t n_elements);
+
+/*
+ * Returns free memory to the system: trims the top of the global heap and
+ * of every arena down to 'pad' bytes, then releases the whole pages inside
+ * every other free chunk. Returns true if anything was released.
+ */
+__LIBC_HIDDEN__ bool __malloc_arenas_trim(size_t pad);
+
+/* mallinfo(3) for the global heap and all the arenas together. */
+__LIBC_HIDDEN__ struct mallinfo __malloc_arenas_mallinfo(void);
+
+__END_DECLS
+
+#endif  // LIBC_BIONIC_MALLOC_ARENA_H_
@@ -505,6 +505,230 @@ extern "C" size_t chk_malloc_usable_size(const void* ptr) {
     return hdr->size;
 }
 
+// =============================================================================
+// Lean checking (libc.debug.malloc = 11)
+// =============================================================================
+
+// A cheaper version of the checks above, cheap enough for soak tests. Each
+// allocation carries only a small header and a short rear guard, with no
+// backtraces and no global list, and each thread keeps its own backlog of
+// freed blocks so no lock is shared between threads. Header tags and rear
+// guards are checked on every free. The (much more expensive) check for
+// use after free is done for one in every LEAN_CHECK_INTERVAL blocks
+// leaving a backlog.
+
+#define LEAN_TAG            0x1ea4a110
+#define LEAN_FREED_TAG      0x1ea4f4ee
+#define LEAN_REAR_GUARD_LEN 8
+#define LEAN_CHECK_INTERVAL 8
+
+struct lean_hdr_t {
+    void* base;  // As hdr_t::base.
+    size_t size;
+    uint32_t tag; // LEAN_TAG or LEAN_FREED_TAG, xor'ed with the header's address.
+} __attribute__((aligned(MALLOC_ALIGNMENT)));
+
+struct lean_backlog_t {
+    size_t next;
+    size_t evictions;
+    lean_hdr_t* entries[0]; // gMallocDebugBacklog of them.
+};
+
+static pthread_once_t lean_backlog_once = PTHREAD_ONCE_INIT;
+static pthread_key_t lean_backlog_key;
+
+static inline void* lean_user(lean_hdr_t* hdr) {
+    return hdr + 1;
+}
+
+static inline lean_hdr_t* lean_meta(void* user) {
+    return reinterpret_cast<lean_hdr_t*>(user) - 1;
+}
+
+static inline uint32_t lean_tag(lean_hdr_t* hdr, uint32_t tag) {
+    return tag ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(hdr));
+}
+
+static inline char* lean_rear_guard(lean_hdr_t* hdr) {
+    return reinterpret_cast<char*>(lean_user(hdr)) + hdr->size;
+}
+
+static void* lean_init(void* base, lean_hdr_t* hdr, size_t size) {
+    hdr->base = base;
+    hdr->size = size;
+    hdr->tag = lean_tag(hdr, LEAN_TAG);
+    memset(lean_rear_guard(hdr), REAR_GUARD, LEAN_REAR_GUARD_LEN);
+    return lean_user(hdr);
+}
+
+static bool lean_is_rear_guard_valid(lean_hdr_t* hdr) {
+    const char* guard = lean_rear_guard(hdr);
+    for (size_t i = 0; i < LEAN_REAR_GUARD_LEN; i++) {
+        if (guard[i] != REAR_GUARD) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void lean_report(const char* message, lean_hdr_t* hdr) {
+    uintptr_t bt[MAX_BACKTRACE_DEPTH];
+    int depth = get_backtrace(bt, MAX_BACKTRACE_DEPTH);
+    log_message("+++ ALLOCATION %p %s\n", lean_user(hdr), message);
+    log_backtrace(bt, depth);
+}
+
+static void lean_evict(lean_backlog_t* backlog, lean_hdr_t* hdr) {
+    if (++backlog->evictions % LEAN_CHECK_INTERVAL == 0) {
+        const char* data = reinterpret_cast<const char*>(lean_user(hdr));
+        for (size_t i = 0; i < hdr->size; i++) {
+            if (data[i] != static_cast<char>(FREE_POISON)) {
+                lean_report("WAS USED AFTER BEING FREED", hdr);
+                break;
+            }
+        }
+    }
+    dlfree(hdr->base);
+}
+
+static void lean_backlog_drain(void* arg) {
+    lean_backlog_t* backlog = reinterpret_cast<lean_backlog_t*>(arg);
+    for (size_t i = 0; i < gMallocDebugBacklog; i++) {
+        if (backlog->entries[i] != NULL) {
+            lean_evict(backlog, backlog->entries[i]);
+        }
+    }
+    dlfree(backlog);
+}
+
+static void lean_backlog_key_create() {
+    pthread_key_create(&lean_backlog_key, lean_backlog_drain);
+}
+
+static lean_backlog_t* lean_backlog_get() {
+    if (gMallocDebugBacklog == 0) {
+        return NULL;
+    }
+    pthread_once(&lean_backlog_once, lean_backlog_key_create);
+    lean_backlog_t* backlog = reinterpret_cast<lean_backlog_t*>(pthread_getspecific(lean_backlog_key));
+    if (backlog == NULL) {
+        backlog = static_cast<lean_backlog_t*>(dlcalloc(1, sizeof(lean_backlog_t) +
+                                                        gMallocDebugBacklog * sizeof(lean_hdr_t*)));
+        if (backlog != NULL) {
+            pthread_setspecific(lean_backlog_key, backlog);
+        }
+    }
+    return backlog;
+}
+
+extern "C" void* lean_malloc(size_t size) {
+    size_t total = sizeof(lean_hdr_t) + size + LEAN_REAR_GUARD_LEN;
+    if (total < size) { // Overflow.
+        return NULL;
+    }
+    lean_hdr_t* hdr = static_cast<lean_hdr_t*>(dlmalloc(total));
+    return (hdr != NULL) ? lean_init(hdr, hdr, size) : NULL;
+}
+
+extern "C" void* lean_memalign(size_t alignment, size_t bytes) {
+    if (alignment <= MALLOC_ALIGNMENT) {
+        return lean_malloc(bytes);
+    }
+
+    // Make the alignment a power of two.
+    if (alignment & (alignment-1)) {
+        alignment = 1L << (31 - __builtin_clz(alignment));
+    }
+
+    size_t size = sizeof(lean_hdr_t) + (alignment-MALLOC_ALIGNMENT) + bytes + LEAN_REAR_GUARD_LEN;
+    if (size < bytes) { // Overflow.
+        return NULL;
+    }
+
+    void* base = dlmalloc(size);
+    if (base == NULL) {
+        return NULL;
+    }
+    uintptr_t ptr = reinterpret_cast<uintptr_t>(reinterpret_cast<lean_hdr_t*>(base) + 1);
+    ptr += ((-ptr) % alignment);
+    return lean_init(base, lean_meta(reinterpret_cast<void*>(ptr)), bytes);
+}
+
+extern "C" void lean_free(void* ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    lean_hdr_t* hdr = lean_meta(ptr);
+    if (hdr->tag == lean_tag(hdr, LEAN_FREED_TAG)) {
+        lean_report("MULTIPLY FREED!", hdr);
+        return;
+    }
+    if (hdr->tag != lean_tag(hdr, LEAN_TAG)) {
+        lean_report("IS CORRUPTED OR NOT ALLOCATED VIA TRACKER!", hdr);
+        return;
+    }
+    if (!lean_is_rear_guard_valid(hdr)) {
+        lean_report("HAS A CORRUPTED REAR GUARD", hdr);
+    }
+
+    hdr->tag = lean_tag(hdr, LEAN_FREED_TAG);
+    memset(ptr, FREE_POISON, hdr->size);
+
+    lean_backlog_t* backlog = lean_backlog_get();
+    if (backlog == NULL) {
+        dlfree(hdr->base);
+        return;
+    }
+    lean_hdr_t* oldest = backlog->entries[backlog->next];
+    backlog->entries[backlog->next] = hdr;
+    backlog->next = (backlog->next + 1) % gMallocDebugBacklog;
+    if (oldest != NULL) {
+        lean_evict(backlog, oldest);
+    }
+}
+
+extern "C" void* lean_realloc(void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return lean_malloc(size);
+    }
+
+    lean_hdr_t* hdr = lean_meta(ptr);
+    if (hdr->tag != lean_tag(hdr, LEAN_TAG)) {
+        lean_report((hdr->tag == lean_tag(hdr, LEAN_FREED_TAG)) ? "WAS REALLOCATED AFTER BEING FREED"
+                                                                : "IS CORRUPTED OR NOT ALLOCATED VIA TRACKER!",
+                    hdr);
+        // Just get a whole new allocation and leak the old one.
+        return lean_malloc(size);
+    }
+
+    void* new_ptr = lean_malloc(size);
+    if (new_ptr != NULL) {
+        memcpy(new_ptr, ptr, (size < hdr->size) ? size : hdr->size);
+        lean_free(ptr);
+    }
+    return new_ptr;
+}
+
+extern "C" void* lean_calloc(size_t nmemb, size_t size) {
+    if (nmemb && MAX_SIZE_T / nmemb < size) {
+        return NULL;
+    }
+    void* ptr = lean_malloc(nmemb * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, nmemb * size);
+    }
+    return ptr;
+}
+
+extern "C" size_t lean_malloc_usable_size(const void* ptr) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    // The rear guard is just after the requested bytes, so there's no more.
+    return lean_meta(const_cast<void*>(ptr))->size;
+}
+
 static void ReportMemoryLeaks() {
   // We only track leaks at level 10.
   if (gMallocDebugLevel != 10) {
@@ -42,11 +42,17 @@
 
 #include "malloc_debug_common.h"
 
+#include <malloc.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include "bionic_hugepage.h"
 #include "dlmalloc.h"
+#include "malloc_arena.h"
+#include "malloc_slab.h"
+#include "malloc_thread_cache.h"
 #include "ScopedPthreadMutexLocker.h"
 
 /*
@@ -54,53 +60,123 @@
  */
 int gMallocLeakZygoteChild = 0;
 
-pthread_mutex_t gAllocationsMutex = PTHREAD_MUTEX_INITIALIZER;
 HashTable gHashTable;
 
 // =============================================================================
 // output functions
 // =============================================================================
 
-static int hash_entry_compare(const void* arg1, const void* arg2) {
-    int result;
+// Entries are copied out a few at a time under their chain's lock, so that
+// neither the callback nor anything else ever runs with a lock held, and an
+// allocation only ever waits for one batch.
+#define LEAK_BATCH_SIZE 8
 
-    const HashEntry* e1 = *static_cast<HashEntry* const*>(arg1);
-    const HashEntry* e2 = *static_cast<HashEntry* const*>(arg2);
+struct LeakBatchEntry {
+    size_t size;
+    size_t allocations;
+    size_t numEntries;
+    uintptr_t backtrace[BACKTRACE_SIZE];
+};
 
-    // if one or both arg pointers are null, deal gracefully
-    if (e1 == NULL) {
-        result = (e2 == NULL) ? 0 : 1;
-    } else if (e2 == NULL) {
-        result = -1;
-    } else {
-        size_t nbAlloc1 = e1->allocations;
-        size_t nbAlloc2 = e2->allocations;
-        size_t size1 = e1->size & ~SIZE_FLAG_MASK;
-        size_t size2 = e2->size & ~SIZE_FLAG_MASK;
-        size_t alloc1 = nbAlloc1 * size1;
-        size_t alloc2 = nbAlloc2 * size2;
-
-        // sort in descending order by:
-        // 1) total size
-        // 2) number of allocations
-        //
-        // This is used for sorting, not determination of equality, so we don't
-        // need to compare the bit flags.
-        if (alloc1 > alloc2) {
-            result = -1;
-        } else if (alloc1 < alloc2) {
-            result = 1;
-        } else {
-            if (nbAlloc1 > nbAlloc2) {
-                result = -1;
-            } else if (nbAlloc1 < nbAlloc2) {
-                result = 1;
-            } else {
-                result = 0;
+extern "C" int malloc_iterate_leaks(malloc_leak_callback_t callback, void* arg) {
+    LeakBatchEntry batch[LEAK_BATCH_SIZE];
+
+    for (size_t slot = 0; slot < HASHTABLE_SIZE; ++slot) {
+        // Entries are only ever added at the head of a chain, so if the
+        // chain changes between batches, entries are seen twice or missed;
+        // the generation tells the caller.
+        size_t skip = 0;
+        bool more = true;
+        while (more) {
+            size_t count = 0;
+            {
+                ScopedPthreadMutexLocker locker(hash_table_lock(&gHashTable, slot));
+                HashEntry* entry = gHashTable.slots[slot];
+                for (size_t i = 0; entry != NULL && i < skip; ++i) {
+                    entry = entry->next;
+                }
+                for (; entry != NULL && count < LEAK_BATCH_SIZE; entry = entry->next) {
+                    LeakBatchEntry* copy = &batch[count++];
+                    copy->size = entry->size;
+                    copy->allocations = entry->allocations;
+                    copy->numEntries = entry->numEntries;
+                    if (copy->numEntries > BACKTRACE_SIZE) {
+                        copy->numEntries = BACKTRACE_SIZE;
+                    }
+                    memcpy(copy->backtrace, entry->backtrace, copy->numEntries * sizeof(uintptr_t));
+                }
+                more = (entry != NULL);
+            }
+            skip += count;
+
+            for (size_t i = 0; i < count; ++i) {
+                malloc_leak_record record;
+                record.size = batch[i].size;
+                record.allocations = batch[i].allocations;
+                record.frame_count = batch[i].numEntries;
+                record.frames = batch[i].backtrace;
+                int result = callback(&record, arg);
+                if (result != 0) {
+                    return result;
+                }
             }
         }
     }
-    return result;
+    return 0;
+}
+
+extern "C" unsigned malloc_leak_generation() {
+    return __sync_fetch_and_add(&gHashTable.generation, 0);
+}
+
+static int leak_info_compare(const void* arg1, const void* arg2) {
+    const size_t* e1 = static_cast<const size_t*>(arg1);
+    const size_t* e2 = static_cast<const size_t*>(arg2);
+    size_t nbAlloc1 = e1[1];
+    size_t nbAlloc2 = e2[1];
+    size_t alloc1 = nbAlloc1 * (e1[0] & ~SIZE_FLAG_MASK);
+    size_t alloc2 = nbAlloc2 * (e2[0] & ~SIZE_FLAG_MASK);
+
+    // sort in descending order by:
+    // 1) total size
+    // 2) number of allocations
+    //
+    // This is used for sorting, not determination of equality, so we don't
+    // need to compare the bit flags.
+    if (alloc1 != alloc2) {
+        return (alloc1 > alloc2) ? -1 : 1;
+    }
+    if (nbAlloc1 != nbAlloc2) {
+        return (nbAlloc1 > nbAlloc2) ? -1 : 1;
+    }
+    return 0;
+}
+
+struct LeakInfoBuffer {
+    uint8_t* head;
+    uint8_t* end;
+    size_t infoSize;
+    size_t totalMemory;
+};
+
+static int copy_leak_info(const malloc_leak_record* record, void* arg) {
+    LeakInfoBuffer* buffer = static_cast<LeakInfoBuffer*>(arg);
+    if (buffer->head == buffer->end) {
+        // More entries than when the buffer was sized: leave out the rest.
+        return 1;
+    }
+
+    size_t* sizes = reinterpret_cast<size_t*>(buffer->head);
+    sizes[0] = record->size;
+    sizes[1] = record->allocations;
+    uintptr_t* backtrace = reinterpret_cast<uintptr_t*>(sizes + 2);
+    memcpy(backtrace, record->frames, record->frame_count * sizeof(uintptr_t));
+    memset(backtrace + record->frame_count, 0,
+           (BACKTRACE_SIZE - record->frame_count) * sizeof(uintptr_t));
+
+    buffer->totalMemory += (record->size & ~SIZE_FLAG_MASK) * record->allocations;
+    buffer->head += buffer->infoSize;
+    return 0;
 }
 
 /*
@@ -112,6 +188,10 @@ static int hash_entry_compare(const void* arg1, const void* arg2) {
  * "*totalMemory" is set to the sum of all allocations we're tracking; does
  *   not include heap overhead
  * "*backtraceSize" is set to the maximum number of entries in the back trace
+ *
+ * The entries are copied out with malloc_iterate_leaks, one chain at a time,
+ * and sorted once no lock is held, so other threads can go on allocating
+ * throughout.
  */
 extern "C" void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
         size_t* infoSize, size_t* totalMemory, size_t* backtraceSize) {
@@ -120,66 +200,45 @@ extern "C" void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
             totalMemory == NULL || backtraceSize == NULL) {
         return;
     }
+    *info = NULL;
+    *overallSize = 0;
+    *infoSize = 0;
     *totalMemory = 0;
+    *backtraceSize = 0;
 
-    ScopedPthreadMutexLocker locker(&gAllocationsMutex);
-
-    if (gHashTable.count == 0) {
-        *info = NULL;
-        *overallSize = 0;
-        *infoSize = 0;
-        *backtraceSize = 0;
+    size_t count = __sync_fetch_and_add(&gHashTable.count, 0);
+    if (count == 0) {
         return;
     }
-
-    HashEntry** list = static_cast<HashEntry**>(dlmalloc(sizeof(void*) * gHashTable.count));
-
-    // get the entries into an array to be sorted
-    int index = 0;
-    for (size_t i = 0 ; i < HASHTABLE_SIZE ; ++i) {
-        HashEntry* entry = gHashTable.slots[i];
-        while (entry != NULL) {
-            list[index] = entry;
-            *totalMemory = *totalMemory +
-                ((entry->size & ~SIZE_FLAG_MASK) * entry->allocations);
-            index++;
-            entry = entry->next;
-        }
-    }
+    // Leave room for entries added during the walk.
+    count += count / 8 + 16;
 
     // XXX: the protocol doesn't allow variable size for the stack trace (yet)
-    *infoSize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * BACKTRACE_SIZE);
-    *overallSize = *infoSize * gHashTable.count;
-    *backtraceSize = BACKTRACE_SIZE;
-
-    // now get a byte array big enough for this
-    *info = static_cast<uint8_t*>(dlmalloc(*overallSize));
-
-    if (*info == NULL) {
-        *overallSize = 0;
-        dlfree(list);
+    size_t entrySize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * BACKTRACE_SIZE);
+    uint8_t* buffer = static_cast<uint8_t*>(dlmalloc(entrySize * count));
+    if (buffer == NULL) {
         return;
     }
 
-    qsort(list, gHashTable.count, sizeof(void*), hash_entry_compare);
+    LeakInfoBuffer out;
+    out.head = buffer;
+    out.end = buffer + entrySize * count;
+    out.infoSize = entrySize;
+    out.totalMemory = 0;
+    malloc_iterate_leaks(copy_leak_info, &out);
 
-    uint8_t* head = *info;
-    const int count = gHashTable.count;
-    for (int i = 0 ; i < count ; ++i) {
-        HashEntry* entry = list[i];
-        size_t entrySize = (sizeof(size_t) * 2) + (sizeof(uintptr_t) * entry->numEntries);
-        if (entrySize < *infoSize) {
-            /* we're writing less than a full entry, clear out the rest */
-            memset(head + entrySize, 0, *infoSize - entrySize);
-        } else {
-            /* make sure the amount we're copying doesn't exceed the limit */
-            entrySize = *infoSize;
-        }
-        memcpy(head, &(entry->size), entrySize);
-        head += *infoSize;
+    size_t used = out.head - buffer;
+    if (used == 0) {
+        dlfree(buffer);
+        return;
     }
+    qsort(buffer, used / entrySize, entrySize, leak_info_compare);
 
-    dlfree(list);
+    *info = buffer;
+    *overallSize = used;
+    *infoSize = entrySize;
+    *totalMemory = out.totalMemory;
+    *backtraceSize = BACKTRACE_SIZE;
 }
 
 extern "C" void free_malloc_leak_info(uint8_t* info) {
@@ -187,7 +246,49 @@ extern "C" void free_malloc_leak_info(uint8_t* info) {
 }
 
 extern "C" struct mallinfo mallinfo() {
-    return dlmallinfo();
+    struct mallinfo mi = __malloc_arenas_mallinfo();
+    __malloc_slab_mallinfo(&mi);
+    return mi;
+}
+
+extern "C" void malloc_dump_stats(int fd) {
+    struct mallinfo heap = __malloc_arenas_mallinfo();
+    __libc_format_fd(fd, "heap: %zu bytes, %zu in use, %zu free in %zu chunks\n",
+                     heap.arena, heap.uordblks, heap.fordblks, heap.ordblks);
+    __libc_format_fd(fd, "mmapped: %zu bytes\n", heap.hblkhd);
+
+    malloc_cache_stats_t counts;
+    __malloc_cache_stats(&counts);
+    __libc_format_fd(fd, "frees: %zu\n", counts.frees);
+    __libc_format_fd(fd, "size  runs  partial  in use      allocs  contended\n");
+    for (size_t i = 0; i < MALLOC_SLAB_CLASSES; ++i) {
+        malloc_slab_stats_t slab;
+        __malloc_slab_stats(i, &slab);
+        __libc_format_fd(fd, "%4zu %5zu %8zu %7zu %11zu %10zu\n", __malloc_slab_class_size(i),
+                         slab.runs, slab.partial_runs, slab.allocated,
+                         counts.small_allocs[i], slab.contended);
+    }
+    __libc_format_fd(fd, "        size      allocs\n");
+    for (size_t i = 0; i + 1 < MALLOC_STATS_LARGE_BUCKETS; ++i) {
+        __libc_format_fd(fd, "<=%10zu %11zu\n", MALLOC_SLAB_MAX_SIZE << (i + 1),
+                         counts.large_allocs[i]);
+    }
+    __libc_format_fd(fd, "> %10zu %11zu\n", MALLOC_SLAB_MAX_SIZE << (MALLOC_STATS_LARGE_BUCKETS - 1),
+                     counts.large_allocs[MALLOC_STATS_LARGE_BUCKETS - 1]);
+}
+
+/* dlmalloc's parameters are shared by the global heap and every arena. */
+extern "C" int mallopt(int param, int value) {
+    if (param == M_HUGEPAGES) {
+        return __bionic_malloc_set_hugepages(value);
+    }
+    return dlmallopt(param, value);
+}
+
+extern "C" int malloc_trim(size_t pad) {
+    bool released = __malloc_slab_trim();
+    released |= __malloc_arenas_trim(pad);
+    return released ? 1 : 0;
 }
 
 extern "C" void* valloc(size_t bytes) {
@@ -209,37 +310,110 @@ extern "C" int posix_memalign(void** memptr, size_t alignment, size_t size) {
  */
 #ifdef USE_DL_PREFIX
 
-/* Table for dispatching malloc calls, initialized with default dispatchers. */
+/* Table for dispatching malloc calls, initialized with default dispatchers.
+ * Small allocations come from the slab allocator through a per-thread cache,
+ * and everything else goes to dlmalloc, or to the arena for the current CPU
+ * in arena mode. */
 extern const MallocDebug __libc_malloc_default_dispatch;
 const MallocDebug __libc_malloc_default_dispatch __attribute__((aligned(32))) =
 {
-    dlmalloc, dlfree, dlcalloc, dlrealloc, dlmemalign, dlmalloc_usable_size,
+    __malloc_cache_malloc, __malloc_cache_free, __malloc_cache_calloc,
+    __malloc_cache_realloc, __malloc_arena_memalign, __malloc_cache_usable_size,
+};
+
+#ifndef LIBC_STATIC
+/* libc.so doesn't choose between the default and debug tables at startup,
+ * since that means reading properties. The dispatch pointer starts out at
+ * this table instead, whose routines make the choice on first use and then
+ * call through whichever table was chosen. */
+static const MallocDebug* malloc_lazy_dispatch();
+
+static void* lazy_malloc(size_t bytes) {
+    return malloc_lazy_dispatch()->malloc(bytes);
+}
+static void lazy_free(void* mem) {
+    malloc_lazy_dispatch()->free(mem);
+}
+static void* lazy_calloc(size_t n_elements, size_t elem_size) {
+    return malloc_lazy_dispatch()->calloc(n_elements, elem_size);
+}
+static void* lazy_realloc(void* oldMem, size_t bytes) {
+    return malloc_lazy_dispatch()->realloc(oldMem, bytes);
+}
+static void* lazy_memalign(size_t alignment, size_t bytes) {
+    return malloc_lazy_dispatch()->memalign(alignment, bytes);
+}
+static size_t lazy_malloc_usable_size(const void* mem) {
+    return malloc_lazy_dispatch()->malloc_usable_size(mem);
+}
+
+static const MallocDebug gMallocLazyDispatch __attribute__((aligned(32))) = {
+    lazy_malloc, lazy_free, lazy_calloc, lazy_realloc, lazy_memalign, lazy_malloc_usable_size,
 };
 
+/* Selector of dispatch table to use for dispatching malloc calls. */
+const MallocDebug* __libc_malloc_dispatch = &gMallocLazyDispatch;
+#else
 /* Selector of dispatch table to use for dispatching malloc calls. */
 const MallocDebug* __libc_malloc_dispatch = &__libc_malloc_default_dispatch;
+#endif
+
+/* Without malloc debugging, the entry points call the default routines
+ * directly. The compare against the default table is a well-predicted
+ * branch, and lets the compiler tail-call or inline the allocator rather
+ * than make an indirect call through the table. */
+static inline bool malloc_dispatch_is_default() {
+    return __predict_true(__libc_malloc_dispatch == &__libc_malloc_default_dispatch);
+}
 
 extern "C" void* malloc(size_t bytes) {
+    if (malloc_dispatch_is_default()) {
+        return __malloc_cache_malloc(bytes);
+    }
     return __libc_malloc_dispatch->malloc(bytes);
 }
 
 extern "C" void free(void* mem) {
+    if (malloc_dispatch_is_default()) {
+        __malloc_cache_free(mem);
+        return;
+    }
+    __libc_malloc_dispatch->free(mem);
+}
+
+extern "C" void free_sized(void* mem, size_t bytes) {
+    if (malloc_dispatch_is_default()) {
+        __malloc_cache_free_sized(mem, bytes);
+        return;
+    }
     __libc_malloc_dispatch->free(mem);
 }
 
 extern "C" void* calloc(size_t n_elements, size_t elem_size) {
+    if (malloc_dispatch_is_default()) {
+        return __malloc_cache_calloc(n_elements, elem_size);
+    }
     return __libc_malloc_dispatch->calloc(n_elements, elem_size);
 }
 
 extern "C" void* realloc(void* oldMem, size_t bytes) {
+    if (malloc_dispatch_is_default()) {
+        return __malloc_cache_realloc(oldMem, bytes);
+    }
     return __libc_malloc_dispatch->realloc(oldMem, bytes);
 }
 
 extern "C" void* memalign(size_t alignment, size_t bytes) {
+    if (malloc_dispatch_is_default()) {
+        return __malloc_arena_memalign(alignment, bytes);
+    }
     return __libc_malloc_dispatch->memalign(alignment, bytes);
 }
 
 extern "C" size_t malloc_usable_size(const void* mem) {
+    if (malloc_dispatch_is_default()) {
+        return __malloc_cache_usable_size(mem);
+    }
     return __libc_malloc_dispatch->malloc_usable_size(mem);
 }
 
@@ -268,13 +442,15 @@ extern const char* __progname;
  *      CHK_SENTINEL_VALUE, and CHK_FILL_FREE macros.
  * 10 - For adding pre-, and post- allocation stubs in order to detect
  *      buffer overruns.
+ * 11 - A leaner version of 10, with smaller stubs, per-thread backlogs and
+ *      sampled use-after-free checks, cheap enough to leave on in soak tests.
  * Note that emulator's memory allocation instrumentation is not controlled by
  * libc.debug.malloc value, but rather by emulator, started with -memcheck
  * option. Note also, that if emulator has started with -memcheck option,
  * emulator's instrumented memory allocation will take over value saved in
  * libc.debug.malloc. In other words, if emulator has started with -memcheck
  * option, libc.debug.malloc value is ignored.
- * Actual functionality for debug levels 1-10 is implemented in
+ * Actual functionality for debug levels 1-11 is implemented in
  * libc_malloc_debug_leak.so, while functionality for emultor's instrumented
  * allocations is implemented in libc_malloc_debug_qemu.so and can be run inside
  * the emulator only.
@@ -282,13 +458,20 @@ extern const char* __progname;
 static void* libc_malloc_impl_handle = NULL;
 
 /* This variable is set to the value of property libc.debug.malloc.backlog,
- * when the value of libc.debug.malloc = 10.  It determines the size of the
- * backlog we use to detect multiple frees.  If the property is not set, the
+ * when the value of libc.debug.malloc = 10 or 11.  It determines the size of the
+ * backlog we use to detect multiple frees (per thread, at level 11).  If the property is not set, the
  * backlog length defaults to BACKLOG_DEFAULT_LEN.
  */
 unsigned int gMallocDebugBacklog;
 #define BACKLOG_DEFAULT_LEN 100
 
+/* This variable is set to the value of property
+ * libc.debug.malloc.sample_interval when libc.debug.malloc = 1. If it's
+ * non-zero, leak tracking records a backtrace for only about one
+ * allocation per that many bytes allocated, rather than for all of them.
+ */
+unsigned int gMallocDebugSampleInterval;
+
 /* The value of libc.debug.malloc. */
 int gMallocDebugLevel;
 
@@ -324,6 +507,28 @@ static void malloc_init_impl() {
     char memcheck_tracing[PROP_VALUE_MAX];
     char debug_program[PROP_VALUE_MAX];
 
+    /* libc.malloc.arenas selects arena mode, with that many arenas chosen by
+     * CPU, or by thread if libc.malloc.arenas.by_thread is set. Anything
+     * already allocated stays in the global heap, where free() finds it. */
+    if (__system_property_get("libc.malloc.arenas", env) && atoi(env) > 1) {
+        char by_thread[PROP_VALUE_MAX];
+        bool arenas_by_thread = __system_property_get("libc.malloc.arenas.by_thread", by_thread) &&
+                                atoi(by_thread) != 0;
+        __malloc_arenas_init(atoi(env), arenas_by_thread);
+    }
+
+    /* libc.malloc.mmap_threshold and libc.malloc.trim_threshold override
+     * dlmalloc's defaults, as mallopt(3) would. */
+    if (__system_property_get("libc.malloc.mmap_threshold", env)) {
+        dlmallopt(M_MMAP_THRESHOLD, atoi(env));
+    }
+    if (__system_property_get("libc.malloc.trim_threshold", env)) {
+        dlmallopt(M_TRIM_THRESHOLD, atoi(env));
+    }
+    if (__system_property_get("libc.malloc.hugepages", env)) {
+        __bionic_malloc_set_hugepages(atoi(env));
+    }
+
     /* Get custom malloc debug level. Note that emulator started with
      * memory checking option will have priority over debug level set in
      * libc.debug.malloc system property. */
@@ -370,7 +575,8 @@ static void malloc_init_impl() {
     switch (gMallocDebugLevel) {
         case 1:
         case 5:
-        case 10: {
+        case 10:
+        case 11: {
             char debug_backlog[PROP_VALUE_MAX];
             if (__system_property_get("libc.debug.malloc.backlog", debug_backlog)) {
                 gMallocDebugBacklog = atoi(debug_backlog);
@@ -379,6 +585,13 @@ static void malloc_init_impl() {
             if (gMallocDebugBacklog == 0) {
                 gMallocDebugBacklog = BACKLOG_DEFAULT_LEN;
             }
+            char sample_interval[PROP_VALUE_MAX];
+            if (gMallocDebugLevel == 1 &&
+                    __system_property_get("libc.debug.malloc.sample_interval", sample_interval)) {
+                gMallocDebugSampleInterval = atoi(sample_interval);
+                info_log("%s: sampling one allocation per %d bytes\n",
+                         __progname, gMallocDebugSampleInterval);
+            }
             so_name = "/system/lib/libc_malloc_debug_leak.so";
             break;
         }
@@ -455,6 +668,9 @@ static void malloc_init_impl() {
         case 10:
             InitMalloc(malloc_impl_handle, &gMallocUse, "chk");
             break;
+        case 11:
+            InitMalloc(malloc_impl_handle, &gMallocUse, "lean");
+            break;
         case 20:
             InitMalloc(malloc_impl_handle, &gMallocUse, "qemu_instrumented");
             break;
@@ -500,23 +716,33 @@ static void malloc_fini_impl() {
 static pthread_once_t  malloc_init_once_ctl = PTHREAD_ONCE_INIT;
 static pthread_once_t  malloc_fini_once_ctl = PTHREAD_ONCE_INIT;
 
-#endif  // !LIBC_STATIC
-#endif  // USE_DL_PREFIX
+/* The thread running malloc_init_impl(), which gets the default routines if
+ * it allocates: the debug table can't be used before it's initialized. */
+static pid_t gMallocInitThread = 0;
 
-/* Initializes memory allocation framework.
- * This routine is called from __libc_init routines implemented
- * in libc_init_static.c and libc_init_dynamic.c files.
- */
-extern "C" __LIBC_HIDDEN__ void malloc_debug_init() {
-    /* We need to initialize malloc iff we implement here custom
-     * malloc routines (i.e. USE_DL_PREFIX is defined) for libc.so */
-#if defined(USE_DL_PREFIX) && !defined(LIBC_STATIC)
-    if (pthread_once(&malloc_init_once_ctl, malloc_init_impl)) {
+static void malloc_lazy_init_impl() {
+    gMallocInitThread = gettid();
+    malloc_init_impl();
+    if (__libc_malloc_dispatch == &gMallocLazyDispatch) {
+        __libc_malloc_dispatch = &__libc_malloc_default_dispatch;
+    }
+    gMallocInitThread = 0;
+}
+
+static const MallocDebug* malloc_lazy_dispatch() {
+    if (gMallocInitThread != 0 && gMallocInitThread == gettid()) {
+        return &__libc_malloc_default_dispatch;
+    }
+    if (pthread_once(&malloc_init_once_ctl, malloc_lazy_init_impl)) {
         error_log("Unable to initialize malloc_debug component.");
+        return &__libc_malloc_default_dispatch;
     }
-#endif  // USE_DL_PREFIX && !LIBC_STATIC
+    return __libc_malloc_dispatch;
 }
 
+#endif  // !LIBC_STATIC
+#endif  // USE_DL_PREFIX
+
 extern "C" __LIBC_HIDDEN__ void malloc_debug_fini() {
     /* We need to finalize malloc iff we implement here custom
      * malloc routines (i.e. USE_DL_PREFIX is defined) for libc.so */
@@ -33,11 +33,14 @@
 #ifndef MALLOC_DEBUG_COMMON_H
 #define MALLOC_DEBUG_COMMON_H
 
+#include <pthread.h>
 #include <stdlib.h>
 
 #include "libc_logging.h"
 
 #define HASHTABLE_SIZE      1543
+/* Each lock covers every HASHTABLE_LOCKS'th slot. */
+#define HASHTABLE_LOCKS     64
 #define BACKTRACE_SIZE      32
 /* flag definitions, currently sharing storage with "size" */
 #define SIZE_FLAG_ZYGOTE_CHILD  (1<<31)
@@ -66,10 +69,31 @@ struct HashEntry {
 };
 
 struct HashTable {
-    size_t count;
+    size_t count; /* Updated atomically. */
+    unsigned generation; /* Bumped atomically with every change to an entry. */
     HashEntry* slots[HASHTABLE_SIZE];
+    /* All zeroes is PTHREAD_MUTEX_INITIALIZER. */
+    pthread_mutex_t locks[HASHTABLE_LOCKS];
 };
 
+/* The lock for the chain in 'slot'. */
+static inline pthread_mutex_t* hash_table_lock(HashTable* table, size_t slot) {
+    return &table->locks[slot % HASHTABLE_LOCKS];
+}
+
+/* Locks every chain, for operations on the whole table. */
+static inline void hash_table_lock_all(HashTable* table) {
+    for (size_t i = 0; i < HASHTABLE_LOCKS; ++i) {
+        pthread_mutex_lock(&table->locks[i]);
+    }
+}
+
+static inline void hash_table_unlock_all(HashTable* table) {
+    for (size_t i = HASHTABLE_LOCKS; i > 0; --i) {
+        pthread_mutex_unlock(&table->locks[i - 1]);
+    }
+}
+
 /* Entry in malloc dispatch table. */
 typedef void* (*MallocDebugMalloc)(size_t);
 typedef void (*MallocDebugFree)(void*);
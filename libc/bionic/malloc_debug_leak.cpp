@@ -60,8 +60,8 @@
 
 // Global variables defined in malloc_debug_common.c
 extern int gMallocLeakZygoteChild;
-extern pthread_mutex_t gAllocationsMutex;
 extern HashTable gHashTable;
+extern unsigned int gMallocDebugSampleInterval;
 
 // =============================================================================
 // stack trace functions
@@ -137,10 +137,13 @@ static HashEntry* record_backtrace(uintptr_t* backtrace, size_t numEntries, size
         size |= SIZE_FLAG_ZYGOTE_CHILD;
     }
 
+    ScopedPthreadMutexLocker locker(hash_table_lock(&gHashTable, slot));
+
     HashEntry* entry = find_entry(&gHashTable, slot, backtrace, numEntries, size);
 
     if (entry != NULL) {
         entry->allocations++;
+        __sync_fetch_and_add(&gHashTable.generation, 1);
     } else {
         // create a new entry
         entry = static_cast<HashEntry*>(dlmalloc(sizeof(HashEntry) + numEntries*sizeof(uintptr_t)));
@@ -163,7 +166,8 @@ static HashEntry* record_backtrace(uintptr_t* backtrace, size_t numEntries, size
         }
 
         // we just added an entry, increase the size of the hashtable
-        gHashTable.count++;
+        __sync_fetch_and_add(&gHashTable.count, 1);
+        __sync_fetch_and_add(&gHashTable.generation, 1);
     }
 
     return entry;
@@ -201,7 +205,7 @@ static void remove_entry(HashEntry* entry) {
     }
 
     // we just removed and entry, decrease the size of the hashtable
-    gHashTable.count--;
+    __sync_fetch_and_sub(&gHashTable.count, 1);
 }
 
 // =============================================================================
@@ -262,6 +266,61 @@ extern "C" size_t fill_malloc_usable_size(const void* mem) {
 
 static uint32_t MEMALIGN_GUARD      = 0xA1A41520;
 
+// In sampling mode, each thread counts down the bytes until its next
+// sample. The gaps are drawn from an exponential distribution with a mean
+// of gMallocDebugSampleInterval, so every byte allocated is equally likely
+// to be sampled, however the allocations are sized or interleaved.
+static pthread_once_t gSampleKeysOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gSampleCountdownKey;
+static pthread_key_t gSampleRandomKey;
+
+static void sample_keys_create() {
+    pthread_key_create(&gSampleCountdownKey, NULL);
+    pthread_key_create(&gSampleRandomKey, NULL);
+}
+
+// Returns a gap drawn from the exponential distribution: -ln(u) * mean for
+// u uniform in (0, 1], computed in 16.16 fixed point with a piecewise
+// linear log2.
+static size_t sample_next_gap(uintptr_t* random) {
+    uint32_t x = *random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *random = x;
+
+    int leading_zeros = __builtin_clz(x);
+    uint32_t log2_u = ((31 - leading_zeros) << 16) + (((x << leading_zeros) >> 15) & 0xffff);
+    uint64_t minus_log2_u = (32U << 16) - log2_u;
+    // ln(2) is 45426/65536.
+    return static_cast<size_t>((gMallocDebugSampleInterval * minus_log2_u * 45426) >> 32) + 1;
+}
+
+// Should this allocation of 'bytes' have its backtrace recorded?
+static bool should_sample(size_t bytes) {
+    if (gMallocDebugSampleInterval == 0) {
+        return true;
+    }
+    pthread_once(&gSampleKeysOnce, sample_keys_create);
+
+    // The countdown is stored plus one, so that 0 means "not started yet".
+    uintptr_t countdown = reinterpret_cast<uintptr_t>(pthread_getspecific(gSampleCountdownKey));
+    bool sample = false;
+    if (countdown == 0 || countdown - 1 <= bytes) {
+        uintptr_t random = reinterpret_cast<uintptr_t>(pthread_getspecific(gSampleRandomKey));
+        if (random == 0) {
+            random = (reinterpret_cast<uintptr_t>(&countdown) >> 4) ^ getpid() ^ 0x9e3779b9;
+        }
+        sample = (countdown != 0);
+        countdown = sample_next_gap(&random) + 1;
+        pthread_setspecific(gSampleRandomKey, reinterpret_cast<void*>(random));
+    } else {
+        countdown -= bytes;
+    }
+    pthread_setspecific(gSampleCountdownKey, reinterpret_cast<void*>(countdown));
+    return sample;
+}
+
 extern "C" void* leak_malloc(size_t bytes) {
     // allocate enough space infront of the allocation to store the pointer for
     // the alloc structure. This will making free'ing the structer really fast!
@@ -276,15 +335,19 @@ extern "C" void* leak_malloc(size_t bytes) {
 
     void* base = dlmalloc(size);
     if (base != NULL) {
-        ScopedPthreadMutexLocker locker(&gAllocationsMutex);
-
-        uintptr_t backtrace[BACKTRACE_SIZE];
-        size_t numEntries = get_backtrace(backtrace, BACKTRACE_SIZE);
-
         AllocationEntry* header = reinterpret_cast<AllocationEntry*>(base);
-        header->entry = record_backtrace(backtrace, numEntries, bytes);
+        header->entry = NULL;
         header->guard = GUARD;
 
+        // Unsampled allocations have no entry, and cost neither a backtrace
+        // nor the lock.
+        if (should_sample(bytes)) {
+            uintptr_t backtrace[BACKTRACE_SIZE];
+            size_t numEntries = get_backtrace(backtrace, BACKTRACE_SIZE);
+
+            header->entry = record_backtrace(backtrace, numEntries, bytes);
+        }
+
         // now increment base to point to after our header.
         // this should just work since our header is 8 bytes.
         base = reinterpret_cast<AllocationEntry*>(base) + 1;
@@ -295,8 +358,6 @@ extern "C" void* leak_malloc(size_t bytes) {
 
 extern "C" void leak_free(void* mem) {
     if (mem != NULL) {
-        ScopedPthreadMutexLocker locker(&gAllocationsMutex);
-
         // check the guard to make sure it is valid
         AllocationEntry* header = to_header(mem);
 
@@ -309,12 +370,33 @@ extern "C" void leak_free(void* mem) {
             }
         }
 
-        if (header->guard == GUARD || is_valid_entry(header->entry)) {
+        if (header->guard == GUARD && header->entry == NULL) {
+            // An allocation that wasn't sampled.
+            dlfree(header);
+            return;
+        }
+
+        bool valid = (header->guard == GUARD);
+        if (!valid) {
+            hash_table_lock_all(&gHashTable);
+            valid = is_valid_entry(header->entry);
+            hash_table_unlock_all(&gHashTable);
+        }
+
+        if (valid) {
             // decrement the allocations
             HashEntry* entry = header->entry;
-            entry->allocations--;
-            if (entry->allocations <= 0) {
-                remove_entry(entry);
+            bool last;
+            {
+                ScopedPthreadMutexLocker locker(hash_table_lock(&gHashTable, entry->slot));
+                entry->allocations--;
+                __sync_fetch_and_add(&gHashTable.generation, 1);
+                last = (entry->allocations <= 0);
+                if (last) {
+                    remove_entry(entry);
+                }
+            }
+            if (last) {
                 dlfree(entry);
             }
 
@@ -359,7 +441,13 @@ extern "C" void* leak_realloc(void* oldMem, size_t bytes) {
 
     newMem = leak_malloc(bytes);
     if (newMem != NULL) {
-        size_t oldSize = header->entry->size & ~SIZE_FLAG_MASK;
+        size_t oldSize;
+        if (header->entry != NULL) {
+            oldSize = header->entry->size & ~SIZE_FLAG_MASK;
+        } else {
+            oldSize = reinterpret_cast<uintptr_t>(header) + dlmalloc_usable_size(header) -
+                      reinterpret_cast<uintptr_t>(oldMem);
+        }
         size_t copySize = (oldSize <= bytes) ? oldSize : bytes;
         memcpy(newMem, oldMem, copySize);
     }
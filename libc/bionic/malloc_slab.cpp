@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "malloc_slab.h"
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "private/bionic_name_mem.h"
+#include "private/libc_logging.h"
+
+// A run is one page. The header is followed by the objects, each aligned to
+// MALLOC_SLAB_CLASS_SIZE.
+#define SLAB_RUN_SIZE PAGE_SIZE
+#define SLAB_REGION_RUNS (MALLOC_SLAB_REGION_SIZE / SLAB_RUN_SIZE)
+#define SLAB_BITMAP_WORDS ((SLAB_RUN_SIZE / MALLOC_SLAB_CLASS_SIZE + 31) / 32)
+
+struct slab_run_t {
+  slab_run_t* next; // In the class's list of runs with free slots.
+  slab_run_t* prev;
+  uint16_t class_index;
+  uint16_t free_count;
+  uint32_t bitmap[SLAB_BITMAP_WORDS]; // Set bits are free slots.
+};
+
+#define SLAB_HEADER_SIZE \
+    ((sizeof(slab_run_t) + MALLOC_SLAB_CLASS_SIZE - 1) & ~(MALLOC_SLAB_CLASS_SIZE - 1))
+
+static inline size_t slab_run_capacity(size_t index) {
+  return (SLAB_RUN_SIZE - SLAB_HEADER_SIZE) / __malloc_slab_class_size(index);
+}
+
+static inline slab_run_t* slab_run_of(const void* mem) {
+  return reinterpret_cast<slab_run_t*>(reinterpret_cast<uintptr_t>(mem) & ~(SLAB_RUN_SIZE - 1));
+}
+
+struct slab_class_t {
+  pthread_mutex_t lock;
+  slab_run_t* partial; // Runs with at least one free slot, but not all free.
+  slab_run_t* empty;   // One wholly free run, kept so a class doesn't thrash.
+  size_t run_count;    // Including 'empty'.
+  size_t allocated;    // Objects handed out (including to thread caches).
+  size_t contended;    // Times the lock was already held when we wanted it.
+};
+
+static void slab_class_lock(slab_class_t* c) {
+  if (__predict_false(pthread_mutex_trylock(&c->lock) != 0)) {
+    pthread_mutex_lock(&c->lock);
+    ++c->contended;
+  }
+}
+
+// All zeroes is PTHREAD_MUTEX_INITIALIZER.
+static slab_class_t gSlabClasses[MALLOC_SLAB_CLASSES];
+
+// The region slab runs come from. Until it's reserved, this is an address
+// that __malloc_slab_owns() doesn't match for any pointer.
+uintptr_t __malloc_slab_region = static_cast<uintptr_t>(-MALLOC_SLAB_REGION_SIZE);
+
+static pthread_mutex_t gSlabRegionLock = PTHREAD_MUTEX_INITIALIZER;
+static bool gSlabRegionReserved;
+static size_t gSlabRegionUsedRuns;
+// Runs given back to the region, whose pages we've already released. A run
+// is a single page, so these are tracked here rather than in the runs.
+static uint16_t gSlabFreeRuns[SLAB_REGION_RUNS];
+static size_t gSlabFreeRunCount;
+
+static void slab_lock_all() {
+  for (size_t i = 0; i < MALLOC_SLAB_CLASSES; ++i) {
+    pthread_mutex_lock(&gSlabClasses[i].lock);
+  }
+  pthread_mutex_lock(&gSlabRegionLock);
+}
+
+static void slab_unlock_all() {
+  pthread_mutex_unlock(&gSlabRegionLock);
+  for (size_t i = MALLOC_SLAB_CLASSES; i > 0; --i) {
+    pthread_mutex_unlock(&gSlabClasses[i - 1].lock);
+  }
+}
+
+// Reserves the region the first time it's needed. Returns false if we
+// couldn't, in which case everything comes from dlmalloc.
+static bool slab_region_reserve_locked() {
+  if (gSlabRegionReserved) {
+    return __malloc_slab_region != static_cast<uintptr_t>(-MALLOC_SLAB_REGION_SIZE);
+  }
+  gSlabRegionReserved = true;
+  // No page is touched, or counted against us, until it's used.
+  void* region = mmap(NULL, MALLOC_SLAB_REGION_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (region == MAP_FAILED) {
+    return false;
+  }
+  __bionic_name_mem(region, MALLOC_SLAB_REGION_SIZE, "libc_malloc");
+  __malloc_slab_region = reinterpret_cast<uintptr_t>(region);
+  return true;
+}
+
+// Set once some thread has taken on calling pthread_atfork for us.
+static volatile int gSlabAtforkRegistered;
+
+// pthread_atfork allocates, possibly from a slab class, so this must be called
+// before taking any of our locks. An allocation it makes meanwhile doesn't wait
+// for the handlers: nothing can be holding the locks across a fork before then.
+static void slab_register_atfork() {
+  if (__predict_false(gSlabAtforkRegistered == 0) &&
+      __sync_bool_compare_and_swap(&gSlabAtforkRegistered, 0, 1)) {
+    pthread_atfork(slab_lock_all, slab_unlock_all, slab_unlock_all);
+  }
+}
+
+static slab_run_t* slab_run_alloc(size_t index) {
+  slab_run_t* run = NULL;
+  pthread_mutex_lock(&gSlabRegionLock);
+  if (slab_region_reserve_locked()) {
+    size_t run_index;
+    if (gSlabFreeRunCount > 0) {
+      run_index = gSlabFreeRuns[--gSlabFreeRunCount];
+    } else if (gSlabRegionUsedRuns < SLAB_REGION_RUNS) {
+      run_index = gSlabRegionUsedRuns++;
+    } else {
+      run_index = SLAB_REGION_RUNS;
+    }
+    if (run_index < SLAB_REGION_RUNS) {
+      run = reinterpret_cast<slab_run_t*>(__malloc_slab_region + run_index * SLAB_RUN_SIZE);
+    }
+  }
+  pthread_mutex_unlock(&gSlabRegionLock);
+
+  if (run != NULL) {
+    size_t capacity = slab_run_capacity(index);
+    run->next = NULL;
+    run->prev = NULL;
+    run->class_index = index;
+    run->free_count = capacity;
+    for (size_t i = 0; i < SLAB_BITMAP_WORDS; ++i) {
+      size_t bits = (capacity > 32 * i) ? capacity - 32 * i : 0;
+      run->bitmap[i] = (bits >= 32) ? ~0U : ((1U << bits) - 1);
+    }
+  }
+  return run;
+}
+
+// Gives a wholly free run's page back to the system.
+static void slab_run_release(slab_run_t* run) {
+  madvise(run, SLAB_RUN_SIZE, MADV_DONTNEED);
+  pthread_mutex_lock(&gSlabRegionLock);
+  size_t run_index = (reinterpret_cast<uintptr_t>(run) - __malloc_slab_region) / SLAB_RUN_SIZE;
+  gSlabFreeRuns[gSlabFreeRunCount++] = run_index;
+  pthread_mutex_unlock(&gSlabRegionLock);
+}
+
+static void slab_partial_push(slab_class_t* c, slab_run_t* run) {
+  run->prev = NULL;
+  run->next = c->partial;
+  if (c->partial != NULL) {
+    c->partial->prev = run;
+  }
+  c->partial = run;
+}
+
+static void slab_partial_remove(slab_class_t* c, slab_run_t* run) {
+  if (run->prev != NULL) {
+    run->prev->next = run->next;
+  } else {
+    c->partial = run->next;
+  }
+  if (run->next != NULL) {
+    run->next->prev = run->prev;
+  }
+  run->next = run->prev = NULL;
+}
+
+size_t __malloc_slab_alloc_batch(size_t index, size_t count, void* objects[]) {
+  slab_class_t* c = &gSlabClasses[index];
+  const size_t size = __malloc_slab_class_size(index);
+  size_t got = 0;
+
+  slab_register_atfork();
+  slab_class_lock(c);
+  while (got < count) {
+    slab_run_t* run = c->partial;
+    if (run == NULL) {
+      if (c->empty != NULL) {
+        run = c->empty;
+        c->empty = NULL;
+      } else {
+        run = slab_run_alloc(index);
+        if (run == NULL) {
+          break;
+        }
+        ++c->run_count;
+      }
+      slab_partial_push(c, run);
+    }
+
+    char* first_object = reinterpret_cast<char*>(run) + SLAB_HEADER_SIZE;
+    for (size_t w = 0; w < SLAB_BITMAP_WORDS && got < count; ++w) {
+      while (run->bitmap[w] != 0 && got < count) {
+        size_t bit = __builtin_ctz(run->bitmap[w]);
+        run->bitmap[w] &= ~(1U << bit);
+        objects[got++] = first_object + (32 * w + bit) * size;
+        --run->free_count;
+      }
+    }
+    if (run->free_count == 0) {
+      slab_partial_remove(c, run);
+    }
+  }
+  c->allocated += got;
+  pthread_mutex_unlock(&c->lock);
+  return got;
+}
+
+static void slab_free_locked(slab_class_t* c, slab_run_t* run, void* mem) {
+  size_t index = run->class_index;
+  size_t offset = reinterpret_cast<char*>(mem) - (reinterpret_cast<char*>(run) + SLAB_HEADER_SIZE);
+  size_t slot = offset / __malloc_slab_class_size(index);
+  if (__predict_false(offset % __malloc_slab_class_size(index) != 0 ||
+                      slot >= slab_run_capacity(index) ||
+                      (run->bitmap[slot / 32] & (1U << (slot % 32))) != 0)) {
+    __libc_fatal("invalid address or address of corrupt block %p passed to free", mem);
+  }
+  run->bitmap[slot / 32] |= 1U << (slot % 32);
+  --c->allocated;
+
+  if (++run->free_count == 1) {
+    slab_partial_push(c, run); // It was full.
+  }
+  if (run->free_count == slab_run_capacity(index)) {
+    slab_partial_remove(c, run);
+    if (c->empty == NULL) {
+      c->empty = run;
+    } else {
+      --c->run_count;
+      slab_run_release(run);
+    }
+  }
+}
+
+void __malloc_slab_free_batch(void* const objects[], size_t count) {
+  slab_class_t* locked = NULL;
+  for (size_t i = 0; i < count; ++i) {
+    slab_run_t* run = slab_run_of(objects[i]);
+    slab_class_t* c = &gSlabClasses[run->class_index];
+    if (c != locked) {
+      if (locked != NULL) {
+        pthread_mutex_unlock(&locked->lock);
+      }
+      slab_class_lock(c);
+      locked = c;
+    }
+    slab_free_locked(c, run, objects[i]);
+  }
+  if (locked != NULL) {
+    pthread_mutex_unlock(&locked->lock);
+  }
+}
+
+size_t __malloc_slab_class_of(const void* mem) {
+  return slab_run_of(mem)->class_index;
+}
+
+bool __malloc_slab_trim() {
+  bool released = false;
+  for (size_t i = 0; i < MALLOC_SLAB_CLASSES; ++i) {
+    slab_class_t* c = &gSlabClasses[i];
+    pthread_mutex_lock(&c->lock);
+    if (c->empty != NULL) {
+      slab_run_release(c->empty);
+      c->empty = NULL;
+      --c->run_count;
+      released = true;
+    }
+    pthread_mutex_unlock(&c->lock);
+  }
+  return released;
+}
+
+void __malloc_slab_stats(size_t index, malloc_slab_stats_t* stats) {
+  slab_class_t* c = &gSlabClasses[index];
+  pthread_mutex_lock(&c->lock);
+  stats->runs = c->run_count;
+  stats->partial_runs = 0;
+  for (slab_run_t* run = c->partial; run != NULL; run = run->next) {
+    ++stats->partial_runs;
+  }
+  stats->allocated = c->allocated;
+  stats->contended = c->contended;
+  pthread_mutex_unlock(&c->lock);
+}
+
+void __malloc_slab_mallinfo(struct mallinfo* mi) {
+  for (size_t i = 0; i < MALLOC_SLAB_CLASSES; ++i) {
+    slab_class_t* c = &gSlabClasses[i];
+    pthread_mutex_lock(&c->lock);
+    size_t run_bytes = c->run_count * SLAB_RUN_SIZE;
+    size_t allocated_bytes = c->allocated * __malloc_slab_class_size(i);
+    mi->arena += run_bytes;
+    mi->uordblks += allocated_bytes;
+    mi->fordblks += run_bytes - allocated_bytes;
+    pthread_mutex_unlock(&c->lock);
+  }
+}
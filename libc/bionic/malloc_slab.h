@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef LIBC_BIONIC_MALLOC_SLAB_H_
+#define LIBC_BIONIC_MALLOC_SLAB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#include "dlmalloc.h"
+
+__BEGIN_DECLS
+
+/*
+ * A slab allocator for small objects. Objects of each size class (every
+ * MALLOC_SLAB_CLASS_SIZE bytes up to MALLOC_SLAB_MAX_SIZE) are carved out of
+ * page-sized runs, each with a small header and a bitmap of free slots, so
+ * they cost no per-object header and no bin search. The runs come from one
+ * reserved region, which is how free() tells slab objects from dlmalloc
+ * chunks. Each size class has its own lock.
+ */
+#define MALLOC_SLAB_CLASS_SIZE 16
+#define MALLOC_SLAB_CLASSES 16
+#define MALLOC_SLAB_MAX_SIZE (MALLOC_SLAB_CLASS_SIZE * MALLOC_SLAB_CLASSES)
+
+/* The size class for a request of 'bytes', which must be at most MALLOC_SLAB_MAX_SIZE. */
+static inline size_t __malloc_slab_class_for(size_t bytes) {
+  return (bytes == 0) ? 0 : (bytes - 1) / MALLOC_SLAB_CLASS_SIZE;
+}
+
+/* The size of the objects in class 'index'. */
+static inline size_t __malloc_slab_class_size(size_t index) {
+  return (index + 1) * MALLOC_SLAB_CLASS_SIZE;
+}
+
+__LIBC_HIDDEN__ extern uintptr_t __malloc_slab_region;
+#define MALLOC_SLAB_REGION_SIZE (64U * 1024U * 1024U)
+
+/* Is 'mem' a slab object, rather than a dlmalloc chunk? */
+static inline bool __malloc_slab_owns(const void* mem) {
+  return reinterpret_cast<uintptr_t>(mem) - __malloc_slab_region < MALLOC_SLAB_REGION_SIZE;
+}
+
+/*
+ * Allocates up to 'count' objects of class 'index' into 'objects', under one
+ * acquisition of the class's lock, and returns how many it got. That's
+ * fewer than asked for only when the slab region is exhausted, in which case
+ * the caller should fall back to dlmalloc.
+ */
+__LIBC_HIDDEN__ size_t __malloc_slab_alloc_batch(size_t index, size_t count, void* objects[]);
+
+/* Frees 'count' objects, taking each class's lock once per run of objects of that class. */
+__LIBC_HIDDEN__ void __malloc_slab_free_batch(void* const objects[], size_t count);
+
+/* The class of slab object 'mem'. */
+__LIBC_HIDDEN__ size_t __malloc_slab_class_of(const void* mem);
+
+/* Releases the empty runs each class keeps cached. Returns true if there were any. */
+__LIBC_HIDDEN__ bool __malloc_slab_trim(void);
+
+struct malloc_slab_stats_t {
+  size_t runs;         /* Pages in use by this class. */
+  size_t partial_runs; /* Runs with both free and allocated slots. */
+  size_t allocated;    /* Objects allocated, including those in thread caches. */
+  size_t contended;    /* Times a thread had to wait for the class's lock. */
+};
+
+/* A snapshot of class 'index'. */
+__LIBC_HIDDEN__ void __malloc_slab_stats(size_t index, struct malloc_slab_stats_t* stats);
+
+/* Adds the slab allocator's memory to the mallinfo(3) totals in 'mi'. */
+__LIBC_HIDDEN__ void __malloc_slab_mallinfo(struct mallinfo* mi);
+
+__END_DECLS
+
+#endif  // LIBC_BIONIC_MALLOC_SLAB_H_
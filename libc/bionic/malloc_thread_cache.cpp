@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "malloc_thread_cache.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "dlmalloc.h"
+#include "malloc_arena.h"
+#include "malloc_slab.h"
+#include "pthread_internal.h"
+#include "private/libc_logging.h"
+
+// Every slab size class is cached. Objects move between a cache and the slab
+// allocator this many at a time, and a cache holds at most MALLOC_CACHE_MAX
+// of each class.
+#define MALLOC_CACHE_CLASSES MALLOC_SLAB_CLASSES
+#define MALLOC_CACHE_BATCH 16
+#define MALLOC_CACHE_MAX (4 * MALLOC_CACHE_BATCH)
+
+struct malloc_cache_t {
+  size_t counts[MALLOC_CACHE_CLASSES];
+  void* chunks[MALLOC_CACHE_CLASSES][MALLOC_CACHE_MAX];
+  malloc_cache_stats_t stats;
+};
+
+// The counts from threads that have exited. This lock also keeps a cache
+// from being freed while __malloc_cache_stats reads it.
+static malloc_cache_stats_t gMallocExitedStats;
+static pthread_mutex_t gMallocStatsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// A cached object's second word holds this value xor'ed with the address of
+// its cache, so that free() can check for double frees cheaply.
+#define MALLOC_CACHE_KEY 0x7ca4e5a1U
+
+// pthread_internal_t::malloc_cache after the thread has flushed its cache.
+#define MALLOC_CACHE_DISABLED reinterpret_cast<void*>(-1)
+
+static malloc_cache_t* malloc_cache_get() {
+  pthread_internal_t* thread = __get_thread();
+  if (__predict_false(thread == NULL)) {
+    return NULL;
+  }
+  void* cache = thread->malloc_cache;
+  if (__predict_false(cache == NULL)) {
+    cache = dlcalloc(1, sizeof(malloc_cache_t));
+    if (cache == NULL) {
+      return NULL;
+    }
+    thread->malloc_cache = cache;
+  } else if (__predict_false(cache == MALLOC_CACHE_DISABLED)) {
+    return NULL;
+  }
+  return reinterpret_cast<malloc_cache_t*>(cache);
+}
+
+static inline uintptr_t malloc_cache_key(const malloc_cache_t* cache) {
+  return reinterpret_cast<uintptr_t>(cache) ^ MALLOC_CACHE_KEY;
+}
+
+// Takes a batch of objects of class 'index' from the slab allocator. Returns
+// false if the slab region is exhausted.
+static bool malloc_cache_refill(malloc_cache_t* cache, size_t index) {
+  void** chunks = &cache->chunks[index][cache->counts[index]];
+  cache->counts[index] += __malloc_slab_alloc_batch(index, MALLOC_CACHE_BATCH, chunks);
+  return cache->counts[index] > 0;
+}
+
+static inline size_t malloc_stats_large_bucket(size_t bytes) {
+  size_t multiple = (bytes - 1) / MALLOC_SLAB_MAX_SIZE; // At least 1.
+  size_t bucket = 31 - __builtin_clz(multiple);
+  return (bucket < MALLOC_STATS_LARGE_BUCKETS) ? bucket : MALLOC_STATS_LARGE_BUCKETS - 1;
+}
+
+void* __malloc_cache_malloc(size_t bytes) {
+  if (bytes <= MALLOC_SLAB_MAX_SIZE) {
+    size_t index = __malloc_slab_class_for(bytes);
+    malloc_cache_t* cache = malloc_cache_get();
+    if (cache != NULL) {
+      ++cache->stats.small_allocs[index];
+      if (cache->counts[index] > 0 || malloc_cache_refill(cache, index)) {
+        void** chunk = reinterpret_cast<void**>(cache->chunks[index][--cache->counts[index]]);
+        chunk[1] = NULL;
+        return chunk;
+      }
+    } else {
+      void* mem;
+      if (__malloc_slab_alloc_batch(index, 1, &mem) == 1) {
+        return mem;
+      }
+    }
+  } else {
+    malloc_cache_t* cache = malloc_cache_get();
+    if (cache != NULL) {
+      ++cache->stats.large_allocs[malloc_stats_large_bucket(bytes)];
+    }
+  }
+  return __malloc_arena_malloc(bytes);
+}
+
+static void malloc_cache_free_large(void* mem) {
+  if (mem != NULL) {
+    malloc_cache_t* cache = malloc_cache_get();
+    if (cache != NULL) {
+      ++cache->stats.frees;
+    }
+  }
+  dlfree(mem);
+}
+
+static inline void malloc_cache_free_small(void* mem, size_t index) {
+  malloc_cache_t* cache = malloc_cache_get();
+  if (cache == NULL) {
+    __malloc_slab_free_batch(&mem, 1);
+    return;
+  }
+  ++cache->stats.frees;
+  uintptr_t* chunk = reinterpret_cast<uintptr_t*>(mem);
+  if (__predict_false(chunk[1] == malloc_cache_key(cache))) {
+    for (size_t i = 0; i < cache->counts[index]; ++i) {
+      if (cache->chunks[index][i] == mem) {
+        __libc_fatal("invalid address or address of corrupt block %p passed to free", mem);
+      }
+    }
+  }
+  if (cache->counts[index] == MALLOC_CACHE_MAX) {
+    // Spill the oldest batch, all under one acquisition of the class's lock.
+    __malloc_slab_free_batch(cache->chunks[index], MALLOC_CACHE_BATCH);
+    memmove(cache->chunks[index], &cache->chunks[index][MALLOC_CACHE_BATCH],
+            (MALLOC_CACHE_MAX - MALLOC_CACHE_BATCH) * sizeof(void*));
+    cache->counts[index] -= MALLOC_CACHE_BATCH;
+  }
+  chunk[1] = malloc_cache_key(cache);
+  cache->chunks[index][cache->counts[index]++] = mem;
+}
+
+void __malloc_cache_free(void* mem) {
+  if (!__malloc_slab_owns(mem)) {
+    malloc_cache_free_large(mem);
+    return;
+  }
+  malloc_cache_free_small(mem, __malloc_slab_class_of(mem));
+}
+
+// A small request always gets an object of its own class (realloc only keeps an
+// object if the new size is in the same class), so the size it was allocated with
+// gives the class without reading the run header. Anything bigger that's still a
+// slab object must have a wrong size, so don't trust it.
+void __malloc_cache_free_sized(void* mem, size_t bytes) {
+  if (!__malloc_slab_owns(mem)) {
+    malloc_cache_free_large(mem);
+    return;
+  }
+  size_t index = (bytes <= MALLOC_SLAB_MAX_SIZE) ? __malloc_slab_class_for(bytes)
+                                                 : __malloc_slab_class_of(mem);
+  malloc_cache_free_small(mem, index);
+}
+
+void* __malloc_cache_calloc(size_t n_elements, size_t elem_size) {
+  size_t bytes = n_elements * elem_size;
+  if (n_elements != 0 && bytes / n_elements != elem_size) {
+    return __malloc_arena_calloc(n_elements, elem_size); // Let dlmalloc report the overflow.
+  }
+  if (bytes > MALLOC_SLAB_MAX_SIZE) {
+    return __malloc_arena_calloc(n_elements, elem_size);
+  }
+  void* mem = __malloc_cache_malloc(bytes);
+  if (mem != NULL) {
+    memset(mem, 0, bytes);
+  }
+  return mem;
+}
+
+void* __malloc_cache_realloc(void* mem, size_t bytes) {
+  if (!__malloc_slab_owns(mem)) {
+    return __malloc_arena_realloc(mem, bytes);
+  }
+  if (bytes == 0) {
+    __malloc_cache_free(mem); // As dlrealloc does, with REALLOC_ZERO_BYTES_FREES.
+    return NULL;
+  }
+  size_t old_size = __malloc_slab_class_size(__malloc_slab_class_of(mem));
+  if (bytes <= old_size && bytes > old_size - MALLOC_SLAB_CLASS_SIZE) {
+    return mem; // Still the same class.
+  }
+  void* new_mem = __malloc_cache_malloc(bytes);
+  if (new_mem != NULL) {
+    memcpy(new_mem, mem, (bytes < old_size) ? bytes : old_size);
+    __malloc_cache_free(mem);
+  }
+  return new_mem;
+}
+
+size_t __malloc_cache_usable_size(const void* mem) {
+  if (__malloc_slab_owns(mem)) {
+    return __malloc_slab_class_size(__malloc_slab_class_of(mem));
+  }
+  return dlmalloc_usable_size(mem);
+}
+
+static void malloc_stats_add(malloc_cache_stats_t* total, const malloc_cache_stats_t& stats) {
+  for (size_t i = 0; i < MALLOC_SLAB_CLASSES; ++i) {
+    total->small_allocs[i] += stats.small_allocs[i];
+  }
+  for (size_t i = 0; i < MALLOC_STATS_LARGE_BUCKETS; ++i) {
+    total->large_allocs[i] += stats.large_allocs[i];
+  }
+  total->frees += stats.frees;
+}
+
+void __malloc_cache_stats(malloc_cache_stats_t* stats) {
+  memset(stats, 0, sizeof(*stats));
+  pthread_mutex_lock(&gMallocStatsLock);
+  malloc_stats_add(stats, gMallocExitedStats);
+  pthread_mutex_unlock(&gMallocStatsLock);
+  for (size_t i = 0; i < PTHREAD_LIST_SHARDS; ++i) {
+    pthread_list_shard_t* shard = &gThreadListShards[i];
+    pthread_mutex_lock(&shard->lock);
+    pthread_mutex_lock(&gMallocStatsLock);
+    for (pthread_internal_t* thread = shard->head; thread != NULL; thread = thread->next) {
+      void* cache = thread->malloc_cache;
+      if (cache != NULL && cache != MALLOC_CACHE_DISABLED) {
+        // Another thread's counters may be a little stale, but never torn.
+        malloc_stats_add(stats, reinterpret_cast<malloc_cache_t*>(cache)->stats);
+      }
+    }
+    pthread_mutex_unlock(&gMallocStatsLock);
+    pthread_mutex_unlock(&shard->lock);
+  }
+}
+
+void __malloc_thread_cache_flush() {
+  pthread_internal_t* thread = __get_thread();
+  pthread_mutex_lock(&gMallocStatsLock);
+  void* cache = thread->malloc_cache;
+  thread->malloc_cache = MALLOC_CACHE_DISABLED;
+  if (cache != NULL && cache != MALLOC_CACHE_DISABLED) {
+    malloc_stats_add(&gMallocExitedStats, reinterpret_cast<malloc_cache_t*>(cache)->stats);
+  }
+  pthread_mutex_unlock(&gMallocStatsLock);
+  if (cache == NULL || cache == MALLOC_CACHE_DISABLED) {
+    return;
+  }
+  malloc_cache_t* c = reinterpret_cast<malloc_cache_t*>(cache);
+  for (size_t i = 0; i < MALLOC_CACHE_CLASSES; ++i) {
+    __malloc_slab_free_batch(c->chunks[i], c->counts[i]);
+  }
+  dlfree(c);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
+#define LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+#include "malloc_slab.h"
+
+__BEGIN_DECLS
+
+/*
+ * A per-thread cache of small free objects in front of the slab allocator,
+ * so that most small allocations and frees take no lock at all. Objects move
+ * between a thread's cache and the slab allocator in batches. Requests too
+ * big for a slab go to dlmalloc. Pointers these return may be slab objects,
+ * so they must be reallocated and measured with these functions rather than
+ * dlrealloc and dlmalloc_usable_size.
+ */
+__LIBC_HIDDEN__ void* __malloc_cache_malloc(size_t bytes);
+__LIBC_HIDDEN__ void __malloc_cache_free(void* mem);
+/* As __malloc_cache_free, given the size 'mem' was allocated with. */
+__LIBC_HIDDEN__ void __malloc_cache_free_sized(void* mem, size_t bytes);
+__LIBC_HIDDEN__ void* __malloc_cache_calloc(size_t n_elements, size_t elem_size);
+__LIBC_HIDDEN__ void* __malloc_cache_realloc(void* mem, size_t bytes);
+__LIBC_HIDDEN__ size_t __malloc_cache_usable_size(const void* mem);
+
+/*
+ * Allocation counts, kept per thread by the caches so that counting costs
+ * no atomic operations.
+ */
+#define MALLOC_STATS_LARGE_BUCKETS 20 /* Powers of two from 2*MALLOC_SLAB_MAX_SIZE. */
+struct malloc_cache_stats_t {
+  size_t small_allocs[MALLOC_SLAB_CLASSES];
+  /* large_allocs[i] counts requests up to 2^(i+1) * MALLOC_SLAB_MAX_SIZE
+   * bytes; the last bucket counts everything bigger too. */
+  size_t large_allocs[MALLOC_STATS_LARGE_BUCKETS];
+  size_t frees;
+};
+
+/* The counts for every live thread plus every thread that has exited. */
+__LIBC_HIDDEN__ void __malloc_cache_stats(struct malloc_cache_stats_t* stats);
+
+/*
+ * Returns the calling thread's cached objects to the slab allocator, and stops it
+ * caching any more. Called from pthread_exit.
+ */
+__LIBC_HIDDEN__ void __malloc_thread_cache_flush(void);
+
+__END_DECLS
+
+#endif  // LIBC_BIONIC_MALLOC_THREAD_CACHE_H_
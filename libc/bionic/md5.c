@@ -215,6 +215,18 @@ MD5_Update (struct md5 *m, const void *v, size_t len)
       ++m->sz[1];
   offset = (old_sz / 8)  % 64;
   while(len > 0){
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    /* Whole aligned blocks can be hashed in place, without the copy. */
+    if(offset == 0 && ((uintptr_t)p & 3) == 0){
+      while(len >= 64){
+	calc(m, (u_int32_t*)p);
+	p += 64;
+	len -= 64;
+      }
+      if(len == 0)
+	break;
+    }
+#endif
     size_t l = min(len, 64 - offset);
     memcpy(m->save + offset, p, l);
     offset += l;
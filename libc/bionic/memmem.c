@@ -26,39 +26,130 @@
  * SUCH DAMAGE.
  */
 /*
- * This uses the "Not So Naive" algorithm, a very simple but
- * usually effective algorithm, see:
- * http://www-igm.univ-mlv.fr/~lecroq/string/
+ * The two-way algorithm (Crochemore and Perrin, "Two-way string-matching",
+ * JACM 38(3), 1991), which needs no allocation and is linear in the worst
+ * case. Before that, memchr() skips to the first occurrence of the needle's
+ * first byte; and each alignment is tried only if the haystack byte under
+ * the needle's last byte occurs in the needle, which usually allows a shift
+ * by the whole needle length.
  */
 #include <string.h>
 
-void *memmem(const void *haystack, size_t n, const void *needle, size_t m)
-{
-    if (m > n || !m || !n)
-        return NULL;
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
 
-    if (__builtin_expect((m > 1), 1)) {
-        const unsigned char*  y = (const unsigned char*) haystack;
-        const unsigned char*  x = (const unsigned char*) needle;
-        size_t                j = 0;
-        size_t                k = 1, l = 2;
+#define BITOP(set, c, op) \
+    ((set)[(c) / (8 * sizeof(*(set)))] op ((size_t)1 << ((c) % (8 * sizeof(*(set))))))
 
-        if (x[0] == x[1]) {
-            k = 2;
-            l = 1;
-        }
-        while (j <= n-m) {
-            if (x[1] != y[j+1]) {
-                j += k;
+/*
+ * Returns the start of the maximal suffix of 'x' for the ordering given by
+ * 'reverse', and sets '*period' to the suffix's period.
+ */
+static size_t max_suffix(const unsigned char* x, size_t m, int reverse, size_t* period)
+{
+    size_t i = (size_t)-1, j = 0, k = 1, p = 1;
+
+    while (j + k < m) {
+        unsigned char a = x[i + k], b = x[j + k];
+        if (a == b) {
+            if (k == p) {
+                j += p;
+                k = 1;
             } else {
-                if (!memcmp(x+2, y+j+2, m-2) && x[0] == y[j])
-                    return (void*) &y[j];
-                j += l;
+                k++;
             }
+        } else if (reverse ? a < b : a > b) {
+            j += k;
+            k = 1;
+            p = j - i;
+        } else {
+            i = j++;
+            k = p = 1;
         }
+    }
+    *period = p;
+    return i;
+}
+
+static void* two_way(const unsigned char* y, size_t n, const unsigned char* x, size_t m)
+{
+    const unsigned char* end = y + n;
+    size_t byteset[32 / sizeof(size_t)] = { 0 };
+    size_t shift[256];
+    size_t i, k, ms, p, p2, memory, period_memory;
+
+    /* shift[c] is how far it is from the last occurrence of c to the end. */
+    for (i = 0; i < m; i++) {
+        BITOP(byteset, x[i], |=);
+        shift[x[i]] = m - 1 - i;
+    }
+
+    /* The critical factorization is the later of the two maximal suffixes. */
+    ms = max_suffix(x, m, 0, &p);
+    i = max_suffix(x, m, 1, &p2);
+    if (i + 1 > ms + 1) {
+        ms = i;
+        p = p2;
+    }
+
+    /*
+     * For a periodic needle, a successful shift by the period leaves all but
+     * the last period matched already. Otherwise, any shift can be as long
+     * as the longer half.
+     */
+    if (memcmp(x, x + p, ms + 1) == 0) {
+        period_memory = m - p;
     } else {
-        /* degenerate case */
-        return memchr(haystack, ((unsigned char*)needle)[0], n);
+        period_memory = 0;
+        p = MAX(ms + 1, m - ms - 1) + 1;
+    }
+
+    memory = 0;
+    while ((size_t)(end - y) >= m) {
+        unsigned char last = y[m - 1];
+        if (!BITOP(byteset, last, &)) {
+            y += m;
+            memory = 0;
+            continue;
+        }
+        k = shift[last];
+        if (k != 0) {
+            y += MAX(k, memory);
+            memory = 0;
+            continue;
+        }
+
+        /* Match the right half, then the left half. */
+        for (k = MAX(ms + 1, memory); k < m && x[k] == y[k]; k++) {
+        }
+        if (k < m) {
+            y += k - ms;
+            memory = 0;
+            continue;
+        }
+        for (k = ms + 1; k > memory && x[k - 1] == y[k - 1]; k--) {
+        }
+        if (k <= memory) {
+            return (void*) y;
+        }
+        y += p;
+        memory = period_memory;
     }
     return NULL;
 }
+
+void *memmem(const void *haystack, size_t n, const void *needle, size_t m)
+{
+    const unsigned char* y = (const unsigned char*) haystack;
+    const unsigned char* x = (const unsigned char*) needle;
+    const unsigned char* first;
+
+    if (m > n || !m || !n) {
+        return NULL;
+    }
+
+    first = memchr(y, x[0], n - m + 1);
+    if (first == NULL || m == 1) {
+        return (void*) first;
+    }
+    return two_way(first, n - (first - y), x, m);
+}
@@ -28,6 +28,9 @@
 
 #include "private/bionic_name_mem.h"
 
+#include <errno.h>
+#include <sys/prctl.h>
+
 /*
  * Local definitions of custom prctl arguments to set a vma name in some kernels
  */
@@ -42,12 +45,17 @@
  * be a pointer to a string that is valid for as long as the memory is mapped,
  * preferably a compile-time constant string.
  *
- * Returns -1 on error and sets errno.  If it returns an error naming page
- * aligned anonymous memory the kernel doesn't support naming, and an alternate
- * method of naming memory should be used (like ashmem).
+ * Returns -1 on error, but leaves errno alone: names are a debugging aid,
+ * given in the middle of functions whose callers look at errno.  If it returns
+ * an error naming page aligned anonymous memory the kernel doesn't support
+ * naming, and an alternate method of naming memory should be used (like
+ * ashmem).
  */
 int __bionic_name_mem(void *addr, size_t len, const char *name)
 {
-    return prctl(BIONIC_PR_SET_VMA, BIONIC_PR_SET_VMA_ANON_NAME,
-                 addr, len, name);
+    int saved_errno = errno;
+    int result = prctl(BIONIC_PR_SET_VMA, BIONIC_PR_SET_VMA_ANON_NAME,
+                       addr, len, name);
+    errno = saved_errno;
+    return result;
 }
@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <spawn.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <paths.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/kernel_sigset_t.h"
+
+#include "cpuacct.h"
+
+extern "C" int __rt_sigprocmask(int, const kernel_sigset_t*, kernel_sigset_t*, size_t);
+
+struct __posix_spawnattr {
+  short flags;
+  pid_t pgroup;
+  sigset_t sigmask;
+  sigset_t sigdefault;
+  int schedpolicy;
+  sched_param schedparam;
+};
+
+enum spawn_action_t {
+  SPAWN_OPEN,
+  SPAWN_CLOSE,
+  SPAWN_DUP2
+};
+
+struct spawn_file_action {
+  spawn_file_action* next;
+  spawn_action_t action;
+  int fd;
+  int new_fd;
+  char* path;
+  int flags;
+  mode_t mode;
+};
+
+struct __posix_spawn_file_actions {
+  spawn_file_action* head;
+  spawn_file_action* tail;
+};
+
+// Everything the child needs, set up by the parent. The child runs on a
+// stack in the parent's frame and shares its memory, so it writes 'error'
+// directly rather than through a pipe.
+struct spawn_args {
+  const char* file;
+  const char* search_path;  // NULL for posix_spawn, $PATH for posix_spawnp.
+  char* const* argv;
+  char* const* envp;
+  const __posix_spawnattr* attr;
+  const __posix_spawn_file_actions* actions;
+  const kernel_sigset_t* parent_mask;
+  int error;
+};
+
+static int apply_file_actions(const __posix_spawn_file_actions* actions) {
+  for (spawn_file_action* a = (actions != NULL) ? actions->head : NULL; a != NULL; a = a->next) {
+    if (a->action == SPAWN_OPEN) {
+      int fd = open(a->path, a->flags, a->mode);
+      if (fd == -1) {
+        return -1;
+      }
+      if (fd != a->fd) {
+        if (dup2(fd, a->fd) == -1) {
+          return -1;
+        }
+        close(fd);
+      }
+    } else if (a->action == SPAWN_CLOSE) {
+      // Closing something that's already closed isn't an error worth failing the spawn for.
+      if (close(a->fd) == -1 && errno != EBADF) {
+        return -1;
+      }
+    } else if (a->fd == a->new_fd) {
+      // dup2 to itself would be a no-op, but the caller wants the fd inherited.
+      int flags = fcntl(a->fd, F_GETFD);
+      if (flags == -1 || fcntl(a->fd, F_SETFD, flags & ~FD_CLOEXEC) == -1) {
+        return -1;
+      }
+    } else if (dup2(a->fd, a->new_fd) == -1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int apply_attrs(const __posix_spawnattr* attr) {
+  short flags = (attr != NULL) ? attr->flags : 0;
+  if ((flags & POSIX_SPAWN_SETPGROUP) != 0 && setpgid(0, attr->pgroup) == -1) {
+    return -1;
+  }
+  if ((flags & POSIX_SPAWN_SETSCHEDULER) != 0) {
+    if (sched_setscheduler(0, attr->schedpolicy, &attr->schedparam) == -1) {
+      return -1;
+    }
+  } else if ((flags & POSIX_SPAWN_SETSCHEDPARAM) != 0) {
+    if (sched_setparam(0, &attr->schedparam) == -1) {
+      return -1;
+    }
+  }
+  if ((flags & POSIX_SPAWN_RESETIDS) != 0) {
+    if (setgid(getgid()) == -1 || setuid(getuid()) == -1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Like execvp(3), but with an explicit environment and without touching
+// 'environ', which the child shares with the parent.
+static void exec_search(const char* file, const char* search_path, char* const* argv, char* const* envp) {
+  size_t file_length = strlen(file);
+  char buf[PATH_MAX];
+  bool saw_eacces = false;
+  const char* dir = search_path;
+  while (true) {
+    const char* end = strchr(dir, ':');
+    size_t dir_length = (end != NULL) ? static_cast<size_t>(end - dir) : strlen(dir);
+    if (dir_length + 1 + file_length < sizeof(buf)) {
+      // An empty entry means the current directory.
+      size_t n = 0;
+      if (dir_length == 0) {
+        buf[n++] = '.';
+      } else {
+        memcpy(buf, dir, dir_length);
+        n = dir_length;
+      }
+      buf[n++] = '/';
+      memcpy(buf + n, file, file_length + 1);
+      execve(buf, argv, envp);
+      if (errno == EACCES) {
+        saw_eacces = true;
+      } else if (errno != ENOENT && errno != ENOTDIR && errno != ELOOP && errno != ENAMETOOLONG) {
+        return;
+      }
+    }
+    if (end == NULL) {
+      break;
+    }
+    dir = end + 1;
+  }
+  errno = saw_eacces ? EACCES : ENOENT;
+}
+
+static int spawn_child(void* arg) {
+  spawn_args* args = reinterpret_cast<spawn_args*>(arg);
+  const __posix_spawnattr* attr = args->attr;
+  bool set_sigdef = (attr != NULL) && (attr->flags & POSIX_SPAWN_SETSIGDEF) != 0;
+
+  // Every signal is blocked, but before execve unblocks them a handler
+  // could run here on the parent's memory, so reset all caught signals.
+  for (int sig = 1; sig < _NSIG; ++sig) {
+    struct sigaction sa;
+    if (sigaction(sig, NULL, &sa) == -1) {
+      continue;
+    }
+    if (sa.sa_handler == SIG_DFL) {
+      continue;
+    }
+    if (sa.sa_handler == SIG_IGN && !(set_sigdef && sigismember(&attr->sigdefault, sig) == 1)) {
+      continue;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_DFL;
+    sigaction(sig, &sa, NULL);
+  }
+
+  if (apply_attrs(attr) == 0 && apply_file_actions(args->actions) == 0) {
+    // Newly created processes must update cpu accounting, as after fork.
+    cpuacct_add(getuid());
+
+    if (attr != NULL && (attr->flags & POSIX_SPAWN_SETSIGMASK) != 0) {
+      kernel_sigset_t mask(&attr->sigmask);
+      __rt_sigprocmask(SIG_SETMASK, &mask, NULL, sizeof(mask));
+    } else {
+      __rt_sigprocmask(SIG_SETMASK, args->parent_mask, NULL, sizeof(*args->parent_mask));
+    }
+
+    if (args->search_path == NULL || strchr(args->file, '/') != NULL) {
+      execve(args->file, args->argv, args->envp);
+    } else {
+      exec_search(args->file, args->search_path, args->argv, args->envp);
+    }
+  }
+  args->error = errno;
+  _exit(127);
+}
+
+static int posix_spawn_common(pid_t* pid_ptr, const char* file, const char* search_path,
+                              const posix_spawn_file_actions_t* actions, const posix_spawnattr_t* attr,
+                              char* const argv[], char* const envp[]) {
+  // The child sets errno in our thread's TLS, which it shares.
+  ErrnoRestorer errno_restorer;
+
+  spawn_args args;
+  args.file = file;
+  args.search_path = search_path;
+  args.argv = argv;
+  args.envp = envp;
+  args.attr = (attr != NULL) ? *attr : NULL;
+  args.actions = (actions != NULL) ? *actions : NULL;
+  args.error = 0;
+
+  // Block everything (including the real-time signals sigset_t can't
+  // express) so nothing reaches the child before it's reset its handlers.
+  kernel_sigset_t all_signals;
+  all_signals.fill();
+  kernel_sigset_t parent_mask;
+  __rt_sigprocmask(SIG_SETMASK, &all_signals, &parent_mask, sizeof(parent_mask));
+  args.parent_mask = &parent_mask;
+
+  // With CLONE_VFORK we don't resume until the child has called execve or
+  // exited, so its stack can live in our frame. exec_search needs PATH_MAX.
+  char child_stack[PATH_MAX + 4096] __attribute__((aligned(16)));
+  pid_t pid = clone(spawn_child, child_stack + sizeof(child_stack), CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+
+  int result = 0;
+  if (pid == -1) {
+    result = errno;
+  } else if (args.error != 0) {
+    result = args.error;
+    TEMP_FAILURE_RETRY(waitpid(pid, NULL, 0));
+  } else if (pid_ptr != NULL) {
+    *pid_ptr = pid;
+  }
+
+  __rt_sigprocmask(SIG_SETMASK, &parent_mask, NULL, sizeof(parent_mask));
+  return result;
+}
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* actions,
+                const posix_spawnattr_t* attr, char* const argv[], char* const envp[]) {
+  return posix_spawn_common(pid, path, NULL, actions, attr, argv, envp);
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* actions,
+                 const posix_spawnattr_t* attr, char* const argv[], char* const envp[]) {
+  const char* search_path = getenv("PATH");
+  if (search_path == NULL) {
+    search_path = _PATH_DEFPATH;
+  }
+  return posix_spawn_common(pid, file, search_path, actions, attr, argv, envp);
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr) {
+  *attr = reinterpret_cast<__posix_spawnattr*>(calloc(1, sizeof(__posix_spawnattr)));
+  return (*attr == NULL) ? errno : 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t* attr) {
+  free(*attr);
+  *attr = NULL;
+  return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags) {
+  if ((flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |
+                 POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSCHEDPARAM | POSIX_SPAWN_SETSCHEDULER)) != 0) {
+    return EINVAL;
+  }
+  (*attr)->flags = flags;
+  return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags) {
+  *flags = (*attr)->flags;
+  return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t* attr, pid_t pgroup) {
+  (*attr)->pgroup = pgroup;
+  return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t* attr, pid_t* pgroup) {
+  *pgroup = (*attr)->pgroup;
+  return 0;
+}
+
+int posix_spawnattr_setsigmask(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigmask = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigmask(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigmask;
+  return 0;
+}
+
+int posix_spawnattr_setsigdefault(posix_spawnattr_t* attr, const sigset_t* mask) {
+  (*attr)->sigdefault = *mask;
+  return 0;
+}
+
+int posix_spawnattr_getsigdefault(const posix_spawnattr_t* attr, sigset_t* mask) {
+  *mask = (*attr)->sigdefault;
+  return 0;
+}
+
+int posix_spawnattr_setschedparam(posix_spawnattr_t* attr, const struct sched_param* param) {
+  (*attr)->schedparam = *param;
+  return 0;
+}
+
+int posix_spawnattr_getschedparam(const posix_spawnattr_t* attr, struct sched_param* param) {
+  *param = (*attr)->schedparam;
+  return 0;
+}
+
+int posix_spawnattr_setschedpolicy(posix_spawnattr_t* attr, int policy) {
+  (*attr)->schedpolicy = policy;
+  return 0;
+}
+
+int posix_spawnattr_getschedpolicy(const posix_spawnattr_t* attr, int* policy) {
+  *policy = (*attr)->schedpolicy;
+  return 0;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* actions) {
+  *actions = reinterpret_cast<__posix_spawn_file_actions*>(calloc(1, sizeof(__posix_spawn_file_actions)));
+  return (*actions == NULL) ? errno : 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* actions) {
+  spawn_file_action* a = (*actions)->head;
+  while (a != NULL) {
+    spawn_file_action* next = a->next;
+    free(a->path);
+    free(a);
+    a = next;
+  }
+  free(*actions);
+  *actions = NULL;
+  return 0;
+}
+
+static int add_file_action(posix_spawn_file_actions_t* actions, spawn_action_t action,
+                           int fd, int new_fd, const char* path, int flags, mode_t mode) {
+  if (fd < 0 || new_fd < 0) {
+    return EBADF;
+  }
+  spawn_file_action* a = reinterpret_cast<spawn_file_action*>(calloc(1, sizeof(spawn_file_action)));
+  if (a == NULL) {
+    return errno;
+  }
+  if (path != NULL) {
+    a->path = strdup(path);
+    if (a->path == NULL) {
+      int error = errno;
+      free(a);
+      return error;
+    }
+  }
+  a->action = action;
+  a->fd = fd;
+  a->new_fd = new_fd;
+  a->flags = flags;
+  a->mode = mode;
+
+  // They have to be applied in the order they were added.
+  if ((*actions)->tail == NULL) {
+    (*actions)->head = a;
+  } else {
+    (*actions)->tail->next = a;
+  }
+  (*actions)->tail = a;
+  return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int fd, const char* path,
+                                     int flags, mode_t mode) {
+  return add_file_action(actions, SPAWN_OPEN, fd, 0, path, flags, mode);
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd) {
+  return add_file_action(actions, SPAWN_CLOSE, fd, 0, NULL, 0, 0);
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int fd, int new_fd) {
+  return add_file_action(actions, SPAWN_DUP2, fd, new_fd, NULL, 0, 0);
+}
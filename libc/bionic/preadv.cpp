@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+// The kernel takes the offset as two words, low first, on every
+// architecture, rather than as an off64_t subject to register pairing.
+extern "C" ssize_t __preadv64(int, const struct iovec*, int, unsigned long, unsigned long);
+extern "C" ssize_t __pwritev64(int, const struct iovec*, int, unsigned long, unsigned long);
+
+static inline unsigned long low_word(off64_t offset) {
+  return static_cast<unsigned long>(static_cast<uint64_t>(offset));
+}
+
+static inline unsigned long high_word(off64_t offset) {
+  return static_cast<unsigned long>(static_cast<uint64_t>(offset) >> 32);
+}
+
+ssize_t preadv(int fd, const struct iovec* iov, int count, off_t offset) {
+  return preadv64(fd, iov, count, offset);
+}
+
+ssize_t preadv64(int fd, const struct iovec* iov, int count, off64_t offset) {
+  return __preadv64(fd, iov, count, low_word(offset), high_word(offset));
+}
+
+ssize_t pwritev(int fd, const struct iovec* iov, int count, off_t offset) {
+  return pwritev64(fd, iov, count, offset);
+}
+
+ssize_t pwritev64(int fd, const struct iovec* iov, int count, off64_t offset) {
+  return __pwritev64(fd, iov, count, low_word(offset), high_word(offset));
+}
@@ -26,8 +26,13 @@
  * SUCH DAMAGE.
  */
 
-#include "pthread_internal.h"
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include "bionic_atomic_inline.h"
+#include "bionic_futex.h"
+#include "pthread_internal.h"
 
 /* Technical note:
  *
@@ -45,16 +50,44 @@
  *  - Posix states that behavior is undefined it a thread tries to acquire
  *    the lock in two distinct modes (e.g. write after read, or read after write).
  *
- *  - This implementation tries to avoid writer starvation by making the readers
- *    block as soon as there is a waiting writer on the lock. However, it cannot
- *    completely eliminate it: each time the lock is unlocked, all waiting threads
- *    are woken and battle for it, which one gets it depends on the kernel scheduler
- *    and is semi-random.
+ *  - By default readers block as soon as there is a waiting writer on the
+ *    lock, so that writers aren't starved. pthread_rwlockattr_setkind_np()
+ *    with PTHREAD_RWLOCK_PREFER_READER_NP lets readers in regardless, which
+ *    gives the best read throughput when writers are rare.
+ *
+ * Everything but the writer's identity lives in a single 'state' word, so
+ * an uncontended read or write lock, and its unlock, is a single cmpxchg:
  *
+ * bits:     name                 description
+ * 0         writer               held for writing
+ * 1         readers waiting      some readers sleep on 'state'
+ * 2-15      pending writers      number of writers waiting for the lock
+ * 16-31     readers              number of read locks held
+ *
+ * Readers sleep on 'state' itself. Writers sleep on 'writerWakeup', a
+ * sequence number bumped each time a writer should retry, so that handing
+ * the lock to one writer doesn't wake every waiter.
  */
 
-#define  RWLOCKATTR_DEFAULT     0
-#define  RWLOCKATTR_SHARED_MASK 0x0010
+#define  RWSTATE_WRITER              0x00000001U
+#define  RWSTATE_READERS_WAITING     0x00000002U
+#define  RWSTATE_PENDING_WRITER_ONE  0x00000004U
+#define  RWSTATE_PENDING_WRITERS     0x0000fffcU
+#define  RWSTATE_READER_ONE          0x00010000U
+#define  RWSTATE_READERS             0xffff0000U
+
+/* a read/write lock attribute holds the following fields
+ *
+ * bits:     name           description
+ * 0         shared         process-shared flag
+ * 1         prefer reader  readers don't wait for pending writers
+ *
+ * The same bits are copied into the 'attr' field of the lock. The
+ * static initializer leaves them at 0: private and writer-preferring.
+ */
+#define  RWLOCKATTR_DEFAULT              0
+#define  RWLOCKATTR_SHARED_MASK          0x0001
+#define  RWLOCKATTR_PREFER_READER_MASK   0x0002
 
 extern pthread_internal_t* __get_thread(void);
 
@@ -63,7 +96,7 @@ int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
     if (!attr)
         return EINVAL;
 
-    *attr = PTHREAD_PROCESS_PRIVATE;
+    *attr = RWLOCKATTR_DEFAULT;
     return 0;
 }
 
@@ -83,8 +116,10 @@ int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int  pshared)
 
     switch (pshared) {
     case PTHREAD_PROCESS_PRIVATE:
+        *attr &= ~RWLOCKATTR_SHARED_MASK;
+        return 0;
     case PTHREAD_PROCESS_SHARED:
-        *attr = pshared;
+        *attr |= RWLOCKATTR_SHARED_MASK;
         return 0;
     default:
         return EINVAL;
@@ -96,45 +131,49 @@ int pthread_rwlockattr_getpshared(pthread_rwlockattr_t *attr, int *pshared)
     if (!attr || !pshared)
         return EINVAL;
 
-    *pshared = *attr;
+    *pshared = (*attr & RWLOCKATTR_SHARED_MASK) ? PTHREAD_PROCESS_SHARED
+                                                : PTHREAD_PROCESS_PRIVATE;
     return 0;
 }
 
-int pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr)
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *attr, int pref)
 {
-    pthread_mutexattr_t*  lock_attr = NULL;
-    pthread_condattr_t*   cond_attr = NULL;
-    pthread_mutexattr_t   lock_attr0;
-    pthread_condattr_t    cond_attr0;
-    int                   ret;
-
-    if (rwlock == NULL)
+    if (!attr)
         return EINVAL;
 
-    if (attr && *attr == PTHREAD_PROCESS_SHARED) {
-        lock_attr = &lock_attr0;
-        pthread_mutexattr_init(lock_attr);
-        pthread_mutexattr_setpshared(lock_attr, PTHREAD_PROCESS_SHARED);
-
-        cond_attr = &cond_attr0;
-        pthread_condattr_init(cond_attr);
-        pthread_condattr_setpshared(cond_attr, PTHREAD_PROCESS_SHARED);
+    switch (pref) {
+    case PTHREAD_RWLOCK_PREFER_READER_NP:
+        *attr |= RWLOCKATTR_PREFER_READER_MASK;
+        return 0;
+    case PTHREAD_RWLOCK_PREFER_WRITER_NP:
+        *attr &= ~RWLOCKATTR_PREFER_READER_MASK;
+        return 0;
+    default:
+        return EINVAL;
     }
+}
 
-    ret = pthread_mutex_init(&rwlock->lock, lock_attr);
-    if (ret != 0)
-        return ret;
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *attr, int *pref)
+{
+    if (!attr || !pref)
+        return EINVAL;
 
-    ret = pthread_cond_init(&rwlock->cond, cond_attr);
-    if (ret != 0) {
-        pthread_mutex_destroy(&rwlock->lock);
-        return ret;
-    }
+    *pref = (*attr & RWLOCKATTR_PREFER_READER_MASK) ? PTHREAD_RWLOCK_PREFER_READER_NP
+                                                    : PTHREAD_RWLOCK_PREFER_WRITER_NP;
+    return 0;
+}
+
+int pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr)
+{
+    if (rwlock == NULL)
+        return EINVAL;
 
-    rwlock->numLocks = 0;
-    rwlock->pendingReaders = 0;
-    rwlock->pendingWriters = 0;
+    rwlock->state = 0;
+    rwlock->writerWakeup = 0;
+    rwlock->writerLockCount = 0;
     rwlock->writerThreadId = 0;
+    rwlock->attr = attr ? (*attr & (RWLOCKATTR_SHARED_MASK|RWLOCKATTR_PREFER_READER_MASK))
+                        : RWLOCKATTR_DEFAULT;
 
     return 0;
 }
@@ -144,193 +183,272 @@ int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
     if (rwlock == NULL)
         return EINVAL;
 
-    if (rwlock->numLocks > 0)
+    if ((rwlock->state & (RWSTATE_WRITER|RWSTATE_READERS)) != 0)
         return EBUSY;
 
-    pthread_cond_destroy(&rwlock->cond);
-    pthread_mutex_destroy(&rwlock->lock);
     return 0;
 }
 
-/* Returns TRUE iff we can acquire a read lock. */
-static __inline__ int read_precondition(pthread_rwlock_t* rwlock, int tid)
+/* Convert the absolute CLOCK_REALTIME deadline 'abstime' into the relative
+ * timeout 'ts' that FUTEX_WAIT wants. Returns -1 if it has already passed.
+ */
+static int rwlock_relative_timeout(struct timespec* ts, const struct timespec* abstime)
 {
-    /* We can't have the lock if any writer is waiting for it (writer bias).
-     * This tries to avoid starvation when there are multiple readers racing.
-     */
-    if (rwlock->pendingWriters > 0)
-        return 0;
-
-    /* We can have the lock if there is no writer, or if we write-own it */
-    /* The second test avoids a self-dead lock in case of buggy code. */
-    if (rwlock->writerThreadId == 0 || rwlock->writerThreadId == tid)
-        return 1;
-
-    /* Otherwise, we can't have it */
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec  = abstime->tv_sec - ts->tv_sec;
+    ts->tv_nsec = abstime->tv_nsec - ts->tv_nsec;
+    if (ts->tv_nsec < 0) {
+        ts->tv_sec--;
+        ts->tv_nsec += 1000000000;
+    }
+    if (ts->tv_nsec < 0 || ts->tv_sec < 0)
+        return -1;
     return 0;
 }
 
-/* returns TRUE iff we can acquire a write lock. */
-static __inline__ int write_precondition(pthread_rwlock_t* rwlock, int tid)
+static __inline__ int rwlock_cmpxchg(unsigned old_state, unsigned new_state, pthread_rwlock_t* rwlock)
 {
-    /* We can get the lock if nobody has it */
-    if (rwlock->numLocks == 0)
-        return 1;
+    return __bionic_cmpxchg((int) old_state, (int) new_state, &rwlock->state);
+}
 
-    /* Or if we already own it */
-    if (rwlock->writerThreadId == tid)
-        return 1;
+/* Returns TRUE iff a reader may take the lock in 'state' right now. */
+static __inline__ int read_precondition(pthread_rwlock_t* rwlock, unsigned state)
+{
+    if (state & RWSTATE_WRITER)
+        return 0;
 
-    /* Otherwise, not */
-    return 0;
+    /* Unless readers are preferred, don't cut in front of a waiting writer
+     * (writer bias). This avoids starvation when readers keep overlapping.
+     */
+    if ((state & RWSTATE_PENDING_WRITERS) != 0 &&
+        (rwlock->attr & RWLOCKATTR_PREFER_READER_MASK) == 0)
+        return 0;
+
+    return 1;
 }
 
-/* This function is used to waken any waiting thread contending
- * for the lock. One of them should be able to grab it after
- * that.
- */
-static void _pthread_rwlock_pulse(pthread_rwlock_t *rwlock)
+/* Let one waiting writer retry. */
+static void wake_writer(pthread_rwlock_t* rwlock)
 {
-    if (rwlock->pendingReaders > 0 || rwlock->pendingWriters > 0)
-        pthread_cond_broadcast(&rwlock->cond);
+    __bionic_atomic_inc(&rwlock->writerWakeup);
+    __futex_wake_ex(&rwlock->writerWakeup, rwlock->attr & RWLOCKATTR_SHARED_MASK, 1);
 }
 
-
-int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+static void wake_readers(pthread_rwlock_t* rwlock)
 {
-    return pthread_rwlock_timedrdlock(rwlock, NULL);
+    __futex_wake_ex(&rwlock->state, rwlock->attr & RWLOCKATTR_SHARED_MASK, INT_MAX);
 }
 
-int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+static int rwlock_rdlock(pthread_rwlock_t *rwlock, int wait, const struct timespec *abs_timeout)
 {
-    int ret = 0;
+    struct timespec ts;
+    unsigned state;
 
     if (rwlock == NULL)
         return EINVAL;
 
-    pthread_mutex_lock(&rwlock->lock);
-    if (__predict_false(!read_precondition(rwlock, __get_thread()->tid)))
-        ret = EBUSY;
-    else
-        rwlock->numLocks ++;
-    pthread_mutex_unlock(&rwlock->lock);
+    for (;;) {
+        state = rwlock->state;
+
+        if (__predict_true(read_precondition(rwlock, state))) {
+            if (__predict_false((state & RWSTATE_READERS) == RWSTATE_READERS))
+                return EAGAIN;
+            if (rwlock_cmpxchg(state, state + RWSTATE_READER_ONE, rwlock) == 0) {
+                ANDROID_MEMBAR_FULL();
+                return 0;
+            }
+            continue;
+        }
 
-    return ret;
-}
+        /* A writer may take a read lock on top of its own write lock.
+         * This avoids a self-dead lock in case of buggy code. */
+        if ((state & RWSTATE_WRITER) && rwlock->writerThreadId == __get_thread()->tid) {
+            rwlock->writerLockCount++;
+            return 0;
+        }
 
-int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock, const struct timespec *abs_timeout)
-{
-    int ret = 0;
+        if (!wait)
+            return EBUSY;
 
-    if (rwlock == NULL)
-        return EINVAL;
+        /* Flag that there are readers to wake before going to sleep. The
+         * futex wait returns at once if 'state' changed meanwhile. */
+        if ((state & RWSTATE_READERS_WAITING) == 0) {
+            if (rwlock_cmpxchg(state, state | RWSTATE_READERS_WAITING, rwlock) != 0)
+                continue;
+            state |= RWSTATE_READERS_WAITING;
+        }
 
-    pthread_mutex_lock(&rwlock->lock);
-    int tid = __get_thread()->tid;
-    if (__predict_false(!read_precondition(rwlock, tid))) {
-        rwlock->pendingReaders += 1;
-        do {
-            ret = pthread_cond_timedwait(&rwlock->cond, &rwlock->lock, abs_timeout);
-        } while (ret == 0 && !read_precondition(rwlock, tid));
-        rwlock->pendingReaders -= 1;
-        if (ret != 0)
-            goto EXIT;
+        if (abs_timeout != NULL && rwlock_relative_timeout(&ts, abs_timeout) < 0)
+            return ETIMEDOUT;
+        __futex_wait_ex(&rwlock->state, rwlock->attr & RWLOCKATTR_SHARED_MASK,
+                        (int) state, abs_timeout ? &ts : NULL);
     }
-    rwlock->numLocks ++;
-EXIT:
-    pthread_mutex_unlock(&rwlock->lock);
-    return ret;
 }
 
-
-int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
 {
-    return pthread_rwlock_timedwrlock(rwlock, NULL);
+    return rwlock_rdlock(rwlock, 1, NULL);
 }
 
-int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
 {
-    int ret = 0;
+    return rwlock_rdlock(rwlock, 0, NULL);
+}
 
-    if (rwlock == NULL)
-        return EINVAL;
+int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock, const struct timespec *abs_timeout)
+{
+    return rwlock_rdlock(rwlock, 1, abs_timeout);
+}
 
-    pthread_mutex_lock(&rwlock->lock);
-    int tid = __get_thread()->tid;
-    if (__predict_false(!write_precondition(rwlock, tid))) {
-        ret = EBUSY;
-    } else {
-        rwlock->numLocks ++;
-        rwlock->writerThreadId = tid;
-    }
-    pthread_mutex_unlock(&rwlock->lock);
-    return ret;
+/* Withdraw a writer that stopped waiting. If it was the one holding
+ * readers back, or the wake-up meant for it got lost, pass it on.
+ */
+static void cancel_pending_writer(pthread_rwlock_t* rwlock)
+{
+    unsigned state, new_state;
+
+    do {
+        state = rwlock->state;
+        new_state = state - RWSTATE_PENDING_WRITER_ONE;
+        if ((new_state & (RWSTATE_PENDING_WRITERS|RWSTATE_WRITER)) == 0)
+            new_state &= ~RWSTATE_READERS_WAITING;
+    } while (rwlock_cmpxchg(state, new_state, rwlock) != 0);
+
+    if ((state & RWSTATE_READERS_WAITING) && !(new_state & RWSTATE_READERS_WAITING))
+        wake_readers(rwlock);
+    if ((new_state & RWSTATE_PENDING_WRITERS) &&
+        (new_state & (RWSTATE_WRITER|RWSTATE_READERS)) == 0)
+        wake_writer(rwlock);
 }
 
-int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock, const struct timespec *abs_timeout)
+static int rwlock_wrlock(pthread_rwlock_t *rwlock, int wait, const struct timespec *abs_timeout)
 {
-    int ret = 0;
+    struct timespec ts;
+    unsigned state;
+    int tid, seq;
 
     if (rwlock == NULL)
         return EINVAL;
 
-    pthread_mutex_lock(&rwlock->lock);
-    int tid = __get_thread()->tid;
-    if (__predict_false(!write_precondition(rwlock, tid))) {
-        /* If we can't read yet, wait until the rwlock is unlocked
-         * and try again. Increment pendingReaders to get the
-         * cond broadcast when that happens.
-         */
-        rwlock->pendingWriters += 1;
-        do {
-            ret = pthread_cond_timedwait(&rwlock->cond, &rwlock->lock, abs_timeout);
-        } while (ret == 0 && !write_precondition(rwlock, tid));
-        rwlock->pendingWriters -= 1;
-        if (ret != 0)
-            goto EXIT;
+    /* fast path for an unlocked lock */
+    if (__predict_true(rwlock_cmpxchg(0, RWSTATE_WRITER, rwlock) == 0)) {
+        ANDROID_MEMBAR_FULL();
+        rwlock->writerThreadId = __get_thread()->tid;
+        rwlock->writerLockCount = 1;
+        return 0;
     }
-    rwlock->numLocks ++;
+
+    tid = __get_thread()->tid;
+    if ((rwlock->state & RWSTATE_WRITER) && rwlock->writerThreadId == tid) {
+        rwlock->writerLockCount++;
+        return 0;
+    }
+
+    /* Take the lock if nobody holds it, or register as a pending writer. */
+    for (;;) {
+        state = rwlock->state;
+        if ((state & (RWSTATE_WRITER|RWSTATE_READERS)) == 0) {
+            if (rwlock_cmpxchg(state, state | RWSTATE_WRITER, rwlock) == 0)
+                goto ACQUIRED;
+            continue;
+        }
+        if (!wait)
+            return EBUSY;
+        if ((state & RWSTATE_PENDING_WRITERS) == RWSTATE_PENDING_WRITERS)
+            return EAGAIN;
+        if (rwlock_cmpxchg(state, state + RWSTATE_PENDING_WRITER_ONE, rwlock) == 0)
+            break;
+    }
+
+    for (;;) {
+        /* Read the sequence number before looking at the state, so that an
+         * unlock that happens in between makes the futex wait return. */
+        seq = rwlock->writerWakeup;
+        state = rwlock->state;
+        if ((state & (RWSTATE_WRITER|RWSTATE_READERS)) == 0) {
+            if (rwlock_cmpxchg(state, (state - RWSTATE_PENDING_WRITER_ONE) | RWSTATE_WRITER,
+                               rwlock) == 0)
+                goto ACQUIRED;
+            continue;
+        }
+
+        if (abs_timeout != NULL && rwlock_relative_timeout(&ts, abs_timeout) < 0) {
+            cancel_pending_writer(rwlock);
+            return ETIMEDOUT;
+        }
+        __futex_wait_ex(&rwlock->writerWakeup, rwlock->attr & RWLOCKATTR_SHARED_MASK,
+                        seq, abs_timeout ? &ts : NULL);
+    }
+
+ACQUIRED:
+    ANDROID_MEMBAR_FULL();
     rwlock->writerThreadId = tid;
-EXIT:
-    pthread_mutex_unlock(&rwlock->lock);
-    return ret;
+    rwlock->writerLockCount = 1;
+    return 0;
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+{
+    return rwlock_wrlock(rwlock, 1, NULL);
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+{
+    return rwlock_wrlock(rwlock, 0, NULL);
+}
+
+int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock, const struct timespec *abs_timeout)
+{
+    return rwlock_wrlock(rwlock, 1, abs_timeout);
 }
 
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
 {
-    int  ret = 0;
+    unsigned state, new_state;
 
     if (rwlock == NULL)
         return EINVAL;
 
-    pthread_mutex_lock(&rwlock->lock);
+    state = rwlock->state;
 
     /* The lock must be held */
-    if (rwlock->numLocks == 0) {
-        ret = EPERM;
-        goto EXIT;
+    if ((state & (RWSTATE_WRITER|RWSTATE_READERS)) == 0)
+        return EPERM;
+
+    /* If it's write-locked, it must be by ourselves. */
+    if (state & RWSTATE_WRITER) {
+        if (rwlock->writerThreadId != __get_thread()->tid)
+            return EPERM;
+        if (--rwlock->writerLockCount > 0)
+            return 0;
+        rwlock->writerThreadId = 0;
+
+        ANDROID_MEMBAR_FULL();
+        do {
+            state = rwlock->state;
+            new_state = state & ~RWSTATE_WRITER;
+            /* Readers still have to wait if a writer is next in line. */
+            if (read_precondition(rwlock, new_state))
+                new_state &= ~RWSTATE_READERS_WAITING;
+        } while (rwlock_cmpxchg(state, new_state, rwlock) != 0);
+
+        if ((state & RWSTATE_READERS_WAITING) && !(new_state & RWSTATE_READERS_WAITING))
+            wake_readers(rwlock);
+        if (state & RWSTATE_PENDING_WRITERS)
+            wake_writer(rwlock);
+        return 0;
     }
 
-    /* If it has only readers, writerThreadId is 0 */
-    if (rwlock->writerThreadId == 0) {
-        if (--rwlock->numLocks == 0)
-            _pthread_rwlock_pulse(rwlock);
-    }
-    /* Otherwise, it has only a single writer, which
-     * must be ourselves.
-     */
-    else {
-        if (rwlock->writerThreadId != __get_thread()->tid) {
-            ret = EPERM;
-            goto EXIT;
-        }
-        if (--rwlock->numLocks == 0) {
-            rwlock->writerThreadId = 0;
-            _pthread_rwlock_pulse(rwlock);
-        }
-    }
-EXIT:
-    pthread_mutex_unlock(&rwlock->lock);
-    return ret;
+    /* Otherwise, drop one read lock. The last reader out lets a
+     * pending writer in; readers never wait for other readers. */
+    ANDROID_MEMBAR_FULL();
+    do {
+        state = rwlock->state;
+        new_state = state - RWSTATE_READER_ONE;
+    } while (rwlock_cmpxchg(state, new_state, rwlock) != 0);
+
+    if ((new_state & RWSTATE_READERS) == 0 && (new_state & RWSTATE_PENDING_WRITERS))
+        wake_writer(rwlock);
+    return 0;
 }
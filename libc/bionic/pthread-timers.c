@@ -50,9 +50,12 @@ extern int __pthread_cond_timedwait_relative(pthread_cond_t*, pthread_mutex_t*,
 // www.opengroup.org/onlinepubs/000095399/functions/xsh_chap02_04.html#tag_02_04_01
 //
 // The Linux kernel doesn't support these, so we need to implement them in the
-// C library. We use a very basic scheme where each timer is associated to a
-// thread that will loop, waiting for timeouts or messages from the program
-// corresponding to calls to timer_settime() and timer_delete().
+// C library. All SIGEV_THREAD timers share one dispatcher thread, which sleeps
+// until the earliest expiration of any armed timer or a message from the program
+// (timer_settime(), timer_delete() or fork()). Expired timers are queued to a
+// small pool of callback threads, started on demand, so a slow callback only
+// delays other timers once the whole pool is busy. Timers with an expiration
+// still queued or running accumulate overruns rather than being queued twice.
 //
 // Note also an important thing: Posix mandates that in the case of fork(),
 // the timers of the child process should be disarmed, but not deleted.
@@ -63,12 +66,6 @@ extern int __pthread_cond_timedwait_relative(pthread_cond_t*, pthread_mutex_t*,
 // This stop/start is implemented by the __timer_table_start_stop() function
 // below.
 //
-// A SIGEV_THREAD timer ID will always have its TIMER_ID_WRAP_BIT
-// set to 1. In this implementation, this is always bit 31, which is
-// guaranteed to never be used by kernel-provided timer ids
-//
-// (See code in <kernel>/lib/idr.c, used to manage IDs, to see why.)
-
 #define  TIMER_ID_WRAP_BIT        0x80000000
 #define  TIMER_ID_WRAP(id)        ((timer_t)((id) |  TIMER_ID_WRAP_BIT))
 #define  TIMER_ID_UNWRAP(id)      ((timer_t)((id) & ~TIMER_ID_WRAP_BIT))
@@ -94,32 +91,39 @@ typedef struct thr_timer_table    thr_timer_table_t;
  * it's really a 'union sigval' a.k.a. sigval_t */
 typedef void (*thr_timer_func_t)( sigval_t );
 
+/* All fields are protected by the table lock. */
 struct thr_timer {
-    thr_timer_t*       next;     /* next in free list */
+    thr_timer_t*       next;     /* next in free list or work queue */
     timer_t            id;       /* TIMER_ID_NONE iff free or dying */
     clockid_t          clock;
-    pthread_t          thread;
-    pthread_attr_t     attributes;
     thr_timer_func_t   callback;
     sigval_t           value;
 
-    /* the following are used to communicate between
-     * the timer thread and the timer_XXX() functions
-     */
-    pthread_mutex_t           mutex;     /* lock */
-    pthread_cond_t            cond;      /* signal a state change to thread */
-    int volatile              done;      /* set by timer_delete */
-    int volatile              stopped;   /* set by _start_stop() */
-    struct timespec volatile  expires;   /* next expiration time, or 0 */
-    struct timespec volatile  period;    /* reload value, or 0 */
-    int volatile              overruns;  /* current number of overruns */
+    int                done;      /* set by timer_delete */
+    int                queued;    /* waiting for a callback thread */
+    int                running;   /* callback in progress */
+    struct timespec    expires;   /* next expiration time, or 0 */
+    struct timespec    period;    /* reload value, or 0 */
+    int                overruns;  /* current number of overruns */
 };
 
-#define  MAX_THREAD_TIMERS  32
+/* Timers no longer cost a thread each, so we can afford plenty. */
+#define  MAX_THREAD_TIMERS  256
+
+/* The most callback threads we'll start. */
+#define  MAX_TIMER_WORKERS  4
 
 struct thr_timer_table {
     pthread_mutex_t  lock;
+    pthread_cond_t   dispatcher_cond;  /* signals a state change to the dispatcher */
+    pthread_cond_t   worker_cond;      /* signals queued work to callback threads */
     thr_timer_t*     free_timer;
+    thr_timer_t*     queue_head;       /* expired timers waiting for a callback thread */
+    thr_timer_t*     queue_tail;
+    int              stopped;          /* set by _start_stop() */
+    int              dispatcher_started;
+    int              workers;          /* callback threads started */
+    int              idle_workers;     /* callback threads waiting for work */
     thr_timer_t      timers[ MAX_THREAD_TIMERS ];
 };
 
@@ -133,6 +137,8 @@ thr_timer_table_init( thr_timer_table_t*  t )
 
     memset(t, 0, sizeof *t);
     pthread_mutex_init( &t->lock, NULL );
+    pthread_cond_init( &t->dispatcher_cond, NULL );
+    pthread_cond_init( &t->worker_cond, NULL );
 
     for (nn = 0; nn < MAX_THREAD_TIMERS; nn++)
         t->timers[nn].id = TIMER_ID_NONE;
@@ -143,35 +149,28 @@ thr_timer_table_init( thr_timer_table_t*  t )
 }
 
 
+/* Called with the table lock held. */
 static thr_timer_t*
-thr_timer_table_alloc( thr_timer_table_t*  t )
+thr_timer_table_alloc_locked( thr_timer_table_t*  t )
 {
-    thr_timer_t*  timer;
+    thr_timer_t*  timer = t->free_timer;
 
-    if (t == NULL)
-        return NULL;
-
-    pthread_mutex_lock(&t->lock);
-    timer = t->free_timer;
     if (timer != NULL) {
         t->free_timer = timer->next;
         timer->next   = NULL;
         timer->id     = TIMER_ID_WRAP((timer - t->timers));
     }
-    pthread_mutex_unlock(&t->lock);
     return timer;
 }
 
 
+/* Called with the table lock held. */
 static void
-thr_timer_table_free( thr_timer_table_t*  t, thr_timer_t*  timer )
+thr_timer_table_free_locked( thr_timer_table_t*  t, thr_timer_t*  timer )
 {
-    pthread_mutex_lock( &t->lock );
     timer->id     = TIMER_ID_NONE;
-    timer->thread = 0;
     timer->next   = t->free_timer;
     t->free_timer = timer;
-    pthread_mutex_unlock( &t->lock );
 }
 
 
@@ -180,28 +179,21 @@ static void thr_timer_table_start_stop(thr_timer_table_t* t, int stop) {
     return;
   }
 
+  // The dispatcher ignores every timer while the table is stopped.
   pthread_mutex_lock(&t->lock);
-  for (int nn = 0; nn < MAX_THREAD_TIMERS; ++nn) {
-    thr_timer_t*  timer  = &t->timers[nn];
-    if (TIMER_ID_IS_VALID(timer->id)) {
-      // Tell the thread to start/stop.
-      pthread_mutex_lock(&timer->mutex);
-      timer->stopped = stop;
-      pthread_cond_signal( &timer->cond );
-      pthread_mutex_unlock(&timer->mutex);
-    }
-  }
+  t->stopped = stop;
+  pthread_cond_signal(&t->dispatcher_cond);
   pthread_mutex_unlock(&t->lock);
 }
 
 
 /* convert a timer_id into the corresponding thr_timer_t* pointer
- * returns NULL if the id is not wrapped or is invalid/free
+ * returns NULL if the id is not wrapped or is invalid/free.
+ * Called with the table lock held.
  */
 static thr_timer_t*
-thr_timer_table_from_id( thr_timer_table_t*  t,
-                         timer_t             id,
-                         int                 remove )
+thr_timer_table_from_id_locked( thr_timer_table_t*  t,
+                                timer_t             id )
 {
     unsigned      index;
     thr_timer_t*  timer;
@@ -213,20 +205,9 @@ thr_timer_table_from_id( thr_timer_table_t*  t,
     if (index >= MAX_THREAD_TIMERS)
         return NULL;
 
-    pthread_mutex_lock(&t->lock);
-
     timer = &t->timers[index];
-
-    if (!TIMER_ID_IS_VALID(timer->id)) {
-        timer = NULL;
-    } else {
-        /* if we're removing this timer, clear the id
-         * right now to prevent another thread to
-         * use the same id after the unlock */
-        if (remove)
-            timer->id = TIMER_ID_NONE;
-    }
-    pthread_mutex_unlock(&t->lock);
+    if (!TIMER_ID_IS_VALID(timer->id))
+        return NULL;
 
     return timer;
 }
@@ -263,29 +244,39 @@ __LIBC_HIDDEN__ void __timer_table_start_stop(int stop) {
   thr_timer_table_start_stop(__timer_table, stop);
 }
 
-static thr_timer_t*
-thr_timer_from_id( timer_t   id )
-{
-    thr_timer_table_t*  table = __timer_table_get();
-    thr_timer_t*        timer = thr_timer_table_from_id( table, id, 0 );
-
-    return timer;
-}
-
+/* In a fork child, the dispatcher and callback threads are gone. Disarm
+ * every timer, and start the threads again when they're next needed.
+ */
+__LIBC_HIDDEN__ void __timer_table_after_fork_child(void) {
+  thr_timer_table_t* t = __timer_table;
+  int nn;
 
-static __inline__ void
-thr_timer_lock( thr_timer_t*  t )
-{
-    pthread_mutex_lock(&t->mutex);
-}
+  if (t == NULL) {
+    return;
+  }
 
-static __inline__ void
-thr_timer_unlock( thr_timer_t*  t )
-{
-    pthread_mutex_unlock(&t->mutex);
+  pthread_mutex_init(&t->lock, NULL);
+  pthread_cond_init(&t->dispatcher_cond, NULL);
+  pthread_cond_init(&t->worker_cond, NULL);
+  t->dispatcher_started = 0;
+  t->workers = 0;
+  t->idle_workers = 0;
+  t->queue_head = t->queue_tail = NULL;
+  t->stopped = 0;
+
+  for (nn = 0; nn < MAX_THREAD_TIMERS; nn++) {
+    thr_timer_t* timer = &t->timers[nn];
+    if (timer->done && (timer->queued || timer->running)) {
+      // timer_delete() left this to a callback thread that no longer exists.
+      thr_timer_table_free_locked(t, timer);
+    }
+    timer->queued = timer->running = 0;
+    timer->expires.tv_sec = timer->expires.tv_nsec = 0;
+    timer->period.tv_sec = timer->period.tv_nsec = 0;
+    timer->overruns = 0;
+  }
 }
 
-
 static __inline__ void timespec_add(struct timespec* a, const struct timespec* b) {
   a->tv_sec  += b->tv_sec;
   a->tv_nsec += b->tv_nsec;
@@ -336,7 +327,32 @@ extern int __timer_gettime(timer_t, struct itimerspec*);
 extern int __timer_settime(timer_t, int, const struct itimerspec*, struct itimerspec*);
 extern int __timer_getoverrun(timer_t);
 
-static void* timer_thread_start(void*);
+static void* timer_dispatcher_start(void*);
+static void* timer_worker_start(void*);
+
+/* Start a detached helper thread. Called with the table lock held. */
+static int timer_start_thread(void* (*fn)(void*), thr_timer_table_t* t) {
+  pthread_attr_t attr;
+  pthread_t thread;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  return pthread_create(&thread, &attr, fn, t);
+}
+
+/* Start the dispatcher if it isn't running: it's shared by all timers, so the
+ * first timer_create starts it, and the first timer armed after a fork starts it
+ * again. Called with the table lock held. */
+static int timer_start_dispatcher_locked(thr_timer_table_t* t) {
+  if (!t->dispatcher_started) {
+    int rc = timer_start_thread(timer_dispatcher_start, t);
+    if (rc != 0) {
+      return rc;
+    }
+    t->dispatcher_started = 1;
+  }
+  return 0;
+}
 
 int timer_create(clockid_t clock_id, struct sigevent* evp, timer_t* timer_id) {
   // If not a SIGEV_THREAD timer, the kernel can handle it without our help.
@@ -356,49 +372,43 @@ int timer_create(clockid_t clock_id, struct sigevent* evp, timer_t* timer_id) {
     return -1;
   }
 
-  // Create a new timer and its thread.
-  // TODO: use a single global thread for all timers.
   thr_timer_table_t* table = __timer_table_get();
-  thr_timer_t* timer = thr_timer_table_alloc(table);
-  if (timer == NULL) {
+  if (table == NULL) {
     errno = ENOMEM;
     return -1;
   }
 
-  // Copy the thread attributes.
-  if (evp->sigev_notify_attributes == NULL) {
-    pthread_attr_init(&timer->attributes);
-  } else {
-    timer->attributes = ((pthread_attr_t*) evp->sigev_notify_attributes)[0];
+  pthread_mutex_lock(&table->lock);
+
+  int rc = timer_start_dispatcher_locked(table);
+  if (rc != 0) {
+    pthread_mutex_unlock(&table->lock);
+    errno = rc;
+    return -1;
   }
 
-  // Posix says that the default is PTHREAD_CREATE_DETACHED and
-  // that PTHREAD_CREATE_JOINABLE has undefined behavior.
-  // So simply always use DETACHED :-)
-  pthread_attr_setdetachstate(&timer->attributes, PTHREAD_CREATE_DETACHED);
+  thr_timer_t* timer = thr_timer_table_alloc_locked(table);
+  if (timer == NULL) {
+    pthread_mutex_unlock(&table->lock);
+    errno = ENOMEM;
+    return -1;
+  }
 
+  // Callbacks run on shared threads, so sigev_notify_attributes isn't
+  // used. Posix makes PTHREAD_CREATE_JOINABLE undefined there anyway.
   timer->callback = evp->sigev_notify_function;
   timer->value = evp->sigev_value;
   timer->clock = clock_id;
 
-  pthread_mutex_init(&timer->mutex, NULL);
-  pthread_cond_init(&timer->cond, NULL);
-
   timer->done = 0;
-  timer->stopped = 0;
+  timer->queued = 0;
+  timer->running = 0;
   timer->expires.tv_sec = timer->expires.tv_nsec = 0;
   timer->period.tv_sec = timer->period.tv_nsec  = 0;
   timer->overruns = 0;
 
-  // Create the thread.
-  int rc = pthread_create(&timer->thread, &timer->attributes, timer_thread_start, timer);
-  if (rc != 0) {
-    thr_timer_table_free(table, timer);
-    errno = rc;
-    return -1;
-  }
-
   *timer_id = timer->id;
+  pthread_mutex_unlock(&table->lock);
   return 0;
 }
 
@@ -411,24 +421,26 @@ timer_delete( timer_t  id )
     else
     {
         thr_timer_table_t*  table = __timer_table_get();
-        thr_timer_t*        timer = thr_timer_table_from_id(table, id, 1);
+        thr_timer_t*        timer;
 
+        pthread_mutex_lock(&table->lock);
+        timer = thr_timer_table_from_id_locked(table, id);
         if (timer == NULL) {
+            pthread_mutex_unlock(&table->lock);
             errno = EINVAL;
             return -1;
         }
 
-        /* tell the timer's thread to stop */
-        thr_timer_lock(timer);
+        /* clear the id right now so that it can't be used again. If a
+         * callback is queued or running, the callback thread frees the
+         * timer object when it's done with it. */
+        timer->id = TIMER_ID_NONE;
         timer->done = 1;
-        pthread_cond_signal( &timer->cond );
-        thr_timer_unlock(timer);
+        if (!timer->queued && !timer->running)
+            thr_timer_table_free_locked(table, timer);
 
-        /* NOTE: the thread will call __timer_table_free() to free the
-         * timer object. the '1' parameter to thr_timer_table_from_id
-         * above ensured that the object and its timer_id cannot be
-         * reused before that.
-         */
+        pthread_cond_signal(&table->dispatcher_cond);
+        pthread_mutex_unlock(&table->lock);
         return 0;
     }
 }
@@ -471,15 +483,18 @@ timer_gettime( timer_t  id, struct itimerspec*  ospec )
     if ( __predict_true(!TIMER_ID_IS_WRAPPED(id)) ) {
         return __timer_gettime( id, ospec );
     } else {
-        thr_timer_t*  timer = thr_timer_from_id(id);
+        thr_timer_table_t*  table = __timer_table_get();
+        thr_timer_t*        timer;
 
+        pthread_mutex_lock(&table->lock);
+        timer = thr_timer_table_from_id_locked(table, id);
         if (timer == NULL) {
+            pthread_mutex_unlock(&table->lock);
             errno = EINVAL;
             return -1;
         }
-        thr_timer_lock(timer);
         timer_gettime_internal( timer, ospec );
-        thr_timer_unlock(timer);
+        pthread_mutex_unlock(&table->lock);
     }
     return 0;
 }
@@ -499,14 +514,17 @@ timer_settime( timer_t                   id,
     if ( __predict_true(!TIMER_ID_IS_WRAPPED(id)) ) {
         return __timer_settime( id, flags, spec, ospec );
     } else {
-        thr_timer_t*        timer = thr_timer_from_id(id);
+        thr_timer_table_t*  table = __timer_table_get();
+        thr_timer_t*        timer;
         struct timespec     expires, now;
 
+        pthread_mutex_lock(&table->lock);
+        timer = thr_timer_table_from_id_locked(table, id);
         if (timer == NULL) {
+            pthread_mutex_unlock(&table->lock);
             errno = EINVAL;
             return -1;
         }
-        thr_timer_lock(timer);
 
         /* return current timer value if ospec isn't NULL */
         if (ospec != NULL) {
@@ -518,6 +536,13 @@ timer_settime( timer_t                   id,
          */
         expires = spec->it_value;
         if (!timespec_is_zero(&expires)) {
+            /* a fork child has no dispatcher until a timer needs one */
+            int rc = timer_start_dispatcher_locked(table);
+            if (rc != 0) {
+                pthread_mutex_unlock(&table->lock);
+                errno = rc;
+                return -1;
+            }
             clock_gettime( timer->clock, &now );
             if (!(flags & TIMER_ABSTIME)) {
                 timespec_add(&expires, &now);
@@ -528,10 +553,10 @@ timer_settime( timer_t                   id,
         }
         timer->expires = expires;
         timer->period  = spec->it_interval;
-        thr_timer_unlock( timer );
 
-        /* signal the change to the thread */
-        pthread_cond_signal( &timer->cond );
+        /* signal the change to the dispatcher */
+        pthread_cond_signal(&table->dispatcher_cond);
+        pthread_mutex_unlock(&table->lock);
     }
     return 0;
 }
@@ -543,110 +568,172 @@ timer_getoverrun(timer_t  id)
     if ( __predict_true(!TIMER_ID_IS_WRAPPED(id)) ) {
         return __timer_getoverrun( id );
     } else {
-        thr_timer_t*  timer = thr_timer_from_id(id);
-        int           result;
+        thr_timer_table_t*  table = __timer_table_get();
+        thr_timer_t*        timer;
+        int                 result;
 
+        pthread_mutex_lock(&table->lock);
+        timer = thr_timer_table_from_id_locked(table, id);
         if (timer == NULL) {
+            pthread_mutex_unlock(&table->lock);
             errno = EINVAL;
             return -1;
         }
-
-        thr_timer_lock(timer);
         result = timer->overruns;
-        thr_timer_unlock(timer);
+        pthread_mutex_unlock(&table->lock);
 
         return result;
     }
 }
 
 
-static void* timer_thread_start(void* arg) {
-  thr_timer_t* timer = arg;
+/* Handle the expiration of 'timer' at time 'now': reload or disarm it,
+ * and hand it to a callback thread. Called with the table lock held.
+ */
+static void timer_expire_locked(thr_timer_table_t* t, thr_timer_t* timer,
+                                const struct timespec* now) {
+  struct timespec expires = timer->expires;
+  struct timespec period = timer->period;
+  int overruns = 0;
+
+  if (!timespec_is_zero(&period)) {
+    // For periodic timers, count the periods we missed entirely.
+    do {
+      timespec_add(&expires, &period);
+      if (timespec_cmp(&expires, now) <= 0 && overruns < DELAYTIMER_MAX) {
+        overruns += 1;
+      }
+    } while (timespec_cmp(&expires, now) <= 0);
+  } else {
+    timespec_zero(&expires);
+  }
+  timer->expires = expires;
 
-  thr_timer_lock(timer);
+  // If the last expiration's callback hasn't started or finished yet, this
+  // one only counts as an overrun.
+  if (timer->queued || timer->running) {
+    overruns += 1;
+  }
+  if (timer->overruns < DELAYTIMER_MAX - overruns) {
+    timer->overruns += overruns;
+  } else {
+    timer->overruns = DELAYTIMER_MAX;
+  }
+  if (timer->queued || timer->running) {
+    return;
+  }
 
-  // Give this thread a meaningful name.
-  char name[32];
-  snprintf(name, sizeof(name), "POSIX interval timer 0x%08x", timer->id);
-  pthread_setname_np(pthread_self(), name);
+  timer->queued = 1;
+  timer->next = NULL;
+  if (t->queue_tail != NULL) {
+    t->queue_tail->next = timer;
+  } else {
+    t->queue_head = timer;
+  }
+  t->queue_tail = timer;
+
+  // Wake an idle callback thread, or start another if there's room.
+  if (t->idle_workers > 0) {
+    pthread_cond_signal(&t->worker_cond);
+  } else if (t->workers < MAX_TIMER_WORKERS &&
+             timer_start_thread(timer_worker_start, t) == 0) {
+    t->workers += 1;
+  }
+}
 
-  // We loop until timer->done is set in timer_delete().
-  while (!timer->done) {
-    struct timespec expires = timer->expires;
-    struct timespec period = timer->period;
 
-    // If the timer is stopped or disarmed, wait indefinitely
-    // for a state change from timer_settime/_delete/_start_stop.
-    if (timer->stopped || timespec_is_zero(&expires)) {
-      pthread_cond_wait(&timer->cond, &timer->mutex);
-      continue;
-    }
-
-    // Otherwise, we need to do a timed wait until either a
-    // state change of the timer expiration time.
-    struct timespec now;
-    clock_gettime(timer->clock, &now);
+static void* timer_dispatcher_start(void* arg) {
+  thr_timer_table_t* t = arg;
 
-    if (timespec_cmp(&expires, &now) > 0) {
-      // Cool, there was no overrun, so compute the
-      // relative timeout as 'expires - now', then wait.
-      struct timespec diff = expires;
-      timespec_sub(&diff, &now);
+  pthread_setname_np(pthread_self(), "POSIX timers");
 
-      int ret = __pthread_cond_timedwait_relative(&timer->cond, &timer->mutex, &diff);
+  pthread_mutex_lock(&t->lock);
+  for (;;) {
+    struct timespec next;
+    int nn, armed = 0;
+
+    // Fire whatever has expired, and find out how long until the next
+    // expiration. Timers can use different clocks, so this is relative.
+    if (!t->stopped) {
+      for (nn = 0; nn < MAX_THREAD_TIMERS; ++nn) {
+        thr_timer_t* timer = &t->timers[nn];
+        struct timespec now, diff;
+
+        if (!TIMER_ID_IS_VALID(timer->id) || timespec_is_zero(&timer->expires)) {
+          continue;
+        }
 
-      // If we didn't time out, it means that a state change
-      // occurred, so loop to take care of it.
-      if (ret != ETIMEDOUT) {
-        continue;
-      }
-    } else {
-      // Overrun was detected before we could wait!
-      if (!timespec_is_zero(&period)) {
-        // For periodic timers, compute total overrun count.
-        do {
-          timespec_add(&expires, &period);
-          if (timer->overruns < DELAYTIMER_MAX) {
-            timer->overruns += 1;
+        clock_gettime(timer->clock, &now);
+        if (timespec_cmp(&timer->expires, &now) <= 0) {
+          timer_expire_locked(t, timer, &now);
+          if (timespec_is_zero(&timer->expires)) {
+            continue;
           }
-        } while (timespec_cmp(&expires, &now) < 0);
-
-        // Backtrack the last one, because we're going to
-        // add the same value just a bit later.
-        timespec_sub(&expires, &period);
-      } else {
-        // For non-periodic timers, things are simple.
-        timer->overruns = 1;
+        }
+
+        diff = timer->expires;
+        timespec_sub(&diff, &now);
+        if (!armed || timespec_cmp(&diff, &next) < 0) {
+          next = diff;
+          armed = 1;
+        }
       }
     }
 
-    // If we get here, a timeout was detected.
-    // First reload/disarm the timer as needed.
-    if (!timespec_is_zero(&period)) {
-      timespec_add(&expires, &period);
+    // Wait for the next expiration, or for timer_settime/_delete/_start_stop.
+    if (armed) {
+      __pthread_cond_timedwait_relative(&t->dispatcher_cond, &t->lock, &next);
     } else {
-      timespec_zero(&expires);
+      pthread_cond_wait(&t->dispatcher_cond, &t->lock);
     }
-    timer->expires = expires;
-
-    // Now call the timer callback function. Release the
-    // lock to allow the function to modify the timer setting
-    // or call timer_getoverrun().
-    // NOTE: at this point we trust the callback not to be a
-    //      total moron and pthread_kill() the timer thread
-    thr_timer_unlock(timer);
-    timer->callback(timer->value);
-    thr_timer_lock(timer);
-
-    // Now clear the overruns counter. it only makes sense
-    // within the callback.
-    timer->overruns = 0;
   }
+  /* NOTREACHED */
+  return NULL;
+}
+
 
-  thr_timer_unlock(timer);
+static void* timer_worker_start(void* arg) {
+  thr_timer_table_t* t = arg;
+
+  pthread_setname_np(pthread_self(), "POSIX timer cb");
+
+  pthread_mutex_lock(&t->lock);
+  for (;;) {
+    thr_timer_t* timer = t->queue_head;
+    if (timer == NULL) {
+      t->idle_workers += 1;
+      pthread_cond_wait(&t->worker_cond, &t->lock);
+      t->idle_workers -= 1;
+      continue;
+    }
 
-  // Free the timer object.
-  thr_timer_table_free(__timer_table_get(), timer);
+    t->queue_head = timer->next;
+    if (t->queue_head == NULL) {
+      t->queue_tail = NULL;
+    }
+    timer->queued = 0;
+
+    if (!timer->done) {
+      // Release the lock to allow the function to modify the timer
+      // setting or call timer_getoverrun().
+      // NOTE: at this point we trust the callback not to be a
+      //      total moron and pthread_kill() the timer thread
+      timer->running = 1;
+      pthread_mutex_unlock(&t->lock);
+      timer->callback(timer->value);
+      pthread_mutex_lock(&t->lock);
+      timer->running = 0;
+
+      // Now clear the overruns counter. it only makes sense
+      // within the callback.
+      timer->overruns = 0;
+    }
 
+    // Free the timer object if timer_delete() was called meanwhile.
+    if (timer->done) {
+      thr_timer_table_free_locked(t, timer);
+    }
+  }
+  /* NOTREACHED */
   return NULL;
 }
@@ -30,20 +30,31 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <sched.h>
 #include <sys/atomics.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "bionic_atomic_inline.h"
+#include "bionic_counters.h"
 #include "bionic_futex.h"
+#include "bionic_name_mem.h"
 #include "bionic_pthread.h"
 #include "bionic_tls.h"
+#include "bionic_thread_table.h"
+#include "bionic_trace.h"
 #include "pthread_internal.h"
 #include "thread_private.h"
 
 extern void pthread_debug_mutex_lock_check(pthread_mutex_t *mutex);
 extern void pthread_debug_mutex_unlock_check(pthread_mutex_t *mutex);
 
+void (*__pthread_mutex_contention_hook)(pthread_mutex_t* mutex, int64_t wait_ns) = NULL;
+int (*__pthread_mutex_contention_dumper)(int fd) = NULL;
+void (*__pthread_mutex_contention_probe)(void) = NULL;
+
 extern void _exit_with_stack_teardown(void * stackBase, int stackSize, int retCode);
 extern void _exit_thread(int  retCode);
 
@@ -82,12 +93,18 @@ void __pthread_cleanup_pop( __pthread_cleanup_t*  c, int  execute )
         c->__cleanup_routine(c->__cleanup_arg);
 }
 
+// Not in libc_nomalloc, so this is a weak reference.
+extern void __malloc_thread_cache_flush(void) __attribute__((weak));
+
 void pthread_exit(void * retval)
 {
     pthread_internal_t*  thread     = __get_thread();
     void*                stack_base = thread->attr.stack_base;
     int                  stack_size = thread->attr.stack_size;
+    size_t               guard_size = thread->attr.guard_size;
     int                  user_stack = (thread->attr.flags & PTHREAD_ATTR_FLAG_USER_STACK) != 0;
+    void*                signal_stack = thread->alternate_signal_stack;
+    pid_t                tid        = thread->tid;
     sigset_t mask;
 
     // call the cleanup handlers first
@@ -103,6 +120,15 @@ void pthread_exit(void * retval)
     // space (see pthread_key_delete)
     pthread_key_clean_all();
 
+    // Free this thread's ELF TLS blocks. Like the TLS destructors, this might free memory.
+    __elf_tls_thread_exit(thread);
+
+    // Give our cached free chunks back now that the TLS destructors, which
+    // may free memory, have run.
+    if (__malloc_thread_cache_flush != NULL) {
+        __malloc_thread_cache_flush();
+    }
+
     if (thread->alternate_signal_stack != NULL) {
       // Tell the kernel to stop using the alternate signal stack.
       stack_t ss;
@@ -110,15 +136,28 @@ void pthread_exit(void * retval)
       ss.ss_flags = SS_DISABLE;
       sigaltstack(&ss, NULL);
 
-      // Free it.
-      munmap(thread->alternate_signal_stack, SIGSTKSZ);
+      // It's freed below, unless it goes into the stack cache.
       thread->alternate_signal_stack = NULL;
     }
 
+    __libc_trace(ANDROID_TRACE_THREAD_EXIT, retval);
+    __libc_trace_thread_exit(thread);
+    __libc_counters_thread_exit(thread);
+    __arc4random_thread_exit(thread);
+    __bionic_thread_table_remove(thread);
+
     // if the thread is detached, destroy the pthread_internal_t
     // otherwise, keep it in memory and signal any joiners.
-    pthread_mutex_lock(&gThreadListLock);
+    pthread_list_shard_t* shard = __pthread_list_shard(thread);
+    pthread_mutex_lock(&shard->lock);
+    // The stack's name may point into the thread struct, which is about to
+    // go; pthread_setname_np can't rename it again once we drop the lock.
+    __pthread_name_stack(thread, NULL);
     if (thread->attr.flags & PTHREAD_ATTR_FLAG_DETACHED) {
+        /* The kernel mustn't write to the thread struct once it's freed. */
+        if (thread->internal_flags & PTHREAD_INTERNAL_FLAG_CLEARS_TID) {
+            __set_tid_address(NULL);
+        }
         _pthread_internal_remove_locked(thread);
     } else {
        /* make sure that the thread struct doesn't have stale pointers to a stack that
@@ -130,21 +169,26 @@ void pthread_exit(void * retval)
             thread->tls = NULL;
         }
 
-       /* Indicate that the thread has exited for joining threads. */
+       /* Indicate that the thread has exited. pthread_join waits for the
+        * kernel to zero our tid, which it does once we're really gone. */
         thread->attr.flags |= PTHREAD_ATTR_FLAG_ZOMBIE;
         thread->return_value = retval;
-
-       /* Signal the joining thread if present. */
-        if (thread->attr.flags & PTHREAD_ATTR_FLAG_JOINED) {
-            pthread_cond_signal(&thread->join_cond);
-        }
     }
-    pthread_mutex_unlock(&gThreadListLock);
+    pthread_mutex_unlock(&shard->lock);
 
     sigfillset(&mask);
     sigdelset(&mask, SIGSEGV);
     (void)sigprocmask(SIG_SETMASK, &mask, (sigset_t *)NULL);
 
+    // Hand our stack to the next pthread_create if there's room in the cache. It
+    // won't be reused until the kernel reports that we're gone.
+    if (!user_stack &&
+        __thread_stack_cache_put(stack_base, stack_size, guard_size, tid, signal_stack))
+        _exit_thread((int)retval);
+
+    if (signal_stack != NULL)
+        munmap(signal_stack, SIGSTKSZ);
+
     // destroy the thread stack
     if (user_stack)
         _exit_thread((int)retval);
@@ -238,7 +282,8 @@ void pthread_exit(void * retval)
 
 /* Mutex type:
  *
- * We support normal, recursive and errorcheck mutexes.
+ * We support normal, recursive, errorcheck and adaptive mutexes. Adaptive
+ * mutexes are normal mutexes that spin for a while before sleeping.
  *
  * The constants defined here *cannot* be changed because they must match
  * the C library ABI which defines the following initialization values in
@@ -255,12 +300,32 @@ void pthread_exit(void * retval)
 #define  MUTEX_TYPE_NORMAL          0  /* Must be 0 to match __PTHREAD_MUTEX_INIT_VALUE */
 #define  MUTEX_TYPE_RECURSIVE       1
 #define  MUTEX_TYPE_ERRORCHECK      2
+#define  MUTEX_TYPE_ADAPTIVE        3
 
 #define  MUTEX_TYPE_TO_BITS(t)       FIELD_TO_BITS(t, MUTEX_TYPE_SHIFT, MUTEX_TYPE_LEN)
 
 #define  MUTEX_TYPE_BITS_NORMAL      MUTEX_TYPE_TO_BITS(MUTEX_TYPE_NORMAL)
 #define  MUTEX_TYPE_BITS_RECURSIVE   MUTEX_TYPE_TO_BITS(MUTEX_TYPE_RECURSIVE)
 #define  MUTEX_TYPE_BITS_ERRORCHECK  MUTEX_TYPE_TO_BITS(MUTEX_TYPE_ERRORCHECK)
+#define  MUTEX_TYPE_BITS_ADAPTIVE    MUTEX_TYPE_TO_BITS(MUTEX_TYPE_ADAPTIVE)
+
+/* Normal and adaptive mutexes have no owner and no counter, so they share
+ * the simple lock and unlock paths. */
+#define  MUTEX_TYPE_BITS_IS_SIMPLE(t)  ((t) == MUTEX_TYPE_BITS_NORMAL || (t) == MUTEX_TYPE_BITS_ADAPTIVE)
+
+/* How many times an adaptive mutex polls a held lock before sleeping.
+ * Critical sections are usually far shorter than the cost of a futex wait
+ * and the context switch that follows. */
+#define  MUTEX_ADAPTIVE_SPINS  100
+
+/* Tell the CPU we're in a spin loop. */
+#if defined(__arm__) && __ARM_ARCH__ >= 7
+#  define  __cpu_relax()  __asm__ __volatile__("yield" ::: "memory")
+#elif defined(__i386__) || defined(__x86_64__)
+#  define  __cpu_relax()  __asm__ __volatile__("pause" ::: "memory")
+#else
+#  define  __cpu_relax()  __asm__ __volatile__("" ::: "memory")
+#endif
 
 /* Mutex owner field:
  *
@@ -296,6 +361,21 @@ void pthread_exit(void * retval)
 #define  MUTEX_OWNER_FROM_BITS(v)    FIELD_FROM_BITS(v,MUTEX_OWNER_SHIFT,MUTEX_OWNER_LEN)
 #define  MUTEX_OWNER_TO_BITS(v)      FIELD_TO_BITS(v,MUTEX_OWNER_SHIFT,MUTEX_OWNER_LEN)
 
+/* Priority-inheritance mutexes:
+ *
+ * FUTEX_LOCK_PI needs a futex word that holds nothing but the owner's
+ * tid, which leaves no room for our type bits. A PI mutex therefore
+ * keeps its futex word in a separate table, and the mutex value holds
+ * the errorcheck type with every counter bit set (a combination a real
+ * errorcheck mutex never has) and the table index in the owner field.
+ *
+ * The mutex value itself never changes between init and destroy.
+ */
+#define  MUTEX_PI_BITS               (MUTEX_TYPE_BITS_ERRORCHECK | MUTEX_COUNTER_MASK)
+#define  MUTEX_IS_PI(v)              (((v) & (MUTEX_TYPE_MASK | MUTEX_COUNTER_MASK)) == MUTEX_PI_BITS)
+#define  MUTEX_PI_INDEX_FROM_BITS(v) MUTEX_OWNER_FROM_BITS(v)
+#define  MUTEX_PI_INDEX_TO_BITS(i)   MUTEX_OWNER_TO_BITS(i)
+
 /* Convenience macros.
  *
  * These are used to form or modify the bit pattern of a given mutex value
@@ -308,9 +388,12 @@ void pthread_exit(void * retval)
  * bits:     name       description
  * 0-3       type       type of mutex
  * 4         shared     process-shared flag
+ * 5-6       protocol   PTHREAD_PRIO_NONE or PTHREAD_PRIO_INHERIT
  */
-#define  MUTEXATTR_TYPE_MASK   0x000f
-#define  MUTEXATTR_SHARED_MASK 0x0010
+#define  MUTEXATTR_TYPE_MASK      0x000f
+#define  MUTEXATTR_SHARED_MASK    0x0010
+#define  MUTEXATTR_PROTOCOL_SHIFT 5
+#define  MUTEXATTR_PROTOCOL_MASK  0x0060
 
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
@@ -339,7 +422,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type)
         int  atype = (*attr & MUTEXATTR_TYPE_MASK);
 
          if (atype >= PTHREAD_MUTEX_NORMAL &&
-             atype <= PTHREAD_MUTEX_ERRORCHECK) {
+             atype <= PTHREAD_MUTEX_ADAPTIVE_NP) {
             *type = atype;
             return 0;
         }
@@ -350,7 +433,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type)
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
     if (attr && type >= PTHREAD_MUTEX_NORMAL &&
-                type <= PTHREAD_MUTEX_ERRORCHECK ) {
+                type <= PTHREAD_MUTEX_ADAPTIVE_NP ) {
         *attr = (*attr & ~MUTEXATTR_TYPE_MASK) | type;
         return 0;
     }
@@ -391,6 +474,152 @@ int pthread_mutexattr_getpshared(pthread_mutexattr_t *attr, int *pshared)
     return 0;
 }
 
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t *attr, int protocol)
+{
+    if (!attr)
+        return EINVAL;
+
+    switch (protocol) {
+    case PTHREAD_PRIO_NONE:
+    case PTHREAD_PRIO_INHERIT:
+        *attr = (*attr & ~MUTEXATTR_PROTOCOL_MASK) |
+                (protocol << MUTEXATTR_PROTOCOL_SHIFT);
+        return 0;
+
+    case PTHREAD_PRIO_PROTECT:
+        /* priority ceilings have no kernel support to build on */
+        return ENOTSUP;
+    }
+    return EINVAL;
+}
+
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t *attr, int *protocol)
+{
+    if (!attr || !protocol)
+        return EINVAL;
+
+    *protocol = (*attr & MUTEXATTR_PROTOCOL_MASK) >> MUTEXATTR_PROTOCOL_SHIFT;
+    return 0;
+}
+
+/* The table of PI futex words. It grows one page at a time, up to the
+ * number of indices that fit in the mutex owner field. A free slot holds
+ * the index of the next free slot.
+ */
+#define  PI_TABLE_PAGE_SLOTS  (PAGE_SIZE / sizeof(int))
+#define  PI_TABLE_MAX_SLOTS   (1 << MUTEX_OWNER_LEN)
+#define  PI_TABLE_MAX_PAGES   (PI_TABLE_MAX_SLOTS / PI_TABLE_PAGE_SLOTS)
+
+static int volatile*   gPiTablePages[PI_TABLE_MAX_PAGES];
+static int             gPiTableFree = -1;
+static int             gPiTableUsed;
+static pthread_mutex_t gPiTableLock = PTHREAD_MUTEX_INITIALIZER;
+
+static __inline__ int volatile*
+_pi_futex(int mvalue)
+{
+    int index = MUTEX_PI_INDEX_FROM_BITS(mvalue);
+    return &gPiTablePages[index / PI_TABLE_PAGE_SLOTS][index % PI_TABLE_PAGE_SLOTS];
+}
+
+/* Returns a cleared table slot, or -1 if the table is full. */
+static int
+_pi_table_alloc(void)
+{
+    int index;
+
+    pthread_mutex_lock(&gPiTableLock);
+    index = gPiTableFree;
+    if (index >= 0) {
+        gPiTableFree = *_pi_futex(MUTEX_PI_INDEX_TO_BITS(index));
+    } else if (gPiTableUsed < PI_TABLE_MAX_SLOTS) {
+        int page = gPiTableUsed / PI_TABLE_PAGE_SLOTS;
+        if (gPiTablePages[page] == NULL) {
+            void* p = mmap(NULL, PAGE_SIZE, PROT_READ|PROT_WRITE,
+                           MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+            if (p != MAP_FAILED) {
+                __bionic_name_mem(p, PAGE_SIZE, "mutex pi table");
+                gPiTablePages[page] = p;
+            }
+        }
+        if (gPiTablePages[page] != NULL) {
+            index = gPiTableUsed++;
+        }
+    }
+    if (index >= 0) {
+        *_pi_futex(MUTEX_PI_INDEX_TO_BITS(index)) = 0;
+    }
+    pthread_mutex_unlock(&gPiTableLock);
+    return index;
+}
+
+static void
+_pi_table_free(int index)
+{
+    pthread_mutex_lock(&gPiTableLock);
+    *_pi_futex(MUTEX_PI_INDEX_TO_BITS(index)) = gPiTableFree;
+    gPiTableFree = index;
+    pthread_mutex_unlock(&gPiTableLock);
+}
+
+/*
+ * Lock a PI mutex. The futex word is 0 when the mutex is free and the
+ * owner's tid otherwise, so the uncontended case is a single cmpxchg.
+ * When it's held, the kernel queues us by priority and boosts the owner
+ * until it unlocks. 'abstime' is a CLOCK_REALTIME deadline, or NULL.
+ */
+static int
+_pi_lock(int volatile* futex, const struct timespec* abstime)
+{
+    int tid = __get_thread()->tid;
+    int ret;
+
+    if (__predict_true(__bionic_cmpxchg(0, tid, futex) == 0)) {
+        ANDROID_MEMBAR_FULL();
+        return 0;
+    }
+
+    if ((*futex & FUTEX_TID_MASK) == tid)
+        return EDEADLK;
+
+    do {
+        ret = __futex_syscall4(futex, FUTEX_LOCK_PI|FUTEX_PRIVATE_FLAG, 0, abstime);
+    } while (ret == -EINTR);
+
+    if (ret == -ETIMEDOUT)
+        return EBUSY;
+    if (ret < 0)
+        return -ret;
+    ANDROID_MEMBAR_FULL();
+    return 0;
+}
+
+static int
+_pi_trylock(int volatile* futex)
+{
+    if (__bionic_cmpxchg(0, __get_thread()->tid, futex) == 0) {
+        ANDROID_MEMBAR_FULL();
+        return 0;
+    }
+    return EBUSY;
+}
+
+static int
+_pi_unlock(int volatile* futex)
+{
+    int tid = __get_thread()->tid;
+
+    if ((*futex & FUTEX_TID_MASK) != tid)
+        return EPERM;
+
+    ANDROID_MEMBAR_FULL();
+
+    /* if FUTEX_WAITERS is set, the kernel must pick the next owner */
+    if (__bionic_cmpxchg(tid, 0, futex) != 0)
+        __futex_syscall3(futex, FUTEX_UNLOCK_PI|FUTEX_PRIVATE_FLAG, 0);
+    return 0;
+}
+
 int pthread_mutex_init(pthread_mutex_t *mutex,
                        const pthread_mutexattr_t *attr)
 {
@@ -404,6 +633,25 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
         return 0;
     }
 
+    if ((*attr & MUTEXATTR_PROTOCOL_MASK) ==
+            (PTHREAD_PRIO_INHERIT << MUTEXATTR_PROTOCOL_SHIFT)) {
+        int index;
+
+        /* PI futex words live in a per-process table, and a PI mutex
+         * is always error-checking since the kernel tracks the owner. */
+        if ((*attr & MUTEXATTR_SHARED_MASK) != 0 ||
+            (*attr & MUTEXATTR_TYPE_MASK) == PTHREAD_MUTEX_RECURSIVE)
+            return ENOTSUP;
+        if ((*attr & MUTEXATTR_TYPE_MASK) > PTHREAD_MUTEX_ADAPTIVE_NP)
+            return EINVAL;
+
+        index = _pi_table_alloc();
+        if (index < 0)
+            return EAGAIN;
+        mutex->value = MUTEX_PI_BITS | MUTEX_PI_INDEX_TO_BITS(index);
+        return 0;
+    }
+
     if ((*attr & MUTEXATTR_SHARED_MASK) != 0)
         value |= MUTEX_SHARED_MASK;
 
@@ -417,6 +665,9 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
     case PTHREAD_MUTEX_ERRORCHECK:
         value |= MUTEX_TYPE_BITS_ERRORCHECK;
         break;
+    case PTHREAD_MUTEX_ADAPTIVE_NP:
+        value |= MUTEX_TYPE_BITS_ADAPTIVE;
+        break;
     default:
         return EINVAL;
     }
@@ -426,6 +677,56 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
 }
 
 
+/*
+ * Contention profiling: a thread about to sleep on a mutex calls
+ * _mutex_contention_begin(), and hands the result to _mutex_contention_end()
+ * once it owns the lock. Both are no-ops (and no clock is read) unless the
+ * profiler in pthread_debug.cpp is enabled, other than recording a trace
+ * event if tracing is on (see <android/trace_events.h>).
+ */
+static __inline__ __attribute__((always_inline)) int64_t
+_mutex_contention_begin(pthread_mutex_t* mutex)
+{
+    struct timespec ts;
+
+    __libc_trace(ANDROID_TRACE_MUTEX_WAIT, mutex);
+    __libc_counter_add(ANDROID_LIBC_COUNTER_MUTEX_WAITS, 1);
+    if (__predict_true(__pthread_mutex_contention_hook == NULL)) {
+        void (*probe)(void) = __pthread_mutex_contention_probe;
+        if (__predict_false(probe != NULL))
+            probe();
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void
+_mutex_contention_end(pthread_mutex_t* mutex, int64_t start)
+{
+    struct timespec ts;
+    void (*hook)(pthread_mutex_t*, int64_t) = __pthread_mutex_contention_hook;
+
+    if (start == 0 || hook == NULL)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    hook(mutex, (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec - start);
+}
+
+int pthread_mutex_contention_dump_np(int fd)
+{
+    int (*dumper)(int);
+    void (*probe)(void) = __pthread_mutex_contention_probe;
+
+    /* Nothing may have waited for a lock yet */
+    if (probe != NULL)
+        probe();
+    dumper = __pthread_mutex_contention_dumper;
+    if (dumper == NULL)
+        return ENOTSUP;
+    return dumper(fd);
+}
+
 /*
  * Lock a non-recursive mutex.
  *
@@ -434,16 +735,17 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
  *   1 (locked, no contention)
  *   2 (locked, contention)
  *
- * Non-recursive mutexes don't use the thread-id or counter fields, and the
- * "type" value is zero, so the only bits that will be set are the ones in
- * the lock state field.
+ * Non-recursive mutexes don't use the thread-id or counter fields, so the
+ * only bits that will change are the ones in the lock state field. 'mtype'
+ * is the type bits: zero for a normal mutex, or MUTEX_TYPE_BITS_ADAPTIVE to
+ * spin before sleeping.
  */
-static __inline__ void
-_normal_lock(pthread_mutex_t*  mutex, int shared)
+static __inline__ __attribute__((always_inline)) void
+_normal_lock(pthread_mutex_t*  mutex, int mtype, int shared)
 {
     /* convenience shortcuts */
-    const int unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-    const int locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+    const int unlocked           = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const int locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
     /*
      * The common case is an unlocked mutex, so we begin by trying to
      * change the lock's state from 0 (UNLOCKED) to 1 (LOCKED).
@@ -451,7 +753,25 @@ _normal_lock(pthread_mutex_t*  mutex, int shared)
      * If the result is nonzero, this lock is already held by another thread.
      */
     if (__bionic_cmpxchg(unlocked, locked_uncontended, &mutex->value) != 0) {
-        const int locked_contended = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+        const int locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+
+        /*
+         * An adaptive mutex first waits for the holder to finish without
+         * sleeping, reading the value and only trying the cmpxchg when the
+         * lock looks free, so as not to keep stealing the cache line.
+         */
+        if (mtype == MUTEX_TYPE_BITS_ADAPTIVE) {
+            int spins;
+            for (spins = 0; spins < MUTEX_ADAPTIVE_SPINS; spins++) {
+                __cpu_relax();
+                if (mutex->value == unlocked &&
+                    __bionic_cmpxchg(unlocked, locked_uncontended, &mutex->value) == 0) {
+                    ANDROID_MEMBAR_FULL();
+                    return;
+                }
+            }
+        }
+
         /*
          * We want to go to sleep until the mutex is available, which
          * requires promoting it to state 2 (CONTENDED). We need to
@@ -468,8 +788,35 @@ _normal_lock(pthread_mutex_t*  mutex, int shared)
          * that the mutex is in state 2 when we go to sleep on it, which
          * guarantees a wake-up call.
          */
-        while (__bionic_swap(locked_contended, &mutex->value) != unlocked)
+        if (__bionic_swap(locked_contended, &mutex->value) != unlocked) {
+            int64_t start = _mutex_contention_begin(mutex);
+            do {
+                __futex_wait_ex(&mutex->value, shared, locked_contended, 0);
+            } while (__bionic_swap(locked_contended, &mutex->value) != unlocked);
+            _mutex_contention_end(mutex, start);
+        }
+    }
+    ANDROID_MEMBAR_FULL();
+}
+
+/*
+ * Lock a non-recursive mutex, leaving it in state 2 (CONTENDED) even if
+ * nobody else wants it. Used after a condition variable wait, where other
+ * waiters may have been requeued onto the mutex futex without the mutex
+ * value showing it; the contended state makes our unlock wake them.
+ */
+static void
+_normal_lock_contended(pthread_mutex_t*  mutex, int mtype, int shared)
+{
+    const int unlocked         = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+    const int locked_contended = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+
+    if (__bionic_swap(locked_contended, &mutex->value) != unlocked) {
+        int64_t start = _mutex_contention_begin(mutex);
+        do {
             __futex_wait_ex(&mutex->value, shared, locked_contended, 0);
+        } while (__bionic_swap(locked_contended, &mutex->value) != unlocked);
+        _mutex_contention_end(mutex, start);
     }
     ANDROID_MEMBAR_FULL();
 }
@@ -478,8 +825,8 @@ _normal_lock(pthread_mutex_t*  mutex, int shared)
  * Release a non-recursive mutex.  The caller is responsible for determining
  * that we are in fact the owner of this lock.
  */
-static __inline__ void
-_normal_unlock(pthread_mutex_t*  mutex, int shared)
+static __inline__ __attribute__((always_inline)) void
+_normal_unlock(pthread_mutex_t*  mutex, int mtype, int shared)
 {
     ANDROID_MEMBAR_FULL();
 
@@ -488,7 +835,7 @@ _normal_unlock(pthread_mutex_t*  mutex, int shared)
      * to release the lock.  __bionic_atomic_dec() returns the previous value;
      * if it wasn't 1 we have to do some additional work.
      */
-    if (__bionic_atomic_dec(&mutex->value) != (shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED)) {
+    if (__bionic_atomic_dec(&mutex->value) != (mtype|shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED)) {
         /*
          * Start by releasing the lock.  The decrement changed it from
          * "contended lock" to "uncontended lock", which means we still
@@ -503,7 +850,7 @@ _normal_unlock(pthread_mutex_t*  mutex, int shared)
          * _normal_lock(), because the __futex_wait() call there will
          * return immediately if the mutex value isn't 2.
          */
-        mutex->value = shared;
+        mutex->value = mtype | shared;
 
         /*
          * Wake up one waiting thread.  We don't know which thread will be
@@ -581,6 +928,7 @@ __LIBC_HIDDEN__
 int pthread_mutex_lock_impl(pthread_mutex_t *mutex)
 {
     int mvalue, mtype, tid, shared;
+    int64_t wait_start = 0;
 
     if (__predict_false(mutex == NULL))
         return EINVAL;
@@ -591,9 +939,15 @@ int pthread_mutex_lock_impl(pthread_mutex_t *mutex)
 
     /* Handle normal case first */
     if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) ) {
-        _normal_lock(mutex, shared);
+        _normal_lock(mutex, MUTEX_TYPE_BITS_NORMAL, shared);
         return 0;
     }
+    if (mtype == MUTEX_TYPE_BITS_ADAPTIVE) {
+        _normal_lock(mutex, MUTEX_TYPE_BITS_ADAPTIVE, shared);
+        return 0;
+    }
+    if (MUTEX_IS_PI(mvalue))
+        return _pi_lock(_pi_futex(mvalue), NULL);
 
     /* Do we already own this recursive or error-check mutex ? */
     tid = __get_thread()->tid;
@@ -635,6 +989,7 @@ int pthread_mutex_lock_impl(pthread_mutex_t *mutex)
                 mvalue = mutex->value;
                 continue;
             }
+            _mutex_contention_end(mutex, wait_start);
             ANDROID_MEMBAR_FULL();
             return 0;
         }
@@ -651,6 +1006,8 @@ int pthread_mutex_lock_impl(pthread_mutex_t *mutex)
         }
 
         /* wait until the mutex is unlocked */
+        if (wait_start == 0)
+            wait_start = _mutex_contention_begin(mutex);
         __futex_wait_ex(&mutex->value, shared, mvalue, NULL);
 
         mvalue = mutex->value;
@@ -685,9 +1042,15 @@ int pthread_mutex_unlock_impl(pthread_mutex_t *mutex)
 
     /* Handle common case first */
     if (__predict_true(mtype == MUTEX_TYPE_BITS_NORMAL)) {
-        _normal_unlock(mutex, shared);
+        _normal_unlock(mutex, MUTEX_TYPE_BITS_NORMAL, shared);
+        return 0;
+    }
+    if (mtype == MUTEX_TYPE_BITS_ADAPTIVE) {
+        _normal_unlock(mutex, MUTEX_TYPE_BITS_ADAPTIVE, shared);
         return 0;
     }
+    if (MUTEX_IS_PI(mvalue))
+        return _pi_unlock(_pi_futex(mvalue));
 
     /* Do we already own this recursive or error-check mutex ? */
     tid = __get_thread()->tid;
@@ -751,10 +1114,10 @@ int pthread_mutex_trylock_impl(pthread_mutex_t *mutex)
     shared = (mvalue & MUTEX_SHARED_MASK);
 
     /* Handle common case first */
-    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) )
+    if ( __predict_true(MUTEX_TYPE_BITS_IS_SIMPLE(mtype)) )
     {
-        if (__bionic_cmpxchg(shared|MUTEX_STATE_BITS_UNLOCKED,
-                             shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED,
+        if (__bionic_cmpxchg(mtype|shared|MUTEX_STATE_BITS_UNLOCKED,
+                             mtype|shared|MUTEX_STATE_BITS_LOCKED_UNCONTENDED,
                              &mutex->value) == 0) {
             ANDROID_MEMBAR_FULL();
             return 0;
@@ -762,6 +1125,8 @@ int pthread_mutex_trylock_impl(pthread_mutex_t *mutex)
 
         return EBUSY;
     }
+    if (MUTEX_IS_PI(mvalue))
+        return _pi_trylock(_pi_futex(mvalue));
 
     /* Do we already own this recursive or error-check mutex ? */
     tid = __get_thread()->tid;
@@ -849,13 +1214,13 @@ int pthread_mutex_lock_timeout_np_impl(pthread_mutex_t *mutex, unsigned msecs)
     shared = (mvalue & MUTEX_SHARED_MASK);
 
     /* Handle common case first */
-    if ( __predict_true(mtype == MUTEX_TYPE_BITS_NORMAL) )
+    if ( __predict_true(MUTEX_TYPE_BITS_IS_SIMPLE(mtype)) )
     {
-        const int unlocked           = shared | MUTEX_STATE_BITS_UNLOCKED;
-        const int locked_uncontended = shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
-        const int locked_contended   = shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
+        const int unlocked           = mtype | shared | MUTEX_STATE_BITS_UNLOCKED;
+        const int locked_uncontended = mtype | shared | MUTEX_STATE_BITS_LOCKED_UNCONTENDED;
+        const int locked_contended   = mtype | shared | MUTEX_STATE_BITS_LOCKED_CONTENDED;
 
-        /* fast path for uncontended lock. Note: MUTEX_TYPE_BITS_NORMAL is 0 */
+        /* fast path for uncontended lock. */
         if (__bionic_cmpxchg(unlocked, locked_uncontended, &mutex->value) == 0) {
             ANDROID_MEMBAR_FULL();
             return 0;
@@ -871,6 +1236,11 @@ int pthread_mutex_lock_timeout_np_impl(pthread_mutex_t *mutex, unsigned msecs)
         ANDROID_MEMBAR_FULL();
         return 0;
     }
+    if (MUTEX_IS_PI(mvalue)) {
+        /* FUTEX_LOCK_PI takes a CLOCK_REALTIME deadline */
+        __timespec_to_relative_msec(&abstime, msecs, CLOCK_REALTIME);
+        return _pi_lock(_pi_futex(mvalue), &abstime);
+    }
 
     /* Do we already own this recursive or error-check mutex ? */
     tid = __get_thread()->tid;
@@ -968,6 +1338,9 @@ int pthread_mutex_destroy(pthread_mutex_t *mutex)
     if (ret != 0)
         return ret;
 
+    if (MUTEX_IS_PI(mutex->value))
+        _pi_table_free(MUTEX_PI_INDEX_FROM_BITS(mutex->value));
+
     mutex->value = 0xdead10cc;
     return 0;
 }
@@ -1031,6 +1404,85 @@ int pthread_condattr_destroy(pthread_condattr_t *attr)
  * XXX then the signal will be lost.
  */
 
+/* Broadcast requeues waiters onto the mutex futex instead of waking them
+ * all (FUTEX_CMP_REQUEUE), so one thread wakes and the rest follow as the
+ * mutex is handed on. The condition variable is a single word with no room
+ * for the mutex, so waiters record it in this small table, keyed by the
+ * condition variable's address. Posix requires all concurrent waiters on a
+ * condition variable to use the same mutex, so the latest entry is right
+ * whenever there are waiters to requeue. A colliding entry just means
+ * broadcast falls back to waking everyone.
+ *
+ * Only private normal and adaptive mutexes qualify: their lock path is
+ * simple enough that a requeued waiter can take them directly.
+ */
+#define COND_MUTEX_TABLE_SIZE  64
+
+typedef struct {
+    int volatile      lock;
+    pthread_cond_t*   cond;
+    pthread_mutex_t*  mutex;
+} cond_mutex_entry_t;
+
+static cond_mutex_entry_t gCondMutexTable[COND_MUTEX_TABLE_SIZE];
+
+static __inline__ cond_mutex_entry_t*
+__cond_mutex_entry(pthread_cond_t* cond)
+{
+    uint32_t h = (uint32_t)(uintptr_t) cond * 2654435761U;
+    return &gCondMutexTable[h >> 26];
+}
+
+static __inline__ int
+__cond_mutex_can_requeue(int mvalue)
+{
+    return MUTEX_TYPE_BITS_IS_SIMPLE(mvalue & MUTEX_TYPE_MASK) &&
+           (mvalue & MUTEX_SHARED_MASK) == 0;
+}
+
+static void
+__cond_mutex_entry_lock(cond_mutex_entry_t* e)
+{
+    while (__bionic_cmpxchg(0, 1, &e->lock) != 0)
+        sched_yield();
+    ANDROID_MEMBAR_FULL();
+}
+
+static void
+__cond_mutex_entry_unlock(cond_mutex_entry_t* e)
+{
+    ANDROID_MEMBAR_FULL();
+    e->lock = 0;
+}
+
+static void
+__cond_mutex_record(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    cond_mutex_entry_t* e = __cond_mutex_entry(cond);
+
+    /* avoid dirtying a shared cache line in the steady state */
+    if (e->cond == cond && e->mutex == mutex)
+        return;
+
+    __cond_mutex_entry_lock(e);
+    e->cond = cond;
+    e->mutex = mutex;
+    __cond_mutex_entry_unlock(e);
+}
+
+static pthread_mutex_t*
+__cond_mutex_lookup(pthread_cond_t* cond)
+{
+    cond_mutex_entry_t* e = __cond_mutex_entry(cond);
+    pthread_mutex_t* mutex = NULL;
+
+    __cond_mutex_entry_lock(e);
+    if (e->cond == cond)
+        mutex = e->mutex;
+    __cond_mutex_entry_unlock(e);
+    return mutex;
+}
+
 int pthread_cond_init(pthread_cond_t *cond,
                       const pthread_condattr_t *attr)
 {
@@ -1051,6 +1503,14 @@ int pthread_cond_destroy(pthread_cond_t *cond)
         return EINVAL;
 
     cond->value = 0xdeadc04d;
+
+    /* forget the mutex, so a new condition variable at this address
+     * doesn't inherit it */
+    cond_mutex_entry_t* e = __cond_mutex_entry(cond);
+    __cond_mutex_entry_lock(e);
+    if (e->cond == cond)
+        e->cond = NULL;
+    __cond_mutex_entry_unlock(e);
     return 0;
 }
 
@@ -1061,7 +1521,7 @@ int pthread_cond_destroy(pthread_cond_t *cond)
 static int
 __pthread_cond_pulse(pthread_cond_t *cond, int  counter)
 {
-    long flags;
+    long flags, newval;
 
     if (__predict_false(cond == NULL))
         return EINVAL;
@@ -1069,8 +1529,8 @@ __pthread_cond_pulse(pthread_cond_t *cond, int  counter)
     flags = (cond->value & ~COND_COUNTER_MASK);
     for (;;) {
         long oldval = cond->value;
-        long newval = ((oldval - COND_COUNTER_INCREMENT) & COND_COUNTER_MASK)
-                      | flags;
+        newval = ((oldval - COND_COUNTER_INCREMENT) & COND_COUNTER_MASK)
+                 | flags;
         if (__bionic_cmpxchg(oldval, newval, &cond->value) == 0)
             break;
     }
@@ -1087,6 +1547,17 @@ __pthread_cond_pulse(pthread_cond_t *cond, int  counter)
      */
     ANDROID_MEMBAR_FULL();
 
+    if (counter == INT_MAX && !COND_IS_SHARED(cond)) {
+        pthread_mutex_t* mutex = __cond_mutex_lookup(cond);
+
+        /* wake one waiter and move the rest to the mutex. This fails
+         * with EAGAIN if the value changed since our update above. */
+        if (mutex != NULL && __cond_mutex_can_requeue(mutex->value) &&
+            syscall(__NR_futex, &cond->value, FUTEX_CMP_REQUEUE|FUTEX_PRIVATE_FLAG,
+                    1, INT_MAX, &mutex->value, newval) >= 0)
+            return 0;
+    }
+
     __futex_wake_ex(&cond->value, COND_IS_SHARED(cond), counter);
     return 0;
 }
@@ -1112,10 +1583,25 @@ int __pthread_cond_timedwait_relative(pthread_cond_t *cond,
 {
     int  status;
     int  oldvalue = cond->value;
+    int  mvalue = mutex->value;
+    int  requeue = !COND_IS_SHARED(cond) && __cond_mutex_can_requeue(mvalue);
+
+    if (requeue)
+        __cond_mutex_record(cond, mutex);
 
     pthread_mutex_unlock(mutex);
     status = __futex_wait_ex(&cond->value, COND_IS_SHARED(cond), oldvalue, reltime);
-    pthread_mutex_lock(mutex);
+
+    if (requeue) {
+        /* we may have been requeued, and so may others */
+        _normal_lock_contended(mutex, mvalue & MUTEX_TYPE_MASK, 0);
+#ifdef PTHREAD_DEBUG
+        if (PTHREAD_DEBUG_ENABLED)
+            pthread_debug_mutex_lock_check(mutex);
+#endif
+    } else {
+        pthread_mutex_lock(mutex);
+    }
 
     if (status == (-ETIMEDOUT)) return ETIMEDOUT;
     return 0;
@@ -1183,6 +1669,156 @@ int pthread_cond_timeout_np(pthread_cond_t *cond,
 }
 
 
+/* Barriers: each arrival is a single atomic increment of 'arrived'. The
+ * last thread to arrive resets it for the next cycle, then bumps
+ * 'generation' and wakes everybody sleeping on it with one call.
+ *
+ * Posix requires exactly 'count' threads per cycle, so a thread can't
+ * arrive for the next cycle before the reset: it has to see the new
+ * generation first.
+ */
+int pthread_barrierattr_init(pthread_barrierattr_t *attr)
+{
+    if (attr == NULL)
+        return EINVAL;
+
+    *attr = PTHREAD_PROCESS_PRIVATE;
+    return 0;
+}
+
+int pthread_barrierattr_destroy(pthread_barrierattr_t *attr)
+{
+    if (attr == NULL)
+        return EINVAL;
+
+    *attr = 0xdeadba11;
+    return 0;
+}
+
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t *attr, int *pshared)
+{
+    if (attr == NULL || pshared == NULL)
+        return EINVAL;
+
+    *pshared = *attr;
+    return 0;
+}
+
+int pthread_barrierattr_setpshared(pthread_barrierattr_t *attr, int pshared)
+{
+    if (attr == NULL)
+        return EINVAL;
+
+    if (pshared != PTHREAD_PROCESS_SHARED &&
+        pshared != PTHREAD_PROCESS_PRIVATE)
+        return EINVAL;
+
+    *attr = pshared;
+    return 0;
+}
+
+int pthread_barrier_init(pthread_barrier_t *barrier,
+                         const pthread_barrierattr_t *attr,
+                         unsigned count)
+{
+    if (barrier == NULL || count == 0 || count > INT_MAX)
+        return EINVAL;
+
+    barrier->count = count;
+    barrier->arrived = 0;
+    barrier->generation = 0;
+    barrier->shared = (attr != NULL && *attr == PTHREAD_PROCESS_SHARED);
+    return 0;
+}
+
+int pthread_barrier_destroy(pthread_barrier_t *barrier)
+{
+    if (barrier == NULL)
+        return EINVAL;
+
+    if (barrier->arrived != 0)
+        return EBUSY;
+
+    barrier->count = 0;
+    return 0;
+}
+
+int pthread_barrier_wait(pthread_barrier_t *barrier)
+{
+    int generation;
+
+    if (__predict_false(barrier == NULL || barrier->count == 0))
+        return EINVAL;
+
+    generation = barrier->generation;
+    ANDROID_MEMBAR_FULL();
+
+    /* __bionic_atomic_inc returns the previous value */
+    if (__bionic_atomic_inc(&barrier->arrived) + 1 == (int) barrier->count) {
+        barrier->arrived = 0;
+        ANDROID_MEMBAR_FULL();
+        __bionic_atomic_inc(&barrier->generation);
+        __futex_wake_ex(&barrier->generation, barrier->shared, INT_MAX);
+        return PTHREAD_BARRIER_SERIAL_THREAD;
+    }
+
+    while (barrier->generation == generation)
+        __futex_wait_ex(&barrier->generation, barrier->shared, generation, NULL);
+    ANDROID_MEMBAR_FULL();
+    return 0;
+}
+
+/* Spinlocks: 0 is unlocked, 1 is locked. Waiters spin on a plain load
+ * and only retry the atomic swap once the lock looks free, so they don't
+ * bounce the cache line between each other.
+ */
+int pthread_spin_init(pthread_spinlock_t *lock, int pshared)
+{
+    if (lock == NULL)
+        return EINVAL;
+
+    /* no futex involved, so sharing needs nothing special */
+    (void) pshared;
+    *lock = 0;
+    return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t *lock)
+{
+    if (lock == NULL)
+        return EINVAL;
+
+    if (*lock != 0)
+        return EBUSY;
+    return 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t *lock)
+{
+    while (__predict_false(__bionic_swap(1, lock) != 0)) {
+        while (*lock != 0)
+            __cpu_relax();
+    }
+    ANDROID_MEMBAR_FULL();
+    return 0;
+}
+
+int pthread_spin_trylock(pthread_spinlock_t *lock)
+{
+    if (__bionic_swap(1, lock) != 0)
+        return EBUSY;
+    ANDROID_MEMBAR_FULL();
+    return 0;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t *lock)
+{
+    ANDROID_MEMBAR_FULL();
+    *lock = 0;
+    return 0;
+}
+
+
 /* NOTE: this implementation doesn't support a init function that throws a C++ exception
  *       or calls fork()
  */
@@ -1194,9 +1830,11 @@ int pthread_once( pthread_once_t*  once_control,  void (*init_routine)(void) )
      *
      *   bit 0 set  -> initialization is under way
      *   bit 1 set  -> initialization is complete
+     *   bit 2 set  -> other threads are waiting for the initialization
      */
 #define ONCE_INITIALIZING           (1 << 0)
 #define ONCE_COMPLETED              (1 << 1)
+#define ONCE_WAITERS                (1 << 2)
 
     /* First check if the once is already initialized. This will be the common
     * case and we want to make this as fast as possible. Note that this still
@@ -1205,7 +1843,7 @@ int pthread_once( pthread_once_t*  once_control,  void (*init_routine)(void) )
     * this CPU after we exit.
     */
     if (__predict_true((*ocptr & ONCE_COMPLETED) != 0)) {
-        ANDROID_MEMBAR_FULL();
+        ANDROID_MEMBAR_ACQ_REL();
         return 0;
     }
 
@@ -1227,7 +1865,7 @@ int pthread_once( pthread_once_t*  once_control,  void (*init_routine)(void) )
 
         if ((oldval & ONCE_COMPLETED) != 0) {
             /* We detected that COMPLETED was set while in our loop */
-            ANDROID_MEMBAR_FULL();
+            ANDROID_MEMBAR_ACQ_REL();
             return 0;
         }
 
@@ -1238,19 +1876,26 @@ int pthread_once( pthread_once_t*  once_control,  void (*init_routine)(void) )
         }
 
         /* Another thread is running the initialization and hasn't completed
-         * yet, so wait for it, then try again. */
-        __futex_wait_ex(ocptr, 0, oldval, NULL);
+         * yet. Tell it we're waiting, so that it knows it has to wake us
+         * up, then wait and try again. */
+        newval = oldval | ONCE_WAITERS;
+        if (newval != oldval && __bionic_cmpxchg(oldval, newval, ocptr) != 0)
+            continue;
+
+        __futex_wait_ex(ocptr, 0, newval, NULL);
     }
 
     /* call the initialization function. */
     (*init_routine)();
 
-    /* Do a store_release indicating that initialization is complete */
-    ANDROID_MEMBAR_FULL();
-    *ocptr = ONCE_COMPLETED;
-
-    /* Wake up any waiters, if any */
-    __futex_wake_ex(ocptr, 0, INT_MAX);
+    /* Do a store_release indicating that initialization is complete.
+     * This has to be a swap, to see whether anyone set ONCE_WAITERS
+     * in the meantime. */
+    ANDROID_MEMBAR_ACQ_REL();
+    if ((__bionic_swap(ONCE_COMPLETED, ocptr) & ONCE_WAITERS) != 0) {
+        /* Wake up the waiters; nobody else enters the kernel. */
+        __futex_wake_ex(ocptr, 0, INT_MAX);
+    }
 
     return 0;
 }
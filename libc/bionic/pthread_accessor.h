@@ -23,9 +23,10 @@
 
 class pthread_accessor {
  public:
-  explicit pthread_accessor(pthread_t desired_thread) {
+  explicit pthread_accessor(pthread_t desired_thread)
+      : shard_(__pthread_list_shard(reinterpret_cast<pthread_internal_t*>(desired_thread))) {
     Lock();
-    for (thread_ = gThreadList; thread_ != NULL; thread_ = thread_->next) {
+    for (thread_ = shard_->head; thread_ != NULL; thread_ = thread_->next) {
       if (thread_ == reinterpret_cast<pthread_internal_t*>(desired_thread)) {
         break;
       }
@@ -40,20 +41,24 @@ class pthread_accessor {
     if (is_locked_) {
       is_locked_ = false;
       thread_ = NULL;
-      pthread_mutex_unlock(&gThreadListLock);
+      pthread_mutex_unlock(&shard_->lock);
     }
   }
 
+  // The lock protecting the thread, held while this accessor is.
+  pthread_mutex_t* lock() const { return &shard_->lock; }
+
   pthread_internal_t& operator*() const { return *thread_; }
   pthread_internal_t* operator->() const { return thread_; }
   pthread_internal_t* get() const { return thread_; }
 
  private:
+  pthread_list_shard_t* shard_;
   pthread_internal_t* thread_;
   bool is_locked_;
 
   void Lock() {
-    pthread_mutex_lock(&gThreadListLock);
+    pthread_mutex_lock(&shard_->lock);
     is_locked_ = true;
   }
 
@@ -29,18 +29,24 @@
 #include <pthread.h>
 
 #include <errno.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include "pthread_internal.h"
 
+#include "private/bionic_hugepage.h"
+#include "private/bionic_name_mem.h"
 #include "private/bionic_ssp.h"
 #include "private/bionic_tls.h"
+#include "private/bionic_trace.h"
 #include "private/libc_logging.h"
 #include "private/thread_private.h"
 #include "private/ErrnoRestorer.h"
 #include "private/ScopedPthreadMutexLocker.h"
 
 extern "C" int __pthread_clone(void* (*fn)(void*), void* child_stack, int flags, void* arg);
+extern "C" int tgkill(int tgid, int tid, int sig);
 
 #ifdef __i386__
 #define ATTRIBUTES __attribute__((noinline)) __attribute__((fastcall))
@@ -52,8 +58,6 @@ extern "C" void ATTRIBUTES _thread_created_hook(pid_t thread_id);
 
 static const int kPthreadInitFailed = 1;
 
-static pthread_mutex_t gPthreadStackCreationLock = PTHREAD_MUTEX_INITIALIZER;
-
 static pthread_mutex_t gDebuggerNotificationLock = PTHREAD_MUTEX_INITIALIZER;
 
 void  __init_tls(pthread_internal_t* thread) {
@@ -72,8 +76,15 @@ void  __init_tls(pthread_internal_t* thread) {
 
   // Create and set an alternate signal stack.
   // This must happen after __set_tls, in case a system call fails and tries to set errno.
+  // A thread reusing a cached stack may already have one.
   stack_t ss;
-  ss.ss_sp = mmap(NULL, SIGSTKSZ, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
+  ss.ss_sp = thread->alternate_signal_stack;
+  if (ss.ss_sp == NULL) {
+    ss.ss_sp = mmap(NULL, SIGSTKSZ, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
+    if (ss.ss_sp != MAP_FAILED) {
+      __bionic_name_mem(ss.ss_sp, SIGSTKSZ, "thread signal stack");
+    }
+  }
   if (ss.ss_sp != MAP_FAILED) {
     ss.ss_size = SIGSTKSZ;
     ss.ss_flags = 0;
@@ -98,6 +109,15 @@ extern "C" void __thread_entry(void* (*func)(void*), void* arg, void** tls) {
   thread->tls = tls;
   __init_tls(thread);
 
+  // Have the kernel zero our tid and wake anyone in pthread_join once we've
+  // really gone, which is CLONE_CHILD_CLEARTID without having to change every
+  // architecture's __pthread_clone. Our creator has stored our tid by now, so
+  // it can't overwrite the zero. Nobody can join a thread created detached.
+  if ((thread->attr.flags & PTHREAD_ATTR_FLAG_DETACHED) == 0) {
+    __set_tid_address(&thread->tid);
+    thread->internal_flags |= PTHREAD_INTERNAL_FLAG_CLEARS_TID;
+  }
+
   if ((thread->internal_flags & kPthreadInitFailed) != 0) {
     pthread_exit(NULL);
   }
@@ -122,7 +142,6 @@ int _init_thread(pthread_internal_t* thread, bool add_to_thread_list) {
     }
   }
 
-  pthread_cond_init(&thread->join_cond, NULL);
   thread->cleanup_stack = NULL;
 
   if (add_to_thread_list) {
@@ -132,13 +151,79 @@ int _init_thread(pthread_internal_t* thread, bool add_to_thread_list) {
   return error;
 }
 
+// A small cache of the stacks of exited threads, along with their guard regions and
+// alternate signal stacks, so that short-lived threads don't pay for mmap, mprotect and
+// munmap (twice over) every time.
+//
+// An exiting thread offers its stack while it's still running on it, so a cached stack
+// can't be reused until the kernel says its thread is gone. Slots are claimed with a
+// cmpxchg on their state, so there's no lock to contend on or to be left held by fork.
+struct thread_stack_cache_slot_t {
+  volatile int state;
+  void* base;
+  size_t size;
+  size_t guard_size;
+  pid_t tid;
+  void* signal_stack;
+};
+
+enum { kStackSlotEmpty, kStackSlotBusy, kStackSlotFull };
+
+static const size_t kStackCacheSlots = 8;
+static thread_stack_cache_slot_t gStackCache[kStackCacheSlots];
+
+bool __thread_stack_cache_put(void* base, size_t size, size_t guard_size, pid_t tid,
+                              void* signal_stack) {
+  for (size_t i = 0; i < kStackCacheSlots; ++i) {
+    thread_stack_cache_slot_t* slot = &gStackCache[i];
+    if (slot->state == kStackSlotEmpty &&
+        __sync_bool_compare_and_swap(&slot->state, kStackSlotEmpty, kStackSlotBusy)) {
+      slot->base = base;
+      slot->size = size;
+      slot->guard_size = guard_size;
+      slot->tid = tid;
+      slot->signal_stack = signal_stack;
+      __sync_synchronize();
+      slot->state = kStackSlotFull;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void* __thread_stack_cache_get(pthread_internal_t* thread) {
+  for (size_t i = 0; i < kStackCacheSlots; ++i) {
+    thread_stack_cache_slot_t* slot = &gStackCache[i];
+    if (slot->state != kStackSlotFull ||
+        !__sync_bool_compare_and_swap(&slot->state, kStackSlotFull, kStackSlotBusy)) {
+      continue;
+    }
+    if (slot->size == thread->attr.stack_size && slot->guard_size == thread->attr.guard_size &&
+        (slot->tid == 0 || (tgkill(getpid(), slot->tid, 0) == -1 && errno == ESRCH))) {
+      void* stack = slot->base;
+      thread->alternate_signal_stack = slot->signal_stack;
+      __sync_synchronize();
+      slot->state = kStackSlotEmpty;
+      return stack;
+    }
+    // Wrong size, or its thread hasn't quite finished exiting yet.
+    slot->state = kStackSlotFull;
+  }
+  return NULL;
+}
+
 static void* __create_thread_stack(pthread_internal_t* thread) {
-  ScopedPthreadMutexLocker lock(&gPthreadStackCreationLock);
+  void* cached = __thread_stack_cache_get(thread);
+  if (cached != NULL) {
+    return cached;
+  }
 
-  // Create a new private anonymous map.
+  // Create a new private anonymous map. mmap and mprotect are thread-safe, so there's
+  // no need to serialize concurrent pthread_create calls here. Stacks explicitly sized
+  // to at least a huge page get huge pages if they're enabled; the default never is.
   int prot = PROT_READ | PROT_WRITE;
   int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
-  void* stack = mmap(NULL, thread->attr.stack_size, prot, flags, -1, 0);
+  void* stack = __bionic_hugepage_mmap(thread->attr.stack_size, prot, flags);
   if (stack == MAP_FAILED) {
     __libc_format_log(ANDROID_LOG_WARN,
                       "libc",
@@ -156,9 +241,26 @@ static void* __create_thread_stack(pthread_internal_t* thread) {
     return NULL;
   }
 
+  // pthread_setname_np renames it, and pthread_exit puts this name back before
+  // the stack is cached or freed.
+  __bionic_name_mem(stack, thread->attr.stack_size, "thread stack");
   return stack;
 }
 
+void __pthread_name_stack(pthread_internal_t* thread, const char* thread_name) {
+  if (!thread->allocated_on_heap || thread->attr.stack_base == NULL ||
+      (thread->attr.flags & PTHREAD_ATTR_FLAG_USER_STACK) != 0) {
+    return;
+  }
+  const char* name = "thread stack";
+  if (thread_name != NULL) {
+    strlcpy(thread->stack_name, "thread stack:", sizeof(thread->stack_name));
+    strlcat(thread->stack_name, thread_name, sizeof(thread->stack_name));
+    name = thread->stack_name;
+  }
+  __bionic_name_mem(thread->attr.stack_base, thread->attr.stack_size, name);
+}
+
 int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
                    void* (*start_routine)(void*), void* arg) {
   ErrnoRestorer errno_restorer;
@@ -224,8 +326,13 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
   int tid = __pthread_clone(start_routine, child_stack, flags, arg);
   if (tid < 0) {
     int clone_errno = errno;
-    if ((thread->attr.flags & PTHREAD_ATTR_FLAG_USER_STACK) == 0) {
+    if ((thread->attr.flags & PTHREAD_ATTR_FLAG_USER_STACK) == 0 &&
+        !__thread_stack_cache_put(thread->attr.stack_base, thread->attr.stack_size,
+                                  thread->attr.guard_size, 0, thread->alternate_signal_stack)) {
       munmap(thread->attr.stack_base, thread->attr.stack_size);
+      if (thread->alternate_signal_stack != NULL) {
+        munmap(thread->alternate_signal_stack, SIGSTKSZ);
+      }
     }
     free(thread);
     __libc_format_log(ANDROID_LOG_WARN, "libc", "pthread_create failed: clone failed: %s", strerror(errno));
@@ -243,6 +350,8 @@ int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
     return init_errno;
   }
 
+  __libc_trace(ANDROID_TRACE_THREAD_CREATE, thread->tid);
+
   // Notify any debuggers about the new thread.
   {
     ScopedPthreadMutexLocker debugger_locker(&gDebuggerNotificationLock);
@@ -37,13 +37,19 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
 #include <unwind.h>
 #include <unistd.h>
 
+#include "bionic_atomic_inline.h"
+#include "bionic_name_mem.h"
 #include "bionic_tls.h"
 #include "debug_mapinfo.h"
 #include "debug_stacktrace.h"
 #include "libc_logging.h"
+#include "pthread_internal.h"
 
 /*
  * ===========================================================================
@@ -151,6 +157,7 @@ static T* DbgAllocLocked(size_t count = 1) {
         if (sDbgAllocPtr == MAP_FAILED) {
             return NULL;
         }
+        __bionic_name_mem(sDbgAllocPtr, DBG_ALLOC_BLOCK_SIZE, "pthread_debug");
     }
     void* addr = sDbgAllocPtr + sDbgAllocOffset;
     sDbgAllocOffset += size;
@@ -161,6 +168,7 @@ static void* debug_realloc(void *ptr, size_t size, size_t old_size) {
     void* addr = mmap(NULL, size, PROT_READ|PROT_WRITE,
             MAP_ANON | MAP_PRIVATE, 0, 0);
     if (addr != MAP_FAILED) {
+        __bionic_name_mem(addr, size, "pthread_debug");
         if (ptr) {
             memcpy(addr, ptr, old_size);
             munmap(ptr, old_size);
@@ -659,13 +667,235 @@ static MutexInfo* get_most_recently_locked() {
 
 /****************************************************************************/
 
-/* pthread_debug_init() is called from libc_init_dynamic() just
- * after system properties have been initialized
+/*
+ * ===========================================================================
+ *      Contention profiling
+ * ===========================================================================
+ */
+/*
+When debug.libc.pthread.contention is set to N > 0, one in every N times a
+thread has to sleep on a mutex, the time it slept is charged to the call
+stack that was waiting. Wait sites live in a fixed-size open-addressed table
+keyed by a hash of their stack, so the cost doesn't depend on how many
+mutexes the process has. If debug.libc.pthread.contention.signal names a
+signal number, the table is written to the log each time the process gets
+that signal; pthread_mutex_contention_dump_np() writes it on demand.
+
+The table has its own spin lock rather than a pthread mutex, since a
+contended pthread mutex would call straight back into the profiler.
+*/
+
+#define CONTENTION_STACK_DEPTH 12
+#define CONTENTION_MAX_SITES   1024  // must be a power of two
+
+typedef struct ContentionSite {
+    // hash of the call stack, 0 for a free slot
+    uint32_t            hash;
+    // number of sampled waits and their total and longest duration
+    uint32_t            count;
+    uint64_t            totalNs;
+    uint64_t            maxNs;
+    // the mutex waited on most recently from this site
+    pthread_mutex_t*    lastMutex;
+    size_t              depth;
+    uintptr_t           frames[CONTENTION_STACK_DEPTH];
+} ContentionSite;
+
+static ContentionSite* sContentionSites = NULL;
+static size_t sContentionSiteCount = 0;
+static uint32_t sContentionDropped = 0;
+static int sContentionInterval = 0;
+static volatile int32_t sContentionSample = 0;
+static volatile int32_t sContentionLock = 0;
+
+static bool contention_trylock() {
+    if (__bionic_cmpxchg(0, 1, &sContentionLock) != 0) {
+        return false;
+    }
+    ANDROID_MEMBAR_FULL();
+    return true;
+}
+
+static void contention_lock() {
+    while (!contention_trylock()) {
+        sched_yield();
+    }
+}
+
+static void contention_unlock() {
+    ANDROID_MEMBAR_FULL();
+    sContentionLock = 0;
+}
+
+static uint32_t contention_hash(const uintptr_t* frames, size_t depth) {
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < depth; ++i) {
+        hash = (hash ^ static_cast<uint32_t>(frames[i])) * 16777619U;
+    }
+    return (hash != 0) ? hash : 1;
+}
+
+static void contention_record(pthread_mutex_t* mutex, int64_t wait_ns) {
+    if (sContentionInterval > 1 &&
+            (__bionic_atomic_inc(&sContentionSample) % sContentionInterval) != 0) {
+        return;
+    }
+
+    // frames[0] is this function; the waiting stack starts at the lock routine.
+    uintptr_t frames[CONTENTION_STACK_DEPTH + 1];
+    int frameCount = get_backtrace(frames, CONTENTION_STACK_DEPTH + 1);
+    size_t depth = (frameCount > 1) ? frameCount - 1 : 0;
+    uintptr_t* stack = frames + 1;
+    uint32_t hash = contention_hash(stack, depth);
+
+    contention_lock();
+
+    ContentionSite* site = NULL;
+    size_t slot = hash & (CONTENTION_MAX_SITES - 1);
+    for (size_t probe = 0; probe < CONTENTION_MAX_SITES; ++probe) {
+        ContentionSite* candidate = &sContentionSites[slot];
+        if (candidate->hash == 0) {
+            // keep the table sparse enough that probing stays short.
+            if (sContentionSiteCount < CONTENTION_MAX_SITES - CONTENTION_MAX_SITES / 4) {
+                site = candidate;
+                site->hash = hash;
+                site->depth = depth;
+                memcpy(site->frames, stack, depth * sizeof(uintptr_t));
+                sContentionSiteCount++;
+            }
+            break;
+        }
+        if (candidate->hash == hash && candidate->depth == depth &&
+                memcmp(candidate->frames, stack, depth * sizeof(uintptr_t)) == 0) {
+            site = candidate;
+            break;
+        }
+        slot = (slot + 1) & (CONTENTION_MAX_SITES - 1);
+    }
+
+    if (site != NULL) {
+        uint64_t ns = (wait_ns > 0) ? static_cast<uint64_t>(wait_ns) : 0;
+        site->count++;
+        site->totalNs += ns;
+        if (ns > site->maxNs) {
+            site->maxNs = ns;
+        }
+        site->lastMutex = mutex;
+    } else {
+        sContentionDropped++;
+    }
+
+    contention_unlock();
+}
+
+#define CONTENTION_OUT(fd, format, ...) \
+    (((fd) >= 0) ? __libc_format_fd((fd), format "\n", ##__VA_ARGS__) \
+                 : LOGI(format, ##__VA_ARGS__))
+
+static int contention_dump(int fd) {
+    // A dump from the signal handler can interrupt a thread that is halfway
+    // through recording; give up rather than spin on it forever.
+    for (int tries = 0; !contention_trylock(); ++tries) {
+        if (tries == 100) {
+            return EBUSY;
+        }
+        sched_yield();
+    }
+
+    CONTENTION_OUT(fd, "%s", kStartBanner);
+    CONTENTION_OUT(fd, "mutex contention for pid %d (%s): %zu sites, %u samples dropped, "
+                   "1 in %d waits sampled",
+                   getpid(), __progname, sContentionSiteCount, sContentionDropped,
+                   sContentionInterval);
+    for (size_t i = 0; i < CONTENTION_MAX_SITES; ++i) {
+        const ContentionSite* site = &sContentionSites[i];
+        if (site->hash == 0) {
+            continue;
+        }
+        CONTENTION_OUT(fd, "--- %u waits, total %llu us, max %llu us, last pthread_mutex_t at %p",
+                       site->count, site->totalNs / 1000, site->maxNs / 1000, site->lastMutex);
+        for (size_t j = 0; j < site->depth; ++j) {
+            CONTENTION_OUT(fd, "          #%02zu  pc %08x", j, site->frames[j]);
+        }
+    }
+    CONTENTION_OUT(fd, "%s", kEndBanner);
+
+    contention_unlock();
+    return 0;
+}
+
+static void contention_signal_handler(int) {
+    int saved_errno = errno;
+    contention_dump(-1);
+    errno = saved_errno;
+}
+
+static void contention_init(int interval) {
+    void* sites = mmap(NULL, CONTENTION_MAX_SITES * sizeof(ContentionSite),
+                       PROT_READ|PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (sites == MAP_FAILED) {
+        LOGE("couldn't allocate the mutex contention table: %s", strerror(errno));
+        return;
+    }
+    __bionic_name_mem(sites, CONTENTION_MAX_SITES * sizeof(ContentionSite), "pthread_debug");
+    sContentionSites = reinterpret_cast<ContentionSite*>(sites);
+    sContentionInterval = interval;
+
+    char env[PROP_VALUE_MAX];
+    if (__system_property_get("debug.libc.pthread.contention.signal", env)) {
+        int signum = atoi(env);
+        if (signum > 0 && signum < NSIG) {
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = contention_signal_handler;
+            sa.sa_flags = SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            if (sigaction(signum, &sa, NULL) == -1) {
+                LOGW("couldn't install the contention dump handler for signal %d: %s",
+                     signum, strerror(errno));
+            }
+        }
+    }
+
+    LOGI("pthread mutex contention profiling (1 in %d waits) enabled for pid %d (%s)",
+         interval, getpid(), __progname);
+
+    // Publish the table before the lock slow paths can see the hook.
+    ANDROID_MEMBAR_FULL();
+    __pthread_mutex_contention_dumper = contention_dump;
+    __pthread_mutex_contention_hook = contention_record;
+}
+
+static volatile int32_t sContentionProbed = 0;
+
+/* Called by the first contended lock in the process. Anything we lock from
+ * here on sees the probe cleared, and racing threads lose the cmpxchg.
+ */
+static void contention_probe() {
+    __pthread_mutex_contention_probe = NULL;
+    if (__bionic_cmpxchg(0, 1, &sContentionProbed) != 0) {
+        return;
+    }
+
+    char env[PROP_VALUE_MAX];
+    if (__system_property_get("debug.libc.pthread.contention", env)) {
+        int interval = atoi(env);
+        if (interval > 0) {
+            contention_init(interval);
+        }
+    }
+}
+
+/****************************************************************************/
+
+/* pthread_debug_init() is called from libc_init_dynamic(). It only reads
+ * properties when deadlock prediction is compiled in, since that has to be
+ * enabled before the first lock; looking at a property maps the property area.
  */
 
 extern "C" __LIBC_HIDDEN__ void pthread_debug_init() {
     char env[PROP_VALUE_MAX];
-    if (__system_property_get("debug.libc.pthread", env)) {
+    if (PTHREAD_DEBUG_ENABLED && __system_property_get("debug.libc.pthread", env)) {
         int level = atoi(env);
         if (level) {
             LOGI("pthread deadlock detection level %d enabled for pid %d (%s)",
@@ -674,6 +904,7 @@ extern "C" __LIBC_HIDDEN__ void pthread_debug_init() {
             sPthreadDebugLevel = level;
         }
     }
+    __pthread_mutex_contention_probe = contention_probe;
 }
 
 /*
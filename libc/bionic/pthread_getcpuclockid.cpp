@@ -35,6 +35,10 @@ int pthread_getcpuclockid(pthread_t t, clockid_t* clockid) {
   if (thread.get() == NULL) {
     return ESRCH;
   }
+  // An exited thread that hasn't been joined yet has a tid of 0, which means "me" to the kernel.
+  if (thread->tid == 0) {
+    return ESRCH;
+  }
 
   // The tid is stored in the top bits, but negated.
   clockid_t result = ~static_cast<clockid_t>(thread->tid) << 3;
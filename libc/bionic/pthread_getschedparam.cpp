@@ -38,6 +38,10 @@ int pthread_getschedparam(pthread_t t, int* policy, sched_param* param) {
   if (thread.get() == NULL) {
     return ESRCH;
   }
+  // An exited thread that hasn't been joined yet has a tid of 0, which means "me" to the kernel.
+  if (thread->tid == 0) {
+    return ESRCH;
+  }
 
   int rc = sched_getparam(thread->tid, param);
   if (rc == -1) {
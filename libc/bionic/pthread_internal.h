@@ -28,10 +28,15 @@
 #ifndef _PTHREAD_INTERNAL_H_
 #define _PTHREAD_INTERNAL_H_
 
+#include <android/libc_counters.h>
 #include <pthread.h>
+#include <signal.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/cdefs.h>
 
+#include "bionic_tls.h"
+
 __BEGIN_DECLS
 
 typedef struct pthread_internal_t
@@ -41,12 +46,18 @@ typedef struct pthread_internal_t
     pthread_attr_t              attr;
     pid_t                       tid;
     bool                        allocated_on_heap;
-    pthread_cond_t              join_cond;
     void*                       return_value;
     int                         internal_flags;
     __pthread_cleanup_t*        cleanup_stack;
     void**                      tls;         /* thread-local storage area */
 
+    /* Second-level pthread key values, see pthread_key.cpp. */
+    void**                      key_blocks[BIONIC_TLS_KEY_BLOCKS];
+
+    /* Keys this thread has set to non-NULL values, so that thread exit only
+     * has to look at those for destructors to call. */
+    uint32_t                    key_touched[(BIONIC_TLS_KEYS + 31) / 32];
+
     void* alternate_signal_stack;
 
     /*
@@ -55,6 +66,39 @@ typedef struct pthread_internal_t
      */
 #define __BIONIC_DLERROR_BUFFER_SIZE 512
     char dlerror_buffer[__BIONIC_DLERROR_BUFFER_SIZE];
+
+    /*
+     * How many times this thread is registered in each of the dynamic linker's lock-free
+     * reader epochs, so that dlclose(3) from a dl_iterate_phdr(3) callback doesn't wait for
+     * its own caller to finish.
+     */
+    int dl_reader_count[2];
+
+    /* This thread's cache of small free chunks (see malloc_thread_cache.h). */
+    void* malloc_cache;
+
+    /* This thread's ELF TLS blocks, allocated by __tls_get_addr (see elf_tls.cpp). */
+    void* elf_tls_dtv;
+
+    /* This thread's trace event buffer, if it has one (see bionic_trace.h). */
+    struct bionic_trace_buffer* trace_buffer;
+
+    /* This thread's share of the libc counters (see bionic_counters.h). */
+    uint64_t counters[ANDROID_LIBC_COUNTER_COUNT];
+
+    /* This thread's arc4random(3) generator, mapped on first use (see arc4random.c). */
+    void* arc4random_state;
+
+    /* This thread's signal mask as the kernel has it, if the low bit of
+     * 'sigmask_state' is set (see pthread_sigmask.cpp). */
+    unsigned long sigmask[_NSIG / LONG_BIT];
+    unsigned int sigmask_state;
+
+    /* What /proc/self/maps calls the stack we allocated for this thread, once
+     * it has been named. The kernel reads the name from here, so it has to
+     * stay put for as long as it's applied (see __pthread_name_stack). */
+#define __BIONIC_STACK_NAME_SIZE 32
+    char stack_name[__BIONIC_STACK_NAME_SIZE];
 } pthread_internal_t;
 
 int _init_thread(pthread_internal_t* thread, bool add_to_thread_list);
@@ -62,8 +106,30 @@ void __init_tls(pthread_internal_t* thread);
 void _pthread_internal_add(pthread_internal_t* thread);
 pthread_internal_t* __get_thread(void);
 
+/* The gettid(2) syscall itself. gettid() returns the thread's cached tid. */
+pid_t __gettid(void);
+
+/* Has the kernel zero *tidptr and futex-wake it when the calling thread exits, and
+ * returns the caller's tid. */
+pid_t __set_tid_address(pid_t* tidptr);
+
 __LIBC_HIDDEN__ void pthread_key_clean_all(void);
+__LIBC_HIDDEN__ void __elf_tls_thread_exit(pthread_internal_t* thread);
 __LIBC_HIDDEN__ void _pthread_internal_remove_locked(pthread_internal_t* thread);
+__LIBC_HIDDEN__ void __arc4random_thread_exit(pthread_internal_t* thread);
+__LIBC_HIDDEN__ void __arc4random_after_fork(void);
+
+/* Stops pthread_sigmask trusting its copy of the thread's signal mask, for
+ * when the kernel's may have changed behind its back. Async-signal-safe. */
+__LIBC_HIDDEN__ void __sigmask_cache_invalidate(pthread_internal_t* thread);
+
+/* Names the stack pthread_create allocated for 'thread' after 'thread_name', or
+ * just "thread stack" if 'thread_name' is NULL. Does nothing for other stacks. */
+__LIBC_HIDDEN__ void __pthread_name_stack(pthread_internal_t* thread, const char* thread_name);
+
+/* Offers an exited thread's stack and alternate signal stack up for reuse. */
+__LIBC_HIDDEN__ bool __thread_stack_cache_put(void* base, size_t size, size_t guard_size,
+                                              pid_t tid, void* signal_stack);
 
 /* Has the thread been detached by a pthread_join or pthread_detach call? */
 #define PTHREAD_ATTR_FLAG_DETACHED      0x00000001
@@ -77,11 +143,51 @@ __LIBC_HIDDEN__ void _pthread_internal_remove_locked(pthread_internal_t* thread)
 /* Has the thread already exited but not been joined? */
 #define PTHREAD_ATTR_FLAG_ZOMBIE        0x00000008
 
-__LIBC_HIDDEN__ extern pthread_internal_t* gThreadList;
-__LIBC_HIDDEN__ extern pthread_mutex_t gThreadListLock;
+/* internal_flags: will the kernel zero the thread's tid when it exits? That's
+ * what pthread_join waits for. */
+#define PTHREAD_INTERNAL_FLAG_CLEARS_TID 0x00000002
+
+/* internal_flags: is the thread's pthread_internal_t shared with a clone child
+ * that got neither its own memory nor its own TLS? And is it on loan to a vfork
+ * child right now? Either way, the cached tid may not be the caller's, so
+ * gettid() has to ask the kernel. */
+#define PTHREAD_INTERNAL_FLAG_TID_SHARED 0x00000004
+#define PTHREAD_INTERNAL_FLAG_VFORKED    0x00000008
+
+/*
+ * The list of live threads is split into shards, each with its own lock, so that
+ * threads being created and exiting at the same time don't all serialize on one
+ * lock. A thread always lives in the shard picked by its address, so finding one
+ * only needs that shard's lock; walking every thread takes each lock in turn.
+ */
+#define PTHREAD_LIST_SHARDS 16
+
+typedef struct {
+    pthread_mutex_t      lock;
+    pthread_internal_t*  head;
+} __attribute__((aligned(32))) pthread_list_shard_t;
+
+__LIBC_HIDDEN__ extern pthread_list_shard_t gThreadListShards[PTHREAD_LIST_SHARDS];
+
+static __inline__ pthread_list_shard_t* __pthread_list_shard(pthread_internal_t* thread) {
+    uint32_t h = (uint32_t)(uintptr_t) thread * 2654435761U;
+    return &gThreadListShards[h >> 28];
+}
+
+/*
+ * Mutex contention profiling. Both hooks stay NULL unless the profiler is
+ * enabled; the lock slow paths only read the clock when they are set.
+ * Checking whether to enable it means reading a property, so rather than do
+ * that at startup pthread_debug_init() sets the probe, which the first
+ * contended lock calls (and which clears itself before doing any work).
+ */
+__LIBC_HIDDEN__ extern void (*__pthread_mutex_contention_hook)(pthread_mutex_t* mutex, int64_t wait_ns);
+__LIBC_HIDDEN__ extern int (*__pthread_mutex_contention_dumper)(int fd);
+__LIBC_HIDDEN__ extern void (*__pthread_mutex_contention_probe)(void);
 
 /* needed by fork.c */
 extern void __timer_table_start_stop(int  stop);
+extern void __timer_table_after_fork_child(void);
 extern void __bionic_atfork_run_prepare();
 extern void __bionic_atfork_run_child();
 extern void __bionic_atfork_run_parent();
@@ -28,11 +28,16 @@
 
 #include "pthread_internal.h"
 
+#include <string.h>
+#include <sys/mman.h>
+
+#include "bionic_name_mem.h"
+#include "bionic_thread_table.h"
 #include "bionic_tls.h"
 #include "ScopedPthreadMutexLocker.h"
 
-__LIBC_HIDDEN__ pthread_internal_t* gThreadList = NULL;
-__LIBC_HIDDEN__ pthread_mutex_t gThreadListLock = PTHREAD_MUTEX_INITIALIZER;
+// All zeroes is an empty shard with an unlocked PTHREAD_MUTEX_INITIALIZER mutex.
+__LIBC_HIDDEN__ pthread_list_shard_t gThreadListShards[PTHREAD_LIST_SHARDS];
 
 void _pthread_internal_remove_locked(pthread_internal_t* thread) {
   if (thread->next != NULL) {
@@ -41,7 +46,7 @@ void _pthread_internal_remove_locked(pthread_internal_t* thread) {
   if (thread->prev != NULL) {
     thread->prev->next = thread->next;
   } else {
-    gThreadList = thread->next;
+    __pthread_list_shard(thread)->head = thread->next;
   }
 
   // The main thread is not heap-allocated. See __libc_init_tls for the declaration,
@@ -52,15 +57,121 @@ void _pthread_internal_remove_locked(pthread_internal_t* thread) {
 }
 
 __LIBC_ABI_PRIVATE__ void _pthread_internal_add(pthread_internal_t* thread) {
-  ScopedPthreadMutexLocker locker(&gThreadListLock);
+  pthread_list_shard_t* shard = __pthread_list_shard(thread);
+  ScopedPthreadMutexLocker locker(&shard->lock);
 
   // We insert at the head.
-  thread->next = gThreadList;
+  thread->next = shard->head;
   thread->prev = NULL;
   if (thread->next != NULL) {
     thread->next->prev = thread;
   }
-  gThreadList = thread;
+  shard->head = thread;
+  __bionic_thread_table_add(thread);
+}
+
+// The table starts out in libc's own data, so most processes never need to map more.
+#define THREAD_TABLE_STATIC_RECORDS 32
+
+static bionic_thread_record gStaticThreadRecords[THREAD_TABLE_STATIC_RECORDS];
+
+static pthread_mutex_t gThreadTableLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Looked up by name by libthread_db.
+extern "C" __LIBC_ABI_PRIVATE__ bionic_thread_table __bionic_thread_table;
+bionic_thread_table __bionic_thread_table = {
+  BIONIC_THREAD_TABLE_VERSION, 0, 0, THREAD_TABLE_STATIC_RECORDS, gStaticThreadRecords
+};
+
+static void thread_table_begin_change(bionic_thread_table* table) {
+  table->sequence++;
+  __sync_synchronize();
+}
+
+static void thread_table_end_change(bionic_thread_table* table) {
+  __sync_synchronize();
+  table->sequence++;
+}
+
+static bool thread_table_grow(bionic_thread_table* table) {
+  uint32_t capacity = table->capacity * 2;
+  size_t size = capacity * sizeof(bionic_thread_record);
+  void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  __bionic_name_mem(map, size, "thread table");
+
+  bionic_thread_record* old_records = table->records;
+  size_t old_size = table->capacity * sizeof(bionic_thread_record);
+  memcpy(map, old_records, old_size);
+
+  thread_table_begin_change(table);
+  table->records = reinterpret_cast<bionic_thread_record*>(map);
+  table->capacity = capacity;
+  thread_table_end_change(table);
+
+  if (old_records != gStaticThreadRecords) {
+    munmap(old_records, old_size);
+  }
+  return true;
+}
+
+void __bionic_thread_table_add(pthread_internal_t* thread) {
+  ScopedPthreadMutexLocker locker(&gThreadTableLock);
+  bionic_thread_table* table = &__bionic_thread_table;
+
+  uint32_t i = 0;
+  while (i < table->used && table->records[i].tid != 0) {
+    ++i;
+  }
+  if (i == table->capacity && !thread_table_grow(table)) {
+    // A table that's missing a thread is worse than none: readers take
+    // version 0 to mean they should look in /proc instead.
+    table->version = 0;
+    return;
+  }
+
+  thread_table_begin_change(table);
+  table->records[i].tid = thread->tid;
+  table->records[i].thread = reinterpret_cast<uintptr_t>(thread);
+  if (i == table->used) {
+    table->used++;
+  }
+  thread_table_end_change(table);
+}
+
+void __bionic_thread_table_remove(pthread_internal_t* thread) {
+  ScopedPthreadMutexLocker locker(&gThreadTableLock);
+  bionic_thread_table* table = &__bionic_thread_table;
+
+  for (uint32_t i = 0; i < table->used; ++i) {
+    if (table->records[i].thread == reinterpret_cast<uintptr_t>(thread)) {
+      thread_table_begin_change(table);
+      table->records[i].tid = 0;
+      table->records[i].thread = 0;
+      while (table->used > 0 && table->records[table->used - 1].tid == 0) {
+        table->used--;
+      }
+      thread_table_end_change(table);
+      return;
+    }
+  }
+}
+
+void __bionic_thread_table_after_fork(pthread_internal_t* thread) {
+  // The lock may have been held by a thread that didn't survive the fork, and
+  // the sequence left odd with it.
+  pthread_mutex_init(&gThreadTableLock, NULL);
+  bionic_thread_table* table = &__bionic_thread_table;
+
+  table->sequence |= 1;
+  __sync_synchronize();
+  memset(table->records, 0, table->used * sizeof(bionic_thread_record));
+  table->records[0].tid = thread->tid;
+  table->records[0].thread = reinterpret_cast<uintptr_t>(thread);
+  table->used = 1;
+  thread_table_end_change(table);
 }
 
 __LIBC_ABI_PRIVATE__ pthread_internal_t* __get_thread(void) {
@@ -29,6 +29,8 @@
 #include <errno.h>
 
 #include "pthread_accessor.h"
+#include "private/bionic_atomic_inline.h"
+#include "private/bionic_futex.h"
 
 int pthread_join(pthread_t t, void** ret_val) {
   if (t == pthread_self()) {
@@ -48,15 +50,27 @@ int pthread_join(pthread_t t, void** ret_val) {
     return EINVAL;
   }
 
-  // Signal our intention to join, and wait for the thread to exit.
+  // Signal our intention to join. That stops anyone else from freeing the
+  // thread, so we can let go of the lock while we wait.
   thread->attr.flags |= PTHREAD_ATTR_FLAG_JOINED;
-  while ((thread->attr.flags & PTHREAD_ATTR_FLAG_ZOMBIE) == 0) {
-    pthread_cond_wait(&thread->join_cond, &gThreadListLock);
+  pthread_internal_t* joined = thread.get();
+  pthread_mutex_t* lock = thread.lock();
+  thread.Unlock();
+
+  // The kernel zeroes the tid and wakes its futex once the thread has gone.
+  volatile pid_t* tid_ptr = &joined->tid;
+  pid_t tid;
+  while ((tid = *tid_ptr) != 0) {
+    __futex_wait(tid_ptr, tid, NULL);
   }
+  ANDROID_MEMBAR_FULL();
+
   if (ret_val) {
-    *ret_val = thread->return_value;
+    *ret_val = joined->return_value;
   }
 
-  _pthread_internal_remove_locked(thread.get());
+  pthread_mutex_lock(lock);
+  _pthread_internal_remove_locked(joined);
+  pthread_mutex_unlock(lock);
   return 0;
 }
@@ -27,13 +27,15 @@
  */
 
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "bionic_tls.h"
 #include "pthread_internal.h"
 
 /* A technical note regarding our thread-local-storage (TLS) implementation:
  *
- * There can be up to BIONIC_TLS_SLOTS independent TLS keys in a given process,
+ * There can be up to BIONIC_TLS_KEYS independent TLS keys in a given process,
  * The keys below TLS_SLOT_FIRST_USER_SLOT are reserved for Bionic to hold
  * special thread-specific variables like errno or a pointer to
  * the current thread's descriptor. These entries cannot be accessed through
@@ -43,13 +45,24 @@
  * currently created/allocated TLS keys and the destructors associated
  * with them.
  *
- * The global TLS map simply contains a bitmap of allocated keys, and
- * an array of destructors.
+ * The global TLS map contains a bitmap of allocated keys, an array of
+ * destructors, and a free list of unallocated keys so that creating a key
+ * doesn't need to search the bitmap. The free list starts out in ascending
+ * order, so the first keys handed out are the cheapest ones (see below).
  *
  * Each thread has a TLS area that is a simple array of BIONIC_TLS_SLOTS void*
  * pointers. the TLS area of the main thread is stack-allocated in
  * __libc_init_common, while the TLS area of other threads is placed at
- * the top of their stack in pthread_create.
+ * the top of their stack in pthread_create. Reading a key that lives in
+ * that array is a single load.
+ *
+ * The values of keys beyond BIONIC_TLS_SLOTS live in a second level of
+ * blocks of BIONIC_TLS_KEY_BLOCK_SIZE values, pointed to from the thread's
+ * pthread_internal_t. A thread allocates each block the first time it stores
+ * a non-NULL value in one of its keys, and frees them all when it exits.
+ *
+ * Each thread also has a bitmap of the keys it has set to non-NULL values,
+ * so that when it exits, only those need checking for destructors to call.
  *
  * When pthread_key_delete() is called it will erase the key's bitmap bit
  * and its destructor, and will also clear the key data in the TLS area of
@@ -59,12 +72,25 @@
  */
 
 #define TLSMAP_BITS       32
-#define TLSMAP_WORDS      ((BIONIC_TLS_SLOTS+TLSMAP_BITS-1)/TLSMAP_BITS)
+#define TLSMAP_WORDS      ((BIONIC_TLS_KEYS+TLSMAP_BITS-1)/TLSMAP_BITS)
 #define TLSMAP_WORD(m,k)  (m).map[(k)/TLSMAP_BITS]
 #define TLSMAP_MASK(k)    (1U << ((k)&(TLSMAP_BITS-1)))
 
+#define TLSMAP_NO_KEY     (-1)
+
 static inline bool IsValidUserKey(pthread_key_t key) {
-  return (key >= TLS_SLOT_FIRST_USER_SLOT && key < BIONIC_TLS_SLOTS);
+  return (key >= TLS_SLOT_FIRST_USER_SLOT && key < BIONIC_TLS_KEYS);
+}
+
+// Returns the address of 'thread''s value for 'key', or NULL if 'key' is in a
+// second-level block that the thread hasn't allocated.
+static inline void** KeyValueAddress(pthread_internal_t* thread, void** tls, pthread_key_t key) {
+  if (key < BIONIC_TLS_SLOTS) {
+    return &tls[key];
+  }
+  key -= BIONIC_TLS_SLOTS;
+  void** block = thread->key_blocks[key / BIONIC_TLS_KEY_BLOCK_SIZE];
+  return (block != NULL) ? &block[key % BIONIC_TLS_KEY_BLOCK_SIZE] : NULL;
 }
 
 typedef void (*key_destructor_t)(void*);
@@ -75,7 +101,11 @@ struct tls_map_t {
   /* bitmap of allocated keys */
   uint32_t map[TLSMAP_WORDS];
 
-  key_destructor_t key_destructors[BIONIC_TLS_SLOTS];
+  key_destructor_t key_destructors[BIONIC_TLS_KEYS];
+
+  /* list of unallocated keys, linked through next_free */
+  pthread_key_t first_free;
+  pthread_key_t next_free[BIONIC_TLS_KEYS];
 };
 
 class ScopedTlsMapAccess {
@@ -93,6 +123,11 @@ class ScopedTlsMapAccess {
       for (pthread_key_t key = 0; key < TLS_SLOT_FIRST_USER_SLOT; ++key) {
         SetInUse(key, NULL);
       }
+      s_tls_map_.first_free = TLS_SLOT_FIRST_USER_SLOT;
+      for (pthread_key_t key = TLS_SLOT_FIRST_USER_SLOT; key < BIONIC_TLS_KEYS - 1; ++key) {
+        s_tls_map_.next_free[key] = key + 1;
+      }
+      s_tls_map_.next_free[BIONIC_TLS_KEYS - 1] = TLSMAP_NO_KEY;
       s_tls_map_.is_initialized = true;
     }
   }
@@ -103,24 +138,28 @@ class ScopedTlsMapAccess {
 
   int CreateKey(pthread_key_t* result, void (*key_destructor)(void*)) {
     // Take the first unallocated key.
-    for (int key = 0; key < BIONIC_TLS_SLOTS; ++key) {
-      if (!IsInUse(key)) {
-        SetInUse(key, key_destructor);
-        *result = key;
-        return 0;
-      }
+    pthread_key_t key = s_tls_map_.first_free;
+    if (key == TLSMAP_NO_KEY) {
+      // We hit PTHREAD_KEYS_MAX. POSIX says EAGAIN for this case.
+      return EAGAIN;
     }
 
-    // We hit PTHREAD_KEYS_MAX. POSIX says EAGAIN for this case.
-    return EAGAIN;
+    s_tls_map_.first_free = s_tls_map_.next_free[key];
+    SetInUse(key, key_destructor);
+    *result = key;
+    return 0;
   }
 
   void DeleteKey(pthread_key_t key) {
     TLSMAP_WORD(s_tls_map_, key) &= ~TLSMAP_MASK(key);
     s_tls_map_.key_destructors[key] = NULL;
+    s_tls_map_.next_free[key] = s_tls_map_.first_free;
+    s_tls_map_.first_free = key;
   }
 
-  bool IsInUse(pthread_key_t key) {
+  // This doesn't need the lock: a word of the bitmap is read atomically, and a
+  // caller racing pthread_key_delete() with a use of the same key is already broken.
+  static bool IsInUse(pthread_key_t key) {
     return (TLSMAP_WORD(s_tls_map_, key) & TLSMAP_MASK(key)) != 0;
   }
 
@@ -134,14 +173,26 @@ class ScopedTlsMapAccess {
   // that have a non-NULL data value and a non-NULL destructor.
   void CleanAll() {
     void** tls = (void**)__get_tls();
+    pthread_internal_t* thread = __get_thread();
 
     // Because destructors can do funky things like deleting/creating other
-    // keys, we need to implement this in a loop.
+    // keys, we need to implement this in a loop. Each round takes the keys
+    // touched since the previous one, so a destructor that sets a key
+    // gets it looked at again in the next round.
     for (int rounds = PTHREAD_DESTRUCTOR_ITERATIONS; rounds > 0; --rounds) {
       size_t called_destructor_count = 0;
-      for (int key = 0; key < BIONIC_TLS_SLOTS; ++key) {
-        if (IsInUse(key)) {
-          void* data = tls[key];
+      for (size_t word = 0; word < TLSMAP_WORDS; ++word) {
+        uint32_t touched = thread->key_touched[word];
+        thread->key_touched[word] = 0;
+        while (touched != 0) {
+          pthread_key_t key = word * TLSMAP_BITS + __builtin_ctz(touched);
+          touched &= touched - 1;
+          if (!IsInUse(key)) {
+            continue;
+          }
+
+          void** value = KeyValueAddress(thread, tls, key);
+          void* data = (value != NULL) ? *value : NULL;
           void (*key_destructor)(void*) = s_tls_map_.key_destructors[key];
 
           if (data != NULL && key_destructor != NULL) {
@@ -152,7 +203,7 @@ class ScopedTlsMapAccess {
             // we do not do this if 'key_destructor == NULL' just in case another
             // destructor function might be responsible for manually
             // releasing the corresponding data.
-            tls[key] = NULL;
+            *value = NULL;
 
             // because the destructor is free to call pthread_key_create
             // and/or pthread_key_delete, we need to temporarily unlock
@@ -189,8 +240,23 @@ __LIBC_HIDDEN__ tls_map_t ScopedTlsMapAccess::s_tls_map_;
 __LIBC_HIDDEN__ pthread_mutex_t ScopedTlsMapAccess::s_tls_map_lock_;
 
 __LIBC_HIDDEN__ void pthread_key_clean_all() {
-  ScopedTlsMapAccess tls_map;
-  tls_map.CleanAll();
+  {
+    ScopedTlsMapAccess tls_map;
+    tls_map.CleanAll();
+  }
+
+  // Free the second-level blocks. pthread_key_delete() may be clearing values in
+  // them, so detach them under our thread list lock before freeing them.
+  pthread_internal_t* thread = __get_thread();
+  pthread_list_shard_t* shard = __pthread_list_shard(thread);
+  void** blocks[BIONIC_TLS_KEY_BLOCKS];
+  pthread_mutex_lock(&shard->lock);
+  memcpy(blocks, thread->key_blocks, sizeof(blocks));
+  memset(thread->key_blocks, 0, sizeof(thread->key_blocks));
+  pthread_mutex_unlock(&shard->lock);
+  for (size_t i = 0; i < BIONIC_TLS_KEY_BLOCKS; ++i) {
+    free(blocks[i]);
+  }
 }
 
 int pthread_key_create(pthread_key_t* key, void (*key_destructor)(void*)) {
@@ -210,45 +276,81 @@ int pthread_key_delete(pthread_key_t key) {
   }
 
   // Clear value in all threads.
-  pthread_mutex_lock(&gThreadListLock);
-  for (pthread_internal_t*  t = gThreadList; t != NULL; t = t->next) {
-    // Skip zombie threads. They don't have a valid TLS area any more.
-    // Similarly, it is possible to have t->tls == NULL for threads that
-    // were just recently created through pthread_create() but whose
-    // startup trampoline (__thread_entry) hasn't been run yet by the
-    // scheduler. t->tls will also be NULL after a thread's stack has been
-    // unmapped but before the ongoing pthread_join() is finished.
-    if ((t->attr.flags & PTHREAD_ATTR_FLAG_ZOMBIE) || t->tls == NULL) {
-      continue;
-    }
+  for (size_t i = 0; i < PTHREAD_LIST_SHARDS; ++i) {
+    pthread_list_shard_t* shard = &gThreadListShards[i];
+    pthread_mutex_lock(&shard->lock);
+    for (pthread_internal_t*  t = shard->head; t != NULL; t = t->next) {
+      // Skip zombie threads. They don't have a valid TLS area any more.
+      // Similarly, it is possible to have t->tls == NULL for threads that
+      // were just recently created through pthread_create() but whose
+      // startup trampoline (__thread_entry) hasn't been run yet by the
+      // scheduler. t->tls will also be NULL after a thread's stack has been
+      // unmapped but before the ongoing pthread_join() is finished.
+      if ((t->attr.flags & PTHREAD_ATTR_FLAG_ZOMBIE) || t->tls == NULL) {
+        continue;
+      }
 
-    t->tls[key] = NULL;
+      void** value = KeyValueAddress(t, t->tls, key);
+      if (value != NULL) {
+        *value = NULL;
+      }
+    }
+    pthread_mutex_unlock(&shard->lock);
   }
   tls_map.DeleteKey(key);
 
-  pthread_mutex_unlock(&gThreadListLock);
   return 0;
 }
 
 void* pthread_getspecific(pthread_key_t key) {
-  if (!IsValidUserKey(key)) {
-    return NULL;
-  }
-
   // For performance reasons, we do not lock/unlock the global TLS map
   // to check that the key is properly allocated. If the key was not
   // allocated, the value read from the TLS should always be NULL
   // due to pthread_key_delete() clearing the values for all threads.
-  return (void *)(((unsigned *)__get_tls())[key]);
+  if (__predict_true(key >= TLS_SLOT_FIRST_USER_SLOT && key < BIONIC_TLS_SLOTS)) {
+    return (void *)(((unsigned *)__get_tls())[key]);
+  }
+
+  if (!IsValidUserKey(key)) {
+    return NULL;
+  }
+  void** value = KeyValueAddress(__get_thread(), NULL, key);
+  return (value != NULL) ? *value : NULL;
 }
 
 int pthread_setspecific(pthread_key_t key, const void* ptr) {
-  ScopedTlsMapAccess tls_map;
-
-  if (!IsValidUserKey(key) || !tls_map.IsInUse(key)) {
+  if (!IsValidUserKey(key) || !ScopedTlsMapAccess::IsInUse(key)) {
     return EINVAL;
   }
 
-  ((uint32_t *)__get_tls())[key] = (uint32_t)ptr;
+  pthread_internal_t* thread = __get_thread();
+  if (ptr != NULL) {
+    // Note that thread exit has to look at this key. Avoid dirtying the
+    // line if it already knows.
+    uint32_t* touched = &thread->key_touched[key / TLSMAP_BITS];
+    if ((*touched & TLSMAP_MASK(key)) == 0) {
+      *touched |= TLSMAP_MASK(key);
+    }
+  }
+
+  if (key < BIONIC_TLS_SLOTS) {
+    ((uint32_t *)__get_tls())[key] = (uint32_t)ptr;
+    return 0;
+  }
+
+  void** value = KeyValueAddress(thread, NULL, key);
+  if (value == NULL) {
+    if (ptr == NULL) {
+      return 0;
+    }
+    // First use of this block by this thread.
+    void** block = reinterpret_cast<void**>(calloc(BIONIC_TLS_KEY_BLOCK_SIZE, sizeof(void*)));
+    if (block == NULL) {
+      return ENOMEM;
+    }
+    thread->key_blocks[(key - BIONIC_TLS_SLOTS) / BIONIC_TLS_KEY_BLOCK_SIZE] = block;
+    value = KeyValueAddress(thread, NULL, key);
+  }
+  *value = const_cast<void*>(ptr);
   return 0;
 }
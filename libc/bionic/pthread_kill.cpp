@@ -45,6 +45,9 @@ int pthread_kill(pthread_t t, int sig) {
   // There's a race here, but it's one we share with all other C libraries.
   pid_t tid = thread->tid;
   thread.Unlock();
+  if (tid == 0) {
+    return ESRCH; // It has exited, but not been joined.
+  }
 
   int rc = tgkill(getpid(), tid, sig);
   if (rc == -1) {
@@ -57,7 +57,11 @@ int pthread_setname_np(pthread_t t, const char* thread_name) {
 
   // Changing our own name is an easy special case.
   if (t == pthread_self()) {
-    return prctl(PR_SET_NAME, thread_name) ? errno : 0;
+    if (prctl(PR_SET_NAME, thread_name) == -1) {
+      return errno;
+    }
+    __pthread_name_stack(__get_thread(), thread_name);
+    return 0;
   }
 
   // We have to change another thread's name.
@@ -69,6 +73,9 @@ int pthread_setname_np(pthread_t t, const char* thread_name) {
     }
     tid = thread->tid;
   }
+  if (tid == 0) {
+    return ESRCH; // It has exited, but not been joined.
+  }
   char comm_name[sizeof(TASK_COMM_FMT) + 8];
   snprintf(comm_name, sizeof(comm_name), TASK_COMM_FMT, tid);
   int fd = open(comm_name, O_WRONLY);
@@ -83,5 +90,12 @@ int pthread_setname_np(pthread_t t, const char* thread_name) {
   } else if (n != static_cast<ssize_t>(thread_name_len)) {
     return EIO;
   }
+
+  // A thread that has since exited no longer has a stack to name; pthread_exit
+  // resets the name under this same lock.
+  pthread_accessor thread(t);
+  if (thread.get() != NULL && (thread->attr.flags & PTHREAD_ATTR_FLAG_ZOMBIE) == 0) {
+    __pthread_name_stack(thread.get(), thread_name);
+  }
   return 0;
 }
@@ -38,6 +38,10 @@ int pthread_setschedparam(pthread_t t, int policy, struct sched_param const* par
   if (thread.get() == NULL) {
     return ESRCH;
   }
+  // An exited thread that hasn't been joined yet has a tid of 0, which means "me" to the kernel.
+  if (thread->tid == 0) {
+    return ESRCH;
+  }
 
   int rc = sched_setscheduler(thread->tid, policy, param);
   if (rc == -1) {
@@ -27,15 +27,138 @@
  */
 
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <signal.h>
+#include <string.h>
 
+#include "pthread_internal.h"
 #include "private/ErrnoRestorer.h"
 #include "private/kernel_sigset_t.h"
 
 extern "C" int __rt_sigprocmask(int, const kernel_sigset_t*, kernel_sigset_t*, size_t);
 
+// Each thread keeps a copy of its signal mask, so that blocking what's already blocked,
+// or a SIG_SETMASK to the mask the thread already has, doesn't need the kernel.
+//
+// The copy is only good while nothing else changes the mask. Signal delivery does, and
+// so does returning from a handler, so the handlers sigaction(2) installs invalidate it
+// on the way in and out (see sigaction.cpp). So does vfork(2) in the parent, because
+// the child shared our memory while it ran.
+//
+// 'sigmask_state' has the copy's validity in bit 0 and a generation count above it,
+// bumped whenever the copy is invalidated. A handler can interrupt us anywhere and
+// rewrite the copy itself, so readers check the generation didn't change while they
+// read, and writers only mark the copy valid if it didn't change while they wrote.
+
+static const unsigned int kSigmaskValid = 1;
+static const size_t kSigmaskWords = sizeof(kernel_sigset_t) / sizeof(unsigned long);
+
+struct sigmask_t {
+  unsigned long words[kSigmaskWords];
+
+  bool operator==(const sigmask_t& other) const {
+    return memcmp(words, other.words, sizeof(words)) == 0;
+  }
+};
+
+static_assert(sizeof(sigmask_t) == sizeof(((pthread_internal_t*) NULL)->sigmask),
+              "pthread_internal_t::sigmask is not the size of the kernel's sigset_t");
+
+static void sigmask_del(sigmask_t* mask, int signal_number) {
+  int bit = signal_number - 1;
+  mask->words[bit / LONG_BIT] &= ~(1UL << (bit % LONG_BIT));
+}
+
+static sigmask_t to_sigmask(const kernel_sigset_t& set) {
+  sigmask_t result;
+  memcpy(result.words, &set, sizeof(result.words));
+  return result;
+}
+
+// Works out what the kernel will make the mask, given what it is now.
+static sigmask_t apply(int how, const sigmask_t& current, const sigset_t* iset) {
+  sigmask_t set = to_sigmask(kernel_sigset_t(iset));
+  sigmask_t result = current;
+  for (size_t i = 0; i < kSigmaskWords; ++i) {
+    if (how == SIG_BLOCK) {
+      result.words[i] |= set.words[i];
+    } else if (how == SIG_UNBLOCK) {
+      result.words[i] &= ~set.words[i];
+    } else {
+      result.words[i] = set.words[i];
+    }
+  }
+  // The kernel quietly refuses to block these.
+  sigmask_del(&result, SIGKILL);
+  sigmask_del(&result, SIGSTOP);
+  return result;
+}
+
+static bool read_cached_sigmask(pthread_internal_t* thread, sigmask_t* result) {
+  volatile unsigned int* state = &thread->sigmask_state;
+  unsigned int before = *state;
+  if ((before & kSigmaskValid) == 0) {
+    return false;
+  }
+  __asm__ __volatile__("" ::: "memory");
+  memcpy(result->words, thread->sigmask, sizeof(result->words));
+  __asm__ __volatile__("" ::: "memory");
+  return *state == before;
+}
+
+static void write_cached_sigmask(pthread_internal_t* thread, const sigmask_t& mask) {
+  volatile unsigned int* state = &thread->sigmask_state;
+  unsigned int invalid = *state & ~kSigmaskValid;
+  // Anyone who interrupts us from here on sees the copy as invalid.
+  *state = invalid;
+  __asm__ __volatile__("" ::: "memory");
+  memcpy(thread->sigmask, mask.words, sizeof(mask.words));
+  __asm__ __volatile__("" ::: "memory");
+  // A handler that ran since we stored 'invalid' will have moved the generation on.
+  __sync_bool_compare_and_swap(state, invalid, invalid | kSigmaskValid);
+}
+
+void __sigmask_cache_invalidate(pthread_internal_t* thread) {
+  // Only this thread and its signal handlers write this, and a handler always
+  // finishes before what it interrupted resumes, so this needn't be atomic.
+  volatile unsigned int* state = &thread->sigmask_state;
+  *state = (*state + 2) & ~kSigmaskValid;
+}
+
+// Called by vfork(2) in the child only, which is borrowing our pthread_internal_t
+// (and so our cached tid) until it execs or exits.
+extern "C" __LIBC_HIDDEN__ pid_t __bionic_vfork_child() {
+  __get_thread()->internal_flags |= PTHREAD_INTERNAL_FLAG_VFORKED;
+  return 0;
+}
+
+// Called by vfork(2) in the parent only, after the child has exec'ed or exited.
+extern "C" __LIBC_HIDDEN__ pid_t __bionic_vfork_parent(pid_t pid) {
+  pthread_internal_t* thread = __get_thread();
+  thread->internal_flags &= ~PTHREAD_INTERNAL_FLAG_VFORKED;
+  __sigmask_cache_invalidate(thread);
+  return pid;
+}
+
 int pthread_sigmask(int how, const sigset_t* iset, sigset_t* oset) {
+  if (iset != NULL && how != SIG_BLOCK && how != SIG_UNBLOCK && how != SIG_SETMASK) {
+    return EINVAL;
+  }
+
+  pthread_internal_t* thread = __get_thread();
+  sigmask_t current;
+  if (read_cached_sigmask(thread, &current)) {
+    if (iset == NULL || apply(how, current, iset) == current) {
+      if (oset != NULL) {
+        kernel_sigset_t out_set;
+        memcpy(&out_set, current.words, sizeof(out_set));
+        *oset = out_set.bionic;
+      }
+      return 0;
+    }
+  }
+
   ErrnoRestorer errno_restorer;
 
   // 'in_set_ptr' is the second parameter to __rt_sigprocmask. It must be NULL
@@ -53,9 +176,22 @@ int pthread_sigmask(int how, const sigset_t* iset, sigset_t* oset) {
     return errno;
   }
 
+  // The kernel told us what the mask was, so we know what it is now.
+  sigmask_t old_mask = to_sigmask(out_set);
+  write_cached_sigmask(thread, (iset != NULL) ? apply(how, old_mask, iset) : old_mask);
+
   if (oset != NULL) {
     *oset = out_set.bionic;
   }
 
   return 0;
 }
+
+int sigprocmask(int how, const sigset_t* iset, sigset_t* oset) {
+  int result = pthread_sigmask(how, iset, oset);
+  if (result != 0) {
+    errno = result;
+    return -1;
+  }
+  return 0;
+}
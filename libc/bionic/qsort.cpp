@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// An introsort: quicksort with a median-of-three (or, for larger ranges, ninther) pivot, giving
+// way to heapsort once it has gone deeper than twice the log of the length, so even adversarial
+// input is O(n log n). The partition stops on elements equal to the pivot from both ends, which
+// keeps ranges of equal keys balanced, and a partition that moved nothing tries finishing each
+// side with an insertion sort that gives up after a few moves, which makes sorted (or nearly
+// sorted) input cost O(n).
+//
+// The code is instantiated for 4-, 8- and 16-byte elements (which covers arrays of pointers) so
+// that swapping them is a couple of moves, and once more for any other size.
+
+namespace {
+
+// Below this, insertion sort beats partitioning.
+static const size_t kInsertionSortThreshold = 12;
+// Above this, the pivot is the median of three medians of three.
+static const size_t kNintherThreshold = 40;
+// How many moves the optimistic insertion sort may make before giving up.
+static const size_t kPartialInsertionSortLimit = 8;
+
+template <typename T>
+struct FixedSizeElements {
+  explicit FixedSizeElements(size_t) {}
+
+  size_t size() const {
+    return sizeof(T);
+  }
+
+  void swap(char* a, char* b) const {
+    T* pa = reinterpret_cast<T*>(a);
+    T* pb = reinterpret_cast<T*>(b);
+    T t = *pa;
+    *pa = *pb;
+    *pb = t;
+  }
+};
+
+struct AnySizeElements {
+  explicit AnySizeElements(size_t size) : size_(size) {}
+
+  size_t size() const {
+    return size_;
+  }
+
+  void swap(char* a, char* b) const {
+    // Fixed-length copies through a small buffer, which the compiler turns into word moves.
+    char t[32];
+    size_t n = size_;
+    for (; n >= sizeof(t); n -= sizeof(t), a += sizeof(t), b += sizeof(t)) {
+      memcpy(t, a, sizeof(t));
+      memcpy(a, b, sizeof(t));
+      memcpy(b, t, sizeof(t));
+    }
+    for (; n > 0; --n, ++a, ++b) {
+      char c = *a;
+      *a = *b;
+      *b = c;
+    }
+  }
+
+  size_t size_;
+};
+
+// The caller's elements may be of any type, so these are allowed to alias them.
+struct word32_t {
+  uint32_t value;
+} __attribute__((__may_alias__));
+struct word64_t {
+  uint64_t value;
+} __attribute__((__may_alias__));
+struct word128_t {
+  uint64_t lo;
+  uint64_t hi;
+} __attribute__((__may_alias__));
+
+struct PlainComparator {
+  int (*compare)(const void*, const void*);
+
+  int operator()(const char* a, const char* b) const {
+    return compare(a, b);
+  }
+};
+
+struct ContextComparator {
+  int (*compare)(const void*, const void*, void*);
+  void* context;
+
+  int operator()(const char* a, const char* b) const {
+    return compare(a, b, context);
+  }
+};
+
+template <typename Elements, typename Comparator>
+class Sorter {
+ public:
+  Sorter(Elements elements, Comparator compare) : elements_(elements), compare_(compare) {}
+
+  void Sort(char* base, size_t n) {
+    int depth_limit = 0;
+    for (size_t i = n; i > 1; i >>= 1) {
+      depth_limit += 2;
+    }
+    Introsort(base, n, depth_limit);
+  }
+
+ private:
+  char* At(char* base, size_t i) const {
+    return base + i * elements_.size();
+  }
+
+  void Swap(char* a, char* b) const {
+    elements_.swap(a, b);
+  }
+
+  void InsertionSort(char* base, size_t n) const {
+    size_t size = elements_.size();
+    char* end = At(base, n);
+    for (char* i = base + size; i < end; i += size) {
+      for (char* j = i; j > base && compare_(j - size, j) > 0; j -= size) {
+        Swap(j, j - size);
+      }
+    }
+  }
+
+  // Like InsertionSort, but returns false, leaving the range partly sorted, rather than spend
+  // more than a few moves.
+  bool PartialInsertionSort(char* base, size_t n) const {
+    size_t size = elements_.size();
+    char* end = At(base, n);
+    size_t moves = 0;
+    for (char* i = base + size; i < end; i += size) {
+      for (char* j = i; j > base && compare_(j - size, j) > 0; j -= size) {
+        if (++moves > kPartialInsertionSortLimit) {
+          return false;
+        }
+        Swap(j, j - size);
+      }
+    }
+    return true;
+  }
+
+  void SiftDown(char* base, size_t root, size_t n) const {
+    for (;;) {
+      size_t child = 2 * root + 1;
+      if (child >= n) {
+        return;
+      }
+      if (child + 1 < n && compare_(At(base, child), At(base, child + 1)) < 0) {
+        ++child;
+      }
+      if (compare_(At(base, root), At(base, child)) >= 0) {
+        return;
+      }
+      Swap(At(base, root), At(base, child));
+      root = child;
+    }
+  }
+
+  void HeapSort(char* base, size_t n) const {
+    for (size_t i = n / 2; i > 0; --i) {
+      SiftDown(base, i - 1, n);
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+      Swap(base, At(base, i));
+      SiftDown(base, 0, i);
+    }
+  }
+
+  char* Median3(char* a, char* b, char* c) const {
+    if (compare_(a, b) < 0) {
+      if (compare_(b, c) < 0) {
+        return b;
+      }
+      return compare_(a, c) < 0 ? c : a;
+    }
+    if (compare_(b, c) > 0) {
+      return b;
+    }
+    return compare_(a, c) < 0 ? a : c;
+  }
+
+  char* ChoosePivot(char* base, size_t n) const {
+    char* first = base;
+    char* middle = At(base, n / 2);
+    char* last = At(base, n - 1);
+    if (n > kNintherThreshold) {
+      size_t step = (n / 8) * elements_.size();
+      first = Median3(first, first + step, first + 2 * step);
+      middle = Median3(middle - step, middle, middle + step);
+      last = Median3(last - 2 * step, last - step, last);
+    }
+    return Median3(first, middle, last);
+  }
+
+  void Introsort(char* base, size_t n, int depth_limit) {
+    size_t size = elements_.size();
+    while (n > kInsertionSortThreshold) {
+      if (depth_limit-- == 0) {
+        HeapSort(base, n);
+        return;
+      }
+
+      Swap(base, ChoosePivot(base, n));
+
+      // Everything in [base + 1, lo) is <= the pivot, and everything in (hi, end) is >= it.
+      char* lo = base + size;
+      char* hi = At(base, n - 1);
+      bool moved = false;
+      for (;;) {
+        while (lo <= hi && compare_(lo, base) < 0) {
+          lo += size;
+        }
+        while (lo <= hi && compare_(hi, base) > 0) {
+          hi -= size;
+        }
+        if (lo >= hi) {
+          break;
+        }
+        Swap(lo, hi);
+        moved = true;
+        lo += size;
+        hi -= size;
+      }
+      Swap(base, hi);
+
+      size_t left = (hi - base) / size;
+      size_t right = n - left - 1;
+      char* right_base = hi + size;
+      if (!moved && PartialInsertionSort(base, left) && PartialInsertionSort(right_base, right)) {
+        return;
+      }
+
+      // Recurse into the smaller side, so the stack stays O(log n), and loop on the larger.
+      if (left < right) {
+        Introsort(base, left, depth_limit);
+        base = right_base;
+        n = right;
+      } else {
+        Introsort(right_base, right, depth_limit);
+        n = left;
+      }
+    }
+    InsertionSort(base, n);
+  }
+
+  Elements elements_;
+  Comparator compare_;
+};
+
+template <typename Elements, typename Comparator>
+static void SortAs(void* base, size_t n, size_t size, Comparator compare) {
+  Sorter<Elements, Comparator> sorter((Elements(size)), compare);
+  sorter.Sort(reinterpret_cast<char*>(base), n);
+}
+
+template <typename Comparator>
+static void Sort(void* base, size_t n, size_t size, Comparator compare) {
+  if (n < 2 || size == 0) {
+    return;
+  }
+  uintptr_t address = reinterpret_cast<uintptr_t>(base);
+  if (size == 4 && address % __alignof__(uint32_t) == 0) {
+    SortAs<FixedSizeElements<word32_t> >(base, n, size, compare);
+  } else if (size == 8 && address % __alignof__(uint64_t) == 0) {
+    SortAs<FixedSizeElements<word64_t> >(base, n, size, compare);
+  } else if (size == 16 && address % __alignof__(uint64_t) == 0) {
+    SortAs<FixedSizeElements<word128_t> >(base, n, size, compare);
+  } else {
+    SortAs<AnySizeElements>(base, n, size, compare);
+  }
+}
+
+}  // namespace
+
+void qsort(void* base, size_t n, size_t size, int (*compare)(const void*, const void*)) {
+  PlainComparator comparator = { compare };
+  Sort(base, n, size, comparator);
+}
+
+void qsort_r(void* base, size_t n, size_t size,
+             int (*compare)(const void*, const void*, void*), void* context) {
+  ContextComparator comparator = { compare, context };
+  Sort(base, n, size, comparator);
+}
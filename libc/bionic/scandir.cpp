@@ -47,7 +47,8 @@ class ScandirResult {
 
   bool Add(dirent* entry) {
     if (size_ >= capacity_) {
-      size_t new_capacity = capacity_ + 32;
+      // Grow geometrically, so a large directory isn't copied over and over.
+      size_t new_capacity = (capacity_ == 0) ? 32 : capacity_ * 2;
       dirent** new_names = (dirent**) realloc(names_, new_capacity * sizeof(dirent*));
       if (new_names == NULL) {
         return false;
@@ -80,6 +81,9 @@ class ScandirResult {
     // Allocate the minimum number of bytes necessary, rounded up to a 4-byte boundary.
     size_t size = ((original->d_reclen + 3) & ~3);
     dirent* copy = (dirent*) malloc(size);
+    if (copy == NULL) {
+      return NULL;
+    }
     memcpy(copy, original, original->d_reclen);
     return copy;
   }
@@ -104,7 +108,10 @@ int scandir(const char* dirname, dirent*** name_list,
     if (filter != NULL && !(*filter)(entry)) {
       continue;
     }
-    names.Add(entry);
+    if (!names.Add(entry)) {
+      errno = ENOMEM;
+      return -1;
+    }
   }
 
   names.Sort(comparator);
@@ -33,6 +33,8 @@
 #include <bionic_atomic_inline.h>
 #include <bionic_futex.h>
 #include <limits.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 /* In this implementation, a semaphore contains a
  * 31-bit signed value and a 1-bit 'shared' flag
@@ -46,13 +48,23 @@
  *
  * post(1)  ==> 2
  * post(0)  ==> 1
- * post(-1) ==> 1, then wake all waiters
+ * post(-1) ==> 1, then wake one waiter
  *
  * wait(2)  ==> 1
  * wait(1)  ==> 0
  * wait(0)  ==> -1 then wait for a wake up + loop
  * wait(-1) ==> -1 then wait for a wake up + loop
  *
+ * So -1 is the "there may be waiters" flag, and post() only enters the
+ * kernel when it sees it: an uncontended post/wait pair is two atomic
+ * operations and nothing else.
+ *
+ * Only one waiter is woken per post, since only one of them can get
+ * the new value. A thread that has slept once doesn't know whether
+ * others are still sleeping, so after waking up it decrements 1 to -1
+ * rather than 0 (see __sem_dec_contended), leaving the flag for the
+ * next post. This costs at most one unnecessary wake at the end of a
+ * contended period, instead of a thundering herd on every post.
  */
 
 /* Use the upper 31-bits for the counter, and the lower one
@@ -110,17 +122,14 @@ int sem_init(sem_t *sem, int pshared, unsigned int value)
 
 int sem_destroy(sem_t *sem)
 {
-    int count;
-
     if (sem == NULL) {
         errno = EINVAL;
         return -1;
     }
-    count = SEMCOUNT_TO_VALUE(sem->count);
-    if (count < 0) {
-        errno = EBUSY;
-        return -1;
-    }
+    /* Don't fail with EBUSY when the value is -1: that only means there
+     * *may* be waiters, and the flag can outlive the last of them (see
+     * __sem_dec_contended). Destroying a semaphore that really has
+     * waiters is undefined anyway. */
     sem->count = 0;
     return 0;
 }
@@ -180,6 +189,31 @@ __sem_dec(volatile unsigned int *pvalue)
     return ret;
 }
 
+/* Same as __sem_dec, but for a thread that has already slept on the
+ * semaphore: decrementing 1 gives -1 rather than 0, to keep waking any
+ * other sleepers. Returns the old value.
+ */
+static int
+__sem_dec_contended(volatile unsigned int *pvalue)
+{
+    unsigned int shared = (*pvalue & SEMCOUNT_SHARED_MASK);
+    unsigned int old, new;
+    int          ret;
+
+    do {
+        old = (*pvalue & SEMCOUNT_VALUE_MASK);
+        ret = SEMCOUNT_TO_VALUE(old);
+        if (ret < 0)
+            break;
+
+        new = (ret <= 1) ? SEMCOUNT_MINUS_ONE : SEMCOUNT_DECREMENT(old);
+    }
+    while (__bionic_cmpxchg((int)(old|shared),
+                            (int)(new|shared),
+                            (volatile int *)pvalue) != 0);
+    return ret;
+}
+
 /* Same as __sem_dec, but will not touch anything if the
  * value is already negative *or* 0. Returns the old value.
  */
@@ -242,6 +276,33 @@ __sem_inc(volatile unsigned int *pvalue)
     return ret;
 }
 
+/* Wait for a wake up while the semaphore is contended, until the absolute
+ * deadline 'abs_timeout' on 'clock' if it isn't NULL. Returns 0 or a
+ * negative errno value, like __futex_wait_ex.
+ */
+static int
+__sem_wait_futex(sem_t *sem, unsigned int shared, const struct timespec *abs_timeout,
+                 clockid_t clock)
+{
+    int op;
+
+    if (abs_timeout == NULL)
+        return __futex_wait_ex(&sem->count, shared, shared|SEMCOUNT_MINUS_ONE, NULL);
+
+    /* FUTEX_WAIT_BITSET takes an absolute deadline, so there's nothing to
+     * recompute when we loop, and the kernel tracks changes to the clock. */
+    op = FUTEX_WAIT_BITSET;
+    if (!shared)
+        op |= FUTEX_PRIVATE_FLAG;
+    if (clock == CLOCK_REALTIME)
+        op |= FUTEX_CLOCK_REALTIME;
+
+    if (syscall(__NR_futex, &sem->count, op, shared|SEMCOUNT_MINUS_ONE,
+                abs_timeout, NULL, FUTEX_BITSET_MATCH_ANY) == -1)
+        return -errno;
+    return 0;
+}
+
 /* lock a semaphore */
 int sem_wait(sem_t *sem)
 {
@@ -254,20 +315,19 @@ int sem_wait(sem_t *sem)
 
     shared = SEM_GET_SHARED(sem);
 
-    for (;;) {
-        if (__sem_dec(&sem->count) > 0)
-            break;
-
-        __futex_wait_ex(&sem->count, shared, shared|SEMCOUNT_MINUS_ONE, NULL);
+    if (__sem_dec(&sem->count) <= 0) {
+        do {
+            __sem_wait_futex(sem, shared, NULL, CLOCK_REALTIME);
+        } while (__sem_dec_contended(&sem->count) <= 0);
     }
     ANDROID_MEMBAR_FULL();
     return 0;
 }
 
-int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
+static int __sem_timedwait(sem_t *sem, const struct timespec *abs_timeout, clockid_t clock)
 {
-    int  ret;
     unsigned int shared;
+    int contended = 0;
 
     if (sem == NULL) {
         errno = EINVAL;
@@ -296,35 +356,30 @@ int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
     shared = SEM_GET_SHARED(sem);
 
     for (;;) {
-        struct timespec ts;
-        int             ret;
-
-        /* Posix mandates CLOCK_REALTIME here */
-        clock_gettime( CLOCK_REALTIME, &ts );
-        ts.tv_sec  = abs_timeout->tv_sec - ts.tv_sec;
-        ts.tv_nsec = abs_timeout->tv_nsec - ts.tv_nsec;
-        if (ts.tv_nsec < 0) {
-            ts.tv_nsec += 1000000000;
-            ts.tv_sec  -= 1;
-        }
-
-        if (ts.tv_sec < 0 || ts.tv_nsec < 0) {
-            errno = ETIMEDOUT;
-            return -1;
-        }
+        int ret;
 
         /* Try to grab the semaphore. If the value was 0, this
          * will also change it to -1 */
-        if (__sem_dec(&sem->count) > 0) {
+        if (contended)
+            ret = __sem_dec_contended(&sem->count);
+        else
+            ret = __sem_dec(&sem->count);
+        if (ret > 0) {
             ANDROID_MEMBAR_FULL();
             break;
         }
 
         /* Contention detected. wait for a wakeup event */
-        ret = __futex_wait_ex(&sem->count, shared, shared|SEMCOUNT_MINUS_ONE, &ts);
+        ret = __sem_wait_futex(sem, shared, abs_timeout, clock);
+        contended = 1;
 
         /* return in case of timeout or interrupt */
         if (ret == -ETIMEDOUT || ret == -EINTR) {
+            /* We may have been woken by a post just as we gave up. Since
+             * a post only wakes one thread, pass that wake up on if the
+             * semaphore is available. */
+            if (SEMCOUNT_TO_VALUE(sem->count) > 0)
+                __futex_wake_ex(&sem->count, shared, 1);
             errno = -ret;
             return -1;
         }
@@ -332,6 +387,17 @@ int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
     return 0;
 }
 
+int sem_timedwait(sem_t *sem, const struct timespec *abs_timeout)
+{
+    /* Posix mandates CLOCK_REALTIME here */
+    return __sem_timedwait(sem, abs_timeout, CLOCK_REALTIME);
+}
+
+int sem_timedwait_monotonic_np(sem_t *sem, const struct timespec *abs_timeout)
+{
+    return __sem_timedwait(sem, abs_timeout, CLOCK_MONOTONIC);
+}
+
 /* Unlock a semaphore */
 int sem_post(sem_t *sem)
 {
@@ -346,8 +412,8 @@ int sem_post(sem_t *sem)
     ANDROID_MEMBAR_FULL();
     old = __sem_inc(&sem->count);
     if (old < 0) {
-        /* contention on the semaphore, wake up all waiters */
-        __futex_wake_ex(&sem->count, shared, INT_MAX);
+        /* contention on the semaphore, wake up one waiter */
+        __futex_wake_ex(&sem->count, shared, 1);
     }
     else if (old == SEM_MAX_VALUE) {
         /* overflow detected */
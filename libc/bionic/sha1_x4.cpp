@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/sha1.h>
+
+#include <stdint.h>
+#include <string.h>
+
+// SHA-1 is serial within a stream, so the only way to use 128-bit SIMD for
+// it is across streams: lane i of every vector below belongs to stream i.
+#if defined(__ARM_NEON__) || defined(__SSE2__)
+
+typedef uint32_t u32x4 __attribute__((vector_size(16)));
+
+static inline u32x4 splat(uint32_t x) {
+  u32x4 v = { x, x, x, x };
+  return v;
+}
+
+static inline u32x4 rol(u32x4 x, int n) {
+  return (x << splat(n)) | (x >> splat(32 - n));
+}
+
+static inline uint32_t load_be32(const u_char* p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static inline u32x4 expand(u32x4 w[16], int i) {
+  u32x4 v = rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+  w[i & 15] = v;
+  return v;
+}
+
+#define ROUND(f, k, wi) \
+  do { \
+    u32x4 t = rol(a, 5) + (f) + e + splat(k) + (wi); \
+    e = d; d = c; c = rol(b, 30); b = a; a = t; \
+  } while (0)
+
+static void sha1_transform_x4(u32x4 state[5], const u_char* const blocks[4]) {
+  u32x4 w[16];
+  for (int i = 0; i < 16; ++i) {
+    u32x4 v = { load_be32(blocks[0] + 4*i), load_be32(blocks[1] + 4*i),
+                load_be32(blocks[2] + 4*i), load_be32(blocks[3] + 4*i) };
+    w[i] = v;
+  }
+
+  u32x4 a = state[0];
+  u32x4 b = state[1];
+  u32x4 c = state[2];
+  u32x4 d = state[3];
+  u32x4 e = state[4];
+
+  for (int i = 0; i < 16; ++i) {
+    ROUND(d ^ (b & (c ^ d)), 0x5a827999, w[i]);
+  }
+  for (int i = 16; i < 20; ++i) {
+    ROUND(d ^ (b & (c ^ d)), 0x5a827999, expand(w, i));
+  }
+  for (int i = 20; i < 40; ++i) {
+    ROUND(b ^ c ^ d, 0x6ed9eba1, expand(w, i));
+  }
+  for (int i = 40; i < 60; ++i) {
+    ROUND((b & c) | (d & (b | c)), 0x8f1bbcdc, expand(w, i));
+  }
+  for (int i = 60; i < 80; ++i) {
+    ROUND(b ^ c ^ d, 0xca62c1d6, expand(w, i));
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+#undef ROUND
+
+static void sha1_add_count(SHA1_CTX* ctx, u_int len) {
+  // The same bit count bookkeeping as SHA1Update.
+  uint32_t old = ctx->count[0];
+  if ((ctx->count[0] += len << 3) < old) {
+    ctx->count[1] += (len >> 29) + 1;
+  }
+}
+
+void SHA1Update4(SHA1_CTX* ctx[4], const u_char* const data[4], u_int len) {
+  // The lanes have to agree on where they are within a block. Streams
+  // that started together and are fed the same lengths always do.
+  uint32_t offset = (ctx[0]->count[0] >> 3) & 63;
+  for (int i = 1; i < 4; ++i) {
+    if (((ctx[i]->count[0] >> 3) & 63) != offset) {
+      for (int j = 0; j < 4; ++j) {
+        SHA1Update(ctx[j], data[j], len);
+      }
+      return;
+    }
+  }
+
+  // Top up any partially-filled buffers the ordinary way.
+  u_int head = (64 - offset) & 63;
+  if (head > len || len - head < 64) {
+    head = len;
+  }
+  const u_char* p[4];
+  for (int i = 0; i < 4; ++i) {
+    SHA1Update(ctx[i], data[i], head);
+    p[i] = data[i] + head;
+  }
+  len -= head;
+  if (len == 0) {
+    return;
+  }
+
+  u_int bulk = len & ~63u;
+  u32x4 state[5];
+  for (int j = 0; j < 5; ++j) {
+    u32x4 v = { ctx[0]->state[j], ctx[1]->state[j], ctx[2]->state[j], ctx[3]->state[j] };
+    state[j] = v;
+  }
+  for (u_int n = 0; n < bulk; n += 64) {
+    sha1_transform_x4(state, p);
+    for (int i = 0; i < 4; ++i) {
+      p[i] += 64;
+    }
+  }
+  uint32_t lanes[5][4];
+  memcpy(lanes, state, sizeof(lanes));
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 5; ++j) {
+      ctx[i]->state[j] = lanes[j][i];
+    }
+    sha1_add_count(ctx[i], bulk);
+    SHA1Update(ctx[i], p[i], len - bulk);
+  }
+}
+
+#else
+
+void SHA1Update4(SHA1_CTX* ctx[4], const u_char* const data[4], u_int len) {
+  for (int i = 0; i < 4; ++i) {
+    SHA1Update(ctx[i], data[i], len);
+  }
+}
+
+#endif
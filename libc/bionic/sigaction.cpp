@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <signal.h>
+
+#include "pthread_internal.h"
+
+extern "C" int __sigaction(int, const struct sigaction*, struct sigaction*);
+
+typedef void (*sigaction_handler_t)(int, siginfo_t*, void*);
+
+// The caller's handler, for each signal whose handler we've set to signal_trampoline.
+static sigaction_handler_t volatile g_handlers[_NSIG + 1];
+
+// Delivering a signal changes the mask, and returning from the handler changes it back,
+// neither through pthread_sigmask. So every handler installed here runs through this,
+// to have pthread_sigmask stop trusting its copy of the mask on the way in and out.
+static void signal_trampoline(int signal_number, siginfo_t* info, void* context) {
+  pthread_internal_t* thread = __get_thread();
+  if (thread != NULL) {
+    __sigmask_cache_invalidate(thread);
+  }
+  // A handler installed without SA_SIGINFO only looks at its first argument,
+  // so it's fine to call it with all three.
+  g_handlers[signal_number](signal_number, info, context);
+  if (thread != NULL) {
+    __sigmask_cache_invalidate(thread);
+  }
+}
+
+int sigaction(int signal_number, const struct sigaction* act, struct sigaction* oact) {
+  if (signal_number < 1 || signal_number > _NSIG) {
+    return __sigaction(signal_number, act, oact);
+  }
+
+  sigaction_handler_t previous = g_handlers[signal_number];
+
+  // SIG_DFL and SIG_IGN go straight to the kernel, which also means this
+  // doesn't write to memory shared with the parent in a vfork(2) child.
+  struct sigaction kernel_act;
+  const struct sigaction* kernel_act_ptr = act;
+  if (act != NULL && act->sa_handler != SIG_DFL && act->sa_handler != SIG_IGN) {
+    kernel_act = *act;
+    kernel_act.sa_sigaction = signal_trampoline;
+    kernel_act_ptr = &kernel_act;
+    // This has to be in place before the kernel can call the trampoline.
+    g_handlers[signal_number] = act->sa_sigaction;
+  }
+
+  if (__sigaction(signal_number, kernel_act_ptr, oact) == -1) {
+    if (kernel_act_ptr == &kernel_act) {
+      g_handlers[signal_number] = previous;
+    }
+    return -1;
+  }
+
+  if (oact != NULL && oact->sa_sigaction == signal_trampoline) {
+    oact->sa_sigaction = previous;
+  }
+  return 0;
+}
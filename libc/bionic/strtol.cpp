@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#define __STDC_LIMIT_MACROS  // For INTMAX_MIN and friends.
+
+#include <ctype.h>
+#include <endian.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The strtol family, built from one template. Bases 10 and 16 get their own
+// instantiations, so the overflow cutoffs are constants and the multiplies
+// are by constants; base 10 also converts runs of eight digits at a time.
+
+static inline unsigned digit_value(char ch) {
+  unsigned d = static_cast<unsigned char>(ch) - '0';
+  if (d < 10) {
+    return d;
+  }
+  d = (static_cast<unsigned char>(ch) | 0x20) - 'a';
+  return (d < 26) ? d + 10 : 36;
+}
+
+// Converts eight decimal digits at s with a handful of 64-bit operations, or
+// returns false if they aren't all digits. Reads all eight bytes regardless,
+// so it declines if that would cross into the next page.
+static inline bool eight_digits(const char* s, uint64_t* result) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+  if ((reinterpret_cast<uintptr_t>(s) & (PAGE_SIZE - 1)) > PAGE_SIZE - 8) {
+    return false;
+  }
+  uint64_t v;
+  memcpy(&v, s, sizeof(v));
+  // Each byte must be 0x30-0x39: high nibble 3, and still 3 after adding 6.
+  if (((v & 0xf0f0f0f0f0f0f0f0ULL) |
+       (((v + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) >> 4)) != 0x3333333333333333ULL) {
+    return false;
+  }
+  v -= 0x3030303030303030ULL;
+  v = (v * 10) + (v >> 8);  // Pairs of digits.
+  *result = (((v & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))) +
+             (((v >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32)))) >> 32;
+  return true;
+#else
+  (void) s;
+  (void) result;
+  return false;
+#endif
+}
+
+// Accumulates the digits at s into *result, which may be at most kLimit.
+// kBase is 0 for bases only known at run time. Returns the end of the digits.
+template <typename U, U kLimit, unsigned kBase>
+static const char* parse_digits(const char* s, unsigned base, U* result, bool* overflow) {
+  const unsigned b = (kBase != 0) ? kBase : base;
+  const U cutoff = kLimit / b;
+  const unsigned cutlim = kLimit % b;
+  U acc = 0;
+  bool too_big = false;
+  bool try_eight = (kBase == 10);
+  while (true) {
+    if (kBase == 10 && try_eight) {
+      uint64_t eight;
+      if (acc <= (kLimit - 99999999) / 100000000 && eight_digits(s, &eight)) {
+        acc = acc * 100000000 + eight;
+        s += 8;
+        continue;
+      }
+      try_eight = false;
+    }
+    unsigned d = digit_value(*s);
+    if (d >= b) {
+      break;
+    }
+    ++s;
+    if (too_big) {
+      continue;
+    }
+    if (acc > cutoff || (acc == cutoff && d > cutlim)) {
+      too_big = true;
+      continue;
+    }
+    acc = acc * b + d;
+  }
+  *result = acc;
+  *overflow = too_big;
+  return s;
+}
+
+template <typename U, U kLimit>
+static const char* parse_digits(const char* s, int base, U* result, bool* overflow) {
+  if (base == 10) {
+    return parse_digits<U, kLimit, 10>(s, base, result, overflow);
+  } else if (base == 16) {
+    return parse_digits<U, kLimit, 16>(s, base, result, overflow);
+  }
+  return parse_digits<U, kLimit, 0>(s, base, result, overflow);
+}
+
+// T is the result type and U its unsigned counterpart. Unsigned results
+// accept a '-' and negate, as C requires; signed ones saturate to kMin.
+template <typename T, typename U, T kMin, T kMax>
+static T strto(const char* nptr, char** endptr, int base) {
+  const char* s = nptr;
+  while (isspace(static_cast<unsigned char>(*s))) {
+    ++s;
+  }
+  bool neg = false;
+  if (*s == '-') {
+    neg = true;
+    ++s;
+  } else if (*s == '+') {
+    ++s;
+  }
+  if ((base == 0 || base == 16) && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+    s += 2;
+    base = 16;
+  } else if (base == 0) {
+    base = (s[0] == '0') ? 8 : 10;
+  }
+  if (base < 2 || base > 36) {
+    if (endptr != NULL) {
+      *endptr = const_cast<char*>(nptr);
+    }
+    errno = EINVAL;
+    return 0;
+  }
+
+  const bool is_signed = (kMin != 0);
+  const U kNegLimit = is_signed ? static_cast<U>(kMax) + 1 : static_cast<U>(kMax);
+  U value;
+  bool overflow;
+  const char* end = neg ? parse_digits<U, kNegLimit>(s, base, &value, &overflow)
+                        : parse_digits<U, static_cast<U>(kMax)>(s, base, &value, &overflow);
+  if (endptr != NULL) {
+    *endptr = const_cast<char*>((end != s) ? end : nptr);
+  }
+  if (overflow) {
+    errno = ERANGE;
+    return (neg && is_signed) ? kMin : kMax;
+  }
+  return static_cast<T>(neg ? -value : value);
+}
+
+long strtol(const char* s, char** end, int base) {
+  return strto<long, unsigned long, LONG_MIN, LONG_MAX>(s, end, base);
+}
+
+long long strtoll(const char* s, char** end, int base) {
+  return strto<long long, unsigned long long, LLONG_MIN, LLONG_MAX>(s, end, base);
+}
+
+unsigned long strtoul(const char* s, char** end, int base) {
+  return strto<unsigned long, unsigned long, 0, ULONG_MAX>(s, end, base);
+}
+
+unsigned long long strtoull(const char* s, char** end, int base) {
+  return strto<unsigned long long, unsigned long long, 0, ULLONG_MAX>(s, end, base);
+}
+
+intmax_t strtoimax(const char* s, char** end, int base) {
+  return strto<intmax_t, uintmax_t, INTMAX_MIN, INTMAX_MAX>(s, end, base);
+}
+
+uintmax_t strtoumax(const char* s, char** end, int base) {
+  return strto<uintmax_t, uintmax_t, 0, UINTMAX_MAX>(s, end, base);
+}
@@ -35,6 +35,7 @@
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "private/android_filesystem_config.h"
@@ -52,6 +53,13 @@ struct stubs_state_t {
   char group_name_buffer_[32];
   char dir_buffer_[32];
   char sh_buffer_[32];
+  // Whether passwd_ and group_ hold what a lookup of their own id or name would return, so
+  // that asking again for the same one (as ls(1) does for every file) can just return them.
+  // A lookup by name can't vouch for the id: "u0_system" and "system" have the same uid.
+  bool passwd_matches_id_;
+  bool passwd_matches_name_;
+  bool group_matches_id_;
+  bool group_matches_name_;
 };
 
 static int do_getpw_r(int by_name, const char* name, uid_t uid,
@@ -146,6 +154,73 @@ static stubs_state_t* __stubs_state() {
   return s;
 }
 
+// android_ids isn't in any particular order, so it's searched through these indexes of it,
+// sorted by id and by name. Ties keep table order, so the first of any duplicates is found,
+// as a linear scan would.
+static pthread_once_t android_ids_index_once = PTHREAD_ONCE_INIT;
+static const android_id_info* android_ids_by_aid[android_id_count];
+static const android_id_info* android_ids_by_name[android_id_count];
+
+static int compare_by_aid(const void* lhs, const void* rhs) {
+  const android_id_info* a = *reinterpret_cast<const android_id_info* const*>(lhs);
+  const android_id_info* b = *reinterpret_cast<const android_id_info* const*>(rhs);
+  if (a->aid != b->aid) {
+    return (a->aid < b->aid) ? -1 : 1;
+  }
+  return (a < b) ? -1 : (a > b);
+}
+
+static int compare_by_name(const void* lhs, const void* rhs) {
+  const android_id_info* a = *reinterpret_cast<const android_id_info* const*>(lhs);
+  const android_id_info* b = *reinterpret_cast<const android_id_info* const*>(rhs);
+  int result = strcmp(a->name, b->name);
+  if (result != 0) {
+    return result;
+  }
+  return (a < b) ? -1 : (a > b);
+}
+
+static void android_ids_index_init() {
+  for (size_t n = 0; n < android_id_count; ++n) {
+    android_ids_by_aid[n] = android_ids_by_name[n] = android_ids + n;
+  }
+  qsort(android_ids_by_aid, android_id_count, sizeof(android_ids_by_aid[0]), compare_by_aid);
+  qsort(android_ids_by_name, android_id_count, sizeof(android_ids_by_name[0]), compare_by_name);
+}
+
+static const android_id_info* find_android_id_info(unsigned id) {
+  pthread_once(&android_ids_index_once, android_ids_index_init);
+  size_t lo = 0;
+  size_t hi = android_id_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (android_ids_by_aid[mid]->aid < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < android_id_count && android_ids_by_aid[lo]->aid == id) ? android_ids_by_aid[lo] : NULL;
+}
+
+static const android_id_info* find_android_id_info(const char* name) {
+  pthread_once(&android_ids_index_once, android_ids_index_init);
+  size_t lo = 0;
+  size_t hi = android_id_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (strcmp(android_ids_by_name[mid]->name, name) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < android_id_count && strcmp(android_ids_by_name[lo]->name, name) == 0) {
+    return android_ids_by_name[lo];
+  }
+  return NULL;
+}
+
 static passwd* android_iinfo_to_passwd(stubs_state_t* state,
                                        const android_id_info* iinfo) {
   snprintf(state->dir_buffer_, sizeof(state->dir_buffer_), "/");
@@ -170,39 +245,23 @@ static group* android_iinfo_to_group(group* gr,
 }
 
 static passwd* android_id_to_passwd(stubs_state_t* state, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_info(id);
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static passwd* android_name_to_passwd(stubs_state_t* state, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_passwd(state, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_info(name);
+  return (iinfo != NULL) ? android_iinfo_to_passwd(state, iinfo) : NULL;
 }
 
 static group* android_id_to_group(group* gr, unsigned id) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (android_ids[n].aid == id) {
-      return android_iinfo_to_group(gr, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_info(id);
+  return (iinfo != NULL) ? android_iinfo_to_group(gr, iinfo) : NULL;
 }
 
 static group* android_name_to_group(group* gr, const char* name) {
-  for (size_t n = 0; n < android_id_count; ++n) {
-    if (!strcmp(android_ids[n].name, name)) {
-      return android_iinfo_to_group(gr, android_ids + n);
-    }
-  }
-  return NULL;
+  const android_id_info* iinfo = find_android_id_info(name);
+  return (iinfo != NULL) ? android_iinfo_to_group(gr, iinfo) : NULL;
 }
 
 // Translate a user/group name to the corresponding user/group id.
@@ -231,12 +290,11 @@ static unsigned app_id_from_name(const char* name) {
     // end will point to \0 if the strtoul below succeeds.
     appid = strtoul(end+2, &end, 10) + AID_ISOLATED_START;
   } else {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (!strcmp(android_ids[n].name, end + 1)) {
-        appid = android_ids[n].aid;
-        // Move the end pointer to the null terminator.
-        end += strlen(android_ids[n].name) + 1;
-      }
+    const android_id_info* iinfo = find_android_id_info(end + 1);
+    if (iinfo != NULL) {
+      appid = iinfo->aid;
+      // Move the end pointer to the null terminator.
+      end += strlen(iinfo->name) + 1;
     }
   }
 
@@ -268,11 +326,9 @@ static void print_app_name_from_appid_userid(const uid_t appid,
   } else if (userid == 0 && appid >= AID_SHARED_GID_START) {
     snprintf(buffer, bufferlen, "all_a%u", appid - AID_SHARED_GID_START);
   } else if (appid < AID_APP) {
-    for (size_t n = 0; n < android_id_count; n++) {
-      if (android_ids[n].aid == appid) {
-        snprintf(buffer, bufferlen, "u%u_%s", userid, android_ids[n].name);
-        return;
-      }
+    const android_id_info* iinfo = find_android_id_info(appid);
+    if (iinfo != NULL) {
+      snprintf(buffer, bufferlen, "u%u_%s", userid, iinfo->name);
     }
   } else {
     snprintf(buffer, bufferlen, "u%u_a%u", userid, appid - AID_APP);
@@ -342,17 +398,32 @@ static group* app_id_to_group(gid_t gid, stubs_state_t* state) {
 }
 
 
+static passwd* remember_passwd(stubs_state_t* state, passwd* pw, bool by_id) {
+  state->passwd_matches_id_ = by_id && (pw != NULL);
+  state->passwd_matches_name_ = (pw != NULL);
+  return pw;
+}
+
+static group* remember_group(stubs_state_t* state, group* gr, bool by_id) {
+  state->group_matches_id_ = by_id && (gr != NULL);
+  state->group_matches_name_ = (gr != NULL);
+  return gr;
+}
+
 passwd* getpwuid(uid_t uid) { // NOLINT: implementing bad function.
   stubs_state_t* state = __stubs_state();
   if (state == NULL) {
     return NULL;
   }
+  if (state->passwd_matches_id_ && state->passwd_.pw_uid == uid) {
+    return &state->passwd_;
+  }
 
   passwd* pw = android_id_to_passwd(state, uid);
   if (pw != NULL) {
-    return pw;
+    return remember_passwd(state, pw, true);
   }
-  return app_id_to_passwd(uid, state);
+  return remember_passwd(state, app_id_to_passwd(uid, state), true);
 }
 
 passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
@@ -360,12 +431,15 @@ passwd* getpwnam(const char* login) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  if (state->passwd_matches_name_ && strcmp(state->passwd_.pw_name, login) == 0) {
+    return &state->passwd_;
+  }
 
   passwd* pw = android_name_to_passwd(state, login);
   if (pw != NULL) {
-    return pw;
+    return remember_passwd(state, pw, false);
   }
-  return app_id_to_passwd(app_id_from_name(login), state);
+  return remember_passwd(state, app_id_to_passwd(app_id_from_name(login), state), false);
 }
 
 // All users are in just one group, the one passed in.
@@ -388,13 +462,16 @@ group* getgrgid(gid_t gid) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  if (state->group_matches_id_ && state->group_.gr_gid == gid) {
+    return &state->group_;
+  }
 
   group* gr = android_id_to_group(&state->group_, gid);
   if (gr != NULL) {
-    return gr;
+    return remember_group(state, gr, true);
   }
 
-  return app_id_to_group(gid, state);
+  return remember_group(state, app_id_to_group(gid, state), true);
 }
 
 group* getgrnam(const char* name) { // NOLINT: implementing bad function.
@@ -402,12 +479,15 @@ group* getgrnam(const char* name) { // NOLINT: implementing bad function.
   if (state == NULL) {
     return NULL;
   }
+  if (state->group_matches_name_ && strcmp(state->group_.gr_name, name) == 0) {
+    return &state->group_;
+  }
 
   if (android_name_to_group(&state->group_, name) != 0) {
-    return &state->group_;
+    return remember_group(state, &state->group_, false);
   }
 
-  return app_id_to_group(app_id_from_name(name), state);
+  return remember_group(state, app_id_to_group(app_id_from_name(name), state), false);
 }
 
 // We don't have an /etc/networks, so all inputs return NULL.
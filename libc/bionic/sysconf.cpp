@@ -37,6 +37,7 @@
 #include <stdio.h>  // For FOPEN_MAX.
 #include <string.h>
 #include <sys/sysconf.h>
+#include <sys/sysinfo.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -77,7 +78,42 @@ static bool __matches_cpuN(const char* s) {
   return (sscanf(s, "cpu%u%c", &cpu, &dummy) == 1);
 }
 
-static int __sysconf_nprocessors_conf() {
+// Counting CPUs means reading sysfs or procfs, and parallel runtimes ask on every parallel
+// region, so the counts are cached. A CPU coming or going through hotplug shows up once the
+// cached count is older than kCpuCountTtlMs.
+static const int32_t kCpuCountTtlMs = 1000;
+
+struct CachedCount {
+  volatile int32_t value;       // 0 until first counted.
+  volatile int32_t expires_ms;  // CLOCK_MONOTONIC_COARSE, compared allowing for wraparound.
+};
+
+static CachedCount __nprocessors_conf_cache;
+static CachedCount __nprocessors_onln_cache;
+
+static int32_t __coarse_monotonic_ms() {
+  timespec t;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &t) == -1) {
+    clock_gettime(CLOCK_MONOTONIC, &t);
+  }
+  return static_cast<int32_t>(static_cast<uint32_t>(t.tv_sec) * 1000U + t.tv_nsec / 1000000);
+}
+
+// Racing callers may both recount, and one may briefly see the other's new deadline with the
+// old count; either way the answer is at most one TTL stale.
+static int __cached_count(CachedCount* cache, int (*count)()) {
+  int32_t now = __coarse_monotonic_ms();
+  int value = cache->value;
+  if (value != 0 && static_cast<int32_t>(now - cache->expires_ms) < 0) {
+    return value;
+  }
+  value = count();
+  cache->value = value;
+  cache->expires_ms = now + kCpuCountTtlMs;
+  return value;
+}
+
+static int __count_processors_conf() {
   // On x86 kernels you can use /proc/cpuinfo for this, but on ARM kernels offline CPUs disappear
   // from there. This method works on both.
   ScopedReaddir reader("/sys/devices/system/cpu");
@@ -95,7 +131,7 @@ static int __sysconf_nprocessors_conf() {
   return result;
 }
 
-static int __sysconf_nprocessors_onln() {
+static int __count_processors_onln() {
   FILE* fp = fopen("/proc/stat", "r");
   if (fp == NULL) {
     return 1;
@@ -118,31 +154,29 @@ static int __sysconf_nprocessors_onln() {
   return result;
 }
 
-static int __get_meminfo(const char* pattern) {
-  FILE* fp = fopen("/proc/meminfo", "r");
-  if (fp == NULL) {
-    return -1;
-  }
+static int __sysconf_nprocessors_conf() {
+  return __cached_count(&__nprocessors_conf_cache, __count_processors_conf);
+}
 
-  int result = -1;
-  char buf[256];
-  while (fgets(buf, sizeof(buf), fp) != NULL) {
-    long total;
-    if (sscanf(buf, pattern, &total) == 1) {
-      result = (int) (total / (PAGE_SIZE/1024));
-      break;
-    }
-  }
-  fclose(fp);
-  return result;
+static int __sysconf_nprocessors_onln() {
+  return __cached_count(&__nprocessors_onln_cache, __count_processors_onln);
+}
+
+// sysinfo(2) reports the same MemTotal and MemFree as /proc/meminfo without any file I/O.
+static int __sysinfo_to_pages(const struct sysinfo& si, unsigned long amount) {
+  unsigned long long unit = (si.mem_unit != 0) ? si.mem_unit : 1;
+  unsigned long long bytes = static_cast<unsigned long long>(amount) * unit;
+  return static_cast<int>(bytes / PAGE_SIZE);
 }
 
 static int __sysconf_phys_pages() {
-  return __get_meminfo("MemTotal: %ld kB");
+  struct sysinfo si;
+  return (sysinfo(&si) == -1) ? -1 : __sysinfo_to_pages(si, si.totalram);
 }
 
 static int __sysconf_avphys_pages() {
-  return __get_meminfo("MemFree: %ld kB");
+  struct sysinfo si;
+  return (sysinfo(&si) == -1) ? -1 : __sysinfo_to_pages(si, si.freeram);
 }
 
 static int __sysconf_monotonic_clock() {
@@ -307,7 +341,7 @@ int sysconf(int name) {
       return _POSIX_THREAD_DESTRUCTOR_ITERATIONS;
 
     case _SC_THREAD_KEYS_MAX:
-      return (BIONIC_TLS_SLOTS - TLS_SLOT_FIRST_USER_SLOT - GLOBAL_INIT_THREAD_LOCAL_BUFFER_COUNT);
+      return (BIONIC_TLS_KEYS - TLS_SLOT_FIRST_USER_SLOT - GLOBAL_INIT_THREAD_LOCAL_BUFFER_COUNT);
 
     case _SC_THREAD_STACK_MIN:    return PTHREAD_STACK_MIN;
     case _SC_THREAD_THREADS_MAX:  return SYSTEM_THREAD_THREADS_MAX;
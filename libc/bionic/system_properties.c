@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <string.h>
@@ -51,6 +52,7 @@
 
 #include <sys/atomics.h>
 #include <bionic_atomic_inline.h>
+#include "private/bionic_counters.h"
 
 #define ALIGN(x, a) (((x) + (a - 1)) & ~(a - 1))
 
@@ -59,7 +61,17 @@ struct prop_area {
     unsigned volatile serial;
     unsigned magic;
     unsigned version;
-    unsigned reserved[28];
+    /* offset and size of the hash index (see below), or 0 if the area
+     * was created without one */
+    unsigned hash_index;
+    unsigned hash_buckets;
+    unsigned hash_count;
+    /* set once a property couldn't be indexed; misses must then check the trie */
+    unsigned volatile hash_overflow;
+    /* offset and size of the per-prefix change counters, or 0 */
+    unsigned watch_index;
+    unsigned watch_slots;
+    unsigned reserved[22];
     char data[0];
 };
 
@@ -73,6 +85,27 @@ struct prop_info {
 
 typedef struct prop_info prop_info;
 
+/*
+ * A value too long for prop_info.value lives in a blob allocated separately
+ * in the area, and prop_info.value holds a descriptor for it instead. The
+ * descriptor starts with an empty string, so readers that don't know about
+ * long values see the property as "", and it is read and written under the
+ * same serial protocol as an inline value. An update reuses the blob when
+ * the new value fits, and allocates a bigger one otherwise; blobs, like
+ * everything else in the area, are never freed.
+ */
+#define PROP_LONG_VALUE_MAGIC "LV"
+
+struct prop_long_value {
+    char empty;
+    char magic[3];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t capacity;
+};
+
+typedef struct prop_long_value prop_long_value;
+
 /*
  * Properties are stored in a hybrid trie/binary tree structure.
  * Each property's name is delimited at '.' characters, and the tokens are put
@@ -107,6 +140,38 @@ struct prop_bt {
 
 typedef struct prop_bt prop_bt;
 
+/*
+ * Exact-name lookups go through an open-addressed hash index instead of the
+ * trie. The index lives in the data area right after the root node and maps
+ * the hash of a full property name to its prop_info, so a lookup usually
+ * touches one bucket and the prop_info itself. Buckets are filled in but
+ * never cleared, which lets readers probe without any locking: the writer
+ * stores the hash before the offset, and a bucket with a zero offset ends
+ * the probe. (A reader racing with the add of the very property it wants
+ * can miss it, just as if it had looked a moment earlier.) The index is kept
+ * at most three-quarters full; a property that doesn't fit is only in the
+ * trie, and hash_overflow tells readers so.
+ * Walking all properties, or all under a prefix, still uses the trie.
+ */
+#define PROP_HASH_BUCKETS 1024
+
+struct prop_hash_bucket {
+    uint32_t volatile hash;
+    prop_off_t info;
+};
+
+typedef struct prop_hash_bucket prop_hash_bucket;
+
+static uint32_t prop_name_hash(const char *name, size_t namelen)
+{
+    uint32_t hash = 2166136261U;
+    size_t i;
+    for (i = 0; i < namelen; i++) {
+        hash = (hash ^ (uint8_t) name[i]) * 16777619U;
+    }
+    return hash;
+}
+
 static const char property_service_socket[] = "/dev/socket/" PROP_SERVICE_NAME;
 static char property_filename[PATH_MAX] = PROP_FILENAME;
 static bool compat_mode = false;
@@ -116,6 +181,38 @@ prop_area *__system_property_area__ = NULL;
 size_t pa_data_size;
 size_t pa_size;
 
+/*
+ * Watchers of one part of the namespace sleep on a change counter picked by
+ * hashing the prefix they care about, rather than on the area serial that
+ * every change bumps. A change to "a.b.c" bumps the counters for "a", "a.b"
+ * and "a.b.c". Unrelated prefixes that share a counter only cost the odd
+ * spurious wakeup.
+ */
+#define PROP_WATCH_SLOTS 256
+
+static unsigned volatile *watch_slot(const char *prefix, size_t len)
+{
+    prop_area *pa = __system_property_area__;
+    unsigned volatile *slots = (unsigned volatile *) (pa->data + pa->watch_index);
+    return &slots[prop_name_hash(prefix, len) & (pa->watch_slots - 1)];
+}
+
+static void watch_notify(const char *name, size_t namelen)
+{
+    size_t len;
+
+    if (__system_property_area__->watch_slots == 0)
+        return;
+
+    for (len = 1; len <= namelen; len++) {
+        if (len == namelen || name[len] == '.') {
+            unsigned volatile *slot = watch_slot(name, len);
+            (*slot)++;
+            __futex_wake(slot, INT32_MAX);
+        }
+    }
+}
+
 static int get_fd_from_env(void)
 {
     char *env = getenv("ANDROID_PROPERTY_WORKSPACE");
@@ -168,6 +265,14 @@ static int map_prop_area_rw()
     pa->version = PROP_AREA_VERSION;
     /* reserve root node */
     pa->bytes_used = sizeof(prop_bt);
+    /* followed by the hash index */
+    pa->hash_index = pa->bytes_used;
+    pa->hash_buckets = PROP_HASH_BUCKETS;
+    pa->bytes_used += PROP_HASH_BUCKETS * sizeof(prop_hash_bucket);
+    /* and the prefix watch counters */
+    pa->watch_index = pa->bytes_used;
+    pa->watch_slots = PROP_WATCH_SLOTS;
+    pa->bytes_used += PROP_WATCH_SLOTS * sizeof(unsigned);
 
     /* plug into the lib property services */
     __system_property_area__ = pa;
@@ -275,6 +380,25 @@ int __system_properties_init()
     return map_prop_area();
 }
 
+static pthread_once_t prop_area_once = PTHREAD_ONCE_INIT;
+
+static void map_prop_area_once()
+{
+    /* init and the tests map an area explicitly before using it */
+    if (__system_property_area__ == NULL)
+        map_prop_area();
+}
+
+/* libc doesn't map the property area at startup, so that processes that
+ * never look at a property don't pay for the open and mmap. Everything that
+ * needs the area without being handed a prop_info calls this first.
+ */
+static bool prop_area_ready()
+{
+    pthread_once(&prop_area_once, map_prop_area_once);
+    return __system_property_area__ != NULL;
+}
+
 static void *new_prop_obj(size_t size, prop_off_t *off)
 {
     prop_area *pa = __system_property_area__;
@@ -288,6 +412,37 @@ static void *new_prop_obj(size_t size, prop_off_t *off)
     return __system_property_area__->data + *off;
 }
 
+static prop_hash_bucket *hash_index()
+{
+    prop_area *pa = __system_property_area__;
+    return (prop_hash_bucket *) (pa->data + pa->hash_index);
+}
+
+static void hash_index_add(const char *name, uint8_t namelen, prop_off_t info)
+{
+    prop_area *pa = __system_property_area__;
+    prop_hash_bucket *buckets;
+    uint32_t hash, mask, i;
+
+    if (pa->hash_buckets == 0)
+        return;
+
+    if (pa->hash_count >= pa->hash_buckets - pa->hash_buckets / 4) {
+        pa->hash_overflow = 1;
+        return;
+    }
+
+    buckets = hash_index();
+    hash = prop_name_hash(name, namelen);
+    mask = pa->hash_buckets - 1;
+    for (i = hash & mask; buckets[i].info != 0; i = (i + 1) & mask)
+        ;
+    buckets[i].hash = hash;
+    ANDROID_MEMBAR_FULL();
+    buckets[i].info = info;
+    pa->hash_count++;
+}
+
 static prop_bt *new_prop_bt(const char *name, uint8_t namelen, prop_off_t *off)
 {
     prop_off_t off_tmp;
@@ -316,6 +471,7 @@ static prop_info *new_prop_info(const char *name, uint8_t namelen,
         info->value[valuelen] = '\0';
         ANDROID_MEMBAR_FULL();
         *off = off_tmp;
+        hash_index_add(name, namelen, off_tmp);
     }
 
     return info;
@@ -334,6 +490,26 @@ static prop_bt *root_node()
     return to_prop_obj(0);
 }
 
+/* Returns the long value descriptor of 'pi', if the value read at 'serial' has one. */
+static const prop_long_value *long_value(const prop_info *pi, unsigned serial)
+{
+    const prop_long_value *lv = (const prop_long_value *) pi->value;
+
+    if (SERIAL_VALUE_LEN(serial) != 0 || lv->empty != '\0' ||
+            memcmp(lv->magic, PROP_LONG_VALUE_MAGIC, sizeof(lv->magic)) != 0)
+        return NULL;
+    return lv;
+}
+
+/* Returns the blob holding a long value, or NULL if the descriptor is bogus. */
+static const char *long_value_data(const prop_long_value *lv, uint32_t length)
+{
+    if (length > PROP_LONG_VALUE_MAX || lv->offset > pa_data_size ||
+            length > pa_data_size - lv->offset)
+        return NULL;
+    return to_prop_obj(lv->offset);
+}
+
 static int cmp_prop_name(const char *one, uint8_t one_len, const char *two,
         uint8_t two_len)
 {
@@ -430,22 +606,63 @@ static const prop_info *find_property(prop_bt *trie, const char *name,
     }
 }
 
+/* Returns the prop_info for 'name' if the hash index has it. A NULL return
+ * is only final if 'definite' is set; otherwise the trie must be searched.
+ */
+static const prop_info *hash_index_find(const char *name, size_t namelen, bool *definite)
+{
+    prop_area *pa = __system_property_area__;
+    prop_hash_bucket *buckets;
+    uint32_t hash, mask, i;
+
+    *definite = false;
+    if (pa->hash_buckets == 0)
+        return NULL;
+
+    buckets = hash_index();
+    hash = prop_name_hash(name, namelen);
+    mask = pa->hash_buckets - 1;
+    for (i = hash & mask; ; i = (i + 1) & mask) {
+        prop_off_t off = buckets[i].info;
+        if (off == 0)
+            break;
+        if (buckets[i].hash == hash) {
+            prop_info *info = to_prop_obj(off);
+            if (info && !strncmp(info->name, name, namelen) && info->name[namelen] == '\0')
+                return info;
+        }
+    }
+    *definite = !pa->hash_overflow;
+    return NULL;
+}
+
 const prop_info *__system_property_find(const char *name)
 {
+    const prop_info *pi;
+    size_t namelen;
+    bool definite;
+
+    __libc_counter_add(ANDROID_LIBC_COUNTER_PROPERTY_LOOKUPS, 1);
+    if (!prop_area_ready())
+        return NULL;
+
     if (__predict_false(compat_mode)) {
         return __system_property_find_compat(name);
     }
-    return find_property(root_node(), name, strlen(name), NULL, 0, false);
+
+    namelen = strlen(name);
+    pi = hash_index_find(name, namelen, &definite);
+    if (pi || definite)
+        return pi;
+    return find_property(root_node(), name, namelen, NULL, 0, false);
 }
 
-int __system_property_read(const prop_info *pi, char *name, char *value)
+/* Reads a consistent value, and reports the serial number it was read at. */
+static int read_property(const prop_info *pi, char *name, char *value,
+        unsigned *serial_out)
 {
     unsigned serial, len;
 
-    if (__predict_false(compat_mode)) {
-        return __system_property_read_compat(pi, name, value);
-    }
-
     for(;;) {
         serial = pi->serial;
         while(SERIAL_DIRTY(serial)) {
@@ -459,11 +676,22 @@ int __system_property_read(const prop_info *pi, char *name, char *value)
             if(name != 0) {
                 strcpy(name, pi->name);
             }
+            *serial_out = serial;
             return len;
         }
     }
 }
 
+int __system_property_read(const prop_info *pi, char *name, char *value)
+{
+    unsigned serial;
+
+    if (__predict_false(compat_mode)) {
+        return __system_property_read_compat(pi, name, value);
+    }
+    return read_property(pi, name, value, &serial);
+}
+
 int __system_property_get(const char *name, char *value)
 {
     const prop_info *pi = __system_property_find(name);
@@ -476,20 +704,125 @@ int __system_property_get(const char *name, char *value)
     }
 }
 
+int __system_property_read_long(const prop_info *pi, char *value, size_t size)
+{
+    unsigned serial, len;
 
-static int send_prop_msg(prop_msg *msg)
+    if (__predict_false(compat_mode)) {
+        char short_value[PROP_VALUE_MAX];
+        len = __system_property_read_compat(pi, 0, short_value);
+        if (size > 0)
+            strlcpy(value, short_value, size);
+        return len;
+    }
+
+    for(;;) {
+        const prop_long_value *lv;
+        const char *src;
+        size_t copy;
+
+        serial = pi->serial;
+        while(SERIAL_DIRTY(serial)) {
+            __futex_wait((volatile void *)&pi->serial, serial, 0);
+            serial = pi->serial;
+        }
+        ANDROID_MEMBAR_FULL();
+
+        lv = long_value(pi, serial);
+        if (lv != NULL) {
+            len = lv->length;
+            src = long_value_data(lv, len);
+            if (src == NULL)
+                len = 0;
+        } else {
+            len = SERIAL_VALUE_LEN(serial);
+            src = pi->value;
+        }
+
+        copy = (size > 0 && len >= size) ? size - 1 : len;
+        if (size > 0) {
+            if (copy > 0)
+                memcpy(value, src, copy);
+            value[copy] = '\0';
+        }
+        ANDROID_MEMBAR_FULL();
+        if(serial == pi->serial) {
+            return len;
+        }
+    }
+}
+
+int __system_property_get_long(const char *name, char *value, size_t size)
+{
+    const prop_info *pi = __system_property_find(name);
+
+    if(pi != 0) {
+        return __system_property_read_long(pi, value, size);
+    } else {
+        if (size > 0)
+            value[0] = 0;
+        return 0;
+    }
+}
+
+void __system_property_cache_init(prop_cache_t *cache, const char *name)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->name = name;
+    cache->len = -1;
+}
+
+int __system_property_cached_read(prop_cache_t *cache)
+{
+    const prop_info *pi = cache->pi;
+    unsigned serial;
+
+    if (pi == NULL && !prop_area_ready()) {
+        cache->value[0] = 0;
+        return 0;
+    }
+
+    if (__predict_false(compat_mode)) {
+        cache->len = __system_property_get(cache->name, cache->value);
+        return cache->len;
+    }
+
+    if (pi == NULL) {
+        /* Sample the area serial before looking, so that a property added
+         * while we search is found next time rather than missed for good.
+         */
+        unsigned area_serial = __system_property_area__->serial;
+        if (cache->len >= 0 && area_serial == cache->area_serial) {
+            return cache->len;
+        }
+        cache->area_serial = area_serial;
+        ANDROID_MEMBAR_FULL();
+        pi = __system_property_find(cache->name);
+        if (pi == NULL) {
+            cache->value[0] = 0;
+            cache->len = 0;
+            return 0;
+        }
+        cache->pi = pi;
+    } else if (cache->len >= 0 && pi->serial == cache->serial) {
+        return cache->len;
+    }
+
+    cache->len = read_property(pi, NULL, cache->value, &serial);
+    cache->serial = serial;
+    return cache->len;
+}
+
+static int connect_prop_service()
 {
-    struct pollfd pollfds[1];
     struct sockaddr_un addr;
     socklen_t alen;
     size_t namelen;
     int s;
-    int r;
-    int result = -1;
 
     s = socket(AF_LOCAL, SOCK_STREAM, 0);
     if(s < 0) {
-        return result;
+        return -1;
     }
 
     memset(&addr, 0, sizeof(addr));
@@ -500,57 +833,84 @@ static int send_prop_msg(prop_msg *msg)
 
     if(TEMP_FAILURE_RETRY(connect(s, (struct sockaddr *) &addr, alen)) < 0) {
         close(s);
+        return -1;
+    }
+    return s;
+}
+
+static void wait_prop_service_done(int s)
+{
+    struct pollfd pollfds[1];
+
+    // We successfully wrote to the property server but now we
+    // wait for the property server to finish its work.  It
+    // acknowledges its completion by closing the socket so we
+    // poll here (on nothing), waiting for the socket to close.
+    // If you 'adb shell setprop foo bar' you'll see the POLLHUP
+    // once the socket closes.  Out of paranoia we cap our poll
+    // at 250 ms.
+    //
+    // If the poll times out we carry on anyway.  The init process
+    // is single-threaded and its property service is sometimes
+    // slow to respond (perhaps it's off starting a child process or
+    // something) and thus this times out and the caller thinks it
+    // failed, even though it's still getting around to it.  So we
+    // fake it here, mostly for ctl.* properties, but we do try and
+    // wait 250 ms so callers who do read-after-write can reliably
+    // see what they've written.  Most of the time.
+    // TODO: fix the system properties design.
+    pollfds[0].fd = s;
+    pollfds[0].events = 0;
+    TEMP_FAILURE_RETRY(poll(pollfds, 1, 250 /* ms */));
+}
+
+static int send_prop_msg(prop_msg *msg)
+{
+    int s;
+    int r;
+    int result = -1;
+
+    s = connect_prop_service();
+    if(s < 0) {
         return result;
     }
 
     r = TEMP_FAILURE_RETRY(send(s, msg, sizeof(prop_msg), 0));
 
     if(r == sizeof(prop_msg)) {
-        // We successfully wrote to the property server but now we
-        // wait for the property server to finish its work.  It
-        // acknowledges its completion by closing the socket so we
-        // poll here (on nothing), waiting for the socket to close.
-        // If you 'adb shell setprop foo bar' you'll see the POLLHUP
-        // once the socket closes.  Out of paranoia we cap our poll
-        // at 250 ms.
-        pollfds[0].fd = s;
-        pollfds[0].events = 0;
-        r = TEMP_FAILURE_RETRY(poll(pollfds, 1, 250 /* ms */));
-        if (r == 1 && (pollfds[0].revents & POLLHUP) != 0) {
-            result = 0;
-        } else {
-            // Ignore the timeout and treat it like a success anyway.
-            // The init process is single-threaded and its property
-            // service is sometimes slow to respond (perhaps it's off
-            // starting a child process or something) and thus this
-            // times out and the caller thinks it failed, even though
-            // it's still getting around to it.  So we fake it here,
-            // mostly for ctl.* properties, but we do try and wait 250
-            // ms so callers who do read-after-write can reliably see
-            // what they've written.  Most of the time.
-            // TODO: fix the system properties design.
-            result = 0;
-        }
+        wait_prop_service_done(s);
+        result = 0;
     }
 
     close(s);
     return result;
 }
 
-int __system_property_set(const char *key, const char *value)
+static int check_prop_set_args(const char *key, const char *value)
 {
-    int err;
-    prop_msg msg;
-
     if(key == 0) return -1;
     if(value == 0) value = "";
     if(strlen(key) >= PROP_NAME_MAX) return -1;
     if(strlen(value) >= PROP_VALUE_MAX) return -1;
+    return 0;
+}
+
+static void fill_prop_msg(prop_msg *msg, unsigned cmd, const char *key, const char *value)
+{
+    memset(msg, 0, sizeof *msg);
+    msg->cmd = cmd;
+    strlcpy(msg->name, key, sizeof msg->name);
+    strlcpy(msg->value, value ? value : "", sizeof msg->value);
+}
 
-    memset(&msg, 0, sizeof msg);
-    msg.cmd = PROP_MSG_SETPROP;
-    strlcpy(msg.name, key, sizeof msg.name);
-    strlcpy(msg.value, value, sizeof msg.value);
+int __system_property_set(const char *key, const char *value)
+{
+    int err;
+    prop_msg msg;
+
+    if(check_prop_set_args(key, value) < 0) return -1;
+
+    fill_prop_msg(&msg, PROP_MSG_SETPROP, key, value);
 
     err = send_prop_msg(&msg);
     if(err < 0) {
@@ -560,10 +920,92 @@ int __system_property_set(const char *key, const char *value)
     return 0;
 }
 
+/* Sends a batch over one connection. Returns 0 on success, 1 if the
+ * property service doesn't support batches, or -1 on error. */
+static int send_prop_batch(const char * const *keys, const char * const *values,
+        size_t count)
+{
+    struct pollfd pollfds[1];
+    prop_msg msg;
+    char ack;
+    size_t i;
+    int result = -1;
+    int s;
+
+    s = connect_prop_service();
+    if(s < 0) {
+        return -1;
+    }
+
+    fill_prop_msg(&msg, PROP_MSG_SETPROP_BATCH, "", NULL);
+    snprintf(msg.value, sizeof msg.value, "%zu", count);
+    if(TEMP_FAILURE_RETRY(send(s, &msg, sizeof(msg), 0)) != sizeof(msg)) {
+        goto out;
+    }
+
+    // An init that understands batches acknowledges the header; an older one
+    // ignores the unknown command and hangs up without a word.
+    pollfds[0].fd = s;
+    pollfds[0].events = POLLIN;
+    if(TEMP_FAILURE_RETRY(poll(pollfds, 1, 250 /* ms */)) != 1 ||
+            TEMP_FAILURE_RETRY(recv(s, &ack, 1, 0)) != 1 ||
+            ack != PROP_BATCH_ACK) {
+        result = 1;
+        goto out;
+    }
+
+    for(i = 0; i < count; i++) {
+        fill_prop_msg(&msg, PROP_MSG_SETPROP, keys[i], values[i]);
+        if(TEMP_FAILURE_RETRY(send(s, &msg, sizeof(msg), 0)) != sizeof(msg)) {
+            goto out;
+        }
+    }
+
+    wait_prop_service_done(s);
+    result = 0;
+
+out:
+    close(s);
+    return result;
+}
+
+int __system_property_set_batch(const char * const *keys, const char * const *values,
+        size_t count)
+{
+    size_t i;
+    int rc;
+
+    for(i = 0; i < count; i++) {
+        if(check_prop_set_args(keys[i], values[i]) < 0) return -1;
+    }
+
+    for(i = 0; i < count; i += PROP_BATCH_MAX) {
+        size_t n = count - i;
+        if(n > PROP_BATCH_MAX) n = PROP_BATCH_MAX;
+
+        rc = send_prop_batch(keys + i, values + i, n);
+        if(rc < 0) {
+            return -1;
+        }
+        if(rc == 1) {
+            // No batch support: fall back to a connection per property.
+            for(; i < count; i++) {
+                if(__system_property_set(keys[i], values[i]) < 0) {
+                    return -1;
+                }
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
 int __system_property_wait(const prop_info *pi)
 {
     unsigned n;
     if(pi == 0) {
+        if (!prop_area_ready())
+            return 0;
         prop_area *pa = __system_property_area__;
         n = pa->serial;
         do {
@@ -588,16 +1030,83 @@ int __system_property_update(prop_info *pi, const char *value, unsigned int len)
     pi->serial = pi->serial | 1;
     ANDROID_MEMBAR_FULL();
     memcpy(pi->value, value, len + 1);
+    /* clear anything after the value, such as a long value descriptor */
+    memset(pi->value + len + 1, 0, PROP_VALUE_MAX - len - 1);
     ANDROID_MEMBAR_FULL();
     pi->serial = (len << 24) | ((pi->serial + 1) & 0xffffff);
     __futex_wake(&pi->serial, INT32_MAX);
 
+    watch_notify(pi->name, strlen(pi->name));
     pa->serial++;
     __futex_wake(&pa->serial, INT32_MAX);
 
     return 0;
 }
 
+int __system_property_update_long(prop_info *pi, const char *value, unsigned int len)
+{
+    prop_area *pa = __system_property_area__;
+    prop_long_value *lv;
+    prop_off_t off;
+    uint32_t capacity;
+    char *blob;
+
+    if (len < PROP_VALUE_MAX)
+        return __system_property_update(pi, value, len);
+    if (len > PROP_LONG_VALUE_MAX)
+        return -1;
+
+    lv = (prop_long_value *) long_value(pi, pi->serial);
+    if (lv != NULL && lv->capacity >= len + 1) {
+        off = lv->offset;
+        capacity = lv->capacity;
+        blob = to_prop_obj(off);
+    } else {
+        capacity = ALIGN(len + 1, sizeof(uint32_t));
+        blob = new_prop_obj(capacity, &off);
+        if (blob == NULL)
+            return -1;
+    }
+    lv = (prop_long_value *) pi->value;
+
+    pi->serial = pi->serial | 1;
+    ANDROID_MEMBAR_FULL();
+    memcpy(blob, value, len);
+    blob[len] = '\0';
+    memset(pi->value, 0, PROP_VALUE_MAX);
+    memcpy(lv->magic, PROP_LONG_VALUE_MAGIC, sizeof(lv->magic));
+    lv->offset = off;
+    lv->length = len;
+    lv->capacity = capacity;
+    ANDROID_MEMBAR_FULL();
+    pi->serial = (pi->serial + 1) & 0xffffff;
+    __futex_wake(&pi->serial, INT32_MAX);
+
+    watch_notify(pi->name, strlen(pi->name));
+    pa->serial++;
+    __futex_wake(&pa->serial, INT32_MAX);
+
+    return 0;
+}
+
+int __system_property_add_long(const char *name, unsigned int namelen,
+            const char *value, unsigned int valuelen)
+{
+    prop_info *pi;
+
+    if (valuelen < PROP_VALUE_MAX)
+        return __system_property_add(name, namelen, value, valuelen);
+    if (valuelen > PROP_LONG_VALUE_MAX)
+        return -1;
+
+    if (__system_property_add(name, namelen, "", 0) < 0)
+        return -1;
+    pi = (prop_info *) find_property(root_node(), name, namelen, NULL, 0, false);
+    if (!pi)
+        return -1;
+    return __system_property_update_long(pi, value, valuelen);
+}
+
 int __system_property_add(const char *name, unsigned int namelen,
             const char *value, unsigned int valuelen)
 {
@@ -615,6 +1124,7 @@ int __system_property_add(const char *name, unsigned int namelen,
     if (!pi)
         return -1;
 
+    watch_notify(name, namelen);
     pa->serial++;
     __futex_wake(&pa->serial, INT32_MAX);
     return 0;
@@ -627,7 +1137,11 @@ unsigned int __system_property_serial(const prop_info *pi)
 
 unsigned int __system_property_wait_any(unsigned int serial)
 {
-    prop_area *pa = __system_property_area__;
+    prop_area *pa;
+
+    if (!prop_area_ready())
+        return serial;
+    pa = __system_property_area__;
 
     do {
         __futex_wait(&pa->serial, serial, 0);
@@ -636,6 +1150,30 @@ unsigned int __system_property_wait_any(unsigned int serial)
     return pa->serial;
 }
 
+unsigned int __system_property_wait_prefix(const char *prefix, unsigned int serial)
+{
+    prop_area *pa;
+    unsigned volatile *slot;
+    size_t len = strlen(prefix);
+
+    if (!prop_area_ready())
+        return serial;
+    pa = __system_property_area__;
+
+    /* "a.b." watches the same names as "a.b" */
+    while (len > 0 && prefix[len - 1] == '.')
+        len--;
+
+    if (pa->watch_slots == 0 || len == 0)
+        return __system_property_wait_any(serial);
+
+    slot = watch_slot(prefix, len);
+    while (*slot == serial) {
+        __futex_wait(slot, serial, 0);
+    }
+    return *slot;
+}
+
 struct find_nth_cookie {
     unsigned count;
     unsigned n;
@@ -702,8 +1240,90 @@ static int foreach_property(prop_off_t off,
 int __system_property_foreach(void (*propfn)(const prop_info *pi, void *cookie),
         void *cookie)
 {
+    if (!prop_area_ready())
+        return -1;
+
     if (__predict_false(compat_mode)) {
         return __system_property_foreach_compat(propfn, cookie);
 	}
     return foreach_property(0, propfn, cookie);
 }
+
+struct foreach_view_cookie {
+    void (*viewfn)(const prop_view_t *view, void *cookie);
+    void *cookie;
+};
+
+static void foreach_view_fn(const prop_info *pi, void *ptr)
+{
+    struct foreach_view_cookie *cookie = ptr;
+    const prop_long_value *lv;
+    prop_view_t view;
+    unsigned serial;
+
+    serial = pi->serial;
+    while (SERIAL_DIRTY(serial)) {
+        __futex_wait((volatile void *)&pi->serial, serial, 0);
+        serial = pi->serial;
+    }
+    ANDROID_MEMBAR_FULL();
+
+    view.pi = pi;
+    view.name = pi->name;
+    view.name_len = strlen(pi->name);
+    view.value = pi->value;
+    view.value_len = SERIAL_VALUE_LEN(serial);
+    view.serial = serial;
+    lv = long_value(pi, serial);
+    if (lv != NULL) {
+        uint32_t length = lv->length;
+        const char *data = long_value_data(lv, length);
+        if (data != NULL) {
+            view.value = data;
+            view.value_len = length;
+        }
+    }
+    cookie->viewfn(&view, cookie->cookie);
+}
+
+static void foreach_view_compat_fn(const prop_info *pi, void *ptr)
+{
+    struct foreach_view_cookie *cookie = ptr;
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+    prop_view_t view;
+
+    /* The old layout has no serial to check, so hand out copies. */
+    view.pi = pi;
+    view.value_len = __system_property_read_compat(pi, name, value);
+    view.value = value;
+    view.name = name;
+    view.name_len = strlen(name);
+    view.serial = 0;
+    cookie->viewfn(&view, cookie->cookie);
+}
+
+int __system_property_foreach_view(
+        void (*viewfn)(const prop_view_t *view, void *cookie),
+        void *cookie)
+{
+    struct foreach_view_cookie view_cookie;
+
+    view_cookie.viewfn = viewfn;
+    view_cookie.cookie = cookie;
+    if (!prop_area_ready())
+        return -1;
+    if (__predict_false(compat_mode)) {
+        return __system_property_foreach_compat(foreach_view_compat_fn, &view_cookie);
+    }
+    return foreach_property(0, foreach_view_fn, &view_cookie);
+}
+
+int __system_property_view_valid(const prop_view_t *view)
+{
+    if (__predict_false(compat_mode)) {
+        return 1;
+    }
+    ANDROID_MEMBAR_FULL();
+    return view->pi->serial == view->serial;
+}
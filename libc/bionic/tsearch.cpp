@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _SEARCH_PRIVATE
+#include <search.h>
+#include <stdlib.h>
+
+// The tsearch family on AVL trees, so that inserting keys in order (ids, say)
+// doesn't leave a linked list. No node has a parent link: a node_t must stay
+// key-first for callers, so insertion and deletion remember the path down
+// instead. An AVL tree is at most 1.44 log2(n) deep, so that path is
+// bounded by the address space.
+static const size_t kMaxDepth = sizeof(void*) * 8 * 3 / 2;
+
+static int height(const node_t* n) {
+  return (n != NULL) ? n->height : 0;
+}
+
+static void update_height(node_t* n) {
+  int l = height(n->llink);
+  int r = height(n->rlink);
+  n->height = ((l > r) ? l : r) + 1;
+}
+
+static node_t* rotate_right(node_t* n) {
+  node_t* l = n->llink;
+  n->llink = l->rlink;
+  l->rlink = n;
+  update_height(n);
+  update_height(l);
+  return l;
+}
+
+static node_t* rotate_left(node_t* n) {
+  node_t* r = n->rlink;
+  n->rlink = r->llink;
+  r->llink = n;
+  update_height(n);
+  update_height(r);
+  return r;
+}
+
+static node_t* rebalance(node_t* n) {
+  int balance = height(n->llink) - height(n->rlink);
+  if (balance > 1) {
+    if (height(n->llink->llink) < height(n->llink->rlink)) {
+      n->llink = rotate_left(n->llink);
+    }
+    return rotate_right(n);
+  }
+  if (balance < -1) {
+    if (height(n->rlink->rlink) < height(n->rlink->llink)) {
+      n->rlink = rotate_right(n->rlink);
+    }
+    return rotate_left(n);
+  }
+  update_height(n);
+  return n;
+}
+
+// Rebalances each subtree on the path, deepest first, until one's height
+// comes out unchanged: nothing above it can have changed either.
+static void rebalance_path(node_t** path[], size_t depth) {
+  while (depth > 0) {
+    node_t** link = path[--depth];
+    int old_height = (*link)->height;
+    *link = rebalance(*link);
+    if ((*link)->height == old_height) {
+      return;
+    }
+  }
+}
+
+void* tsearch(const void* key, void** rootp, int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+
+  node_t** path[kMaxDepth];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(rootp);
+  while (*link != NULL) {
+    int r = (*compar)(key, (*link)->key);
+    if (r == 0) {
+      return *link;
+    }
+    path[depth++] = link;
+    link = (r < 0) ? &(*link)->llink : &(*link)->rlink;
+  }
+
+  node_t* q = reinterpret_cast<node_t*>(malloc(sizeof(node_t)));
+  if (q == NULL) {
+    return NULL;
+  }
+  q->key = const_cast<char*>(reinterpret_cast<const char*>(key));
+  q->llink = q->rlink = NULL;
+  q->height = 1;
+  *link = q;
+  rebalance_path(path, depth);
+  return q;
+}
+
+void* tfind(const void* key, void* const* rootp, int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+
+  node_t* n = *reinterpret_cast<node_t* const*>(rootp);
+  while (n != NULL) {
+    int r = (*compar)(key, n->key);
+    if (r == 0) {
+      return n;
+    }
+    n = (r < 0) ? n->llink : n->rlink;
+  }
+  return NULL;
+}
+
+// Returns the deleted node's parent or, if it was the root, rootp.
+void* tdelete(const void* key, void** rootp, int (*compar)(const void*, const void*)) {
+  if (rootp == NULL) {
+    return NULL;
+  }
+
+  node_t** path[kMaxDepth];
+  size_t depth = 0;
+  node_t** link = reinterpret_cast<node_t**>(rootp);
+  while (true) {
+    if (*link == NULL) {
+      return NULL;
+    }
+    int r = (*compar)(key, (*link)->key);
+    if (r == 0) {
+      break;
+    }
+    path[depth++] = link;
+    link = (r < 0) ? &(*link)->llink : &(*link)->rlink;
+  }
+  void* parent = (depth > 0) ? static_cast<void*>(*path[depth - 1]) : static_cast<void*>(rootp);
+
+  node_t* deleted = *link;
+  if (deleted->llink == NULL || deleted->rlink == NULL) {
+    *link = (deleted->llink != NULL) ? deleted->llink : deleted->rlink;
+  } else {
+    // Put the in-order successor in the deleted node's place.
+    path[depth++] = link;
+    size_t replaced = depth;
+    node_t** s = &deleted->rlink;
+    while ((*s)->llink != NULL) {
+      path[depth++] = s;
+      s = &(*s)->llink;
+    }
+    node_t* successor = *s;
+    *s = successor->rlink;
+    successor->llink = deleted->llink;
+    successor->rlink = deleted->rlink;
+    successor->height = deleted->height;
+    *link = successor;
+    // The first step down from here went through the deleted node.
+    if (depth > replaced) {
+      path[replaced] = &successor->rlink;
+    }
+  }
+  free(deleted);
+  rebalance_path(path, depth);
+  return parent;
+}
+
+static void walk(const node_t* n, void (*action)(const void*, VISIT, int), int level) {
+  if (n->llink == NULL && n->rlink == NULL) {
+    (*action)(n, leaf, level);
+    return;
+  }
+  (*action)(n, preorder, level);
+  if (n->llink != NULL) {
+    walk(n->llink, action, level + 1);
+  }
+  (*action)(n, postorder, level);
+  if (n->rlink != NULL) {
+    walk(n->rlink, action, level + 1);
+  }
+  (*action)(n, endorder, level);
+}
+
+void twalk(const void* root, void (*action)(const void*, VISIT, int)) {
+  if (root != NULL && action != NULL) {
+    walk(reinterpret_cast<const node_t*>(root), action, 0);
+  }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <elf.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/auxv.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "libc_init_common.h"
+
+// The raw system calls (see SYSCALLS.TXT).
+extern "C" int __clock_gettime(clockid_t, timespec*);
+extern "C" int __gettimeofday(timeval*, struct timezone*);
+
+typedef int (*ClockGettimeFn)(clockid_t, timespec*);
+typedef int (*GettimeofdayFn)(timeval*, struct timezone*);
+
+// Entry points in the kernel's vDSO, or NULL if it doesn't have them. They're
+// filled in by __libc_init_vdso() before any other thread can exist.
+static ClockGettimeFn gVdsoClockGettime = NULL;
+static GettimeofdayFn gVdsoGettimeofday = NULL;
+
+int clock_gettime(clockid_t clock_id, timespec* tp) {
+  ClockGettimeFn vdso_clock_gettime = gVdsoClockGettime;
+  // The vDSO returns -errno rather than setting errno, and for clocks it
+  // can't read from user space it makes the system call anyway. Either way,
+  // let the system call report the error.
+  if (__predict_true(vdso_clock_gettime != NULL) && vdso_clock_gettime(clock_id, tp) == 0) {
+    return 0;
+  }
+  return __clock_gettime(clock_id, tp);
+}
+
+int gettimeofday(timeval* tv, struct timezone* tz) {
+  GettimeofdayFn vdso_gettimeofday = gVdsoGettimeofday;
+  if (__predict_true(vdso_gettimeofday != NULL) && vdso_gettimeofday(tv, tz) == 0) {
+    return 0;
+  }
+  return __gettimeofday(tv, tz);
+}
+
+// Looks up the vDSO's exports by walking its dynamic symbol table. The vDSO
+// is already mapped, so all we have to do is account for where: its
+// addresses are relative to the vaddr of its single PT_LOAD.
+void __libc_init_vdso() {
+  Elf32_Ehdr* ehdr = reinterpret_cast<Elf32_Ehdr*>(getauxval(AT_SYSINFO_EHDR));
+  if (ehdr == NULL || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0) {
+    return;
+  }
+
+  uintptr_t base = reinterpret_cast<uintptr_t>(ehdr);
+  Elf32_Phdr* phdr = reinterpret_cast<Elf32_Phdr*>(base + ehdr->e_phoff);
+  Elf32_Dyn* dynamic = NULL;
+  uintptr_t load_bias = 0;
+  bool found_load = false;
+  for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+    if (phdr[i].p_type == PT_LOAD && !found_load) {
+      load_bias = base + phdr[i].p_offset - phdr[i].p_vaddr;
+      found_load = true;
+    } else if (phdr[i].p_type == PT_DYNAMIC) {
+      dynamic = reinterpret_cast<Elf32_Dyn*>(base + phdr[i].p_offset);
+    }
+  }
+  if (!found_load || dynamic == NULL) {
+    return;
+  }
+
+  Elf32_Sym* symtab = NULL;
+  const char* strtab = NULL;
+  Elf32_Word* hash = NULL;
+  for (Elf32_Dyn* d = dynamic; d->d_tag != DT_NULL; ++d) {
+    if (d->d_tag == DT_SYMTAB) {
+      symtab = reinterpret_cast<Elf32_Sym*>(load_bias + d->d_un.d_ptr);
+    } else if (d->d_tag == DT_STRTAB) {
+      strtab = reinterpret_cast<const char*>(load_bias + d->d_un.d_ptr);
+    } else if (d->d_tag == DT_HASH) {
+      hash = reinterpret_cast<Elf32_Word*>(load_bias + d->d_un.d_ptr);
+    }
+  }
+  // Every architecture's vDSO has a SysV hash table, whose nchain is the
+  // number of symbols.
+  if (symtab == NULL || strtab == NULL || hash == NULL) {
+    return;
+  }
+
+  size_t symbol_count = hash[1];
+  for (size_t i = 0; i < symbol_count; ++i) {
+    Elf32_Sym* sym = &symtab[i];
+    if (ELF32_ST_TYPE(sym->st_info) != STT_FUNC || sym->st_shndx == SHN_UNDEF) {
+      continue;
+    }
+    const char* name = strtab + sym->st_name;
+    void* address = reinterpret_cast<void*>(load_bias + sym->st_value);
+    if (strcmp(name, "__vdso_clock_gettime") == 0) {
+      gVdsoClockGettime = reinterpret_cast<ClockGettimeFn>(address);
+    } else if (strcmp(name, "__vdso_gettimeofday") == 0) {
+      gVdsoGettimeofday = reinterpret_cast<GettimeofdayFn>(address);
+    }
+  }
+}
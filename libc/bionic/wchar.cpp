@@ -27,7 +27,6 @@
  */
 
 #include <ctype.h>
-#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -66,34 +65,34 @@ int vwprintf(const wchar_t* format, va_list arg) {
   return vfwprintf(stdout, format, arg);
 }
 
-int vfwprintf(FILE* /*stream*/, const wchar_t* /*format*/, va_list /*arg*/) {
-  errno = ENOTSUP;
-  return -1;
+int fwscanf(FILE* stream, const wchar_t* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int result = vfwscanf(stream, format, args);
+  va_end(args);
+  return result;
 }
 
-int vswprintf(wchar_t* /*s*/, size_t /*n*/, const wchar_t* /*format*/, va_list /*arg*/) {
-  errno = ENOTSUP;
-  return -1;
+int wscanf(const wchar_t* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int result = vwscanf(format, args);
+  va_end(args);
+  return result;
 }
 
-int fwscanf(FILE* /*stream*/, const wchar_t* /*format*/, ... ) {
-  errno = ENOTSUP;
-  return -1;
+int vwscanf(const wchar_t* format, va_list arg) {
+  return vfwscanf(stdin, format, arg);
 }
 
-int wscanf(const wchar_t* format, ... ) {
+int swscanf(const wchar_t* s, const wchar_t* format, ...) {
   va_list args;
-  va_start (args, format);
-  int result = fwscanf(stdout, format, args );
-  va_end (args);
+  va_start(args, format);
+  int result = vswscanf(s, format, args);
+  va_end(args);
   return result;
 }
 
-int swscanf(const wchar_t* /*s*/, const wchar_t* /*format*/, ... ) {
-  errno = ENOTSUP;
-  return -1;
-}
-
 int iswalnum(wint_t wc) { return isalnum(wc); }
 int iswalpha(wint_t wc) { return isalpha(wc); }
 int iswcntrl(wint_t wc) { return iscntrl(wc); }
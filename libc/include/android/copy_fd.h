@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_COPY_FD_H__
+#define __ANDROID_COPY_FD_H__
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/* Copies up to 'count' bytes, or UINT64_MAX for everything, from the current
+ * offset of 'in_fd' to the current offset of 'out_fd', advancing both, without
+ * the data passing through user space where the kernel allows. sendfile(2) is
+ * tried first, then splice(2) through a pipe (or directly, if either end is
+ * one), then read(2) and write(2). Both descriptors should be blocking.
+ * Returns 0, having copied fewer than 'count' bytes only at end of file, or -1
+ * and sets errno. Either way, '*copied' gets how many were copied if 'copied'
+ * isn't NULL.
+ */
+extern int android_copy_fd(int out_fd, int in_fd, uint64_t count, uint64_t* copied);
+
+__END_DECLS
+
+#endif /* __ANDROID_COPY_FD_H__ */
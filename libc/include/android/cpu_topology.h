@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_CPU_TOPOLOGY_H__
+#define __ANDROID_CPU_TOPOLOGY_H__
+
+#include <sched.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+#define ANDROID_CPU_CLUSTERS_MAX 8
+
+typedef struct {
+  /* CPUs in the cluster, whether or not they're currently online */
+  cpu_set_t cpus;
+  /* Relative compute capacity of one CPU in the cluster. This is the kernel's
+   * cpu_capacity where it exports one, and the maximum frequency in kHz
+   * otherwise, so only compare it with other clusters of the same topology.
+   */
+  unsigned  capacity;
+  /* Maximum frequency in kHz, or 0 if cpufreq isn't available */
+  unsigned  max_freq_khz;
+} android_cpu_cluster_t;
+
+typedef struct {
+  /* Number of CPUs the kernel could bring online */
+  int                    cpu_count;
+  /* CPUs that were online when the topology was read */
+  cpu_set_t              online;
+  /* Clusters of cores, sorted by increasing capacity: the last is the "big" one */
+  size_t                 cluster_count;
+  android_cpu_cluster_t  clusters[ANDROID_CPU_CLUSTERS_MAX];
+  /* Index into 'clusters' of each CPU */
+  int                    cluster_of_cpu[CPU_SETSIZE];
+  /* CPUs sharing an L2 cache with each CPU (including itself) */
+  cpu_set_t              l2_shared[CPU_SETSIZE];
+} android_cpu_topology_t;
+
+/* Copies the CPU topology into 'topology'. It's read from sysfs on first use
+ * and cached; call android_refresh_cpu_topology() after CPUs are hotplugged
+ * to pick up the new online mask. Returns 0 on success, or -1 and sets errno.
+ */
+extern int android_get_cpu_topology(android_cpu_topology_t* topology);
+
+/* Rereads the CPU topology from sysfs. Returns 0 on success, or -1 and sets errno. */
+extern int android_refresh_cpu_topology(void);
+
+/* Restricts thread 'tid' (0 for the calling thread) to the CPUs of cluster
+ * 'cluster', as numbered by android_get_cpu_topology(). Returns 0 on success,
+ * or -1 and sets errno (EINVAL for an unknown cluster).
+ */
+extern int android_set_thread_cluster(pid_t tid, size_t cluster);
+
+__END_DECLS
+
+#endif /* __ANDROID_CPU_TOPOLOGY_H__ */
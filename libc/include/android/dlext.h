@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_DLEXT_H__
+#define __ANDROID_DLEXT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/* bitfield definitions for android_dlextinfo.flags */
+enum {
+  /* When set, the reserved_addr and reserved_size fields must point to an
+   * already-reserved region of address space which will be used to load the
+   * library if it fits. If the reserved region is not large enough, the load
+   * will fail. When the library is unloaded, the region is left reserved
+   * (as inaccessible anonymous memory) for the caller to reuse or release.
+   */
+  ANDROID_DLEXT_RESERVED_ADDRESS      = 0x1,
+
+  /* As DLEXT_RESERVED_ADDRESS, but if the reserved region is not large enough,
+   * the linker will choose an available address instead.
+   */
+  ANDROID_DLEXT_RESERVED_ADDRESS_HINT = 0x2,
+
+  /* When set, after relocation the linker writes the GNU RELRO section of the
+   * library to relro_fd, and replaces its own copy with a mapping of the file.
+   */
+  ANDROID_DLEXT_WRITE_RELRO = 0x4,
+
+  /* When set, after relocation the linker compares the library's GNU RELRO
+   * section with the contents of relro_fd (as written by a process that used
+   * ANDROID_DLEXT_WRITE_RELRO), and maps the file over any identical pages.
+   * This only saves memory if the library was loaded at the same address,
+   * which ANDROID_DLEXT_RESERVED_ADDRESS can guarantee.
+   */
+  ANDROID_DLEXT_USE_RELRO = 0x8,
+
+  /* When set, the library is read from library_fd instead of being searched
+   * for and opened by name. The name is still used for error messages and to
+   * recognize the library if it's already loaded. The linker doesn't close
+   * library_fd, and reads from it with pread(2), so its offset is unchanged.
+   */
+  ANDROID_DLEXT_USE_LIBRARY_FD = 0x10,
+
+  /* When set, the linker asks the kernel to read the library's segments in
+   * as soon as they're mapped, rather than faulting them in a page at a time
+   * during relocation and construction. Setting LD_READAHEAD in the
+   * environment does this for every library.
+   */
+  ANDROID_DLEXT_READAHEAD = 0x20,
+
+  /* Mask of valid bits */
+  ANDROID_DLEXT_VALID_FLAG_BITS = ANDROID_DLEXT_RESERVED_ADDRESS |
+                                  ANDROID_DLEXT_RESERVED_ADDRESS_HINT |
+                                  ANDROID_DLEXT_WRITE_RELRO |
+                                  ANDROID_DLEXT_USE_RELRO |
+                                  ANDROID_DLEXT_USE_LIBRARY_FD |
+                                  ANDROID_DLEXT_READAHEAD,
+};
+
+typedef struct {
+  uint64_t flags;
+  int      relro_fd;
+  void*    reserved_addr;
+  size_t   reserved_size;
+  int      library_fd;
+} android_dlextinfo;
+
+/* Like dlopen(3), but with extra options given by 'extinfo', which may be NULL.
+ * The options only apply to the library named by 'filename', not to its
+ * dependencies, and are ignored if the library is already loaded.
+ */
+extern void* android_dlopen_ext(const char* filename, int flag, const android_dlextinfo* extinfo);
+
+/* Memory use of one loaded library, as reported by android_dl_get_stats. */
+typedef struct {
+  const char* name;
+  void*       base;
+  size_t      size;                /* Bytes of address space. */
+  size_t      private_dirty_pages; /* Resident pages private to this process. */
+  size_t      clean_pages;         /* Resident pages shared with the file. */
+  size_t      relocated_pages;     /* Pages with relocations to apply. */
+} android_dl_library_stats;
+
+/* Fills in 'stats' for up to 'count' loaded libraries and returns how many
+ * there are, so a caller can retry with a larger array. If 'linker_bytes' is
+ * not NULL, it's set to the memory the linker uses to keep track of them.
+ * The resident page counts come from /proc/self/pagemap, and are 0 if it
+ * can't be read.
+ */
+extern size_t android_dl_get_stats(android_dl_library_stats* stats, size_t count,
+                                   size_t* linker_bytes);
+
+/* Writes the same information to 'fd' as text, one line per library. This
+ * doesn't allocate memory, so it's safe to call from a crash handler as
+ * long as the linker isn't in the middle of dlopen(3) or dlclose(3).
+ */
+extern void android_dl_dump_stats(int fd);
+
+/* Returns a number that changes whenever a library is loaded or unloaded, and
+ * so an address can start belonging to a different library. Caches of lookups
+ * by address, like an unwinder's, can compare it to the number they were
+ * filled under rather than asking the linker about every address again.
+ */
+extern unsigned android_dl_get_generation(void);
+
+__END_DECLS
+
+#endif /* __ANDROID_DLEXT_H__ */
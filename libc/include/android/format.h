@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_FORMAT_H__
+#define __ANDROID_FORMAT_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * The formatting the C library uses for its own diagnostics: no allocation,
+ * no locks and no locale, so it's safe in signal handlers and after fork(),
+ * and quicker than snprintf(3) for what it does support, which is the
+ * conversions c, s, d, i, o, u, x, X, p, f and %, with the flags '-', '0',
+ * '+' and ' ', a field width, a precision for s and f (at most 17 digits for
+ * f), either of those given as '*', and the length modifiers hh, h, l, ll, z
+ * and t. Anything else aborts. %f doesn't honor the rounding mode, and
+ * digits past the fifteenth significant one or so needn't match printf(3).
+ */
+
+/* Like snprintf(3): writes at most 'size' bytes, NUL included, and returns
+ * the length the whole output would have had.
+ */
+extern int android_format_buffer(char* buffer, size_t size, const char* format, ...)
+    __printflike(3, 4);
+extern int android_vformat_buffer(char* buffer, size_t size, const char* format, va_list args);
+
+/* Appends to the string of length '*length' in 'buffer', writing at most
+ * 'size - *length' bytes, and adds the length of the whole output to
+ * '*length' and returns it. Once one append has been cut short, '*length' is
+ * 'size' or more and later ones only count.
+ */
+extern int android_format_append(char* buffer, size_t size, size_t* length,
+                                 const char* format, ...) __printflike(4, 5);
+
+/* Writes straight to 'fd', retrying short writes, and returns the number of
+ * bytes written, which is less than the output's length if a write failed.
+ */
+extern int android_format_fd(int fd, const char* format, ...) __printflike(2, 3);
+extern int android_vformat_fd(int fd, const char* format, va_list args);
+
+__END_DECLS
+
+#endif /* __ANDROID_FORMAT_H__ */
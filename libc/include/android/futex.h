@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_FUTEX_H__
+#define __ANDROID_FUTEX_H__
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <time.h>
+
+__BEGIN_DECLS
+
+/*
+ * Lightweight blocking primitives built directly on futexes, for code that
+ * needs to park and unpark threads without paying for a mutex. They only
+ * work between threads of one process. Timeouts are relative and measured
+ * against CLOCK_MONOTONIC; NULL means wait forever. Functions that can fail
+ * return 0 or an errno value, like the pthread functions.
+ */
+
+/* Sleeps for as long as '*addr' holds 'expected', until woken by
+ * android_futex_wake() or the timeout expires. Returns 0 when woken,
+ * EAGAIN if '*addr' didn't hold 'expected', ETIMEDOUT or EINTR. Wakeups can
+ * be spurious, so callers should recheck their condition in a loop.
+ */
+extern int android_futex_wait(volatile int32_t* addr, int32_t expected,
+                              const struct timespec* timeout);
+
+/* Wakes up to 'count' threads sleeping in android_futex_wait() on 'addr'
+ * (INT_MAX for all of them), and returns how many were woken.
+ */
+extern int android_futex_wake(volatile int32_t* addr, int count);
+
+/* An event is either set or not set. Waiting for a set manual-reset event
+ * returns at once until it's reset; setting an auto-reset event releases a
+ * single waiter, which clears it again.
+ */
+typedef struct {
+  volatile int32_t state;
+  int32_t          flags;
+} android_event_t;
+
+#define ANDROID_EVENT_AUTO_RESET    0
+#define ANDROID_EVENT_MANUAL_RESET  1
+
+#define ANDROID_EVENT_INITIALIZER(flags) { 0, (flags) }
+
+extern void android_event_init(android_event_t* event, int flags, int initially_set);
+extern void android_event_set(android_event_t* event);
+extern void android_event_reset(android_event_t* event);
+extern int  android_event_wait(android_event_t* event);
+extern int  android_event_timedwait(android_event_t* event, const struct timespec* timeout);
+
+/* A latch opens once it has been counted down 'count' times, releasing
+ * everybody waiting on it; it can't be closed again. Counting down an open
+ * latch does nothing.
+ */
+typedef struct {
+  volatile int32_t count;
+} android_latch_t;
+
+#define ANDROID_LATCH_INITIALIZER(count) { (count) }
+
+extern void android_latch_init(android_latch_t* latch, int32_t count);
+extern void android_latch_count_down(android_latch_t* latch);
+extern int  android_latch_wait(android_latch_t* latch);
+extern int  android_latch_timedwait(android_latch_t* latch, const struct timespec* timeout);
+
+__END_DECLS
+
+#endif /* __ANDROID_FUTEX_H__ */
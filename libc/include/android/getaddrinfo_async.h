@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_GETADDRINFO_ASYNC_H__
+#define __ANDROID_GETADDRINFO_ASYNC_H__
+
+#include <netdb.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Non-blocking name lookups, for event loops that would otherwise need a
+ * thread per lookup in flight. A lookup is started, its file descriptor is
+ * polled alongside the caller's others, and the result is collected once
+ * the descriptor is readable. Lookups that don't need DNS, such as numeric
+ * hosts, complete while being started, as does everything in the DNS proxy
+ * itself. The others are sent to the proxy, whose cache merges identical
+ * lookups that are in flight at the same time.
+ */
+typedef struct android_getaddrinfo_request android_getaddrinfo_request_t;
+
+/* Starts resolving like android_getaddrinfoforiface(). Returns 0 and sets
+ * '*request', or returns an EAI_* error if the lookup failed straight away.
+ */
+extern int android_getaddrinfo_async(const char* hostname, const char* servname,
+                                     const struct addrinfo* hints, const char* iface, int mark,
+                                     android_getaddrinfo_request_t** request);
+
+/* Returns the file descriptor that becomes readable when 'request' has a
+ * result. It belongs to the request: don't read from or close it.
+ */
+extern int android_getaddrinfo_fd(const android_getaddrinfo_request_t* request);
+
+/* Collects the result of 'request' and frees it. Returns what getaddrinfo()
+ * would have, setting '*res' on success. If the descriptor isn't readable
+ * yet, this blocks until it is.
+ */
+extern int android_getaddrinfo_result(android_getaddrinfo_request_t* request,
+                                      struct addrinfo** res);
+
+/* Abandons 'request' and frees it. */
+extern void android_getaddrinfo_cancel(android_getaddrinfo_request_t* request);
+
+__END_DECLS
+
+#endif /* __ANDROID_GETADDRINFO_ASYNC_H__ */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_LIBC_COUNTERS_H__
+#define __ANDROID_LIBC_COUNTERS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Counts of things the C library and the dynamic linker do that are
+ * worth watching across a fleet, since process start. Each thread counts
+ * in its own pthread_internal_t without atomics, and a read adds them up,
+ * so a read is only as consistent as a sample: counts from threads busy
+ * counting, or exiting, at the time may be a moment out of date.
+ */
+enum {
+    ANDROID_LIBC_COUNTER_MUTEX_WAITS,       /* times a thread slept on a mutex */
+    ANDROID_LIBC_COUNTER_MALLOC_SYSTEM,     /* times the heap asked the kernel for memory */
+    ANDROID_LIBC_COUNTER_DLOPEN,            /* dlopen() and android_dlopen_ext() calls */
+    ANDROID_LIBC_COUNTER_DLOPEN_NS,         /* time spent in them */
+    ANDROID_LIBC_COUNTER_DNS_CACHE_HITS,
+    ANDROID_LIBC_COUNTER_DNS_CACHE_MISSES,
+    ANDROID_LIBC_COUNTER_PROPERTY_LOOKUPS,  /* __system_property_find() calls */
+    ANDROID_LIBC_COUNTER_COUNT
+};
+
+/* Fills in the first 'count' counters, and returns how many there are. */
+extern size_t android_libc_counters_read(uint64_t* values, size_t count);
+
+/* Returns a short name for 'counter', or NULL. */
+extern const char* android_libc_counter_name(int counter);
+
+/* Writes every counter to 'fd' as a "name value" line, without allocating.
+ * Returns 0, or -1 and sets errno if a write failed.
+ */
+extern int android_libc_counters_dump(int fd);
+
+__END_DECLS
+
+#endif /* __ANDROID_LIBC_COUNTERS_H__ */
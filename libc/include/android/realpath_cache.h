@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_REALPATH_CACHE_H__
+#define __ANDROID_REALPATH_CACHE_H__
+
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * realpath(3) for batches of paths with long prefixes in common. realpath
+ * lstat()s every component of every path, and readlink()s every link; a
+ * cache remembers what each of those found, and the working directory, so
+ * each is only asked once per batch. Nothing checks whether the file system
+ * or the working directory have changed since: a cache should only live as
+ * long as the caller can assume they haven't. A cache is only for one
+ * thread at a time. Failed lookups aren't cached.
+ */
+typedef struct android_realpath_cache android_realpath_cache_t;
+
+/* Returns a new, empty cache, or NULL if out of memory. */
+extern android_realpath_cache_t* android_realpath_cache_create(void);
+
+/* Frees 'cache' and everything in it. */
+extern void android_realpath_cache_destroy(android_realpath_cache_t* cache);
+
+/* Like realpath(), but with lookups answered from 'cache' where they can be. */
+extern char* android_realpath_cached(android_realpath_cache_t* cache, const char* path,
+                                     char* resolved);
+
+__END_DECLS
+
+#endif /* __ANDROID_REALPATH_CACHE_H__ */
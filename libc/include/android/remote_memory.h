@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_REMOTE_MEMORY_H__
+#define __ANDROID_REMOTE_MEMORY_H__
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/* Copies 'size' bytes between 'local' in this process and 'remote' in process
+ * 'pid', in as few process_vm_readv(2) or process_vm_writev(2) calls as it
+ * takes, or, on kernels older than 3.2, a word at a time with ptrace(2), for
+ * which the caller must already have 'pid' attached and stopped. Returns how
+ * many bytes were copied, fewer than 'size' only if the remote range stops
+ * being mapped (or writable), or -1 and sets errno if none could be.
+ */
+extern ssize_t android_read_remote(pid_t pid, void* local, const void* remote, size_t size);
+extern ssize_t android_write_remote(pid_t pid, void* remote, const void* local, size_t size);
+
+__END_DECLS
+
+#endif /* __ANDROID_REMOTE_MEMORY_H__ */
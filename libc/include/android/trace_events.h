@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_TRACE_EVENTS_H__
+#define __ANDROID_TRACE_EVENTS_H__
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/*
+ * Cheap tracing of what libc and the dynamic linker are up to, for events
+ * that are otherwise only seen with heavy instrumentation. While tracing is
+ * on, each thread records compact events in a ring buffer of its own, without
+ * locks, and a reader drains them. While it's off, each place an event could
+ * come from costs one predicted branch.
+ */
+
+struct android_trace_event {
+  uint64_t time_ns;  /* CLOCK_MONOTONIC */
+  uint64_t arg;      /* depends on the type */
+  pid_t tid;         /* the thread the event happened on */
+  uint32_t type;
+};
+
+/* Events, and what 'arg' is for each. */
+#define ANDROID_TRACE_MUTEX_WAIT     1  /* about to sleep on a mutex: its address */
+#define ANDROID_TRACE_THREAD_CREATE  2  /* the new thread's tid */
+#define ANDROID_TRACE_THREAD_EXIT    3  /* the thread's return value */
+#define ANDROID_TRACE_DLOPEN         4  /* the handle returned, or 0 */
+#define ANDROID_TRACE_DLCLOSE        5  /* the handle */
+#define ANDROID_TRACE_MALLOC_SYSTEM  6  /* bytes the heap asked the kernel for */
+#define ANDROID_TRACE_DROPPED        7  /* events lost to a full buffer just before this one */
+
+/* Starts tracing, with room for 'events_per_thread' events, rounded up to a
+ * power of two, in the buffer of each thread that doesn't have one yet. The
+ * dynamic linker only records events for threads that already have a buffer,
+ * which a thread gets with its first event from libc; the calling thread gets
+ * one now. Returns 0, or -1 and sets errno.
+ */
+extern int android_trace_start(size_t events_per_thread);
+
+/* Stops tracing. Events already recorded can still be read. */
+extern void android_trace_stop(void);
+
+/* Moves up to 'count' of the events recorded so far into 'events', and
+ * returns how many. Each thread's events come out in order, but there's no
+ * order between threads: sort by 'time_ns' for that.
+ */
+extern size_t android_trace_read(struct android_trace_event* events, size_t count);
+
+/* Moves every event recorded so far to 'fd', as an array of struct
+ * android_trace_event. Returns how many were written, or -1 and sets errno.
+ */
+extern ssize_t android_trace_dump(int fd);
+
+__END_DECLS
+
+#endif /* __ANDROID_TRACE_EVENTS_H__ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ANDROID_TREE_WALK_H__
+#define __ANDROID_TREE_WALK_H__
+
+#include <sys/cdefs.h>
+#include <sys/stat.h>
+
+__BEGIN_DECLS
+
+/*
+ * A directory tree walk that reads several directories at once, for walks
+ * over so many files that fts(3) or nftw(3), reading one directory and
+ * stat-ing one entry at a time, leave flash storage mostly idle. Entries are
+ * only stat-ed when asked for or when getdents(2) can't say what type they
+ * are. There's no order: entries of different directories are reported by
+ * different threads at the same time, so the callback must be thread-safe.
+ * Symbolic links are reported but not followed, except for 'root' itself.
+ */
+
+struct android_tree_walk_entry {
+  const char* path;         /* 'root' and the names leading here, separated by '/' */
+  const char* name;         /* the last component of 'path' */
+  int depth;                /* 0 for 'root' */
+  unsigned char type;       /* DT_REG, DT_DIR and so on, or DT_UNKNOWN if stat failed */
+  const struct stat* stat;  /* NULL unless the entry was stat-ed */
+  int error;                /* 0, or the errno from stat, or from reading a directory */
+};
+
+/* Called for each entry, or a second time with 'error' set for a directory
+ * that couldn't be read all the way. Return 0 to go on, ANDROID_TREE_WALK_SKIP
+ * not to go into the directory, or anything else to stop the walk.
+ */
+typedef int (*android_tree_walk_callback_t)(const struct android_tree_walk_entry* entry, void* arg);
+
+#define ANDROID_TREE_WALK_SKIP  1
+
+/* Stat every entry, not just the ones getdents(2) can't type. */
+#define ANDROID_TREE_WALK_STAT  0x1
+
+/* Walks the tree at 'root', with 'threads' threads counting the caller's, or
+ * one per online CPU if 'threads' is 0 or less. Returns once every callback
+ * has returned: 0 when the walk is done, the value a callback stopped it
+ * with, or -1 and sets errno if 'root' can't be stat-ed or memory runs out.
+ */
+extern int android_tree_walk(const char* root, int flags, int threads,
+                             android_tree_walk_callback_t callback, void* arg);
+
+__END_DECLS
+
+#endif /* __ANDROID_TREE_WALK_H__ */
@@ -30,6 +30,7 @@
 
 #include <sys/cdefs.h>
 #include <sys/types.h>
+#include <linux/fadvise.h>
 #include <linux/fcntl.h>
 #include <unistd.h>  /* this is not required, but makes client code much happier */
 
@@ -49,6 +50,36 @@ extern int  unlinkat(int dirfd, const char *pathname, int flags);
 extern int  fcntl(int   fd, int   command, ...);
 extern int  creat(const char*  path, mode_t  mode);
 
+/* Flags for splice(2), tee(2) and vmsplice(2). */
+#define SPLICE_F_MOVE      1
+#define SPLICE_F_NONBLOCK  2
+#define SPLICE_F_MORE      4
+#define SPLICE_F_GIFT      8
+
+struct iovec;
+extern ssize_t splice(int fd_in, off64_t* off_in, int fd_out, off64_t* off_out, size_t len, unsigned int flags);
+extern ssize_t tee(int fd_in, int fd_out, size_t len, unsigned int flags);
+extern ssize_t vmsplice(int fd, const struct iovec* iov, size_t nr_segs, unsigned int flags);
+
+/* Flags for fallocate(2). */
+#define FALLOC_FL_KEEP_SIZE   0x01
+#define FALLOC_FL_PUNCH_HOLE  0x02
+
+extern int fallocate(int fd, int mode, off_t offset, off_t length);
+extern int fallocate64(int fd, int mode, off64_t offset, off64_t length);
+extern int posix_fallocate(int fd, off_t offset, off_t length);
+extern int posix_fallocate64(int fd, off64_t offset, off64_t length);
+
+extern int posix_fadvise(int fd, off_t offset, off_t length, int advice);
+extern int posix_fadvise64(int fd, off64_t offset, off64_t length, int advice);
+
+/* Flags for sync_file_range(2). */
+#define SYNC_FILE_RANGE_WAIT_BEFORE  1
+#define SYNC_FILE_RANGE_WRITE        2
+#define SYNC_FILE_RANGE_WAIT_AFTER   4
+
+extern int sync_file_range(int fd, off64_t offset, off64_t length, unsigned int flags);
+
 #if defined(__BIONIC_FORTIFY) && !defined(__clang__)
 __errordecl(__creat_missing_mode, "called with O_CREAT, but missing mode");
 __errordecl(__creat_too_many_args, "too many arguments");
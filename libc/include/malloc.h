@@ -24,6 +24,7 @@
  */
 #include <sys/cdefs.h>
 #include <stddef.h>
+#include <stdint.h>
 
 __BEGIN_DECLS
 
@@ -31,6 +32,8 @@ extern void* malloc(size_t byte_count) __mallocfunc __wur;
 extern void* calloc(size_t item_count, size_t item_size) __mallocfunc __wur;
 extern void* realloc(void* p, size_t byte_count) __wur;
 extern void free(void* p);
+/* Like free, but 'byte_count' must be the size 'p' was allocated with, which saves a lookup. */
+extern void free_sized(void* p, size_t byte_count);
 
 extern void* memalign(size_t alignment, size_t byte_count) __mallocfunc __wur;
 extern size_t malloc_usable_size(const void* p);
@@ -56,6 +59,64 @@ struct mallinfo {
 
 extern struct mallinfo mallinfo(void);
 
+/*
+ * Tuning for mallopt(3). Values are in bytes; -1 means "never".
+ *   M_TRIM_THRESHOLD: free memory at the top of the heap beyond this is
+ *     returned to the system.
+ *   M_GRANULARITY: the unit the heap grows by (a power of two, at least a page).
+ *   M_MMAP_THRESHOLD: requests at least this big get their own mapping.
+ *   M_HUGEPAGES: nonzero to grow the heap in 2MB steps, align heap mappings
+ *     and thread stacks of at least 2MB to 2MB, and mark them MADV_HUGEPAGE.
+ *     Also set by the libc.malloc.hugepages system property.
+ * Returns 1 on success, 0 for an unknown parameter or bad value.
+ */
+#define M_TRIM_THRESHOLD     (-1)
+#define M_GRANULARITY        (-2)
+#define M_MMAP_THRESHOLD     (-3)
+#define M_HUGEPAGES          (-4)
+
+extern int mallopt(int param, int value);
+
+/*
+ * Returns as much free memory to the system as possible, keeping 'pad'
+ * bytes at the top of the heap. Unlike automatic trimming, this also
+ * releases the pages inside free chunks in the middle of the heap, so
+ * long-running processes can call it when they go idle. Returns 1 if any
+ * memory was released, 0 otherwise.
+ */
+extern int malloc_trim(size_t pad);
+
+/*
+ * Writes a human-readable summary of the allocator's state to 'fd': heap
+ * and mmapped totals, and for each small size class the pages it uses,
+ * its partially full pages, the objects in use, the allocation count and
+ * the number of times threads waited for its lock, followed by a histogram
+ * of larger allocations. Counts are cumulative since process start.
+ */
+extern void malloc_dump_stats(int fd);
+
+/*
+ * With the leak checker on (libc.debug.malloc=1), calls 'callback' for each
+ * distinct allocation site it's tracking, stopping early if 'callback'
+ * returns nonzero, and returns that value or 0. Only one hash chain is locked
+ * at a time, and never while 'callback' runs, so allocation carries on during
+ * the walk, and 'callback' may allocate too. The records come in no order and
+ * 'frames' only lives until 'callback' returns. For a consistent view, compare
+ * malloc_leak_generation() before and after; it changes whenever the records
+ * do.
+ */
+struct malloc_leak_record {
+  size_t size;              /* per allocation; the top bit is set after leaving zygote */
+  size_t allocations;
+  size_t frame_count;
+  const uintptr_t* frames;  /* the allocating backtrace, innermost first */
+};
+
+typedef int (*malloc_leak_callback_t)(const struct malloc_leak_record* record, void* arg);
+
+extern int malloc_iterate_leaks(malloc_leak_callback_t callback, void* arg);
+extern unsigned malloc_leak_generation(void);
+
 __END_DECLS
 
 #endif  /* LIBC_INCLUDE_MALLOC_H_ */
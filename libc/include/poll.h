@@ -30,6 +30,7 @@
 
 #include <sys/cdefs.h>
 #include <linux/poll.h>
+#include <signal.h> /* for sigset_t */
 
 __BEGIN_DECLS
 
@@ -38,6 +39,9 @@ typedef unsigned int  nfds_t;
 /* POSIX specifies "int" for the timeout, Linux seems to use long... */
 extern int poll(struct pollfd *, nfds_t, long);
 
+struct timespec;
+extern int ppoll(struct pollfd *, nfds_t, const struct timespec *, const sigset_t *);
+
 __END_DECLS
 
 #endif /* _POLL_H_ */
@@ -45,15 +45,19 @@ typedef struct
 #define  __PTHREAD_MUTEX_INIT_VALUE            0
 #define  __PTHREAD_RECURSIVE_MUTEX_INIT_VALUE  0x4000
 #define  __PTHREAD_ERRORCHECK_MUTEX_INIT_VALUE 0x8000
+#define  __PTHREAD_ADAPTIVE_MUTEX_INIT_VALUE   0xc000
 
 #define  PTHREAD_MUTEX_INITIALIZER             {__PTHREAD_MUTEX_INIT_VALUE}
 #define  PTHREAD_RECURSIVE_MUTEX_INITIALIZER   {__PTHREAD_RECURSIVE_MUTEX_INIT_VALUE}
 #define  PTHREAD_ERRORCHECK_MUTEX_INITIALIZER  {__PTHREAD_ERRORCHECK_MUTEX_INIT_VALUE}
+#define  PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP {__PTHREAD_ADAPTIVE_MUTEX_INIT_VALUE}
 
 enum {
     PTHREAD_MUTEX_NORMAL = 0,
     PTHREAD_MUTEX_RECURSIVE = 1,
     PTHREAD_MUTEX_ERRORCHECK = 2,
+    /* A normal mutex that spins briefly before sleeping, for short critical sections. */
+    PTHREAD_MUTEX_ADAPTIVE_NP = 3,
 
     PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
     PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
@@ -104,6 +108,10 @@ typedef volatile int  pthread_once_t;
 #define PTHREAD_SCOPE_SYSTEM     0
 #define PTHREAD_SCOPE_PROCESS    1
 
+#define PTHREAD_PRIO_NONE        0
+#define PTHREAD_PRIO_INHERIT     1
+#define PTHREAD_PRIO_PROTECT     2
+
 /*
  * Prototypes
  */
@@ -160,6 +168,8 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type);
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type);
 int pthread_mutexattr_setpshared(pthread_mutexattr_t *attr, int  pshared);
 int pthread_mutexattr_getpshared(pthread_mutexattr_t *attr, int *pshared);
+int pthread_mutexattr_setprotocol(pthread_mutexattr_t *attr, int protocol);
+int pthread_mutexattr_getprotocol(const pthread_mutexattr_t *attr, int *protocol);
 
 int pthread_mutex_init(pthread_mutex_t *mutex,
                        const pthread_mutexattr_t *attr);
@@ -223,26 +233,40 @@ int pthread_cond_timeout_np(pthread_cond_t *cond,
  */
 int pthread_mutex_lock_timeout_np(pthread_mutex_t *mutex, unsigned msecs);
 
+/* write the wait sites recorded by the mutex contention profiler (enabled
+ * with the debug.libc.pthread.contention system property) to 'fd', or to
+ * the log if 'fd' is negative. returns 0 on success, ENOTSUP if the
+ * profiler isn't running in this process.
+ */
+int pthread_mutex_contention_dump_np(int fd);
+
 /* read-write lock support */
 
 typedef int pthread_rwlockattr_t;
 
 typedef struct {
-    pthread_mutex_t  lock;
-    pthread_cond_t   cond;
-    int              numLocks;
+    int volatile     state;
+    int volatile     writerWakeup;
+    int              writerLockCount;
     int              writerThreadId;
-    int              pendingReaders;
-    int              pendingWriters;
+    int              attr;
+    int              __reserved;
     void*            reserved[4];  /* for future extensibility */
 } pthread_rwlock_t;
 
-#define PTHREAD_RWLOCK_INITIALIZER  { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, { NULL, NULL, NULL, NULL } }
+#define PTHREAD_RWLOCK_INITIALIZER  { 0, 0, 0, 0, 0, 0, { NULL, NULL, NULL, NULL } }
+
+enum {
+    PTHREAD_RWLOCK_PREFER_READER_NP = 0,
+    PTHREAD_RWLOCK_PREFER_WRITER_NP = 1,
+};
 
 int pthread_rwlockattr_init(pthread_rwlockattr_t *attr);
 int pthread_rwlockattr_destroy(pthread_rwlockattr_t *attr);
 int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int  pshared);
 int pthread_rwlockattr_getpshared(pthread_rwlockattr_t *attr, int *pshared);
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *attr, int pref);
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *attr, int *pref);
 
 int pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr);
 int pthread_rwlock_destroy(pthread_rwlock_t *rwlock);
@@ -257,6 +281,38 @@ int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock, const struct timespec *
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock);
 
+/* barrier support */
+
+typedef int pthread_barrierattr_t;
+
+typedef struct {
+    unsigned int     count;
+    int volatile     arrived;
+    int volatile     generation;
+    int              shared;
+} pthread_barrier_t;
+
+#define PTHREAD_BARRIER_SERIAL_THREAD  -1
+
+int pthread_barrierattr_init(pthread_barrierattr_t *attr);
+int pthread_barrierattr_destroy(pthread_barrierattr_t *attr);
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t *attr, int *pshared);
+int pthread_barrierattr_setpshared(pthread_barrierattr_t *attr, int pshared);
+
+int pthread_barrier_init(pthread_barrier_t *barrier, const pthread_barrierattr_t *attr, unsigned count);
+int pthread_barrier_destroy(pthread_barrier_t *barrier);
+int pthread_barrier_wait(pthread_barrier_t *barrier);
+
+/* spinlock support */
+
+typedef int volatile pthread_spinlock_t;
+
+int pthread_spin_init(pthread_spinlock_t *lock, int pshared);
+int pthread_spin_destroy(pthread_spinlock_t *lock);
+int pthread_spin_lock(pthread_spinlock_t *lock);
+int pthread_spin_trylock(pthread_spinlock_t *lock);
+int pthread_spin_unlock(pthread_spinlock_t *lock);
+
 
 int pthread_key_create(pthread_key_t *key, void (*destructor_function)(void *));
 int pthread_key_delete (pthread_key_t);
@@ -11,6 +11,7 @@
 
 #include <sys/cdefs.h>
 #include <sys/_types.h>
+#include <sys/types.h>
 
 typedef	enum {
 	preorder,
@@ -19,10 +20,26 @@ typedef	enum {
 	leaf
 } VISIT;
 
+typedef	struct entry {
+	char	*key;
+	void	*data;
+} ENTRY;
+
+typedef	enum {
+	FIND,
+	ENTER
+} ACTION;
+
+/* For the GNU reentrant hsearch_r family; zero it before hcreate_r. */
+struct hsearch_data {
+	struct __hsearch *__hsearch;
+};
+
 #ifdef _SEARCH_PRIVATE
 typedef	struct node {
 	char         *key;
 	struct node  *llink, *rlink;
+	int           height;	/* of the AVL subtree rooted here */
 } node_t;
 #endif
 
@@ -34,6 +51,13 @@ void	*tfind(const void *, void * const *,
 void	*tsearch(const void *, void **, int (*)(const void *, const void *));
 void	 twalk(const void *, void (*)(const void *, VISIT, int));
 void	 tdestroy(void *, void (*)(void *));
+
+int	 hcreate(size_t);
+void	 hdestroy(void);
+ENTRY	*hsearch(ENTRY, ACTION);
+int	 hcreate_r(size_t, struct hsearch_data *);
+void	 hdestroy_r(struct hsearch_data *);
+int	 hsearch_r(ENTRY, ACTION, ENTRY **, struct hsearch_data *);
 __END_DECLS
 
 #endif /* !_SEARCH_H_ */
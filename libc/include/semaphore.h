@@ -53,6 +53,11 @@ extern int    sem_wait(sem_t *);
 struct timespec;
 extern int    sem_timedwait(sem_t *sem, const struct timespec *abs_timeout);
 
+/* BIONIC: Same as sem_timedwait(), but 'abs_timeout' is measured
+ * against CLOCK_MONOTONIC, so it isn't affected by changes to the
+ * wall clock. */
+extern int    sem_timedwait_monotonic_np(sem_t *sem, const struct timespec *abs_timeout);
+
 __END_DECLS
 
 #endif /* _SEMAPHORE_H */
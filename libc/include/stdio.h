@@ -304,6 +304,11 @@ int	 pclose(FILE *);
 FILE	*popen(const char *, const char *);
 #endif
 
+#if __POSIX_VISIBLE >= 200809
+FILE	*fmemopen(void * __restrict, size_t, const char * __restrict);
+FILE	*open_memstream(char **, size_t *);
+#endif
+
 #if __POSIX_VISIBLE >= 199506
 void	 flockfile(FILE *);
 int	 ftrylockfile(FILE *);
@@ -334,7 +339,12 @@ __BEGIN_DECLS
 int	 asprintf(char ** __restrict, const char * __restrict, ...)
 		__printflike(2, 3);
 char	*fgetln(FILE * __restrict, size_t * __restrict);
+char	*fgets_unlocked(char * __restrict, int, FILE * __restrict);
 int	 fpurge(FILE *);
+int	 fputs_unlocked(const char * __restrict, FILE * __restrict);
+size_t	 fread_unlocked(void * __restrict, size_t, size_t, FILE * __restrict);
+size_t	 fwrite_unlocked(const void * __restrict, size_t, size_t,
+    FILE * __restrict);
 int	 getw(FILE *);
 int	 putw(int, FILE *);
 void	 setbuffer(FILE *, char *, int);
@@ -89,6 +89,8 @@ extern void * bsearch(const void *key, const void *base0,
 	int (*compar)(const void *, const void *));
 
 extern void qsort(void *, size_t, size_t, int (*)(const void *, const void *));
+/* Like glibc's, which passes the context last, rather than the BSDs'. */
+extern void qsort_r(void *, size_t, size_t, int (*)(const void *, const void *, void *), void *);
 
 extern long jrand48(unsigned short *);
 extern long mrand48(void);
@@ -101,6 +103,8 @@ extern void srand48(long);
 extern unsigned int arc4random(void);
 extern void arc4random_stir(void);
 extern void arc4random_addrandom(unsigned char *, int);
+extern void arc4random_buf(void *, size_t);
+extern unsigned int arc4random_uniform(unsigned int);
 
 #define RAND_MAX 0x7fffffff
 static __inline__ int rand(void) {
@@ -58,6 +58,21 @@ struct prop_msg
 };
 
 #define PROP_MSG_SETPROP 1
+
+/*
+** A batch of properties is set over one connection. The client sends a
+** prop_msg with cmd PROP_MSG_SETPROP_BATCH, an empty name, and the number
+** of properties in the batch as a decimal string in value. The property
+** service answers with the single byte PROP_BATCH_ACK, then reads that many
+** ordinary PROP_MSG_SETPROP messages, applies each in turn, and closes the
+** connection. If the connection ends before the whole batch has arrived,
+** it stops at that point. A property service that doesn't know about
+** batches closes the connection without acknowledging, and the client
+** falls back to one connection per property.
+*/
+#define PROP_MSG_SETPROP_BATCH 2
+#define PROP_BATCH_ACK 'B'
+#define PROP_BATCH_MAX 1024
     
 /*
 ** Rules:
@@ -118,6 +133,27 @@ int __system_property_add(const char *name, unsigned int namelen,
 */
 int __system_property_update(prop_info *pi, const char *value, unsigned int len);
 
+/* Set 'count' system properties as a batch over one connection to the
+** property service; values[i] is the value for keys[i]. The same limits
+** apply to each pair as to __system_property_set(), and nothing is sent if
+** any pair is invalid. Batches larger than PROP_BATCH_MAX are split.
+**
+** Returns 0 on success, -1 on error.
+*/
+int __system_property_set_batch(const char * const *keys, const char * const *values,
+        size_t count);
+
+/* Like __system_property_add() and __system_property_update(), but accept
+** values of up to PROP_LONG_VALUE_MAX bytes. Values that fit in a prop_info
+** are stored inline as usual; longer ones are stored out of line in the
+** property area.
+**
+** Returns 0 on success, -1 if the value is too long or the area is full.
+*/
+int __system_property_add_long(const char *name, unsigned int namelen,
+			const char *value, unsigned int valuelen);
+int __system_property_update_long(prop_info *pi, const char *value, unsigned int len);
+
 /* Read the serial number of a system property returned by
 ** __system_property_find.
 **
@@ -125,11 +161,26 @@ int __system_property_update(prop_info *pi, const char *value, unsigned int len)
 */
 unsigned int __system_property_serial(const prop_info *pi);
 
+/* Wait for the system property returned by __system_property_find to be
+** updated, or for any property to be updated if pi is NULL.  Changes that
+** happen before the call starts waiting are not noticed.
+**
+** Returns 0.
+*/
+int __system_property_wait(const prop_info *pi);
+
 /* Wait for any system property to be updated.  Caller must pass
 ** in 0 the first time, and the previous return value on each
 ** successive call. */
 unsigned int __system_property_wait_any(unsigned int serial);
 
+/* Like __system_property_wait_any(), but only wakes for changes to the
+** property named 'prefix' or to properties below it ("persist.sys" covers
+** "persist.sys.timezone" but not "persist.system"). Caller must pass in 0
+** the first time, and the previous return value on each successive call.
+** Wakeups for unrelated properties are rare but possible. */
+unsigned int __system_property_wait_prefix(const char *prefix, unsigned int serial);
+
 /*  Compatibility functions to support using an old init with a new libc,
  ** mostly for the OTA updater binary.  These can be deleted once OTAs from
  ** a pre-K release no longer needed to be supported. */
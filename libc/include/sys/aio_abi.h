@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SYS_AIO_ABI_H
+#define _SYS_AIO_ABI_H
+
+/*
+ * Linux native AIO: the raw io_* syscalls and the kernel's types. This is
+ * not POSIX <aio.h>, and not libaio's io_context_t interface either.
+ *
+ * Reads and writes only complete asynchronously on files opened O_DIRECT;
+ * otherwise io_submit does the I/O before it returns.
+ */
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <linux/aio_abi.h>
+
+__BEGIN_DECLS
+
+struct timespec;
+
+extern int io_setup(unsigned int nr_events, aio_context_t* ctx);
+extern int io_destroy(aio_context_t ctx);
+extern int io_submit(aio_context_t ctx, long nr, struct iocb** iocbs);
+extern int io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event* events, struct timespec* timeout);
+extern int io_cancel(aio_context_t ctx, struct iocb* iocb, struct io_event* result);
+
+__END_DECLS
+
+#endif /* _SYS_AIO_ABI_H */
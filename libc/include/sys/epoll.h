@@ -29,6 +29,7 @@
 #define _SYS_EPOLL_H_
 
 #include <sys/cdefs.h>
+#include <signal.h> /* for sigset_t */
 
 __BEGIN_DECLS
 
@@ -47,6 +48,8 @@ __BEGIN_DECLS
 #define EPOLLONESHOT     0x40000000
 #define EPOLLET          0x80000000
 
+#define EPOLL_CLOEXEC    02000000  /* O_CLOEXEC */
+
 #define EPOLL_CTL_ADD    1
 #define EPOLL_CTL_DEL    2
 #define EPOLL_CTL_MOD    3
@@ -66,8 +69,10 @@ struct epoll_event
 };
 
 int epoll_create(int size);
+int epoll_create1(int flags);
 int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
 int epoll_wait(int epfd, struct epoll_event *events, int max, int timeout);
+int epoll_pwait(int epfd, struct epoll_event *events, int max, int timeout, const sigset_t *ss);
 
 __END_DECLS
 
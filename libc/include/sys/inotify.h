@@ -34,7 +34,16 @@
 
 __BEGIN_DECLS
 
+/* Flags for inotify_init1(). */
+#define IN_CLOEXEC 02000000  /* O_CLOEXEC */
+#ifdef __mips__
+#define IN_NONBLOCK 0x0080   /* O_NONBLOCK */
+#else
+#define IN_NONBLOCK 04000    /* O_NONBLOCK */
+#endif
+
 extern int inotify_init(void);
+extern int inotify_init1(int);
 extern int inotify_add_watch(int, const char *, __u32);
 extern int inotify_rm_watch(int, __u32);
 
@@ -26,6 +26,11 @@ void	SHA1Transform(uint32_t[5], const u_char[64]);
 void	SHA1Init(SHA1_CTX *);
 void	SHA1Update(SHA1_CTX *, const u_char *, u_int);
 void	SHA1Final(u_char[SHA1_DIGEST_LENGTH], SHA1_CTX *);
+/*
+ * Android extension: feed len bytes to each of four independent contexts.
+ * Contexts at the same offset within a block are hashed together using SIMD.
+ */
+void	SHA1Update4(SHA1_CTX *[4], const u_char * const [4], u_int);
 __END_DECLS
 
 #endif /* _SYS_SHA1_H_ */
@@ -61,6 +61,14 @@ typedef int socklen_t;
 #define SOCK_PACKET      10
 #endif
 
+/* Flags for socket(), socketpair() and accept4(), or'ed into the type. */
+#define SOCK_CLOEXEC     02000000  /* O_CLOEXEC */
+#ifdef __mips__
+#define SOCK_NONBLOCK    0x0080    /* O_NONBLOCK */
+#else
+#define SOCK_NONBLOCK    04000     /* O_NONBLOCK */
+#endif
+
 /* BIONIC: second argument to shutdown() */
 enum {
     SHUT_RD = 0,        /* no more receptions */
@@ -91,6 +99,11 @@ struct msghdr {
  unsigned msg_flags;
 };
 
+struct mmsghdr {
+ struct msghdr msg_hdr;
+ unsigned int msg_len;
+};
+
 struct cmsghdr {
  __kernel_size_t cmsg_len;
  int cmsg_level;
@@ -238,6 +251,7 @@ struct ucred {
 #define MSG_ERRQUEUE 0x2000
 #define MSG_NOSIGNAL 0x4000
 #define MSG_MORE 0x8000
+#define MSG_WAITFORONE 0x10000
 #define MSG_EOF MSG_FIN
 #define MSG_CMSG_COMPAT 0
 
@@ -278,6 +292,7 @@ __socketcall int bind(int, const struct sockaddr *, int);
 __socketcall int connect(int, const struct sockaddr *, socklen_t);
 __socketcall int listen(int, int);
 __socketcall int accept(int, struct sockaddr *, socklen_t *);
+__socketcall int accept4(int, struct sockaddr *, socklen_t *, int);
 __socketcall int getsockname(int, struct sockaddr *, socklen_t *);
 __socketcall int getpeername(int, struct sockaddr *, socklen_t *);
 __socketcall int socketpair(int, int, int, int *);
@@ -287,6 +302,10 @@ __socketcall int getsockopt(int, int, int, void *, socklen_t *);
 __socketcall int sendmsg(int, const struct msghdr *, unsigned int);
 __socketcall int recvmsg(int, struct msghdr *, unsigned int);
 
+struct timespec;
+__socketcall int sendmmsg(int, struct mmsghdr *, unsigned int, unsigned int);
+__socketcall int recvmmsg(int, struct mmsghdr *, unsigned int, unsigned int, struct timespec *);
+
 extern  ssize_t  send(int, const void *, size_t, unsigned int);
 extern  ssize_t  recv(int, void *, size_t, unsigned int);
 
@@ -30,6 +30,7 @@
 #define _INCLUDE_SYS_SYSTEM_PROPERTIES_H
 
 #include <sys/cdefs.h>
+#include <stddef.h>
 
 __BEGIN_DECLS
 
@@ -46,6 +47,19 @@ typedef struct prop_info prop_info;
 */
 int __system_property_get(const char *name, char *value);
 
+/* Values longer than PROP_VALUE_MAX - 1 can be stored by the property
+** service, up to PROP_LONG_VALUE_MAX bytes. __system_property_get() and
+** __system_property_read() see such a property as "".
+*/
+#define PROP_LONG_VALUE_MAX 4096
+
+/* Like __system_property_get(), but also reads long values. At most
+** 'size' bytes, including a \0 terminator, are copied to 'value'.
+** Returns the full string length of the value, which may be more than
+** was copied.
+*/
+int __system_property_get_long(const char *name, char *value, size_t size);
+
 /* Set a system property by name.
 **/
 int __system_property_set(const char *key, const char *value);
@@ -72,6 +86,38 @@ const prop_info *__system_property_find(const char *name);
 */
 int __system_property_read(const prop_info *pi, char *name, char *value);
 
+/* A cached lookup of one system property, for callers that poll the
+** same property repeatedly. The name is resolved to a prop_info once,
+** and the value is only copied again when the property's serial number
+** changes; until then __system_property_cached_read() returns at once.
+** A property that doesn't exist yet is looked up again only after some
+** property has been added or changed. A cache must not be shared between
+** threads without locking.
+*/
+typedef struct {
+    const char *name;
+    const prop_info *pi;
+    unsigned serial;
+    unsigned area_serial;
+    int len;
+    char value[PROP_VALUE_MAX];
+} prop_cache_t;
+
+#define PROP_CACHE_INITIALIZER(name) { (name), 0, 0, 0, -1, { 0 } }
+
+void __system_property_cache_init(prop_cache_t *cache, const char *name);
+
+/* Bring 'cache' up to date, leaving the value and a \0 terminator in
+** cache->value. Returns the string length of the value; as with
+** __system_property_get(), an undefined property reads as "".
+*/
+int __system_property_cached_read(prop_cache_t *cache);
+
+/* Like __system_property_read(), but also reads long values, with the
+** same 'size' and return value conventions as __system_property_get_long().
+*/
+int __system_property_read_long(const prop_info *pi, char *value, size_t size);
+
 /* Return a prop_info for the nth system property, or NULL if 
 ** there is no nth property.  Use __system_property_read() to
 ** read the value of this property.
@@ -97,6 +143,36 @@ int __system_property_foreach(
         void (*propfn)(const prop_info *pi, void *cookie),
         void *cookie);
 
+/* A view of one system property straight into the property area, as
+** passed to the callback of __system_property_foreach_view(). The name
+** never changes. The value is not copied, so it is only what the
+** property holds while __system_property_view_valid() says so.
+*/
+typedef struct {
+    const prop_info *pi;
+    const char *name;
+    unsigned name_len;
+    const char *value;
+    unsigned value_len;
+    unsigned serial;
+} prop_view_t;
+
+/* Pass a view of each system property to the provided callback,
+** without copying names or values. Returns 0 on success, -1 on error.
+**
+** Order of results may change from call to call.  This is
+** not a bug.
+*/
+int __system_property_foreach_view(
+        void (*viewfn)(const prop_view_t *view, void *cookie),
+        void *cookie);
+
+/* Returns nonzero if the property hasn't changed since 'view' was taken,
+** so that the value it points at is still the one its length describes.
+** Copy what you need from the view first, then check.
+*/
+int __system_property_view_valid(const prop_view_t *view);
+
 __END_DECLS
 
 #endif
@@ -37,6 +37,23 @@ __BEGIN_DECLS
 int readv(int, const struct iovec *, int);
 int writev(int, const struct iovec *, int);
 
+/* readv and writev at an explicit offset, without moving the file offset. */
+ssize_t preadv(int, const struct iovec *, int, off_t);
+ssize_t preadv64(int, const struct iovec *, int, off64_t);
+ssize_t pwritev(int, const struct iovec *, int, off_t);
+ssize_t pwritev64(int, const struct iovec *, int, off64_t);
+
+/* Copies between this process and 'pid' without stopping it, needing the
+ * same permission as ptrace(PTRACE_ATTACH). 'flags' must be 0. Linux 3.2 and
+ * later; ENOSYS before that.
+ */
+ssize_t process_vm_readv(pid_t pid, const struct iovec* local_iov, unsigned long liovcnt,
+                         const struct iovec* remote_iov, unsigned long riovcnt,
+                         unsigned long flags);
+ssize_t process_vm_writev(pid_t pid, const struct iovec* local_iov, unsigned long liovcnt,
+                          const struct iovec* remote_iov, unsigned long riovcnt,
+                          unsigned long flags);
+
 __END_DECLS
 
 #endif /* _SYS_UIO_H_ */
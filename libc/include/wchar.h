@@ -109,6 +109,9 @@ extern wint_t            ungetwc(wint_t, FILE *);
 extern int               vfwprintf(FILE *, const wchar_t *, va_list);
 extern int               vwprintf(const wchar_t *, va_list);
 extern int               vswprintf(wchar_t *, size_t, const wchar_t *, va_list);
+extern int               vfwscanf(FILE *, const wchar_t *, va_list);
+extern int               vswscanf(const wchar_t *, const wchar_t *, va_list);
+extern int               vwscanf(const wchar_t *, va_list);
 extern size_t            wcrtomb(char *, wchar_t, mbstate_t *);
 extern int               wcscasecmp(const wchar_t *, const wchar_t *);
 extern wchar_t          *wcscat(wchar_t *, const wchar_t *);
@@ -448,4 +448,6 @@
 /* WARNING: DO NOT EDIT, AUTO-GENERATED CODE - SEE TOP FOR INSTRUCTIONS */
 #define __NR_sendmmsg 345
 #define __NR_setns 346
+#define __NR_process_vm_readv 347
+#define __NR_process_vm_writev 348
 #endif
@@ -41,6 +41,7 @@ __RCSID("$NetBSD: ns_name.c,v 1.3 2004/11/07 02:19:49 christos Exp $");
 #include <ctype.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <pthread.h>
 
 #ifdef SPRINTF_CHAR
 # define SPRINTF(x) strlen(sprintf/**/x)
@@ -81,6 +82,11 @@ static int		printable(int);
 static int		dn_find(const u_char *, const u_char *,
 				const u_char * const *,
 				const u_char * const *);
+static int		dn_match(const u_char *, const u_char *,
+				 const u_char *);
+static struct dn_dict	*dn_dict_get(const u_char **, const u_char **);
+static int		dn_dict_find(struct dn_dict *, const u_char *,
+				     const u_char *, int *);
 static int		encode_bitsring(const char **, const char *,
 					unsigned char **, unsigned char **,
 					unsigned const char *);
@@ -483,6 +489,8 @@ ns_name_pack(const u_char *src, u_char *dst, int dstsiz,
 	const u_char **cpp, **lpp, *eob, *msg;
 	const u_char *srcp;
 	int n, l, first = 1;
+	struct dn_dict *dict;
+	int label, match = -1, match_off = -1;
 
 	srcp = src;
 	dstp = dst;
@@ -519,14 +527,35 @@ ns_name_pack(const u_char *src, u_char *dst, int dstsiz,
 		srcp += l0 + 1;
 	} while (n != 0);
 
+	/*
+	 * With a long list of previous names, find the longest suffix of
+	 * this one that's already in the message by hashing, rather than
+	 * by comparing each suffix against every previous name.
+	 */
+	dict = NULL;
+	if (msg != NULL && (dict = dn_dict_get(dnptrs - 1, lpp)) != NULL)
+		match = dn_dict_find(dict, src, msg, &match_off);
+	if (match == -2)
+		dict = NULL;
+
 	/* from here on we need to reset compression pointer array on error */
 	srcp = src;
+	label = 0;
 	do {
 		/* Look to see if we can use pointers. */
 		n = *srcp;
 		if (n != 0 && msg != NULL) {
-			l = dn_find(srcp, msg, (const u_char * const *)dnptrs,
-				    (const u_char * const *)lpp);
+			if (dict == NULL) {
+				l = dn_find(srcp, msg,
+					    (const u_char * const *)dnptrs,
+					    (const u_char * const *)lpp);
+			} else if (label == match) {
+				l = match_off;
+			} else {
+				errno = ENOENT;
+				l = -1;
+			}
+			label++;
 			if (l >= 0) {
 				if (dstp + 1 >= eob) {
 					goto cleanup;
@@ -739,9 +768,8 @@ dn_find(const u_char *domain, const u_char *msg,
 	const u_char * const *dnptrs,
 	const u_char * const *lastdnptr)
 {
-	const u_char *dn, *cp, *sp;
+	const u_char *sp;
 	const u_char * const *cpp;
-	u_int n;
 
 	for (cpp = dnptrs; cpp < lastdnptr; cpp++) {
 		sp = *cpp;
@@ -753,39 +781,12 @@ dn_find(const u_char *domain, const u_char *msg,
 		 */
 		while (*sp != 0 && (*sp & NS_CMPRSFLGS) == 0 &&
 		       (sp - msg) < 0x4000) {
-			dn = domain;
-			cp = sp;
-			while ((n = *cp++) != 0) {
-				/*
-				 * check for indirection
-				 */
-				switch (n & NS_CMPRSFLGS) {
-				case 0:		/* normal case, n == len */
-					n = labellen(cp - 1); /* XXX */
-
-					if (n != *dn++)
-						goto next;
-
-					for (; n > 0; n--)
-						if (mklower(*dn++) !=
-						    mklower(*cp++))
-							goto next;
-					/* Is next root for both ? */
-					if (*dn == '\0' && *cp == '\0')
-						return (sp - msg);
-					if (*dn)
-						continue;
-					goto next;
-				case NS_CMPRSFLGS:	/* indirection */
-					cp = msg + (((n & 0x3f) << 8) | *cp);
-					break;
-
-				default:	/* illegal type */
-					errno = EMSGSIZE;
-					return (-1);
-				}
+			switch (dn_match(domain, msg, sp)) {
+			case 1:
+				return (sp - msg);
+			case -1:
+				return (-1);
 			}
- next: ;
 			sp += *sp + 1;
 		}
 	}
@@ -793,6 +794,317 @@ dn_find(const u_char *domain, const u_char *msg,
 	return (-1);
 }
 
+/*
+ * dn_match(domain, msg, sp)
+ *	Compare the counted-label name with the compressed name at sp.
+ * return:
+ *	1 if they're the same, 0 if not, or -1 (with errno set) for a
+ *	label type we don't understand.
+ */
+static int
+dn_match(const u_char *domain, const u_char *msg, const u_char *sp)
+{
+	const u_char *dn, *cp;
+	u_int n;
+
+	dn = domain;
+	cp = sp;
+	while ((n = *cp++) != 0) {
+		/*
+		 * check for indirection
+		 */
+		switch (n & NS_CMPRSFLGS) {
+		case 0:		/* normal case, n == len */
+			n = labellen(cp - 1); /* XXX */
+
+			if (n != *dn++)
+				return (0);
+
+			for (; n > 0; n--)
+				if (mklower(*dn++) != mklower(*cp++))
+					return (0);
+			/* Is next root for both ? */
+			if (*dn == '\0' && *cp == '\0')
+				return (1);
+			if (*dn)
+				continue;
+			return (0);
+		case NS_CMPRSFLGS:	/* indirection */
+			cp = msg + (((n & 0x3f) << 8) | *cp);
+			break;
+
+		default:	/* illegal type */
+			errno = EMSGSIZE;
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+/*
+ * The compression dictionary: every offset dn_find would try, hashed by
+ * the (case-folded) name found there.  There's one per thread, for the
+ * dnptrs array most recently packed into.  It's only trusted while that
+ * array still starts with the names it has seen, which stops being true
+ * as soon as a caller starts a new message (dnptrs[1] = NULL) or rolls
+ * one back.
+ */
+#define DN_DICT_MIN	16	/* shorter lists just use dn_find */
+#define DN_MAXLABELS	(NS_MAXCDNAME / 2)
+
+struct dn_dict_entry {
+	u_int32_t	hash;
+	int		off;	/* from msg */
+	int		next;	/* earlier entry in the bucket, or -1 */
+};
+
+struct dn_dict {
+	const u_char	**dnptrs;
+	const u_char	*msg;
+	const u_char	**names;	/* copy of dnptrs[1..nnames] */
+	int		nnames, maxnames;
+	struct dn_dict_entry *entries;
+	int		nentries, maxentries;
+	int		*buckets;
+	int		nbuckets;	/* a power of two */
+	int		broken;		/* odd labels: leave it to dn_find */
+};
+
+static pthread_key_t	dn_dict_key;
+static pthread_once_t	dn_dict_once = PTHREAD_ONCE_INIT;
+
+static void
+dn_dict_free(void *arg)
+{
+	struct dn_dict *dict = arg;
+
+	free(dict->names);
+	free(dict->entries);
+	free(dict->buckets);
+	free(dict);
+}
+
+static void
+dn_dict_init_key(void)
+{
+	pthread_key_create(&dn_dict_key, dn_dict_free);
+}
+
+static void
+dn_dict_reset(struct dn_dict *dict, const u_char **dnptrs)
+{
+	dict->dnptrs = dnptrs;
+	dict->msg = dnptrs[0];
+	dict->nnames = 0;
+	dict->nentries = 0;
+	dict->broken = 0;
+	memset(dict->buckets, 0xff, dict->nbuckets * sizeof(int));
+}
+
+static u_int32_t
+dn_hash_label(u_int32_t h, const u_char *label)
+{
+	u_int n;
+
+	for (n = 0; n <= *label; n++)
+		h = (h ^ (u_int32_t)mklower(label[n])) * 16777619;
+	return (h);
+}
+
+/*
+ * Collect the labels of a compressed name, and the hash of the name
+ * starting at each of them.  Returns the number of labels, -1 if the name
+ * can never be matched (see dn_match), or -2 for label types dn_match
+ * rejects.
+ */
+static int
+dn_labels(const u_char *name, const u_char *msg,
+	  const u_char *labels[DN_MAXLABELS], u_int32_t hashes[DN_MAXLABELS])
+{
+	const u_char *cp = name;
+	int i, nlabels = 0, hops = 0;
+	u_int32_t h;
+	u_int n;
+
+	while ((n = *cp) != 0) {
+		switch (n & NS_CMPRSFLGS) {
+		case 0:
+			if (nlabels == DN_MAXLABELS)
+				return (-1);
+			labels[nlabels++] = cp;
+			cp += n + 1;
+			break;
+		case NS_CMPRSFLGS:
+			/* dn_match wants the name's root label in place. */
+			if (nlabels == 0 || ++hops > DN_MAXLABELS)
+				return (-1);
+			cp = msg + (((n & 0x3f) << 8) | cp[1]);
+			if (*cp == 0)
+				return (-1);
+			break;
+		default:
+			return (-2);
+		}
+	}
+	for (h = 2166136261U, i = nlabels - 1; i >= 0; i--)
+		hashes[i] = h = dn_hash_label(h, labels[i]);
+	return (nlabels);
+}
+
+static int
+dn_dict_grow(struct dn_dict *dict)
+{
+	struct dn_dict_entry *entries;
+	int *buckets;
+	int i, max = dict->maxentries * 2;
+
+	entries = realloc(dict->entries, max * sizeof(*entries));
+	if (entries == NULL)
+		return (-1);
+	dict->entries = entries;
+	dict->maxentries = max;
+	buckets = realloc(dict->buckets, max * sizeof(int));
+	if (buckets == NULL)
+		return (-1);
+	dict->buckets = buckets;
+	dict->nbuckets = max;
+	memset(buckets, 0xff, max * sizeof(int));
+	for (i = 0; i < dict->nentries; i++) {
+		int b = entries[i].hash & (max - 1);
+
+		entries[i].next = buckets[b];
+		buckets[b] = i;
+	}
+	return (0);
+}
+
+/* Add the offsets dn_find would try for the name at sp, in its order. */
+static void
+dn_dict_add(struct dn_dict *dict, const u_char *sp)
+{
+	const u_char *labels[DN_MAXLABELS];
+	u_int32_t hashes[DN_MAXLABELS];
+	int i, n;
+
+	n = dn_labels(sp, dict->msg, labels, hashes);
+	if (n == -2)
+		dict->broken = 1;
+	for (i = 0; i < n && labels[i] == sp && (sp - dict->msg) < 0x4000;
+	     i++, sp += *sp + 1) {
+		struct dn_dict_entry *e;
+		int b;
+
+		if (dict->nentries == dict->maxentries &&
+		    dn_dict_grow(dict) < 0) {
+			dict->broken = 1;
+			return;
+		}
+		b = hashes[i] & (dict->nbuckets - 1);
+		e = &dict->entries[dict->nentries];
+		e->hash = hashes[i];
+		e->off = sp - dict->msg;
+		e->next = dict->buckets[b];
+		dict->buckets[b] = dict->nentries++;
+	}
+}
+
+/*
+ * Return this thread's dictionary for the names in dnptrs (which includes
+ * the message pointer) up to lastdnptr, or NULL to use dn_find.
+ */
+static struct dn_dict *
+dn_dict_get(const u_char **dnptrs, const u_char **lastdnptr)
+{
+	struct dn_dict *dict;
+	int n = lastdnptr - (dnptrs + 1);
+
+	pthread_once(&dn_dict_once, dn_dict_init_key);
+	dict = pthread_getspecific(dn_dict_key);
+	/* Even short lists have to be checked, to notice new messages. */
+	if (dict != NULL &&
+	    (dict->dnptrs != dnptrs || dict->msg != dnptrs[0] ||
+	     dict->nnames > n ||
+	     (dict->nnames != 0 &&
+	      memcmp(dict->names, dnptrs + 1,
+		     dict->nnames * sizeof(*dnptrs)) != 0)))
+		dn_dict_reset(dict, dnptrs);
+	if (n < DN_DICT_MIN)
+		return (NULL);
+
+	if (dict == NULL) {
+		dict = calloc(1, sizeof(*dict));
+		if (dict == NULL)
+			return (NULL);
+		dict->maxentries = dict->nbuckets = 64;
+		dict->entries = malloc(dict->maxentries *
+		    sizeof(*dict->entries));
+		dict->buckets = malloc(dict->nbuckets * sizeof(int));
+		if (dict->entries == NULL || dict->buckets == NULL ||
+		    pthread_setspecific(dn_dict_key, dict) != 0) {
+			dn_dict_free(dict);
+			return (NULL);
+		}
+		dn_dict_reset(dict, dnptrs);
+	}
+
+	if (n > dict->maxnames) {
+		int max = n * 2;
+		const u_char **names = realloc(dict->names,
+		    max * sizeof(*names));
+
+		if (names == NULL)
+			return (NULL);
+		dict->names = names;
+		dict->maxnames = max;
+	}
+	for (; dict->nnames < n; dict->nnames++) {
+		const u_char *sp = dnptrs[1 + dict->nnames];
+
+		dict->names[dict->nnames] = sp;
+		if (!dict->broken)
+			dn_dict_add(dict, sp);
+	}
+	return (dict->broken ? NULL : dict);
+}
+
+/*
+ * dn_dict_find(dict, domain, msg, offp)
+ *	Find the longest suffix of the counted-label name that dn_find
+ *	would find, and the offset it would find it at.
+ * return:
+ *	index of the first label of that suffix, with its offset in *offp;
+ *	-1 if there's no such suffix; or -2 if dn_find should be used.
+ */
+static int
+dn_dict_find(struct dn_dict *dict, const u_char *domain, const u_char *msg,
+	     int *offp)
+{
+	const u_char *labels[DN_MAXLABELS];
+	u_int32_t hashes[DN_MAXLABELS];
+	int i, n;
+
+	n = dn_labels(domain, msg, labels, hashes);
+	if (n < 0)
+		return (-2);
+	for (i = 0; i < n; i++) {
+		int e, found = -1;
+
+		/* Buckets are newest first; dn_find returns the oldest. */
+		for (e = dict->buckets[hashes[i] & (dict->nbuckets - 1)];
+		     e != -1; e = dict->entries[e].next) {
+			if (dict->entries[e].hash == hashes[i] &&
+			    dn_match(labels[i], msg,
+				     msg + dict->entries[e].off) == 1)
+				found = e;
+		}
+		if (found != -1) {
+			*offp = dict->entries[found].off;
+			return (i);
+		}
+	}
+	return (-1);
+}
+
 static int
 decode_bitstring(const unsigned char **cpp, char *dn, const char *eom)
 {
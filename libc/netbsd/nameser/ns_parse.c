@@ -34,6 +34,8 @@ __RCSID("$NetBSD: ns_parse.c,v 1.2 2004/05/20 20:35:05 christos Exp $");
 #include "arpa_nameser.h"
 
 #include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
 #ifdef ANDROID_CHANGES
 #include "resolv_private.h"
 #else
@@ -44,11 +46,31 @@ __RCSID("$NetBSD: ns_parse.c,v 1.2 2004/05/20 20:35:05 christos Exp $");
 /* Forward. */
 
 static void	setsection(ns_msg *msg, ns_sect sect);
+static struct rr_index *rr_index_get(const ns_msg *msg, ns_sect sect);
+static void	rr_index_forget(const u_char *msg);
 
 /* Macros. */
 
 #define RETERR(err) do { errno = (err); return (-1); } while (/*NOTREACHED*//*CONSTCOND*/0)
 
+/*
+ * Where each record of the section last parsed on this thread starts, so
+ * that going back to an earlier record doesn't mean skipping over the
+ * section from its start again.  ns_initparse drops it, so a buffer that's
+ * reused for a new message is never mistaken for the old one; the copy of
+ * the header covers handles initialized on some other thread.
+ */
+#define RR_INDEX_MAX	256
+
+struct rr_index {
+	const u_char	*msg;
+	const u_char	*eom;
+	u_char		hdr[NS_HFIXEDSZ];
+	ns_sect		sect;
+	int		count;
+	const u_char	*rr[RR_INDEX_MAX];
+};
+
 /* Public. */
 
 /* These need to be in the same order as the nres.h:ns_flag enum. */
@@ -104,6 +126,7 @@ ns_initparse(const u_char *msg, int msglen, ns_msg *handle) {
 	const u_char *eom = msg + msglen;
 	int i;
 
+	rr_index_forget(msg);
 	memset(handle, 0x5e, sizeof *handle);
 	handle->_msg = msg;
 	handle->_eom = eom;
@@ -138,7 +161,9 @@ ns_initparse(const u_char *msg, int msglen, ns_msg *handle) {
 
 int
 ns_parserr(ns_msg *handle, ns_sect section, int rrnum, ns_rr *rr) {
-	int b;
+	struct rr_index *idx;
+	const u_char *ptr;
+	int b, num;
 
 	/* Make section right. */
 	if ((unsigned)section >= (unsigned)ns_s_max)
@@ -151,17 +176,28 @@ ns_parserr(ns_msg *handle, ns_sect section, int rrnum, ns_rr *rr) {
 		rrnum = handle->_rrnum;
 	if (rrnum < 0 || rrnum >= handle->_counts[(int)section])
 		RETERR(ENODEV);
+	idx = rr_index_get(handle, section);
+	if (idx != NULL && rrnum != handle->_rrnum && rrnum < idx->count) {
+		/* We've been here before. */
+		handle->_msg_ptr = idx->rr[rrnum];
+		handle->_rrnum = rrnum;
+	}
 	if (rrnum < handle->_rrnum)
 		setsection(handle, section);
-	if (rrnum > handle->_rrnum) {
-		b = ns_skiprr(handle->_msg_ptr, handle->_eom, section,
-			      rrnum - handle->_rrnum);
-
+	/* Skip one record at a time, remembering where each one starts. */
+	ptr = handle->_msg_ptr;
+	for (num = handle->_rrnum; num < rrnum; num++) {
+		if (idx != NULL && num == idx->count && num < RR_INDEX_MAX)
+			idx->rr[idx->count++] = ptr;
+		b = ns_skiprr(ptr, handle->_eom, section, 1);
 		if (b < 0)
 			return (-1);
-		handle->_msg_ptr += b;
-		handle->_rrnum = rrnum;
+		ptr += b;
 	}
+	handle->_msg_ptr = ptr;
+	handle->_rrnum = rrnum;
+	if (idx != NULL && rrnum == idx->count && rrnum < RR_INDEX_MAX)
+		idx->rr[idx->count++] = ptr;
 
 	/* Do the parse. */
 	b = dn_expand(handle->_msg, handle->_eom,
@@ -196,6 +232,51 @@ ns_parserr(ns_msg *handle, ns_sect section, int rrnum, ns_rr *rr) {
 
 /* Private. */
 
+static pthread_key_t	rr_index_key;
+static pthread_once_t	rr_index_once = PTHREAD_ONCE_INIT;
+
+static void
+rr_index_init_key(void) {
+	pthread_key_create(&rr_index_key, free);
+}
+
+static struct rr_index *
+rr_index_get(const ns_msg *msg, ns_sect sect) {
+	struct rr_index *idx;
+
+	pthread_once(&rr_index_once, rr_index_init_key);
+	idx = pthread_getspecific(rr_index_key);
+	if (idx == NULL) {
+		idx = malloc(sizeof *idx);
+		if (idx == NULL)
+			return (NULL);
+		if (pthread_setspecific(rr_index_key, idx) != 0) {
+			free(idx);
+			return (NULL);
+		}
+		idx->msg = NULL;
+	}
+	if (idx->msg != msg->_msg || idx->eom != msg->_eom ||
+	    idx->sect != sect || memcmp(idx->hdr, msg->_msg, NS_HFIXEDSZ) != 0) {
+		idx->msg = msg->_msg;
+		idx->eom = msg->_eom;
+		memcpy(idx->hdr, msg->_msg, NS_HFIXEDSZ);
+		idx->sect = sect;
+		idx->count = 0;
+	}
+	return (idx);
+}
+
+static void
+rr_index_forget(const u_char *msg) {
+	struct rr_index *idx;
+
+	pthread_once(&rr_index_once, rr_index_init_key);
+	idx = pthread_getspecific(rr_index_key);
+	if (idx != NULL && idx->msg == msg)
+		idx->msg = NULL;
+}
+
 static void
 setsection(ns_msg *msg, ns_sect sect) {
 	msg->_sect = sect;
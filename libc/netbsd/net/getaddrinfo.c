@@ -78,7 +78,9 @@
  */
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/cdefs.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
@@ -92,6 +94,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <netdb.h>
+#include <android/getaddrinfo_async.h>
 #include "resolv_private.h"
 #include <stdbool.h>
 #include <stddef.h>
@@ -403,35 +406,62 @@ _have_ipv4() {
         return _test_connect(PF_INET, &addr.generic, sizeof(addr.in));
 }
 
-// Returns 0 on success, else returns on error.
-static int
-android_getaddrinfo_proxy(
-    const char *hostname, const char *servname,
-    const struct addrinfo *hints, struct addrinfo **res, const char *iface)
+/*
+ * Connections to dnsproxyd are kept open between lookups, as connecting
+ * costs about as much as a cached answer. A thread takes an idle connection
+ * out of the pool, or opens a new one, for the duration of one request, and
+ * gives it back once the whole reply has been read. Connections that failed
+ * or were left in the middle of a reply are closed instead.
+ */
+#define PROXY_POOL_SIZE 4
+
+static pthread_mutex_t proxy_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t proxy_pool_once = PTHREAD_ONCE_INIT;
+static FILE* proxy_pool[PROXY_POOL_SIZE];
+static int proxy_pool_count;
+
+static void
+proxy_pool_lock_all(void)
 {
-	int sock;
-	const int one = 1;
-	struct sockaddr_un proxy_addr;
-	FILE* proxy = NULL;
-	int success = 0;
+	pthread_mutex_lock(&proxy_pool_lock);
+}
 
-	// Clear this at start, as we use its non-NULLness later (in the
-	// error path) to decide if we have to free up any memory we
-	// allocated in the process (before failing).
-	*res = NULL;
+static void
+proxy_pool_unlock_all(void)
+{
+	pthread_mutex_unlock(&proxy_pool_lock);
+}
 
-	// Bogus things we can't serialize.  Don't use the proxy.  These will fail - let them.
-	if ((hostname != NULL &&
-	     strcspn(hostname, " \n\r\t^'\"") != strlen(hostname)) ||
-	    (servname != NULL &&
-	     strcspn(servname, " \n\r\t^'\"") != strlen(servname))) {
-		return EAI_NODATA;
+// A child shares its parent's sockets, so it mustn't reuse them: their
+// replies could go to either process.
+static void
+proxy_pool_child(void)
+{
+	while (proxy_pool_count > 0) {
+		fclose(proxy_pool[--proxy_pool_count]);
 	}
+	pthread_mutex_unlock(&proxy_pool_lock);
+}
+
+static void
+proxy_pool_init(void)
+{
+	pthread_atfork(proxy_pool_lock_all, proxy_pool_unlock_all, proxy_pool_child);
+}
+
+static FILE*
+proxy_connect(void)
+{
+	int sock;
+	const int one = 1;
+	struct sockaddr_un proxy_addr;
+	FILE* proxy;
 
 	sock = socket(AF_UNIX, SOCK_STREAM, 0);
 	if (sock < 0) {
-		return EAI_NODATA;
+		return NULL;
 	}
+	fcntl(sock, F_SETFD, FD_CLOEXEC);
 
 	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
 	memset(&proxy_addr, 0, sizeof(proxy_addr));
@@ -442,28 +472,147 @@ android_getaddrinfo_proxy(
 				       (const struct sockaddr*) &proxy_addr,
 				       sizeof(proxy_addr))) != 0) {
 		close(sock);
-		return EAI_NODATA;
+		return NULL;
 	}
 
-	// Send the request.
 	proxy = fdopen(sock, "r+");
-	if (fprintf(proxy, "getaddrinfo %s %s %d %d %d %d %s",
+	if (proxy == NULL) {
+		close(sock);
+	}
+	return proxy;
+}
+
+// Returns an idle pooled connection, setting '*reused', or a new one.
+static FILE*
+proxy_get(int* reused)
+{
+	FILE* proxy;
+	char c;
+
+	for (;;) {
+		proxy = NULL;
+		pthread_mutex_lock(&proxy_pool_lock);
+		if (proxy_pool_count > 0) {
+			proxy = proxy_pool[--proxy_pool_count];
+		}
+		pthread_mutex_unlock(&proxy_pool_lock);
+		if (proxy == NULL) {
+			break;
+		}
+		// An idle connection has nothing to read unless dnsproxyd
+		// closed it.
+		if (recv(fileno(proxy), &c, 1, MSG_PEEK | MSG_DONTWAIT) < 0 &&
+		    errno == EAGAIN) {
+			*reused = 1;
+			return proxy;
+		}
+		fclose(proxy);
+	}
+
+	*reused = 0;
+	return proxy_connect();
+}
+
+// Gives back a connection whose last reply was read in full.
+static void
+proxy_put(FILE* proxy)
+{
+	pthread_once(&proxy_pool_once, proxy_pool_init);
+
+	pthread_mutex_lock(&proxy_pool_lock);
+	if (proxy_pool_count < PROXY_POOL_SIZE) {
+		proxy_pool[proxy_pool_count++] = proxy;
+		proxy = NULL;
+	}
+	pthread_mutex_unlock(&proxy_pool_lock);
+
+	if (proxy != NULL) {
+		fclose(proxy);
+	}
+}
+
+// Writes the whole request, bypassing stdio so that a connection dnsproxyd
+// closed while it was idle fails with EPIPE rather than raising SIGPIPE.
+static int
+proxy_send(FILE* proxy, const char* request, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = TEMP_FAILURE_RETRY(send(fileno(proxy), request, len,
+						    MSG_NOSIGNAL));
+		if (n <= 0) {
+			return -1;
+		}
+		request += n;
+		len -= n;
+	}
+	return 0;
+}
+
+// Sends a getaddrinfo request to dnsproxyd. Returns the connection its
+// reply will arrive on, to be passed to android_getaddrinfo_proxy_recv(), or
+// NULL on error.
+static FILE*
+android_getaddrinfo_proxy_send(
+    const char *hostname, const char *servname,
+    const struct addrinfo *hints, const char *iface)
+{
+	FILE* proxy = NULL;
+	char* request;
+	int request_len;
+	int reused;
+
+	// Bogus things we can't serialize.  Don't use the proxy.  These will fail - let them.
+	if ((hostname != NULL &&
+	     strcspn(hostname, " \n\r\t^'\"") != strlen(hostname)) ||
+	    (servname != NULL &&
+	     strcspn(servname, " \n\r\t^'\"") != strlen(servname))) {
+		return NULL;
+	}
+
+	request_len = asprintf(&request, "getaddrinfo %s %s %d %d %d %d %s",
 		    hostname == NULL ? "^" : hostname,
 		    servname == NULL ? "^" : servname,
 		    hints == NULL ? -1 : hints->ai_flags,
 		    hints == NULL ? -1 : hints->ai_family,
 		    hints == NULL ? -1 : hints->ai_socktype,
 		    hints == NULL ? -1 : hints->ai_protocol,
-		    iface == NULL ? "^" : iface) < 0) {
-		goto exit;
+		    iface == NULL ? "^" : iface);
+	if (request_len < 0) {
+		return NULL;
 	}
-	// literal NULL byte at end, required by FrameworkListener
-	if (fputc(0, proxy) == EOF ||
-	    fflush(proxy) != 0) {
-		goto exit;
+
+	// Send the request, with the literal NULL byte at the end that
+	// FrameworkListener requires. If dnsproxyd closed a pooled connection
+	// since it was checked, try again on a new one.
+	for (;;) {
+		proxy = proxy_get(&reused);
+		if (proxy == NULL ||
+		    proxy_send(proxy, request, request_len + 1) == 0) {
+			break;
+		}
+		fclose(proxy);
+		proxy = NULL;
+		if (!reused) {
+			break;
+		}
 	}
+	free(request);
+	return proxy;
+}
 
+// Reads dnsproxyd's reply from 'proxy', which it then pools or closes.
+// Returns 0 on success, else returns on error.
+static int
+android_getaddrinfo_proxy_recv(FILE* proxy, struct addrinfo **res)
+{
+	int success = 0;
 	char buf[4];
+
+	// Clear this at start, as we use its non-NULLness later (in the
+	// error path) to decide if we have to free up any memory we
+	// allocated in the process (before failing).
+	*res = NULL;
+
 	// read result code for gethostbyaddr
 	if (fread(buf, 1, sizeof(buf), proxy) != sizeof(buf)) {
 		goto exit;
@@ -557,13 +706,11 @@ android_getaddrinfo_proxy(
 		freeaddrinfo(ai);
 	}
 exit:
-	if (proxy != NULL) {
-		fclose(proxy);
-	}
-
 	if (success) {
+		proxy_put(proxy);
 		return 0;
 	}
+	fclose(proxy);
 
 	// Proxy failed;
 	// clean up memory we might've allocated.
@@ -574,16 +721,31 @@ exit:
 	return EAI_NODATA;
 }
 
-int
-getaddrinfo(const char *hostname, const char *servname,
-    const struct addrinfo *hints, struct addrinfo **res)
+// Returns 0 on success, else returns on error.
+static int
+android_getaddrinfo_proxy(
+    const char *hostname, const char *servname,
+    const struct addrinfo *hints, struct addrinfo **res, const char *iface)
 {
-	return android_getaddrinfoforiface(hostname, servname, hints, NULL, 0, res);
+	FILE* proxy;
+
+	*res = NULL;
+	proxy = android_getaddrinfo_proxy_send(hostname, servname, hints, iface);
+	if (proxy == NULL) {
+		return EAI_NODATA;
+	}
+	return android_getaddrinfo_proxy_recv(proxy, res);
 }
 
-int
-android_getaddrinfoforiface(const char *hostname, const char *servname,
-    const struct addrinfo *hints, const char *iface, int mark, struct addrinfo **res)
+/*
+ * The body of android_getaddrinfoforiface(). If 'pending' isn't NULL, a
+ * lookup that has to go to dnsproxyd is only sent, and '*pending' is set to
+ * the connection its reply will arrive on.
+ */
+static int
+android_getaddrinfo_internal(const char *hostname, const char *servname,
+    const struct addrinfo *hints, const char *iface, int mark,
+    struct addrinfo **res, FILE **pending)
 {
 	struct addrinfo sentinel;
 	struct addrinfo *cur;
@@ -732,6 +894,11 @@ android_getaddrinfoforiface(const char *hostname, const char *servname,
          */
 	if (cache_mode == NULL || strcmp(cache_mode, "local") != 0) {
 		// we're not the proxy - pass the request to them
+		if (pending != NULL) {
+			*pending = android_getaddrinfo_proxy_send(hostname,
+			    servname, hints, iface);
+			return (*pending != NULL) ? 0 : EAI_NODATA;
+		}
 		return android_getaddrinfo_proxy(hostname, servname, hints, res, iface);
 	}
 
@@ -790,6 +957,104 @@ android_getaddrinfoforiface(const char *hostname, const char *servname,
 	return error;
 }
 
+int
+getaddrinfo(const char *hostname, const char *servname,
+    const struct addrinfo *hints, struct addrinfo **res)
+{
+	return android_getaddrinfoforiface(hostname, servname, hints, NULL, 0, res);
+}
+
+int
+android_getaddrinfoforiface(const char *hostname, const char *servname,
+    const struct addrinfo *hints, const char *iface, int mark, struct addrinfo **res)
+{
+	return android_getaddrinfo_internal(hostname, servname, hints, iface,
+	    mark, res, NULL);
+}
+
+/*
+ * An asynchronous lookup is either waiting for dnsproxyd's reply on 'proxy',
+ * or was already complete when it was started, in which case its result is
+ * in 'res' and 'event_fd' is always readable.
+ */
+struct android_getaddrinfo_request {
+	FILE* proxy;
+	int event_fd;
+	struct addrinfo* res;
+};
+
+int
+android_getaddrinfo_async(const char *hostname, const char *servname,
+    const struct addrinfo *hints, const char *iface, int mark,
+    android_getaddrinfo_request_t **request)
+{
+	android_getaddrinfo_request_t* r;
+	int error;
+
+	assert(request != NULL);
+	*request = NULL;
+
+	r = calloc(1, sizeof(*r));
+	if (r == NULL) {
+		return EAI_MEMORY;
+	}
+	r->event_fd = -1;
+
+	error = android_getaddrinfo_internal(hostname, servname, hints, iface,
+	    mark, &r->res, &r->proxy);
+	if (error == 0 && r->proxy == NULL) {
+		r->event_fd = eventfd(1, EFD_CLOEXEC);
+		if (r->event_fd < 0) {
+			freeaddrinfo(r->res);
+			error = EAI_SYSTEM;
+		}
+	}
+	if (error != 0) {
+		free(r);
+		return error;
+	}
+	*request = r;
+	return 0;
+}
+
+int
+android_getaddrinfo_fd(const android_getaddrinfo_request_t *request)
+{
+	return (request->proxy != NULL) ? fileno(request->proxy) : request->event_fd;
+}
+
+int
+android_getaddrinfo_result(android_getaddrinfo_request_t *request,
+    struct addrinfo **res)
+{
+	int error = 0;
+
+	assert(res != NULL);
+	if (request->proxy != NULL) {
+		error = android_getaddrinfo_proxy_recv(request->proxy, res);
+	} else {
+		*res = request->res;
+		close(request->event_fd);
+	}
+	free(request);
+	return error;
+}
+
+void
+android_getaddrinfo_cancel(android_getaddrinfo_request_t *request)
+{
+	if (request->proxy != NULL) {
+		// dnsproxyd will still write the reply: the connection can't
+		// be reused.
+		fclose(request->proxy);
+	} else {
+		if (request->res != NULL)
+			freeaddrinfo(request->res);
+		close(request->event_fd);
+	}
+	free(request);
+}
+
 /*
  * FQDN hostname, DNS lookup
  */
@@ -2164,6 +2429,9 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 	struct res_target *t;
 	int rcode;
 	int ancount;
+	struct res_sendq sq[RES_NSENDN_MAX];
+	u_char sqbuf[RES_NSENDN_MAX][PACKETSZ];
+	int i, nsq;
 
 	assert(name != NULL);
 	/* XXX: target may be NULL??? */
@@ -2171,12 +2439,45 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 	rcode = NOERROR;
 	ancount = 0;
 
-	for (t = target; t; t = t->next) {
+	/*
+	 * With RES_BLAST, the queries (AAAA and A, typically) are all sent
+	 * at once, and the loop below only has to look at the answers.
+	 */
+	nsq = 0;
+	if ((res->options & RES_BLAST) != 0U) {
+		for (t = target; t && nsq < RES_NSENDN_MAX; t = t->next, nsq++) {
+			hp = (HEADER *)(void *)t->answer;
+			hp->rcode = NOERROR;	/* default */
+
+			n = res_nmkquery(res, QUERY, name, t->qclass, t->qtype,
+			    NULL, 0, NULL, sqbuf[nsq], sizeof(sqbuf[nsq]));
+#ifdef RES_USE_EDNS0
+			if (n > 0 && (res->options & RES_USE_EDNS0) != 0)
+				n = res_nopt(res, n, sqbuf[nsq],
+				    sizeof(sqbuf[nsq]), t->anslen);
+#endif
+			if (n <= 0) {
+				h_errno = NO_RECOVERY;
+				return n;
+			}
+			sq[nsq].buf = sqbuf[nsq];
+			sq[nsq].buflen = n;
+			sq[nsq].ans = t->answer;
+			sq[nsq].anssiz = t->anslen;
+		}
+		res_nsendN(res, sq, nsq);
+	}
+
+	for (t = target, i = 0; t; t = t->next, i++) {
 		int class, type;
 		u_char *answer;
 		int anslen;
 
 		hp = (HEADER *)(void *)t->answer;
+		if (i < nsq) {
+			n = sq[i].anslen;
+			goto answered;
+		}
 		hp->rcode = NOERROR;	/* default */
 
 		/* make it easier... */
@@ -2215,6 +2516,7 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 		}
 #endif
 
+ answered:
 		if (n < 0 || hp->rcode != NOERROR || ntohs(hp->ancount) == 0) {
 			rcode = hp->rcode;	/* record most recent error */
 #ifdef DEBUG
@@ -33,21 +33,11 @@ struct servent *
 getservbyport(int port, const char *proto)
 {
     res_static       rs = __res_get_static();
-    struct servent*  s;
 
     if (rs == NULL || proto == NULL) {
         errno = EINVAL;
         return NULL;
     }
 
-    rs->servent_ptr = NULL;
-    while (1) {
-        struct servent*  s = getservent_r(rs);
-        if (s == NULL)
-            break;
-        if ( s->s_port == port && !strcmp( s->s_proto, proto ) )
-            return s;
-    }
-
-    return NULL;
+    return getservent_byport_r(rs, port, proto);
 }
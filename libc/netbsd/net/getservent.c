@@ -118,6 +118,107 @@ getservent_r( res_static  rs )
     return &rs->servent;
 }
 
+/* compare the name or alias of _services at 'name' and the protocol of the
+ * entry at 'entry' with 'key' (of 'keylen' bytes) and 'proto' ('t' or 'u') */
+static int
+_servent_cmp_name( int  name, int  entry, const char*  key, int  keylen, int  proto )
+{
+    const char*  p   = _services + name;
+    int          len = p[0];
+    int          ret;
+
+    ret = memcmp( p+1, key, len < keylen ? len : keylen );
+    if (ret == 0)
+        ret = len - keylen;
+    if (ret == 0) {
+        p   = _services + entry;
+        ret = p[1+p[0]+2] - proto;
+    }
+    return ret;
+}
+
+/* same as above, for the port (in host byte order) and protocol */
+static int
+_servent_cmp_port( int  offset, int  port, int  proto )
+{
+    const unsigned char*  p = (const unsigned char*)_services + offset;
+    int                   ret;
+
+    p  += 1 + p[0];
+    ret = ((p[0] << 8) | p[1]) - port;
+    if (ret == 0)
+        ret = p[2] - proto;
+    return ret;
+}
+
+static int
+_servent_proto( const char*  proto )
+{
+    if (!strcmp(proto, "tcp"))
+        return 't';
+    if (!strcmp(proto, "udp"))
+        return 'u';
+    return 0;
+}
+
+/* look the entries up in the sorted indexes that genserv.py generates. the
+ * searches find the first of equal entries, as a linear scan of
+ * getservent_r() would. names match aliases too */
+struct servent *
+getservent_byname_r( res_static  rs, const char*  name, const char*  proto )
+{
+    int  namelen = strlen(name);
+    int  c       = _servent_proto(proto);
+    int  lo      = 0;
+    int  hi      = _SERVICES_NAME_COUNT;
+
+    if (c == 0 || namelen > 255)
+        return NULL;
+
+    while (lo < hi) {
+        int  mid = lo + (hi - lo)/2;
+        if (_servent_cmp_name(_services_by_name[mid].name, _services_by_name[mid].entry,
+                              name, namelen, c) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == _SERVICES_NAME_COUNT ||
+        _servent_cmp_name(_services_by_name[lo].name, _services_by_name[lo].entry,
+                          name, namelen, c) != 0)
+        return NULL;
+
+    rs->servent_ptr = _services + _services_by_name[lo].entry;
+    return getservent_r(rs);
+}
+
+struct servent *
+getservent_byport_r( res_static  rs, int  port, const char*  proto )
+{
+    int  c  = _servent_proto(proto);
+    int  lo = 0;
+    int  hi = _SERVICES_COUNT;
+
+    /* 'port' is in network byte order, like s_port */
+    if (c == 0 || port < 0 || port > 0xffff)
+        return NULL;
+    port = ntohs(port);
+
+    while (lo < hi) {
+        int  mid = lo + (hi - lo)/2;
+        if (_servent_cmp_port(_services_by_port[mid], port, c) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == _SERVICES_COUNT ||
+        _servent_cmp_port(_services_by_port[lo], port, c) != 0)
+        return NULL;
+
+    rs->servent_ptr = _services + _services_by_port[lo];
+    return getservent_r(rs);
+}
+
 struct servent *
 getservent(void)
 {
@@ -42,3 +42,5 @@
 #include "resolv_static.h"
 
 struct servent*  getservent_r(res_static rs);
+struct servent*  getservent_byname_r(res_static rs, const char* name, const char* proto);
+struct servent*  getservent_byport_r(res_static rs, int port, const char* proto);
@@ -478,3 +478,163 @@ static const char  _services[] = "\
 \4fido\353\23t\0\
 \0";
 
+#define  _SERVICES_COUNT      476
+#define  _SERVICES_NAME_COUNT 600
+
+/* offsets of the names and aliases above and of their entries,
+ * sorted by name, then protocol */
+static const struct { unsigned short name, entry; }  _services_by_name[] = {
+    {1893,1879}, {1917,1903}, {1450,1437}, {1481,1468}, {1459,1437}, {1490,1468},
+    {782,782}, {801,801}, {5880,5880}, {5893,5893}, {5906,5906}, {5920,5920},
+    {2634,2634}, {2649,2649}, {4756,4756}, {4769,4769}, {4548,4548}, {4566,4566},
+    {4724,4724}, {4740,4740}, {4500,4500}, {4524,4524}, {4656,4656}, {4674,4674},
+    {4584,4584}, {4602,4602}, {4814,4814}, {4830,4830}, {4782,4782}, {4798,4798},
+    {4620,4620}, {4638,4638}, {4692,4692}, {4708,4708}, {4974,4974}, {4985,4985},
+    {6342,6342}, {6356,6356}, {6516,6516}, {6524,6524}, {1621,1621}, {1633,1633},
+    {1599,1599}, {1610,1610}, {1575,1575}, {1587,1587}, {1645,1645}, {1656,1656},
+    {999,999}, {1008,999}, {4888,4888}, {4903,4903}, {4918,4918}, {4932,4932},
+    {4946,4946}, {4960,4960}, {4520,4500}, {4544,4524}, {1499,1499}, {1507,1507},
+    {5838,5838}, {6134,6134}, {2334,2334}, {6506,6506}, {531,531}, {542,542},
+    {509,509}, {520,520}, {5102,5102}, {5111,5111}, {5030,5030}, {5040,5040},
+    {5050,5050}, {5066,5066}, {5012,5012}, {5021,5021}, {6145,6145}, {4190,4190},
+    {4203,4203}, {5729,5729}, {157,157}, {183,183}, {2531,2516}, {6250,6250},
+    {1879,1879}, {1903,1903}, {2383,2373}, {1367,1367}, {1382,1382}, {1341,1341},
+    {1354,1354}, {1851,1851}, {1865,1865}, {3696,3696}, {3708,3708}, {3720,3720},
+    {3735,3735}, {2343,2334}, {2516,2516}, {2500,2500}, {820,820}, {840,840},
+    {833,820}, {853,840}, {5619,5619}, {5631,5631}, {3620,3620}, {3635,3635},
+    {3910,3910}, {3919,3919}, {3300,3300}, {3327,3327}, {90,90}, {102,102},
+    {795,782}, {814,801}, {3766,3766}, {3775,3775}, {6532,6532}, {29,29},
+    {51,51}, {3888,3888}, {3899,3899}, {5964,5964}, {429,429}, {451,451},
+    {2210,2197}, {2236,2223}, {2262,2249}, {2292,2279}, {2152,2137}, {2182,2167},
+    {11,11}, {20,20}, {5415,5415}, {5991,5991}, {6007,6007}, {1129,1117},
+    {1147,1135}, {2325,2325}, {1795,1795}, {1807,1807}, {5944,5944}, {6556,6556},
+    {599,599}, {4846,4846}, {4867,4867}, {5750,5750}, {230,230}, {238,230},
+    {222,222}, {209,209}, {2885,2885}, {2871,2871}, {2569,2569}, {2580,2580},
+    {3802,3802}, {3813,3813}, {4466,4466}, {4483,4483}, {4432,4432}, {4449,4449},
+    {562,562}, {573,573}, {3784,3784}, {3793,3793}, {4996,4996}, {5004,5004},
+    {2249,2249}, {2279,2279}, {6054,6054}, {6066,6066}, {755,741}, {741,741},
+    {5301,5278}, {618,610}, {1991,1991}, {2001,2001}, {5952,5952}, {3966,3966},
+    {3974,3974}, {3834,3824}, {3848,3838}, {3824,3824}, {3838,3838}, {1027,999},
+    {1257,1247}, {1272,1262}, {1247,1247}, {1262,1262}, {1731,1731}, {1741,1741},
+    {2918,2918}, {2928,2928}, {1973,1973}, {1982,1982}, {3238,3238}, {3253,3253},
+    {2309,2309}, {2317,2317}, {5434,5434}, {1715,1715}, {1723,1723}, {1541,1541},
+    {1549,1549}, {6180,6180}, {2938,2938}, {2947,2947}, {2081,2081}, {2092,2092},
+    {6462,6462}, {6474,6474}, {5870,5870}, {764,764}, {4086,4070}, {4116,4100},
+    {4146,4130}, {4176,4160}, {6318,6318}, {6330,6330}, {3094,3094}, {3104,3104},
+    {5216,5190}, {5186,5160}, {648,648}, {689,689}, {2810,2810}, {5204,5190},
+    {5174,5160}, {676,648}, {717,689}, {5190,5190}, {5160,5160}, {661,648},
+    {702,689}, {5240,5240}, {5220,5220}, {3410,3410}, {3421,3421}, {2606,2606},
+    {5361,5361}, {5326,5326}, {5352,5352}, {5338,5326}, {671,648}, {712,689},
+    {5291,5278}, {5278,5278}, {5307,5307}, {2628,2617}, {5321,5307}, {2617,2617},
+    {5427,5427}, {3432,3432}, {3445,3445}, {3440,3432}, {3453,3445}, {1955,1955},
+    {1964,1964}, {2754,2754}, {2764,2764}, {631,631}, {5474,5474}, {1117,1117},
+    {1135,1135}, {3544,3544}, {2350,2350}, {3136,3136}, {3161,3161}, {3150,3136},
+    {3175,3161}, {5986,5976}, {279,270}, {1397,1397}, {1407,1407}, {6298,6282},
+    {6282,6282}, {2029,2029}, {2046,2046}, {5530,5530}, {5543,5543}, {5560,5560},
+    {3750,3750}, {3758,3758}, {6125,6125}, {3212,3212}, {3225,3225}, {3186,3186},
+    {3199,3199}, {141,141}, {149,149}, {473,473}, {5976,5976}, {3852,3852},
+    {3862,3862}, {354,339}, {339,339}, {440,429}, {462,451}, {5741,5741},
+    {3114,3114}, {3125,3125}, {1183,1183}, {1199,1199}, {1153,1153}, {1168,1168},
+    {1215,1215}, {1231,1231}, {2536,2536}, {592,584}, {114,114}, {2557,2557},
+    {2492,2482}, {1437,1437}, {1468,1468}, {3574,3574}, {3582,3582}, {369,359},
+    {5759,5759}, {5772,5772}, {1056,1056}, {2692,2692}, {2708,2708}, {6032,6032},
+    {6043,6043}, {2197,2197}, {2223,2223}, {2137,2137}, {2167,2167}, {2121,2121},
+    {2129,2129}, {6116,6116}, {2427,2427}, {1079,1079}, {1087,1087}, {46,29},
+    {68,51}, {3872,3872}, {3880,3880}, {3370,3354}, {3398,3382}, {3316,3300},
+    {3343,3327}, {5585,5585}, {5602,5602}, {5595,5585}, {5612,5602}, {6226,6226},
+    {6238,6238}, {3038,3038}, {3050,3050}, {5847,5847}, {5858,5858}, {5828,5828},
+    {5260,5260}, {1751,1751}, {1763,1763}, {6023,6023}, {904,884}, {919,910},
+    {934,925}, {949,940}, {884,884}, {910,910}, {925,925}, {940,940},
+    {2956,2956}, {2966,2966}, {5488,5488}, {5501,5501}, {966,955}, {988,977},
+    {4231,4216}, {4255,4240}, {4216,4216}, {4240,4240}, {893,884}, {5655,5655},
+    {2398,2398}, {2996,2996}, {3007,3007}, {1515,1515}, {1528,1528}, {3268,3268},
+    {3284,3284}, {1095,1095}, {1106,1106}, {1667,1667}, {1676,1676}, {126,126},
+    {135,126}, {3496,3480}, {3520,3504}, {3458,3458}, {3469,3469}, {3480,3480},
+    {3504,3504}, {3982,3982}, {3998,3998}, {399,399}, {414,414}, {1065,1056},
+    {2548,2536}, {2664,2664}, {3559,3559}, {330,322}, {4022,4022}, {4014,4014},
+    {2688,2664}, {2677,2664}, {5808,5808}, {5817,5817}, {584,584}, {322,322},
+    {3062,3062}, {3078,3078}, {5667,5667}, {3018,3018}, {3028,3028}, {2437,2437},
+    {2454,2437}, {2447,2437}, {2512,2500}, {1819,1819}, {1835,1835}, {6088,6088},
+    {6078,6078}, {6107,6107}, {6098,6098}, {2851,2851}, {2861,2861}, {3590,3590},
+    {3605,3605}, {860,860}, {872,872}, {2103,2103}, {2112,2112}, {3354,3354},
+    {3382,3382}, {2063,2063}, {2072,2072}, {6169,6155}, {6155,6155}, {6174,6155},
+    {1033,1033}, {6450,6450}, {6412,6412}, {6425,6425}, {6438,6438}, {2373,2373},
+    {5719,5719}, {2792,2792}, {2801,2801}, {41,29}, {63,51}, {4030,4030},
+    {4038,4038}, {4046,4046}, {4058,4058}, {5643,5643}, {6370,6370}, {6380,6380},
+    {270,270}, {5524,5514}, {1557,1557}, {1566,1566}, {1277,1277}, {1286,1286},
+    {1295,1295}, {1318,1318}, {1309,1295}, {1332,1318}, {2702,2692}, {2718,2708},
+    {2011,2011}, {2020,2020}, {2976,2976}, {2986,2986}, {176,157}, {202,183},
+    {5575,5575}, {2410,2398}, {243,243}, {251,251}, {5514,5514}, {2724,2724},
+    {2739,2739}, {3936,3928}, {3955,3947}, {955,955}, {977,977}, {730,730},
+    {5459,5459}, {5444,5444}, {5707,5707}, {3928,3928}, {3947,3947}, {5343,5343},
+    {2387,2387}, {73,73}, {377,377}, {388,388}, {481,481}, {495,495},
+    {2418,2418}, {1023,999}, {0,0}, {259,259}, {2894,2894}, {2906,2906},
+    {2482,2482}, {6546,6546}, {553,553}, {284,284}, {303,303}, {2461,2461},
+    {2471,2461}, {293,284}, {312,303}, {2774,2774}, {2783,2783}, {6215,6215},
+    {777,764}, {640,631}, {169,157}, {195,183}, {1927,1927}, {1941,1941},
+    {3528,3528}, {1074,1056}, {84,73}, {2591,2591}, {1042,1042}, {2600,2591},
+    {6486,6486}, {6496,6496}, {3650,3650}, {3660,3660}, {3670,3670}, {3683,3683},
+    {5082,5082}, {5092,5092}, {5120,5120}, {5131,5131}, {1695,1685}, {1710,1700},
+    {6202,6202}, {2827,2827}, {2839,2839}, {2360,2360}, {2368,2360}, {359,359},
+    {5678,5678}, {5142,5142}, {5151,5151}, {610,610}, {623,623}, {4264,4264},
+    {4278,4278}, {4272,4264}, {4286,4278}, {4292,4292}, {4302,4302}, {4312,4312},
+    {4322,4322}, {4332,4332}, {4342,4342}, {4352,4352}, {4362,4362}, {4372,4372},
+    {4382,4382}, {4392,4392}, {4402,4402}, {4412,4412}, {4422,4422}, {1417,1417},
+    {1427,1427}, {4863,4846}, {4884,4867}, {6271,6271}, {4070,4070}, {4100,4100},
+    {4130,4130}, {4160,4160}, {6390,6390}, {6401,6401}, {5688,5688}, {5934,5934},
+    {5697,5697}, {1685,1685}, {1700,1700}, {5798,5798}, {5785,5785}, {5386,5386},
+    {5401,5401}, {5371,5371}, {6309,6309}, {6189,6189}, {1775,1775}, {1785,1785},
+};
+
+/* offsets of the entries above sorted by port, then protocol */
+static const unsigned short  _services_by_port[] = {
+    0, 11, 20, 29, 51, 73, 90, 102, 114, 126,
+    141, 149, 157, 183, 209, 222, 230, 243, 251, 259,
+    270, 284, 303, 322, 339, 359, 377, 388, 399, 414,
+    429, 451, 473, 481, 495, 509, 520, 531, 542, 553,
+    562, 573, 584, 599, 610, 623, 631, 648, 689, 730,
+    5474, 741, 764, 782, 801, 820, 840, 5488, 5501, 860,
+    872, 884, 910, 925, 940, 955, 977, 999, 1033, 1042,
+    1056, 1079, 1087, 1095, 1106, 1117, 1135, 1153, 1168, 1183,
+    1199, 1215, 1231, 1247, 1262, 1277, 1286, 1295, 1318, 1341,
+    1354, 1367, 1382, 1397, 1407, 1417, 1427, 1437, 1468, 1499,
+    1507, 1515, 1528, 1541, 1549, 1557, 1566, 1575, 1587, 1599,
+    1610, 1621, 1633, 1645, 1656, 1667, 1676, 1685, 1700, 1715,
+    1723, 1731, 1741, 1751, 1763, 1775, 1785, 1795, 1807, 1819,
+    1835, 1851, 1865, 1879, 1903, 1927, 1941, 1955, 1964, 1973,
+    1982, 1991, 2001, 2011, 2020, 2029, 2046, 5514, 2063, 2072,
+    2081, 2092, 2325, 2334, 2350, 2360, 2373, 2387, 2398, 2418,
+    2427, 2437, 2461, 2482, 2500, 2516, 2536, 2557, 2569, 2580,
+    2591, 2606, 2617, 2634, 2649, 2103, 2112, 2664, 2692, 2708,
+    2724, 2739, 2121, 2129, 2137, 2167, 2197, 2223, 2249, 2279,
+    2309, 2317, 2754, 2764, 2774, 2783, 2792, 2801, 2810, 5190,
+    5160, 5240, 5220, 5260, 5278, 5307, 5326, 2827, 2839, 5530,
+    5543, 5560, 5575, 5585, 5602, 5444, 2851, 2861, 5343, 2871,
+    2885, 2894, 2906, 2918, 2928, 2938, 2947, 2956, 2966, 5619,
+    5631, 2976, 2986, 2996, 3007, 3018, 3028, 3062, 3078, 5352,
+    5459, 5643, 3038, 3050, 5655, 3094, 3104, 5667, 3114, 3125,
+    5678, 5688, 5697, 3136, 3161, 3186, 3199, 3212, 3225, 3238,
+    3253, 3268, 3284, 5707, 3300, 3327, 3354, 3382, 3410, 3421,
+    3432, 3445, 3458, 3469, 3480, 3504, 3528, 3544, 3559, 5719,
+    5729, 5741, 3574, 3582, 5361, 3590, 3605, 5371, 5386, 5401,
+    5415, 5427, 5434, 5750, 5759, 5772, 3620, 3635, 3650, 3660,
+    3670, 3683, 3696, 3708, 3720, 3735, 3750, 3758, 5785, 5798,
+    5808, 5817, 5828, 5838, 5847, 5858, 5870, 3766, 3775, 3784,
+    3793, 5880, 5893, 5906, 5920, 3802, 3813, 3824, 3838, 3852,
+    3862, 3872, 3880, 3888, 3899, 3910, 3919, 3928, 3947, 5934,
+    5944, 5952, 3966, 3974, 5964, 3982, 3998, 5976, 4022, 4014,
+    5991, 6007, 4030, 4038, 4046, 4058, 6023, 4070, 4100, 4130,
+    4160, 4190, 4203, 6032, 6043, 6054, 6066, 4216, 4240, 6088,
+    6078, 6107, 6098, 6116, 6125, 6134, 6145, 4264, 4278, 4292,
+    4302, 4312, 4322, 4332, 4342, 4352, 4362, 4372, 4382, 4392,
+    4402, 4412, 4422, 4432, 4449, 4466, 4483, 6155, 6180, 4500,
+    4524, 4548, 4566, 4584, 4602, 4620, 4638, 4656, 4674, 4692,
+    4708, 4724, 4740, 4756, 4769, 4782, 4798, 4814, 4830, 4846,
+    4867, 6189, 6202, 6215, 6226, 6238, 6250, 6271, 4888, 4903,
+    4918, 4932, 4946, 4960, 6282, 6309, 4974, 4985, 6318, 6330,
+    6342, 6356, 6370, 6380, 4996, 5004, 5012, 5021, 5030, 5040,
+    5050, 5066, 5082, 5092, 5102, 5111, 5120, 5131, 6390, 6401,
+    6412, 6425, 6438, 6450, 6462, 6474, 6486, 6496, 5142, 5151,
+    6506, 6516, 6524, 6532, 6546, 6556,
+};
+
@@ -35,6 +35,7 @@
 
 #include <errno.h>
 #include "arpa_nameser.h"
+#include <sys/atomics.h>
 #include <sys/system_properties.h>
 #include <net/if.h>
 #include <netdb.h>
@@ -44,6 +45,7 @@
 #include "resolv_private.h"
 #include "resolv_iface.h"
 #include "res_private.h"
+#include "private/bionic_counters.h"
 
 /* This code implements a small and *simple* DNS resolver cache.
  *
@@ -67,7 +69,9 @@
  *    (and should be solved by the later full DNS cache process).
  *
  *  - the implementation is just a (query-data) => (answer-data) hash table
- *    with a trivial least-recently-used expiration policy.
+ *    with an approximate least-recently-used expiration policy. it is split
+ *    into shards by query hash, each with its own lock, and hits only take
+ *    their shard's lock for reading.
  *
  * Doing this keeps the code simple and avoids to deal with a lot of things
  * that a full DNS cache is expected to do.
@@ -138,7 +142,8 @@
  * As such, a value of 64 should be relatively comfortable at the moment.
  *
  * The system property ro.net.dns_cache_size can be used to override the default
- * value with a custom value
+ * value with a custom value. Neither lookups, adds nor expiry scan the whole
+ * cache, so busy devices can make it much larger without slowing it down.
  *
  *
  * ******************************************
@@ -766,226 +771,74 @@ _dnsPacket_bprintQuery( DnsPacket*  packet, char*  p, char*  end )
 #endif
 
 
-/** QUERY HASHING SUPPORT
+/** QUERY KEYS
  **
  ** THE FOLLOWING CODE ASSUMES THAT THE INPUT PACKET HAS ALREADY
  ** BEEN SUCCESFULLY CHECKED.
  **/
 
+/* the key of a query holds everything that tells its answer apart from
+ * others: the RD bit, QDCOUNT and the QRs, with the letters of their names
+ * folded to lower case since names compare case-insensitively (RFC 4343).
+ * it is built once per lookup, so that hashing and comparing are plain
+ * loops over contiguous bytes instead of walks over the packets.
+ *
+ * the QRs are copied in wire format: checked queries have no compression,
+ * label lengths are below 64 and the TYPE and CLASS bytes we support are
+ * all below 'A', so folding every byte of them is safe.
+ *
+ * keys of queries that fit in a UDP datagram fit in DNS_KEY_MAX bytes.
+ */
+#define  DNS_KEY_MAX  (3 + 512 - DNS_HEADER_SIZE)
+
 /* use 32-bit FNV hash function */
 #define  FNV_MULT   16777619U
 #define  FNV_BASIS  2166136261U
 
-static unsigned
-_dnsPacket_hashBytes( DnsPacket*  packet, int  numBytes, unsigned  hash )
-{
-    const uint8_t*  p   = packet->cursor;
-    const uint8_t*  end = packet->end;
-
-    while (numBytes > 0 && p < end) {
-        hash = hash*FNV_MULT ^ *p++;
-    }
-    packet->cursor = p;
-    return hash;
-}
-
-
-static unsigned
-_dnsPacket_hashQName( DnsPacket*  packet, unsigned  hash )
+/* build the key of a checked query, whose cursor is just past its last QR,
+ * into 'key'. returns its length, or 0 if it is too long */
+static int
+_dnsPacket_makeKey( DnsPacket*  packet, uint8_t*  key )
 {
-    const uint8_t*  p   = packet->cursor;
-    const uint8_t*  end = packet->end;
-
-    for (;;) {
-        int  c;
-
-        if (p >= end) {  /* should not happen */
-            XLOG("%s: INTERNAL_ERROR: read-overflow !!\n", __FUNCTION__);
-            break;
-        }
+    const uint8_t*  p   = packet->base + DNS_HEADER_SIZE;
+    int             len = packet->cursor - p;
+    int             nn;
 
-        c = *p++;
-
-        if (c == 0)
-            break;
-
-        if (c >= 64) {
-            XLOG("%s: INTERNAL_ERROR: malformed domain !!\n", __FUNCTION__);
-            break;
-        }
-        if (p + c >= end) {
-            XLOG("%s: INTERNAL_ERROR: simple label read-overflow !!\n",
-                    __FUNCTION__);
-            break;
-        }
-        while (c > 0) {
-            hash = hash*FNV_MULT ^ *p++;
-            c   -= 1;
-        }
+    if (3 + len > DNS_KEY_MAX) {
+        XLOG("query too long for a key");
+        return 0;
     }
-    packet->cursor = p;
-    return hash;
-}
-
-static unsigned
-_dnsPacket_hashQR( DnsPacket*  packet, unsigned  hash )
-{
-    hash = _dnsPacket_hashQName(packet, hash);
-    hash = _dnsPacket_hashBytes(packet, 4, hash); /* TYPE and CLASS */
-    return hash;
-}
-
-static unsigned
-_dnsPacket_hashQuery( DnsPacket*  packet )
-{
-    unsigned  hash = FNV_BASIS;
-    int       count;
-    _dnsPacket_rewind(packet);
 
     /* we ignore the TC bit for reasons explained in
-     * _dnsPacket_checkQuery().
-     *
-     * however we hash the RD bit to differentiate
-     * between answers for recursive and non-recursive
-     * queries.
+     * _dnsPacket_checkQuery(), but keep the RD bit to
+     * differentiate between answers for recursive and
+     * non-recursive queries. other flags are 0, and so
+     * are ANCOUNT, NSCOUNT and ARCOUNT.
      */
-    hash = hash*FNV_MULT ^ (packet->base[2] & 1);
-
-    /* assume: other flags are 0 */
-    _dnsPacket_skip(packet, 4);
-
-    /* read QDCOUNT */
-    count = _dnsPacket_readInt16(packet);
+    key[0] = packet->base[2] & 1;
+    key[1] = packet->base[4];
+    key[2] = packet->base[5];
 
-    /* assume: ANcount, NScount, ARcount are 0 */
-    _dnsPacket_skip(packet, 6);
-
-    /* hash QDCOUNT QRs */
-    for ( ; count > 0; count-- )
-        hash = _dnsPacket_hashQR(packet, hash);
-
-    return hash;
-}
-
-
-/** QUERY COMPARISON
- **
- ** THE FOLLOWING CODE ASSUMES THAT THE INPUT PACKETS HAVE ALREADY
- ** BEEN SUCCESFULLY CHECKED.
- **/
+    for (nn = 0; nn < len; nn++) {
+        int  c = p[nn];
 
-static int
-_dnsPacket_isEqualDomainName( DnsPacket*  pack1, DnsPacket*  pack2 )
-{
-    const uint8_t*  p1   = pack1->cursor;
-    const uint8_t*  end1 = pack1->end;
-    const uint8_t*  p2   = pack2->cursor;
-    const uint8_t*  end2 = pack2->end;
-
-    for (;;) {
-        int  c1, c2;
-
-        if (p1 >= end1 || p2 >= end2) {
-            XLOG("%s: INTERNAL_ERROR: read-overflow !!\n", __FUNCTION__);
-            break;
-        }
-        c1 = *p1++;
-        c2 = *p2++;
-        if (c1 != c2)
-            break;
-
-        if (c1 == 0) {
-            pack1->cursor = p1;
-            pack2->cursor = p2;
-            return 1;
-        }
-        if (c1 >= 64) {
-            XLOG("%s: INTERNAL_ERROR: malformed domain !!\n", __FUNCTION__);
-            break;
-        }
-        if ((p1+c1 > end1) || (p2+c1 > end2)) {
-            XLOG("%s: INTERNAL_ERROR: simple label read-overflow !!\n",
-                    __FUNCTION__);
-            break;
-        }
-        if (memcmp(p1, p2, c1) != 0)
-            break;
-        p1 += c1;
-        p2 += c1;
-        /* we rely on the bound checks at the start of the loop */
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        key[3 + nn] = (uint8_t)c;
     }
-    /* not the same, or one is malformed */
-    XLOG("different DN");
-    return 0;
+    return 3 + len;
 }
 
-static int
-_dnsPacket_isEqualBytes( DnsPacket*  pack1, DnsPacket*  pack2, int  numBytes )
-{
-    const uint8_t*  p1 = pack1->cursor;
-    const uint8_t*  p2 = pack2->cursor;
-
-    if ( p1 + numBytes > pack1->end || p2 + numBytes > pack2->end )
-        return 0;
-
-    if ( memcmp(p1, p2, numBytes) != 0 )
-        return 0;
-
-    pack1->cursor += numBytes;
-    pack2->cursor += numBytes;
-    return 1;
-}
-
-static int
-_dnsPacket_isEqualQR( DnsPacket*  pack1, DnsPacket*  pack2 )
-{
-    /* compare domain name encoding + TYPE + CLASS */
-    if ( !_dnsPacket_isEqualDomainName(pack1, pack2) ||
-         !_dnsPacket_isEqualBytes(pack1, pack2, 2+2) )
-        return 0;
-
-    return 1;
-}
-
-static int
-_dnsPacket_isEqualQuery( DnsPacket*  pack1, DnsPacket*  pack2 )
+static unsigned
+_dnsKey_hash( const uint8_t*  key, int  keylen )
 {
-    int  count1, count2;
-
-    /* compare the headers, ignore most fields */
-    _dnsPacket_rewind(pack1);
-    _dnsPacket_rewind(pack2);
+    const uint8_t*  end  = key + keylen;
+    unsigned        hash = FNV_BASIS;
 
-    /* compare RD, ignore TC, see comment in _dnsPacket_checkQuery */
-    if ((pack1->base[2] & 1) != (pack2->base[2] & 1)) {
-        XLOG("different RD");
-        return 0;
-    }
+    while (key < end)
+        hash = hash*FNV_MULT ^ *key++;
 
-    /* assume: other flags are all 0 */
-    _dnsPacket_skip(pack1, 4);
-    _dnsPacket_skip(pack2, 4);
-
-    /* compare QDCOUNT */
-    count1 = _dnsPacket_readInt16(pack1);
-    count2 = _dnsPacket_readInt16(pack2);
-    if (count1 != count2 || count1 < 0) {
-        XLOG("different QDCOUNT");
-        return 0;
-    }
-
-    /* assume: ANcount, NScount and ARcount are all 0 */
-    _dnsPacket_skip(pack1, 6);
-    _dnsPacket_skip(pack2, 6);
-
-    /* compare the QDCOUNT QRs */
-    for ( ; count1 > 0; count1-- ) {
-        if (!_dnsPacket_isEqualQR(pack1, pack2)) {
-            XLOG("different QR");
-            return 0;
-        }
-    }
-    return 1;
+    return hash;
 }
 
 /****************************************************************************/
@@ -999,14 +852,27 @@ _dnsPacket_isEqualQuery( DnsPacket*  pack1, DnsPacket*  pack2 )
 /* cache entry. for simplicity, 'hash' and 'hlink' are inlined in this
  * structure though they are conceptually part of the hash table.
  *
- * similarly, mru_next and mru_prev are part of the global MRU list
+ * similarly, ring_next and ring_prev are part of the shard's eviction ring,
+ * which the clock hand sweeps (see _cache_evict_one). 'referenced' is set by
+ * every hit and cleared by the hand, so that hits never need to relink
+ * anything and can run under a read lock.
+ *
+ * wheel_next and wheel_pprev link the entry into the slot of the shard's
+ * expiry wheel that 'expires' falls into (see _cache_expire).
+ *
+ * 'key' is what lookups hash and compare, 'query' is only kept for dumps.
  */
 typedef struct Entry {
     unsigned int     hash;   /* hash value */
     struct Entry*    hlink;  /* next in collision chain */
-    struct Entry*    mru_prev;
-    struct Entry*    mru_next;
-
+    struct Entry*    ring_prev;
+    struct Entry*    ring_next;
+    int              referenced;
+    struct Entry*    wheel_next;
+    struct Entry**   wheel_pprev;
+
+    const uint8_t*   key;    /* see _dnsPacket_makeKey */
+    int              keylen;
     const uint8_t*   query;
     int              querylen;
     const uint8_t*   answer;
@@ -1122,39 +988,49 @@ entry_free( Entry*  e )
 }
 
 static __inline__ void
-entry_mru_remove( Entry*  e )
+entry_wheel_add( Entry*  e, Entry**  slot )
 {
-    e->mru_prev->mru_next = e->mru_next;
-    e->mru_next->mru_prev = e->mru_prev;
+    e->wheel_next  = *slot;
+    e->wheel_pprev = slot;
+    if (*slot != NULL)
+        (*slot)->wheel_pprev = &e->wheel_next;
+    *slot = e;
 }
 
 static __inline__ void
-entry_mru_add( Entry*  e, Entry*  list )
+entry_wheel_remove( Entry*  e )
 {
-    Entry*  first = list->mru_next;
-
-    e->mru_next = first;
-    e->mru_prev = list;
+    *e->wheel_pprev = e->wheel_next;
+    if (e->wheel_next != NULL)
+        e->wheel_next->wheel_pprev = e->wheel_pprev;
+}
 
-    list->mru_next  = e;
-    first->mru_prev = e;
+static __inline__ void
+entry_ring_remove( Entry*  e )
+{
+    e->ring_prev->ring_next = e->ring_next;
+    e->ring_next->ring_prev = e->ring_prev;
 }
 
-/* compute the hash of a given entry, this is a hash of most
- * data in the query (key) */
-static unsigned
-entry_hash( const Entry*  e )
+/* insert 'e' at the tail of the ring whose sentinel is 'ring', i.e. as far
+ * from the clock hand's next stop as possible */
+static __inline__ void
+entry_ring_add( Entry*  e, Entry*  ring )
 {
-    DnsPacket  pack[1];
+    Entry*  last = ring->ring_prev;
+
+    e->ring_prev = last;
+    e->ring_next = ring;
 
-    _dnsPacket_init(pack, e->query, e->querylen);
-    return _dnsPacket_hashQuery(pack);
+    ring->ring_prev = e;
+    last->ring_next = e;
 }
 
 /* initialize an Entry as a search key, this also checks the input query packet
+ * and builds its key into 'keybuf', which must hold DNS_KEY_MAX bytes.
  * returns 1 on success, or 0 in case of unsupported/malformed data */
 static int
-entry_init_key( Entry*  e, const void*  query, int  querylen )
+entry_init_key( Entry*  e, uint8_t*  keybuf, const void*  query, int  querylen )
 {
     DnsPacket  pack[1];
 
@@ -1162,11 +1038,19 @@ entry_init_key( Entry*  e, const void*  query, int  querylen )
 
     e->query    = query;
     e->querylen = querylen;
-    e->hash     = entry_hash(e);
 
     _dnsPacket_init(pack, query, querylen);
 
-    return _dnsPacket_checkQuery(pack);
+    if (!_dnsPacket_checkQuery(pack))
+        return 0;
+
+    e->key    = keybuf;
+    e->keylen = _dnsPacket_makeKey(pack, keybuf);
+    if (e->keylen == 0)
+        return 0;
+
+    e->hash   = _dnsKey_hash(e->key, e->keylen);
+    return 1;
 }
 
 /* allocate a new entry as a cache node */
@@ -1176,13 +1060,18 @@ entry_alloc( const Entry*  init, const void*  answer, int  answerlen )
     Entry*  e;
     int     size;
 
-    size = sizeof(*e) + init->querylen + answerlen;
+    size = sizeof(*e) + init->keylen + init->querylen + answerlen;
     e    = calloc(size, 1);
     if (e == NULL)
         return e;
 
     e->hash     = init->hash;
-    e->query    = (const uint8_t*)(e+1);
+    e->key      = (const uint8_t*)(e+1);
+    e->keylen   = init->keylen;
+
+    memcpy( (char*)e->key, init->key, e->keylen );
+
+    e->query    = e->key + e->keylen;
     e->querylen = init->querylen;
 
     memcpy( (char*)e->query, init->query, e->querylen );
@@ -1198,15 +1087,8 @@ entry_alloc( const Entry*  init, const void*  answer, int  answerlen )
 static int
 entry_equals( const Entry*  e1, const Entry*  e2 )
 {
-    DnsPacket  pack1[1], pack2[1];
-
-    if (e1->querylen != e2->querylen) {
-        return 0;
-    }
-    _dnsPacket_init(pack1, e1->query, e1->querylen);
-    _dnsPacket_init(pack2, e2->query, e2->querylen);
-
-    return _dnsPacket_isEqualQuery(pack1, pack2);
+    return e1->keylen == e2->keylen &&
+           memcmp(e1->key, e2->key, e1->keylen) == 0;
 }
 
 /****************************************************************************/
@@ -1220,26 +1102,67 @@ entry_equals( const Entry*  e1, const Entry*  e2 )
 /* We use a simple hash table with external collision lists
  * for simplicity, the hash-table fields 'hash' and 'hlink' are
  * inlined in the Entry structure.
+ *
+ * The table is split into CACHE_SHARDS independent shards, chosen by query
+ * hash, so that lookups of different names rarely touch the same lock, and
+ * each shard holds its share of the cache's entries.
  */
 
 /* Maximum time for a thread to wait for an pending request */
 #define PENDING_REQUEST_TIMEOUT 20;
 
+/* number of shards per cache, a power of 2 */
+#define CACHE_SHARDS  8
+
+/* Expired entries are found with a hashed timing wheel rather than by
+ * scanning the whole cache: an entry expiring at time T sits in slot
+ * T % CACHE_WHEEL_SLOTS, and every add first walks the slots of the seconds
+ * that went by since the previous one. Each walk only looks at entries that
+ * are due, or that are due a multiple of CACHE_WHEEL_SLOTS seconds later, so
+ * the cost of expiry doesn't depend on the size of the cache.
+ */
+#define CACHE_WHEEL_SLOTS  256
+
 typedef struct pending_req_info {
     unsigned int                hash;
     pthread_cond_t              cond;
     struct pending_req_info*    next;
 } PendingReqInfo;
 
-typedef struct resolv_cache {
+typedef struct cache_shard {
+    /* taken for reading by hits, and for writing by anything that changes
+     * the table or the ring */
+    pthread_rwlock_t lock;
     int              max_entries;
     int              num_entries;
-    Entry            mru_list;
-    pthread_mutex_t  lock;
-    unsigned         generation;
     int              last_id;
-    Entry*           entries;
+    Entry**          entries;       /* max_entries buckets */
+    Entry            ring;          /* sentinel of the eviction ring */
+    Entry*           hand;          /* the clock hand, or &ring */
+    Entry*           wheel[CACHE_WHEEL_SLOTS];
+    time_t           wheel_time;    /* last second the wheel was turned to */
+    /* protects pending_requests, and is taken before 'lock' when both are */
+    pthread_mutex_t  pending_lock;
     PendingReqInfo   pending_requests;
+
+    /* counters reported by _resolv_get_cache_stats_for_iface(). hits and
+     * misses are incremented atomically by concurrent readers, coalesced
+     * and pending_timeouts under pending_lock, the others under 'lock'
+     * for writing */
+    volatile int     hits;
+    volatile int     negative_hits;
+    volatile int     misses;
+    int              coalesced;
+    int              pending_timeouts;
+    int              evictions;
+    int              expirations;
+} CacheShard;
+
+typedef struct resolv_cache {
+    int              max_entries;
+    pthread_mutex_t  lock;          /* protects 'generation' */
+    unsigned         generation;
+    CacheShard       shards[CACHE_SHARDS];
 } Cache;
 
 typedef struct resolv_cache_info {
@@ -1267,8 +1190,15 @@ typedef struct resolv_uidiface_info {
 
 #define  HTABLE_VALID(x)  ((x) != NULL && (x) != HTABLE_DELETED)
 
+static __inline__ CacheShard*
+_cache_shard( Cache*  cache, const Entry*  key )
+{
+    /* the low bits pick the bucket within the shard */
+    return &cache->shards[(key->hash >> 24) & (CACHE_SHARDS - 1)];
+}
+
 static void
-_cache_flush_pending_requests_locked( struct resolv_cache* cache )
+_cache_flush_pending_requests_locked( CacheShard* cache )
 {
     struct pending_req_info *ri, *tmp;
     if (cache) {
@@ -1289,9 +1219,9 @@ _cache_flush_pending_requests_locked( struct resolv_cache* cache )
 
 /* return 0 if no pending request is found matching the key
  * if a matching request is found the calling thread will wait
- * and return 1 when released */
+ * and return 1 when released. must be called with cache->pending_lock held */
 static int
-_cache_check_pending_request_locked( struct resolv_cache* cache, Entry* key )
+_cache_check_pending_request_locked( CacheShard* cache, Entry* key )
 {
     struct pending_req_info *ri, *prev;
     int exist = 0;
@@ -1319,7 +1249,9 @@ _cache_check_pending_request_locked( struct resolv_cache* cache, Entry* key )
             struct timespec ts = {0,0};
             XLOG("Waiting for previous request");
             ts.tv_sec = _time_now() + PENDING_REQUEST_TIMEOUT;
-            pthread_cond_timedwait(&ri->cond, &cache->lock, &ts);
+            cache->coalesced += 1;
+            if (pthread_cond_timedwait(&ri->cond, &cache->pending_lock, &ts) == ETIMEDOUT)
+                cache->pending_timeouts += 1;
         }
     }
 
@@ -1329,7 +1261,7 @@ _cache_check_pending_request_locked( struct resolv_cache* cache, Entry* key )
 /* notify any waiting thread that waiting on a request
  * matching the key has been added to the cache */
 static void
-_cache_notify_waiting_tid_locked( struct resolv_cache* cache, Entry* key )
+_cache_notify_waiting_tid_locked( CacheShard* cache, Entry* key )
 {
     struct pending_req_info *ri, *prev;
 
@@ -1361,22 +1293,28 @@ _resolv_cache_query_failed( struct resolv_cache* cache,
                    int         querylen)
 {
     Entry    key[1];
+    uint8_t  keybuf[DNS_KEY_MAX];
+
+    if (cache && entry_init_key(key, keybuf, query, querylen)) {
+        CacheShard*  shard = _cache_shard(cache, key);
 
-    if (cache && entry_init_key(key, query, querylen)) {
-        pthread_mutex_lock(&cache->lock);
-        _cache_notify_waiting_tid_locked(cache, key);
-        pthread_mutex_unlock(&cache->lock);
+        pthread_mutex_lock(&shard->pending_lock);
+        _cache_notify_waiting_tid_locked(shard, key);
+        pthread_mutex_unlock(&shard->pending_lock);
     }
 }
 
 static void
-_cache_flush_locked( Cache*  cache )
+_cache_shard_flush( CacheShard*  cache )
 {
     int     nn;
 
+    pthread_mutex_lock(&cache->pending_lock);
+    pthread_rwlock_wrlock(&cache->lock);
+
     for (nn = 0; nn < cache->max_entries; nn++)
     {
-        Entry**  pnode = (Entry**) &cache->entries[nn];
+        Entry**  pnode = &cache->entries[nn];
 
         while (*pnode != NULL) {
             Entry*  node = *pnode;
@@ -1388,10 +1326,25 @@ _cache_flush_locked( Cache*  cache )
     // flush pending request
     _cache_flush_pending_requests_locked(cache);
 
-    cache->mru_list.mru_next = cache->mru_list.mru_prev = &cache->mru_list;
+    cache->ring.ring_next = cache->ring.ring_prev = &cache->ring;
+    cache->hand              = &cache->ring;
+    memset(cache->wheel, 0, sizeof(cache->wheel));
     cache->num_entries       = 0;
     cache->last_id           = 0;
 
+    pthread_rwlock_unlock(&cache->lock);
+    pthread_mutex_unlock(&cache->pending_lock);
+}
+
+static void
+_cache_flush( Cache*  cache )
+{
+    int  nn;
+
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        _cache_shard_flush(&cache->shards[nn]);
+    }
+
     XLOG("*************************\n"
          "*** DNS CACHE FLUSHED ***\n"
          "*************************");
@@ -1430,25 +1383,50 @@ _res_cache_get_max_entries( void )
     return result;
 }
 
+static void
+_resolv_cache_free( struct resolv_cache*  cache )
+{
+    int  nn;
+
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        free(cache->shards[nn].entries);
+    }
+    free(cache);
+}
+
 static struct resolv_cache*
 _resolv_cache_create( void )
 {
     struct resolv_cache*  cache;
+    int                   nn, shard_entries;
 
     cache = calloc(sizeof(*cache), 1);
-    if (cache) {
-        cache->max_entries = _res_cache_get_max_entries();
-        cache->entries = calloc(sizeof(*cache->entries), cache->max_entries);
-        if (cache->entries) {
-            cache->generation = ~0U;
-            pthread_mutex_init( &cache->lock, NULL );
-            cache->mru_list.mru_prev = cache->mru_list.mru_next = &cache->mru_list;
-            XLOG("%s: cache created\n", __FUNCTION__);
-        } else {
-            free(cache);
-            cache = NULL;
+    if (cache == NULL)
+        return NULL;
+
+    cache->max_entries = _res_cache_get_max_entries();
+    cache->generation = ~0U;
+    pthread_mutex_init( &cache->lock, NULL );
+
+    /* round up, so that small caches still get at least one entry per shard
+     * (a cache of size 0 is off, and stays that way) */
+    shard_entries = (cache->max_entries + CACHE_SHARDS - 1) / CACHE_SHARDS;
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        CacheShard*  shard = &cache->shards[nn];
+
+        shard->max_entries = shard_entries;
+        shard->entries = calloc(sizeof(*shard->entries), shard_entries ? shard_entries : 1);
+        if (shard->entries == NULL) {
+            _resolv_cache_free(cache);
+            return NULL;
         }
+        pthread_rwlock_init( &shard->lock, NULL );
+        pthread_mutex_init( &shard->pending_lock, NULL );
+        shard->ring.ring_prev = shard->ring.ring_next = &shard->ring;
+        shard->hand = &shard->ring;
+        shard->wheel_time = _time_now();
     }
+    XLOG("%s: cache created\n", __FUNCTION__);
     return cache;
 }
 
@@ -1466,14 +1444,15 @@ _dump_query( const uint8_t*  query, int  querylen )
 }
 
 static void
-_cache_dump_mru( Cache*  cache )
+_cache_dump_ring( CacheShard*  cache )
 {
     char    temp[512], *p=temp, *end=p+sizeof(temp);
     Entry*  e;
 
-    p = _bprint(temp, end, "MRU LIST (%2d): ", cache->num_entries);
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list; e = e->mru_next)
-        p = _bprint(p, end, " %d", e->id);
+    p = _bprint(temp, end, "RING (%2d): ", cache->num_entries);
+    for (e = cache->ring.ring_next; e != &cache->ring; e = e->ring_next)
+        p = _bprint(p, end, " %d%s%s", e->id, e->referenced ? "*" : "",
+                    e == cache->hand ? "<" : "");
 
     XLOG("%s", temp);
 }
@@ -1536,11 +1515,11 @@ _dump_answer(const void* answer, int answerlen)
  * table.
  */
 static Entry**
-_cache_lookup_p( Cache*   cache,
-                 Entry*   key )
+_cache_lookup_p( CacheShard*  cache,
+                 Entry*       key )
 {
     int      index = key->hash % cache->max_entries;
-    Entry**  pnode = (Entry**) &cache->entries[ index ];
+    Entry**  pnode = &cache->entries[ index ];
 
     while (*pnode != NULL) {
         Entry*  node = *pnode;
@@ -1559,16 +1538,17 @@ _cache_lookup_p( Cache*   cache,
 /* Add a new entry to the hash table. 'lookup' must be the
  * result of an immediate previous failed _lookup_p() call
  * (i.e. with *lookup == NULL), and 'e' is the pointer to the
- * newly created entry
+ * newly created entry, whose 'expires' must be set
  */
 static void
-_cache_add_p( Cache*   cache,
-              Entry**  lookup,
-              Entry*   e )
+_cache_add_p( CacheShard*  cache,
+              Entry**      lookup,
+              Entry*       e )
 {
     *lookup = e;
     e->id = ++cache->last_id;
-    entry_mru_add(e, &cache->mru_list);
+    entry_ring_add(e, &cache->ring);
+    entry_wheel_add(e, &cache->wheel[(unsigned long)e->expires % CACHE_WHEEL_SLOTS]);
     cache->num_entries += 1;
 
     XLOG("%s: entry %d added (count=%d)", __FUNCTION__,
@@ -1580,59 +1560,169 @@ _cache_add_p( Cache*   cache,
  * and succesful _lookup_p() call.
  */
 static void
-_cache_remove_p( Cache*   cache,
-                 Entry**  lookup )
+_cache_remove_p( CacheShard*  cache,
+                 Entry**      lookup )
 {
     Entry*  e  = *lookup;
 
     XLOG("%s: entry %d removed (count=%d)", __FUNCTION__,
          e->id, cache->num_entries-1);
 
-    entry_mru_remove(e);
+    if (cache->hand == e)
+        cache->hand = e->ring_next;
+    entry_ring_remove(e);
+    entry_wheel_remove(e);
     *lookup = e->hlink;
     entry_free(e);
     cache->num_entries -= 1;
 }
 
-/* Remove the oldest entry from the hash table.
+/* Remove one entry that hasn't been used lately: the clock hand sweeps the
+ * ring, giving each entry that was hit since the last sweep a second chance.
+ * As hits only set a flag, this approximates least-recently-used without
+ * writes on the lookup path. At worst the hand goes round twice.
  */
 static void
-_cache_remove_oldest( Cache*  cache )
+_cache_evict_one( CacheShard*  cache )
 {
-    Entry*   oldest = cache->mru_list.mru_prev;
-    Entry**  lookup = _cache_lookup_p(cache, oldest);
+    Entry*   victim;
+    Entry**  lookup;
+
+    if (cache->num_entries == 0)
+        return;
 
+    for (;;) {
+        if (cache->hand == &cache->ring)
+            cache->hand = cache->ring.ring_next;
+        victim = cache->hand;
+        if (!victim->referenced)
+            break;
+        victim->referenced = 0;
+        cache->hand = victim->ring_next;
+    }
+
+    lookup = _cache_lookup_p(cache, victim);
     if (*lookup == NULL) { /* should not happen */
-        XLOG("%s: OLDEST NOT IN HTABLE ?", __FUNCTION__);
+        XLOG("%s: VICTIM NOT IN HTABLE ?", __FUNCTION__);
         return;
     }
     if (DEBUG) {
-        XLOG("Cache full - removing oldest");
-        XLOG_QUERY(oldest->query, oldest->querylen);
+        XLOG("Cache full - evicting entry %d", victim->id);
+        XLOG_QUERY(victim->query, victim->querylen);
     }
     _cache_remove_p(cache, lookup);
+    cache->evictions += 1;
 }
 
-/* Remove all expired entries from the hash table.
+/* Remove the entries that expired since the wheel was last turned, by
+ * walking the slots of the seconds in between. Entries in those slots that
+ * are due in a later round of the wheel are left alone. If the clock went
+ * backwards there's nothing to do, and if it jumped forward by more than a
+ * round every slot is walked just once.
  */
-static void _cache_remove_expired(Cache* cache) {
-    Entry* e;
-    time_t now = _time_now();
-
-    for (e = cache->mru_list.mru_next; e != &cache->mru_list;) {
-        // Entry is old, remove
-        if (now >= e->expires) {
-            Entry** lookup = _cache_lookup_p(cache, e);
-            if (*lookup == NULL) { /* should not happen */
-                XLOG("%s: ENTRY NOT IN HTABLE ?", __FUNCTION__);
-                return;
+static void
+_cache_expire( CacheShard*  cache )
+{
+    time_t  now = _time_now();
+    time_t  t;
+
+    if (now <= cache->wheel_time) {
+        cache->wheel_time = now;
+        return;
+    }
+    t = cache->wheel_time + 1;
+    if (now - cache->wheel_time > CACHE_WHEEL_SLOTS)
+        t = now - CACHE_WHEEL_SLOTS + 1;
+
+    for ( ; t <= now; t++) {
+        Entry*  e = cache->wheel[(unsigned long)t % CACHE_WHEEL_SLOTS];
+
+        while (e != NULL) {
+            Entry*  next = e->wheel_next;
+
+            if (now >= e->expires) {
+                Entry**  lookup = _cache_lookup_p(cache, e);
+                if (*lookup == NULL) { /* should not happen */
+                    XLOG("%s: ENTRY NOT IN HTABLE ?", __FUNCTION__);
+                } else {
+                    _cache_remove_p(cache, lookup);
+                    cache->expirations += 1;
+                }
             }
-            e = e->mru_next;
-            _cache_remove_p(cache, lookup);
-        } else {
-            e = e->mru_next;
+            e = next;
         }
     }
+    cache->wheel_time = now;
+}
+
+/* Copy the answer for 'key' out of the shard, which must be locked (for
+ * reading at least). Sets '*stale' if the entry has expired and needs to be
+ * removed, which takes the write lock.
+ */
+static ResolvCacheStatus
+_cache_read_locked( CacheShard*  cache,
+                    Entry*       key,
+                    void*        answer,
+                    int          answersize,
+                    int         *answerlen,
+                    int         *stale )
+{
+    Entry*  e;
+
+    if (cache->max_entries == 0)
+        return RESOLV_CACHE_NOTFOUND;
+
+    e = *_cache_lookup_p(cache, key);
+    if (e == NULL) {
+        XLOG( "NOT IN CACHE");
+        return RESOLV_CACHE_NOTFOUND;
+    }
+
+    if (_time_now() >= e->expires) {
+        XLOG( " NOT IN CACHE (STALE ENTRY %p)", e );
+        XLOG_QUERY(e->query, e->querylen);
+        *stale = 1;
+        return RESOLV_CACHE_NOTFOUND;
+    }
+
+    *answerlen = e->answerlen;
+    if (e->answerlen > answersize) {
+        /* NOTE: we return UNSUPPORTED if the answer buffer is too short */
+        XLOG(" ANSWER TOO LONG");
+        return RESOLV_CACHE_UNSUPPORTED;
+    }
+
+    memcpy( answer, e->answer, e->answerlen );
+
+    /* concurrent readers can only store the same value, and the clock hand
+     * clears it under the write lock. testing first keeps hot entries'
+     * cache lines clean */
+    if (!e->referenced)
+        e->referenced = 1;
+
+    __atomic_inc(&cache->hits);
+    __libc_counter_add(ANDROID_LIBC_COUNTER_DNS_CACHE_HITS, 1);
+    /* a negative answer has an empty answer section (ANCOUNT is at 6) */
+    if (e->answerlen >= DNS_HEADER_SIZE && e->answer[6] == 0 && e->answer[7] == 0)
+        __atomic_inc(&cache->negative_hits);
+
+    XLOG( "FOUND IN CACHE entry=%p", e );
+    return RESOLV_CACHE_FOUND;
+}
+
+/* Remove the entry for 'key' if it has expired. */
+static void
+_cache_remove_stale( CacheShard*  cache, Entry*  key )
+{
+    Entry**  lookup;
+
+    pthread_rwlock_wrlock( &cache->lock );
+    lookup = _cache_lookup_p(cache, key);
+    if (*lookup != NULL && _time_now() >= (*lookup)->expires) {
+        _cache_remove_p(cache, lookup);
+        cache->expirations += 1;
+    }
+    pthread_rwlock_unlock( &cache->lock );
 }
 
 ResolvCacheStatus
@@ -1643,76 +1733,55 @@ _resolv_cache_lookup( struct resolv_cache*  cache,
                       int                   answersize,
                       int                  *answerlen )
 {
-    Entry      key[1];
-    Entry**    lookup;
-    Entry*     e;
-    time_t     now;
+    Entry        key[1];
+    uint8_t      keybuf[DNS_KEY_MAX];
+    CacheShard*  shard;
+    int          stale = 0;
 
-    ResolvCacheStatus  result = RESOLV_CACHE_NOTFOUND;
+    ResolvCacheStatus  result;
 
     XLOG("%s: lookup", __FUNCTION__);
     XLOG_QUERY(query, querylen);
 
     /* we don't cache malformed queries */
-    if (!entry_init_key(key, query, querylen)) {
+    if (!entry_init_key(key, keybuf, query, querylen)) {
         XLOG("%s: unsupported query", __FUNCTION__);
         return RESOLV_CACHE_UNSUPPORTED;
     }
-    /* lookup cache */
-    pthread_mutex_lock( &cache->lock );
+    shard = _cache_shard(cache, key);
 
-    /* see the description of _lookup_p to understand this.
-     * the function always return a non-NULL pointer.
-     */
-    lookup = _cache_lookup_p(cache, key);
-    e      = *lookup;
+    /* the fast path: a hit only needs the read lock */
+    pthread_rwlock_rdlock( &shard->lock );
+    result = _cache_read_locked(shard, key, answer, answersize, answerlen, &stale);
+    pthread_rwlock_unlock( &shard->lock );
+    if (result != RESOLV_CACHE_NOTFOUND)
+        return result;
 
-    if (e == NULL) {
-        XLOG( "NOT IN CACHE");
-        // calling thread will wait if an outstanding request is found
-        // that matching this query
-        if (!_cache_check_pending_request_locked(cache, key)) {
-            goto Exit;
-        } else {
-            lookup = _cache_lookup_p(cache, key);
-            e = *lookup;
-            if (e == NULL) {
-                goto Exit;
-            }
-        }
-    }
+    if (stale)
+        _cache_remove_stale(shard, key);
 
-    now = _time_now();
+    /* look again with the pending list locked, so that either we see the
+     * answer of a query that completed meanwhile, or its _resolv_cache_add
+     * sees us waiting for it. */
+    pthread_mutex_lock( &shard->pending_lock );
+    pthread_rwlock_rdlock( &shard->lock );
+    result = _cache_read_locked(shard, key, answer, answersize, answerlen, &stale);
+    pthread_rwlock_unlock( &shard->lock );
 
-    /* remove stale entries here */
-    if (now >= e->expires) {
-        XLOG( " NOT IN CACHE (STALE ENTRY %p DISCARDED)", *lookup );
-        XLOG_QUERY(e->query, e->querylen);
-        _cache_remove_p(cache, lookup);
-        goto Exit;
+    // calling thread will wait if an outstanding request is found
+    // that matching this query
+    if (result == RESOLV_CACHE_NOTFOUND &&
+            _cache_check_pending_request_locked(shard, key)) {
+        pthread_rwlock_rdlock( &shard->lock );
+        result = _cache_read_locked(shard, key, answer, answersize, answerlen, &stale);
+        pthread_rwlock_unlock( &shard->lock );
     }
+    pthread_mutex_unlock( &shard->pending_lock );
 
-    *answerlen = e->answerlen;
-    if (e->answerlen > answersize) {
-        /* NOTE: we return UNSUPPORTED if the answer buffer is too short */
-        result = RESOLV_CACHE_UNSUPPORTED;
-        XLOG(" ANSWER TOO LONG");
-        goto Exit;
+    if (result == RESOLV_CACHE_NOTFOUND) {
+        __atomic_inc(&shard->misses);
+        __libc_counter_add(ANDROID_LIBC_COUNTER_DNS_CACHE_MISSES, 1);
     }
-
-    memcpy( answer, e->answer, e->answerlen );
-
-    /* bump up this entry to the top of the MRU list */
-    if (e != cache->mru_list.mru_next) {
-        entry_mru_remove( e );
-        entry_mru_add( e, &cache->mru_list );
-    }
-
-    XLOG( "FOUND IN CACHE entry=%p", e );
-    result = RESOLV_CACHE_FOUND;
-
-Exit:
-    pthread_mutex_unlock( &cache->lock );
     return result;
 }
 
@@ -1724,19 +1793,20 @@ _resolv_cache_add( struct resolv_cache*  cache,
                    const void*           answer,
                    int                   answerlen )
 {
-    Entry    key[1];
-    Entry*   e;
-    Entry**  lookup;
-    u_long   ttl;
+    Entry        key[1];
+    uint8_t      keybuf[DNS_KEY_MAX];
+    Entry*       e;
+    Entry**      lookup;
+    CacheShard*  shard;
+    u_long       ttl;
 
     /* don't assume that the query has already been cached
      */
-    if (!entry_init_key( key, query, querylen )) {
+    if (!entry_init_key( key, keybuf, query, querylen )) {
         XLOG( "%s: passed invalid query ?", __FUNCTION__);
         return;
     }
-
-    pthread_mutex_lock( &cache->lock );
+    shard = _cache_shard(cache, key);
 
     XLOG( "%s: query:", __FUNCTION__ );
     XLOG_QUERY(query,querylen);
@@ -1746,44 +1816,52 @@ _resolv_cache_add( struct resolv_cache*  cache,
     XLOG_BYTES(answer,answerlen);
 #endif
 
-    lookup = _cache_lookup_p(cache, key);
+    /* parse the answer before taking the lock */
+    ttl = answer_getTTL(answer, answerlen);
+
+    pthread_rwlock_wrlock( &shard->lock );
+
+    if (ttl == 0 || shard->max_entries == 0)
+        goto Exit;
+
+    _cache_expire(shard);
+
+    lookup = _cache_lookup_p(shard, key);
     e      = *lookup;
 
+    if (e != NULL && _time_now() >= e->expires) {
+        /* a lookup saw it go stale, but raced with another thread */
+        _cache_remove_p(shard, lookup);
+        shard->expirations += 1;
+        lookup = _cache_lookup_p(shard, key);
+        e      = *lookup;
+    }
     if (e != NULL) { /* should not happen */
         XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
              __FUNCTION__, e);
         goto Exit;
     }
 
-    if (cache->num_entries >= cache->max_entries) {
-        _cache_remove_expired(cache);
-        if (cache->num_entries >= cache->max_entries) {
-            _cache_remove_oldest(cache);
-        }
+    if (shard->num_entries >= shard->max_entries) {
+        _cache_evict_one(shard);
         /* need to lookup again */
-        lookup = _cache_lookup_p(cache, key);
-        e      = *lookup;
-        if (e != NULL) {
-            XLOG("%s: ALREADY IN CACHE (%p) ? IGNORING ADD",
-                __FUNCTION__, e);
-            goto Exit;
-        }
+        lookup = _cache_lookup_p(shard, key);
     }
 
-    ttl = answer_getTTL(answer, answerlen);
-    if (ttl > 0) {
-        e = entry_alloc(key, answer, answerlen);
-        if (e != NULL) {
-            e->expires = ttl + _time_now();
-            _cache_add_p(cache, lookup, e);
-        }
+    e = entry_alloc(key, answer, answerlen);
+    if (e != NULL) {
+        e->expires = ttl + _time_now();
+        _cache_add_p(shard, lookup, e);
     }
 #if DEBUG
-    _cache_dump_mru(cache);
+    _cache_dump_ring(shard);
 #endif
 Exit:
-    _cache_notify_waiting_tid_locked(cache, key);
-    pthread_mutex_unlock( &cache->lock );
+    pthread_rwlock_unlock( &shard->lock );
+
+    pthread_mutex_lock( &shard->pending_lock );
+    _cache_notify_waiting_tid_locked(shard, key);
+    pthread_mutex_unlock( &shard->pending_lock );
 }
 
 /****************************************************************************/
@@ -1817,6 +1895,11 @@ static pthread_mutex_t _res_pidiface_list_lock;
 // lock protecting the _res_uidiface_list
 static pthread_mutex_t _res_uidiface_list_lock;
 
+// bumped under _res_cache_list_lock whenever an interface gets a cache or new
+// nameservers, or the default interface changes: all that the bindings of
+// res_states to interfaces depend on (see _resolv_get_cache_for_res). never 0.
+static volatile int    _res_cache_generation = 1;
+
 /* lookup the default interface name */
 static char *_get_default_iface_locked();
 /* find the first cache that has an associated interface and return the name of the interface */
@@ -1877,14 +1960,35 @@ _res_cache_init(void)
     pthread_mutex_init(&_res_uidiface_list_lock, NULL);
 }
 
-struct resolv_cache*
-__get_res_cache(const char* ifname)
+static void
+_res_cache_bump_generation_locked(void)
 {
-    struct resolv_cache *cache;
+    if (++_res_cache_generation == 0)
+        _res_cache_generation = 1;
+}
 
-    pthread_once(&_res_cache_once, _res_cache_init);
-    pthread_mutex_lock(&_res_cache_list_lock);
+static __inline__ int
+_res_binding_matches(const struct __res_iface_binding* binding, const char* iface)
+{
+    /* a binding looked up for "" also stands for the interface that gave */
+    return binding->generation == _res_cache_generation &&
+           (strcmp(iface, binding->ifreq) == 0 || strcmp(iface, binding->iface) == 0);
+}
 
+static void
+_res_binding_set(struct __res_iface_binding* binding, int generation,
+        const char* ifreq, const char* iface, struct resolv_cache* cache)
+{
+    binding->generation = generation;
+    strlcpy(binding->ifreq, ifreq, sizeof(binding->ifreq));
+    strlcpy(binding->iface, iface, sizeof(binding->iface));
+    binding->cache = cache;
+}
+
+/* the body of __get_res_cache(), also returns the name of the interface in '*iface' */
+static struct resolv_cache*
+_get_res_cache_locked(const char* ifname, const char** iface_out)
+{
     char* iface;
     if (ifname == NULL || ifname[0] == '\0') {
         iface = _get_default_iface_locked();
@@ -1898,13 +2002,52 @@ __get_res_cache(const char* ifname)
         iface = (char *) ifname;
     }
 
-    cache = _get_res_cache_for_iface_locked(iface);
+    *iface_out = iface;
+    return _get_res_cache_for_iface_locked(iface);
+}
+
+struct resolv_cache*
+__get_res_cache(const char* ifname)
+{
+    struct resolv_cache *cache;
+    const char* iface;
+
+    pthread_once(&_res_cache_once, _res_cache_init);
+    pthread_mutex_lock(&_res_cache_list_lock);
+
+    cache = _get_res_cache_locked(ifname, &iface);
 
     pthread_mutex_unlock(&_res_cache_list_lock);
     XLOG("_get_res_cache: iface = %s, cache=%p\n", iface, cache);
     return cache;
 }
 
+struct resolv_cache*
+_resolv_get_cache_for_res(res_state statp)
+{
+    struct resolv_cache *cache;
+    const char* iface;
+    int generation;
+
+    if (_res_binding_matches(&statp->_cache_binding, statp->iface))
+        return statp->_cache_binding.cache;
+
+    /* read first: if anything changes while we look, the binding is stale
+     * by the time we use it */
+    generation = _res_cache_generation;
+
+    pthread_once(&_res_cache_once, _res_cache_init);
+    pthread_mutex_lock(&_res_cache_list_lock);
+
+    cache = _get_res_cache_locked(statp->iface, &iface);
+    if (cache != NULL)
+        _res_binding_set(&statp->_cache_binding, generation, statp->iface, iface, cache);
+
+    pthread_mutex_unlock(&_res_cache_list_lock);
+    XLOG("%s: iface = %s, cache=%p\n", __FUNCTION__, iface, cache);
+    return cache;
+}
+
 static struct resolv_cache*
 _get_res_cache_for_iface_locked(const char* ifname)
 {
@@ -1923,6 +2066,7 @@ _get_res_cache_for_iface_locked(const char* ifname)
                 cache_info->ifname[len - 1] = '\0';
 
                 _insert_cache_info_locked(cache_info);
+                _res_cache_bump_generation_locked();
             } else {
                 free(cache_info);
             }
@@ -1931,6 +2075,37 @@ _get_res_cache_for_iface_locked(const char* ifname)
     return cache;
 }
 
+int
+_resolv_get_cache_stats_for_iface(const char* ifname, struct resolv_cache_stats* stats)
+{
+    struct resolv_cache*  cache;
+    int                   nn;
+
+    cache = __get_res_cache(ifname);
+    if (cache == NULL)
+        return -1;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->max_entries = cache->max_entries;
+    for (nn = 0; nn < CACHE_SHARDS; nn++) {
+        CacheShard*  shard = &cache->shards[nn];
+
+        pthread_mutex_lock(&shard->pending_lock);
+        pthread_rwlock_rdlock(&shard->lock);
+        stats->hits             += shard->hits;
+        stats->negative_hits    += shard->negative_hits;
+        stats->misses           += shard->misses;
+        stats->coalesced        += shard->coalesced;
+        stats->pending_timeouts += shard->pending_timeouts;
+        stats->evictions        += shard->evictions;
+        stats->expirations      += shard->expirations;
+        stats->entries          += shard->num_entries;
+        pthread_rwlock_unlock(&shard->lock);
+        pthread_mutex_unlock(&shard->pending_lock);
+    }
+    return 0;
+}
+
 void
 _resolv_cache_reset(unsigned  generation)
 {
@@ -1961,7 +2136,7 @@ _resolv_cache_reset(unsigned  generation)
     if (cache != NULL) {
         pthread_mutex_lock( &cache->lock );
         if (cache->generation != generation) {
-            _cache_flush_locked(cache);
+            _cache_flush(cache);
             cache->generation = generation;
         }
         pthread_mutex_unlock( &cache->lock );
@@ -2000,9 +2175,7 @@ _flush_cache_for_iface_locked(const char* ifname)
 {
     struct resolv_cache* cache = _find_named_cache_locked(ifname);
     if (cache) {
-        pthread_mutex_lock(&cache->lock);
-        _cache_flush_locked(cache);
-        pthread_mutex_unlock(&cache->lock);
+        _cache_flush(cache);
     }
 }
 
@@ -2092,6 +2265,7 @@ _resolv_set_default_iface(const char* ifname)
     memset(_res_default_ifname, 0, size);
     strncpy(_res_default_ifname, ifname, size - 1);
     _res_default_ifname[size - 1] = '\0';
+    _res_cache_bump_generation_locked();
 
     pthread_mutex_unlock(&_res_cache_list_lock);
 }
@@ -2162,6 +2336,7 @@ _resolv_set_nameservers_for_iface(const char* ifname, const char** servers, int
 
         // flush cache since new settings
         _flush_cache_for_iface_locked(ifname);
+        _res_cache_bump_generation_locked();
 
     }
 
@@ -2626,10 +2801,21 @@ _resolv_get_default_iface(char* buff, size_t buffLen)
 void
 _resolv_populate_res_for_iface(res_state statp)
 {
+    char ifreq[IF_NAMESIZE + 1];
+    int generation;
+
     if (statp == NULL) {
         return;
     }
 
+    // statp already has what it would copy
+    if (_res_binding_matches(&statp->_ns_binding, statp->iface)) {
+        strlcpy(statp->iface, statp->_ns_binding.iface, sizeof(statp->iface));
+        return;
+    }
+    generation = _res_cache_generation;
+    strlcpy(ifreq, statp->iface, sizeof(ifreq));
+
     if (statp->iface[0] == '\0') { // no interface set assign default
         size_t if_len = _resolv_get_default_iface(statp->iface, sizeof(statp->iface));
         if (if_len + 1 > sizeof(statp->iface)) {
@@ -2683,5 +2869,6 @@ _resolv_populate_res_for_iface(res_state statp)
             *pp++ = &statp->defdname + *p++;
         }
     }
+    _res_binding_set(&statp->_ns_binding, generation, ifreq, statp->iface, NULL);
     pthread_mutex_unlock(&_res_cache_list_lock);
 }
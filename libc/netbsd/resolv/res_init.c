@@ -221,6 +221,8 @@ __res_vinit(res_state statp, int preinit) {
 	statp->_flags = 0;
 	statp->qhook = NULL;
 	statp->rhook = NULL;
+	statp->_cache_binding.generation = 0;
+	statp->_ns_binding.generation = 0;
 	statp->_u._ext.nscount = 0;
 	statp->_u._ext.ext = malloc(sizeof(*statp->_u._ext.ext));
 	if (statp->_u._ext.ext != NULL) {
@@ -542,6 +544,8 @@ res_setoptions(res_state statp, const char *options, const char *source)
 			statp->options |= RES_USE_INET6;
 		} else if (!strncmp(cp, "rotate", sizeof("rotate") - 1)) {
 			statp->options |= RES_ROTATE;
+		} else if (!strncmp(cp, "blast", sizeof("blast") - 1)) {
+			statp->options |= RES_BLAST;
 		} else if (!strncmp(cp, "no-check-names",
 				    sizeof("no-check-names") - 1)) {
 			statp->options |= RES_NOCHECKNAME;
@@ -704,6 +708,9 @@ res_setservers(res_state statp, const union res_sockaddr_union *set, int cnt) {
 	/* cause rtt times to be forgotten */
 	statp->_u._ext.nscount = 0;
 
+	/* and the nameservers of our interface to be copied in again */
+	statp->_ns_binding.generation = 0;
+
 	nserv = 0;
 	for (i = 0; i < cnt && nserv < MAXNS; i++) {
 		switch (set->sin.sin_family) {
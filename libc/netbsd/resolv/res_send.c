@@ -101,6 +101,7 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
 #ifdef ANDROID_CHANGES
 #include "resolv_private.h"
 #else
@@ -359,8 +360,12 @@ res_queriesmatch(const u_char *buf1, const u_char *eom1,
 }
 
 
-int
-res_nsend(res_state statp,
+/*
+ * Sends one query the classic way: to each nameserver in turn, waiting for
+ * its answer before trying the next one.
+ */
+static int
+res_nsend_serial(res_state statp,
 	  const u_char *buf, int buflen, u_char *ans, int anssiz)
 {
 	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
@@ -389,7 +394,7 @@ res_nsend(res_state statp,
 
 #if USE_RESOLV_CACHE
 	// get the cache associated with the interface
-	cache = __get_res_cache(statp->iface);
+	cache = _resolv_get_cache_for_res(statp);
 	if (cache != NULL) {
 		int  anslen = 0;
 		cache_status = _resolv_cache_lookup(
@@ -669,6 +674,380 @@ res_nsend(res_state statp,
 	return (-1);
 }
 
+int
+res_nsend(res_state statp,
+	  const u_char *buf, int buflen, u_char *ans, int anssiz)
+{
+	struct res_sendq q;
+
+	if ((statp->options & RES_BLAST) == 0U)
+		return (res_nsend_serial(statp, buf, buflen, ans, anssiz));
+
+	q.buf = buf;
+	q.buflen = buflen;
+	q.ans = ans;
+	q.anssiz = anssiz;
+	res_nsendN(statp, &q, 1);
+	return (q.anslen);
+}
+
+/*
+ * Opens a datagram socket connected to nameserver 'ns' for res_nsendN(),
+ * or returns -1.
+ */
+static int
+blast_socket(res_state statp, int ns)
+{
+	const struct sockaddr *nsap = get_nsaddr(statp, (size_t)ns);
+	int nsaplen = get_salen(nsap);
+	int s;
+
+	s = socket(nsap->sa_family, SOCK_DGRAM, 0);
+	if (s < 0)
+		return (-1);
+	if ((statp->_mark != 0 &&
+	     setsockopt(s, SOL_SOCKET, SO_MARK, &statp->_mark,
+			sizeof(statp->_mark)) < 0) ||
+	    random_bind(s, nsap->sa_family) < 0 ||
+	    connect(s, nsap, (socklen_t)nsaplen) < 0) {
+		Aerror(statp, stderr, "blast", errno, nsap, nsaplen);
+		close(s);
+		return (-1);
+	}
+	return (s);
+}
+
+/* Set once the kernel turns out not to have sendmmsg() and recvmmsg(). */
+static int blast_no_mmsg;
+
+/*
+ * Sends the 'n' datagrams of 'msgs' on 's', all in one system call if the
+ * kernel has sendmmsg(). As with separate send()s, a datagram that fails
+ * doesn't keep the others from going.
+ */
+static void
+blast_send(int s, struct mmsghdr *msgs, int n)
+{
+	int sent;
+
+	while (n > 0 && !blast_no_mmsg) {
+		sent = sendmmsg(s, msgs, (unsigned int)n, 0);
+		if (sent < 0 && errno == ENOSYS) {
+			blast_no_mmsg = 1;
+			break;
+		}
+		if (sent <= 0)
+			sent = 1;	/* skip the one that failed */
+		msgs += sent;
+		n -= sent;
+	}
+	for (; n > 0; msgs++, n--)
+		send(s, msgs->msg_hdr.msg_iov->iov_base,
+		    msgs->msg_hdr.msg_iov->iov_len, 0);
+}
+
+/*
+ * Receives up to 'n' datagrams from 's' into 'msgs' without blocking, all in
+ * one system call if the kernel has recvmmsg(). Returns how many, with their
+ * lengths in 'msg_len', or -1.
+ */
+static int
+blast_recv(int s, struct mmsghdr *msgs, int n)
+{
+	int got;
+
+	if (!blast_no_mmsg) {
+		got = recvmmsg(s, msgs, (unsigned int)n, MSG_DONTWAIT, NULL);
+		if (got >= 0 || errno != ENOSYS)
+			return (got);
+		blast_no_mmsg = 1;
+	}
+	got = recv(s, msgs->msg_hdr.msg_iov->iov_base,
+	    msgs->msg_hdr.msg_iov->iov_len, MSG_DONTWAIT);
+	if (got < 0)
+		return (-1);
+	msgs->msg_len = (unsigned int)got;
+	return (1);
+}
+
+/* What res_nsendN() has done with each query. */
+enum {
+	BLAST_WAITING,		/* no usable answer yet */
+	BLAST_ANSWERED,		/* answered by a nameserver */
+	BLAST_CACHED,		/* answered from the cache */
+	BLAST_REJECTED,		/* rejected by every server, 'ans' is the last */
+	BLAST_SERIAL		/* left to res_nsend_serial() */
+};
+
+/*
+ * Has every nameserver still open rejected a query? 'rejected' has bit 'n'
+ * set for each one, by its index in 'pfd', that did.
+ */
+static int
+blast_all_rejected(const struct pollfd *pfd, int nfds, unsigned int rejected)
+{
+	int n;
+
+	for (n = 0; n < nfds; n++) {
+		if (pfd[n].fd >= 0 && (rejected & (1U << n)) == 0U)
+			return (0);
+	}
+	return (1);
+}
+
+/*
+ * RES_BLAST: sends all 'count' queries to all nameservers at once and takes
+ * the first usable answer to each, so that a dead or slow server costs
+ * nothing as long as another one answers, and the caller's queries (a
+ * host's A and AAAA records, say) don't wait for each other. Unanswered
+ * queries are sent again every 'retrans' seconds, 'retry' times in all, but
+ * not once every server has rejected them: the last rejection is then the
+ * answer.
+ * Each server gets all of them, and gives back all it has answered so far,
+ * in one system call each way.
+ * Queries that need TCP or got a truncated answer, and all of them when
+ * hooks are installed, go through res_nsend_serial() instead.
+ *
+ * Sets each query's 'anslen' to the length of its answer, or to -1, and
+ * returns how many were answered. If none was, errno is set like
+ * res_nsend() sets it.
+ */
+int
+res_nsendN(res_state statp, struct res_sendq *q, int count)
+{
+	struct pollfd pfd[MAXNS];
+	int state[RES_NSENDN_MAX];
+	unsigned int rejected[RES_NSENDN_MAX];
+	int rejlen[RES_NSENDN_MAX];
+	struct mmsghdr smsg[RES_NSENDN_MAX], rmsg[RES_NSENDN_MAX];
+	struct iovec siov[RES_NSENDN_MAX], riov[RES_NSENDN_MAX];
+	u_char *abuf = NULL;
+	int abufsiz = 0;
+	int i, j, ns, n, nfds, live, try, waiting, answered, gotsomewhere;
+	struct timespec finish, now, timeout;
+#if USE_RESOLV_CACHE
+	struct resolv_cache *cache;
+	ResolvCacheStatus cache_status[RES_NSENDN_MAX];
+#endif
+
+	if (count > RES_NSENDN_MAX || statp->qhook || statp->rhook) {
+		for (i = 0, answered = 0; i < count; i++) {
+			q[i].anslen = res_nsend_serial(statp, q[i].buf,
+			    q[i].buflen, q[i].ans, q[i].anssiz);
+			if (q[i].anslen >= 0)
+				answered++;
+		}
+		return (answered);
+	}
+
+#if USE_RESOLV_CACHE
+	cache = _resolv_get_cache_for_res(statp);
+#endif
+	waiting = 0;
+	for (i = 0; i < count; i++) {
+		q[i].anslen = -1;
+		rejected[i] = 0U;
+#if USE_RESOLV_CACHE
+		cache_status[i] = RESOLV_CACHE_UNSUPPORTED;
+#endif
+		if ((statp->options & RES_USEVC) || q[i].buflen > PACKETSZ ||
+		    q[i].anssiz < HFIXEDSZ) {
+			state[i] = BLAST_SERIAL;
+			continue;
+		}
+#if USE_RESOLV_CACHE
+		if (cache != NULL) {
+			int anslen = 0;
+
+			cache_status[i] = _resolv_cache_lookup(cache,
+			    q[i].buf, q[i].buflen, q[i].ans, q[i].anssiz,
+			    &anslen);
+			if (cache_status[i] == RESOLV_CACHE_FOUND) {
+				q[i].anslen = anslen;
+				state[i] = BLAST_CACHED;
+				continue;
+			}
+		}
+#endif
+		state[i] = BLAST_WAITING;
+		if (q[i].anssiz > abufsiz)
+			abufsiz = q[i].anssiz;
+		waiting++;
+	}
+
+	nfds = 0;
+	gotsomewhere = 0;
+	if (waiting > 0) {
+#if USE_RESOLV_CACHE
+		if (cache != NULL)
+			_resolv_populate_res_for_iface(statp);
+#endif
+		abuf = malloc((size_t)abufsiz * RES_NSENDN_MAX);
+		memset(rmsg, 0, sizeof(rmsg));
+		for (j = 0; abuf != NULL && j < RES_NSENDN_MAX; j++) {
+			riov[j].iov_base = abuf + j * abufsiz;
+			riov[j].iov_len = (size_t)abufsiz;
+			rmsg[j].msg_hdr.msg_iov = &riov[j];
+			rmsg[j].msg_hdr.msg_iovlen = 1;
+		}
+		for (ns = 0; abuf != NULL && ns < statp->nscount; ns++) {
+			pfd[nfds].fd = blast_socket(statp, ns);
+			pfd[nfds].events = POLLIN;
+			if (pfd[nfds].fd >= 0)
+				nfds++;
+		}
+	}
+
+	live = nfds;
+	for (try = 0; try < statp->retry && waiting > 0 && live > 0; try++) {
+		memset(smsg, 0, sizeof(smsg));
+		for (i = 0, j = 0; i < count; i++) {
+			if (state[i] != BLAST_WAITING)
+				continue;
+			siov[j].iov_base = (void *)(uintptr_t)q[i].buf;
+			siov[j].iov_len = (size_t)q[i].buflen;
+			smsg[j].msg_hdr.msg_iov = &siov[j];
+			smsg[j].msg_hdr.msg_iovlen = 1;
+			j++;
+		}
+		for (n = 0; n < nfds; n++) {
+			if (pfd[n].fd >= 0)
+				blast_send(pfd[n].fd, smsg, j);
+		}
+		finish = evAddTime(evNowTime(),
+		    evConsTime((long)statp->retrans, 0L));
+
+		while (waiting > 0 && live > 0) {
+			now = evNowTime();
+			if (evCmpTime(finish, now) <= 0)
+				break;
+			timeout = evSubTime(finish, now);
+			n = poll(pfd, (nfds_t)nfds,
+			    (int)(timeout.tv_sec * 1000 +
+				  timeout.tv_nsec / 1000000 + 1));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				break;
+
+			for (n = 0; n < nfds; n++) {
+				int got;
+
+				if (pfd[n].fd < 0 || pfd[n].revents == 0)
+					continue;
+				got = blast_recv(pfd[n].fd, rmsg, RES_NSENDN_MAX);
+				if (got < 0) {
+					if (errno == EAGAIN || errno == EINTR)
+						continue;
+					/* ECONNREFUSED: nobody's listening */
+					Perror(statp, stderr, "recv", errno);
+					close(pfd[n].fd);
+					pfd[n].fd = -1;
+					live--;
+					/* the others may all have rejected some */
+					for (i = 0; i < count && live > 0; i++) {
+						if (state[i] == BLAST_WAITING &&
+						    rejected[i] != 0U &&
+						    blast_all_rejected(pfd, nfds,
+							rejected[i])) {
+							q[i].anslen = rejlen[i];
+							state[i] = BLAST_REJECTED;
+							waiting--;
+						}
+					}
+					continue;
+				}
+				gotsomewhere = 1;
+				for (j = 0; j < got; j++) {
+					u_char *rbuf = riov[j].iov_base;
+					const HEADER *anhp =
+					    (const HEADER *)(void *)rbuf;
+					int resplen = (int)rmsg[j].msg_len;
+
+					if (resplen < HFIXEDSZ)
+						continue;
+					for (i = 0; i < count; i++) {
+						const HEADER *hp = (const HEADER *)
+						    (const void *)q[i].buf;
+
+						if (state[i] == BLAST_WAITING &&
+						    hp->id == anhp->id &&
+						    res_queriesmatch(q[i].buf,
+							q[i].buf + q[i].buflen,
+							rbuf, rbuf + resplen))
+							break;
+					}
+					if (i == count) {
+						/* late answer to something else */
+						continue;
+					}
+					if (resplen > q[i].anssiz)
+						resplen = q[i].anssiz;
+					/* let another server answer instead */
+					if (anhp->rcode == SERVFAIL ||
+					    anhp->rcode == NOTIMP ||
+					    anhp->rcode == REFUSED ||
+					    anhp->rcode == FORMERR) {
+						memcpy(q[i].ans, rbuf,
+						    (size_t)resplen);
+						rejlen[i] = resplen;
+						rejected[i] |= 1U << n;
+						if (blast_all_rejected(pfd, nfds,
+						    rejected[i])) {
+							q[i].anslen = resplen;
+							state[i] =
+							    BLAST_REJECTED;
+							waiting--;
+						}
+						continue;
+					}
+
+					waiting--;
+					if (!(statp->options & RES_IGNTC) &&
+					    anhp->tc) {
+						state[i] = BLAST_SERIAL;
+						continue;
+					}
+					memcpy(q[i].ans, rbuf, (size_t)resplen);
+					q[i].anslen = resplen;
+					state[i] = BLAST_ANSWERED;
+				}
+			}
+		}
+	}
+
+	for (n = 0; n < nfds; n++) {
+		if (pfd[n].fd >= 0)
+			close(pfd[n].fd);
+	}
+	free(abuf);
+
+	answered = 0;
+	for (i = 0; i < count; i++) {
+#if USE_RESOLV_CACHE
+		if (cache_status[i] == RESOLV_CACHE_NOTFOUND) {
+			/* an answer, or else wake up whoever waits on us */
+			if (state[i] == BLAST_ANSWERED)
+				_resolv_cache_add(cache, q[i].buf, q[i].buflen,
+				    q[i].ans, q[i].anslen);
+			else
+				_resolv_cache_query_failed(cache, q[i].buf,
+				    q[i].buflen);
+		}
+#endif
+		if (state[i] == BLAST_SERIAL)
+			q[i].anslen = res_nsend_serial(statp, q[i].buf,
+			    q[i].buflen, q[i].ans, q[i].anssiz);
+		if (q[i].anslen >= 0)
+			answered++;
+	}
+	if (answered == 0 && !gotsomewhere)
+		errno = ECONNREFUSED;	/* no nameservers found */
+	else if (answered == 0)
+		errno = ETIMEDOUT;	/* no answer obtained */
+	return (answered);
+}
+
 /* Private */
 
 static int
@@ -22,6 +22,8 @@
 #include <sys/auxv.h>
 
 struct abort_msg_t;
+struct bionic_tls_modules_t;
+struct StartupTrace;
 
 // When the kernel starts the dynamic linker, it passes a pointer to a block
 // of memory containing argc, the argv array, the environment variable array,
@@ -44,6 +46,10 @@ class KernelArgumentBlock {
     ++p; // Skip second NULL;
 
     auxv = reinterpret_cast<Elf32_auxv_t*>(p);
+
+    abort_message_ptr = NULL;
+    tls_modules = NULL;
+    startup_trace = NULL;
   }
 
   // Similar to ::getauxval but doesn't require the libc global variables to be set up,
@@ -71,6 +77,12 @@ class KernelArgumentBlock {
 
   abort_msg_t** abort_message_ptr;
 
+  // The dynamic linker's table of ELF TLS modules, for __tls_get_addr.
+  bionic_tls_modules_t* tls_modules;
+
+  // The dynamic linker's startup timestamps, if LD_STARTUP_TRACE is set.
+  StartupTrace* startup_trace;
+
  private:
   // Disallow copy and assignment.
   KernelArgumentBlock(const KernelArgumentBlock&);
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STARTUP_TRACE_H
+#define STARTUP_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Timestamps of the phases a dynamically-linked process goes through on its
+// way to main(). The dynamic linker owns the only instance, and only hands it
+// to libc (in KernelArgumentBlock::startup_trace) when LD_STARTUP_TRACE is
+// set; __libc_init() logs it just before calling main().
+struct StartupTrace {
+  static const size_t kMaxPhases = 8;
+
+  // Records that 'phase' (a string literal) starts now. Marks past
+  // kMaxPhases are dropped.
+  void Mark(const char* phase) {
+    if (count < kMaxPhases) {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      phases[count].name = phase;
+      phases[count].ns = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+      ++count;
+    }
+  }
+
+  size_t count;
+  struct {
+    const char* name;
+    int64_t ns;
+  } phases[kMaxPhases];
+};
+
+#endif // STARTUP_TRACE_H
@@ -120,6 +120,30 @@ __bionic_memory_barrier(void)
 }
 #endif /* !ANDROID_SMP */
 
+/* Define a barrier that orders earlier loads before all later accesses,
+ * and all earlier accesses before later stores. This is enough to give
+ * a preceding load acquire semantics, or a following store release
+ * semantics, but unlike a full barrier it doesn't order an earlier store
+ * with a later load.
+ *
+ * On ARMv7-A, this is 'dmb ish', which only waits for the inner-shareable
+ * domain rather than the whole system. Elsewhere we fall back to the full
+ * barrier.
+ */
+#if defined(ANDROID_SMP) && ANDROID_SMP == 1 && defined(__ARM_HAVE_DMB)
+__ATOMIC_INLINE__ void
+__bionic_acq_rel_barrier(void)
+{
+    __asm__ __volatile__ ( "dmb ish" : : : "memory" );
+}
+#else
+__ATOMIC_INLINE__ void
+__bionic_acq_rel_barrier(void)
+{
+    __bionic_memory_barrier();
+}
+#endif
+
 #ifndef __ARM_HAVE_LDREX_STREX
 #error Only ARM devices which have LDREX / STREX are supported
 #endif
@@ -33,6 +33,12 @@
  * void ANDROID_MEMBAR_FULL(void)
  *   Full memory barrier.  Provides a compiler reordering barrier, and
  *   on SMP systems emits an appropriate instruction.
+ *
+ * void ANDROID_MEMBAR_ACQ_REL(void)
+ *   Barrier placed after a load to give it acquire semantics, or before
+ *   a store to give it release semantics.  Cheaper than a full barrier
+ *   on some CPUs because it doesn't order earlier stores with later
+ *   loads.
  */
 
 #if !defined(ANDROID_SMP)
@@ -60,6 +66,7 @@ extern "C" {
 #endif
 
 #define ANDROID_MEMBAR_FULL  __bionic_memory_barrier
+#define ANDROID_MEMBAR_ACQ_REL  __bionic_acq_rel_barrier
 
 #ifdef __cplusplus
 } // extern "C"
@@ -34,6 +34,16 @@ __bionic_memory_barrier()
 }
 #endif
 
+/* Define a barrier that gives a preceding load acquire semantics, or a
+ * following store release semantics. MIPS32 has nothing lighter than
+ * 'sync' for this.
+ */
+__ATOMIC_INLINE__ void
+__bionic_acq_rel_barrier()
+{
+    __bionic_memory_barrier();
+}
+
 /* Compare-and-swap, without any explicit barriers. Note that this function
  * returns 0 on success, and 1 on failure. The opposite convention is typically
  * used on other platforms.
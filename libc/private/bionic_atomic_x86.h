@@ -34,6 +34,17 @@ __bionic_memory_barrier()
 }
 #endif
 
+/* Define a barrier that gives a preceding load acquire semantics, or a
+ * following store release semantics. x86 never reorders loads with other
+ * loads or stores with other stores, nor later stores before earlier
+ * loads, so only the compiler needs to be told.
+ */
+__ATOMIC_INLINE__ void
+__bionic_acq_rel_barrier()
+{
+    __asm__ __volatile__ ( "" : : : "memory" );
+}
+
 /* Compare-and-swap, without any explicit barriers. Note that this function
  * returns 0 on success, and 1 on failure. The opposite convention is typically
  * used on other platforms.
@@ -35,6 +35,9 @@ __BEGIN_DECLS
 
 extern Elf32_auxv_t* __libc_auxv;
 
+// Sets '__libc_auxv' and the table getauxval reads the common types from.
+__LIBC_HIDDEN__ void __libc_init_auxv(Elf32_auxv_t* auxv);
+
 __END_DECLS
 
 #endif /* _PRIVATE_BIONIC_AUXV_H_ */
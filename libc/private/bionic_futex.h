@@ -51,6 +51,18 @@ extern int __futex_syscall4(volatile void *ftx, int op, int val, const struct ti
 #define FUTEX_WAKE_PRIVATE  (FUTEX_WAKE|FUTEX_PRIVATE_FLAG)
 #endif
 
+#ifndef FUTEX_WAIT_BITSET
+#define FUTEX_WAIT_BITSET  9
+#endif
+
+#ifndef FUTEX_CLOCK_REALTIME
+#define FUTEX_CLOCK_REALTIME  256
+#endif
+
+#ifndef FUTEX_BITSET_MATCH_ANY
+#define FUTEX_BITSET_MATCH_ANY  0xffffffff
+#endif
+
 /* Like __futex_wait/wake, but take an additionnal 'pshared' argument.
  * when non-0, this will use normal futexes. Otherwise, private futexes.
  */
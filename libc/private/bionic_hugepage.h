@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _BIONIC_HUGEPAGE_H
+#define _BIONIC_HUGEPAGE_H
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/* The transparent huge page size on ARM (with LPAE) and x86. */
+#define BIONIC_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/* Set by mallopt(M_HUGEPAGES) or the libc.malloc.hugepages property. */
+__LIBC_HIDDEN__ extern int __bionic_hugepages_enabled;
+
+/*
+ * Like mmap(NULL, length, prot, flags, -1, 0). When huge pages are enabled
+ * and length is at least a huge page, the mapping starts on a huge page
+ * boundary and is marked MADV_HUGEPAGE.
+ */
+__LIBC_HIDDEN__ void* __bionic_hugepage_mmap(size_t length, int prot, int flags);
+
+/* Marks the whole pages of existing memory MADV_HUGEPAGE, if enabled. */
+__LIBC_HIDDEN__ void __bionic_hugepage_advise(void* addr, size_t length);
+
+/* mallopt(M_HUGEPAGES): also makes dlmalloc grow in whole huge pages. */
+__LIBC_HIDDEN__ int __bionic_malloc_set_hugepages(int enable);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef _BIONIC_THREAD_TABLE_H
+#define _BIONIC_THREAD_TABLE_H
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/*
+ * Every running thread, published in libc as __bionic_thread_table so that
+ * libthread_db can read the lot in two reads of the target's memory instead
+ * of walking /proc/<pid>/task. The sequence is odd while the table is being
+ * changed; a reader copies the header, then 'used' records, then checks that
+ * the sequence is still the even number it started with, and retries if not.
+ * 'records' may move when the table grows, so a read through a stale copy of
+ * it can fail, which also means retry.
+ */
+#define BIONIC_THREAD_TABLE_VERSION 1
+
+struct bionic_thread_record {
+    pid_t tid;          /* 0 for a free record */
+    uintptr_t thread;   /* the pthread_t */
+};
+
+struct bionic_thread_table {
+    uint32_t version;
+    volatile uint32_t sequence;
+    uint32_t used;      /* Records after these are all free. */
+    uint32_t capacity;
+    struct bionic_thread_record* volatile records;
+};
+
+struct pthread_internal_t;
+
+__LIBC_HIDDEN__ void __bionic_thread_table_add(struct pthread_internal_t* thread);
+__LIBC_HIDDEN__ void __bionic_thread_table_remove(struct pthread_internal_t* thread);
+
+/* Forgets every thread but the caller, in a fork child. */
+__LIBC_HIDDEN__ void __bionic_thread_table_after_fork(struct pthread_internal_t* thread);
+
+__END_DECLS
+
+#endif /* _BIONIC_THREAD_TABLE_H */
@@ -57,8 +57,21 @@ extern size_t strftime_tz(char* s, size_t max, const char* format, const struct
 extern time_t mktime_tz(struct tm* const tmp, char const* tz);
 extern void localtime_tz(const time_t* const timep, struct tm* tmp, const char* tz);
 
+/*
+ * A format parsed once by strftime_compile, for strftime_compiled to format any number of times
+ * much more cheaply than strftime_tz would. strftime_compile returns NULL if out of memory. A NULL
+ * locale means the C locale.
+ */
+struct strftime_format;
+extern struct strftime_format* strftime_compile(const char* format);
+extern size_t strftime_compiled(char* s, size_t max, const struct strftime_format* format, const struct tm* tm, const struct strftime_locale* lc);
+extern void strftime_compiled_free(struct strftime_format* format);
+
 #endif /* _BIONIC_STRFTIME_TZ_DECLARED */
 
+/* Called by setenv(3) and friends after changing 'name', so localtime(3) and friends know to look at TZ again. */
+__LIBC_HIDDEN__ extern void __bionic_tz_env_changed(const char* name);
+
 __END_DECLS
 
 #endif /* _BIONIC_TIME_H */
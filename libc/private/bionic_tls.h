@@ -28,6 +28,8 @@
 #ifndef _SYS_TLS_H
 #define _SYS_TLS_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/cdefs.h>
 
 __BEGIN_DECLS
@@ -83,6 +85,37 @@ enum {
 #define BIONIC_ALIGN(x, a) (((x) + (a - 1)) & ~(a - 1))
 #define BIONIC_TLS_SLOTS BIONIC_ALIGN(128 + TLS_SLOT_FIRST_USER_SLOT + GLOBAL_INIT_THREAD_LOCAL_BUFFER_COUNT, 4)
 
+/*
+ * pthread keys beyond the TLS array are kept in a second level of per-thread blocks of
+ * BIONIC_TLS_KEY_BLOCK_SIZE values, each allocated the first time the thread sets one of
+ * its keys. BIONIC_TLS_KEYS is the total number of keys, including the TLS array slots.
+ */
+#define BIONIC_TLS_KEY_BLOCK_SIZE 64
+#define BIONIC_TLS_KEY_BLOCKS 16
+#define BIONIC_TLS_KEYS (BIONIC_TLS_SLOTS + BIONIC_TLS_KEY_BLOCKS * BIONIC_TLS_KEY_BLOCK_SIZE)
+
+/*
+ * ELF TLS (PT_TLS) modules. The dynamic linker gives each loaded object with a PT_TLS
+ * segment a module id and records its TLS segment here; libc's __tls_get_addr reads
+ * this table to allocate and initialize each thread's copy on first use. Module ids
+ * start at 1. A module's generation is 0 while the id is free, and changes whenever
+ * the id is reused, so a thread can tell that a block it allocated is stale.
+ */
+#define BIONIC_TLS_MODULES_MAX 64
+
+typedef struct bionic_tls_module_t {
+  const void* init_image; /* .tdata */
+  size_t init_size;
+  size_t block_size;      /* .tdata + .tbss */
+  size_t align;
+  uint32_t generation;
+} bionic_tls_module_t;
+
+typedef struct bionic_tls_modules_t {
+  uint32_t next_generation;
+  bionic_tls_module_t modules[BIONIC_TLS_MODULES_MAX];
+} bionic_tls_modules_t;
+
 /* syscall only, do not call directly */
 extern int __set_tls(void* ptr);
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef _BIONIC_TRACE_H
+#define _BIONIC_TRACE_H
+
+#include <android/trace_events.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <time.h>
+
+__BEGIN_DECLS
+
+/*
+ * One thread's events (see <android/trace_events.h>), in a ring that only
+ * its owner writes to and only android_trace_read() reads from, under a lock
+ * of its own. Buffers are never freed, so that the reader needn't care about
+ * threads exiting: the next thread to want a buffer takes over an exited
+ * thread's, unread events and all.
+ */
+struct bionic_trace_buffer {
+    struct bionic_trace_buffer* next;  /* Every buffer, newest first. */
+    volatile pid_t owner;              /* The owning thread, or 0. */
+    volatile int enabled;
+    volatile uint32_t head;            /* Events written by the owner... */
+    volatile uint32_t tail;            /* ...and read by the reader. */
+    uint32_t dropped;                  /* Events lost to a full ring since the last written. */
+    uint32_t mask;                     /* The capacity, a power of two, less one. */
+    struct android_trace_event events[];
+};
+
+/* Nonzero between android_trace_start() and android_trace_stop(). */
+__LIBC_HIDDEN__ extern volatile int __libc_trace_enabled;
+
+__LIBC_HIDDEN__ void __libc_trace_event(uint32_t type, uint64_t arg);
+
+struct pthread_internal_t;
+
+/* Gives up an exiting thread's buffer. */
+__LIBC_HIDDEN__ void __libc_trace_thread_exit(struct pthread_internal_t* thread);
+
+/* Records an event from libc. */
+#define __libc_trace(type, arg) \
+    do { \
+        if (__predict_false(__libc_trace_enabled)) { \
+            __libc_trace_event((type), (uint64_t) (uintptr_t) (arg)); \
+        } \
+    } while (0)
+
+/*
+ * Appends an event to the calling thread's buffer. Shared with the dynamic
+ * linker, which has its own copy of libc's globals and so can't see
+ * __libc_trace_enabled, only the buffers in the threads.
+ */
+static __inline__ void
+__bionic_trace_append(struct bionic_trace_buffer* buffer, pid_t tid, uint32_t type, uint64_t arg)
+{
+    struct timespec ts;
+    struct android_trace_event* event;
+    uint32_t head = buffer->head;
+    uint32_t needed = (buffer->dropped != 0) ? 2 : 1;
+
+    if (!buffer->enabled)
+        return;
+    if (head - buffer->tail > buffer->mask + 1 - needed) {
+        ++buffer->dropped;
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (buffer->dropped != 0) {
+        event = &buffer->events[head++ & buffer->mask];
+        event->time_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        event->arg = buffer->dropped;
+        event->tid = tid;
+        event->type = ANDROID_TRACE_DROPPED;
+        buffer->dropped = 0;
+    }
+    event = &buffer->events[head++ & buffer->mask];
+    event->time_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    event->arg = arg;
+    event->tid = tid;
+    event->type = type;
+
+    /* The reader mustn't see the new head before the events. */
+    __sync_synchronize();
+    buffer->head = head;
+}
+
+__END_DECLS
+
+#endif /* _BIONIC_TRACE_H */
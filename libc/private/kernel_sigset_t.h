@@ -35,6 +35,10 @@ union kernel_sigset_t {
     memset(this, 0, sizeof(*this));
   }
 
+  void fill() {
+    memset(this, 0xff, sizeof(*this));
+  }
+
   void set(const sigset_t* value) {
     bionic = *value;
   }
@@ -40,6 +40,12 @@ struct resolv_cache;  /* forward */
 __LIBC_HIDDEN__
 extern struct resolv_cache*  __get_res_cache(const char* ifname);
 
+/* same as __get_res_cache(statp->iface), but without taking any lock as long
+ * as the interface configuration hasn't changed since the last call with the
+ * same 'statp' */
+__LIBC_HIDDEN__
+extern struct resolv_cache*  _resolv_get_cache_for_res(struct __res_state* statp);
+
 /* this gets called everytime we detect some changes in the DNS configuration
  * and will flush the cache */
 __LIBC_HIDDEN__
@@ -86,7 +92,9 @@ __LIBC_HIDDEN__
 
 /* sets the name server addresses to the provided res_state structure. The
  * name servers are retrieved from the cache which is associated
- * with the interface to which the res_state structure is associated */
+ * with the interface to which the res_state structure is associated.
+ * this does nothing, and takes no lock, if it has already been done for
+ * that interface since the interface configuration last changed */
 __LIBC_HIDDEN__
 extern void _resolv_populate_res_for_iface(struct __res_state* statp);
 
@@ -101,6 +101,26 @@ extern int _resolv_get_uids_associated_interface(int uid, char* buff, int buffLe
 
 #endif /* _BIONIC_RESOLV_IFACE_FUNCTIONS_DECLARED */
 
+/* What the DNS cache of an interface has done since it was created. A
+ * lookup that waited for an identical query in flight counts as coalesced,
+ * and then as a hit or a miss depending on how that query went. */
+struct resolv_cache_stats {
+    unsigned hits;             /* lookups answered from the cache */
+    unsigned negative_hits;    /* hits on a cached NXDOMAIN or NODATA answer */
+    unsigned misses;           /* lookups that had to ask a name server */
+    unsigned coalesced;        /* lookups that waited for an identical query */
+    unsigned pending_timeouts; /* coalesced lookups that gave up waiting */
+    unsigned evictions;        /* entries dropped to make room */
+    unsigned expirations;      /* entries dropped because their TTL ran out */
+    int      entries;          /* entries now */
+    int      max_entries;      /* capacity, 0 if this process doesn't cache */
+};
+
+/** Copies the counters of the cache of interface 'ifname' (or of the
+ *  default interface, if NULL) to 'stats'. Returns 0, or -1 if the
+ *  interface has no cache. */
+extern int _resolv_get_cache_stats_for_iface(const char* ifname, struct resolv_cache_stats* stats);
+
 __END_DECLS
 
 #endif /* _RESOLV_IFACE_H */
@@ -141,6 +141,18 @@ struct res_sym {
 
 struct __res_state_ext;
 
+/*
+ * PRIVATE: what res_cache.c last looked up for a res_state's 'iface'. It
+ * stands for as long as the interface configuration keeps the generation
+ * it was looked up in.
+ */
+struct __res_iface_binding {
+	int	generation;		/* 0 if none */
+	char	ifreq[IF_NAMESIZE+1];	/* the 'iface' it was looked up for */
+	char	iface[IF_NAMESIZE+1];	/* the interface that turned out to be */
+	struct resolv_cache *cache;
+};
+
 struct __res_state {
 	char	iface[IF_NAMESIZE+1];
 	int	retrans;	 	/* retransmission time interval */
@@ -191,6 +203,8 @@ struct __res_state {
 	} _u;
 #endif
         struct res_static   rstatic[1];
+	struct __res_iface_binding _cache_binding;	/* PRIVATE */
+	struct __res_iface_binding _ns_binding;		/* PRIVATE */
 };
 
 typedef struct __res_state *res_state;
@@ -208,6 +222,19 @@ union res_sockaddr_union {
 	char			__space[128];   /* max size */
 };
 
+/*
+ * One of the queries res_nsendN() sends at once, and its answer.
+ */
+#define	RES_NSENDN_MAX	4	/* more queries are sent one by one */
+
+struct res_sendq {
+	const u_char	*buf;		/* the query */
+	int		buflen;
+	u_char		*ans;		/* where to put the answer */
+	int		anssiz;
+	int		anslen;		/* out: its length, or -1 */
+};
+
 /*
  * Resolver flags (used to be discrete per-module statics ints).
  */
@@ -383,6 +410,7 @@ extern const struct res_sym __p_rcode_syms[];
 #define res_nquerydomain	__res_nquerydomain
 #define res_nsearch		__res_nsearch
 #define res_nsend		__res_nsend
+#define res_nsendN		__res_nsendN
 #define res_nsendsigned		__res_nsendsigned
 #define res_nisourserver	__res_nisourserver
 #define res_ownok		__res_ownok
@@ -463,6 +491,7 @@ int		res_nmkquery(res_state, int, const char *, int, int,
 				  const u_char *, int, const u_char *,
 				  u_char *, int);
 int		res_nsend(res_state, const u_char *, int, u_char *, int);
+int		res_nsendN(res_state, struct res_sendq *, int);
 int		res_nsendsigned(res_state, const u_char *, int,
 				     ns_tsig_key *, u_char *, int);
 int		res_findzonecut(res_state, const char *, ns_class, int,
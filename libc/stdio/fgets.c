@@ -30,18 +30,9 @@
  * SUCH DAMAGE.
  */
 
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)fgets.c	8.2 (Berkeley) 12/22/93";
-#endif /* LIBC_SCCS and not lint */
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
-
-#include "namespace.h"
 #include <stdio.h>
 #include <string.h>
-#include "un-namespace.h"
 #include "local.h"
-#include "libc_private.h"
 
 /*
  * Read at most n-1 characters from the given file.
@@ -49,7 +40,7 @@ __FBSDID("$FreeBSD$");
  * Return first argument, or NULL if no characters were read.
  */
 char *
-fgets(char * __restrict buf, int n, FILE * __restrict fp)
+fgets_unlocked(char * __restrict buf, int n, FILE * __restrict fp)
 {
 	size_t len;
 	char *s;
@@ -58,8 +49,6 @@ fgets(char * __restrict buf, int n, FILE * __restrict fp)
 	if (n <= 0)		/* sanity check */
 		return (NULL);
 
-	FLOCKFILE(fp);
-	ORIENT(fp, -1);
 	s = buf;
 	n--;			/* leave space for NUL */
 	while (n != 0) {
@@ -69,10 +58,8 @@ fgets(char * __restrict buf, int n, FILE * __restrict fp)
 		if ((len = fp->_r) <= 0) {
 			if (__srefill(fp)) {
 				/* EOF/error: stop with partial or no line */
-				if (s == buf) {
-					FUNLOCKFILE(fp);
+				if (s == buf)
 					return (NULL);
-				}
 				break;
 			}
 			len = fp->_r;
@@ -94,7 +81,6 @@ fgets(char * __restrict buf, int n, FILE * __restrict fp)
 			fp->_p = t;
 			(void)memcpy((void *)s, (void *)p, len);
 			s[len] = 0;
-			FUNLOCKFILE(fp);
 			return (buf);
 		}
 		fp->_r -= len;
@@ -104,6 +90,16 @@ fgets(char * __restrict buf, int n, FILE * __restrict fp)
 		n -= len;
 	}
 	*s = 0;
-	FUNLOCKFILE(fp);
 	return (buf);
 }
+
+char *
+fgets(char * __restrict buf, int n, FILE * __restrict fp)
+{
+	char *s;
+
+	FLOCKFILE(fp);
+	s = fgets_unlocked(buf, n, fp);
+	FUNLOCKFILE(fp);
+	return (s);
+}
@@ -39,9 +39,13 @@ struct __sfileext {
 	struct	__sbuf _ub; /* ungetc buffer */
 	struct wchar_io_data _wcio;	/* wide char io status */
 	pthread_mutex_t _lock; /* file lock */
+	struct __sFILE *_freenext; /* next FILE on __sfp's free list */
+	struct __sFILE *_wrnext; /* next FILE that may have output to flush */
+	struct __sFILE **_wrprev; /* what points at us there; NULL if unlisted */
+	int _caller_locks; /* __fsetlocking(FSETLOCKING_BYCALLER) */
 };
 
-#define _FILEEXT_INITIALIZER  {{NULL,0},{0},PTHREAD_RECURSIVE_MUTEX_INITIALIZER}
+#define _FILEEXT_INITIALIZER  {{NULL,0},{0},PTHREAD_RECURSIVE_MUTEX_INITIALIZER,NULL,NULL,NULL,0}
 
 #define _EXT(fp) ((struct __sfileext *)((fp)->_ext._base))
 #define _UB(fp) _EXT(fp)->_ub
@@ -53,6 +57,7 @@ do { \
 	_UB(fp)._size = 0; \
 	WCIO_INIT(fp); \
 	_FLOCK_INIT(fp); \
+	_EXT(fp)->_caller_locks = 0; \
 } while (0)
 
 /* Helper macros to avoid a function call when you know that fp is not NULL.
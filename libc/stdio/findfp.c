@@ -43,7 +43,7 @@
 
 int	__sdidinit;
 
-#define	NDYNAMIC 10		/* add ten more whenever necessary */
+#define	NDYNAMIC 10		/* add at least ten more whenever necessary */
 
 #define	std(flags, file) \
 	{0,0,0,flags,file,{0,0},0,__sF+file,__sclose,__sread,__sseek,__swrite, \
@@ -58,6 +58,28 @@ static struct glue uglue = { 0, FOPEN_MAX - 3, usual };
 static struct glue *lastglue = &uglue;
 _THREAD_PRIVATE_MUTEX(__sfp_mutex);
 
+/*
+ * FILEs known to be free, and how many FILEs there are in all. fclose()
+ * and friends release a FILE by clearing its _flags and don't tell us, so
+ * when the free list runs dry __sfp() sweeps the glue for released FILEs,
+ * and grows it by as many FILEs again as it holds if the sweep recovered
+ * less than a quarter of them. That keeps each __sfp() O(1) amortized.
+ */
+static FILE *freelist;
+static int niobs = FOPEN_MAX;	/* __sF + usual */
+
+/*
+ * FILEs that may have output to flush: every FILE __sfp() hands out, until
+ * __sfwalk_writable() finds it released or open for reading only. Entries
+ * are only added at the head and unlinked under __sfp_mutex, and a FILE
+ * is never freed, so walkers can follow the links unlocked.
+ */
+static FILE *writable;
+
+/* Released, or open for reading only. (_flags is 1 while being opened.) */
+#define	unwritable(fp) \
+	((fp)->_flags == 0 || ((fp)->_flags & (__SRD|__SWR|__SRW)) == __SRD)
+
 static struct __sfileext __sFext[3] = {
 	_FILEEXT_INITIALIZER,
 	_FILEEXT_INITIALIZER,
@@ -94,12 +116,56 @@ moreglue(int n)
 	while (--n >= 0) {
 		*p = empty;
 		_FILEEXT_SETUP(p, pext);
+		pext->_freenext = NULL;
+		pext->_wrnext = NULL;
+		pext->_wrprev = NULL;
 		p++;
 		pext++;
 	}
 	return (g);
 }
 
+/*
+ * Rebuilds the free list from the FILEs in 'g' onwards that are free.
+ * Returns how many there were. Called with __sfp_mutex held.
+ */
+static int
+sweepglue(struct glue *g)
+{
+	FILE *fp;
+	int n, nfree;
+
+	nfree = 0;
+	for (; g != NULL; g = g->next) {
+		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++) {
+			if (fp->_flags == 0) {
+				_EXT(fp)->_freenext = freelist;
+				freelist = fp;
+				nfree++;
+			}
+		}
+	}
+	return (nfree);
+}
+
+/*
+ * Puts 'fp' on the list __sfwalk_writable() walks, if it isn't there.
+ * Called with __sfp_mutex held.
+ */
+static void
+writable_add(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+
+	if (ext->_wrprev != NULL)
+		return;
+	ext->_wrnext = writable;
+	ext->_wrprev = &writable;
+	if (writable != NULL)
+		_EXT(writable)->_wrprev = &ext->_wrnext;
+	writable = fp;
+}
+
 /*
  * Find a free FILE for fopen et al.
  */
@@ -114,22 +180,26 @@ __sfp(void)
 		__sinit();
 
 	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
-	for (g = &__sglue; g != NULL; g = g->next) {
-		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
-			if (fp->_flags == 0)
-				goto found;
+	if (freelist == NULL && sweepglue(&__sglue) < niobs / 4) {
+		/* release lock while mallocing */
+		n = niobs < NDYNAMIC ? NDYNAMIC : niobs;
+		_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+		g = moreglue(n);
+		_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+		if (g != NULL) {
+			lastglue->next = g;
+			lastglue = g;
+			niobs += n;
+			sweepglue(g);
+		}
 	}
-
-	/* release lock while mallocing */
-	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
-	if ((g = moreglue(NDYNAMIC)) == NULL)
+	if ((fp = freelist) == NULL) {
+		_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 		return (NULL);
-	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
-	lastglue->next = g;
-	lastglue = g;
-	fp = g->iobs;
-found:
+	}
+	freelist = _EXT(fp)->_freenext;
 	fp->_flags = 1;		/* reserve this slot; caller sets real flags */
+	writable_add(fp);
 	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	fp->_p = NULL;		/* no current pointer */
 	fp->_w = 0;		/* nothing to read or write */
@@ -170,6 +240,56 @@ f_prealloc(void)
 }
 #endif
 
+/*
+ * Puts 'fp' back on the list __sfwalk_writable() walks, for freopen(),
+ * which may turn a FILE open for reading only into one that writes.
+ */
+void
+__sfp_writable(FILE *fp)
+{
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	writable_add(fp);
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+}
+
+/*
+ * Like _fwalk(), but only visits FILEs that may have output to flush,
+ * dropping from the list those that have been released or are open for
+ * reading only. Those can't start writing without going through __sfp()
+ * or freopen(), which put them back.
+ */
+int
+__sfwalk_writable(int (*function)(FILE *))
+{
+	FILE *fp, *next;
+	struct __sfileext *ext;
+	int ret;
+
+	if (!__sdidinit)
+		__sinit();
+
+	ret = 0;
+	for (fp = writable; fp != NULL; fp = next) {
+		ext = _EXT(fp);
+		next = ext->_wrnext;
+		if (!unwritable(fp)) {
+			if ((fp->_flags & __SIGN) == 0)
+				ret |= (*function)(fp);
+			continue;
+		}
+		_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+		/* check again: __sfp() could have reused it meanwhile */
+		if (ext->_wrprev != NULL && unwritable(fp)) {
+			*ext->_wrprev = ext->_wrnext;
+			if (ext->_wrnext != NULL)
+				_EXT(ext->_wrnext)->_wrprev = ext->_wrprev;
+			ext->_wrprev = NULL;
+		}
+		_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
+	}
+	return (ret);
+}
+
 /*
  * exit() calls _cleanup() through *__cleanup, set whenever we
  * open or buffer a file.  This chicanery is done so that programs
@@ -181,7 +301,7 @@ void
 _cleanup(void)
 {
 	/* (void) _fwalk(fclose); */
-	(void) _fwalk(__sflush);		/* `cheating' */
+	(void) __sfwalk_writable(__sflush);	/* `cheating' */
 }
 
 /*
@@ -199,6 +319,14 @@ __sinit(void)
 	for (i = 0; i < FOPEN_MAX - 3; i++) {
 		_FILEEXT_SETUP(usual+i, usualext+i);
 	}
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	for (i = FOPEN_MAX - 3; --i >= 0; ) {
+		usualext[i]._freenext = freelist;
+		freelist = usual + i;
+	}
+	for (i = 3; --i >= 0; )
+		writable_add(__sF + i);
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	/* make sure we clean up on exit */
 	__cleanup = _cleanup; /* conservative */
 	__sdidinit = 1;
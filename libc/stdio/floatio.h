@@ -40,3 +40,7 @@
 #define	MAXEXP		308
 /* 128 bit fraction takes up 39 decimal digits; max reasonable precision */
 #define	MAXFRACT	39
+
+/* Fast path for __dtoa() modes 2 and 3, for up to MAXFASTDIG digits. */
+#define	MAXFASTDIG	17
+__LIBC_HIDDEN__ int __grisu_counted(double, int, char *, int *);
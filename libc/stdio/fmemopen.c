@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "local.h"
+
+/* A stream on a caller's buffer, or on one of ours if 'own' is set. */
+struct fmemopen_cookie {
+	char	*buf;
+	size_t	size;		/* of buf */
+	size_t	len;		/* bytes of buf that hold data */
+	size_t	off;		/* current position */
+	int	own;
+	int	append;
+};
+
+static int
+fmemopen_read(void *cookie, char *buf, int n)
+{
+	struct fmemopen_cookie *mc = cookie;
+
+	if ((size_t)n > mc->len - mc->off)
+		n = (int)(mc->len - mc->off);
+	memcpy(buf, mc->buf + mc->off, (size_t)n);
+	mc->off += (size_t)n;
+	return (n);
+}
+
+static int
+fmemopen_write(void *cookie, const char *buf, int n)
+{
+	struct fmemopen_cookie *mc = cookie;
+
+	if (mc->append)
+		mc->off = mc->len;
+	if ((size_t)n > mc->size - mc->off)
+		n = (int)(mc->size - mc->off);
+	if (n == 0) {
+		errno = ENOSPC;
+		return (-1);
+	}
+	memcpy(mc->buf + mc->off, buf, (size_t)n);
+	mc->off += (size_t)n;
+	if (mc->off > mc->len) {
+		mc->len = mc->off;
+		/* keep the data a string, if there's room */
+		if (mc->len < mc->size)
+			mc->buf[mc->len] = '\0';
+	}
+	return (n);
+}
+
+static fpos_t
+fmemopen_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct fmemopen_cookie *mc = cookie;
+	fpos_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = (fpos_t)mc->off;
+		break;
+	case SEEK_END:
+		base = (fpos_t)mc->len;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < -base || offset > (fpos_t)mc->size - base) {
+		errno = EINVAL;
+		return (-1);
+	}
+	mc->off = (size_t)(base + offset);
+	return ((fpos_t)mc->off);
+}
+
+static int
+fmemopen_close(void *cookie)
+{
+	struct fmemopen_cookie *mc = cookie;
+
+	if (mc->own)
+		free(mc->buf);
+	free(mc);
+	return (0);
+}
+
+/*
+ * Opens a stream on the 'size' bytes at 'buf', or on as many that we
+ * allocate, and free at fclose(), if 'buf' is NULL. Writes past the end
+ * of the buffer fail with ENOSPC.
+ */
+FILE *
+fmemopen(void *buf, size_t size, const char *mode)
+{
+	struct fmemopen_cookie *mc;
+	FILE *fp;
+	int flags, oflags;
+
+	if ((flags = __sflags(mode, &oflags)) == 0)
+		return (NULL);
+	if (size == 0 || (fpos_t)size < 0) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((mc = malloc(sizeof(*mc))) == NULL)
+		return (NULL);
+	mc->own = (buf == NULL);
+	if (mc->own && (buf = calloc(1, size)) == NULL) {
+		free(mc);
+		return (NULL);
+	}
+	mc->buf = buf;
+	mc->size = size;
+	mc->off = 0;
+	mc->append = (oflags & O_APPEND) != 0;
+	if (oflags & O_TRUNC)
+		mc->buf[0] = '\0';
+	if (oflags & (O_TRUNC | O_APPEND))
+		mc->len = strnlen(mc->buf, size);
+	else
+		mc->len = size;
+	if (mc->append)
+		mc->off = mc->len;
+
+	fp = funopen(mc,
+	    (flags & (__SRD | __SRW)) ? fmemopen_read : NULL,
+	    (flags & (__SWR | __SRW)) ? fmemopen_write : NULL,
+	    fmemopen_seek, fmemopen_close);
+	if (fp == NULL) {
+		fmemopen_close(mc);
+		return (NULL);
+	}
+	/*
+	 * Unbuffered, so that a write past the end of the buffer gives a
+	 * short count straight away. There are no system calls to save.
+	 */
+	setvbuf(fp, NULL, _IONBF, 0);
+	return (fp);
+}
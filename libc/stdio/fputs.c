@@ -30,27 +30,17 @@
  * SUCH DAMAGE.
  */
 
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)fputs.c	8.1 (Berkeley) 6/4/93";
-#endif /* LIBC_SCCS and not lint */
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
-
-#include "namespace.h"
 #include <stdio.h>
 #include <string.h>
-#include "un-namespace.h"
 #include "fvwrite.h"
-#include "libc_private.h"
 #include "local.h"
 
 /*
  * Write the given string to the given file.
  */
 int
-fputs(const char * __restrict s, FILE * __restrict fp)
+fputs_unlocked(const char * __restrict s, FILE * __restrict fp)
 {
-	int retval;
 	struct __suio uio;
 	struct __siov iov;
 
@@ -58,9 +48,16 @@ fputs(const char * __restrict s, FILE * __restrict fp)
 	iov.iov_len = uio.uio_resid = strlen(s);
 	uio.uio_iov = &iov;
 	uio.uio_iovcnt = 1;
+	return (__sfvwrite(fp, &uio));
+}
+
+int
+fputs(const char * __restrict s, FILE * __restrict fp)
+{
+	int retval;
+
 	FLOCKFILE(fp);
-	ORIENT(fp, -1);
-	retval = __sfvwrite(fp, &uio);
+	retval = fputs_unlocked(s, fp);
 	FUNLOCKFILE(fp);
 	return (retval);
 }
@@ -45,7 +45,7 @@ lflush(FILE *fp)
 }
 
 size_t
-fread(void *buf, size_t size, size_t count, FILE *fp)
+fread_unlocked(void *buf, size_t size, size_t count, FILE *fp)
 {
     size_t resid;
     char *p;
@@ -59,7 +59,6 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
      */
     if ((resid = count * size) == 0)
         return (0);
-    FLOCKFILE(fp);
     if (fp->_r < 0)
         fp->_r = 0;
     total = resid;
@@ -80,7 +79,6 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
 
         /* SysV does not make this test; take it out for compatibility */
         if (fp->_flags & __SEOF) {
-            FUNLOCKFILE(fp);
             return (EOF);
         }
 
@@ -88,14 +86,12 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
         if ((fp->_flags & __SRD) == 0) {
             if ((fp->_flags & __SRW) == 0) {
                 fp->_flags |= __SERR;
-                FUNLOCKFILE(fp);
                 errno = EBADF;
                 return (EOF);
             }
             /* switch to reading */
             if (fp->_flags & __SWR) {
                 if (__sflush(fp)) {
-                    FUNLOCKFILE(fp);
                     return (EOF);
                 }
                 fp->_flags &= ~__SWR;
@@ -122,9 +118,9 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
          */
 
         if (fp->_flags & (__SLBF|__SNBF)) {
-            /* Ignore this file in _fwalk to deadlock. */
+            /* Ignore this file in __sfwalk_writable to deadlock. */
             fp->_flags |= __SIGN;
-            (void) _fwalk(lflush);
+            (void) __sfwalk_writable(lflush);
             fp->_flags &= ~__SIGN;
 
             /* Now flush this file without locking it. */
@@ -141,13 +137,11 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
                 else {
                     fp->_flags |= __SERR;
                 }
-                FUNLOCKFILE(fp);
                 return ((total - resid) / size);
             }
             p     += len;
             resid -= len;
         }
-        FUNLOCKFILE(fp);
         return (count);
     }
     else
@@ -161,7 +155,6 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
             resid -= r;
             if (__srefill(fp)) {
                 /* no more input: return partial result */
-                FUNLOCKFILE(fp);
                 return ((total - resid) / size);
             }
         }
@@ -170,6 +163,16 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
     (void)memcpy((void *)p, (void *)fp->_p, resid);
     fp->_r -= resid;
     fp->_p += resid;
-    FUNLOCKFILE(fp);
     return (count);
 }
+
+size_t
+fread(void *buf, size_t size, size_t count, FILE *fp)
+{
+    size_t ret;
+
+    FLOCKFILE(fp);
+    ret = fread_unlocked(buf, size, count, fp);
+    FUNLOCKFILE(fp);
+    return (ret);
+}
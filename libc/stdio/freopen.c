@@ -142,6 +142,7 @@ freopen(const char *file, const char *mode, FILE *fp)
 	}
 
 	fp->_flags = flags;
+	__sfp_writable(fp);
 	fp->_file = f;
 	fp->_cookie = fp;
 	fp->_read = __sread;
@@ -31,13 +31,58 @@
  * SUCH DAMAGE.
  */
 
+#include <sys/uio.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include "local.h"
 #include "fvwrite.h"
 
+/*
+ * Empties the buffer of a stream on a file descriptor and writes up to 'len'
+ * bytes from 'p' after it, all with one writev(), so that a large write
+ * isn't copied into the buffer first. Writes no more than keeps the file
+ * position a multiple of the buffer size. Returns how many bytes from 'p'
+ * were written, or -1 on error.
+ */
+static int
+__swritev(FILE *fp, const char *p, size_t len)
+{
+	struct iovec iov[2];
+	int n = fp->_p - fp->_bf._base;
+	int size = fp->_bf._size;
+	int r;
+
+	if (len > (size_t)(INT_MAX - n))
+		len = INT_MAX - n;
+	len -= (n + len) % size;
+
+	if (fp->_flags & __SAPP)
+		(void) lseek(fp->_file, (off_t)0, SEEK_END);
+	fp->_flags &= ~__SOFF;	/* in case FAPPEND mode is set */
+	iov[0].iov_base = fp->_bf._base;
+	iov[0].iov_len = n;
+	iov[1].iov_base = (void *)p;
+	iov[1].iov_len = len;
+	r = writev(fp->_file, iov, 2);
+	if (r <= 0)
+		return (-1);
+	if (r < n) {
+		/* short write: keep the rest of the buffer and flush it */
+		n -= r;
+		memmove(fp->_bf._base, fp->_bf._base + r, n);
+		fp->_p = fp->_bf._base + n;
+		fp->_w = size - n;
+		return (__sflush(fp) ? -1 : 0);
+	}
+	fp->_p = fp->_bf._base;
+	fp->_w = size;
+	return (r - n);
+}
+
 /*
  * Write some memory regions.  Return zero on success, EOF on error.
  *
@@ -133,6 +178,12 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 				fp->_w -= w;
 				fp->_p += w;
 				w = len;	/* but pretend copied all */
+			} else if (fp->_p > fp->_bf._base &&
+			    len >= (size_t)fp->_bf._size &&
+			    fp->_write == __swrite) {
+				/* flush and write directly, together */
+				if ((w = __swritev(fp, p, len)) < 0)
+					goto err;
 			} else if (fp->_p > fp->_bf._base && (int)len > w) {
 				/* fill and flush */
 				COPY(w);
@@ -141,8 +192,9 @@ __sfvwrite(FILE *fp, struct __suio *uio)
 				if (fflush(fp))
 					goto err;
 			} else if ((int)len >= (w = fp->_bf._size)) {
-				/* write directly */
-				w = (*fp->_write)(fp->_cookie, p, w);
+				/* write directly, as many whole buffers as fit */
+				w = (*fp->_write)(fp->_cookie, p,
+				    MIN(len, (size_t)INT_MAX) / w * w);
 				if (w <= 0)
 					goto err;
 			} else {
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2010 the V8 project authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Grisu3 in "counted" mode, from the double-conversion library: the first
+ * n significant digits of a double, correctly rounded, using only 64-bit
+ * integer arithmetic. It gives up, rather than guess, on the few inputs
+ * (about 0.5% of them) whose rounding it can't decide, including exact
+ * ties, and vfprintf's cvt() then falls back to __dtoa().
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "floatio.h"
+
+/* A 64-bit significand and a binary exponent: f * 2^e. */
+struct diyfp {
+	uint64_t f;
+	int e;
+};
+
+/* Normalized approximations of 10^-348, 10^-340, ..., 10^340. */
+static const struct {
+	uint64_t f;
+	int16_t e;
+	int16_t k;
+} cached_powers[] = {
+	{ UINT64_C(0xfa8fd5a0081c0288), -1220, -348 },
+	{ UINT64_C(0xbaaee17fa23ebf76), -1193, -340 },
+	{ UINT64_C(0x8b16fb203055ac76), -1166, -332 },
+	{ UINT64_C(0xcf42894a5dce35ea), -1140, -324 },
+	{ UINT64_C(0x9a6bb0aa55653b2d), -1113, -316 },
+	{ UINT64_C(0xe61acf033d1a45df), -1087, -308 },
+	{ UINT64_C(0xab70fe17c79ac6ca), -1060, -300 },
+	{ UINT64_C(0xff77b1fcbebcdc4f), -1034, -292 },
+	{ UINT64_C(0xbe5691ef416bd60c), -1007, -284 },
+	{ UINT64_C(0x8dd01fad907ffc3c), -980, -276 },
+	{ UINT64_C(0xd3515c2831559a83), -954, -268 },
+	{ UINT64_C(0x9d71ac8fada6c9b5), -927, -260 },
+	{ UINT64_C(0xea9c227723ee8bcb), -901, -252 },
+	{ UINT64_C(0xaecc49914078536d), -874, -244 },
+	{ UINT64_C(0x823c12795db6ce57), -847, -236 },
+	{ UINT64_C(0xc21094364dfb5637), -821, -228 },
+	{ UINT64_C(0x9096ea6f3848984f), -794, -220 },
+	{ UINT64_C(0xd77485cb25823ac7), -768, -212 },
+	{ UINT64_C(0xa086cfcd97bf97f4), -741, -204 },
+	{ UINT64_C(0xef340a98172aace5), -715, -196 },
+	{ UINT64_C(0xb23867fb2a35b28e), -688, -188 },
+	{ UINT64_C(0x84c8d4dfd2c63f3b), -661, -180 },
+	{ UINT64_C(0xc5dd44271ad3cdba), -635, -172 },
+	{ UINT64_C(0x936b9fcebb25c996), -608, -164 },
+	{ UINT64_C(0xdbac6c247d62a584), -582, -156 },
+	{ UINT64_C(0xa3ab66580d5fdaf6), -555, -148 },
+	{ UINT64_C(0xf3e2f893dec3f126), -529, -140 },
+	{ UINT64_C(0xb5b5ada8aaff80b8), -502, -132 },
+	{ UINT64_C(0x87625f056c7c4a8b), -475, -124 },
+	{ UINT64_C(0xc9bcff6034c13053), -449, -116 },
+	{ UINT64_C(0x964e858c91ba2655), -422, -108 },
+	{ UINT64_C(0xdff9772470297ebd), -396, -100 },
+	{ UINT64_C(0xa6dfbd9fb8e5b88f), -369, -92 },
+	{ UINT64_C(0xf8a95fcf88747d94), -343, -84 },
+	{ UINT64_C(0xb94470938fa89bcf), -316, -76 },
+	{ UINT64_C(0x8a08f0f8bf0f156b), -289, -68 },
+	{ UINT64_C(0xcdb02555653131b6), -263, -60 },
+	{ UINT64_C(0x993fe2c6d07b7fac), -236, -52 },
+	{ UINT64_C(0xe45c10c42a2b3b06), -210, -44 },
+	{ UINT64_C(0xaa242499697392d3), -183, -36 },
+	{ UINT64_C(0xfd87b5f28300ca0e), -157, -28 },
+	{ UINT64_C(0xbce5086492111aeb), -130, -20 },
+	{ UINT64_C(0x8cbccc096f5088cc), -103, -12 },
+	{ UINT64_C(0xd1b71758e219652c), -77, -4 },
+	{ UINT64_C(0x9c40000000000000), -50, 4 },
+	{ UINT64_C(0xe8d4a51000000000), -24, 12 },
+	{ UINT64_C(0xad78ebc5ac620000), 3, 20 },
+	{ UINT64_C(0x813f3978f8940984), 30, 28 },
+	{ UINT64_C(0xc097ce7bc90715b3), 56, 36 },
+	{ UINT64_C(0x8f7e32ce7bea5c70), 83, 44 },
+	{ UINT64_C(0xd5d238a4abe98068), 109, 52 },
+	{ UINT64_C(0x9f4f2726179a2245), 136, 60 },
+	{ UINT64_C(0xed63a231d4c4fb27), 162, 68 },
+	{ UINT64_C(0xb0de65388cc8ada8), 189, 76 },
+	{ UINT64_C(0x83c7088e1aab65db), 216, 84 },
+	{ UINT64_C(0xc45d1df942711d9a), 242, 92 },
+	{ UINT64_C(0x924d692ca61be758), 269, 100 },
+	{ UINT64_C(0xda01ee641a708dea), 295, 108 },
+	{ UINT64_C(0xa26da3999aef774a), 322, 116 },
+	{ UINT64_C(0xf209787bb47d6b85), 348, 124 },
+	{ UINT64_C(0xb454e4a179dd1877), 375, 132 },
+	{ UINT64_C(0x865b86925b9bc5c2), 402, 140 },
+	{ UINT64_C(0xc83553c5c8965d3d), 428, 148 },
+	{ UINT64_C(0x952ab45cfa97a0b3), 455, 156 },
+	{ UINT64_C(0xde469fbd99a05fe3), 481, 164 },
+	{ UINT64_C(0xa59bc234db398c25), 508, 172 },
+	{ UINT64_C(0xf6c69a72a3989f5c), 534, 180 },
+	{ UINT64_C(0xb7dcbf5354e9bece), 561, 188 },
+	{ UINT64_C(0x88fcf317f22241e2), 588, 196 },
+	{ UINT64_C(0xcc20ce9bd35c78a5), 614, 204 },
+	{ UINT64_C(0x98165af37b2153df), 641, 212 },
+	{ UINT64_C(0xe2a0b5dc971f303a), 667, 220 },
+	{ UINT64_C(0xa8d9d1535ce3b396), 694, 228 },
+	{ UINT64_C(0xfb9b7cd9a4a7443c), 720, 236 },
+	{ UINT64_C(0xbb764c4ca7a44410), 747, 244 },
+	{ UINT64_C(0x8bab8eefb6409c1a), 774, 252 },
+	{ UINT64_C(0xd01fef10a657842c), 800, 260 },
+	{ UINT64_C(0x9b10a4e5e9913129), 827, 268 },
+	{ UINT64_C(0xe7109bfba19c0c9d), 853, 276 },
+	{ UINT64_C(0xac2820d9623bf429), 880, 284 },
+	{ UINT64_C(0x80444b5e7aa7cf85), 907, 292 },
+	{ UINT64_C(0xbf21e44003acdd2d), 933, 300 },
+	{ UINT64_C(0x8e679c2f5e44ff8f), 960, 308 },
+	{ UINT64_C(0xd433179d9c8cb841), 986, 316 },
+	{ UINT64_C(0x9e19db92b4e31ba9), 1013, 324 },
+	{ UINT64_C(0xeb96bf6ebadf77d9), 1039, 332 },
+	{ UINT64_C(0xaf87023b9bf0ee6b), 1066, 340 },
+};
+
+#define	CACHED_POWERS_OFFSET	348	/* -cached_powers[0].k */
+#define	DECIMAL_EXPONENT_DISTANCE 8
+#define	MIN_TARGET_EXPONENT	(-60)
+
+static const uint32_t small_powers_of_ten[] = {
+	0, 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000
+};
+
+/* Rounds a.f * b.f / 2^64 to nearest. */
+static struct diyfp
+diyfp_times(struct diyfp x, struct diyfp y)
+{
+	const uint64_t m32 = 0xffffffffU;
+	uint64_t a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32) + (1U << 31);
+	struct diyfp r;
+
+	r.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+	r.e = x.e + y.e + 64;
+	return (r);
+}
+
+/*
+ * Handles the last digit of 'buf': the part of w left over is 'rest', out
+ * of 'ten_kappa' for a whole unit of that digit, and w is off by less
+ * than 'unit'. Rounds the digit up if that is certainly right, and
+ * returns 0 if it can't tell.
+ */
+static int
+round_weed_counted(char *buf, int len, uint64_t rest, uint64_t ten_kappa,
+    uint64_t unit, int *kappa)
+{
+	int i;
+
+	/* the error is too big to say anything about the last digit */
+	if (unit >= ten_kappa || ten_kappa - unit <= unit)
+		return (0);
+	/* 2 * (rest + unit) <= 10^kappa: rounding down is right */
+	if (ten_kappa - rest > rest && ten_kappa - 2 * rest >= 2 * unit)
+		return (1);
+	/* 2 * (rest - unit) >= 10^kappa: rounding up is right */
+	if (rest > unit && ten_kappa - (rest - unit) <= rest - unit) {
+		buf[len - 1]++;
+		for (i = len - 1; i > 0 && buf[i] == '0' + 10; i--) {
+			buf[i] = '0';
+			buf[i - 1]++;
+		}
+		/* all nines: 999 became 1000, which fits as "100" */
+		if (buf[0] == '0' + 10) {
+			buf[0] = '1';
+			(*kappa)++;
+		}
+		return (1);
+	}
+	return (0);
+}
+
+/*
+ * Generates 'ndigits' digits of w, which is off by less than one unit in
+ * its last place and whose exponent is between -60 and -32.
+ */
+static int
+digit_gen_counted(struct diyfp w, int ndigits, char *buf, int *kappa)
+{
+	struct diyfp one;
+	uint64_t fractionals, w_error = 1;
+	uint32_t integrals, divisor;
+	int len = 0;
+
+	one.f = (uint64_t)1 << -w.e;
+	one.e = w.e;
+	integrals = (uint32_t)(w.f >> -one.e);
+	fractionals = w.f & (one.f - 1);
+
+	/* the biggest power of ten that is <= integrals (which is >= 8) */
+	*kappa = ((64 - (-one.e) + 1) * 1233 >> 12) + 1;
+	if (integrals < small_powers_of_ten[*kappa])
+		(*kappa)--;
+	divisor = small_powers_of_ten[*kappa];
+
+	while (*kappa > 0) {
+		buf[len++] = (char)('0' + integrals / divisor);
+		integrals %= divisor;
+		(*kappa)--;
+		if (--ndigits == 0)
+			break;
+		divisor /= 10;
+	}
+	if (ndigits == 0)
+		return (round_weed_counted(buf, len,
+		    ((uint64_t)integrals << -one.e) + fractionals,
+		    (uint64_t)divisor << -one.e, w_error, kappa) ? len : 0);
+
+	while (ndigits > 0 && fractionals > w_error) {
+		fractionals *= 10;
+		w_error *= 10;
+		buf[len++] = (char)('0' + (fractionals >> -one.e));
+		fractionals &= one.f - 1;
+		(*kappa)--;
+		ndigits--;
+	}
+	if (ndigits != 0)
+		return (0);
+	return (round_weed_counted(buf, len, fractionals, one.f, w_error,
+	    kappa) ? len : 0);
+}
+
+/*
+ * Puts the first 'ndigits' (1 to 17) significant digits of finite, positive
+ * 'value', correctly rounded, in 'buf', and sets '*decpt' as __dtoa()
+ * does. Returns how many digits that is, or 0 if __dtoa() has to decide.
+ */
+__LIBC_HIDDEN__ int
+__grisu_counted(double value, int ndigits, char *buf, int *decpt)
+{
+	struct diyfp w, ten_mk;
+	uint64_t bits;
+	int biased_e, k, index, kappa, len;
+
+	memcpy(&bits, &value, sizeof(bits));
+	biased_e = (int)((bits >> 52) & 0x7ff);
+	w.f = bits & (((uint64_t)1 << 52) - 1);
+	if (biased_e == 0)
+		w.e = 1 - 1075;		/* subnormal */
+	else {
+		w.f |= (uint64_t)1 << 52;
+		w.e = biased_e - 1075;
+	}
+	if (w.f == 0 || biased_e == 0x7ff)
+		return (0);
+	while ((w.f & ((uint64_t)1 << 63)) == 0) {
+		w.f <<= 1;
+		w.e--;
+	}
+
+	/*
+	 * Scale w by a cached 10^-k that brings its exponent to between
+	 * -60 and -32. k = ceil((MIN_TARGET_EXPONENT - w.e - 1) * log10(2)),
+	 * with 78913 / 2^18 standing in for log10(2): exact for the
+	 * exponents we meet, and it keeps libm out of stdio.
+	 */
+	k = -(((w.e + 1 - MIN_TARGET_EXPONENT) * 78913) >> 18);
+	index = (CACHED_POWERS_OFFSET + k - 1) / DECIMAL_EXPONENT_DISTANCE + 1;
+	ten_mk.f = cached_powers[index].f;
+	ten_mk.e = cached_powers[index].e;
+
+	len = digit_gen_counted(diyfp_times(w, ten_mk), ndigits, buf, &kappa);
+	if (len == 0)
+		return (0);
+	*decpt = len - cached_powers[index].k + kappa;
+	return (len);
+}
@@ -54,9 +54,12 @@ void	_cleanup(void);
 void	__smakebuf(FILE *);
 int	__swhatbuf(FILE *, size_t *, int *);
 int	_fwalk(int (*)(FILE *));
+int	__sfwalk_writable(int (*)(FILE *));
+void	__sfp_writable(FILE *);
 int	__swsetup(FILE *);
 int	__sflags(const char *, int *);
 int	__vfprintf(FILE *, const char *, __va_list);
+int	__vfwprintf(FILE *, const wchar_t *, __va_list);
 
 /*
  * Function to clean up streams, called from abort() and exit().
@@ -91,5 +94,5 @@ extern int __sdidinit;
 	(fp)->_lb._base = NULL; \
 }
 
-#define FLOCKFILE(fp)   do { if (__isthreaded) flockfile(fp); } while (0)
-#define FUNLOCKFILE(fp) do { if (__isthreaded) funlockfile(fp); } while (0)
+#define FLOCKFILE(fp)   do { if (__isthreaded && !_EXT(fp)->_caller_locks) flockfile(fp); } while (0)
+#define FUNLOCKFILE(fp) do { if (__isthreaded && !_EXT(fp)->_caller_locks) funlockfile(fp); } while (0)
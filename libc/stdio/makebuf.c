@@ -30,29 +30,56 @@
  * SUCH DAMAGE.
  */
 
-#if defined(LIBC_SCCS) && !defined(lint)
-static char sccsid[] = "@(#)makebuf.c	8.1 (Berkeley) 6/4/93";
-#endif /* LIBC_SCCS and not lint */
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
-
-#include "namespace.h"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include "un-namespace.h"
-
-#include "libc_private.h"
 #include "local.h"
 
+/*
+ * Buffers that stdio allocates itself are at least _STDIO_BUFSIZ_MIN bytes,
+ * since st_blksize is only 4KiB on most filesystems and BUFSIZ (kept at 1KiB
+ * for the callers of setbuf()) less still, which makes reading or writing a
+ * file through stdio a system call per few lines. They grow with st_blksize
+ * up to _STDIO_BUFSIZ_MAX. A process can instead have all its buffers be the
+ * size given by the BIONIC_STDIO_BUFSIZ environment variable.
+ */
+#define	_STDIO_BUFSIZ_MIN	(16 * 1024)
+#define	_STDIO_BUFSIZ_MAX	(64 * 1024)
+#define	_STDIO_BUFSIZ_ENV	"BIONIC_STDIO_BUFSIZ"
+
+static size_t
+__sbufsize(size_t blksize)
+{
+	static size_t override = (size_t)-1;
+
+	/* racing threads all find the same value */
+	if (override == (size_t)-1) {
+		const char *env = getenv(_STDIO_BUFSIZ_ENV);
+		long size = env != NULL ? atol(env) : 0;
+
+		if (size > 0 && size < BUFSIZ)
+			size = BUFSIZ;
+		if (size > 1024 * 1024)
+			size = 1024 * 1024;
+		override = size > 0 ? (size_t)size : 0;
+	}
+	if (override != 0)
+		return (override);
+	if (blksize < _STDIO_BUFSIZ_MIN)
+		return (_STDIO_BUFSIZ_MIN);
+	if (blksize > _STDIO_BUFSIZ_MAX)
+		return (_STDIO_BUFSIZ_MAX);
+	return (blksize);
+}
+
 /*
  * Allocate a file buffer, or switch to unbuffered I/O.
  * Per the ANSI C standard, ALL tty devices default to line buffered.
  *
  * As a side effect, we set __SOPT or __SNPT (en/dis-able fseek
- * optimisation) right after the _fstat() that finds the buffer size.
+ * optimisation) right after the fstat() that finds the buffer size.
  */
 void
 __smakebuf(FILE *fp)
@@ -91,16 +118,16 @@ __swhatbuf(FILE *fp, size_t *bufsize, int *couldbetty)
 {
 	struct stat st;
 
-	if (fp->_file < 0 || _fstat(fp->_file, &st) < 0) {
+	if (fp->_file < 0 || fstat(fp->_file, &st) < 0) {
 		*couldbetty = 0;
-		*bufsize = BUFSIZ;
+		*bufsize = __sbufsize(BUFSIZ);
 		return (__SNPT);
 	}
 
 	/* could be a tty iff it is a character device */
 	*couldbetty = (st.st_mode & S_IFMT) == S_IFCHR;
 	if (st.st_blksize <= 0) {
-		*bufsize = BUFSIZ;
+		*bufsize = __sbufsize(BUFSIZ);
 		return (__SNPT);
 	}
 
@@ -109,7 +136,7 @@ __swhatbuf(FILE *fp, size_t *bufsize, int *couldbetty)
 	 * __sseek is mainly paranoia.)  It is safe to set _blksize
 	 * unconditionally; it will only be used if __SOPT is also set.
 	 */
-	*bufsize = st.st_blksize;
+	*bufsize = __sbufsize(st.st_blksize);
 	fp->_blksize = st.st_blksize;
 	return ((st.st_mode & S_IFMT) == S_IFREG && fp->_seek == __sseek ?
 	    __SOPT : __SNPT);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "local.h"
+
+#define	MEMSTREAM_MINSIZE 64
+
+struct memstream {
+	char	**bufp;		/* caller's copies of buf... */
+	size_t	*sizep;		/* ...and of the size they may look at */
+	char	*buf;		/* always holds len bytes and a NUL */
+	size_t	cap;		/* bytes buf has room for, besides the NUL */
+	size_t	len;		/* bytes written */
+	size_t	off;		/* current position */
+};
+
+static void
+memstream_update(struct memstream *ms)
+{
+	*ms->bufp = ms->buf;
+	*ms->sizep = ms->off < ms->len ? ms->off : ms->len;
+}
+
+/* Makes room for 'need' bytes, at least doubling buf so writes stay O(1). */
+static int
+memstream_grow(struct memstream *ms, size_t need)
+{
+	size_t cap;
+	char *buf;
+
+	if (need <= ms->cap)
+		return (0);
+	cap = ms->cap < SIZE_MAX / 2 ? ms->cap * 2 : SIZE_MAX - 1;
+	if (cap < need)
+		cap = need;
+	if ((buf = realloc(ms->buf, cap + 1)) == NULL)
+		return (-1);
+	ms->buf = buf;
+	ms->cap = cap;
+	return (0);
+}
+
+static int
+memstream_write(void *cookie, const char *buf, int n)
+{
+	struct memstream *ms = cookie;
+
+	if ((size_t)n >= SIZE_MAX - ms->off) {
+		errno = EFBIG;
+		return (-1);
+	}
+	if (memstream_grow(ms, ms->off + (size_t)n) == -1)
+		return (-1);
+	/* a gap left by seeking past the end reads as NULs */
+	if (ms->off > ms->len)
+		memset(ms->buf + ms->len, 0, ms->off - ms->len);
+	memcpy(ms->buf + ms->off, buf, (size_t)n);
+	ms->off += (size_t)n;
+	if (ms->off > ms->len) {
+		ms->len = ms->off;
+		ms->buf[ms->len] = '\0';
+	}
+	memstream_update(ms);
+	return (n);
+}
+
+static fpos_t
+memstream_seek(void *cookie, fpos_t offset, int whence)
+{
+	struct memstream *ms = cookie;
+	fpos_t base;
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = (fpos_t)ms->off;
+		break;
+	case SEEK_END:
+		base = (fpos_t)ms->len;
+		break;
+	default:
+		errno = EINVAL;
+		return (-1);
+	}
+	if (offset < -base) {
+		errno = EINVAL;
+		return (-1);
+	}
+	ms->off = (size_t)(base + offset);
+	memstream_update(ms);
+	return ((fpos_t)ms->off);
+}
+
+static int
+memstream_close(void *cookie)
+{
+	struct memstream *ms = cookie;
+
+	memstream_update(ms);
+	free(ms);
+	return (0);
+}
+
+/*
+ * Opens a stream that writes to a buffer it grows as needed. After each
+ * fflush() and at fclose(), '*bufp' points at the data, NUL-terminated,
+ * and '*sizep' says how much of it there is up to the current position.
+ * The caller frees '*bufp' once the stream is closed.
+ */
+FILE *
+open_memstream(char **bufp, size_t *sizep)
+{
+	struct memstream *ms;
+	FILE *fp;
+
+	if (bufp == NULL || sizep == NULL) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((ms = malloc(sizeof(*ms))) == NULL)
+		return (NULL);
+	if ((ms->buf = malloc(MEMSTREAM_MINSIZE + 1)) == NULL) {
+		free(ms);
+		return (NULL);
+	}
+	ms->buf[0] = '\0';
+	ms->cap = MEMSTREAM_MINSIZE;
+	ms->len = 0;
+	ms->off = 0;
+	ms->bufp = bufp;
+	ms->sizep = sizep;
+
+	fp = funopen(ms, NULL, memstream_write, memstream_seek,
+	    memstream_close);
+	if (fp == NULL) {
+		free(ms->buf);
+		free(ms);
+		return (NULL);
+	}
+	memstream_update(ms);
+	return (fp);
+}
@@ -50,11 +50,74 @@
 
 #include "local.h"
 #include "fvwrite.h"
+#include "private/bionic_name_mem.h"
 
-static void __find_arguments(const char *fmt0, va_list ap, va_list **argtable,
-    size_t *argtablesiz);
+/*
+ * BIONIC: vfwprintf.c builds the wide-character printf from this same code
+ * by defining PRINTF_WIDE first. Every character is one byte here, as
+ * fputwc() has it, so converting between char and wchar_t is a cast.
+ */
+#ifdef PRINTF_WIDE
+#include <wchar.h>
+#define	CHAR_T		wchar_t
+#define	OTHER_T		char
+#define	OTHER_S		0	/* %s is a char string, %ls our own */
+#define	STR(s)		L##s
+#define	MEMCHR		wmemchr
+#define	STRLEN		wcslen
+#define	ORIENTATION	1
+#define	VFPRINTF	vfwprintf
+#define	__VFPRINTF	__vfwprintf
+#else
+#define	CHAR_T		char
+#define	OTHER_T		wchar_t
+#define	OTHER_S		LONGINT	/* %ls is a wchar_t string */
+#define	STR(s)		s
+#define	MEMCHR		memchr
+#define	STRLEN		strlen
+#define	ORIENTATION	-1
+#define	VFPRINTF	vfprintf
+#define	__VFPRINTF	__vfprintf
+#endif
+
+static void __find_arguments(const CHAR_T *fmt0, va_list ap,
+    va_list **argtable, size_t *argtablesiz);
 static int __grow_type_table(unsigned char **typetable, int *tablesize);
 
+#ifdef PRINTF_WIDE
+/*
+ * Flush out all the vectors defined by the given uio, whose lengths count
+ * wide characters, then reset it so that it can be reused.
+ */
+static int
+__sprint(FILE *fp, struct __suio *uio)
+{
+	char cbuf[128];
+	struct __siov ciov;
+	struct __suio cuio;
+	const wchar_t *ws;
+	size_t len;
+	int i, n, err;
+
+	ciov.iov_base = cbuf;
+	cuio.uio_iov = &ciov;
+	cuio.uio_iovcnt = 1;
+	err = 0;
+	for (i = 0; i < uio->uio_iovcnt && err == 0; i++) {
+		ws = uio->uio_iov[i].iov_base;
+		len = uio->uio_iov[i].iov_len;
+		while (len > 0 && err == 0) {
+			for (n = 0; n < (int)sizeof(cbuf) && len > 0; n++, len--)
+				cbuf[n] = (char)*ws++;
+			ciov.iov_len = cuio.uio_resid = n;
+			err = __sfvwrite(fp, &cuio);
+		}
+	}
+	uio->uio_resid = 0;
+	uio->uio_iovcnt = 0;
+	return (err);
+}
+#else
 /*
  * Flush out all the vectors defined by the given uio,
  * then reset it so that it can be reused.
@@ -73,6 +136,35 @@ __sprint(FILE *fp, struct __suio *uio)
 	uio->uio_iovcnt = 0;
 	return (err);
 }
+#endif
+
+/*
+ * Copies a string of the other character type, stopping after 'prec'
+ * characters unless that's negative, into 'buf' if it fits in 'bufsiz'
+ * characters or else into memory from malloc(). Returns the copy and sets
+ * '*sizep' to its length, or returns NULL if there was no memory.
+ */
+static CHAR_T *
+__sconv(const OTHER_T *s, int prec, CHAR_T *buf, int bufsiz, int *sizep)
+{
+	CHAR_T *cs;
+	int i, n;
+
+	for (n = 0; n != prec && s[n] != 0; n++)
+		continue;
+	cs = buf;
+	if (n > bufsiz && (cs = malloc(n * sizeof(*cs))) == NULL)
+		return (NULL);
+	for (i = 0; i < n; i++) {
+#ifdef PRINTF_WIDE
+		cs[i] = (unsigned char)s[i];
+#else
+		cs[i] = (char)s[i];
+#endif
+	}
+	*sizep = n;
+	return (cs);
+}
 
 /*
  * Helper function for `fprintf to unbuffered unix file': creates a
@@ -80,7 +172,7 @@ __sprint(FILE *fp, struct __suio *uio)
  * worries about ungetc buffers and so forth.
  */
 static int
-__sbprintf(FILE *fp, const char *fmt, va_list ap)
+__sbprintf(FILE *fp, const CHAR_T *fmt, va_list ap)
 {
 	int ret;
 	FILE fake;
@@ -100,7 +192,7 @@ __sbprintf(FILE *fp, const char *fmt, va_list ap)
 	fake._lbfsize = 0;	/* not actually used, but Just In Case */
 
 	/* do the work, then copy any error status */
-	ret = __vfprintf(&fake, fmt, ap);
+	ret = __VFPRINTF(&fake, fmt, ap);
 	if (ret >= 0 && __sflush(&fake))
 		ret = EOF;
 	if (fake._flags & __SERR)
@@ -117,8 +209,8 @@ __sbprintf(FILE *fp, const char *fmt, va_list ap)
 #define	BUF		(MAXEXP+MAXFRACT+1)	/* + decimal point */
 #define	DEFPREC		6
 
-static char *cvt(double, int, int, char *, int *, int, int *);
-static int exponent(char *, int, int);
+static char *cvt(double, int, int, char *, int *, int, int *, char *);
+static int exponent(CHAR_T *, int, int);
 #else /* no FLOATING_POINT */
 #define	BUF		40
 #endif /* FLOATING_POINT */
@@ -138,6 +230,12 @@ static  int  _my_isnan(double);
 #define is_digit(c)	((unsigned)to_digit(c) <= 9)
 #define	to_char(n)	((n) + '0')
 
+/* BIONIC: "00" to "99", for converting decimals two digits at a time */
+static const CHAR_T digits2[200] = STR(
+	"00010203040506070809101112131415161718192021222324252627282930313233"
+	"34353637383940414243444546474849505152535455565758596061626364656667"
+	"6869707172737475767778798081828384858687888990919293949596979899");
+
 /*
  * Flags used during conversion.
  */
@@ -156,40 +254,46 @@ static  int  _my_isnan(double);
 #define MAXINT		0x1000		/* largest integer size (intmax_t) */
 
 int
-vfprintf(FILE *fp, const char *fmt0, __va_list ap)
+VFPRINTF(FILE *fp, const CHAR_T *fmt0, __va_list ap)
 {
 	int ret;
 
 	FLOCKFILE(fp);
-	ret = __vfprintf(fp, fmt0, ap);
+	ret = __VFPRINTF(fp, fmt0, ap);
 	FUNLOCKFILE(fp);
 	return (ret);
 }
 
 int
-__vfprintf(FILE *fp, const char *fmt0, __va_list ap)
+__VFPRINTF(FILE *fp, const CHAR_T *fmt0, __va_list ap)
 {
-	char *fmt;	/* format string */
+	CHAR_T *fmt;	/* format string */
 	int ch;	/* character from fmt */
 	int n, m, n2;	/* handy integers (short term usage) */
-	char *cp;	/* handy char pointer (short term usage) */
-	char *cp_free = NULL;  /* BIONIC: copy of cp to be freed after usage */
+	u_int u32;	/* handy 32-bit value for decimal conversion */
+	CHAR_T *cp;	/* handy char pointer (short term usage) */
+	CHAR_T *cp_free = NULL;  /* BIONIC: copy of cp to be freed after usage */
+	const OTHER_T *ocp;	/* %s argument of the other character type */
 	struct __siov *iovp;/* for PRINT macro */
+	int strout;	/* BIONIC: PRINT copies straight into fp's buffer */
+	int sn;		/* for PRINT macro, in that case */
 	int flags;	/* flags as above */
 	int ret;		/* return value accumulator */
 	int width;		/* width from format (%8d), or 0 */
 	int prec;		/* precision from format (%.3d), or -1 */
-	char sign;		/* sign prefix (' ', '+', '-', or \0) */
+	CHAR_T sign;		/* sign prefix (' ', '+', '-', or \0) */
 	wchar_t wc;
 	void* ps;
 #ifdef FLOATING_POINT
-	char *decimal_point = ".";
+	CHAR_T *decimal_point = STR(".");
 	char softsign;		/* temporary negative sign for floats */
 	double _double = 0.;	/* double precision arguments %[eEfgG] */
 	int expt;		/* integer value of exponent */
 	int expsize = 0;	/* character count for expstr */
 	int ndig;		/* actual number of digits returned by cvt */
-	char expstr[7];		/* buffer for exponent string */
+	CHAR_T expstr[7];	/* buffer for exponent string */
+	char fdigits[MAXFASTDIG + 2]; /* cvt()'s digits, unless it mallocs */
+	char *dtoaresult;	/* cvt()'s digits, wherever they are */
 #endif
 
 	uintmax_t _umax;	/* integer arguments %[diouxX] */
@@ -197,12 +301,12 @@ __vfprintf(FILE *fp, const char *fmt0, __va_list ap)
 	int dprec;		/* a copy of prec if [diouxX], 0 otherwise */
 	int realsz;		/* field size expanded by dprec */
 	int size;		/* size of converted field or string */
-	char* xdigs = NULL;		/* digits for [xX] conversion */
+	CHAR_T *xdigs = NULL;	/* digits for [xX] conversion */
 #define NIOV 8
 	struct __suio uio;	/* output information: summary */
 	struct __siov iov[NIOV];/* ... and individual io vectors */
-	char buf[BUF];		/* space for %c, %[diouxX], %[eEfgG] */
-	char ox[2];		/* space for 0x hex-prefix */
+	CHAR_T buf[BUF];	/* space for %c, %[diouxX], %[eEfgG] */
+	CHAR_T ox[2];		/* space for 0x hex-prefix */
 	va_list *argtable;	/* args, built due to positional arg */
 	va_list statargtable[STATIC_ARG_TBL_SIZE];
 	size_t argtablesiz;
@@ -214,15 +318,25 @@ __vfprintf(FILE *fp, const char *fmt0, __va_list ap)
 	 * below longer.
 	 */
 #define	PADSIZE	16		/* pad chunk size */
-	static const char blanks[PADSIZE] =
+	static const CHAR_T blanks[PADSIZE] =
 	 {' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' ',' '};
-	static const char zeroes[PADSIZE] =
+	static const CHAR_T zeroes[PADSIZE] =
 	 {'0','0','0','0','0','0','0','0','0','0','0','0','0','0','0','0'};
 
 	/*
 	 * BEWARE, these `goto error' on error, and PAD uses `n'.
 	 */
 #define	PRINT(ptr, len) do { \
+	if (strout) { \
+		/* what __sfvwrite() does with strings, less the uio */ \
+		sn = (len) * (int)sizeof(CHAR_T); \
+		if (sn > fp->_w) \
+			sn = fp->_w; \
+		memcpy(fp->_p, (ptr), sn); \
+		fp->_p += sn; \
+		fp->_w -= sn; \
+		break; \
+	} \
 	iovp->iov_base = (ptr); \
 	iovp->iov_len = (len); \
 	uio.uio_resid += (len); \
@@ -306,7 +420,7 @@ __vfprintf(FILE *fp, const char *fmt0, __va_list ap)
 	(((argtable != NULL) ? (void)(ap = argtable[nextarg]) : (void)0), \
 	 nextarg++, va_arg(ap, type))
 
-	_SET_ORIENTATION(fp, -1);
+	_SET_ORIENTATION(fp, ORIENTATION);
 	/* sorry, fprintf(read_only_file, "") returns EOF, not 0 */
 	if (cantwrite(fp)) {
 		errno = EBADF;
@@ -318,13 +432,15 @@ __vfprintf(FILE *fp, const char *fmt0, __va_list ap)
 	    fp->_file >= 0)
 		return (__sbprintf(fp, fmt0, ap));
 
-	fmt = (char *)fmt0;
+	fmt = (CHAR_T *)fmt0;
 	argtable = NULL;
 	nextarg = 1;
 	va_copy(orgap, ap);
 	uio.uio_iov = iovp = iov;
 	uio.uio_resid = 0;
 	uio.uio_iovcnt = 0;
+	/* sprintf() and snprintf() need no uio to fill a fixed buffer */
+	strout = (fp->_flags & (__SSTR|__SALC|__SNBF|__SLBF)) == __SSTR;
 	ret = 0;
 
 	memset(&ps, 0, sizeof(ps));
@@ -474,7 +590,14 @@ reswitch:	switch (ch) {
 			flags |= SIZEINT;
 			goto rflag;
 		case 'c':
+#ifdef PRINTF_WIDE
+			if (flags & LONGINT)
+				*(cp = buf) = (wchar_t)GETARG(wint_t);
+			else
+				*(cp = buf) = (unsigned char)GETARG(int);
+#else
 			*(cp = buf) = GETARG(int);
+#endif
 			size = 1;
 			sign = '\0';
 			break;
@@ -512,20 +635,34 @@ reswitch:	switch (ch) {
 			if (_my_isinf(_double)) {
 				if (_double < 0)
 					sign = '-';
-				cp = "Inf";
+				cp = STR("Inf");
 				size = 3;
 				break;
 			}
 			if (_my_isnan(_double)) {
-				cp = "NaN";
+				cp = STR("NaN");
 				size = 3;
 				break;
 			}
 
 			flags |= FPT;
-			cp = cvt(_double, prec, flags, &softsign,
-				&expt, ch, &ndig);
-		    cp_free = cp;
+			dtoaresult = cvt(_double, prec, flags, &softsign,
+				&expt, ch, &ndig, fdigits);
+#ifdef PRINTF_WIDE
+			cp = __sconv(dtoaresult, ndig, buf, BUF, &n);
+			if (dtoaresult != fdigits)
+				free(dtoaresult);
+			if (cp == NULL) {
+				fp->_flags |= __SERR;
+				goto error;
+			}
+			if (cp != buf)
+				cp_free = cp;
+#else
+			cp = dtoaresult;
+			if (cp != fdigits)
+				cp_free = cp;
+#endif
 			if (ch == 'g' || ch == 'G') {
 				if (expt <= -4 || expt > prec)
 					ch = (ch == 'g') ? 'e' : 'E';
@@ -600,20 +737,35 @@ reswitch:	switch (ch) {
 			/* NOSTRICT */
 			_umax = (u_long)GETARG(void *);
 			base = HEX;
-			xdigs = "0123456789abcdef";
+			xdigs = STR("0123456789abcdef");
 			flags |= HEXPREFIX;
 			ch = 'x';
 			goto nosign;
 		case 's':
-			if ((cp = GETARG(char *)) == NULL)
-				cp = "(null)";
+			if ((flags & LONGINT) == OTHER_S) {
+				if ((ocp = GETARG(OTHER_T *)) != NULL) {
+					cp = __sconv(ocp, prec, buf, BUF, &size);
+					if (cp == NULL) {
+						fp->_flags |= __SERR;
+						goto error;
+					}
+					if (cp != buf)
+						cp_free = cp;
+					sign = '\0';
+					break;
+				}
+				cp = NULL;
+			} else
+				cp = GETARG(CHAR_T *);
+			if (cp == NULL)
+				cp = STR("(null)");
 			if (prec >= 0) {
 				/*
 				 * can't use strlen; can only look for the
 				 * NUL in the first `prec' characters, and
 				 * strlen() will go further.
 				 */
-				char *p = memchr(cp, 0, prec);
+				CHAR_T *p = MEMCHR(cp, 0, prec);
 
 				if (p != NULL) {
 					size = p - cp;
@@ -622,7 +774,7 @@ reswitch:	switch (ch) {
 				} else
 					size = prec;
 			} else
-				size = strlen(cp);
+				size = STRLEN(cp);
 			sign = '\0';
 			break;
 		case 'U':
@@ -633,10 +785,10 @@ reswitch:	switch (ch) {
 			base = DEC;
 			goto nosign;
 		case 'X':
-			xdigs = "0123456789ABCDEF";
+			xdigs = STR("0123456789ABCDEF");
 			goto hex;
 		case 'x':
-			xdigs = "0123456789abcdef";
+			xdigs = STR("0123456789abcdef");
 hex:			_umax = UARG();
 			base = HEX;
 			/* leading 0x/X only if non-zero */
@@ -677,12 +829,32 @@ number:			if ((dprec = prec) >= 0)
 					break;
 
 				case DEC:
-					/* many numbers are 1 digit */
-					while (_umax >= 10) {
-						*--cp = to_char(_umax % 10);
-						_umax /= 10;
+					/*
+					 * BIONIC: two digits per division, and
+					 * only 32-bit divisions once it fits.
+					 */
+					while (_umax > UINT32_MAX) {
+						n = (int)(_umax % 100);
+						_umax /= 100;
+						cp -= 2;
+						memcpy(cp, &digits2[n * 2],
+						    2 * sizeof(CHAR_T));
 					}
-					*--cp = to_char(_umax);
+					u32 = (u_int)_umax;
+					while (u32 >= 100) {
+						n = (int)(u32 % 100);
+						u32 /= 100;
+						cp -= 2;
+						memcpy(cp, &digits2[n * 2],
+						    2 * sizeof(CHAR_T));
+					}
+					/* many numbers are 1 digit */
+					if (u32 >= 10) {
+						cp -= 2;
+						memcpy(cp, &digits2[u32 * 2],
+						    2 * sizeof(CHAR_T));
+					} else
+						*--cp = to_char(u32);
 					break;
 
 				case HEX:
@@ -693,8 +865,8 @@ number:			if ((dprec = prec) >= 0)
 					break;
 
 				default:
-					cp = "bug in vfprintf: bad base";
-					size = strlen(cp);
+					cp = STR("bug in vfprintf: bad base");
+					size = STRLEN(cp);
 					goto skipsize;
 				}
 			}
@@ -760,13 +932,13 @@ number:			if ((dprec = prec) >= 0)
 			if (ch >= 'f') {	/* 'f' or 'g' */
 				if (_double == 0) {
 					/* kludge for __dtoa irregularity */
-					PRINT("0", 1);
+					PRINT(STR("0"), 1);
 					if (expt < ndig || (flags & ALT) != 0) {
 						PRINT(decimal_point, 1);
 						PAD(ndig - 1, zeroes);
 					}
 				} else if (expt <= 0) {
-					PRINT("0", 1);
+					PRINT(STR("0"), 1);
 					PRINT(decimal_point, 1);
 					PAD(-expt, zeroes);
 					PRINT(cp, ndig);
@@ -774,11 +946,11 @@ number:			if ((dprec = prec) >= 0)
 					PRINT(cp, ndig);
 					PAD(expt - ndig, zeroes);
 					if (flags & ALT)
-						PRINT(".", 1);
+						PRINT(STR("."), 1);
 				} else {
 					PRINT(cp, expt);
 					cp += expt;
-					PRINT(".", 1);
+					PRINT(STR("."), 1);
 					PRINT(cp, ndig-expt);
 				}
 			} else {	/* 'e' or 'E' */
@@ -870,13 +1042,13 @@ error:
  * problematic since we have nested functions..)
  */
 static void
-__find_arguments(const char *fmt0, va_list ap, va_list **argtable,
+__find_arguments(const CHAR_T *fmt0, va_list ap, va_list **argtable,
     size_t *argtablesiz)
 {
-	char *fmt;	/* format string */
+	CHAR_T *fmt;	/* format string */
 	int ch;	/* character from fmt */
 	int n, n2;	/* handy integer (short term usage) */
-	char *cp;	/* handy char pointer (short term usage) */
+	CHAR_T *cp;	/* handy char pointer (short term usage) */
 	int flags;	/* flags as above */
 	unsigned char *typetable; /* table of types */
 	unsigned char stattypetable[STATIC_ARG_TBL_SIZE];
@@ -930,7 +1102,7 @@ __find_arguments(const char *fmt0, va_list ap, va_list **argtable,
 	} else { \
 		ADDTYPE(T_INT); \
 	}
-	fmt = (char *)fmt0;
+	fmt = (CHAR_T *)fmt0;
 	typetable = stattypetable;
 	tablesize = STATIC_ARG_TBL_SIZE;
 	tablemax = 0;
@@ -1103,6 +1275,8 @@ done:
 		*argtablesiz = sizeof (va_list) * (tablemax + 1);
 		*argtable = (va_list *)mmap(NULL, *argtablesiz,
 		    PROT_WRITE|PROT_READ, MAP_ANON|MAP_PRIVATE, -1, 0);
+		if (*argtable != MAP_FAILED)
+			__bionic_name_mem(*argtable, *argtablesiz, "vfprintf");
 	}
 
 #if 0
@@ -1204,11 +1378,13 @@ __grow_type_table(unsigned char **typetable, int *tablesize)
 		    sizeof (unsigned char) * newsize, PROT_WRITE|PROT_READ,
 		    MAP_ANON|MAP_PRIVATE, -1, 0);
 		/* XXX unchecked */
+		__bionic_name_mem(*typetable, newsize, "vfprintf");
 		memcpy( *typetable, oldtable, *tablesize);
 	} else {
 		unsigned char *new = (unsigned char *)mmap(NULL,
 		    sizeof (unsigned char) * newsize, PROT_WRITE|PROT_READ,
 		    MAP_ANON|MAP_PRIVATE, -1, 0);
+		__bionic_name_mem(new, newsize, "vfprintf");
 		memmove(new, *typetable, *tablesize);
 		munmap(*typetable, *tablesize);
 		*typetable = new;
@@ -1225,12 +1401,18 @@ __grow_type_table(unsigned char **typetable, int *tablesize)
 
 extern char *__dtoa(double, int, int, int *, int *, char **);
 
+/*
+ * Returns the digits of 'value' for 'ch' format, in 'buf' if they fit
+ * there (MAXFASTDIG digits and room for a carry), or else in memory that
+ * the caller frees.
+ */
 static char *
 cvt(double value, int ndigits, int flags, char *sign, int *decpt, int ch,
-    int *length)
+    int *length, char *buf)
 {
-	int mode, dsgn;
+	int mode, dsgn, n;
 	char *digits, *bp, *rve;
+	uint64_t ipart;
 
 	if (ch == 'f') {
 		mode = 3;		/* ndigits after the decimal point */
@@ -1250,7 +1432,29 @@ cvt(double value, int ndigits, int flags, char *sign, int *decpt, int ch,
 		*sign = '-';
 	} else
 		*sign = '\000';
-	digits = __dtoa(value, mode, ndigits, decpt, &dsgn, &rve);
+
+	/*
+	 * BIONIC: try __grisu_counted() first, for as many significant
+	 * digits as are asked for. For 'f' that's only known up front when
+	 * there is an integer part to count them from.
+	 */
+	n = 0;
+	if (mode == 2)
+		n = ndigits > 1 ? ndigits : 1;
+	else if (value >= 1 && value < 1e17) {
+		for (ipart = (uint64_t)value, n = ndigits; ipart != 0;
+		    ipart /= 10)
+			n++;
+	}
+	if (n > 0 && n <= MAXFASTDIG &&
+	    (n = __grisu_counted(value, n, buf, decpt)) > 0) {
+		/* suppress trailing zeros, as __dtoa does */
+		while (n > 1 && buf[n - 1] == '0')
+			n--;
+		digits = buf;
+		rve = buf + n;
+	} else
+		digits = __dtoa(value, mode, ndigits, decpt, &dsgn, &rve);
 	if ((ch != 'g' && ch != 'G') || flags & ALT) {	/* Print trailing zeros */
 		bp = digits + ndigits;
 		if (ch == 'f') {
@@ -1268,10 +1472,10 @@ cvt(double value, int ndigits, int flags, char *sign, int *decpt, int ch,
 }
 
 static int
-exponent(char *p0, int exp, int fmtch)
+exponent(CHAR_T *p0, int exp, int fmtch)
 {
-	char *p, *t;
-	char expbuf[MAXEXP];
+	CHAR_T *p, *t;
+	CHAR_T expbuf[MAXEXP];
 
 	p = p0;
 	*p++ = fmtch;
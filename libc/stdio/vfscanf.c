@@ -88,7 +88,23 @@
 #define u_char unsigned char
 #define u_long unsigned long
 
-static u_char *__sccl(char *, u_char *);
+/*
+ * BIONIC: vfwscanf.c builds the wide-character scanf from this same code by
+ * defining SCANF_WIDE first. Only the format differs: input is read a byte
+ * at a time either way, each byte being one character as fgetwc() has it.
+ */
+#ifdef SCANF_WIDE
+#define	CHAR_T		wchar_t
+#define	UCHAR_T		wchar_t
+#define	ORIENTATION	1
+#define	VFSCANF		vfwscanf
+#else
+#define	CHAR_T		char
+#define	UCHAR_T		u_char
+#define	ORIENTATION	-1
+#endif
+
+static UCHAR_T *__sccl(char *, UCHAR_T *);
 
 #if !defined(VFSCANF)
 #define VFSCANF	vfscanf
@@ -98,15 +114,17 @@ static u_char *__sccl(char *, u_char *);
  * vfscanf
  */
 int
-VFSCANF(FILE *fp, const char *fmt0, __va_list ap)
+VFSCANF(FILE *fp, const CHAR_T *fmt0, __va_list ap)
 {
-	u_char *fmt = (u_char *)fmt0;
+	UCHAR_T *fmt = (UCHAR_T *)fmt0;
 	int c;		/* character from format, or conversion */
 	size_t width;	/* field width, or 0 */
 	char *p;	/* points into all kinds of strings */
+	wchar_t *wcp;	/* ... and into wide ones, for %l[cs[] */
 	int n;		/* handy integer */
 	int flags;	/* flags as defined above */
 	char *p0;	/* saves original value of p when necessary */
+	wchar_t *wcp0;	/* likewise for wcp */
 	int nassigned;		/* number of fields assigned */
 	int nread;		/* number of characters consumed from fp */
 	int base;		/* base argument to strtoimax/strtouimax */
@@ -118,7 +136,7 @@ VFSCANF(FILE *fp, const char *fmt0, __va_list ap)
 		{ 10, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
 
 	FLOCKFILE(fp);
-	_SET_ORIENTATION(fp, -1);
+	_SET_ORIENTATION(fp, ORIENTATION);
 
 	nassigned = 0;
 	nread = 0;
@@ -129,7 +147,8 @@ VFSCANF(FILE *fp, const char *fmt0, __va_list ap)
 			FUNLOCKFILE(fp);
 			return (nassigned);
 		}
-		if (isspace(c)) {
+		/* (a wide format may have characters no byte matches) */
+		if (c < 256 && isspace(c)) {
 			while ((fp->_r > 0 || __srefill(fp) == 0) &&
 			    isspace(*fp->_p))
 				nread++, fp->_r--, fp->_p++;
@@ -305,7 +324,7 @@ literal:
 			return (EOF);
 
 		default:	/* compat */
-			if (isupper(c))
+			if (c < 256 && isupper(c))
 				flags |= LONG;
 			c = CT_INT;
 			base = 10;
@@ -366,6 +385,17 @@ literal:
 					}
 				}
 				nread += sum;
+			} else if (flags & LONG) {
+				size_t sum = 0;
+
+				wcp = va_arg(ap, wchar_t *);
+				do {
+					fp->_r--;
+					*wcp++ = *fp->_p++;
+				} while (++sum < width &&
+				    (fp->_r > 0 || __srefill(fp) == 0));
+				nread += sum;
+				nassigned++;
 			} else {
 				size_t r = fread((void *)va_arg(ap, char *), 1,
 				    width, fp);
@@ -396,6 +426,24 @@ literal:
 				}
 				if (n == 0)
 					goto match_failure;
+			} else if (flags & LONG) {
+				wcp0 = wcp = va_arg(ap, wchar_t *);
+				while (ccltab[*fp->_p]) {
+					fp->_r--;
+					*wcp++ = *fp->_p++;
+					if (--width == 0)
+						break;
+					if (fp->_r <= 0 && __srefill(fp)) {
+						if (wcp == wcp0)
+							goto input_failure;
+						break;
+					}
+				}
+				n = wcp - wcp0;
+				if (n == 0)
+					goto match_failure;
+				*wcp = L'\0';
+				nassigned++;
 			} else {
 				p0 = p = va_arg(ap, char *);
 				while (ccltab[*fp->_p]) {
@@ -432,6 +480,19 @@ literal:
 						break;
 				}
 				nread += n;
+			} else if (flags & LONG) {
+				wcp0 = wcp = va_arg(ap, wchar_t *);
+				while (!isspace(*fp->_p)) {
+					fp->_r--;
+					*wcp++ = *fp->_p++;
+					if (--width == 0)
+						break;
+					if (fp->_r <= 0 && __srefill(fp))
+						break;
+				}
+				*wcp = L'\0';
+				nread += wcp - wcp0;
+				nassigned++;
 			} else {
 				p0 = p = va_arg(ap, char *);
 				while (!isspace(*fp->_p)) {
@@ -710,10 +771,11 @@ match_failure:
  * Fill in the given table from the scanset at the given format
  * (just after `[').  Return a pointer to the character past the
  * closing `]'.  The table has a 1 wherever characters should be
- * considered part of the scanset.
+ * considered part of the scanset. Characters of a wide format that are
+ * past the table can't be read, so they are left out.
  */
-static u_char *
-__sccl(char *tab, u_char *fmt)
+static UCHAR_T *
+__sccl(char *tab, UCHAR_T *fmt)
 {
 	int c, n, v;
 
@@ -739,7 +801,8 @@ __sccl(char *tab, u_char *fmt)
 	 */
 	v = 1 - v;
 	for (;;) {
-		tab[c] = v;		/* take character c */
+		if (c < 256)
+			tab[c] = v;	/* take character c */
 doswitch:
 		n = *fmt++;		/* and examine the next */
 		switch (n) {
@@ -773,7 +836,8 @@ doswitch:
 			}
 			fmt++;
 			do {		/* fill in the range */
-				tab[++c] = v;
+				if (++c < 256)
+					tab[c] = v;
 			} while (c < n);
 #if 1	/* XXX another disgusting compatibility hack */
 			/*
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <wchar.h>
+#include "local.h"
+
+/*
+ * Hands the string to vfwscanf() a buffer at a time, a byte per character,
+ * the way it reads any stream.
+ */
+static int
+wstringread(void *cookie, char *buf, int len)
+{
+	const wchar_t **wsp = cookie;
+	const wchar_t *ws = *wsp;
+	int n;
+
+	for (n = 0; n < len && ws[n] != L'\0'; n++)
+		buf[n] = (char)ws[n];
+	*wsp = ws + n;
+	return (n);
+}
+
+int
+vswscanf(const wchar_t *str, const wchar_t *fmt, __va_list ap)
+{
+	FILE f;
+	struct __sfileext fext;
+	unsigned char buf[128];
+
+	_FILEEXT_SETUP(&f, &fext);
+	f._flags = __SRD;
+	f._bf._base = f._p = buf;
+	f._bf._size = sizeof(buf);
+	f._r = 0;
+	f._cookie = &str;
+	f._read = wstringread;
+	f._lb._base = NULL;
+	return (vfwscanf(&f, fmt, ap));
+}
@@ -31,25 +31,143 @@
 
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include "atexit.h"
+#include "bionic_name_mem.h"
 #include "thread_private.h"
 
 int __atexit_invalid = 1;
 struct atexit *__atexit;
 
 /*
- * Function pointers are stored in a linked list of pages. The list
- * is initially empty, and pages are allocated on demand. The first
- * function pointer in the first allocated page (the last one in
- * the linked list) was reserved for the cleanup function.
- * TODO: switch to the regular FreeBSD/NetBSD atexit implementation.
+ * Function pointers are stored in a linked list of tables, each
+ * ATEXIT_CHUNK_PAGES pages long, allocated on demand with the newest at
+ * the head.  Slots are claimed with an atomic increment of the head's
+ * index, so registration doesn't take the atexit lock; only linking in a
+ * new table or sealing a full one is serialized (by compare-and-swap and
+ * by the lock respectively).
  *
- * Outside the following functions, all pages are mprotect()'ed
- * to prevent unintentional/malicious corruption.
+ * Once every slot in a table has been written, all but its first page
+ * is mprotect()'ed read-only to prevent unintentional/malicious
+ * corruption.  The first page holds the index, which threads that
+ * haven't yet seen the newer table keep incrementing, so it has to stay
+ * writable; nor can tables still being filled be protected.
+ *
+ * Each registration is also pushed onto a per-dso chain, found through a
+ * small hash table of dso handles, so that __cxa_finalize(dso) for one
+ * library doesn't have to walk every handler in the process.
  */
+#define ATEXIT_CHUNK_PAGES	4
+#define ATEXIT_DSO_BUCKETS	256	/* power of two */
+
+struct atexit_dso {
+	void *dso;
+	struct atexit_fn *head;		/* most recent registration */
+};
+
+static struct atexit_dso atexit_dsos[ATEXIT_DSO_BUCKETS];
+static int atexit_dsos_overflowed;	/* some handler isn't indexed */
+
+static size_t
+atexit_chunk_size(void)
+{
+	return ATEXIT_CHUNK_PAGES * getpagesize();
+}
+
+/* The part of a table that's read-only once it's sealed. */
+static void
+atexit_protect(struct atexit *p, int prot)
+{
+	int pgsize = getpagesize();
+
+	mprotect((char *)p + pgsize, atexit_chunk_size() - pgsize, prot);
+}
+
+static unsigned
+atexit_dso_hash(void *dso)
+{
+	return ((uintptr_t)dso >> 3) * 2654435761U;
+}
+
+/* Claims a slot, linking in a new table if the current one is full. */
+static struct atexit_fn *
+atexit_claim(struct atexit **table)
+{
+	struct atexit *p, *q;
+	size_t size = atexit_chunk_size();
+	int n;
+
+	for (;;) {
+		p = *(struct atexit * volatile *)&__atexit;
+		if (p != NULL) {
+			n = __sync_fetch_and_add(&p->ind, 1);
+			if (n < p->max) {
+				*table = p;
+				return &p->fns[n];
+			}
+		}
+		q = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		    MAP_ANON | MAP_PRIVATE, -1, 0);
+		if (q == MAP_FAILED)
+			return NULL;
+		__bionic_name_mem(q, size, "atexit handlers");
+		q->ind = 1;
+		q->max = (size - ((char *)&q->fns[0] - (char *)q)) /
+		    sizeof(q->fns[0]);
+		q->next = p;
+		if (__sync_bool_compare_and_swap(&__atexit, p, q)) {
+			if (__atexit_invalid)
+				__atexit_invalid = 0;
+			*table = q;
+			return &q->fns[0];
+		}
+		/* Someone else replaced the full table first; use theirs. */
+		munmap(q, size);
+	}
+}
+
+static void
+atexit_index(struct atexit_fn *fnp)
+{
+	struct atexit_dso *b;
+	struct atexit_fn *head;
+	unsigned h = atexit_dso_hash(fnp->fn_dso);
+	int probe;
+
+	for (probe = 0; probe < ATEXIT_DSO_BUCKETS; probe++) {
+		b = &atexit_dsos[(h + probe) & (ATEXIT_DSO_BUCKETS - 1)];
+		if (b->dso == NULL)
+			__sync_bool_compare_and_swap(&b->dso, NULL, fnp->fn_dso);
+		if (b->dso != fnp->fn_dso)
+			continue;
+		do {
+			head = b->head;
+			fnp->fn_dso_prev = head;
+		} while (!__sync_bool_compare_and_swap(&b->head, head, fnp));
+		return;
+	}
+	atexit_dsos_overflowed = 1;
+}
+
+static struct atexit_dso *
+atexit_find_dso(void *dso)
+{
+	struct atexit_dso *b;
+	unsigned h = atexit_dso_hash(dso);
+	int probe;
+
+	for (probe = 0; probe < ATEXIT_DSO_BUCKETS; probe++) {
+		b = &atexit_dsos[(h + probe) & (ATEXIT_DSO_BUCKETS - 1)];
+		if (b->dso == dso)
+			return b;
+		if (b->dso == NULL)
+			break;
+	}
+	return NULL;
+}
 
 /*
  * Register a function to be performed at exit or when a shared object
@@ -61,48 +179,75 @@ struct atexit *__atexit;
 int
 __cxa_atexit(void (*func)(void *), void *arg, void *dso)
 {
-	struct atexit *p = __atexit;
+	struct atexit *p;
 	struct atexit_fn *fnp;
-	int pgsize = getpagesize();
-	int ret = -1;
 
-	if (pgsize < (int)sizeof(*p))
+	fnp = atexit_claim(&p);
+	if (fnp == NULL)
 		return (-1);
-	_ATEXIT_LOCK();
-	p = __atexit;
-	if (p != NULL) {
-		if (p->ind + 1 >= p->max)
-			p = NULL;
-		else if (mprotect(p, pgsize, PROT_READ | PROT_WRITE))
-			goto unlock;
-	}
-	if (p == NULL) {
-		p = mmap(NULL, pgsize, PROT_READ | PROT_WRITE,
-		    MAP_ANON | MAP_PRIVATE, -1, 0);
-		if (p == MAP_FAILED)
-			goto unlock;
-		if (__atexit == NULL) {
-			memset(&p->fns[0], 0, sizeof(p->fns[0]));
-			p->ind = 1;
-		} else
-			p->ind = 0;
-		p->max = (pgsize - ((char *)&p->fns[0] - (char *)p)) /
-		    sizeof(p->fns[0]);
-		p->next = __atexit;
-		__atexit = p;
-		if (__atexit_invalid)
-			__atexit_invalid = 0;
-	}
-	fnp = &p->fns[p->ind++];
-	fnp->fn_ptr.cxa_func = func;
 	fnp->fn_arg = arg;
 	fnp->fn_dso = dso;
-	if (mprotect(p, pgsize, PROT_READ))
-		goto unlock;
-	ret = 0;
-unlock:
+	/* The function pointer is what makes the slot live; publish it last. */
+	__sync_synchronize();
+	fnp->fn_ptr.cxa_func = func;
+	if (dso != NULL)
+		atexit_index(fnp);
+
+	if (__sync_add_and_fetch(&p->done, 1) == p->max) {
+		_ATEXIT_LOCK();
+		p->sealed = 1;
+		atexit_protect(p, PROT_READ);
+		_ATEXIT_UNLOCK();
+	}
+	return (0);
+}
+
+/*
+ * Mark a handler as having been already called to avoid dupes and
+ * loops.  Called with the atexit lock held, which keeps its table from
+ * being sealed underneath us.
+ */
+static void
+atexit_mark_called(struct atexit_fn *fnp)
+{
+	struct atexit *p;
+
+	for (p = __atexit; p != NULL; p = p->next) {
+		if (fnp < &p->fns[0] || fnp >= &p->fns[p->max])
+			continue;
+		if (p->sealed)
+			atexit_protect(p, PROT_READ | PROT_WRITE);
+		fnp->fn_ptr.cxa_func = NULL;
+		if (p->sealed)
+			atexit_protect(p, PROT_READ);
+		return;
+	}
+}
+
+/* Called with the atexit lock held; drops it around the call. */
+static void
+atexit_call(struct atexit_fn *fnp)
+{
+	struct atexit_fn fn;
+
+	__sync_synchronize();
+	fn = *fnp;
+	atexit_mark_called(fnp);
 	_ATEXIT_UNLOCK();
-	return (ret);
+#if ANDROID
+	/* it looks like we should always call the function
+	 * with an argument, even if dso is not NULL. Otherwise
+	 * static destructors will not be called properly on
+	 * the ARM.
+	 */
+	(*fn.fn_ptr.cxa_func)(fn.fn_arg);
+#else /* !ANDROID */
+	if (fn.fn_dso != NULL)
+		(*fn.fn_ptr.cxa_func)(fn.fn_arg);
+	else
+		(*fn.fn_ptr.std_func)();
+#endif /* !ANDROID */
+	_ATEXIT_LOCK();
 }
 
 /*
@@ -113,63 +258,42 @@ unlock:
 void
 __cxa_finalize(void *dso)
 {
-	struct atexit *p, *q;
-	struct atexit_fn fn;
-	int n, pgsize = getpagesize();
-	static int call_depth;
+	struct atexit *p;
+	struct atexit_dso *b;
+	struct atexit_fn *fnp;
+	int n;
 
 	if (__atexit_invalid)
 		return;
 
 	_ATEXIT_LOCK();
-	call_depth++;
+
+	if (dso != NULL && !atexit_dsos_overflowed) {
+		/* Every handler for this dso is on its chain, newest first. */
+		b = atexit_find_dso(dso);
+		for (fnp = (b != NULL) ? b->head : NULL; fnp != NULL;
+		    fnp = fnp->fn_dso_prev) {
+			if (fnp->fn_ptr.cxa_func != NULL)
+				atexit_call(fnp);
+		}
+		_ATEXIT_UNLOCK();
+		return;
+	}
 
 	for (p = __atexit; p != NULL; p = p->next) {
-		for (n = p->ind; --n >= 0;) {
+		for (n = (p->ind < p->max) ? p->ind : p->max; --n >= 0;) {
 			if (p->fns[n].fn_ptr.cxa_func == NULL)
 				continue;	/* already called */
 			if (dso != NULL && dso != p->fns[n].fn_dso)
 				continue;	/* wrong DSO */
-
-			/*
-			 * Mark handler as having been already called to avoid
-			 * dupes and loops, then call the appropriate function.
-			 */
-			fn = p->fns[n];
-			if (mprotect(p, pgsize, PROT_READ | PROT_WRITE) == 0) {
-				p->fns[n].fn_ptr.cxa_func = NULL;
-				mprotect(p, pgsize, PROT_READ);
-			}
-			_ATEXIT_UNLOCK();
-#if ANDROID
-                        /* it looks like we should always call the function
-                         * with an argument, even if dso is not NULL. Otherwise
-                         * static destructors will not be called properly on
-                         * the ARM.
-                         */
-                        (*fn.fn_ptr.cxa_func)(fn.fn_arg);
-#else /* !ANDROID */
-			if (dso != NULL)
-				(*fn.fn_ptr.cxa_func)(fn.fn_arg);
-			else
-				(*fn.fn_ptr.std_func)();
-#endif /* !ANDROID */
-			_ATEXIT_LOCK();
+			atexit_call(&p->fns[n]);
 		}
 	}
 
 	/*
-	 * If called via exit(), unmap the pages since we have now run
-	 * all the handlers.  We defer this until calldepth == 0 so that
-	 * we don't unmap things prematurely if called recursively.
+	 * The tables aren't unmapped after exit() has run everything: the
+	 * process is about to _exit(), and another thread may still be
+	 * registering into them.
 	 */
-	if (dso == NULL && --call_depth == 0) {
-		for (p = __atexit; p != NULL; ) {
-			q = p;
-			p = p->next;
-			munmap(q, pgsize);
-		}
-		__atexit = NULL;
-	}
 	_ATEXIT_UNLOCK();
 }
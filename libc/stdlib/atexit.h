@@ -36,6 +36,8 @@ struct atexit {
 	struct atexit *next;		/* next in list */
 	int ind;			/* next index in this table */
 	int max;			/* max entries >= ATEXIT_SIZE */
+	int done;			/* entries completely written */
+	int sealed;			/* table is full and read-only */
 	struct atexit_fn {
 		union {
 			void (*std_func)(void);
@@ -43,6 +45,7 @@ struct atexit {
 		} fn_ptr;
 		void *fn_arg;		/* argument for CXA callback */
 		void *fn_dso;		/* shared module handle */
+		struct atexit_fn *fn_dso_prev;	/* previous for this dso */
 	} fns[1];			/* the table itself */
 };
 
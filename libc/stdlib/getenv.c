@@ -28,11 +28,153 @@
  * SUCH DAMAGE.
  */
 
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+
+#include "private/bionic_env.h"
+#include "private/bionic_name_mem.h"
 
 char *__findenv(const char *name, int *offset);
 
+extern char **environ;
+
+/*
+ * getenv() looks names up in a hash index of environ rather than scanning
+ * it, once a few lookups have shown that the environment is being read
+ * often enough to be worth it. setenv(), unsetenv() and clearenv() drop the
+ * index (see __bionic_env_changed); pointing environ at a different array
+ * is noticed by comparing it with the array the index was built over.
+ * Either way the next lookups build a fresh one.
+ *
+ * getenv() may be called from several threads at once, so an index is
+ * only ever replaced, under env_index_lock, and a replaced one is kept
+ * until the environment is next changed, which nothing may do at the same
+ * time as a getenv(). The memory is mmap'ed rather than malloc'ed because
+ * getenv() is called before malloc debugging is set up.
+ */
+#define	ENV_INDEX_MIN_LOOKUPS	4
+#define	ENV_INDEX_MIN_SLOTS	16
+
+struct env_slot {
+	uint32_t hash;
+	uint32_t len;		/* of the name */
+	int offset;		/* in environ, or -1 if the slot is empty */
+};
+
+struct env_index {
+	char **environ;		/* the array this indexes */
+	size_t size;		/* bytes mapped */
+	struct env_index *retired;	/* indexes this replaced */
+	size_t mask;
+	struct env_slot slots[1];	/* actually [mask + 1] */
+};
+
+static pthread_mutex_t env_index_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct env_index *volatile env_index;
+static unsigned env_lookups;	/* linear lookups since the last change */
+
+/* FNV-1a over the name, which ends at a '=' or NUL; sets *len. */
+static uint32_t
+env_hash(const char *name, size_t *len)
+{
+	uint32_t h = 2166136261U;
+	const char *np;
+
+	for (np = name; *np && *np != '='; ++np)
+		h = (h ^ (unsigned char)*np) * 16777619U;
+	*len = np - name;
+	return (h);
+}
+
+static struct env_index *
+env_index_build(char **env)
+{
+	struct env_index *index;
+	struct env_slot *slot;
+	size_t count, slots, size, len, i;
+	uint32_t h;
+	char *cp;
+
+	for (count = 0; env[count] != NULL; ++count)
+		;
+	for (slots = ENV_INDEX_MIN_SLOTS; slots < 2 * count; slots *= 2)
+		;
+	size = sizeof(*index) + (slots - 1) * sizeof(struct env_slot);
+	index = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (index == MAP_FAILED)
+		return (NULL);
+	__bionic_name_mem(index, size, "environ index");
+	index->environ = env;
+	index->size = size;
+	index->retired = NULL;
+	index->mask = slots - 1;
+	for (i = 0; i < slots; ++i)
+		index->slots[i].offset = -1;
+
+	for (i = 0; i < count; ++i) {
+		cp = env[i];
+		h = env_hash(cp, &len);
+		if (cp[len] != '=')
+			continue;	/* __findenv() never matches these */
+		for (slot = &index->slots[h & index->mask]; slot->offset != -1;
+		    slot = &index->slots[(slot - index->slots + 1) & index->mask]) {
+			/* as in __findenv(), the first of any duplicates wins */
+			if (slot->hash == h && slot->len == len &&
+			    memcmp(env[slot->offset], cp, len) == 0)
+				break;
+		}
+		if (slot->offset == -1) {
+			slot->hash = h;
+			slot->len = len;
+			slot->offset = i;
+		}
+	}
+	return (index);
+}
+
+/* Returns an index of the current environ, or NULL to scan it instead. */
+static struct env_index *
+env_index_get(void)
+{
+	struct env_index *index;
+
+	if (__sync_add_and_fetch(&env_lookups, 1) <= ENV_INDEX_MIN_LOOKUPS)
+		return (NULL);
+
+	pthread_mutex_lock(&env_index_lock);
+	index = env_index;
+	if (index == NULL || index->environ != environ) {
+		struct env_index *fresh = env_index_build(environ);
+		if (fresh != NULL) {
+			fresh->retired = index;
+			/* Everything in the index must be visible before it is. */
+			__sync_synchronize();
+			env_index = fresh;
+		}
+		index = fresh;
+	}
+	pthread_mutex_unlock(&env_index_lock);
+	return (index);
+}
+
+void
+__bionic_env_changed(void)
+{
+	struct env_index *index, *retired;
+
+	pthread_mutex_lock(&env_index_lock);
+	for (index = env_index; index != NULL; index = retired) {
+		retired = index->retired;
+		munmap(index, index->size);
+	}
+	env_index = NULL;
+	env_lookups = 0;
+	pthread_mutex_unlock(&env_index_lock);
+}
+
 /*
  * __findenv --
  *	Returns pointer to value associated with name, if any, else NULL.
@@ -74,7 +216,34 @@ __findenv(const char *name, int *offset)
 char *
 getenv(const char *name)
 {
+	struct env_index *index = env_index;
+	struct env_slot *slot;
+	size_t len;
+	uint32_t h;
+	char *cp;
 	int offset;
 
-	return (__findenv(name, &offset));
+	if (name == NULL || environ == NULL)
+		return (NULL);
+	if (index == NULL || index->environ != environ) {
+		index = env_index_get();
+		if (index == NULL)
+			return (__findenv(name, &offset));
+	}
+
+	h = env_hash(name, &len);
+	for (slot = &index->slots[h & index->mask]; slot->offset != -1;
+	    slot = &index->slots[(slot - index->slots + 1) & index->mask]) {
+		if (slot->hash != h || slot->len != len)
+			continue;
+		cp = index->environ[slot->offset];
+		if (cp != NULL && strncmp(cp, name, len) == 0 && cp[len] == '=')
+			return (cp + len + 1);
+		/*
+		 * Two names with one hash, or an entry that was rewritten
+		 * behind our back: either way the scan has the answer.
+		 */
+		return (__findenv(name, &offset));
+	}
+	return (NULL);
 }
@@ -31,6 +31,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "private/bionic_env.h"
+#include "private/bionic_time.h"
+
 char *__findenv(const char *name, int *offset);
 
 extern char **environ;
@@ -56,6 +59,7 @@ setenv(const char *name, const char *value, int rewrite)
 		if ((int)strlen(C) >= l_value) {	/* old larger; copy over */
 			while ((*C++ = *value++))
 				;
+			__bionic_tz_env_changed(name);
 			return (0);
 		}
 	} else {					/* create new slot */
@@ -73,6 +77,7 @@ setenv(const char *name, const char *value, int rewrite)
 		lastenv = environ = P;
 		offset = cnt;
 		environ[cnt + 1] = NULL;
+		__bionic_env_changed();
 	}
 	for (C = (char *)name; *C && *C != '='; ++C)
 		;				/* no `=' in name */
@@ -83,6 +88,7 @@ setenv(const char *name, const char *value, int rewrite)
 		;
 	for (*C++ = '='; (*C++ = *value++); )
 		;
+	__bionic_tz_env_changed(name);
 	return (0);
 }
 
@@ -101,5 +107,7 @@ unsetenv(const char *name)
 			if (!(*P = *(P + 1)))
 				break;
 
+        __bionic_env_changed();
+        __bionic_tz_env_changed(name);
         return 0;
 }
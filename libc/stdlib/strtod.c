@@ -93,6 +93,7 @@
 
 #ifdef ANDROID_CHANGES
 #include <pthread.h>
+#include <stdint.h>
 #define mutex_lock(x) pthread_mutex_lock(x)
 #define mutex_unlock(x) pthread_mutex_unlock(x)
 #endif
@@ -1328,6 +1329,84 @@ static CONST double tinytens[] = { 1e-16, 1e-32 };
 #endif
 #endif
 
+#if defined(ANDROID_CHANGES) && defined(IEEE_Arith)
+#include "strtod_pow10.h"
+
+/* Sets (*hi, *lo) to the 128-bit product a * b. */
+static void
+mul64(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128)a * b;
+
+	*hi = (uint64_t)(p >> 64);
+	*lo = (uint64_t)p;
+#else
+	uint64_t a0 = (uint32_t)a, a1 = a >> 32;
+	uint64_t b0 = (uint32_t)b, b1 = b >> 32;
+	uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+	uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+
+	*hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+	*lo = (mid << 32) | (uint32_t)p00;
+#endif
+}
+
+/*
+ * BIONIC: Daniel Lemire's variant of Michael Eisel's algorithm, as in
+ * Go's strconv. Sets *rv to man * 10^q (man != 0), correctly rounded,
+ * with one or two 64x64-bit multiplications by a tabulated 10^q. Returns
+ * 0, leaving the bignum code to decide, when the result is too close to
+ * a halfway point to be sure of, or is subnormal, or overflows.
+ */
+static int
+eisel_lemire(uint64_t man, int q, _double *rv)
+{
+	uint64_t xhi, xlo, yhi, ylo, mhi, mlo, mant;
+	int clz, msb, exp2;
+
+	if (q < POW10_MIN || q > POW10_MAX)
+		return 0;
+	clz = __builtin_clzll(man);
+	man <<= clz;
+	/* 217706 / 2^16 is log2(10), near enough for q in range */
+	exp2 = ((217706 * q) >> 16) + 64 + Bias - clz;
+
+	mul64(man, pow10_128[q - POW10_MIN][0], &xhi, &xlo);
+	/* 9 bits below the 54 we keep all ones: widen to 192 bits */
+	if ((xhi & 0x1ff) == 0x1ff && xlo + man < man) {
+		mul64(man, pow10_128[q - POW10_MIN][1], &yhi, &ylo);
+		mhi = xhi;
+		mlo = xlo + yhi;
+		if (mlo < xlo)
+			mhi++;
+		if ((mhi & 0x1ff) == 0x1ff && mlo + 1 == 0 && ylo + man < man)
+			return 0;
+		xhi = mhi;
+		xlo = mlo;
+	}
+
+	msb = (int)(xhi >> 63);
+	mant = xhi >> (msb + 9);
+	exp2 -= 1 ^ msb;
+	/* possibly exactly halfway: round-half-even needs the bignums */
+	if (xlo == 0 && (xhi & 0x1ff) == 0 && (mant & 3) == 1)
+		return 0;
+
+	mant += mant & 1;
+	mant >>= 1;
+	if (mant >> 53) {
+		mant >>= 1;
+		exp2++;
+	}
+	if (exp2 <= 0 || exp2 >= 0x7ff)
+		return 0;
+	word0(*rv) = (ULong)((uint64_t)exp2 << 20 | (mant >> 32 & 0xfffff));
+	word1(*rv) = (ULong)mant;
+	return 1;
+}
+#endif /* ANDROID_CHANGES && IEEE_Arith */
+
  double
 strtod
 #ifdef KR_headers
@@ -1565,6 +1644,21 @@ strtod
 		}
 #endif
 	}
+#if defined(ANDROID_CHANGES) && defined(IEEE_Arith)
+	/* BIONIC: up to 19 digits fit in 64 bits, and usually need no bignums */
+	if (nd <= 19) {
+		uint64_t man = 0;
+
+		for (i = 0, s1 = s0; i < nd; s1++) {
+			if (*s1 != decimal_point) {
+				man = 10 * man + (*s1 - '0');
+				i++;
+			}
+		}
+		if (eisel_lemire(man, e, &rv))
+			goto ret;
+	}
+#endif
 	e1 += nd - k;
 
 	/* Get starting approximation = rv * 10**e1 */
@@ -31,28 +31,31 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
 #include <string.h>
 
+#define	IN_SET(set, c)	((set)[(c) >> 5] & (1U << ((c) & 31)))
+
 /*
  * Span the complement of string s2.
  */
 size_t
 strcspn(const char *s1, const char *s2)
 {
-	const char *p, *spanp;
-	char c, sc;
+	const unsigned char *p = (const unsigned char *)s1;
+	const unsigned char *spanp = (const unsigned char *)s2;
+	uint32_t set[256 / 32];
 
 	/*
 	 * Stop as soon as we find any character from s2.  Note that there
 	 * must be a NUL in s2; it suffices to stop when we find that, too.
+	 * A bitmap of s2 makes that one lookup per character of s1.
 	 */
-	for (p = s1;;) {
-		c = *p++;
-		spanp = s2;
-		do {
-			if ((sc = *spanp++) == c)
-				return (p - 1 - s1);
-		} while (sc != 0);
-	}
-	/* NOTREACHED */
+	memset(set, 0, sizeof(set));
+	set[0] = 1;
+	for (; *spanp != 0; spanp++)
+		set[*spanp >> 5] |= 1U << (*spanp & 31);
+	while (!IN_SET(set, *p))
+		p++;
+	return (p - (const unsigned char *)s1);
 }
@@ -36,13 +36,7 @@
 char *
 strpbrk(const char *s1, const char *s2)
 {
-	const char *scanp;
-	int c, sc;
-
-	while ((c = *s1++) != 0) {
-		for (scanp = s2; (sc = *scanp++) != 0;)
-			if (sc == c)
-				return ((char *)(s1 - 1));
-	}
-	return (NULL);
+	/* strcspn() stops at the first such character, or at the NUL. */
+	s1 += strcspn(s1, s2);
+	return (*s1 != 0 ? (char *)s1 : NULL);
 }
@@ -28,24 +28,29 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
 #include <string.h>
 
+#define	IN_SET(set, c)	((set)[(c) >> 5] & (1U << ((c) & 31)))
+
 /*
  * Span the string s2 (skip characters that are in s2).
  */
 size_t
 strspn(const char *s1, const char *s2)
 {
-	const char *p = s1, *spanp;
-	char c, sc;
+	const unsigned char *p = (const unsigned char *)s1;
+	const unsigned char *spanp = (const unsigned char *)s2;
+	uint32_t set[256 / 32];
 
 	/*
-	 * Skip any characters in s2, excluding the terminating \0.
+	 * A bitmap of the characters in s2, excluding the terminating \0,
+	 * makes each character of s1 one lookup however long s2 is.
 	 */
-cont:
-	c = *p++;
-	for (spanp = s2; (sc = *spanp++) != 0;)
-		if (sc == c)
-			goto cont;
-	return (p - 1 - s1);
+	memset(set, 0, sizeof(set));
+	for (; *spanp != 0; spanp++)
+		set[*spanp >> 5] |= 1U << (*spanp & 31);
+	while (IN_SET(set, *p))
+		p++;
+	return (p - (const unsigned char *)s1);
 }
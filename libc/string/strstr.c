@@ -31,26 +31,49 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
 #include <string.h>
 
 /*
  * Find the first occurrence of find in s.
+ *
+ * The haystack's length isn't known up front, and measuring all of it would
+ * make finding a match near its start cost as much as not finding one. So
+ * memmem() searches windows of it, which overlap by strlen(find) - 1 bytes.
+ * A window is at least four times the needle's length, which keeps the
+ * total work linear.
  */
+#define	STRSTR_WINDOW	4096
+
 char *
 strstr(const char *s, const char *find)
 {
-	char c, sc;
-	size_t len;
+	size_t len, window, n;
+	char *p;
+
+	if (find[0] == '\0')
+		return ((char *)s);
+	if (find[1] == '\0')
+		return (strchr(s, find[0]));
+
+	len = strlen(find);
+	if (len <= STRSTR_WINDOW / 4)
+		window = STRSTR_WINDOW;
+	else if (len <= SIZE_MAX / 4)
+		window = 4 * len;
+	else
+		window = SIZE_MAX;
 
-	if ((c = *find++) != 0) {
-		len = strlen(find);
-		do {
-			do {
-				if ((sc = *s++) == 0)
-					return (NULL);
-			} while (sc != c);
-		} while (strncmp(s, find, len) != 0);
-		s--;
+	for (;;) {
+		s = strchr(s, find[0]);
+		if (s == NULL)
+			return (NULL);
+		n = strnlen(s, window);
+		if (n < len)
+			return (NULL);
+		p = memmem(s, n, find, len);
+		if (p != NULL || n < window)
+			return (p);
+		s += n - len + 1;
 	}
-	return ((char *)s);
 }
@@ -66,9 +66,52 @@ def parse(f):
 
     return result
 
+def gen_index(name, comment, ctype, items, per_line):
+    result  = "\n/* %s */\n" % comment
+    result += "static const %s  %s[] = {\n" % (ctype, name)
+    for n in range(0, len(items), per_line):
+        result += "   " + "".join([" %s," % i for i in items[n:n+per_line]]) + "\n"
+    result += "};\n"
+    return result
+
 services = parse(sys.stdin)
 line = '/* generated by genserv.py - do not edit */\nstatic const char  _services[] = "\\\n'
 for s in services:
     line += str(s)+"\\\n"
 line += '\\0";\n'
+
+# index the names and aliases, and the ports, of the entries in the blob.
+# the sorts are stable so that, like a linear scan, lookups find the first of
+# equal entries.
+by_name = []
+by_port = []
+offset  = 0
+for s in services:
+    by_port.append(((s.port, s.proto), offset))
+    name = offset
+    by_name.append(((s.name, s.proto), name, offset))
+    name += 1 + len(s.name) + 4
+    for alias in s.aliases:
+        by_name.append(((alias, s.proto), name, offset))
+        name += 1 + len(alias)
+    offset = name
+
+if offset > 65535:
+    sys.stderr.write("too many services for 16-bit offsets\n")
+    sys.exit(1)
+
+by_name.sort(key=lambda i: i[0])
+by_port.sort(key=lambda i: i[0])
+
+line += "\n#define  _SERVICES_COUNT      %d\n" % len(by_port)
+line += "#define  _SERVICES_NAME_COUNT %d\n" % len(by_name)
+line += gen_index("_services_by_name",
+                  "offsets of the names and aliases above and of their entries,\n"
+                  " * sorted by name, then protocol",
+                  "struct { unsigned short name, entry; }",
+                  ["{%d,%d}" % (i[1], i[2]) for i in by_name], 6)
+line += gen_index("_services_by_port",
+                  "offsets of the entries above sorted by port, then protocol",
+                  "unsigned short",
+                  ["%d" % i[1] for i in by_port], 10)
 print line
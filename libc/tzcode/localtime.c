@@ -19,6 +19,11 @@
 #define TZ_ABBR_MAX_LEN 16
 #endif /* !defined TZ_ABBR_MAX_LEN */
 
+/* android-added: the longest POSIX TZ string at the end of a zone's data. */
+#ifndef TZ_STRING_MAX_LEN
+#define TZ_STRING_MAX_LEN 255
+#endif /* !defined TZ_STRING_MAX_LEN */
+
 #ifndef TZ_ABBR_CHAR_SET
 #define TZ_ABBR_CHAR_SET \
     "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 :+-._"
@@ -146,7 +151,7 @@ struct rule {
 
 /* NOTE: all internal functions assume that _tzLock() was already called */
 
-static int __bionic_open_tzdata(const char*, int*);
+static const char * __bionic_find_tzdata(const char*, int*);
 static int_fast32_t detzcode(const char * codep);
 static time_t   detzcode64(const char * codep);
 static int      differ_by_repeat(time_t t1, time_t t0);
@@ -163,6 +168,11 @@ static struct tm *  gmtsub(const time_t * timep, const int_fast32_t offset,
                 struct tm * tmp, const struct state * sp); // android-changed: added sp.
 static struct tm *  localsub(const time_t * timep, int_fast32_t offset,
                 struct tm * tmp, const struct state * sp); // android-changed: added sp.
+// android-added: localsub for the lock-free paths; see lcl_seq.
+static struct tm *  localsub_unlocked(const time_t * timep, int_fast32_t offset,
+                struct tm * tmp, const struct state * sp);
+static struct tm *  localsub_common(const time_t * timep, int_fast32_t offset,
+                struct tm * tmp, const struct state * sp, int set_tzname);
 static int      increment_overflow(int * number, int delta);
 static int      leaps_thru_end_of(int y) ATTRIBUTE_PURE;
 static int      increment_overflow32(int_fast32_t * number, int delta);
@@ -346,48 +356,35 @@ tzload(register const char* name, register struct state* const sp,
 {
     register const char *       p;
     register int            i;
-    register int            fid;
     register int            stored;
     register int            nread;
-    typedef union {
-        struct tzhead   tzhead;
-        char        buf[2 * sizeof(struct tzhead) +
-                    2 * sizeof *sp +
-                    4 * TZ_MAX_TIMES];
-    } u_t;
-#ifdef ALL_STATE
-    register u_t *			up;
-
-    up = (u_t *) calloc(1, sizeof *up);
-    if (up == NULL)
-        return -1;
-#else /* !defined ALL_STATE */
-    u_t				u;
-    register u_t * const		up = &u;
-#endif /* !defined ALL_STATE */
+    // android-changed: the zone's data is parsed in place, out of the mapped tzdata file,
+    // with 'base' moving on to the 64-bit data instead of that being copied down.
+    const char *            base;
+    const struct tzhead *   tzhp;
 
     sp->goback = sp->goahead = FALSE;
     if (name == NULL && (name = TZDEFAULT) == NULL)
-        goto oops;
+        return -1;
     int toread;
-    fid = __bionic_open_tzdata(name, &toread);
-    if (fid < 0) {
+    base = __bionic_find_tzdata(name, &toread);
+    if (base == NULL)
         return -1;
-    }
-    nread = read(fid, up->buf, toread);
-    if (close(fid) < 0 || nread <= 0)
-        goto oops;
+    nread = toread;
     for (stored = 4; stored <= 8; stored *= 2) {
         int     ttisstdcnt;
         int     ttisgmtcnt;
 
-        ttisstdcnt = (int) detzcode(up->tzhead.tzh_ttisstdcnt);
-        ttisgmtcnt = (int) detzcode(up->tzhead.tzh_ttisgmtcnt);
-        sp->leapcnt = (int) detzcode(up->tzhead.tzh_leapcnt);
-        sp->timecnt = (int) detzcode(up->tzhead.tzh_timecnt);
-        sp->typecnt = (int) detzcode(up->tzhead.tzh_typecnt);
-        sp->charcnt = (int) detzcode(up->tzhead.tzh_charcnt);
-        p = up->tzhead.tzh_charcnt + sizeof up->tzhead.tzh_charcnt;
+        if (nread < (int) sizeof *tzhp)
+            return -1;
+        tzhp = (const struct tzhead *) base;
+        ttisstdcnt = (int) detzcode(tzhp->tzh_ttisstdcnt);
+        ttisgmtcnt = (int) detzcode(tzhp->tzh_ttisgmtcnt);
+        sp->leapcnt = (int) detzcode(tzhp->tzh_leapcnt);
+        sp->timecnt = (int) detzcode(tzhp->tzh_timecnt);
+        sp->typecnt = (int) detzcode(tzhp->tzh_typecnt);
+        sp->charcnt = (int) detzcode(tzhp->tzh_charcnt);
+        p = tzhp->tzh_charcnt + sizeof tzhp->tzh_charcnt;
         if (sp->leapcnt < 0 || sp->leapcnt > TZ_MAX_LEAPS ||
             sp->typecnt <= 0 || sp->typecnt > TZ_MAX_TYPES ||
             sp->timecnt < 0 || sp->timecnt > TZ_MAX_TIMES ||
@@ -395,7 +392,7 @@ tzload(register const char* name, register struct state* const sp,
             (ttisstdcnt != sp->typecnt && ttisstdcnt != 0) ||
             (ttisgmtcnt != sp->typecnt && ttisgmtcnt != 0))
                 goto oops;
-        if (nread - (p - up->buf) <
+        if (nread - (p - base) <
             sp->timecnt * stored +      /* ats */
             sp->timecnt +           /* types */
             sp->typecnt * 6 +       /* ttinfos */
@@ -508,11 +505,10 @@ tzload(register const char* name, register struct state* const sp,
         /*
         ** If this is an old file, we're done.
         */
-        if (up->tzhead.tzh_version[0] == '\0')
+        if (tzhp->tzh_version[0] == '\0')
             break;
-        nread -= p - up->buf;
-        for (i = 0; i < nread; ++i)
-            up->buf[i] = p[i];
+        nread -= p - base;
+        base = p;
         /*
         ** If this is a narrow integer time_t system, we're done.
         */
@@ -520,13 +516,16 @@ tzload(register const char* name, register struct state* const sp,
             break;
     }
     if (doextend && nread > 2 &&
-        up->buf[0] == '\n' && up->buf[nread - 1] == '\n' &&
+        base[0] == '\n' && base[nread - 1] == '\n' &&
+        nread - 2 <= TZ_STRING_MAX_LEN &&
         sp->typecnt + 2 <= TZ_MAX_TYPES) {
             struct state    ts;
             register int    result;
+            char            tzstring[TZ_STRING_MAX_LEN + 1];
 
-            up->buf[nread - 1] = '\0';
-            result = tzparse(&up->buf[1], &ts, FALSE);
+            memcpy(tzstring, &base[1], nread - 2);
+            tzstring[nread - 2] = '\0';
+            result = tzparse(tzstring, &ts, FALSE);
             if (result == 0 && ts.typecnt == 2 &&
                 sp->charcnt + ts.charcnt <= TZ_MAX_CHARS) {
                     for (i = 0; i < 2; ++i)
@@ -604,14 +603,8 @@ tzload(register const char* name, register struct state* const sp,
                 }
         }
         sp->defaulttype = i;
-#ifdef ALL_STATE
-        free(up);
-#endif /* defined ALL_STATE */
         return 0;
 oops:
-#ifdef ALL_STATE
-        free(up);
-#endif /* defined ALL_STATE */
         return -1;
 }
 
@@ -1170,6 +1163,91 @@ gmtload(struct state * const sp)
         (void) tzparse(gmt, sp, TRUE);
 }
 
+/*
+** BEGIN android-added: a lock-free fast path for localtime_r and mktime.
+**
+** lclmem and the key below only change under _tzLock, with lcl_seq odd while they do. A zone
+** is loaded into lcl_scratch and only then copied over lclmem, so a reader never sees fields
+** that tzload hasn't yet checked. A reader that sees the same even lcl_seq before and after
+** converting knows that it used one consistent lclmem. If the key held too, tzset_locked would
+** have chosen the same zone: TZ has only changed by way of setenv(3) and friends, which bump
+** lcl_tz_generation, and if TZ was unset, persist.sys.timezone's serial hasn't moved.
+** Changes made by writing to environ directly aren't noticed.
+*/
+
+#include <bionic_atomic_inline.h>
+#include <bionic_time.h>
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h> // For __system_property_get and __system_property_serial.
+
+static volatile unsigned int    lcl_seq;
+static volatile unsigned int    lcl_tz_generation;
+static struct state             lcl_scratch;
+
+static int                      lcl_key_valid;
+static unsigned int             lcl_key_generation;
+static const prop_info *        lcl_key_pi; /* persist.sys.timezone if TZ was unset, else NULL */
+static unsigned int             lcl_key_serial;
+
+void
+__bionic_tz_env_changed(const char * name)
+{
+    if (strncmp(name, "TZ", 2) == 0 && (name[2] == '\0' || name[2] == '=')) {
+        ANDROID_MEMBAR_FULL();
+        ++lcl_tz_generation;
+    }
+}
+
+/* Whether tzset_locked would keep lclmem as it is. */
+static int
+lcl_key_holds(void)
+{
+    return lcl_key_valid && lcl_key_generation == lcl_tz_generation &&
+        (lcl_key_pi == NULL || lcl_key_serial == __system_property_serial(lcl_key_pi));
+}
+
+/* Returns the lcl_seq to pass to lcl_read_end, or an odd one if lclmem can't be used unlocked. */
+static unsigned int
+lcl_read_begin(void)
+{
+    unsigned int seq = lcl_seq;
+    ANDROID_MEMBAR_FULL();
+    return lcl_key_holds() ? seq : 1;
+}
+
+/* Whether everything read of lclmem since lcl_read_begin came from one consistent zone. */
+static int
+lcl_read_end(unsigned int seq)
+{
+    ANDROID_MEMBAR_FULL();
+    return lcl_seq == seq;
+}
+
+static void
+lcl_write_begin(void)
+{
+    ++lcl_seq;
+    ANDROID_MEMBAR_FULL();
+}
+
+static void
+lcl_write_end(void)
+{
+    ANDROID_MEMBAR_FULL();
+    ++lcl_seq;
+}
+
+/* Copies the zone loaded into lcl_scratch over lclmem. */
+static void
+lcl_publish(void)
+{
+    lcl_write_begin();
+    *lclptr = lcl_scratch;
+    lcl_write_end();
+}
+
+/* END android-added */
+
 #ifndef STD_INSPIRED
 /*
 ** A non-static declaration of tzsetwall in a system header file
@@ -1183,6 +1261,7 @@ tzsetwall(void)
     if (lcl_is_set < 0)
         return;
     lcl_is_set = -1;
+    lcl_key_valid = FALSE; // android-added: tzset_locked must look again.
 
 #ifdef ALL_STATE
     if (lclptr == NULL) {
@@ -1193,15 +1272,15 @@ tzsetwall(void)
         }
     }
 #endif /* defined ALL_STATE */
-    if (tzload(NULL, lclptr, TRUE) != 0)
-        gmtload(lclptr);
+    // android-changed: loaded into lcl_scratch; see lcl_seq.
+    if (tzload(NULL, &lcl_scratch, TRUE) != 0)
+        gmtload(&lcl_scratch);
+    lcl_publish();
     settzname();
 }
 
-#include <sys/system_properties.h> // For __system_property_get.
-
 static void
-tzset_locked(void)
+tzset_lookup_locked(void) // android-changed: was tzset_locked.
 {
     register const char *   name = NULL;
 
@@ -1233,26 +1312,64 @@ tzset_locked(void)
         }
     }
 #endif /* defined ALL_STATE */
+    // BEGIN android-changed: loaded into lcl_scratch; see lcl_seq.
     if (*name == '\0') {
         /*
         ** User wants it fast rather than right.
         */
-        lclptr->leapcnt = 0;        /* so, we're off a little */
-        lclptr->timecnt = 0;
-        lclptr->typecnt = 0;
-        lclptr->ttis[0].tt_isdst = 0;
-        lclptr->ttis[0].tt_gmtoff = 0;
-        lclptr->ttis[0].tt_abbrind = 0;
-        (void) strcpy(lclptr->chars, gmt);
-    } else if (tzload(name, lclptr, TRUE) != 0)
-        if (name[0] == ':' || tzparse(name, lclptr, FALSE) != 0)
-            (void) gmtload(lclptr);
+        lcl_scratch = *lclptr;
+        lcl_scratch.leapcnt = 0;        /* so, we're off a little */
+        lcl_scratch.timecnt = 0;
+        lcl_scratch.typecnt = 0;
+        lcl_scratch.ttis[0].tt_isdst = 0;
+        lcl_scratch.ttis[0].tt_gmtoff = 0;
+        lcl_scratch.ttis[0].tt_abbrind = 0;
+        (void) strcpy(lcl_scratch.chars, gmt);
+    } else if (tzload(name, &lcl_scratch, TRUE) != 0)
+        if (name[0] == ':' || tzparse(name, &lcl_scratch, FALSE) != 0)
+            (void) gmtload(&lcl_scratch);
+    lcl_publish();
+    // END android-changed
     settzname();
 }
 
+static void
+tzset_locked(void)
+{
+    // BEGIN android-added: only look again if the key no longer holds; see lcl_seq.
+    if (lcl_key_holds())
+        return;
+
+    // Sample the key before reading what it stands for, so a change made meanwhile is seen.
+    unsigned int generation = lcl_tz_generation;
+    ANDROID_MEMBAR_FULL();
+    int tz_is_set = (getenv("TZ") != NULL);
+    const prop_info* pi = NULL;
+    unsigned int serial = 0;
+    if (!tz_is_set && (pi = __system_property_find("persist.sys.timezone")) != NULL)
+        serial = __system_property_serial(pi);
+    ANDROID_MEMBAR_FULL();
+
+    tzset_lookup_locked();
+
+    // Without the property to watch, or with a TZ too long to remember, look every time.
+    lcl_write_begin();
+    lcl_key_generation = generation;
+    lcl_key_pi = pi;
+    lcl_key_serial = serial;
+    lcl_key_valid = lcl_is_set != 0 && (tz_is_set || pi != NULL);
+    lcl_write_end();
+    // END android-added
+}
+
 void
 tzset(void)
 {
+    // android-added: strftime calls this every time, so don't take the lock for nothing.
+    unsigned int seq = lcl_read_begin();
+    if ((seq & 1) == 0 && lcl_read_end(seq))
+        return;
+
     _tzLock();
     tzset_locked();
     _tzUnlock();
@@ -1271,6 +1388,24 @@ tzset(void)
 static struct tm *
 localsub(const time_t * const timep, const int_fast32_t offset,
          struct tm * const tmp, const struct state * sp) // android-changed: added sp.
+{
+    return localsub_common(timep, offset, tmp, sp, TRUE);
+}
+
+// BEGIN android-added: a read that lcl_read_end may yet throw away mustn't touch tzname,
+// which only changes under _tzLock.
+static struct tm *
+localsub_unlocked(const time_t * const timep, const int_fast32_t offset,
+                  struct tm * const tmp, const struct state * sp)
+{
+    return localsub_common(timep, offset, tmp, sp, FALSE);
+}
+// END android-added
+
+static struct tm *
+localsub_common(const time_t * const timep, const int_fast32_t offset,
+                struct tm * const tmp, const struct state * sp,
+                const int set_tzname) // android-changed: added sp and set_tzname.
 {
     register const struct ttinfo *  ttisp;
     register int            i;
@@ -1311,7 +1446,7 @@ localsub(const time_t * const timep, const int_fast32_t offset,
             if (newt < sp->ats[0] ||
                 newt > sp->ats[sp->timecnt - 1])
                     return NULL;    /* "cannot happen" */
-            result = localsub(&newt, offset, tmp, sp); // android-changed: added sp.
+            result = localsub_common(&newt, offset, tmp, sp, set_tzname); // android-changed.
             if (result == tmp) {
                 register time_t newy;
 
@@ -1349,7 +1484,10 @@ localsub(const time_t * const timep, const int_fast32_t offset,
     */
     result = timesub(&t, ttisp->tt_gmtoff, sp, tmp);
     tmp->tm_isdst = ttisp->tt_isdst;
-    tzname[tmp->tm_isdst] = &sp->chars[ttisp->tt_abbrind];
+    // android-changed: only the process's own timezone sets tzname, since the states
+    // localtime_tz uses are shared and freed when they drop out of the cache.
+    if (set_tzname && sp == lclptr)
+        tzname[tmp->tm_isdst] = &sp->chars[ttisp->tt_abbrind];
 #ifdef TM_ZONE
     tmp->TM_ZONE = &sp->chars[ttisp->tt_abbrind];
 #endif /* defined TM_ZONE */
@@ -1371,6 +1509,20 @@ localtime_r(const time_t * const timep, struct tm * tmp)
 {
     struct tm*  result;
 
+    // BEGIN android-added: lock-free while the timezone is unchanged; see lcl_seq.
+    unsigned int seq = lcl_read_begin();
+    if ((seq & 1) == 0) {
+        struct tm tm;
+        result = localsub_unlocked(timep, 0L, &tm, lclptr);
+        if (lcl_read_end(seq)) {
+            if (result == NULL)
+                return NULL;
+            *tmp = tm;
+            return tmp;
+        }
+    }
+    // END android-added
+
     _tzLock();
     tzset_locked();
     result = localsub(timep, 0L, tmp, NULL); // android-changed: extra parameter.
@@ -1694,6 +1846,103 @@ tmcomp(register const struct tm * const atmp,
     return result;
 }
 
+/*
+** BEGIN android-added: mktime without the binary search, when there's only one answer.
+*/
+
+/* The days from 1970-01-01 to the given day (with a month of 0-11) of the Gregorian calendar. */
+static int_fast64_t
+days_from_civil(int_fast64_t y, const int m, const int d)
+{
+    int_fast64_t    era;
+    int             yoe, doy, doe;
+
+    if (m < 2)
+        --y;
+    era = ((y >= 0) ? y : y - (YEARSPERREPEAT - 1)) / YEARSPERREPEAT;
+    yoe = (int) (y - era * YEARSPERREPEAT);
+    doy = (153 * ((m < 2) ? m + 10 : m - 2) + 2) / 5 + d - 1;
+    doe = yoe * DAYSPERNYEAR + yoe / 4 - yoe / 100 + doy;
+    /* Counted from 0000-03-01, which was 719468 days before the epoch. */
+    return era * (SECSPERREPEAT / SECSPERDAY) + doe - 719468;
+}
+
+/* The seconds from the epoch to the date and time in 'tmp', taken as UT. */
+static int_fast64_t
+tm_seconds(const struct tm * const tmp)
+{
+    return days_from_civil((int_fast64_t) tmp->tm_year + TM_YEAR_BASE, tmp->tm_mon,
+        tmp->tm_mday) * SECSPERDAY + tmp->tm_hour * SECSPERHOUR + tmp->tm_min * SECSPERMIN +
+        tmp->tm_sec;
+}
+
+/*
+** Finds the time that funcp turns into yourtm's normalized fields straight from its day number
+** and the offset from UT then, rather than by searching. Any other time with the same fields
+** would be within the zone's spread of offsets of this one, so if there's no transition that
+** close, it's the only one. Otherwise (near a gap or a repeated hour, or with leap seconds or
+** the wrong tm_isdst), returns FALSE and leaves it to the search.
+*/
+static int
+time2direct(const struct tm * const yourtm,
+            struct tm *(*const funcp)(const time_t*, int_fast32_t, struct tm*, const struct state*),
+            const int_fast32_t offset, const struct state * sp, time_t * const tp)
+{
+    struct tm       mytm;
+    int_fast64_t    local, guess, spread;
+    int_fast32_t    lo, hi;
+    time_t          t;
+    int             i, j, mid;
+
+    local = tm_seconds(yourtm);
+    t = (time_t) local;
+    if (t != local || (*funcp)(&t, offset, &mytm, sp) == NULL)
+        return FALSE;
+    /*
+    ** The offset in effect at 'local' taken as UT is the one at the answer too,
+    ** unless the answer is near a transition.
+    */
+    guess = local - (tm_seconds(&mytm) - local);
+    t = (time_t) guess;
+    if (t != guess || (*funcp)(&t, offset, &mytm, sp) == NULL || tmcomp(&mytm, yourtm) != 0)
+        return FALSE;
+    if (yourtm->tm_isdst >= 0 && mytm.tm_isdst != yourtm->tm_isdst)
+        return FALSE;
+
+    if (sp == NULL)
+        sp = (const struct state *) ((funcp == localsub) ? lclptr : gmtptr);
+    if (sp->leapcnt != 0)
+        return FALSE;
+    if (sp->timecnt != 0) {
+        if ((sp->goback && t < sp->ats[0]) ||
+            (sp->goahead && t > sp->ats[sp->timecnt - 1]))
+                return FALSE;
+        lo = hi = sp->ttis[0].tt_gmtoff;
+        for (i = 1; i < sp->typecnt; ++i) {
+            if (sp->ttis[i].tt_gmtoff < lo)
+                lo = sp->ttis[i].tt_gmtoff;
+            if (sp->ttis[i].tt_gmtoff > hi)
+                hi = sp->ttis[i].tt_gmtoff;
+        }
+        spread = (int_fast64_t) hi - lo + 1;
+        /* Is the first transition after t - spread also after t + spread? */
+        i = 0;
+        j = sp->timecnt;
+        while (i < j) {
+            mid = i + (j - i) / 2;
+            if (sp->ats[mid] <= t - spread)
+                i = mid + 1;
+            else    j = mid;
+        }
+        if (i < sp->timecnt && sp->ats[i] <= t + spread)
+            return FALSE;
+    }
+    *tp = t;
+    return TRUE;
+}
+
+/* END android-added */
+
 static time_t
 time2sub(struct tm * const tmp,
          struct tm *(*const funcp)(const time_t*, int_fast32_t, struct tm*, const struct state*),
@@ -1779,23 +2028,15 @@ time2sub(struct tm * const tmp,
         saved_seconds = yourtm.tm_sec;
         yourtm.tm_sec = 0;
     }
+    // android-added: see time2direct.
+    if (time2direct(&yourtm, funcp, offset, sp, &t))
+        goto label;
     /*
     ** Do a binary search (this works whatever time_t's type is).
     */
-    if (!TYPE_SIGNED(time_t)) {
-        lo = 0;
-        hi = lo - 1;
-    } else if (!TYPE_INTEGRAL(time_t)) {
-        if (sizeof(time_t) > sizeof(float))
-            hi = (time_t) DBL_MAX;
-        else    hi = (time_t) FLT_MAX;
-        lo = -hi;
-    } else {
-        lo = 1;
-        for (i = 0; i < (int) TYPE_BIT(time_t) - 1; ++i)
-            lo *= 2;
-        hi = -(lo + 1);
-    }
+    // android-changed: doubling lo overflowed, which the compiler is free to miscompile.
+    lo = time_t_min;
+    hi = time_t_max;
     for ( ; ; ) {
         t = lo / 2 + hi / 2;
         if (t < lo)
@@ -1979,6 +2220,18 @@ time1(struct tm * const tmp,
 time_t
 mktime(struct tm * const tmp)
 {
+    // BEGIN android-added: lock-free while the timezone is unchanged; see lcl_seq.
+    unsigned int seq = lcl_read_begin();
+    if ((seq & 1) == 0 && tmp != NULL) {
+        struct tm tm = *tmp;
+        time_t result = time1(&tm, localsub_unlocked, 0L, lclptr);
+        if (lcl_read_end(seq)) {
+            *tmp = tm;
+            return result;
+        }
+    }
+    // END android-added
+
     _tzLock();
     tzset_locked();
     time_t result = time1(tmp, localsub, 0L, NULL); // android-changed: extra parameter.
@@ -2107,160 +2360,246 @@ posix2time(time_t t)
 // BEGIN android-added
 
 #include <assert.h>
+#include <limits.h>
 #include <stdint.h>
 #include <arpa/inet.h> // For ntohl(3).
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-static int to_int(unsigned char* s) {
+static int to_int(const unsigned char* s) {
   return (s[0] << 24) | (s[1] << 16) | (s[2] << 8) | s[3];
 }
 
-static int __bionic_open_tzdata_path(const char* path, const char* olson_id, int* data_size) {
+// byte[12] tzdata_version  -- "tzdata2012f\0"
+// int index_offset
+// int data_offset
+// int zonetab_offset
+struct bionic_tzdata_header {
+  char tzdata_version[12];
+  int32_t index_offset;
+  int32_t data_offset;
+  int32_t zonetab_offset;
+};
+
+// Each index entry is a NUL-padded Olson id followed by the offset of the zone's data
+// (relative to data_offset), its length, and its raw GMT offset. ZoneCompactor writes
+// the entries sorted by id.
+#define TZDATA_NAME_LENGTH 40
+#define TZDATA_ENTRY_SIZE (TZDATA_NAME_LENGTH + 3 * sizeof(int32_t))
+
+// A tzdata file, mapped for the life of the process. Zone data is parsed straight out
+// of the mapping, so finding a zone costs no system calls once the file is mapped.
+struct bionic_tzdata {
+  const char* data;
+  size_t size;
+  const unsigned char* index;
+  size_t id_count;
+  size_t data_offset;
+};
+
+static void __bionic_map_tzdata_path(const char* path, struct bionic_tzdata* tzdata) {
   int fd = TEMP_FAILURE_RETRY(open(path, OPEN_MODE));
   if (fd == -1) {
     XLOG(("%s: could not open \"%s\": %s\n", __FUNCTION__, path, strerror(errno)));
-    return -2; // Distinguish failure to find any data from failure to find a specific id.
+    return;
   }
 
-  // byte[12] tzdata_version  -- "tzdata2012f\0"
-  // int index_offset
-  // int data_offset
-  // int zonetab_offset
-  struct bionic_tzdata_header {
-    char tzdata_version[12];
-    int32_t index_offset;
-    int32_t data_offset;
-    int32_t zonetab_offset;
-  } header;
-  memset(&header, 0, sizeof(header));
-  ssize_t bytes_read = TEMP_FAILURE_RETRY(read(fd, &header, sizeof(header)));
-  if (bytes_read != sizeof(header)) {
+  struct stat sb;
+  int rc = fstat(fd, &sb);
+  if (rc == -1 || sb.st_size < (off_t) sizeof(struct bionic_tzdata_header)) {
     fprintf(stderr, "%s: could not read header of \"%s\": %s\n",
-            __FUNCTION__, path, (bytes_read == -1) ? strerror(errno) : "short read");
+            __FUNCTION__, path, (rc == -1) ? strerror(errno) : "short file");
     close(fd);
-    return -1;
+    return;
+  }
+  size_t size = sb.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "%s: could not map \"%s\": %s\n", __FUNCTION__, path, strerror(errno));
+    return;
   }
 
+  struct bionic_tzdata_header header;
+  memcpy(&header, map, sizeof(header));
   if (strncmp(header.tzdata_version, "tzdata", 6) != 0 || header.tzdata_version[11] != 0) {
     fprintf(stderr, "%s: bad magic in \"%s\": \"%.6s\"\n",
             __FUNCTION__, path, header.tzdata_version);
-    close(fd);
-    return -1;
+    munmap(map, size);
+    return;
   }
 
-#if 0
-  fprintf(stderr, "version: %s\n", header.tzdata_version);
-  fprintf(stderr, "index_offset = %d\n", ntohl(header.index_offset));
-  fprintf(stderr, "data_offset = %d\n", ntohl(header.data_offset));
-  fprintf(stderr, "zonetab_offset = %d\n", ntohl(header.zonetab_offset));
-#endif
-
-  if (TEMP_FAILURE_RETRY(lseek(fd, ntohl(header.index_offset), SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: couldn't seek to index in \"%s\": %s\n",
-            __FUNCTION__, path, strerror(errno));
-    close(fd);
-    return -1;
+  uint32_t index_offset = ntohl(header.index_offset);
+  uint32_t data_offset = ntohl(header.data_offset);
+  if (index_offset > data_offset || data_offset > size) {
+    fprintf(stderr, "%s: bad offsets in \"%s\"\n", __FUNCTION__, path);
+    munmap(map, size);
+    return;
   }
 
-  off_t specific_zone_offset = -1;
+  tzdata->data = map;
+  tzdata->size = size;
+  tzdata->index = (const unsigned char*) map + index_offset;
+  tzdata->id_count = (data_offset - index_offset) / TZDATA_ENTRY_SIZE;
+  tzdata->data_offset = data_offset;
+}
 
-  static const size_t NAME_LENGTH = 40;
-  unsigned char buf[NAME_LENGTH + 3 * sizeof(int32_t)];
+static const char* __bionic_find_tzdata_path(const struct bionic_tzdata* tzdata,
+                                             const char* olson_id, int* data_size) {
+  if (tzdata->data == NULL) {
+    return NULL;
+  }
 
-  size_t id_count = (ntohl(header.data_offset) - ntohl(header.index_offset)) / sizeof(buf);
-  for (size_t i = 0; i < id_count; ++i) {
-    if (TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf))) != (ssize_t) sizeof(buf)) {
-      break;
+  size_t lo = 0;
+  size_t hi = tzdata->id_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const unsigned char* entry = tzdata->index + mid * TZDATA_ENTRY_SIZE;
+    int cmp = strncmp(olson_id, (const char*) entry, TZDATA_NAME_LENGTH);
+    if (cmp == 0 && strlen(olson_id) > TZDATA_NAME_LENGTH) {
+      cmp = 1;
     }
-
-    char this_id[NAME_LENGTH + 1];
-    memcpy(this_id, buf, NAME_LENGTH);
-    this_id[NAME_LENGTH] = '\0';
-
-    if (strcmp(this_id, olson_id) == 0) {
-      specific_zone_offset = to_int(buf + NAME_LENGTH) + ntohl(header.data_offset);
-      *data_size = to_int(buf + NAME_LENGTH + sizeof(int32_t));
-      break;
+    if (cmp < 0) {
+      hi = mid;
+    } else if (cmp > 0) {
+      lo = mid + 1;
+    } else {
+      size_t offset = tzdata->data_offset + (uint32_t) to_int(entry + TZDATA_NAME_LENGTH);
+      size_t length = (uint32_t) to_int(entry + TZDATA_NAME_LENGTH + sizeof(int32_t));
+      if (offset > tzdata->size || length > tzdata->size - offset || length > INT_MAX) {
+        fprintf(stderr, "%s: bad data for zone \"%s\"\n", __FUNCTION__, olson_id);
+        return NULL;
+      }
+      // TODO: check that there's TZ_MAGIC at this offset, so we can fall back to the other file if not.
+      *data_size = length;
+      return tzdata->data + offset;
     }
   }
 
-  if (specific_zone_offset == -1) {
-    XLOG(("%s: couldn't find zone \"%s\"\n", __FUNCTION__, olson_id));
-    close(fd);
-    return -1;
-  }
+  XLOG(("%s: couldn't find zone \"%s\"\n", __FUNCTION__, olson_id));
+  return NULL;
+}
 
-  if (TEMP_FAILURE_RETRY(lseek(fd, specific_zone_offset, SEEK_SET)) == -1) {
-    fprintf(stderr, "%s: could not seek to %ld in \"%s\": %s\n",
-            __FUNCTION__, specific_zone_offset, path, strerror(errno));
-    close(fd);
-    return -1;
+// Mapped by the first lookup, under _tzLock().
+static struct bionic_tzdata __bionic_data_tzdata;
+static struct bionic_tzdata __bionic_system_tzdata;
+static int __bionic_tzdata_mapped;
+
+static const char* __bionic_find_tzdata(const char* olson_id, int* data_size) {
+  if (!__bionic_tzdata_mapped) {
+    // TODO: use $ANDROID_DATA and $ANDROID_ROOT like libcore, to support bionic on the host.
+    __bionic_map_tzdata_path("/data/misc/zoneinfo/tzdata", &__bionic_data_tzdata);
+    __bionic_map_tzdata_path("/system/usr/share/zoneinfo/tzdata", &__bionic_system_tzdata);
+    __bionic_tzdata_mapped = 1;
   }
 
-  // TODO: check that there's TZ_MAGIC at this offset, so we can fall back to the other file if not.
-
-  return fd;
-}
-
-static int __bionic_open_tzdata(const char* olson_id, int* data_size) {
-  // TODO: use $ANDROID_DATA and $ANDROID_ROOT like libcore, to support bionic on the host.
-  int fd = __bionic_open_tzdata_path("/data/misc/zoneinfo/tzdata", olson_id, data_size);
-  if (fd < 0) {
-    fd = __bionic_open_tzdata_path("/system/usr/share/zoneinfo/tzdata", olson_id, data_size);
-    if (fd == -2) {
+  const char* data = __bionic_find_tzdata_path(&__bionic_data_tzdata, olson_id, data_size);
+  if (data == NULL) {
+    data = __bionic_find_tzdata_path(&__bionic_system_tzdata, olson_id, data_size);
+    if (__bionic_system_tzdata.data == NULL) {
       // The first thing that 'recovery' does is try to format the current time. It doesn't have
       // any tzdata available, so we must not abort here --- doing so breaks the recovery image!
       fprintf(stderr, "%s: couldn't find any tzdata when looking for %s!\n", __FUNCTION__, olson_id);
     }
   }
-  return fd;
+  return data;
+}
+
+// Caches the most recently used timezones (http://b/8270865). Each one is loaded once into a
+// state that's never modified afterwards, so callers use it in place without holding _tzLock.
+// One that's evicted while in use is freed by the last caller to release it.
+#define BIONIC_TZ_CACHE_SIZE 8
+
+struct bionic_cached_tz {
+  int refs; // One for the cache, plus one per caller using it. Guarded by _tzLock.
+  char* name;
+  struct state state;
+};
+
+static struct bionic_cached_tz* gCachedTimeZones[BIONIC_TZ_CACHE_SIZE]; // Most recent first.
+
+static void __bionic_tz_release_locked(struct bionic_cached_tz* tz) {
+  if (--tz->refs == 0) {
+    free(tz->name);
+    free(tz);
+  }
 }
 
-// Caches the most recent timezone (http://b/8270865).
-static int __bionic_tzload_cached(const char* name, struct state* const sp, const int doextend) {
+static void __bionic_tz_release(struct bionic_cached_tz* tz) {
   _tzLock();
+  __bionic_tz_release_locked(tz);
+  _tzUnlock();
+}
 
-  // Our single-item cache.
-  static char* gCachedTimeZoneName;
-  static struct state gCachedTimeZone;
+// Returns the named timezone with a reference the caller must release, or NULL if we're out
+// of memory. A timezone we can't load is cached as gmt, which is what callers fall back to.
+static struct bionic_cached_tz* __bionic_tzload_cached(const char* name) {
+  _tzLock();
 
-  // Do we already have this timezone cached?
-  if (gCachedTimeZoneName != NULL && strcmp(name, gCachedTimeZoneName) == 0) {
-    *sp = gCachedTimeZone;
-    _tzUnlock();
-    return 0;
+  struct bionic_cached_tz* tz = NULL;
+  size_t i;
+  for (i = 0; i < BIONIC_TZ_CACHE_SIZE && gCachedTimeZones[i] != NULL; ++i) {
+    if (strcmp(name, gCachedTimeZones[i]->name) == 0) {
+      tz = gCachedTimeZones[i];
+      break;
+    }
   }
 
-  // Can we load it?
-  int rc = tzload(name, sp, doextend);
-  if (rc == 0) {
-    // Update the cache.
-    free(gCachedTimeZoneName);
-    gCachedTimeZoneName = strdup(name);
-    gCachedTimeZone = *sp;
+  if (tz == NULL) {
+    tz = malloc(sizeof(*tz));
+    if (tz == NULL || (tz->name = strdup(name)) == NULL) {
+      free(tz);
+      _tzUnlock();
+      return NULL;
+    }
+    if (tzload(name, &tz->state, TRUE) != 0) {
+      // TODO: not sure what's best here, but for now, we fall back to gmt.
+      gmtload(&tz->state);
+    }
+    tz->refs = 1;
+    // Make room by evicting the least recently used timezone.
+    if (i == BIONIC_TZ_CACHE_SIZE) {
+      --i;
+      __bionic_tz_release_locked(gCachedTimeZones[i]);
+    }
   }
 
+  // Move it to the front, over its old slot or the free one.
+  memmove(&gCachedTimeZones[1], &gCachedTimeZones[0], i * sizeof(gCachedTimeZones[0]));
+  gCachedTimeZones[0] = tz;
+  ++tz->refs;
+
   _tzUnlock();
-  return rc;
+  return tz;
 }
 
 // Non-standard API: mktime(3) but with an explicit timezone parameter.
 time_t mktime_tz(struct tm* const tmp, const char* tz) {
-  struct state st;
-  if (__bionic_tzload_cached(tz, &st, TRUE) != 0) {
-    // TODO: not sure what's best here, but for now, we fall back to gmt.
-    gmtload(&st);
+  struct bionic_cached_tz* cached = __bionic_tzload_cached(tz);
+  if (cached == NULL) {
+    // Without the memory for even gmt's own copy, use the global one.
+    _tzLock();
+    time_t result = time1(tmp, gmtsub, 0L, NULL);
+    _tzUnlock();
+    return result;
   }
-  return time1(tmp, localsub, 0L, &st);
+  time_t result = time1(tmp, localsub, 0L, &cached->state);
+  __bionic_tz_release(cached);
+  return result;
 }
 
 // Non-standard API: localtime(3) but with an explicit timezone parameter.
 void localtime_tz(const time_t* const timep, struct tm* tmp, const char* tz) {
-  struct state st;
-  if (__bionic_tzload_cached(tz, &st, TRUE) != 0) {
-    // TODO: not sure what's best here, but for now, we fall back to gmt.
-    gmtload(&st);
+  struct bionic_cached_tz* cached = __bionic_tzload_cached(tz);
+  if (cached == NULL) {
+    // Without the memory for even gmt's own copy, use the global one.
+    _tzLock();
+    gmtsub(timep, 0L, tmp, NULL);
+    _tzUnlock();
+    return;
   }
-  localsub(timep, 0L, tmp, &st);
+  localsub(timep, 0L, tmp, &cached->state);
+  __bionic_tz_release(cached);
 }
 
 // END android-added
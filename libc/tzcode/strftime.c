@@ -113,6 +113,8 @@ static const struct lc_time_T   C_time_locale = {
 
 static char *   _add(const char *, char *, const char *, int);
 static char *   _conv(int, const char *, char *, const char *);
+static char *   _num(int, int, int, char *, const char *); // android-added.
+static const struct strftime_format * _common_format(const char *); // android-added.
 static char *   _fmt(const char *, const struct tm *, char *, const char *,
             int *, const struct strftime_locale*);
 static char *   _yconv(int, int, int, int, char *, const char *, int);
@@ -152,6 +154,11 @@ const struct strftime_locale *locale;
     char *  p;
     int warn;
 
+    // android-added: the common formats are compiled in advance.
+    const struct strftime_format * compiled = _common_format(format);
+    if (compiled != NULL)
+        return strftime_compiled(s, maxsize, compiled, t, locale);
+
     tzset();
     warn = IN_NONE;
     p = _fmt(((format == NULL) ? "%c" : format), t, s, s + maxsize, &warn, locale);
@@ -674,10 +681,46 @@ const char * const  format;
 char * const        pt;
 const char * const  ptlim;
 {
-    char    buf[INT_STRLEN_MAXIMUM(int) + 1];
+    // BEGIN android-changed: the formats are all "%d" with an optional 0 and width.
+    const char *    f = format + 1;
+    int             pad = ' ';
+    int             width = 0;
+
+    if (*f == '0') {
+        pad = '0';
+        ++f;
+    }
+    while (is_digit(*f))
+        width = width * 10 + *f++ - '0';
+    return _num(n, width, pad, pt, ptlim);
+    // END android-changed
+}
+
+/*
+** android-added: what snprintf with "%0<width>d", or with "%<width>d" if pad is ' ',
+** gives, without snprintf.
+*/
+static char *
+_num(const int n, const int width, const int pad, char * const pt, const char * const ptlim)
+{
+    char            buf[INT_STRLEN_MAXIMUM(int) + 1];
+    char * const    end = buf + sizeof(buf) - 1;
+    char *          p = end;
+    unsigned int    u = (n < 0) ? -(unsigned int) n : (unsigned int) n;
 
-    (void) snprintf(buf, sizeof(buf), format, n);
-    return _add(buf, pt, ptlim, 0);
+    *p = '\0';
+    do {
+        *--p = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    if (pad == '0')
+        while (end - p + (n < 0) < width)
+            *--p = '0';
+    if (n < 0)
+        *--p = '-';
+    while (end - p < width)
+        *--p = ' ';
+    return _add(p, pt, ptlim, 0);
 }
 
 static char *
@@ -769,3 +812,323 @@ int                     modifier;
                            pt, ptlim);
     return pt;
 }
+
+/*
+** BEGIN android-added: formats parsed once, and then run without being interpreted again.
+**
+** A format is compiled into a list of ops: runs of literal text, the common numeric and name
+** conversions without a flag, which are done inline, and everything else, which is handed to
+** _fmt as a format of its own with just the one conversion. The ISO 8601 and RFC 1123 formats
+** that servers and loggers use all the time are compiled in advance, for strftime_tz.
+*/
+
+#define OP_TEXT 0   /* 'text' is literal */
+#define OP_FMT  1   /* 'text' is a format with one conversion, for _fmt */
+                    /* anything else is a conversion done inline */
+
+struct strftime_op {
+    int             kind;
+    size_t          len;
+    const char *    text;
+};
+
+struct strftime_format {
+    const struct strftime_op *  ops;
+    size_t                      count;
+    int                         needs_tzset;    /* whether an op might want tzname */
+};
+
+#define TEXT(s)     { OP_TEXT, sizeof(s) - 1, s }
+#define CONV(c)     { c, 0, NULL }
+#define COUNT(ops)  (sizeof(ops) / sizeof(ops[0]))
+
+static const struct strftime_op iso8601_ops[] = {
+    CONV('Y'), TEXT("-"), CONV('m'), TEXT("-"), CONV('d'), TEXT("T"),
+    CONV('H'), TEXT(":"), CONV('M'), TEXT(":"), CONV('S'),
+};
+
+static const struct strftime_op iso8601_utc_ops[] = {
+    CONV('Y'), TEXT("-"), CONV('m'), TEXT("-"), CONV('d'), TEXT("T"),
+    CONV('H'), TEXT(":"), CONV('M'), TEXT(":"), CONV('S'), TEXT("Z"),
+};
+
+static const struct strftime_op iso8601_space_ops[] = {
+    CONV('Y'), TEXT("-"), CONV('m'), TEXT("-"), CONV('d'), TEXT(" "),
+    CONV('H'), TEXT(":"), CONV('M'), TEXT(":"), CONV('S'),
+};
+
+static const struct strftime_op rfc1123_ops[] = {
+    CONV('a'), TEXT(", "), CONV('d'), TEXT(" "), CONV('b'), TEXT(" "), CONV('Y'), TEXT(" "),
+    CONV('H'), TEXT(":"), CONV('M'), TEXT(":"), CONV('S'), TEXT(" GMT"),
+};
+
+static const struct {
+    const char *            format;
+    struct strftime_format  compiled;
+} common_formats[] = {
+    { "%Y-%m-%dT%H:%M:%S", { iso8601_ops, COUNT(iso8601_ops), FALSE } },
+    { "%FT%T", { iso8601_ops, COUNT(iso8601_ops), FALSE } },
+    { "%Y-%m-%dT%H:%M:%SZ", { iso8601_utc_ops, COUNT(iso8601_utc_ops), FALSE } },
+    { "%Y-%m-%d %H:%M:%S", { iso8601_space_ops, COUNT(iso8601_space_ops), FALSE } },
+    { "%F %T", { iso8601_space_ops, COUNT(iso8601_space_ops), FALSE } },
+    { "%a, %d %b %Y %H:%M:%S GMT", { rfc1123_ops, COUNT(rfc1123_ops), FALSE } },
+    { "%a, %d %b %Y %T GMT", { rfc1123_ops, COUNT(rfc1123_ops), FALSE } },
+};
+
+static const struct strftime_format *
+_common_format(const char * const format)
+{
+    size_t  i;
+
+    if (format == NULL || format[0] != '%')
+        return NULL;
+    for (i = 0; i < COUNT(common_formats); ++i)
+        if (strcmp(format, common_formats[i].format) == 0)
+            return &common_formats[i].compiled;
+    return NULL;
+}
+
+/*
+** Builds a compiled format in two passes: one with ops NULL that only counts, so that
+** the second can fill in a single allocation of exactly the right size.
+*/
+struct strftime_builder {
+    struct strftime_op *    ops;
+    char *                  text;
+    size_t                  count;
+    size_t                  text_len;
+    int                     in_text;    /* whether text can be added to the last op */
+    int                     needs_tzset;
+};
+
+static void
+_compile_text(struct strftime_builder * const b, const char * const str, const size_t len)
+{
+    if (!b->in_text) {
+        if (b->ops != NULL) {
+            b->ops[b->count].kind = OP_TEXT;
+            b->ops[b->count].len = 0;
+            b->ops[b->count].text = b->text + b->text_len;
+        }
+        ++b->count;
+        b->in_text = TRUE;
+    }
+    if (b->ops != NULL) {
+        (void) memcpy(b->text + b->text_len, str, len);
+        b->ops[b->count - 1].len += len;
+    }
+    b->text_len += len;
+}
+
+static void
+_compile_op(struct strftime_builder * const b, const int kind, const char * const format,
+            const size_t len)
+{
+    if (b->ops != NULL) {
+        b->ops[b->count].kind = kind;
+        b->ops[b->count].len = len;
+        b->ops[b->count].text = b->text + b->text_len;
+        if (len != 0) {
+            (void) memcpy(b->text + b->text_len, format, len);
+            b->text[b->text_len + len] = '\0';
+        }
+    }
+    ++b->count;
+    if (len != 0)
+        b->text_len += len + 1;
+    b->in_text = FALSE;
+}
+
+/* Parses the way _fmt does, so that running the ops gives the same result. */
+static void
+_compile(struct strftime_builder * const b, const char * format)
+{
+    for ( ; *format; ++format) {
+        if (*format != '%') {
+            _compile_text(b, format, 1);
+            continue;
+        }
+
+        int     modifier = 0;
+        char    c;
+        for ( ; ; ) {
+            c = *++format;
+            if (c == '_' || c == '-' || c == '0' || c == '^' || c == '#')
+                modifier = c;
+            else if (c != 'E' && c != 'O')
+                break;
+        }
+        switch (c) {
+        case '\0':
+            /* _fmt then adds the character before. */
+            --format;
+            _compile_text(b, format, 1);
+            continue;
+        case 'D':
+            _compile(b, "%m/%d/%y");
+            continue;
+        case 'F':
+            _compile(b, "%Y-%m-%d");
+            continue;
+        case 'R':
+            _compile(b, "%H:%M");
+            continue;
+        case 'T':
+            _compile(b, "%H:%M:%S");
+            continue;
+        case 'n':
+            _compile_text(b, "\n", 1);
+            continue;
+        case 't':
+            _compile_text(b, "\t", 1);
+            continue;
+        case 'h':
+            c = 'b';
+            /* FALLTHROUGH */
+        case 'A': case 'a': case 'B': case 'b': case 'd': case 'e':
+        case 'H': case 'j': case 'M': case 'm': case 'S': case 'Y':
+            if (modifier == 0) {
+                _compile_op(b, c, NULL, 0);
+                continue;
+            }
+            break;
+        }
+        if (c == '%' || strchr("AaBbCcdeGgHIjKklMmPprSsUuVvWwXxYyZz+", c) == NULL) {
+            /* _fmt adds '%' and conversions it doesn't know as they are. */
+            _compile_text(b, format, 1);
+            continue;
+        }
+        {
+            char    conversion[4];
+            size_t  len = 0;
+
+            conversion[len++] = '%';
+            if (modifier != 0)
+                conversion[len++] = modifier;
+            conversion[len++] = c;
+            _compile_op(b, OP_FMT, conversion, len);
+            b->needs_tzset = TRUE;
+        }
+    }
+}
+
+struct strftime_format *
+strftime_compile(const char * const format)
+{
+    struct strftime_builder     b;
+    struct strftime_format *    result;
+
+    memset(&b, 0, sizeof(b));
+    _compile(&b, (format == NULL) ? "%c" : format);
+
+    result = malloc(sizeof(*result) + b.count * sizeof(*b.ops) + b.text_len);
+    if (result == NULL)
+        return NULL;
+    b.ops = (struct strftime_op *) (result + 1);
+    b.text = (char *) (b.ops + b.count);
+    b.count = b.text_len = 0;
+    b.in_text = FALSE;
+    _compile(&b, (format == NULL) ? "%c" : format);
+
+    result->ops = b.ops;
+    result->count = b.count;
+    result->needs_tzset = b.needs_tzset;
+    return result;
+}
+
+void
+strftime_compiled_free(struct strftime_format * const format)
+{
+    free(format);
+}
+
+static char *
+_name(const int i, const int n, const char * const * const names, char * const pt,
+      const char * const ptlim)
+{
+    return _add((i < 0 || i >= n) ? "?" : names[i], pt, ptlim, 0);
+}
+
+static char *
+_run(const struct strftime_format * const format, const struct tm * const t, char * pt,
+     const char * const ptlim, const struct strftime_locale * const locale)
+{
+    const struct strftime_op *  op = format->ops;
+    const struct strftime_op *  end = op + format->count;
+    int                         warn = IN_NONE;
+
+    for ( ; op < end && pt < ptlim; ++op) {
+        switch (op->kind) {
+        case OP_TEXT:
+            if (op->len > (size_t) (ptlim - pt)) {
+                (void) memcpy(pt, op->text, ptlim - pt);
+                return (char *) ptlim;
+            }
+            (void) memcpy(pt, op->text, op->len);
+            pt += op->len;
+            break;
+        case OP_FMT:
+            pt = _fmt(op->text, t, pt, ptlim, &warn, locale);
+            break;
+        case 'A':
+            pt = _name(t->tm_wday, DAYSPERWEEK, locale->weekday, pt, ptlim);
+            break;
+        case 'a':
+            pt = _name(t->tm_wday, DAYSPERWEEK, locale->wday, pt, ptlim);
+            break;
+        case 'B':
+            pt = _name(t->tm_mon, MONSPERYEAR, locale->month, pt, ptlim);
+            break;
+        case 'b':
+            pt = _name(t->tm_mon, MONSPERYEAR, locale->mon, pt, ptlim);
+            break;
+        case 'd':
+            pt = _num(t->tm_mday, 2, '0', pt, ptlim);
+            break;
+        case 'e':
+            pt = _num(t->tm_mday, 2, ' ', pt, ptlim);
+            break;
+        case 'H':
+            pt = _num(t->tm_hour, 2, '0', pt, ptlim);
+            break;
+        case 'j':
+            pt = _num(t->tm_yday + 1, 3, '0', pt, ptlim);
+            break;
+        case 'M':
+            pt = _num(t->tm_min, 2, '0', pt, ptlim);
+            break;
+        case 'm':
+            pt = _num(t->tm_mon + 1, 2, '0', pt, ptlim);
+            break;
+        case 'S':
+            pt = _num(t->tm_sec, 2, '0', pt, ptlim);
+            break;
+        case 'Y':
+            /* _yconv splits the year in two to keep this from overflowing or going negative. */
+            if (t->tm_year >= -TM_YEAR_BASE && t->tm_year <= INT_MAX - TM_YEAR_BASE)
+                pt = _num(t->tm_year + TM_YEAR_BASE, 4, '0', pt, ptlim);
+            else    pt = _yconv(t->tm_year, TM_YEAR_BASE, 1, 1, pt, ptlim, 0);
+            break;
+        }
+    }
+    return pt;
+}
+
+size_t
+strftime_compiled(char * const s, const size_t maxsize, const struct strftime_format * const format,
+                  const struct tm * const t, const struct strftime_locale * locale)
+{
+    char *  p;
+
+    if (locale == NULL)
+        locale = Locale;
+    if (format->needs_tzset)
+        tzset();
+    p = _run(format, t, s, s + maxsize, locale);
+    if (p == s + maxsize)
+        return 0;
+    *p = '\0';
+    return p - s;
+}
+
+/* END android-added */
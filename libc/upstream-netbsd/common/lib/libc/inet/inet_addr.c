@@ -139,7 +139,7 @@ inet_aton(const char *cp, struct in_addr *addr) {
 		 * Values are specified as for C:
 		 * 0x=hex, 0=octal, isdigit=decimal.
 		 */
-		if (!isdigit((unsigned char)c))
+		if ((unsigned int)(c - '0') > 9)
 			return (0);
 		val = 0; base = 10; digit = 0;
 		if (c == '0') {
@@ -151,17 +151,20 @@ inet_aton(const char *cp, struct in_addr *addr) {
 				digit = 1 ;
 			}
 		}
+		/*
+		 * Plain range checks rather than <ctype.h>: only ASCII
+		 * digits and (in hex) letters are accepted anyway.
+		 */
 		for (;;) {
-			if (isascii(c) && isdigit((unsigned char)c)) {
-				if (base == 8 && (c == '8' || c == '9'))
+			if ((unsigned int)(c - '0') <= 9) {
+				if (base == 8 && c >= '8')
 					return (0);
 				val = (val * base) + (c - '0');
 				c = *++cp;
 				digit = 1;
-			} else if (base == 16 && isascii(c) && 
-				   isxdigit((unsigned char)c)) {
-				val = (val << 4) |
-					(c + 10 - (islower((unsigned char)c) ? 'a' : 'A'));
+			} else if (base == 16 &&
+				   (unsigned int)((c | 0x20) - 'a') <= 5) {
+				val = (val << 4) | ((c | 0x20) - 'a' + 10);
 				c = *++cp;
 				digit = 1;
 			} else
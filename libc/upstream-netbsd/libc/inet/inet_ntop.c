@@ -99,18 +99,37 @@ static const char *
 inet_ntop4(const u_char *src, char *dst, socklen_t size)
 {
 	char tmp[sizeof "255.255.255.255"];
-	int l;
+	char *tp;
+	int i, l;
 
 	_DIAGASSERT(src != NULL);
 	_DIAGASSERT(dst != NULL);
 
-	l = snprintf(tmp, sizeof(tmp), "%u.%u.%u.%u",
-	    src[0], src[1], src[2], src[3]);
-	if (l <= 0 || (socklen_t) l >= size) {
+	/* Emit the digits directly: this is "%u.%u.%u.%u" without snprintf. */
+	tp = tmp;
+	for (i = 0; i < NS_INADDRSZ; i++) {
+		u_int v = src[i];
+
+		if (i != 0)
+			*tp++ = '.';
+		if (v >= 100) {
+			*tp++ = '0' + v / 100;
+			v %= 100;
+			*tp++ = '0' + v / 10;
+			v %= 10;
+		} else if (v >= 10) {
+			*tp++ = '0' + v / 10;
+			v %= 10;
+		}
+		*tp++ = '0' + v;
+	}
+	*tp = '\0';
+	l = (int)(tp - tmp);
+	if ((socklen_t) l >= size) {
 		errno = ENOSPC;
 		return (NULL);
 	}
-	strlcpy(dst, tmp, size);
+	memcpy(dst, tmp, (size_t)l + 1);
 	return (dst);
 }
 
@@ -130,11 +149,12 @@ inet_ntop6(const u_char *src, char *dst, socklen_t size)
 	 * Keep this in mind if you think this function should have been coded
 	 * to use pointer overlays.  All the world's not a VAX.
 	 */
+	static const char xdigits[] = "0123456789abcdef";
 	char tmp[sizeof "ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255"];
 	char *tp, *ep;
 	struct { int base, len; } best, cur;
-	u_int words[NS_IN6ADDRSZ / NS_INT16SZ];
-	int i;
+	u_int words[NS_IN6ADDRSZ / NS_INT16SZ], w;
+	int i, j;
 	int advance;
 
 	_DIAGASSERT(src != NULL);
@@ -202,9 +222,13 @@ inet_ntop6(const u_char *src, char *dst, socklen_t size)
 			tp += strlen(tp);
 			break;
 		}
-		advance = snprintf(tp, (size_t)(ep - tp), "%x", words[i]);
-		if (advance <= 0 || advance >= ep - tp)
+		/* "%x", without snprintf. */
+		advance = 1 + (words[i] > 0xf) + (words[i] > 0xff) +
+		    (words[i] > 0xfff);
+		if (advance >= ep - tp)
 			return (NULL);
+		for (j = advance - 1, w = words[i]; j >= 0; j--, w >>= 4)
+			tp[j] = xdigits[w & 0xf];
 		tp += advance;
 	}
 	/* Was it a trailing run of 0x00's? */
@@ -225,7 +249,7 @@ inet_ntop6(const u_char *src, char *dst, socklen_t size)
 		errno = ENOSPC;
 		return (NULL);
 	}
-	strlcpy(dst, tmp, size);
+	memcpy(dst, tmp, (size_t)(tp - tmp));
 	return (dst);
 }
 
@@ -55,6 +55,17 @@ __weak_alias(inet_pton,_inet_pton)
 static int	inet_pton4(const char *src, u_char *dst, int pton);
 static int	inet_pton6(const char *src, u_char *dst);
 
+/*
+ * One more than the value of each hex digit, so that every other
+ * character maps to 0.  Indexed by unsigned char.
+ */
+static const u_char xdigit_values[256] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+	['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
 /* int
  * inet_pton(af, src, dst)
  *	convert from presentation format (which usually means ASCII printable)
@@ -116,34 +127,28 @@ inet_pton4(const char *src, u_char *dst, int pton)
 		 * Values are specified as for C:
 		 * 0x=hex, 0=octal, isdigit=decimal.
 		 */
-		if (!isdigit(c))
+		digit = xdigit_values[c];
+		if (digit == 0 || digit > 10)
 			return (0);
 		val = 0; base = 10;
 		if (c == '0') {
 			c = *++src;
+			digit = xdigit_values[c];
 			if (c == 'x' || c == 'X')
 				base = 16, c = *++src;
-			else if (isdigit(c) && c != '9')
+			else if (digit != 0 && digit < 10)
 				base = 8;
 		}
 		/* inet_pton() takes decimal only */
 		if (pton && base != 10)
 			return (0);
 		for (;;) {
-			if (isdigit(c)) {
-				digit = c - '0';
-				if (digit >= base)
-					break;
-				val = (val * base) + digit;
-				c = *++src;
-			} else if (base == 16 && isxdigit(c)) {
-				digit = c + 10 - (islower(c) ? 'a' : 'A');
-				if (digit >= 16)
-					break;
-				val = (val << 4) | digit;
-				c = *++src;
-			} else
+			/* Digits and letters past the base end the number. */
+			digit = xdigit_values[c];
+			if (digit == 0 || --digit >= base)
 				break;
+			val = (val * base) + digit;
+			c = *++src;
 		}
 		if (c == '.') {
 			/*
@@ -222,11 +227,9 @@ inet_pton4(const char *src, u_char *dst, int pton)
 static int
 inet_pton6(const char *src, u_char *dst)
 {
-	static const char xdigits_l[] = "0123456789abcdef",
-			  xdigits_u[] = "0123456789ABCDEF";
 	u_char tmp[NS_IN6ADDRSZ], *tp, *endp, *colonp;
-	const char *xdigits, *curtok;
-	int ch, seen_xdigits;
+	const char *curtok;
+	int ch, digit, seen_xdigits;
 	u_int val;
 
 	_DIAGASSERT(src != NULL);
@@ -243,13 +246,10 @@ inet_pton6(const char *src, u_char *dst)
 	seen_xdigits = 0;
 	val = 0;
 	while ((ch = *src++) != '\0') {
-		const char *pch;
-
-		if ((pch = strchr((xdigits = xdigits_l), ch)) == NULL)
-			pch = strchr((xdigits = xdigits_u), ch);
-		if (pch != NULL) {
+		digit = xdigit_values[(u_char)ch];
+		if (digit != 0) {
 			val <<= 4;
-			val |= (int)(pch - xdigits);
+			val |= digit - 1;
 			if (++seen_xdigits > 4)
 				return (0);
 			continue;
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Bionic's cache of the state sets the small-representation matcher's
+ * fast() pass has gone through, and where each character category and
+ * anchor takes them: a DFA built lazily from the NFA, so that a pattern
+ * run over a lot of text costs about one table lookup per byte once the
+ * states it visits have been seen. See dfa_fast() in engine.c.
+ *
+ * regexec(3) may be called on one regex_t from several threads at once.
+ * Transitions are only ever added, under 'lock', and each is published
+ * (after the state it leads to) with a single word store, so lookups take
+ * no lock. States live in blocks that never move. Once DFA_MAX_STATES
+ * exist no more are made, and transitions to new ones are computed by the
+ * NFA each time instead.
+ */
+
+#ifndef _REGEX_DFA_H_
+#define _REGEX_DFA_H_
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#define	DFA_MAX_STATES		1024
+#define	DFA_BLOCK_STATES	16
+#define	DFA_HASH_SIZE		512
+#define	DFA_UNKNOWN		(-1)
+
+struct dfa_state {
+	unsigned long set;	/* NFA states, as in the small representation */
+	int next[1];		/* actually [ncodes]: DFA_UNKNOWN or a state */
+};
+
+struct dfa {
+	pthread_mutex_t lock;
+	size_t ncodes;		/* ncategories, then one per anchor code */
+	size_t stride;		/* bytes per struct dfa_state */
+	unsigned long fresh;	/* the set a new match starts in */
+	int start;		/* and its state */
+	int words;		/* does the pattern use \< or \>? */
+	volatile int full;	/* DFA_MAX_STATES reached, or out of memory */
+	int nstates;
+	char *blocks[DFA_MAX_STATES / DFA_BLOCK_STATES];
+	int hash[DFA_HASH_SIZE];
+	int chain[DFA_MAX_STATES];
+};
+
+#define	DFA_STATE(d, i) \
+	((struct dfa_state *)((d)->blocks[(i) / DFA_BLOCK_STATES] + \
+	    ((i) % DFA_BLOCK_STATES) * (d)->stride))
+
+static __inline void
+dfa_free(struct dfa *d)
+{
+	int i;
+
+	if (d == NULL)
+		return;
+	for (i = 0; i < DFA_MAX_STATES / DFA_BLOCK_STATES; i++)
+		free(d->blocks[i]);
+	pthread_mutex_destroy(&d->lock);
+	free(d);
+}
+
+#endif /* _REGEX_DFA_H_ */
@@ -167,6 +167,217 @@ static int nope = 0;
 #define	NOTE(s)	/* nothing */
 #endif
 
+/* BIONIC-BEGIN */
+#ifdef SNAMES
+/*
+ * The DFA (see dfa.h) stands in for fast() for patterns without back
+ * references, which the small representation covers, and produces the
+ * same result: every transition is step()'s, computed once.
+ */
+#define	DFA_CODE(g, ch) \
+	(NONCHAR(ch) ? (int)(g)->ncategories + ((ch) - BOL) : \
+	    (int)(g)->categories[ch])
+
+/*
+ * Finds or makes the state for 'set', and if 'from' is a state, records
+ * that 'code' takes it there. Returns the state, or DFA_UNKNOWN.
+ */
+static int
+dfa_add(struct dfa *d, int from, int code, unsigned long set)
+{
+	struct dfa_state *ds;
+	size_t h, i;
+	int to;
+
+	if (d->full)
+		return(DFA_UNKNOWN);
+	pthread_mutex_lock(&d->lock);
+	h = (set ^ (set >> 16) ^ (set >> 5)) % DFA_HASH_SIZE;
+	for (to = d->hash[h]; to != DFA_UNKNOWN; to = d->chain[to])
+		if (DFA_STATE(d, to)->set == set)
+			break;
+	if (to == DFA_UNKNOWN) {
+		if (d->nstates == DFA_MAX_STATES)
+			goto full;
+		if (d->nstates % DFA_BLOCK_STATES == 0) {
+			i = d->nstates / DFA_BLOCK_STATES;
+			d->blocks[i] = malloc(DFA_BLOCK_STATES * d->stride);
+			if (d->blocks[i] == NULL)
+				goto full;
+		}
+		to = d->nstates++;
+		ds = DFA_STATE(d, to);
+		ds->set = set;
+		for (i = 0; i < d->ncodes; i++)
+			ds->next[i] = DFA_UNKNOWN;
+		d->chain[to] = d->hash[h];
+		d->hash[h] = to;
+	}
+	if (from != DFA_UNKNOWN) {
+		/* The state must be visible before the way to it. */
+		__sync_synchronize();
+		DFA_STATE(d, from)->next[code] = to;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return(to);
+
+full:
+	d->full = 1;
+	pthread_mutex_unlock(&d->lock);
+	return(DFA_UNKNOWN);
+}
+
+/*
+ * Returns the pattern's DFA, making it if this is the first match, or
+ * NULL if there's no memory for one.
+ */
+static struct dfa *
+dfa_get(struct re_guts *g, sopno startst, sopno stopst)
+{
+	struct dfa *d = g->dfa;
+	sopno pc;
+	size_t i;
+
+	if (__predict_true(d != NULL))
+		return(d);
+
+	d = malloc(sizeof(*d));
+	if (d == NULL)
+		return(NULL);
+	pthread_mutex_init(&d->lock, NULL);
+	d->ncodes = g->ncategories + (EOW - BOL + 1);
+	d->stride = sizeof(struct dfa_state) + (d->ncodes - 1) * sizeof(int);
+	d->full = 0;
+	d->nstates = 0;
+	for (i = 0; i < DFA_MAX_STATES / DFA_BLOCK_STATES; i++)
+		d->blocks[i] = NULL;
+	for (i = 0; i < DFA_HASH_SIZE; i++)
+		d->hash[i] = DFA_UNKNOWN;
+	d->words = 0;
+	for (pc = startst; pc != stopst; pc++)
+		if (OP(g->strip[pc]) == OBOW || OP(g->strip[pc]) == OEOW)
+			d->words = 1;
+
+	/* as fast() starts */
+	d->fresh = (unsigned long)1 << startst;
+	d->fresh = step(g, startst, stopst, d->fresh, NOTHING, d->fresh);
+	d->start = dfa_add(d, DFA_UNKNOWN, 0, d->fresh);
+	if (d->start == DFA_UNKNOWN) {
+		dfa_free(d);
+		return(NULL);
+	}
+
+	/* Everything in 'd' must be visible before 'd' is. */
+	if (!__sync_bool_compare_and_swap(&g->dfa, NULL, d)) {
+		dfa_free(d);
+		d = g->dfa;
+	}
+	return(d);
+}
+
+/* Where 'ch' takes the states 'st', known as state '*cur' if it's cached. */
+static __inline unsigned long
+dfa_step(struct re_guts *g, struct dfa *d, sopno startst, sopno stopst,
+    int *cur, unsigned long st, int ch)
+{
+	int code = DFA_CODE(g, ch);
+	int next;
+
+	if (__predict_true(*cur != DFA_UNKNOWN)) {
+		next = DFA_STATE(d, *cur)->next[code];
+		if (__predict_true(next != DFA_UNKNOWN)) {
+			*cur = next;
+			return(DFA_STATE(d, next)->set);
+		}
+	}
+	/* An anchor adds to what was there; a character starts afresh. */
+	if (NONCHAR(ch))
+		st = step(g, startst, stopst, st, ch, st);
+	else
+		st = step(g, startst, stopst, st, ch, d->fresh);
+	*cur = dfa_add(d, *cur, code, st);
+	return(st);
+}
+
+/* fast(), a transition at a time through the DFA. */
+static const char *
+dfa_fast(
+    struct match *m,
+    struct dfa *d,
+    const char *start,
+    const char *stop,
+    sopno startst,
+    sopno stopst)
+{
+	struct re_guts *g = m->g;
+	const unsigned long fresh = d->fresh;
+	unsigned long st = fresh;
+	int cur = d->start;
+	const char *p = start;
+	int c = (start == m->beginp) ? OUT : *(start-1);
+	int lastc;	/* previous c */
+	int flagch;
+	size_t i;
+	const char *coldp; /* last p after which no match was underway */
+
+	coldp = NULL;
+	for (;;) {
+		/* next character */
+		lastc = c;
+		c = (p == m->endp) ? OUT : *p;
+		if (st == fresh)
+			coldp = p;
+
+		/* is there an EOL and/or BOL between lastc and c? */
+		flagch = '\0';
+		i = 0;
+		if ( (lastc == '\n' && g->cflags&REG_NEWLINE) ||
+				(lastc == OUT && !(m->eflags&REG_NOTBOL)) ) {
+			flagch = BOL;
+			i = g->nbol;
+		}
+		if ( (c == '\n' && g->cflags&REG_NEWLINE) ||
+				(c == OUT && !(m->eflags&REG_NOTEOL)) ) {
+			flagch = (flagch == BOL) ? BOLEOL : EOL;
+			i += g->neol;
+		}
+		for (; i > 0; i--)
+			st = dfa_step(g, d, startst, stopst, &cur, st, flagch);
+
+		/* how about a word boundary? without \< or \> it changes nothing */
+		if (d->words) {
+			if ( (flagch == BOL || (lastc != OUT && !ISWORD(lastc))) &&
+						(c != OUT && ISWORD(c)) ) {
+				flagch = BOW;
+			}
+			if ( (lastc != OUT && ISWORD(lastc)) &&
+					(flagch == EOL || (c != OUT && !ISWORD(c))) ) {
+				flagch = EOW;
+			}
+			if (flagch == BOW || flagch == EOW)
+				st = dfa_step(g, d, startst, stopst, &cur, st, flagch);
+		}
+
+		/* are we done? */
+		if (ISSET(st, stopst) || p == stop)
+			break;		/* NOTE BREAK OUT */
+
+		/* no, we must deal with this character */
+		assert(c != OUT);
+		st = dfa_step(g, d, startst, stopst, &cur, st, c);
+		p++;
+	}
+
+	assert(coldp != NULL);
+	m->coldp = coldp;
+	if (ISSET(st, stopst))
+		return(p+1);
+	else
+		return(NULL);
+}
+#endif /* SNAMES */
+/* BIONIC-END */
+
 /*
  - matcher - the actual matching engine
  == static int matcher(struct re_guts *g, char *string, \
@@ -190,6 +401,11 @@ matcher(
 	const char *start;
 	const char *stop;
 	int error = 0;
+	/* BIONIC-BEGIN */
+#ifdef SNAMES
+	struct dfa *dfa;
+#endif
+	/* BIONIC-END */
 
 	_DIAGASSERT(g != NULL);
 	_DIAGASSERT(string != NULL);
@@ -236,6 +452,13 @@ matcher(
 
 	/* this loop does only one repetition except for backrefs */
 	for (;;) {
+		/* BIONIC-BEGIN */
+#ifdef SNAMES
+		if (!g->backrefs && (dfa = dfa_get(g, gf, gl)) != NULL)
+			endp = dfa_fast(m, dfa, start, stop, gf, gl);
+		else
+#endif
+		/* BIONIC-END */
 		endp = fast(m, start, stop, gf, gl);
 		if (endp == NULL) {		/* a miss */
 			error = REG_NOMATCH;
@@ -299,6 +299,9 @@ regcomp(
 	g->categories = &g->catspace[-(CHAR_MIN)];
 	(void) memset((char *)g->catspace, 0, NC*sizeof(cat_t));
 	g->backrefs = 0;
+	/* BIONIC-BEGIN */
+	g->dfa = NULL;
+	/* BIONIC-END */
 
 	/* do it */
 	EMIT(OEND, 0);
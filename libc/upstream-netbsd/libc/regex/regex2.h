@@ -200,6 +200,9 @@ struct re_guts {
 	size_t nsub;		/* copy of re_nsub */
 	int backrefs;		/* does it use back references? */
 	sopno nplus;		/* how deep does it nest +s? */
+	/* BIONIC-BEGIN */
+	struct dfa *dfa;	/* built on first use; see dfa.h */
+	/* BIONIC-END */
 	/* catspace must be last */
 	cat_t catspace[1];	/* actually [NC] */
 };
@@ -104,6 +104,9 @@ __weak_alias(regexec,_regexec)
 
 #include "utils.h"
 #include "regex2.h"
+/* BIONIC-BEGIN */
+#include "dfa.h"
+/* BIONIC-END */
 
 /* macros for manipulating states, small version */
 #define	states	unsigned long
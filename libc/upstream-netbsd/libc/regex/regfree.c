@@ -94,6 +94,9 @@ __weak_alias(regfree,_regfree)
 
 #include "utils.h"
 #include "regex2.h"
+/* BIONIC-BEGIN */
+#include "dfa.h"
+/* BIONIC-END */
 
 /*
  - regfree - free everything
@@ -125,5 +128,8 @@ regfree(
 		free(g->setbits);
 	if (g->must != NULL)
 		free(g->must);
+	/* BIONIC-BEGIN */
+	dfa_free(g->dfa);
+	/* BIONIC-END */
 	free(g);
 }
@@ -15,6 +15,7 @@
  */
 
 #include <dlfcn.h>
+#include <android/dlext.h>
 /* These are stubs for functions that are actually defined
  * in the dynamic linker (dlfcn.c), and hijacked at runtime.
  */
@@ -26,6 +27,14 @@ int dlclose(void *handle) { return 0; }
 
 void android_update_LD_LIBRARY_PATH(const char* ld_library_path) { }
 
+void* android_dlopen_ext(const char* filename, int flag, const android_dlextinfo* extinfo) { return 0; }
+
+size_t android_dl_get_stats(android_dl_library_stats* stats, size_t count, size_t* linker_bytes) { return 0; }
+
+void android_dl_dump_stats(int fd) { }
+
+unsigned android_dl_get_generation(void) { return 0; }
+
 #if defined(__arm__)
 
 void *dl_unwind_find_exidx(void *pc, int *pcount) { return 0; }
@@ -8,7 +8,10 @@ libm_common_src_files := \
 
 # TODO: this is not in the BSDs.
 libm_common_src_files += \
+    rem_pio2_large.c \
     sincos.c \
+    sincosf.c \
+    vmath.c \
 
 libm_common_src_files += \
     upstream-freebsd/lib/msun/bsdsrc/b_exp.c \
@@ -26,8 +29,6 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/e_atanhf.c \
     upstream-freebsd/lib/msun/src/e_cosh.c \
     upstream-freebsd/lib/msun/src/e_coshf.c \
-    upstream-freebsd/lib/msun/src/e_exp.c \
-    upstream-freebsd/lib/msun/src/e_expf.c \
     upstream-freebsd/lib/msun/src/e_fmod.c \
     upstream-freebsd/lib/msun/src/e_fmodf.c \
     upstream-freebsd/lib/msun/src/e_gamma.c \
@@ -50,10 +51,7 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/e_log10f.c \
     upstream-freebsd/lib/msun/src/e_log2.c \
     upstream-freebsd/lib/msun/src/e_log2f.c \
-    upstream-freebsd/lib/msun/src/e_log.c \
-    upstream-freebsd/lib/msun/src/e_logf.c \
     upstream-freebsd/lib/msun/src/e_pow.c \
-    upstream-freebsd/lib/msun/src/e_powf.c \
     upstream-freebsd/lib/msun/src/e_remainder.c \
     upstream-freebsd/lib/msun/src/e_remainderf.c \
     upstream-freebsd/lib/msun/src/e_rem_pio2.c \
@@ -66,7 +64,6 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/k_cosf.c \
     upstream-freebsd/lib/msun/src/k_exp.c \
     upstream-freebsd/lib/msun/src/k_expf.c \
-    upstream-freebsd/lib/msun/src/k_rem_pio2.c \
     upstream-freebsd/lib/msun/src/k_sin.c \
     upstream-freebsd/lib/msun/src/k_sinf.c \
     upstream-freebsd/lib/msun/src/k_tan.c \
@@ -81,8 +78,6 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/s_cbrtf.c \
     upstream-freebsd/lib/msun/src/s_ccosh.c \
     upstream-freebsd/lib/msun/src/s_ccoshf.c \
-    upstream-freebsd/lib/msun/src/s_ceil.c \
-    upstream-freebsd/lib/msun/src/s_ceilf.c \
     upstream-freebsd/lib/msun/src/s_cexp.c \
     upstream-freebsd/lib/msun/src/s_cexpf.c \
     upstream-freebsd/lib/msun/src/s_cimag.c \
@@ -113,10 +108,6 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/s_fdim.c \
     upstream-freebsd/lib/msun/src/s_finite.c \
     upstream-freebsd/lib/msun/src/s_finitef.c \
-    upstream-freebsd/lib/msun/src/s_floor.c \
-    upstream-freebsd/lib/msun/src/s_floorf.c \
-    upstream-freebsd/lib/msun/src/s_fma.c \
-    upstream-freebsd/lib/msun/src/s_fmaf.c \
     upstream-freebsd/lib/msun/src/s_fmax.c \
     upstream-freebsd/lib/msun/src/s_fmaxf.c \
     upstream-freebsd/lib/msun/src/s_fmin.c \
@@ -128,29 +119,22 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/s_isfinite.c \
     upstream-freebsd/lib/msun/src/s_isnan.c \
     upstream-freebsd/lib/msun/src/s_isnormal.c \
-    upstream-freebsd/lib/msun/src/s_llrint.c \
-    upstream-freebsd/lib/msun/src/s_llrintf.c \
     upstream-freebsd/lib/msun/src/s_llround.c \
     upstream-freebsd/lib/msun/src/s_llroundf.c \
     upstream-freebsd/lib/msun/src/s_log1p.c \
     upstream-freebsd/lib/msun/src/s_log1pf.c \
     upstream-freebsd/lib/msun/src/s_logb.c \
     upstream-freebsd/lib/msun/src/s_logbf.c \
-    upstream-freebsd/lib/msun/src/s_lrint.c \
-    upstream-freebsd/lib/msun/src/s_lrintf.c \
     upstream-freebsd/lib/msun/src/s_lround.c \
     upstream-freebsd/lib/msun/src/s_lroundf.c \
     upstream-freebsd/lib/msun/src/s_modf.c \
     upstream-freebsd/lib/msun/src/s_modff.c \
     upstream-freebsd/lib/msun/src/s_nan.c \
-    upstream-freebsd/lib/msun/src/s_nearbyint.c \
     upstream-freebsd/lib/msun/src/s_nextafter.c \
     upstream-freebsd/lib/msun/src/s_nextafterf.c \
     upstream-freebsd/lib/msun/src/s_nexttowardf.c \
     upstream-freebsd/lib/msun/src/s_remquo.c \
     upstream-freebsd/lib/msun/src/s_remquof.c \
-    upstream-freebsd/lib/msun/src/s_rint.c \
-    upstream-freebsd/lib/msun/src/s_rintf.c \
     upstream-freebsd/lib/msun/src/s_round.c \
     upstream-freebsd/lib/msun/src/s_roundf.c \
     upstream-freebsd/lib/msun/src/s_scalbln.c \
@@ -166,8 +150,6 @@ libm_common_src_files += \
     upstream-freebsd/lib/msun/src/s_tanh.c \
     upstream-freebsd/lib/msun/src/s_tanhf.c \
     upstream-freebsd/lib/msun/src/s_tgammaf.c \
-    upstream-freebsd/lib/msun/src/s_trunc.c \
-    upstream-freebsd/lib/msun/src/s_truncf.c \
     upstream-freebsd/lib/msun/src/w_cabs.c \
     upstream-freebsd/lib/msun/src/w_cabsf.c \
     upstream-freebsd/lib/msun/src/w_drem.c \
@@ -195,7 +177,8 @@ libm_common_src_files += fake_long_double.c
       else
         libm_common_src_files += \
 	      upstream-freebsd/lib/msun/src/s_cos.c \
-	      upstream-freebsd/lib/msun/src/s_sin.c \
+	      upstream-freebsd/lib/msun/src/s_sin.c
+        libm_generic_sqrt_src_files := \
 	      upstream-freebsd/lib/msun/src/e_sqrtf.c \
 	      upstream-freebsd/lib/msun/src/e_sqrt.c
       endif
@@ -237,23 +220,93 @@ libm_common_src_files += fake_long_double.c
 #    upstream-freebsd/lib/msun/src/s_tanl.c \
 #    upstream-freebsd/lib/msun/src/s_truncl.c \
 
-# TODO: re-enable i387/e_sqrtf.S for x86, and maybe others.
-
 libm_common_cflags := -DFLT_EVAL_METHOD=0
 libm_common_includes := $(LOCAL_PATH)/upstream-freebsd/lib/msun/src/
 
+# x86 has SSE2 and SSE4.1 versions of these.
+libm_generic_rounding_src_files := \
+    upstream-freebsd/lib/msun/src/s_ceil.c \
+    upstream-freebsd/lib/msun/src/s_ceilf.c \
+    upstream-freebsd/lib/msun/src/s_floor.c \
+    upstream-freebsd/lib/msun/src/s_floorf.c \
+    upstream-freebsd/lib/msun/src/s_nearbyint.c \
+    upstream-freebsd/lib/msun/src/s_rint.c \
+    upstream-freebsd/lib/msun/src/s_rintf.c \
+    upstream-freebsd/lib/msun/src/s_trunc.c \
+    upstream-freebsd/lib/msun/src/s_truncf.c \
+
+# ARM and x86 convert in the current rounding mode with one instruction.
+libm_generic_lrint_src_files := \
+    upstream-freebsd/lib/msun/src/s_llrint.c \
+    upstream-freebsd/lib/msun/src/s_llrintf.c \
+    upstream-freebsd/lib/msun/src/s_lrint.c \
+    upstream-freebsd/lib/msun/src/s_lrintf.c \
+
+# ARM picks the VFPv4 instruction at run time when the core has it.
+libm_generic_fma_src_files := \
+    upstream-freebsd/lib/msun/src/s_fma.c \
+    upstream-freebsd/lib/msun/src/s_fmaf.c \
+
+# The table-driven expf, logf and powf work in double precision, which
+# needs a double unit as fast as the float one: VFP on ARM, SSE2 on x86.
+libm_double_expf_logf_src_files := \
+    e_expf.c \
+    e_logf.c \
+    e_powf.c \
+    expf_logf_data.c \
+
+libm_generic_expf_logf_src_files := \
+    upstream-freebsd/lib/msun/src/e_expf.c \
+    upstream-freebsd/lib/msun/src/e_logf.c \
+    upstream-freebsd/lib/msun/src/e_powf.c \
+
+# The table-driven exp and log, for ARM and x86; mips keeps msun's.
+libm_table_exp_log_src_files := \
+    e_exp.c \
+    e_log.c \
+    exp_log_data.c \
+
+libm_generic_exp_log_src_files := \
+    upstream-freebsd/lib/msun/src/e_exp.c \
+    upstream-freebsd/lib/msun/src/e_log.c \
+
 libm_arm_includes := $(LOCAL_PATH)/arm
-libm_arm_src_files := arm/fenv.c
+libm_arm_src_files := \
+    arm/fenv.c \
+    arm/fma.c \
+    arm/lrint.c \
+    arm/s_fma_vfpv4.S \
+    $(libm_double_expf_logf_src_files) \
+    $(libm_generic_rounding_src_files) \
+    $(libm_table_exp_log_src_files) \
+    $(libm_generic_sqrt_src_files) \
+
 ifeq ($(TARGET_CPU_VARIANT),krait)
   libm_arm_cflags += -DKRAIT_NEON_OPTIMIZATION
 endif
 
+# All the arithmetic goes through SSE2 rather than the x87 stack, which is
+# what FLT_EVAL_METHOD=0 promises anyway.
+libm_x86_cflags := -msse2 -mfpmath=sse
 libm_x86_includes := $(LOCAL_PATH)/i386 $(LOCAL_PATH)/i387
-libm_x86_src_files := i387/fenv.c
+libm_x86_src_files := \
+    i387/fenv.c \
+    x86/rounding.c \
+    x86/sqrt.c \
+    $(libm_double_expf_logf_src_files) \
+    $(libm_generic_fma_src_files) \
+    $(libm_table_exp_log_src_files) \
 
 libm_mips_cflags := -fno-builtin-rintf -fno-builtin-rint
 libm_mips_includes := $(LOCAL_PATH)/mips
-libm_mips_src_files := mips/fenv.c
+libm_mips_src_files := \
+    mips/fenv.c \
+    $(libm_generic_exp_log_src_files) \
+    $(libm_generic_expf_logf_src_files) \
+    $(libm_generic_fma_src_files) \
+    $(libm_generic_lrint_src_files) \
+    $(libm_generic_rounding_src_files) \
+    $(libm_generic_sqrt_src_files) \
 
 #
 # libm.a for target.
@@ -0,0 +1,84 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <sys/auxv.h>
+
+#include "math.h"
+#include "math_private.h"
+
+/*
+ * fma() and fmaf() go to the vfma instruction on cores with VFPv4, such as
+ * the Cortex-A7, A15 and Krait, and to msun's software versions, which
+ * split the operands and fix up the rounding by hand, everywhere else.
+ */
+double __fma_generic(double, double, double) __LIBC_HIDDEN__;
+float __fmaf_generic(float, float, float) __LIBC_HIDDEN__;
+double __fma_vfpv4(double, double, double) __LIBC_HIDDEN__;
+float __fmaf_vfpv4(float, float, float) __LIBC_HIDDEN__;
+
+/*
+ * msun's versions, under other names. The fmal alias s_fma.c makes still
+ * names fma() itself, since __weak_reference() doesn't expand its arguments.
+ */
+#define	fma	__fma_generic
+#include "s_fma.c"
+#undef	fma
+
+#define	fmaf	__fmaf_generic
+#include "s_fmaf.c"
+#undef	fmaf
+
+/* From the kernel's <asm/hwcap.h>. */
+#define	HWCAP_VFPv4	(1 << 16)
+
+/*
+ * Set before main() runs. Anything called earlier, from another
+ * constructor, gets the software versions, which give the same results.
+ */
+static int has_vfpv4;
+
+static void __attribute__((constructor))
+init_has_vfpv4(void)
+{
+	has_vfpv4 = (getauxval(AT_HWCAP) & HWCAP_VFPv4) != 0;
+}
+
+double
+fma(double x, double y, double z)
+{
+	if (has_vfpv4)
+		return __fma_vfpv4(x, y, z);
+	return __fma_generic(x, y, z);
+}
+
+float
+fmaf(float x, float y, float z)
+{
+	if (has_vfpv4)
+		return __fmaf_vfpv4(x, y, z);
+	return __fmaf_generic(x, y, z);
+}
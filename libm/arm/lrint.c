@@ -0,0 +1,87 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * lrint(), llrint() and their float versions with vcvtr, which converts to
+ * a 32-bit integer in the rounding mode already in the FPSCR. msun's
+ * versions save and restore the whole floating-point environment around
+ * rint() instead, and each vmrs or vmsr that takes stalls the VFP pipeline.
+ * vcvtr raises inexact for a fraction, and only invalid, saturating, for
+ * arguments out of range or NaN, which is what C99 asks.
+ */
+
+#include "math.h"
+#include "math_private.h"
+
+#define	VCVTR_F64(x) ({							\
+	int __r;							\
+	float __t;							\
+	__asm__("vcvtr.s32.f64 %1, %P2\n\tvmov %0, %1"			\
+	    : "=r" (__r), "=t" (__t) : "w" (x));			\
+	__r;								\
+})
+
+#define	VCVTR_F32(x) ({							\
+	int __r;							\
+	float __t;							\
+	__asm__("vcvtr.s32.f32 %1, %2\n\tvmov %0, %1"			\
+	    : "=r" (__r), "=t" (__t) : "t" (x));			\
+	__r;								\
+})
+
+long
+lrint(double x)
+{
+	return VCVTR_F64(x);
+}
+
+long
+lrintf(float x)
+{
+	return VCVTR_F32(x);
+}
+
+/*
+ * There's no 64-bit conversion in VFP, so only the cases whose results
+ * are sure to fit in 32 bits, in any rounding mode, are fast. rint() needs
+ * no access to the FPSCR either.
+ */
+long long
+llrint(double x)
+{
+	if (fabs(x) < 0x1p31 - 1)
+		return VCVTR_F64(x);
+	return rint(x);
+}
+
+long long
+llrintf(float x)
+{
+	if (fabsf(x) < 0x1p30f)
+		return VCVTR_F32(x);
+	return rintf(x);
+}
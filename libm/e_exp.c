@@ -0,0 +1,131 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <float.h>
+
+#include "math.h"
+#include "math_private.h"
+#include "exp_log.h"
+
+/*
+ * exp(x) = 2^(k/EXP_N) * e^r, with k the integer nearest x*EXP_N/ln(2) and
+ * |r| <= ln(2)/(2*EXP_N). 2^(k/EXP_N) comes from the table as a double s
+ * and its tail, and the Taylor series of e^r - 1 to r^5 leaves an error
+ * below 2^-60, so the result is off by little more than the half ulp of
+ * rounding s + s*tmp at the end.
+ */
+
+static const double
+shift	= 0x1.8p52,			/* rounds to integers */
+invln2n	= 0x1.71547652b82fep+7,		/* EXP_N/ln(2) */
+ln2hin	= 0x1.62e42fefc0000p-8,		/* ln(2)/EXP_N, top 35 bits */
+ln2lon	= -0x1.c610ca86c3899p-44,	/* ln(2)/EXP_N - ln2hin */
+c2	= 0x1p-1,			/* 1/2 */
+c3	= 0x1.5555555555555p-3,		/* 1/6 */
+c4	= 0x1.5555555555555p-5,		/* 1/24 */
+c5	= 0x1.1111111111111p-7;		/* 1/120 */
+
+static volatile double
+huge	= 1.0e+300,
+twom1000= 9.33263618503218878990e-302;	/* 2**-1000=0x01700000,0 */
+
+/*
+ * 512 <= |x| < 1024, where the exponent of s can leave the normal range:
+ * s is built 1009 binades lower or 1022 higher and the result scaled back.
+ * Results below 2^-1022 are rounded to their subnormal precision before
+ * the scaling, which is then exact, so that they aren't rounded twice.
+ */
+static double
+specialcase(double tmp, uint64_t sbits, uint64_t ki)
+{
+	double hi, lo, s, y;
+	volatile double force;
+
+	if ((ki & 0x80000000) == 0) {
+	    sbits -= 1009ULL << 52;
+	    INSERT_WORD64(s, sbits);
+	    return 0x1p1009 * (s + s * tmp);
+	}
+	sbits += 1022ULL << 52;
+	INSERT_WORD64(s, sbits);
+	y = s + s * tmp;
+	if (y < 1.0) {
+	    lo = s - y + s * tmp;
+	    hi = 1.0 + y;
+	    lo = 1.0 - hi + y + lo;
+	    y = (hi + lo) - 1.0;
+	    if (y == 0.0)
+		y = 0.0;			/* not -0 when rounding down */
+	    force = twom1000 * twom1000;	/* raise underflow */
+	    (void)force;
+	}
+	return 0x1p-1022 * y;
+}
+
+double
+__ieee754_exp(double x)
+{
+	double kd, r, r2, s, tail, tmp;
+	uint64_t ix, ki, sbits;
+	uint32_t abstop;
+	int idx;
+
+	EXTRACT_WORD64(ix, x);
+	abstop = (ix >> 52) & 0x7ff;
+	if (abstop - 0x3c9 >= 0x408 - 0x3c9) {	/* |x| < 2^-54 or |x| >= 512 */
+	    if (abstop < 0x3c9)
+		return 1.0 + x;			/* with inexact if x != 0 */
+	    if (abstop >= 0x409) {		/* |x| >= 1024, inf or NaN */
+		if (ix == 0xfff0000000000000ULL)
+		    return 0.0;			/* exp(-inf) = 0 */
+		if (abstop >= 0x7ff)
+		    return x + x;		/* exp(+inf or NaN) */
+		if (ix >> 63)
+		    return twom1000 * twom1000;	/* underflow */
+		return huge * huge;		/* overflow */
+	    }
+	}
+
+	kd = invln2n * x + shift;
+	EXTRACT_WORD64(ki, kd);
+	kd -= shift;
+	r = x - kd * ln2hin - kd * ln2lon;
+	idx = 2 * (ki % EXP_N);
+	INSERT_WORD64(tail, __exp_table[idx]);
+	sbits = __exp_table[idx + 1] + (ki << (52 - EXP_TABLE_BITS));
+
+	r2 = r * r;
+	tmp = tail + r + r2 * (c2 + r * c3) + r2 * r2 * (c4 + r * c5);
+	if (abstop >= 0x408)
+	    return specialcase(tmp, sbits, ki);
+	INSERT_WORD64(s, sbits);
+	return s + s * tmp;
+}
+
+#if (LDBL_MANT_DIG == 53)
+__weak_reference(exp, expl);
+#endif
@@ -0,0 +1,57 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "math.h"
+#include "math_private.h"
+#include "expf_logf.h"
+
+static const float
+o_threshold =  0x1.62e42ep+6f,		/* 88.72283, the largest finite result */
+u_threshold = -0x1.9fe368p+6f;		/* -103.97207, the smallest non-zero one */
+
+static volatile float
+huge	= 1.0e+30,
+twom100 = 7.8886090522e-31;		/* 2**-100=0x0d800000 */
+
+float
+__ieee754_expf(float x)
+{
+	uint32_t ix;
+
+	GET_FLOAT_WORD(ix,x);
+	if ((ix & 0x7fffffff) >= 0x42b00000) {	/* |x| >= 88 */
+	    if (ix == 0xff800000)
+		return 0.0f;			/* exp(-inf) = 0 */
+	    if ((ix & 0x7fffffff) >= 0x7f800000)
+		return x+x;			/* exp(+inf or NaN) */
+	    if (x > o_threshold)
+		return huge*huge;		/* overflow */
+	    if (x < u_threshold)
+		return twom100*twom100;		/* underflow */
+	}
+	return __expf_kernel(x);
+}
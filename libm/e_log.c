@@ -0,0 +1,104 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <float.h>
+
+#include "math.h"
+#include "math_private.h"
+#include "exp_log.h"
+
+/*
+ * log(x) = k*log(2) + log(c) + log(1 + r), with x = 2^k * z, c from the
+ * table for the interval of z and r = z/c - 1, |r| <= 2^-8. Every term but
+ * the polynomial is carried with its rounding error, and the Taylor series
+ * of log(1 + r) - r to r^7 is far more accurate than the half ulp lost in
+ * the final addition, so that is about the whole error.
+ */
+
+static const double
+two52	= 0x1p52,
+ln2hi	= 0x1.62e42fefa3800p-1,		/* log(2) as a multiple of 2^-42 */
+ln2lo	= 0x1.ef35793c76730p-45,	/* log(2) - ln2hi */
+a0	= -0x1p-1,
+a1	=  0x1.5555555555555p-2,
+a2	= -0x1p-2,
+a3	=  0x1.999999999999ap-3,
+a4	= -0x1.5555555555555p-3,
+a5	=  0x1.2492492492492p-3;
+
+static const double two54 = 1.80143985094819840000e+16;  /* 43500000 00000000 */
+static volatile double vzero = 0.0;
+
+double
+__ieee754_log(double x)
+{
+	double hi, invc, kd, lo, p, r, r2, rhi, rlo, w, z, zh;
+	uint64_t ix, iz, tmp;
+	int i;
+
+	EXTRACT_WORD64(ix, x);
+	if (ix - 0x0010000000000000ULL >= 0x7ff0000000000000ULL - 0x0010000000000000ULL) {
+	    if ((ix << 1) == 0)
+		return -two54 / vzero;		/* log(+-0) = -inf */
+	    if (ix == 0x7ff0000000000000ULL)
+		return x;			/* log(+inf) = +inf */
+	    if ((ix >> 63) || (ix >> 52) == 0x7ff)
+		return (x - x) / vzero;		/* log(-#) = NaN, log(NaN) */
+	    EXTRACT_WORD64(ix, x * two52);	/* subnormal */
+	    ix -= 52ULL << 52;
+	}
+	if (ix == 0x3ff0000000000000ULL)
+	    return 0.0;				/* log(1) = +0 in every mode */
+
+	tmp = ix - LOG_OFF;
+	i = (tmp >> (52 - LOG_TABLE_BITS)) % LOG_N;
+	kd = (int64_t)tmp >> 52;
+	iz = ix - (tmp & 0xfff0000000000000ULL);
+	INSERT_WORD64(z, iz);
+
+	/*
+	 * z*invc - 1 exactly, as rhi + rlo: invc has 26 bits, so it times the
+	 * top 26 bits of z and times the other 27 are both exact.
+	 */
+	invc = __log_table[i].invc;
+	INSERT_WORD64(zh, iz & 0xfffffffff8000000ULL);
+	rhi = zh * invc - 1.0;
+	rlo = (z - zh) * invc;
+	r = rhi + rlo;
+	rlo = (rhi - r) + rlo;
+
+	w = kd * ln2hi + __log_table[i].logc;
+	hi = w + r;
+	lo = (w - hi) + r + (kd * ln2lo + __log_table[i].logctail + rlo);
+	r2 = r * r;
+	p = a0 + r * a1 + r2 * (a2 + r * a3) + r2 * r2 * (a4 + r * a5);
+	return hi + (lo + p * r2);
+}
+
+#if (LDBL_MANT_DIG == 53)
+__weak_reference(log, logl);
+#endif
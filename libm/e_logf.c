@@ -1,6 +1,5 @@
-/*	$OpenBSD: strtoull.c,v 1.5 2005/08/08 08:05:37 espie Exp $ */
 /*-
- * Copyright (c) 1992 The Regents of the University of California.
+ * Copyright (c) 2013 The Android Open Source Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -11,14 +10,11 @@
  * 2. Redistributions in binary form must reproduce the above copyright
  *    notice, this list of conditions and the following disclaimer in the
  *    documentation and/or other materials provided with the distribution.
- * 3. Neither the name of the University nor the names of its contributors
- *    may be used to endorse or promote products derived from this software
- *    without specific prior written permission.
  *
- * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
  * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
  * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
- * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
  * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
  * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
  * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
@@ -26,24 +22,36 @@
  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
  * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
+ *
  */
 
-#include <sys/types.h>
+#include "math.h"
+#include "math_private.h"
+#include "expf_logf.h"
 
-#include <ctype.h>
-#include <errno.h>
-#include <limits.h>
-#include <stdlib.h>
-#include <inttypes.h>
+static const float
+two23 = 0x1p23f,
+zero  = 0.0f;
 
-/*
- * Convert a string to an unsigned long long.
- *
- * Ignores `locale' stuff.  Assumes that the upper and lower case
- * alphabets and digits are each contiguous.
- */
-unsigned long long
-strtoull(const char *nptr, char **endptr, int base)
+static volatile float vzero = 0.0f;
+
+float
+__ieee754_logf(float x)
 {
-    return (unsigned long long)strtoumax(nptr, endptr, base);
+	uint32_t ix;
+
+	GET_FLOAT_WORD(ix,x);
+	if (ix - 0x00800000 >= 0x7f800000 - 0x00800000) {
+	    /* x is zero, subnormal, negative, infinite or NaN */
+	    if ((ix & 0x7fffffff) == 0)
+		return -1.0f/vzero;		/* log(+-0) = -inf */
+	    if ((ix & 0x7fffffff) >= 0x7f800000 && ix != 0xff800000)
+		return x+x;			/* log(+inf or NaN) */
+	    if (ix & 0x80000000)
+		return (x-x)/zero;		/* log(-#) = NaN */
+	    x *= two23;				/* subnormal: normalize */
+	    GET_FLOAT_WORD(ix,x);
+	    ix -= 23 << 23;
+	}
+	return __logf_kernel(ix);
 }
@@ -0,0 +1,125 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "math.h"
+#include "math_private.h"
+#include "expf_logf.h"
+
+static const float two23 = 0x1p23f;
+
+static volatile float
+huge = 1.0e+30,
+tiny = 1.0e-30;
+
+/* Whether i is the bits of zero, an infinity or a NaN. */
+#define	zeroinfnan(i)	(2 * (i) - 1 >= 2u * 0x7f800000 - 1)
+
+/* Returns 0 if iy is the bits of a non-integer, 1 if of an odd integer, and
+ * 2 if of an even one. */
+static int
+checkint(uint32_t iy)
+{
+	int e = (iy >> 23) & 0xff;
+
+	if (e < 0x7f)
+	    return 0;
+	if (e > 0x7f + 23)
+	    return 2;
+	if (iy & ((1 << (0x7f + 23 - e)) - 1))
+	    return 0;
+	if (iy & (1 << (0x7f + 23 - e)))
+	    return 1;
+	return 2;
+}
+
+/*
+ * x**y = e^(y*log(x)), with log(x) and the product in double precision:
+ * their errors are amplified by |y*log(x)|, at most 104 for a result that's
+ * neither zero nor infinite, which leaves enough accuracy for one rounding.
+ * The special cases are those of C99 Annex F.
+ */
+float
+__ieee754_powf(float x, float y)
+{
+	double ylogx;
+	float r;
+	uint32_t ix, iy;
+	int negative = 0;
+
+	GET_FLOAT_WORD(ix,x);
+	GET_FLOAT_WORD(iy,y);
+	if (ix - 0x00800000 >= 0x7f800000 - 0x00800000 || zeroinfnan(iy)) {
+	    /* x is zero, subnormal, negative, infinite or NaN, or y is zero,
+	     * infinite or NaN */
+	    if (zeroinfnan(iy)) {
+		if (2 * iy == 0)
+		    return 1.0f;		/* x**+-0 = 1, even for NaN x */
+		if (ix == 0x3f800000)
+		    return 1.0f;		/* 1**y = 1, even for NaN y */
+		if (2 * ix > 2u * 0x7f800000 || 2 * iy > 2u * 0x7f800000)
+		    return x+y;			/* NaN */
+		if (2 * ix == 2 * 0x3f800000)
+		    return 1.0f;		/* (-1)**+-inf = 1 */
+		if ((2 * ix < 2 * 0x3f800000) == !(iy & 0x80000000))
+		    return 0.0f;		/* (|x|<1)**+inf, (|x|>1)**-inf = +0 */
+		return y*y;			/* the other way round: +inf */
+	    }
+	    if (zeroinfnan(ix)) {
+		float x2 = x*x;			/* +0, +inf or NaN */
+		if ((ix & 0x80000000) && checkint(iy) == 1)
+		    x2 = -x2;			/* odd y keeps the sign */
+		return (iy & 0x80000000) ? 1/x2 : x2;	/* 1/+-0 = +-inf */
+	    }
+	    /* x is finite and non-zero, and y is finite and non-zero */
+	    if (ix & 0x80000000) {
+		switch (checkint(iy)) {
+		case 0:
+		    return (x-x)/(x-x);		/* (-#)**non-integer = NaN */
+		case 1:
+		    negative = 1;
+		    break;
+		}
+		ix &= 0x7fffffff;
+	    }
+	    if (ix < 0x00800000) {		/* subnormal: normalize */
+		SET_FLOAT_WORD(x,ix);
+		x *= two23;
+		GET_FLOAT_WORD(ix,x);
+		ix -= 23 << 23;
+	    }
+	}
+
+	ylogx = y * __logf_kernel(ix);
+	if (ylogx > 0x1.63p+6) {		/* > 88.75: overflow */
+	    r = huge*huge;
+	} else if (ylogx < -0x1.ap+6) {	/* < -104: underflow */
+	    r = tiny*tiny;
+	} else {
+	    r = __expf_kernel(ylogx);
+	}
+	return negative ? -r : r;
+}
@@ -0,0 +1,70 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _EXP_LOG_H_
+#define _EXP_LOG_H_
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+/*
+ * The tables of the double exp() and log(). Both reduce the argument with
+ * one lookup into a small interval where a short polynomial is enough, and
+ * carry the table values with enough extra bits that the result is only
+ * rounded once, at the end: the error stays close to half an ulp.
+ */
+
+#define	EXP_TABLE_BITS		7
+#define	EXP_N			(1 << EXP_TABLE_BITS)
+#define	LOG_TABLE_BITS		7
+#define	LOG_N			(1 << LOG_TABLE_BITS)
+
+/*
+ * The bits of the double that starts the first log interval, 0.748: x is
+ * written as 2^k * z with z in [0.748, 1.496), the range split into LOG_N
+ * intervals by the top bits of its mantissa, with 1 in the middle of one.
+ */
+#define	LOG_OFF			0x3fe7f00000000000ULL
+
+/*
+ * For each i, the bits of two doubles: the tail of 2^(i/EXP_N) relative to
+ * the double s nearest it, (2^(i/EXP_N) - s)/s, and s itself, with
+ * i << (52 - EXP_TABLE_BITS) subtracted.
+ */
+extern const uint64_t __exp_table[2 * EXP_N] __LIBC_HIDDEN__;
+
+/*
+ * For each interval, 1/c for a c near its center, rounded to 26 bits so
+ * that the mantissa of z times it is exact in two pieces (1 for the
+ * interval containing 1), and -log(1/c) as a multiple of 2^-42 plus the
+ * rest, so that k*log(2) + log(c) adds up without any rounding.
+ */
+extern const struct log_entry {
+	double invc, logc, logctail;
+} __log_table[LOG_N] __LIBC_HIDDEN__;
+
+#endif /* _EXP_LOG_H_ */
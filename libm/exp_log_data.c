@@ -0,0 +1,226 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "exp_log.h"
+
+const uint64_t __exp_table[2 * EXP_N] = {
+	0x0000000000000000ULL, 0x3ff0000000000000ULL, 0x3c9b3b4f1a88bf6eULL, 0x3feff63da9fb3335ULL,
+	0xbc7160139cd8dc5dULL, 0x3fefec9a3e778061ULL, 0xbc905e7a108766d1ULL, 0x3fefe315e86e7f85ULL,
+	0x3c8cd2523567f613ULL, 0x3fefd9b0d3158574ULL, 0xbc8bce8023f98efaULL, 0x3fefd06b29ddf6deULL,
+	0x3c60f74e61e6c861ULL, 0x3fefc74518759bc8ULL, 0x3c90a3e45b33d399ULL, 0x3fefbe3ecac6f383ULL,
+	0x3c979aa65d837b6dULL, 0x3fefb5586cf9890fULL, 0x3c8eb51a92fdeffcULL, 0x3fefac922b7247f7ULL,
+	0x3c3ebe3d702f9cd1ULL, 0x3fefa3ec32d3d1a2ULL, 0xbc6a033489906e0bULL, 0x3fef9b66affed31bULL,
+	0xbc9556522a2fbd0eULL, 0x3fef9301d0125b51ULL, 0xbc5080ef8c4eea55ULL, 0x3fef8abdc06c31ccULL,
+	0xbc91c923b9d5f416ULL, 0x3fef829aaea92de0ULL, 0x3c80d3e3e95c55afULL, 0x3fef7a98c8a58e51ULL,
+	0xbc801b15eaa59348ULL, 0x3fef72b83c7d517bULL, 0xbc8f1ff055de323dULL, 0x3fef6af9388c8deaULL,
+	0x3c8b898c3f1353bfULL, 0x3fef635beb6fcb75ULL, 0xbc96d99c7611eb26ULL, 0x3fef5be084045cd4ULL,
+	0x3c9aecf73e3a2f60ULL, 0x3fef54873168b9aaULL, 0xbc8fe782cb86389dULL, 0x3fef4d5022fcd91dULL,
+	0x3c8a6f4144a6c38dULL, 0x3fef463b88628cd6ULL, 0x3c807a05b0e4047dULL, 0x3fef3f49917ddc96ULL,
+	0x3c968efde3a8a894ULL, 0x3fef387a6e756238ULL, 0x3c875e18f274487dULL, 0x3fef31ce4fb2a63fULL,
+	0x3c80472b981fe7f2ULL, 0x3fef2b4565e27cddULL, 0xbc96b87b3f71085eULL, 0x3fef24dfe1f56381ULL,
+	0x3c82f7e16d09ab31ULL, 0x3fef1e9df51fdee1ULL, 0xbc3d219b1a6fbffaULL, 0x3fef187fd0dad990ULL,
+	0x3c8b3782720c0ab4ULL, 0x3fef1285a6e4030bULL, 0x3c6e149289cecb8fULL, 0x3fef0cafa93e2f56ULL,
+	0x3c834d754db0abb6ULL, 0x3fef06fe0a31b715ULL, 0x3c864201e2ac744cULL, 0x3fef0170fc4cd831ULL,
+	0x3c8fdd395dd3f84aULL, 0x3feefc08b26416ffULL, 0xbc86a3803b8e5b04ULL, 0x3feef6c55f929ff1ULL,
+	0xbc924aedcc4b5068ULL, 0x3feef1a7373aa9cbULL, 0xbc9907f81b512d8eULL, 0x3feeecae6d05d866ULL,
+	0xbc71d1e83e9436d2ULL, 0x3feee7db34e59ff7ULL, 0xbc991919b3ce1b15ULL, 0x3feee32dc313a8e5ULL,
+	0x3c859f48a72a4c6dULL, 0x3feedea64c123422ULL, 0xbc9312607a28698aULL, 0x3feeda4504ac801cULL,
+	0xbc58a78f4817895bULL, 0x3feed60a21f72e2aULL, 0xbc7c2c9b67499a1bULL, 0x3feed1f5d950a897ULL,
+	0x3c4363ed60c2ac11ULL, 0x3feece086061892dULL, 0x3c9666093b0664efULL, 0x3feeca41ed1d0057ULL,
+	0x3c6ecce1daa10379ULL, 0x3feec6a2b5c13cd0ULL, 0x3c93ff8e3f0f1230ULL, 0x3feec32af0d7d3deULL,
+	0x3c7690cebb7aafb0ULL, 0x3feebfdad5362a27ULL, 0x3c931dbdeb54e077ULL, 0x3feebcb299fddd0dULL,
+	0xbc8f94340071a38eULL, 0x3feeb9b2769d2ca7ULL, 0xbc87deccdc93a349ULL, 0x3feeb6daa2cf6642ULL,
+	0xbc78dec6bd0f385fULL, 0x3feeb42b569d4f82ULL, 0xbc861246ec7b5cf6ULL, 0x3feeb1a4ca5d920fULL,
+	0x3c93350518fdd78eULL, 0x3feeaf4736b527daULL, 0x3c7b98b72f8a9b05ULL, 0x3feead12d497c7fdULL,
+	0x3c9063e1e21c5409ULL, 0x3feeab07dd485429ULL, 0x3c34c7855019c6eaULL, 0x3feea9268a5946b7ULL,
+	0x3c9432e62b64c035ULL, 0x3feea76f15ad2148ULL, 0xbc8ce44a6199769fULL, 0x3feea5e1b976dc09ULL,
+	0xbc8c33c53bef4da8ULL, 0x3feea47eb03a5585ULL, 0xbc845378892be9aeULL, 0x3feea34634ccc320ULL,
+	0xbc93cedd78565858ULL, 0x3feea23882552225ULL, 0x3c5710aa807e1964ULL, 0x3feea155d44ca973ULL,
+	0xbc93b3efbf5e2228ULL, 0x3feea09e667f3bcdULL, 0xbc6a12ad8734b982ULL, 0x3feea012750bdabfULL,
+	0xbc6367efb86da9eeULL, 0x3fee9fb23c651a2fULL, 0xbc80dc3d54e08851ULL, 0x3fee9f7df9519484ULL,
+	0xbc781f647e5a3ecfULL, 0x3fee9f75e8ec5f74ULL, 0xbc86ee4ac08b7db0ULL, 0x3fee9f9a48a58174ULL,
+	0xbc8619321e55e68aULL, 0x3fee9feb564267c9ULL, 0x3c909ccb5e09d4d3ULL, 0x3feea0694fde5d3fULL,
+	0xbc7b32dcb94da51dULL, 0x3feea11473eb0187ULL, 0x3c94ecfd5467c06bULL, 0x3feea1ed0130c132ULL,
+	0x3c65ebe1abd66c55ULL, 0x3feea2f336cf4e62ULL, 0xbc88a1c52fb3cf42ULL, 0x3feea427543e1a12ULL,
+	0xbc9369b6f13b3734ULL, 0x3feea589994cce13ULL, 0xbc805e843a19ff1eULL, 0x3feea71a4623c7adULL,
+	0xbc94d450d872576eULL, 0x3feea8d99b4492edULL, 0x3c90ad675b0e8a00ULL, 0x3feeaac7d98a6699ULL,
+	0x3c8db72fc1f0eab4ULL, 0x3feeace5422aa0dbULL, 0xbc65b6609cc5e7ffULL, 0x3feeaf3216b5448cULL,
+	0x3c7bf68359f35f44ULL, 0x3feeb1ae99157736ULL, 0xbc93091fa71e3d83ULL, 0x3feeb45b0b91ffc6ULL,
+	0xbc5da9b88b6c1e29ULL, 0x3feeb737b0cdc5e5ULL, 0xbc6c23f97c90b959ULL, 0x3feeba44cbc8520fULL,
+	0xbc92434322f4f9aaULL, 0x3feebd829fde4e50ULL, 0xbc85ca6cd7668e4bULL, 0x3feec0f170ca07baULL,
+	0x3c71affc2b91ce27ULL, 0x3feec49182a3f090ULL, 0x3c6dd235e10a73bbULL, 0x3feec86319e32323ULL,
+	0xbc87c50422622263ULL, 0x3feecc667b5de565ULL, 0x3c8b1c86e3e231d5ULL, 0x3feed09bec4a2d33ULL,
+	0xbc91bbd1d3bcbb15ULL, 0x3feed503b23e255dULL, 0x3c90cc319cee31d2ULL, 0x3feed99e1330b358ULL,
+	0x3c8469846e735ab3ULL, 0x3feede6b5579fdbfULL, 0xbc82dfcd978e9db4ULL, 0x3feee36bbfd3f37aULL,
+	0x3c8c1a7792cb3387ULL, 0x3feee89f995ad3adULL, 0xbc907b8f4ad1d9faULL, 0x3feeee07298db666ULL,
+	0xbc55c3d956dcaebaULL, 0x3feef3a2b84f15fbULL, 0xbc90a40e3da6f640ULL, 0x3feef9728de5593aULL,
+	0xbc68d6f438ad9334ULL, 0x3feeff76f2fb5e47ULL, 0xbc91eee26b588a35ULL, 0x3fef05b030a1064aULL,
+	0x3c74ffd70a5fddcdULL, 0x3fef0c1e904bc1d2ULL, 0xbc91bdfbfa9298acULL, 0x3fef12c25bd71e09ULL,
+	0x3c736eae30af0cb3ULL, 0x3fef199bdd85529cULL, 0x3c8ee3325c9ffd94ULL, 0x3fef20ab5fffd07aULL,
+	0x3c84e08fd10959acULL, 0x3fef27f12e57d14bULL, 0x3c63cdaf384e1a67ULL, 0x3fef2f6d9406e7b5ULL,
+	0x3c676b2c6c921968ULL, 0x3fef3720dcef9069ULL, 0xbc808a1883ccb5d2ULL, 0x3fef3f0b555dc3faULL,
+	0xbc8fad5d3ffffa6fULL, 0x3fef472d4a07897cULL, 0xbc900dae3875a949ULL, 0x3fef4f87080d89f2ULL,
+	0x3c74a385a63d07a7ULL, 0x3fef5818dcfba487ULL, 0xbc82919e2040220fULL, 0x3fef60e316c98398ULL,
+	0x3c8e5a50d5c192acULL, 0x3fef69e603db3285ULL, 0x3c843a59ac016b4bULL, 0x3fef7321f301b460ULL,
+	0xbc82d52107b43e1fULL, 0x3fef7c97337b9b5fULL, 0xbc892ab93b470dc9ULL, 0x3fef864614f5a129ULL,
+	0x3c74b604603a88d3ULL, 0x3fef902ee78b3ff6ULL, 0x3c83c5ec519d7271ULL, 0x3fef9a51fbc74c83ULL,
+	0xbc8ff7128fd391f0ULL, 0x3fefa4afa2a490daULL, 0xbc8dae98e223747dULL, 0x3fefaf482d8e67f1ULL,
+	0x3c8ec3bc41aa2008ULL, 0x3fefba1bee615a27ULL, 0x3c842b94c3a9eb32ULL, 0x3fefc52b376bba97ULL,
+	0x3c8a64a931d185eeULL, 0x3fefd0765b6e4540ULL, 0xbc8e37bae43be3edULL, 0x3fefdbfdad9cbe14ULL,
+	0x3c77893b4d91cd9dULL, 0x3fefe7c1819e90d8ULL, 0x3c5305c14160cc89ULL, 0x3feff3c22b8f71f1ULL,
+};
+
+const struct log_entry __log_table[LOG_N] = {
+	{ 0x1.5555558000000p+0, -0x1.269621934e000p-2, 0x1.1b81f1051fb7ap-44 },
+	{ 0x1.5390948000000p+0, -0x1.214456a2ec000p-2, 0x1.caf4648b72a9ep-44 },
+	{ 0x1.51d07e8000000p+0, -0x1.1bf995a9a7000p-2, 0x1.1aeedd75c58f8p-44 },
+	{ 0x1.5015018000000p+0, -0x1.16b5cd4cd0000p-2, 0x1.23533242d356ep-44 },
+	{ 0x1.4e5e0a8000000p+0, -0x1.1178e84a7e000p-2, -0x1.1ef46ce2d093fp-44 },
+	{ 0x1.4cab888000000p+0, -0x1.0c42d6a016000p-2, -0x1.7181cd63cedecp-45 },
+	{ 0x1.4afd6a0000000p+0, -0x1.071385f4d6000p-2, 0x1.e763a4e912b2cp-44 },
+	{ 0x1.49539e0000000p+0, -0x1.01eae4aa6c000p-2, -0x1.a3fbafade06f0p-44 },
+	{ 0x1.47ae148000000p+0, -0x1.f991c6eb3c000p-3, 0x1.90d0ccd7cc81fp-44 },
+	{ 0x1.460cbc8000000p+0, -0x1.ef5ade51d0000p-3, 0x1.a212565bb8e0cp-51 },
+	{ 0x1.446f868000000p+0, -0x1.e530f10672000p-3, 0x1.fddfc313f4d4dp-44 },
+	{ 0x1.42d6628000000p+0, -0x1.db13dbe948000p-3, -0x1.27ef0647542fap-44 },
+	{ 0x1.4141418000000p+0, -0x1.d10380b656000p-3, 0x1.8718e75b1e0cep-47 },
+	{ 0x1.3fb0140000000p+0, -0x1.c6ffbc8f00000p-3, -0x1.ee130d3a69d58p-44 },
+	{ 0x1.3e22cc0000000p+0, -0x1.bd0874c3be000p-3, 0x1.d520459536c0bp-45 },
+	{ 0x1.3c995a8000000p+0, -0x1.b31d86e1bc000p-3, -0x1.c7543362ade72p-44 },
+	{ 0x1.3b13b10000000p+0, -0x1.a93ed248ae000p-3, 0x1.87b4350574169p-45 },
+	{ 0x1.3991c30000000p+0, -0x1.9f6c42088a000p-3, 0x1.33cedcbcc928ap-44 },
+	{ 0x1.3813810000000p+0, -0x1.95a5ac5f70000p-3, -0x1.7d118589d0985p-47 },
+	{ 0x1.3698df0000000p+0, -0x1.8beafd1b90000p-3, 0x1.765f8aaee9299p-47 },
+	{ 0x1.3521cf8000000p+0, -0x1.823c15051a000p-3, -0x1.e00139a619ca3p-46 },
+	{ 0x1.33ae458000000p+0, -0x1.7898d6f044000p-3, -0x1.8e29dc3db3c81p-44 },
+	{ 0x1.323e348000000p+0, -0x1.6f0127cf56000p-3, -0x1.575948d31cf4ep-44 },
+	{ 0x1.30d1900000000p+0, -0x1.6574eb68c2000p-3, 0x1.98c9d34f0f9b7p-44 },
+	{ 0x1.2f684c0000000p+0, -0x1.5bf407b544000p-3, 0x1.27823eb67ed71p-46 },
+	{ 0x1.2e025c0000000p+0, -0x1.527e5e2a1c000p-3, 0x1.4e6138d4b4132p-44 },
+	{ 0x1.2c9fb50000000p+0, -0x1.4913d9433c000p-3, 0x1.540855580f196p-44 },
+	{ 0x1.2b404b0000000p+0, -0x1.3fb45ba192000p-3, -0x1.193cb40cb3f17p-44 },
+	{ 0x1.29e4128000000p+0, -0x1.365fca315a000p-3, 0x1.fd4f2afb97ffep-44 },
+	{ 0x1.288b010000000p+0, -0x1.2d160fb068000p-3, -0x1.38a48cb7ff603p-47 },
+	{ 0x1.27350b8000000p+0, -0x1.23d7126c9c000p-3, -0x1.00cc18fd3dd93p-46 },
+	{ 0x1.25e2270000000p+0, -0x1.1aa2b7aa40000p-3, 0x1.1ac515de3b3d8p-44 },
+	{ 0x1.2492490000000p+0, -0x1.1178e7227e000p-3, -0x1.1eb78ce2cb29cp-45 },
+	{ 0x1.2345678000000p+0, -0x1.08598b15e4000p-3, 0x1.7e625b00991c5p-45 },
+	{ 0x1.21fb780000000p+0, -0x1.fe89129dbc000p-4, -0x1.56514d82f752cp-44 },
+	{ 0x1.20b4710000000p+0, -0x1.ec739b60a0000p-4, -0x1.11ab7280d89c9p-44 },
+	{ 0x1.1f70480000000p+0, -0x1.da72783844000p-4, -0x1.a81401fa7c1dep-46 },
+	{ 0x1.1e2ef38000000p+0, -0x1.c8857d33c4000p-4, -0x1.63e5f8659a6fdp-45 },
+	{ 0x1.1cf06b0000000p+0, -0x1.b6ac8afad4000p-4, -0x1.b199df50258f4p-44 },
+	{ 0x1.1bb4a40000000p+0, -0x1.a4e763cb1c000p-4, 0x1.e42f6b9440873p-47 },
+	{ 0x1.1a7b960000000p+0, -0x1.9335e4d594000p-4, -0x1.3105c3abd3d2fp-45 },
+	{ 0x1.1945380000000p+0, -0x1.8197e27410000p-4, 0x1.c100460d200ecp-44 },
+	{ 0x1.1811810000000p+0, -0x1.700d2f4eac000p-4, -0x1.c004da99c3188p-49 },
+	{ 0x1.16e0688000000p+0, -0x1.5e95a3b178000p-4, -0x1.1cad1c1d16933p-44 },
+	{ 0x1.15b1e60000000p+0, -0x1.4d31165208000p-4, 0x1.53c2582f4d745p-48 },
+	{ 0x1.1485f10000000p+0, -0x1.3bdf5c4d20000p-4, 0x1.19d752d1238d3p-44 },
+	{ 0x1.135c810000000p+0, -0x1.2aa0492470000p-4, -0x1.7a3e9a8b1c3a9p-44 },
+	{ 0x1.12358e8000000p+0, -0x1.1973bdac64000p-4, -0x1.566a434f931d0p-44 },
+	{ 0x1.1111110000000p+0, -0x1.08598a59e4000p-4, 0x1.7e7dd7009a581p-46 },
+	{ 0x1.0fef010000000p+0, -0x1.eea31a2068000p-5, -0x1.c3d67b606d42cp-44 },
+	{ 0x1.0ecf568000000p+0, -0x1.ccb7357dd8000p-5, -0x1.95ef6ee08ea92p-44 },
+	{ 0x1.0db20a8000000p+0, -0x1.aaef2bffb0000p-5, -0x1.0fbd1f53bb295p-45 },
+	{ 0x1.0c97150000000p+0, -0x1.894aa1c9f8000p-5, -0x1.9a1928be97676p-44 },
+	{ 0x1.0b7e6f0000000p+0, -0x1.67c9568d48000p-5, -0x1.da554027dd577p-44 },
+	{ 0x1.0a68108000000p+0, -0x1.466ae8a2e0000p-5, 0x1.c1bcc75be8111p-45 },
+	{ 0x1.0953f38000000p+0, -0x1.252f3108d0000p-5, -0x1.83daaa021acc8p-45 },
+	{ 0x1.0842108000000p+0, -0x1.0415d81e78000p-5, 0x1.dddcff461c52bp-44 },
+	{ 0x1.0732608000000p+0, -0x1.c63d25e150000p-6, 0x1.546130030e0c8p-44 },
+	{ 0x1.0624dd0000000p+0, -0x1.8492470c90000p-6, 0x1.aa8fe325b09afp-45 },
+	{ 0x1.05197f8000000p+0, -0x1.432a92f980000p-6, -0x1.9812092863828p-47 },
+	{ 0x1.0410410000000p+0, -0x1.0205648930000p-6, -0x1.611ca7c8e8402p-44 },
+	{ 0x1.03091b8000000p+0, -0x1.8244a0f880000p-7, -0x1.45138f2c5ff87p-44 },
+	{ 0x1.0204080000000p+0, -0x1.01014f5880000p-7, -0x1.bcda51998afb1p-44 },
+	{ 0x1.0101010000000p+0, -0x1.0080549580000p-8, -0x1.166aecb31c67ap-45 },
+	{ 0x1p+0, 0x0p+0, 0x0p+0 },
+	{ 0x1.fc07f00000000p-1, 0x1.fe02b6b100000p-8, 0x1.9e43f0dda563ap-46 },
+	{ 0x1.f81f820000000p-1, 0x1.fc0a890fc0000p-7, 0x1.f207cf6d3a147p-50 },
+	{ 0x1.f4465a0000000p-1, 0x1.7b91acfd60000p-6, -0x1.3b8f3b602b076p-44 },
+	{ 0x1.f07c1f0000000p-1, 0x1.f829b1e780000p-6, 0x1.980367c7e0a0fp-45 },
+	{ 0x1.ecc07b0000000p-1, 0x1.39e87ebfe8000p-5, 0x1.eb10d00ada46ep-44 },
+	{ 0x1.e9131a8000000p-1, 0x1.7745938330000p-5, -0x1.17fbc6586803ep-44 },
+	{ 0x1.e573ac8000000p-1, 0x1.b42dd82198000p-5, -0x1.c81ea65d66d19p-46 },
+	{ 0x1.e1e1e20000000p-1, 0x1.f0a30a0118000p-5, -0x1.d589e8336993cp-45 },
+	{ 0x1.de5d6e0000000p-1, 0x1.1653710a38000p-4, -0x1.47356768ed653p-46 },
+	{ 0x1.dae6078000000p-1, 0x1.341d78b1bc000p-4, 0x1.1d0cf19837455p-44 },
+	{ 0x1.d77b658000000p-1, 0x1.51b0722860000p-4, 0x1.840ff478e4a46p-44 },
+	{ 0x1.d41d420000000p-1, 0x1.6f0d272e58000p-4, -0x1.4b3441b665813p-44 },
+	{ 0x1.d0cb590000000p-1, 0x1.8c345d1318000p-4, 0x1.b21022cb42a3cp-44 },
+	{ 0x1.cd85688000000p-1, 0x1.a926d434ac000p-4, 0x1.5638d8bd22b8fp-44 },
+	{ 0x1.ca4b308000000p-1, 0x1.c5e5477dbc000p-4, 0x1.d10a7d85f7a6ep-46 },
+	{ 0x1.c71c720000000p-1, 0x1.e27074e2b0000p-4, -0x1.a302c2af05591p-45 },
+	{ 0x1.c3f8f00000000p-1, 0x1.fec9141dc0000p-4, -0x1.544d5d1ae60b1p-44 },
+	{ 0x1.c0e0700000000p-1, 0x1.0d77e8cd08000p-3, 0x1.cb4cd2ee31f2cp-44 },
+	{ 0x1.bdd2b88000000p-1, 0x1.1b72adc6f6000p-3, 0x1.e81765811ab87p-45 },
+	{ 0x1.bacf918000000p-1, 0x1.29552e9200000p-3, -0x1.5b7a5f4474124p-44 },
+	{ 0x1.b7d6c40000000p-1, 0x1.371fc161e8000p-3, 0x1.ee93f9b2d8052p-44 },
+	{ 0x1.b4e81b8000000p-1, 0x1.44d2b5e4b8000p-3, -0x1.7062f6135f743p-46 },
+	{ 0x1.b203640000000p-1, 0x1.526e5e5a1c000p-3, -0x1.790b237fc5223p-44 },
+	{ 0x1.af286c0000000p-1, 0x1.5ff3060a7a000p-3, -0x1.8566f183c169cp-44 },
+	{ 0x1.ac57018000000p-1, 0x1.6d60ff459e000p-3, -0x1.bc58637132f2bp-44 },
+	{ 0x1.a98ef60000000p-1, 0x1.7ab890410e000p-3, -0x1.bdb8072534a2dp-45 },
+	{ 0x1.a6d01a8000000p-1, 0x1.87fa05f60c000p-3, 0x1.2216260120101p-44 },
+	{ 0x1.a41a418000000p-1, 0x1.9525aa7f46000p-3, -0x1.296217d9f07b1p-44 },
+	{ 0x1.a16d3f8000000p-1, 0x1.a23bc2722c000p-3, -0x1.5396471dc9b13p-44 },
+	{ 0x1.9ec8e98000000p-1, 0x1.af3c94000c000p-3, -0x1.8a9e33fed5211p-52 },
+	{ 0x1.9c2d150000000p-1, 0x1.bc2866ead8000p-3, 0x1.9ac90739d1061p-44 },
+	{ 0x1.9999998000000p-1, 0x1.c8ff7cf9aa000p-3, -0x1.7784f689f7989p-45 },
+	{ 0x1.970e4f8000000p-1, 0x1.d5c216b8fc000p-3, -0x1.1ba917bca681bp-45 },
+	{ 0x1.948b100000000p-1, 0x1.e27075e2b0000p-3, -0x1.a322c2af02ae7p-44 },
+	{ 0x1.920fb48000000p-1, 0x1.ef0add51c6000p-3, -0x1.b25615c869ea7p-45 },
+	{ 0x1.8f9c190000000p-1, 0x1.fb9186b5e4000p-3, -0x1.d56eaab993d31p-47 },
+	{ 0x1.8d30190000000p-1, 0x1.040258d74d000p-2, 0x1.051009ef23164p-48 },
+	{ 0x1.8acb910000000p-1, 0x1.0a324e0f39000p-2, 0x1.c6c7e7ef400cep-47 },
+	{ 0x1.886e5f0000000p-1, 0x1.1058bfb6e5000p-2, -0x1.4ab85017d525bp-44 },
+	{ 0x1.8618618000000p-1, 0x1.1675cacaba000p-2, 0x1.83816731f55d9p-44 },
+	{ 0x1.83c9778000000p-1, 0x1.1c898c889a000p-2, -0x1.8127ac5c60cdbp-44 },
+	{ 0x1.8181818000000p-1, 0x1.22941fc0f8000p-2, -0x1.a697675eb0962p-44 },
+	{ 0x1.7f40600000000p-1, 0x1.2895a0bde8000p-2, 0x1.a8f7ad24be946p-44 },
+	{ 0x1.7d05f40000000p-1, 0x1.2e8e2bee12000p-2, -0x1.67a1e99b7212dp-45 },
+	{ 0x1.7ad2208000000p-1, 0x1.347dd9cf88000p-2, -0x1.558f394c57e56p-45 },
+	{ 0x1.78a4c80000000p-1, 0x1.3a64c59694000p-2, 0x1.7a79cbcd73b26p-44 },
+	{ 0x1.767dce8000000p-1, 0x1.404307c26a000p-2, 0x1.f925150499ac3p-44 },
+	{ 0x1.745d178000000p-1, 0x1.4618bb81c6000p-2, -0x1.3cbaf484dd222p-46 },
+	{ 0x1.7242880000000p-1, 0x1.4be5f93778000p-2, -0x1.d7c72cd9ad8cfp-44 },
+	{ 0x1.702e060000000p-1, 0x1.51aad7c2e0000p-2, -0x1.f4810db0aebacp-44 },
+	{ 0x1.6e1f768000000p-1, 0x1.5767720656000p-2, -0x1.64c1375249879p-44 },
+	{ 0x1.6c16c18000000p-1, 0x1.5d1bdbbd81000p-2, -0x1.8d65bc9c7c5cbp-44 },
+	{ 0x1.6a13cd0000000p-1, 0x1.62c82f679c000p-2, 0x1.e552e3d7c8efdp-44 },
+	{ 0x1.6816818000000p-1, 0x1.686c81a5b1000p-2, 0x1.2bba18af839eep-44 },
+	{ 0x1.661ec68000000p-1, 0x1.6e08eb0cba000p-2, 0x1.e3e3db931ee5ep-46 },
+	{ 0x1.642c858000000p-1, 0x1.739d7f9bbd000p-2, 0x1.abb8931522b50p-52 },
+	{ 0x1.623fa78000000p-1, 0x1.792a55cfd4000p-2, 0x1.e8a3277691defp-44 },
+	{ 0x1.6058160000000p-1, 0x1.7eaf83c82b000p-2, -0x1.e4ca62d0c2303p-49 },
+	{ 0x1.5e75bb8000000p-1, 0x1.842d1dc7e9000p-2, -0x1.3a2adf3ae675ep-44 },
+	{ 0x1.5c98828000000p-1, 0x1.89a3391414000p-2, 0x1.2dc9138c4c972p-45 },
+	{ 0x1.5ac0568000000p-1, 0x1.8f11e90166000p-2, 0x1.640dcfb4f1fcep-45 },
+	{ 0x1.58ed230000000p-1, 0x1.947941da11000p-2, 0x1.beafb3374523cp-44 },
+	{ 0x1.571ed40000000p-1, 0x1.99d957617e000p-2, 0x1.177b525da119bp-47 },
+};
@@ -0,0 +1,126 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _EXPF_LOGF_H_
+#define _EXPF_LOGF_H_
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#include "math_private.h"
+
+/*
+ * The kernels of expf(), logf() and powf(). They work in double precision,
+ * which ARM's VFP and x86's SSE2 pipeline about as well as single, so
+ * that the float results are rounded once from values with far smaller
+ * errors, and need no argument splitting. Each one is a small table lookup
+ * and a short polynomial, without any division or data-dependent branch.
+ */
+
+#define	EXP2F_TABLE_BITS	5
+#define	EXP2F_N			(1 << EXP2F_TABLE_BITS)
+#define	LOGF_TABLE_BITS		4
+#define	LOGF_N			(1 << LOGF_TABLE_BITS)
+
+/*
+ * The bits of the float that starts the first logf interval, 0.699: x is
+ * written as 2^k * z with z in [0.699, 1.398), the range split into LOGF_N
+ * intervals by the top bits of its mantissa.
+ */
+#define	LOGF_OFF		0x3f330000
+
+/* 2^(i/EXP2F_N), as bits with i << (52 - EXP2F_TABLE_BITS) subtracted. */
+extern const uint64_t __exp2f_table[EXP2F_N] __LIBC_HIDDEN__;
+
+/*
+ * For each interval, the double nearest 1/c for its center c (1 for the
+ * interval containing 1, whose results need the most relative accuracy),
+ * and log(c) for that double.
+ */
+extern const struct logf_entry {
+	double invc, logc;
+} __logf_table[LOGF_N] __LIBC_HIDDEN__;
+
+/*
+ * e^x for |x| < 104, which covers every float result, with a relative error
+ * below 2^-33: e^x = 2^(k/EXP2F_N) * 2^(r/EXP2F_N), with |r| <= 1/2.
+ */
+static inline double
+__expf_kernel(double x)
+{
+	static const double
+	shift   = 0x1.8p52,			/* rounds to integers */
+	invln2n = 0x1.71547652b82fep+5,		/* EXP2F_N/ln(2) */
+	c0      = 0x1.c6b08d704a0c0p-20,	/* (ln(2)/EXP2F_N)^3/6 */
+	c1      = 0x1.ebfbdff82c58fp-13,	/* (ln(2)/EXP2F_N)^2/2 */
+	c2      = 0x1.62e42fefa39efp-6;		/* ln(2)/EXP2F_N */
+	double kd, r, s, z;
+	uint64_t ki, t;
+
+	z = invln2n * x;
+	kd = z + shift;
+	EXTRACT_WORD64(ki, kd);
+	kd -= shift;
+	r = z - kd;
+	t = __exp2f_table[ki % EXP2F_N] + (ki << (52 - EXP2F_TABLE_BITS));
+	INSERT_WORD64(s, t);
+	return ((c0 * r + c1) * (r * r) + (c2 * r + 1)) * s;
+}
+
+/*
+ * log(x) for the bits of a positive normal float x, with a relative error
+ * below 2^-40: log(x) = k*log(2) + log(c) + log(1 + r), with r = z/c - 1
+ * and |r| < 0.032. The Taylor series of log(1 + r) goes to r^7.
+ */
+static inline double
+__logf_kernel(uint32_t ix)
+{
+	static const double
+	ln2 = 0x1.62e42fefa39efp-1,
+	a2  = -0x1p-1,
+	a3  =  0x1.5555555555555p-2,
+	a4  = -0x1p-2,
+	a5  =  0x1.999999999999ap-3,
+	a6  = -0x1.5555555555555p-3,
+	a7  =  0x1.2492492492492p-3;
+	double p, r, r2;
+	float z;
+	uint32_t tmp;
+	int i, k;
+
+	tmp = ix - LOGF_OFF;
+	i = (tmp >> (23 - LOGF_TABLE_BITS)) % LOGF_N;
+	k = (int32_t)tmp >> 23;
+	SET_FLOAT_WORD(z, ix - (tmp & 0xff800000));
+
+	r = z * __logf_table[i].invc - 1;
+	r2 = r * r;
+	p = ((a7 * r + a6) * r2 + (a5 * r + a4)) * r2 + (a3 * r + a2);
+	return (k * ln2 + __logf_table[i].logc + r) + p * r2;
+}
+
+#endif /* _EXPF_LOGF_H_ */
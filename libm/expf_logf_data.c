@@ -0,0 +1,58 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "expf_logf.h"
+
+const uint64_t __exp2f_table[EXP2F_N] = {
+	0x3ff0000000000000ULL, 0x3fefd9b0d3158574ULL, 0x3fefb5586cf9890fULL, 0x3fef9301d0125b51ULL,
+	0x3fef72b83c7d517bULL, 0x3fef54873168b9aaULL, 0x3fef387a6e756238ULL, 0x3fef1e9df51fdee1ULL,
+	0x3fef06fe0a31b715ULL, 0x3feef1a7373aa9cbULL, 0x3feedea64c123422ULL, 0x3feece086061892dULL,
+	0x3feebfdad5362a27ULL, 0x3feeb42b569d4f82ULL, 0x3feeab07dd485429ULL, 0x3feea47eb03a5585ULL,
+	0x3feea09e667f3bcdULL, 0x3fee9f75e8ec5f74ULL, 0x3feea11473eb0187ULL, 0x3feea589994cce13ULL,
+	0x3feeace5422aa0dbULL, 0x3feeb737b0cdc5e5ULL, 0x3feec49182a3f090ULL, 0x3feed503b23e255dULL,
+	0x3feee89f995ad3adULL, 0x3feeff76f2fb5e47ULL, 0x3fef199bdd85529cULL, 0x3fef3720dcef9069ULL,
+	0x3fef5818dcfba487ULL, 0x3fef7c97337b9b5fULL, 0x3fefa4afa2a490daULL, 0x3fefd0765b6e4540ULL,
+};
+
+const struct logf_entry __logf_table[LOGF_N] = {
+	{ 0x1.661ec6a5122f9p+0, -0x1.57bf753c8d1fbp-2 },
+	{ 0x1.571ed3c506b3ap+0, -0x1.2bef07cdc9355p-2 },
+	{ 0x1.49539e3b2d067p+0, -0x1.01eae5626c691p-2 },
+	{ 0x1.3c995a47babe7p+0, -0x1.b31d8575bce3bp-3 },
+	{ 0x1.30d190130d190p+0, -0x1.6574ebe8c1339p-3 },
+	{ 0x1.25e22708092f1p+0, -0x1.1aa2b7e23f729p-3 },
+	{ 0x1.1bb4a4046ed29p+0, -0x1.a4e7640b1bc38p-4 },
+	{ 0x1.12358e75d3033p+0, -0x1.1973bd1465561p-4 },
+	{ 0x1.0953f39010954p+0, -0x1.252f32f8d1840p-5 },
+	{ 0x1p+0, 0x0p+0 },
+	{ 0x1.e573ac901e574p-1, 0x1.b42dd711971b9p-5 },
+	{ 0x1.ca4b3055ee191p-1, 0x1.c5e548f5bc743p-4 },
+	{ 0x1.b2036406c80d9p-1, 0x1.526e5e3a1b438p-3 },
+	{ 0x1.9c2d14ee4a102p-1, 0x1.bc286742d8cd4p-3 },
+	{ 0x1.886e5f0abb04ap-1, 0x1.1058bf9ae4ad4p-2 },
+	{ 0x1.767dce434a9b1p-1, 0x1.404308686a7e4p-2 },
+};
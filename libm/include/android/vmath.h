@@ -0,0 +1,76 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _ANDROID_VMATH_H_
+#define _ANDROID_VMATH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/*
+ * Array versions of <math.h> functions: out[i] = f(x[i]) for i < n. 'out'
+ * may be the same array as an input, but must not otherwise overlap one.
+ * They are faster than a loop over the scalar functions (four elements at a
+ * time, with NEON on ARM and SSE2 on x86), and give the same results for
+ * infinities, NaNs, and arguments outside the range the vector code covers.
+ * The maximum errors over all other arguments, in units in the last place
+ * and in the default rounding mode, are:
+ *
+ *   vexpf  0.56 ulp
+ *   vlogf  0.54 ulp
+ *   vsinf  0.78 ulp
+ *   vcosf  0.79 ulp
+ *   vpowf  0.56 ulp
+ *
+ * (The unary functions were checked against every float, vpowf against
+ * random pairs of arguments.)
+ */
+extern void vexpf(const float* x, float* out, size_t n);
+extern void vlogf(const float* x, float* out, size_t n);
+extern void vsinf(const float* x, float* out, size_t n);
+extern void vcosf(const float* x, float* out, size_t n);
+
+/* out[i] = powf(x[i], y[i]) for i < n. */
+extern void vpowf(const float* x, const float* y, float* out, size_t n);
+
+/*
+ * Conversions between float and 16-bit samples, eight at a time, for which
+ * 'out' must not overlap 'x'. vftoi16() rounds scale*x[i] to the nearest
+ * integer, ties to even as lrintf() does in the default rounding mode, and
+ * saturates it to [INT16_MIN, INT16_MAX]; NaNs give 0. vi16tof() gives
+ * x[i]*scale, rounded once (on ARM, NEON flushes subnormal products to 0).
+ * A scale of 32768 and one of 1/32768 convert between [-1, 1) and PCM.
+ */
+extern void vftoi16(const float* x, float scale, int16_t* out, size_t n);
+extern void vi16tof(const int16_t* x, float scale, float* out, size_t n);
+
+__END_DECLS
+
+#endif /* _ANDROID_VMATH_H_ */
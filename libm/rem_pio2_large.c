@@ -0,0 +1,192 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <float.h>
+#include <stdint.h>
+
+#include "math.h"
+#include "math_private.h"
+
+/*
+ * msun's __kernel_rem_pio2() handles any precision and any number of input
+ * chunks, converting the bits of 2/pi to doubles and summing partial
+ * products on every call. The only callers here are the double and float
+ * reductions, so this version reads a window of 2/pi straight from a table
+ * of 32-bit words and does the product with integer multiplies, falling
+ * back to the general one for anything else.
+ */
+int __kernel_rem_pio2_generic(double*, double*, int, int, int) __LIBC_HIDDEN__;
+
+#define	__kernel_rem_pio2 __kernel_rem_pio2_generic
+#include "k_rem_pio2.c"
+#undef	__kernel_rem_pio2
+
+/*
+ * The bits of 2/pi after the binary point, bit 1 the top bit of the third
+ * word. The two zero words in front stand for the bits at and above the
+ * binary point, so that windows for smaller arguments need no special case.
+ * The table ends with the last bit the largest double needs.
+ */
+#define	TWO_OVER_PI_PAD	2
+
+static const uint32_t two_over_pi[] = {
+	0x00000000, 0x00000000,
+	0xa2f9836e, 0x4e441529, 0xfc2757d1, 0xf534ddc0,
+	0xdb629599, 0x3c439041, 0xfe5163ab, 0xdebbc561,
+	0xb7246e3a, 0x424dd2e0, 0x06492eea, 0x09d1921c,
+	0xfe1deb1c, 0xb129a73e, 0xe88235f5, 0x2ebb4484,
+	0xe99c7026, 0xb45f7e41, 0x3991d639, 0x835339f4,
+	0x9c845f8b, 0xbdf9283b, 0x1ff897ff, 0xde05980f,
+	0xef2f118b, 0x5a0a6d1f, 0x6d367ecf, 0x27cb09b7,
+	0x4f463f66, 0x9e5fea2d, 0x7527bac7, 0xebe5f17b,
+	0x3d0739f7, 0x8a5292ea, 0x6bfb5fb1, 0x1f8d5d08,
+	0x56033046,
+};
+
+static const double
+pio2    = 1.57079632679489655800e+00, /* 0x3FF921FB, 0x54442D18 */
+pio2_1  = 1.57079632673412561417e+00, /* 0x3FF921FB, 0x54400000 */
+pio2_1t = 6.07710050650619224932e-11; /* 0x3DD0B461, 0x1A626331 */
+
+static const double sign[2] = { 1.0, -1.0 };
+
+/*
+ * The argument is m * 2^e with m a 53-bit integer. Bits of 2/pi above bit
+ * e-2 only add multiples of 8 to m * 2^e * 2/pi, so the window W is the 192
+ * bits from there, and m * W * 2^-189 is the product mod 8, short by less
+ * than 2^-136. For no double is x * 2/pi within 2^-62 of an integer, which
+ * leaves more than 70 good bits in the fraction.
+ */
+int
+__kernel_rem_pio2(double *x, double *y, int e0, int nx, int prec)
+{
+	uint32_t w[6], p[6], mh, ml, hx, lx, neg, mask;
+	uint64_t pl[6], ph[5], t, q2, q1, q0, hi, lo;
+	double z, s, fhi, flo, a, b;
+	int e, k, i, j, n, sh;
+
+	if (nx > 3 || prec > 1)
+		return __kernel_rem_pio2_generic(x, y, e0, nx, prec);
+
+	/* Put back the bits the caller split into 24-bit chunks. */
+	z = x[0];
+	if (nx > 1)
+		z += x[1] * 0x1p-24;
+	if (nx > 2)
+		z += x[2] * 0x1p-48;
+	EXTRACT_WORDS(hx, lx, z);
+	mh = (hx & 0xfffff) | 0x100000;
+	ml = lx;
+	e = (int)(hx >> 20) - 1023 - 52 + e0;
+	if (e < -61)
+		return __kernel_rem_pio2_generic(x, y, e0, nx, prec);
+
+	/* The 192-bit window starting at bit e-2, least significant word first. */
+	k = e - 3 + 32 * TWO_OVER_PI_PAD;
+	j = k >> 5;
+	sh = k & 31;
+	for (i = 0; i < 6; i++) {
+		w[5 - i] = two_over_pi[j + i] << sh;
+		if (sh != 0)
+			w[5 - i] |= two_over_pi[j + i + 1] >> (32 - sh);
+	}
+
+	/*
+	 * p = (mh * 2^32 + ml) * w mod 2^192. The products are independent, and
+	 * only the additions that gather them into words carry from one word to
+	 * the next.
+	 */
+	for (i = 0; i < 6; i++)
+		pl[i] = (uint64_t)ml * w[i];
+	for (i = 0; i < 5; i++)
+		ph[i] = (uint64_t)mh * w[i];
+	t = (uint32_t)pl[0];
+	p[0] = (uint32_t)t;
+	t = (t >> 32) + (uint32_t)pl[1] + (pl[0] >> 32) + (uint32_t)ph[0];
+	p[1] = (uint32_t)t;
+	for (i = 2; i < 6; i++) {
+		t = (t >> 32) + (uint32_t)pl[i] + (pl[i - 1] >> 32) +
+		    (uint32_t)ph[i - 1] + (ph[i - 2] >> 32);
+		p[i] = (uint32_t)t;
+	}
+
+	/*
+	 * The quadrant, rounded to nearest, and the magnitude of the 189-bit
+	 * fraction left. Which way it rounds is a coin toss for large arguments,
+	 * so the negation is done with a mask rather than a branch.
+	 */
+	n = p[5] >> 29;
+	neg = (p[5] >> 28) & 1;
+	n += neg;
+	mask = -neg;
+	t = neg;
+	for (i = 0; i < 6; i++) {
+		t += p[i] ^ mask;
+		p[i] = (uint32_t)t;
+		t >>= 32;
+	}
+	p[5] &= 0x1fffffff;
+	q2 = ((uint64_t)p[5] << 32) | p[4];
+	q1 = ((uint64_t)p[3] << 32) | p[2];
+	q0 = ((uint64_t)p[1] << 32) | p[0];
+
+	/* Normalize, so that the fraction is +-(hi + lo * 2^-64) * 2^(3-sh-64). */
+	sh = 0;
+	if (q2 == 0) {
+		q2 = q1;
+		q1 = q0;
+		q0 = 0;
+		sh = 64;
+	}
+	if (q2 == 0)		/* can't happen: 2/pi is irrational */
+		return __kernel_rem_pio2_generic(x, y, e0, nx, prec);
+	i = __builtin_clzll(q2);
+	sh += i;
+	if (i != 0) {
+		hi = (q2 << i) | (q1 >> (64 - i));
+		lo = (q1 << i) | (q0 >> (64 - i));
+	} else {
+		hi = q2;
+		lo = q1;
+	}
+	INSERT_WORD64(s, (uint64_t)(0x3ff + 3 - sh - 64) << 52);
+	s *= sign[neg];
+
+	/*
+	 * fhi takes the top 20 bits so that fhi * pio2_1 is exact, and the rest
+	 * only needs the precision of a double.
+	 */
+	fhi = (double)(uint32_t)(hi >> 44) * 0x1p44 * s;
+	flo = ((double)(uint32_t)((hi >> 32) & 0xfff) * 0x1p32 +
+	    (double)(uint32_t)hi + (double)(uint32_t)(lo >> 32) * 0x1p-32) * s;
+	a = fhi * pio2_1;
+	b = fhi * pio2_1t + flo * pio2;
+	y[0] = a + b;
+	if (prec == 1)
+		y[1] = (a - y[0]) + b;
+	return n & 7;
+}
@@ -25,27 +25,72 @@
  *
  */
 #define _GNU_SOURCE 1
-#include <math.h>
-
-// Disable sincos optimization for all functions in this file,
-// otherwise gcc would generate infinite calls.
-// Refer to gcc PR46926.
-// -fno-builtin-sin or -fno-builtin-cos can disable sincos optimization,
-// but these two options do not work inside optimize pragma in-file.
-// Thus we just enforce -O0 when compiling this file.
-#pragma GCC optimize ("O0")
-
-void sincos(double x, double* p_sin, double* p_cos) {
-  *p_sin = sin(x);
-  *p_cos = cos(x);
-}
 
-void sincosf(float x, float* p_sinf, float* p_cosf) {
-  *p_sinf = sinf(x);
-  *p_cosf = cosf(x);
+#include <float.h>
+
+#define _GNU_SOURCE 1
+#include "math.h"
+#define INLINE_REM_PIO2
+#include "math_private.h"
+#include "e_rem_pio2.c"
+
+/*
+ * sin(x) and cos(x) from one argument reduction: the same steps as msun's
+ * sin() and cos(), with both kernels run on the reduced argument.
+ */
+void
+sincos(double x, double* p_sin, double* p_cos)
+{
+	double y[2];
+	int32_t n, ix;
+
+	GET_HIGH_WORD(ix,x);
+
+    /* |x| ~< pi/4 */
+	ix &= 0x7fffffff;
+	if(ix <= 0x3fe921fb) {
+	    if(ix<0x3e400000)			/* |x| < 2**-27 */
+		if(((int)x)==0) {		/* generate inexact */
+		    *p_sin = x;
+		    *p_cos = 1.0;
+		    return;
+		}
+	    *p_sin = __kernel_sin(x,0.0,0);
+	    *p_cos = __kernel_cos(x,0.0);
+	    return;
+	}
+
+    /* sin(Inf or NaN) and cos(Inf or NaN) are NaN */
+	if (ix>=0x7ff00000) {
+	    *p_sin = *p_cos = x-x;
+	    return;
+	}
+
+    /* argument reduction needed */
+	n = __ieee754_rem_pio2(x,y);
+	switch(n&3) {
+	    case 0:
+		*p_sin =  __kernel_sin(y[0],y[1],1);
+		*p_cos =  __kernel_cos(y[0],y[1]);
+		break;
+	    case 1:
+		*p_sin =  __kernel_cos(y[0],y[1]);
+		*p_cos = -__kernel_sin(y[0],y[1],1);
+		break;
+	    case 2:
+		*p_sin = -__kernel_sin(y[0],y[1],1);
+		*p_cos = -__kernel_cos(y[0],y[1]);
+		break;
+	    default:
+		*p_sin = -__kernel_cos(y[0],y[1]);
+		*p_cos =  __kernel_sin(y[0],y[1],1);
+		break;
+	}
 }
 
-void sincosl(long double x, long double* p_sinl, long double* p_cosl) {
-  *p_sinl = sinl(x);
-  *p_cosl = cosl(x);
+/* On Android, "long double" is "double" (see fake_long_double.c). */
+void
+sincosl(long double x, long double* p_sinl, long double* p_cosl)
+{
+	sincos(x, (double*) p_sinl, (double*) p_cosl);
 }
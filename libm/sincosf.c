@@ -0,0 +1,134 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+#define _GNU_SOURCE 1
+
+#define _GNU_SOURCE 1
+#include "math.h"
+#define	INLINE_KERNEL_COSDF
+#define	INLINE_KERNEL_SINDF
+#define INLINE_REM_PIO2F
+#include "math_private.h"
+#include "e_rem_pio2f.c"
+#include "k_cosf.c"
+#include "k_sinf.c"
+
+/* Small multiples of pi/2 rounded to double precision. */
+static const double
+p1pio2 = 1*M_PI_2,			/* 0x3FF921FB, 0x54442D18 */
+p2pio2 = 2*M_PI_2,			/* 0x400921FB, 0x54442D18 */
+p3pio2 = 3*M_PI_2,			/* 0x4012D97C, 0x7F3321D2 */
+p4pio2 = 4*M_PI_2;			/* 0x401921FB, 0x54442D18 */
+
+/*
+ * sinf(x) and cosf(x) from one argument reduction: the same steps as msun's
+ * sinf() and cosf(), which reduce by the same multiples of pi/2, with both
+ * kernels run on the reduced argument.
+ */
+void
+sincosf(float x, float* p_sinf, float* p_cosf)
+{
+	double y;
+	int32_t n, hx, ix;
+
+	GET_FLOAT_WORD(hx,x);
+	ix = hx & 0x7fffffff;
+
+	if(ix <= 0x3f490fda) {		/* |x| ~<= pi/4 */
+	    if(ix<0x39800000)		/* |x| < 2**-12 */
+		if(((int)x)==0) {	/* x and 1 with inexact if x != 0 */
+		    *p_sinf = x;
+		    *p_cosf = 1.0f;
+		    return;
+		}
+	    *p_sinf = __kernel_sindf(x);
+	    *p_cosf = __kernel_cosdf(x);
+	    return;
+	}
+	if(ix<=0x407b53d1) {		/* |x| ~<= 5*pi/4 */
+	    if(ix<=0x4016cbe3) {	/* |x| ~<= 3pi/4 */
+		if(hx>0) {
+		    y = x - p1pio2;
+		    *p_sinf =  __kernel_cosdf(y);
+		    *p_cosf = -__kernel_sindf(y);
+		} else {
+		    y = x + p1pio2;
+		    *p_sinf = -__kernel_cosdf(y);
+		    *p_cosf =  __kernel_sindf(y);
+		}
+	    } else {
+		y = x + (hx > 0 ? -p2pio2 : p2pio2);
+		*p_sinf = -__kernel_sindf(y);
+		*p_cosf = -__kernel_cosdf(y);
+	    }
+	    return;
+	}
+	if(ix<=0x40e231d5) {		/* |x| ~<= 9*pi/4 */
+	    if(ix<=0x40afeddf) {	/* |x| ~<= 7*pi/4 */
+		if(hx>0) {
+		    y = x - p3pio2;
+		    *p_sinf = -__kernel_cosdf(y);
+		    *p_cosf =  __kernel_sindf(y);
+		} else {
+		    y = x + p3pio2;
+		    *p_sinf =  __kernel_cosdf(y);
+		    *p_cosf = -__kernel_sindf(y);
+		}
+	    } else {
+		y = x + (hx > 0 ? -p4pio2 : p4pio2);
+		*p_sinf = __kernel_sindf(y);
+		*p_cosf = __kernel_cosdf(y);
+	    }
+	    return;
+	}
+
+    /* sinf(Inf or NaN) and cosf(Inf or NaN) are NaN */
+	if (ix>=0x7f800000) {
+	    *p_sinf = *p_cosf = x-x;
+	    return;
+	}
+
+    /* general argument reduction needed */
+	n = __ieee754_rem_pio2f(x,&y);
+	switch(n&3) {
+	    case 0:
+		*p_sinf =  __kernel_sindf(y);
+		*p_cosf =  __kernel_cosdf(y);
+		break;
+	    case 1:
+		*p_sinf =  __kernel_cosdf(y);
+		*p_cosf = -__kernel_sindf(y);
+		break;
+	    case 2:
+		*p_sinf = -__kernel_sindf(y);
+		*p_cosf = -__kernel_cosdf(y);
+		break;
+	    default:
+		*p_sinf = -__kernel_cosdf(y);
+		*p_cosf =  __kernel_sindf(y);
+		break;
+	}
+}
@@ -0,0 +1,469 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <android/vmath.h>
+
+#include <math.h>
+#include <string.h>
+#include <sys/cdefs.h>
+
+#include "vmath_simd.h"
+
+#if defined(VMATH_HAVE_SIMD)
+
+/*
+ * Each function works on four lanes at a time. Lanes the vector code can't
+ * handle (infinities, NaNs, subnormals, negative logarithms, results outside
+ * the normal range, and large trigonometric arguments) are flagged as
+ * special and recomputed with the scalar function, so that every edge case
+ * is exactly what <math.h> gives. Rounding to the nearest integer is done by
+ * adding and subtracting kShifter, which assumes the default rounding mode.
+ */
+
+static const float kShifter = 0x1.8p23f;
+
+/* Returns a*b, setting '*err' to its exact rounding error (Dekker). */
+static inline vf two_prod(vf a, vf b, vf* err) {
+  vf p = vf_mul(a, b);
+  vf ca = vf_mul(a, vf_dup(4097.0f));
+  vf ah = vf_sub(ca, vf_sub(ca, a));
+  vf al = vf_sub(a, ah);
+  vf cb = vf_mul(b, vf_dup(4097.0f));
+  vf bh = vf_sub(cb, vf_sub(cb, b));
+  vf bl = vf_sub(b, bh);
+  *err = vf_add(vf_add(vf_add(vf_sub(vf_mul(ah, bh), p), vf_mul(ah, bl)), vf_mul(al, bh)),
+                vf_mul(al, bl));
+  return p;
+}
+
+/* Returns a+b, setting '*err' to its exact rounding error (Knuth). */
+static inline vf two_sum(vf a, vf b, vf* err) {
+  vf s = vf_add(a, b);
+  vf bb = vf_sub(s, a);
+  *err = vf_add(vf_sub(a, vf_sub(s, bb)), vf_sub(b, bb));
+  return s;
+}
+
+static inline vf vf_abs(vf a) {
+  return vu_as_vf(vu_and(vf_bits(a), vu_dup(0x7fffffff)));
+}
+
+/* The polynomials below are Taylor series, which have far more accuracy
+ * than a float needs over the reduced ranges they're used on. */
+
+/* e^r - 1, for |r| <= ln(2)/32. */
+static inline vf expm1_poly(vf r) {
+  vf p = vf_dup(0x1.555556p-5f);
+  p = vf_add(vf_mul(p, r), vf_dup(0x1.555556p-3f));
+  p = vf_add(vf_mul(p, r), vf_dup(0x1p-1f));
+  return vf_add(r, vf_mul(vf_mul(r, r), p));
+}
+
+/* 2^f - 1, for |f| <= 1/32. */
+static inline vf exp2m1_poly(vf f) {
+  vf p = vf_dup(0x1.3b2ab6p-7f);
+  p = vf_add(vf_mul(p, f), vf_dup(0x1.c6b08ep-5f));
+  p = vf_add(vf_mul(p, f), vf_dup(0x1.ebfbep-3f));
+  p = vf_add(vf_mul(p, f), vf_dup(0x1.62e43p-1f));
+  return vf_mul(f, p);
+}
+
+/* sin(r + r_lo) and cos(r + r_lo), for |r| <= pi/4 and tiny r_lo. */
+static inline vf sin_poly(vf r, vf r2, vf r_lo) {
+  vf p = vf_dup(0x1.71de3ap-19f);
+  p = vf_add(vf_mul(p, r2), vf_dup(-0x1.a01a02p-13f));
+  p = vf_add(vf_mul(p, r2), vf_dup(0x1.111112p-7f));
+  p = vf_add(vf_mul(p, r2), vf_dup(-0x1.555556p-3f));
+  vf lo = vf_mul(r_lo, vf_sub(vf_dup(1.0f), vf_mul(r2, vf_dup(0.5f))));
+  return vf_add(r, vf_add(vf_mul(vf_mul(r, r2), p), lo));
+}
+
+static inline vf cos_poly(vf r, vf r2, vf r_lo) {
+  vf p = vf_dup(-0x1.27e4fcp-22f);
+  p = vf_add(vf_mul(p, r2), vf_dup(0x1.a01a02p-16f));
+  p = vf_add(vf_mul(p, r2), vf_dup(-0x1.6c16c2p-10f));
+  p = vf_add(vf_mul(p, r2), vf_dup(0x1.555556p-5f));
+  /* 1 - r^2/2 is rounded once, and its rounding error kept (as k_cos.c does). */
+  vf hz = vf_mul(r2, vf_dup(0.5f));
+  vf w = vf_sub(vf_dup(1.0f), hz);
+  vf lo = vf_sub(vf_mul(vf_mul(r2, r2), p), vf_mul(r, r_lo));
+  return vf_add(w, vf_add(vf_sub(vf_sub(vf_dup(1.0f), w), hz), lo));
+}
+
+/* 2^(j/16) as the unevaluated sum of two floats. */
+static const struct {
+  float hi, lo;
+} kExp2Table[16] = {
+  { 0x1p+0f, 0.0f },
+  { 0x1.0b5586p+0f, 0x1.9f3122p-25f },
+  { 0x1.172b84p+0f, -0x1.c15742p-27f },
+  { 0x1.2387a6p+0f, 0x1.ceac48p-25f },
+  { 0x1.306fep+0f, 0x1.4636e2p-25f },
+  { 0x1.3dea64p+0f, 0x1.824684p-25f },
+  { 0x1.4bfdaep+0f, -0x1.593abcp-25f },
+  { 0x1.5ab07ep+0f, -0x1.5bd5ecp-27f },
+  { 0x1.6a09e6p+0f, 0x1.9fcef4p-26f },
+  { 0x1.7a1148p+0f, -0x1.829fdp-25f },
+  { 0x1.8ace54p+0f, 0x1.15506ep-27f },
+  { 0x1.9c4918p+0f, 0x1.51f848p-27f },
+  { 0x1.ae89fap+0f, -0x1.a94b14p-26f },
+  { 0x1.c199bep+0f, -0x1.3d56b2p-27f },
+  { 0x1.d5818ep+0f, -0x1.822dbcp-27f },
+  { 0x1.ea4afap+0f, 0x1.52486cp-27f },
+};
+
+#define EXP2_TABLE_GATHER(field, i) \
+  vf_load((const float[4]) { kExp2Table[(i)[0]].field, kExp2Table[(i)[1]].field, \
+                             kExp2Table[(i)[2]].field, kExp2Table[(i)[3]].field })
+
+/* Returns 2^(nj/16) * (1 + p) for integers nj, when the result is normal.
+ * Only p's own rounding error is added to that of the final addition. */
+static inline vf exp2_table_scale(vu nj, vf p) {
+  uint32_t j[4];
+  vu_store(j, vu_and(nj, vu_dup(15)));
+  vf hi = EXP2_TABLE_GATHER(hi, j);
+  vf r = vf_add(hi, vf_add(vf_mul(hi, p), EXP2_TABLE_GATHER(lo, j)));
+  return vu_as_vf(vu_add(vf_bits(r), vu_shl(vu_sra(nj, 4), 23)));
+}
+
+static inline vf expf_lanes(vf x, vu* special) {
+  /* e^x = 2^(nj/16) * e^r, with |r| <= ln(2)/32. The first part of ln(2)/16
+   * has few enough bits for nj times it to be exact. */
+  *special = vu_not(vf_lt(vf_abs(x), vf_dup(86.0f)));
+  vf z = vf_add(vf_mul(x, vf_dup(0x1.715476p+4f)), vf_dup(kShifter));
+  vf nj = vf_sub(z, vf_dup(kShifter));
+  vf r = vf_sub(vf_sub(x, vf_mul(nj, vf_dup(0x1.62ep-5f))), vf_mul(nj, vf_dup(0x1.0bfbe8p-19f)));
+  return exp2_table_scale(vu_sub(vf_bits(z), vf_bits(vf_dup(kShifter))), expm1_poly(r));
+}
+
+/*
+ * The logarithms write x as 2^k * z, with z in [0.699, 1.398) split into 16
+ * intervals, and multiply z by an approximation of 1/c for the center c of
+ * its interval: log(x) = k*log(2) + log(c) + log(1 + a), |a| < 0.03. The
+ * interval containing 1 uses c = 1, so that results near x = 1 keep their
+ * relative accuracy.
+ */
+#define LOG_TABLE_OFFSET 0x3f330000
+
+static const struct {
+  float invc, logc_hi, logc_lo, log2c_hi, log2c_lo;
+} kLogTable[16] = {
+  { 0x1.661ec6p+0f, -0x1.57bf74p-2f, 0x1.36e5c2p-27f, -0x1.efec6p-2f, 0x1.f1c384p-27f },
+  { 0x1.571ed4p+0f, -0x1.2bef08p-2f, -0x1.f724d4p-28f, -0x1.b0b68p-2f, -0x1.34c248p-28f },
+  { 0x1.49539ep+0f, -0x1.01eae4p-2f, -0x1.54d8d2p-27f, -0x1.7418acp-2f, 0x1.db59c4p-30f },
+  { 0x1.3c995ap+0f, -0x1.b31d84p-3f, 0x1.690c72p-29f, -0x1.39de8cp-2f, -0x1.8d4ad8p-27f },
+  { 0x1.30d19p+0f, -0x1.6574ecp-3f, 0x1.2e7d98p-28f, -0x1.01d9bcp-2f, 0x1.195ep-27f },
+  { 0x1.25e228p+0f, -0x1.1aa2bep-3f, -0x1.447eep-28f, -0x1.97c1d4p-3f, -0x1.a1840ep-28f },
+  { 0x1.1bb4a4p+0f, -0x1.a4e764p-4f, 0x1.a721e4p-31f, -0x1.2f9e32p-3f, -0x1.4f2a9cp-28f },
+  { 0x1.12358ep+0f, -0x1.1973b6p-4f, -0x1.a32aa8p-31f, -0x1.960ca6p-4f, 0x1.41a4ccp-30f },
+  { 0x1.0953f4p+0f, -0x1.252f4p-5f, -0x1.e34604p-31f, -0x1.a6f9d6p-5f, -0x1.e3a2d6p-30f },
+  { 0x1p+0f, 0.0f, 0.0f, 0.0f, 0.0f },
+  { 0x1.e573acp-1f, 0x1.b42dep-5f, 0x1.232e3ap-30f, 0x1.3aa304p-4f, 0x1.59a09ep-29f },
+  { 0x1.ca4b3p-1f, 0x1.c5e54cp-4f, -0x1.48717p-33f, 0x1.476aa2p-3f, -0x1.ee0eccp-30f },
+  { 0x1.b20364p-1f, 0x1.526e5ep-3f, 0x1.686d0ep-29f, 0x1.e840bep-3f, 0x1.462268p-28f },
+  { 0x1.9c2d14p-1f, 0x1.bc286cp-3f, -0x1.d27314p-31f, 0x1.406468p-2f, -0x1.f078d2p-27f },
+  { 0x1.886e6p-1f, 0x1.1058bep-2f, -0x1.ca36a4p-27f, 0x1.88e9c4p-2f, -0x1.b52012p-28f },
+  { 0x1.767dcep-1f, 0x1.40430ap-2f, -0x1.bf2b04p-27f, 0x1.ce0a4ap-2f, 0x1.68d1e8p-29f },
+};
+
+#define LOG_TABLE_GATHER(field, i) \
+  vf_load((const float[4]) { kLogTable[(i)[0]].field, kLogTable[(i)[1]].field, \
+                             kLogTable[(i)[2]].field, kLogTable[(i)[3]].field })
+
+/* Zero, negative, subnormal, infinite and NaN x. */
+static inline vu log_special(vu ix) {
+  return vu_gt(vu_sub(ix, vu_dup(0x00800000)), vu_dup(0x7effffff));
+}
+
+/* Returns a, and sets '*kf' to k, '*e' to the rounding error of a, and 'i' to
+ * the table indexes. */
+static inline vf log_reduce(vu ix, vf* kf, vf* e, uint32_t i[4]) {
+  vu tmp = vu_sub(ix, vu_dup(LOG_TABLE_OFFSET));
+  vu_store(i, vu_and(vu_shr(tmp, 19), vu_dup(15)));
+  *kf = vs_to_vf(vu_sra(tmp, 23));
+  vf z = vu_as_vf(vu_sub(ix, vu_and(tmp, vu_dup(0xff800000))));
+  /* z*invc is close enough to 1 that subtracting 1 is exact. */
+  return vf_sub(two_prod(z, LOG_TABLE_GATHER(invc, i), e), vf_dup(1.0f));
+}
+
+static inline vf logf_lanes(vf x, vu* special) {
+  vu ix = vf_bits(x);
+  *special = log_special(ix);
+  vf kf, e;
+  uint32_t i[4];
+  vf a = log_reduce(ix, &kf, &e, i);
+
+  /* log(1 + a) - a. The rounding error e of a adds e - a*e. */
+  vf q = vf_dup(-0x1.555556p-3f);
+  q = vf_add(vf_mul(q, a), vf_dup(0x1.99999ap-3f));
+  q = vf_add(vf_mul(q, a), vf_dup(-0x1p-2f));
+  q = vf_add(vf_mul(q, a), vf_dup(0x1.555556p-2f));
+  q = vf_add(vf_mul(q, a), vf_dup(-0x1p-1f));
+  q = vf_mul(vf_mul(a, a), q);
+
+  /* k*log(2) + log(c) + a, keeping the rounding errors of the two sums. */
+  vf e1, e2;
+  vf s = two_sum(vf_mul(kf, vf_dup(0x1.62e4p-1f)), LOG_TABLE_GATHER(logc_hi, i), &e1);
+  s = two_sum(s, a, &e2);
+  vf lo = vf_add(vf_mul(kf, vf_dup(0x1.7f7d1cp-20f)), LOG_TABLE_GATHER(logc_lo, i));
+  lo = vf_add(vf_add(vf_add(vf_add(lo, vf_sub(e, vf_mul(a, e))), q), e1), e2);
+  return vf_add(s, lo);
+}
+
+static inline vf sincosf_lanes(vf x, vu* special, uint32_t quadrant) {
+  /* x = n*pi/2 + r + r_lo, with |r| <= pi/4. Below 8192, n has at most 13
+   * bits, so its products with the first three 11-bit parts of pi/2 are
+   * exact, and so is the first subtraction. */
+  *special = vu_not(vf_lt(vf_abs(x), vf_dup(8192.0f)));
+  vf z = vf_add(vf_mul(x, vf_dup(0x1.45f306p-1f)), vf_dup(kShifter));
+  vf n = vf_sub(z, vf_dup(kShifter));
+  vf e1, e2, e3;
+  vf r = vf_sub(x, vf_mul(n, vf_dup(0x1.92p+0f)));
+  r = two_sum(r, vf_mul(n, vf_dup(-0x1.fb4p-12f)), &e1);
+  r = two_sum(r, vf_mul(n, vf_dup(-0x1.444p-24f)), &e2);
+  r = two_sum(r, vf_mul(n, vf_dup(-0x1.68c234p-39f)), &e3);
+  vf r_lo = vf_add(vf_add(e1, e2), e3);
+  vf r2 = vf_mul(r, r);
+
+  /* sin(x + q*pi/2) is sin(r), cos(r), -sin(r) or -cos(r) for q = 0 to 3. */
+  vu q = vu_add(vf_bits(z), vu_dup(quadrant));
+  vu odd = vu_sra(vu_shl(q, 31), 31);
+  vf y = vf_select(odd, cos_poly(r, r2, r_lo), sin_poly(r, r2, r_lo));
+  return vu_as_vf(vu_xor(vf_bits(y), vu_shl(vu_shr(q, 1), 31)));
+}
+
+static inline vf sinf_lanes(vf x, vu* special) {
+  /* sin(x) is x for tiny x, which NEON would flush to zero if subnormal. */
+  vu tiny = vf_lt(vf_abs(x), vf_dup(0x1p-12f));
+  return vf_select(tiny, x, sincosf_lanes(x, special, 0));
+}
+
+static inline vf cosf_lanes(vf x, vu* special) {
+  return sincosf_lanes(x, special, 1);
+}
+
+static inline vf powf_lanes(vf x, vf y, vu* special) {
+  /* x^y = 2^(y*log2(x)), with log2(x) to about 2^-40 relative accuracy as
+   * the unevaluated sum of two floats: errors in y*log2(x) are amplified by
+   * up to 128 in the result. */
+  vu ix = vf_bits(x);
+  *special = vu_or(log_special(ix), vu_not(vf_lt(vf_abs(y), vf_dup(0x1p100f))));
+  vf kf, e;
+  uint32_t i[4];
+  vf a = log_reduce(ix, &kf, &e, i);
+
+  /* log(1 + a + e) = a - a^2/2 + a^3/3 - ... + e/(1 + a), where e is as
+   * large as 2^-24, so e/(1 + a) needs its a^3 term. */
+  vf a2_lo;
+  vf a2 = two_prod(a, a, &a2_lo);
+  vf l_lo;
+  vf l_hi = two_sum(a, vf_mul(a2, vf_dup(-0.5f)), &l_lo);
+  vf p = vf_dup(0x1.24924ap-3f);
+  p = vf_add(vf_mul(p, a), vf_dup(-0x1.555556p-3f));
+  p = vf_add(vf_mul(p, a), vf_dup(0x1.99999ap-3f));
+  p = vf_add(vf_mul(p, a), vf_dup(-0x1p-2f));
+  p = vf_add(vf_mul(p, a), vf_dup(0x1.555556p-2f));
+  p = vf_mul(vf_mul(a2, a), p);
+  vf one = vf_dup(1.0f);
+  vf e_term = vf_mul(e, vf_sub(one, vf_mul(a, vf_sub(one, vf_mul(a, vf_sub(one, a))))));
+  l_lo = vf_add(vf_add(vf_add(l_lo, vf_mul(a2_lo, vf_dup(-0.5f))), p), e_term);
+
+  /* Converted to base 2. */
+  vf m_lo;
+  vf m_hi = two_prod(l_hi, vf_dup(0x1.715476p+0f), &m_lo);
+  m_lo = vf_add(m_lo, vf_add(vf_mul(l_hi, vf_dup(0x1.4ae0cp-26f)),
+                             vf_mul(l_lo, vf_dup(0x1.715476p+0f))));
+
+  /* Plus k + log2(c). */
+  vf e1, e2;
+  vf s = two_sum(kf, LOG_TABLE_GATHER(log2c_hi, i), &e1);
+  s = two_sum(s, m_hi, &e2);
+  vf lo = vf_add(vf_add(vf_add(LOG_TABLE_GATHER(log2c_lo, i), m_lo), e1), e2);
+  vf log_hi = vf_add(s, lo);
+  vf log_lo = vf_sub(lo, vf_sub(log_hi, s));
+
+  /* t = y*log2(x), and 2^t = 2^n * 2^(j/16) * 2^f, with |f| <= 1/32. */
+  vf t_lo;
+  vf t_hi = two_prod(y, log_hi, &t_lo);
+  t_lo = vf_add(t_lo, vf_mul(y, log_lo));
+  *special = vu_or(*special, vu_not(vf_lt(vf_abs(t_hi), vf_dup(125.0f))));
+  vf z = vf_add(t_hi, vf_dup(kShifter / 16));
+  vf f = vf_add(vf_sub(t_hi, vf_sub(z, vf_dup(kShifter / 16))), t_lo);
+  return exp2_table_scale(vu_sub(vf_bits(z), vf_bits(vf_dup(kShifter / 16))), exp2m1_poly(f));
+}
+
+/* Replaces the special lanes of 'y' with the scalar function's results. */
+static void store_unary(float* out, vf y, vu special, vf x, float (*fn)(float)) {
+  vf_store(out, y);
+  if (__predict_false(vu_any(special))) {
+    float in[4];
+    uint32_t mask[4];
+    vf_store(in, x);
+    vu_store(mask, special);
+    for (int l = 0; l < 4; ++l) {
+      if (mask[l] != 0) {
+        out[l] = fn(in[l]);
+      }
+    }
+  }
+}
+
+static void store_binary(float* out, vf r, vu special, vf x, vf y, float (*fn)(float, float)) {
+  vf_store(out, r);
+  if (__predict_false(vu_any(special))) {
+    float in_x[4], in_y[4];
+    uint32_t mask[4];
+    vf_store(in_x, x);
+    vf_store(in_y, y);
+    vu_store(mask, special);
+    for (int l = 0; l < 4; ++l) {
+      if (mask[l] != 0) {
+        out[l] = fn(in_x[l], in_y[l]);
+      }
+    }
+  }
+}
+
+/* The last n % 4 elements go through a padded copy, so that nothing is read
+ * or written past the end of the arrays. */
+#define VMATH_UNARY(name, lanes, fn) \
+  static inline void name##_block(const float* x, float* out) { \
+    vf xv = vf_load(x); \
+    vu special; \
+    vf r = lanes(xv, &special); \
+    store_unary(out, r, special, xv, fn); \
+  } \
+  void name(const float* x, float* out, size_t n) { \
+    size_t i; \
+    for (i = 0; i + 4 <= n; i += 4) { \
+      name##_block(x + i, out + i); \
+    } \
+    if (i < n) { \
+      float tail[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; \
+      memcpy(tail, x + i, (n - i) * sizeof(float)); \
+      name##_block(tail, tail); \
+      memcpy(out + i, tail, (n - i) * sizeof(float)); \
+    } \
+  }
+
+#define VMATH_BINARY(name, lanes, fn) \
+  static inline void name##_block(const float* x, const float* y, float* out) { \
+    vf xv = vf_load(x); \
+    vf yv = vf_load(y); \
+    vu special; \
+    vf r = lanes(xv, yv, &special); \
+    store_binary(out, r, special, xv, yv, fn); \
+  } \
+  void name(const float* x, const float* y, float* out, size_t n) { \
+    size_t i; \
+    for (i = 0; i + 4 <= n; i += 4) { \
+      name##_block(x + i, y + i, out + i); \
+    } \
+    if (i < n) { \
+      float tail_x[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; \
+      float tail_y[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; \
+      memcpy(tail_x, x + i, (n - i) * sizeof(float)); \
+      memcpy(tail_y, y + i, (n - i) * sizeof(float)); \
+      name##_block(tail_x, tail_y, tail_x); \
+      memcpy(out + i, tail_x, (n - i) * sizeof(float)); \
+    } \
+  }
+
+#else
+
+#define VMATH_UNARY(name, lanes, fn) \
+  void name(const float* x, float* out, size_t n) { \
+    for (size_t i = 0; i < n; ++i) { \
+      out[i] = fn(x[i]); \
+    } \
+  }
+
+#define VMATH_BINARY(name, lanes, fn) \
+  void name(const float* x, const float* y, float* out, size_t n) { \
+    for (size_t i = 0; i < n; ++i) { \
+      out[i] = fn(x[i], y[i]); \
+    } \
+  }
+
+#endif
+
+VMATH_UNARY(vexpf, expf_lanes, expf)
+VMATH_UNARY(vlogf, logf_lanes, logf)
+VMATH_UNARY(vsinf, sinf_lanes, sinf)
+VMATH_UNARY(vcosf, cosf_lanes, cosf)
+VMATH_BINARY(vpowf, powf_lanes, powf)
+
+/*
+ * The 16-bit conversions, eight elements at a time, with the rest done one
+ * by one with the same results. scale*x[i] is clamped to [-32768, 32767]
+ * before it is rounded, by adding and subtracting kShifter on the vector
+ * side, so that the narrowing never saturates and nothing overflows.
+ */
+static inline int16_t ftoi16(float v) {
+  if (isnan(v)) {
+    return 0;
+  }
+  return (int16_t) lrintf(fminf(fmaxf(v, -32768.0f), 32767.0f));
+}
+
+#if defined(VMATH_HAVE_SIMD)
+static inline vu ftoi16_lanes(vf v) {
+  v = vf_select(vf_eq(v, v), v, vf_dup(0.0f));
+  v = vf_min(vf_max(v, vf_dup(-32768.0f)), vf_dup(32767.0f));
+  return vf_to_vs(vf_sub(vf_add(v, vf_dup(kShifter)), vf_dup(kShifter)));
+}
+#endif
+
+void vftoi16(const float* x, float scale, int16_t* out, size_t n) {
+  size_t i = 0;
+#if defined(VMATH_HAVE_SIMD)
+  vf s = vf_dup(scale);
+  for (; i + 8 <= n; i += 8) {
+    vs_store_i16(out + i, ftoi16_lanes(vf_mul(vf_load(x + i), s)),
+                 ftoi16_lanes(vf_mul(vf_load(x + i + 4), s)));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = ftoi16(x[i] * scale);
+  }
+}
+
+void vi16tof(const int16_t* x, float scale, float* out, size_t n) {
+  size_t i = 0;
+#if defined(VMATH_HAVE_SIMD)
+  vf s = vf_dup(scale);
+  for (; i + 8 <= n; i += 8) {
+    vu a, b;
+    vs_load_i16(x + i, &a, &b);
+    vf_store(out + i, vf_mul(vs_to_vf(a), s));
+    vf_store(out + i + 4, vf_mul(vs_to_vf(b), s));
+  }
+#endif
+  for (; i < n; ++i) {
+    out[i] = x[i] * scale;
+  }
+}
@@ -0,0 +1,157 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _VMATH_SIMD_H_
+#define _VMATH_SIMD_H_
+
+#include <stdint.h>
+
+/*
+ * The four-lane operations that vmath.c is written in, on SSE2 for x86 and
+ * NEON for ARM. Other targets leave VMATH_HAVE_SIMD undefined, and vmath.c
+ * falls back to loops over the scalar functions there.
+ *
+ * A vf holds four floats and a vu four 32-bit integers or masks. Comparisons
+ * set a lane to all ones where they hold and to zero elsewhere.
+ */
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define VMATH_HAVE_SIMD 1
+
+typedef __m128 vf;
+typedef __m128i vu;
+
+static inline vf vf_dup(float f) { return _mm_set1_ps(f); }
+static inline vf vf_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void vf_store(float* p, vf a) { _mm_storeu_ps(p, a); }
+static inline vf vf_add(vf a, vf b) { return _mm_add_ps(a, b); }
+static inline vf vf_sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+static inline vf vf_mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+static inline vf vf_min(vf a, vf b) { return _mm_min_ps(a, b); }
+static inline vf vf_max(vf a, vf b) { return _mm_max_ps(a, b); }
+static inline vu vf_lt(vf a, vf b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+static inline vu vf_eq(vf a, vf b) { return _mm_castps_si128(_mm_cmpeq_ps(a, b)); }
+static inline vf vf_select(vu mask, vf a, vf b) {
+  __m128 m = _mm_castsi128_ps(mask);
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline vu vf_bits(vf a) { return _mm_castps_si128(a); }
+static inline vf vu_as_vf(vu a) { return _mm_castsi128_ps(a); }
+static inline vf vs_to_vf(vu a) { return _mm_cvtepi32_ps(a); }
+/* Only for lanes that already hold integers: SSE2 rounds the others, NEON truncates. */
+static inline vu vf_to_vs(vf a) { return _mm_cvtps_epi32(a); }
+
+static inline vu vu_dup(uint32_t u) { return _mm_set1_epi32((int32_t) u); }
+static inline void vu_store(uint32_t* p, vu a) { _mm_storeu_si128((__m128i*) p, a); }
+static inline vu vu_add(vu a, vu b) { return _mm_add_epi32(a, b); }
+static inline vu vu_sub(vu a, vu b) { return _mm_sub_epi32(a, b); }
+static inline vu vu_and(vu a, vu b) { return _mm_and_si128(a, b); }
+static inline vu vu_or(vu a, vu b) { return _mm_or_si128(a, b); }
+static inline vu vu_xor(vu a, vu b) { return _mm_xor_si128(a, b); }
+static inline vu vu_not(vu a) { return _mm_xor_si128(a, _mm_set1_epi32(-1)); }
+/* SSE2 only compares signed integers: flipping the top bits makes that unsigned. */
+static inline vu vu_gt(vu a, vu b) {
+  __m128i top = _mm_set1_epi32((int32_t) 0x80000000);
+  return _mm_cmpgt_epi32(_mm_xor_si128(a, top), _mm_xor_si128(b, top));
+}
+static inline int vu_any(vu mask) { return _mm_movemask_epi8(mask) != 0; }
+
+/* Eight 16-bit integers, sign-extended into two vectors or narrowed from
+ * two with saturation. */
+static inline void vs_load_i16(const int16_t* p, vu* a, vu* b) {
+  __m128i v = _mm_loadu_si128((const __m128i*) p);
+  *a = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+  *b = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+static inline void vs_store_i16(int16_t* p, vu a, vu b) {
+  _mm_storeu_si128((__m128i*) p, _mm_packs_epi32(a, b));
+}
+
+/* Shifts take a constant count (NEON needs one), so they are macros. */
+#define vu_shl(a, n) _mm_slli_epi32(a, n)
+#define vu_shr(a, n) _mm_srli_epi32(a, n)
+#define vu_sra(a, n) _mm_srai_epi32(a, n)
+
+#elif defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+#define VMATH_HAVE_SIMD 1
+
+typedef float32x4_t vf;
+typedef uint32x4_t vu;
+
+static inline vf vf_dup(float f) { return vdupq_n_f32(f); }
+static inline vf vf_load(const float* p) { return vld1q_f32(p); }
+static inline void vf_store(float* p, vf a) { vst1q_f32(p, a); }
+static inline vf vf_add(vf a, vf b) { return vaddq_f32(a, b); }
+static inline vf vf_sub(vf a, vf b) { return vsubq_f32(a, b); }
+static inline vf vf_mul(vf a, vf b) { return vmulq_f32(a, b); }
+static inline vf vf_min(vf a, vf b) { return vminq_f32(a, b); }
+static inline vf vf_max(vf a, vf b) { return vmaxq_f32(a, b); }
+static inline vu vf_lt(vf a, vf b) { return vcltq_f32(a, b); }
+static inline vu vf_eq(vf a, vf b) { return vceqq_f32(a, b); }
+static inline vf vf_select(vu mask, vf a, vf b) { return vbslq_f32(mask, a, b); }
+static inline vu vf_bits(vf a) { return vreinterpretq_u32_f32(a); }
+static inline vf vu_as_vf(vu a) { return vreinterpretq_f32_u32(a); }
+static inline vf vs_to_vf(vu a) { return vcvtq_f32_s32(vreinterpretq_s32_u32(a)); }
+static inline vu vf_to_vs(vf a) { return vreinterpretq_u32_s32(vcvtq_s32_f32(a)); }
+
+static inline vu vu_dup(uint32_t u) { return vdupq_n_u32(u); }
+static inline void vu_store(uint32_t* p, vu a) { vst1q_u32(p, a); }
+static inline vu vu_add(vu a, vu b) { return vaddq_u32(a, b); }
+static inline vu vu_sub(vu a, vu b) { return vsubq_u32(a, b); }
+static inline vu vu_and(vu a, vu b) { return vandq_u32(a, b); }
+static inline vu vu_or(vu a, vu b) { return vorrq_u32(a, b); }
+static inline vu vu_xor(vu a, vu b) { return veorq_u32(a, b); }
+static inline vu vu_not(vu a) { return vmvnq_u32(a); }
+static inline vu vu_gt(vu a, vu b) { return vcgtq_u32(a, b); }
+static inline int vu_any(vu mask) {
+  uint32x2_t m = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+  return (vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) != 0;
+}
+
+static inline void vs_load_i16(const int16_t* p, vu* a, vu* b) {
+  int16x8_t v = vld1q_s16(p);
+  *a = vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(v)));
+  *b = vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(v)));
+}
+static inline void vs_store_i16(int16_t* p, vu a, vu b) {
+  vst1q_s16(p, vcombine_s16(vqmovn_s32(vreinterpretq_s32_u32(a)),
+                            vqmovn_s32(vreinterpretq_s32_u32(b))));
+}
+
+#define vu_shl(a, n) vshlq_n_u32(a, n)
+#define vu_shr(a, n) vshrq_n_u32(a, n)
+#define vu_sra(a, n) vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(a), n))
+
+#endif
+
+#endif /* _VMATH_SIMD_H_ */
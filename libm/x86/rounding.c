@@ -0,0 +1,304 @@
+/*-
+ * Copyright (c) 2013 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * floor(), ceil(), trunc(), rint(), nearbyint(), lrint() and llrint() and
+ * their float versions, in SSE registers instead of the x87 stack. With
+ * SSE4.1 each one is a single roundsd or roundss; without it, rint() adds
+ * and subtracts 2^52 (or 2^23 for floats) and the others are built on it.
+ */
+
+#include <cpuid.h>
+#include <float.h>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+#include "math.h"
+#include "math_private.h"
+
+#if !defined(__SSE2_MATH__)
+#error "these need double arithmetic in SSE registers (-msse2 -mfpmath=sse)"
+#endif
+
+/* The roundsd and roundss immediates. */
+#define	ROUND_FLOOR	0x1		/* toward -inf */
+#define	ROUND_CEIL	0x2		/* toward +inf */
+#define	ROUND_TRUNC	0x3		/* toward zero */
+#define	ROUND_RINT	0x4		/* MXCSR mode */
+#define	ROUND_NEARBYINT	0xc		/* MXCSR mode, no inexact */
+
+#define	ROUNDSD(mode, x) ({						\
+	double __r;							\
+	__asm__("roundsd %2, %1, %0" : "=x" (__r) : "xm" (x), "i" (mode)); \
+	__r;								\
+})
+
+#define	ROUNDSS(mode, x) ({						\
+	float __r;							\
+	__asm__("roundss %2, %1, %0" : "=x" (__r) : "xm" (x), "i" (mode)); \
+	__r;								\
+})
+
+/*
+ * Set from cpuid before main() runs. Anything called earlier, from another
+ * constructor, gets the SSE2 versions, which give the same results.
+ */
+static int has_sse4_1;
+
+static void __attribute__((constructor))
+init_has_sse4_1(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		has_sse4_1 = (ecx & bit_SSE4_1) != 0;
+}
+
+static const double two52 = 0x1p52;
+static const float two23 = 0x1p23f;
+
+/*
+ * Rounds x to an integer in the current rounding mode, raising inexact
+ * if that changes it. Only |x| < 2^52 has a fraction, and for those adding
+ * and subtracting 2^52 leaves no bits below the binary point. The result
+ * keeps the sign of x, so that, say, -0.25 goes to -0.
+ */
+static inline double
+rint_sse2(double x)
+{
+	double t;
+
+	if (!(fabs(x) < two52))
+		return x + 0.0;		/* integer, inf or NaN (quieted) */
+	if (x >= 0)
+		t = (x + two52) - two52;
+	else
+		t = (x - two52) + two52;
+	return copysign(t, x);
+}
+
+static inline float
+rintf_sse2(float x)
+{
+	float t;
+
+	if (!(fabsf(x) < two23))
+		return x + 0.0f;
+	if (x >= 0)
+		t = (x + two23) - two23;
+	else
+		t = (x - two23) + two23;
+	return copysignf(t, x);
+}
+
+/*
+ * The rest round in the current mode first, then step by one toward the
+ * right side. Like msun's versions, and roundsd without its suppression
+ * bit, they raise inexact when the result differs from x.
+ */
+static inline double
+floor_sse2(double x)
+{
+	double t;
+
+	t = rint_sse2(x);
+	if (t > x)
+		t -= 1;
+	return copysign(t, x);
+}
+
+static inline double
+ceil_sse2(double x)
+{
+	double t;
+
+	t = rint_sse2(x);
+	if (t < x)
+		t += 1;
+	return copysign(t, x);
+}
+
+static inline float
+floorf_sse2(float x)
+{
+	float t;
+
+	t = rintf_sse2(x);
+	if (t > x)
+		t -= 1;
+	return copysignf(t, x);
+}
+
+static inline float
+ceilf_sse2(float x)
+{
+	float t;
+
+	t = rintf_sse2(x);
+	if (t < x)
+		t += 1;
+	return copysignf(t, x);
+}
+
+double
+floor(double x)
+{
+	if (has_sse4_1)
+		return ROUNDSD(ROUND_FLOOR, x);
+	return floor_sse2(x);
+}
+
+float
+floorf(float x)
+{
+	if (has_sse4_1)
+		return ROUNDSS(ROUND_FLOOR, x);
+	return floorf_sse2(x);
+}
+
+double
+ceil(double x)
+{
+	if (has_sse4_1)
+		return ROUNDSD(ROUND_CEIL, x);
+	return ceil_sse2(x);
+}
+
+float
+ceilf(float x)
+{
+	if (has_sse4_1)
+		return ROUNDSS(ROUND_CEIL, x);
+	return ceilf_sse2(x);
+}
+
+double
+trunc(double x)
+{
+	if (has_sse4_1)
+		return ROUNDSD(ROUND_TRUNC, x);
+	return (x < 0) ? ceil_sse2(x) : floor_sse2(x);
+}
+
+float
+truncf(float x)
+{
+	if (has_sse4_1)
+		return ROUNDSS(ROUND_TRUNC, x);
+	return (x < 0) ? ceilf_sse2(x) : floorf_sse2(x);
+}
+
+double
+rint(double x)
+{
+	if (has_sse4_1)
+		return ROUNDSD(ROUND_RINT, x);
+	return rint_sse2(x);
+}
+
+float
+rintf(float x)
+{
+	if (has_sse4_1)
+		return ROUNDSS(ROUND_RINT, x);
+	return rintf_sse2(x);
+}
+
+/*
+ * Without SSE4.1, the MXCSR is put back afterwards, which takes the inexact
+ * flag back to what it was: far cheaper than the fegetenv() and fesetenv()
+ * of the generic version, which save the x87 state too.
+ */
+double
+nearbyint(double x)
+{
+	unsigned int csr;
+	double r;
+
+	if (has_sse4_1)
+		return ROUNDSD(ROUND_NEARBYINT, x);
+	csr = _mm_getcsr();
+	r = rint_sse2(x);
+	_mm_setcsr(csr);
+	return r;
+}
+
+float
+nearbyintf(float x)
+{
+	unsigned int csr;
+	float r;
+
+	if (has_sse4_1)
+		return ROUNDSS(ROUND_NEARBYINT, x);
+	csr = _mm_getcsr();
+	r = rintf_sse2(x);
+	_mm_setcsr(csr);
+	return r;
+}
+
+long double
+nearbyintl(long double x)
+{
+	return nearbyint(x);
+}
+
+/*
+ * cvtsd2si and cvtss2si round in the MXCSR mode, and give LONG_MIN with
+ * invalid raised when the result doesn't fit, as C99 allows.
+ */
+long
+lrint(double x)
+{
+	return _mm_cvtsd_si32(_mm_set_sd(x));
+}
+
+long
+lrintf(float x)
+{
+	return _mm_cvtss_si32(_mm_set_ss(x));
+}
+
+/*
+ * There's no 64-bit conversion on i386, so only the cases whose results
+ * are sure to fit in 32 bits, in any rounding mode, are fast.
+ */
+long long
+llrint(double x)
+{
+	if (fabs(x) < 0x1p31 - 1)
+		return _mm_cvtsd_si32(_mm_set_sd(x));
+	return rint(x);
+}
+
+long long
+llrintf(float x)
+{
+	if (fabsf(x) < 0x1p30f)
+		return _mm_cvtss_si32(_mm_set_ss(x));
+	return rintf(x);
+}
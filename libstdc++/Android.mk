@@ -10,6 +10,9 @@ else
     libstdc++_cflags += -DANDROID_SMP=0
 endif
 
+# <new> only declares std::align_val_t for C++11 and later.
+libstdc++_cppflags := -std=gnu++0x
+
 include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES:= \
@@ -22,6 +25,7 @@ LOCAL_MODULE:= libstdc++
 LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
 
 LOCAL_CFLAGS := $(libstdc++_cflags)
+LOCAL_CPPFLAGS := $(libstdc++_cppflags)
 
 LOCAL_SYSTEM_SHARED_LIBRARIES := libc
 
@@ -36,6 +40,7 @@ LOCAL_SRC_FILES:= \
 	src/typeinfo.cpp
 
 LOCAL_CFLAGS := $(libstdc++_cflags)
+LOCAL_CPPFLAGS := $(libstdc++_cppflags)
 
 LOCAL_MODULE:= libstdc++
 LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
@@ -1,4 +1,5 @@
 #include "new"
+#include <malloc.h>
 #include <stdlib.h>
 
 const std::nothrow_t std::nothrow = {};
@@ -51,7 +52,75 @@ void  operator delete[](void* ptr, const std::nothrow_t&)
     free(ptr);
 }
 
+// A program that replaces the unsized delete is entitled to have sized
+// deletes end up there too, so these forward rather than going to
+// free_sized() themselves.
+void  operator delete(void* ptr, std::size_t)
+{
+    ::operator delete(ptr);
+}
+
+void  operator delete[](void* ptr, std::size_t)
+{
+    ::operator delete[](ptr);
+}
 
+// Over-aligned allocations come from memalign, and are never small
+// objects, so there's nothing for a size to save when freeing them.
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* p = memalign(static_cast<std::size_t>(alignment), size);
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
 
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    void* p = memalign(static_cast<std::size_t>(alignment), size);
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
 
+void  operator delete(void* ptr, std::align_val_t)
+{
+    free(ptr);
+}
 
+void  operator delete[](void* ptr, std::align_val_t)
+{
+    free(ptr);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&)
+{
+    return memalign(static_cast<std::size_t>(alignment), size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&)
+{
+    return memalign(static_cast<std::size_t>(alignment), size);
+}
+
+void  operator delete(void* ptr, std::align_val_t, const std::nothrow_t&)
+{
+    free(ptr);
+}
+
+void  operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&)
+{
+    free(ptr);
+}
+
+void  operator delete(void* ptr, std::size_t, std::align_val_t alignment)
+{
+    ::operator delete(ptr, alignment);
+}
+
+void  operator delete[](void* ptr, std::size_t, std::align_val_t alignment)
+{
+    ::operator delete[](ptr, alignment);
+}
@@ -72,6 +72,16 @@ extern "C" int __cxa_guard_acquire(_guard_t* gv)
     // waiting: untouched, wait and return 0
     // ready: untouched, return 0
 
+    // The compiler's inline check of the guard is only a plain load, so
+    // every use of an already-constructed static comes through here. Don't
+    // make those pay for an atomic read-modify-write (or, since futex_wait
+    // on a ready guard returns straight away, a syscall): a load followed
+    // by an acquire barrier is enough to see the constructor's stores.
+    if (gv->state == ready) {
+        ANDROID_MEMBAR_ACQ_REL();
+        return 0;
+    }
+
 retry:
     if (__bionic_cmpxchg(0, pending, &gv->state) == 0) {
         ANDROID_MEMBAR_FULL();
@@ -103,7 +113,11 @@ extern "C" void __cxa_guard_release(_guard_t* gv)
 
 extern "C" void __cxa_guard_abort(_guard_t* gv)
 {
+    // pending -> 0
+    // waiting -> 0, and wake
+
     ANDROID_MEMBAR_FULL();
-    gv->state= 0;
-    __futex_wake(&gv->state, 0x7fffffff);
+    if (__bionic_swap(0, &gv->state) == waiting) {
+        __futex_wake(&gv->state, 0x7fffffff);
+    }
 }
@@ -9,6 +9,9 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES:= \
 	libthread_db.c
 
+# For libc's thread table layout.
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../libc/private
+
 LOCAL_MODULE:= libthread_db
 LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
 
@@ -4,12 +4,16 @@
 
 #include <dirent.h>
 #include <sys/ptrace.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <thread_db.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "bionic_thread_table.h"
+
 extern int ps_pglobal_lookup (void *, const char *obj, const char *name, void **sym_addr);
+extern int ps_pdread(struct ps_prochandle *ph, psaddr_t addr, void *buf, size_t size);
 extern pid_t ps_getpid(struct ps_prochandle *ph);
 
 /*
@@ -24,6 +28,7 @@ enum {
 
 static char const * gSymbols[] = {
     [SYM_TD_CREATE] = "_thread_created_hook",
+    [SYM_THREAD_LIST] = "__bionic_thread_table",
     NULL
 };
 
@@ -212,6 +217,63 @@ td_ta_clear_event(const td_thragent_t * ta_arg, td_thr_events_t * event)
 }
 
 
+/*
+ * Copies libc's table of running threads (see bionic_thread_table.h) out of
+ * the target in a couple of reads, retrying if it changes under us. Returns
+ * a malloc'd array the caller frees, or NULL if there's no usable table, as
+ * with an older libc, or a thread stopped in the middle of changing it.
+ */
+#define MAX_THREAD_TABLE_READS 8
+
+static struct bionic_thread_record *
+_read_thread_table(td_thragent_t const * agent, uint32_t * count_out)
+{
+    void * addr;
+    struct bionic_thread_table table;
+    struct bionic_thread_record * records = NULL;
+    struct bionic_thread_record * grown;
+    uint32_t sequence;
+    int i;
+
+    if (ps_pglobal_lookup(NULL, NULL, gSymbols[SYM_THREAD_LIST], &addr) != 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < MAX_THREAD_TABLE_READS; ++i) {
+        if (ps_pdread(agent->ph, addr, &table, sizeof(table)) != 0 ||
+                table.version != BIONIC_THREAD_TABLE_VERSION) {
+            break;
+        }
+        if ((table.sequence & 1) != 0 || table.used > table.capacity) {
+            continue;
+        }
+
+        grown = realloc(records, (table.used + 1) * sizeof(*records));
+        if (grown == NULL) {
+            break;
+        }
+        records = grown;
+        if (table.used > 0 &&
+                ps_pdread(agent->ph, (psaddr_t) table.records, records,
+                          table.used * sizeof(*records)) != 0) {
+            /* The records moved since we read where they were. */
+            continue;
+        }
+
+        if (ps_pdread(agent->ph, (char *) addr + offsetof(struct bionic_thread_table, sequence),
+                      &sequence, sizeof(sequence)) != 0) {
+            break;
+        }
+        if (sequence == table.sequence) {
+            *count_out = table.used;
+            return records;
+        }
+    }
+
+    free(records);
+    return NULL;
+}
+
 td_err_e
 td_ta_thr_iter(td_thragent_t const * agent, td_thr_iter_f * func, void * cookie,
                td_thr_state_e state, int32_t prio, sigset_t * sigmask, uint32_t user_flags)
@@ -221,6 +283,27 @@ td_ta_thr_iter(td_thragent_t const * agent, td_thr_iter_f * func, void * cookie,
     DIR * dir;
     struct dirent * entry;
     td_thrhandle_t handle;
+    struct bionic_thread_record * records;
+    uint32_t count;
+    uint32_t i;
+
+    handle.pid = agent->pid;
+
+    records = _read_thread_table(agent, &count);
+    if (records != NULL) {
+        for (i = 0; i < count; ++i) {
+            if (records[i].tid == 0) {
+                continue;
+            }
+            handle.tid = records[i].tid;
+            if (func(&handle, cookie) != 0) {
+                err = TD_DBERR;
+                break;
+            }
+        }
+        free(records);
+        return err;
+    }
 
     snprintf(path, sizeof(path), "/proc/%d/task/", agent->pid);
     dir = opendir(path);
@@ -228,7 +311,6 @@ td_ta_thr_iter(td_thragent_t const * agent, td_thr_iter_f * func, void * cookie,
         return TD_NOEVENT;
     }
 
-    handle.pid = agent->pid;
     while ((entry = readdir(dir)) != NULL) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
             continue;
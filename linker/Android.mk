@@ -16,6 +16,11 @@ LOCAL_SRC_FILES:= \
     linker_phdr.cpp \
     rt.cpp
 
+# MIPS uses its own GOT-based resolver protocol, which we don't implement.
+ifneq ($(TARGET_ARCH),mips)
+    LOCAL_SRC_FILES += arch/$(TARGET_ARCH)/lazy_bind.S
+endif
+
 LOCAL_LDFLAGS := -shared -Wl,--exclude-libs,ALL
 
 LOCAL_CFLAGS += -fno-stack-protector \
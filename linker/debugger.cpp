@@ -35,9 +35,15 @@
 #include <sys/mman.h>
 #include <sys/prctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <asm/sigcontext.h>
+#include <asm/ucontext.h>
+
+#include <private/bionic_name_mem.h>
+
 extern "C" int tgkill(int tgid, int tid, int sig);
 
 #define DEBUGGER_SOCKET_NAME "android:debuggerd"
@@ -59,8 +65,49 @@ struct debugger_msg_t {
 
   // version 2 added:
   uintptr_t abort_msg_address;
+
+  // version 3 added:
+  uintptr_t crash_record_address;
 };
 
+/*
+ * What the crashing thread can say about itself before debuggerd attaches,
+ * so debuggerd can write a tombstone from the one read of this record
+ * instead of walking the process with ptrace, which can take long enough
+ * for a watchdog to kill a big process mid-dump. It lives in a mapping made
+ * at startup, since the handler can't allocate. Everything is copied with
+ * process_vm_readv on ourselves, which fails instead of faulting on a bad
+ * stack pointer or abort message.
+ */
+#define CRASH_RECORD_MAGIC        0x68737263  // "crsh"
+#define CRASH_RECORD_VERSION      1
+#define CRASH_RECORD_MAX_FRAMES   32
+#define CRASH_RECORD_ABORT_BYTES  256
+#define CRASH_RECORD_STACK_BYTES  (16 * 1024)
+
+struct crash_record_t {
+  uint32_t magic;
+  uint32_t version;
+  pid_t tid;
+  int signal;
+  siginfo_t info;              // All zeroes if the handler got none.
+  struct sigcontext registers;
+  // The pc first, then return addresses from the link register or the
+  // frame pointer chain, as far as the copy of the stack goes.
+  uint32_t frame_count;
+  uintptr_t frames[CRASH_RECORD_MAX_FRAMES];
+  char abort_message[CRASH_RECORD_ABORT_BYTES];  // Empty if there was none.
+  uintptr_t stack_address;     // The stack pointer at the fault...
+  uint32_t stack_size;         // ...and how much from there was copied.
+  uint8_t stack[CRASH_RECORD_STACK_BYTES];
+};
+
+static crash_record_t* gCrashRecord = NULL;
+
+// The tid of the thread filling in the record, so a second crash at the same time
+// doesn't scribble over the first.
+static volatile pid_t gCrashRecordOwner = 0;
+
 // see man(2) prctl, specifically the section about PR_GET_NAME
 #define MAX_TASK_NAME_LEN (16)
 
@@ -172,11 +219,93 @@ static bool have_siginfo(int signum) {
     return result;
 }
 
+// Copies what it can of 'size' bytes at 'src' in this process without risking a fault.
+static size_t safe_copy(void* dst, uintptr_t src, size_t size) {
+    iovec local = { dst, size };
+    iovec remote = { reinterpret_cast<void*>(src), size };
+    ssize_t n = process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+    return (n > 0) ? n : 0;
+}
+
+static void crash_record_unwind(crash_record_t* record) {
+#if defined(__arm__)
+    uintptr_t pc = record->registers.arm_pc;
+    uintptr_t lr = record->registers.arm_lr;
+    record->stack_address = record->registers.arm_sp;
+#elif defined(__i386__)
+    uintptr_t pc = record->registers.eip;
+    record->stack_address = record->registers.esp;
+#elif defined(__mips__)
+    uintptr_t pc = record->registers.sc_pc;
+    uintptr_t lr = record->registers.sc_regs[31];
+    record->stack_address = record->registers.sc_regs[29];
+#endif
+    record->stack_size = safe_copy(record->stack, record->stack_address, sizeof(record->stack));
+
+    record->frames[record->frame_count++] = pc;
+#if defined(__i386__)
+    // Follow the saved %ebp chain, but only through the copy of the stack.
+    uintptr_t fp = record->registers.ebp;
+    uintptr_t stack_end = record->stack_address + record->stack_size;
+    while (record->frame_count < CRASH_RECORD_MAX_FRAMES &&
+           fp >= record->stack_address && fp + 2 * sizeof(uintptr_t) <= stack_end &&
+           (fp & (sizeof(uintptr_t) - 1)) == 0) {
+        const uintptr_t* frame =
+            reinterpret_cast<const uintptr_t*>(record->stack + (fp - record->stack_address));
+        if (frame[1] == 0) {
+            break;
+        }
+        record->frames[record->frame_count++] = frame[1];
+        if (frame[0] <= fp) {
+            break;
+        }
+        fp = frame[0];
+    }
+#else
+    // Without frame pointers, the rest needs the unwind tables, which is
+    // debuggerd's job; the copy of the stack means it needn't ptrace for it.
+    if (lr != 0) {
+        record->frames[record->frame_count++] = lr;
+    }
+#endif
+}
+
+// Fills in the crash record for this thread, and returns its address to pass on,
+// or 0 if there's no record or another thread has it.
+static uintptr_t crash_record_capture(int signum, siginfo_t* info, void* context, pid_t tid) {
+    crash_record_t* record = gCrashRecord;
+    if (record == NULL || !__sync_bool_compare_and_swap(&gCrashRecordOwner, 0, tid)) {
+        return 0;
+    }
+
+    memset(record, 0, offsetof(crash_record_t, stack));
+    record->magic = CRASH_RECORD_MAGIC;
+    record->version = CRASH_RECORD_VERSION;
+    record->tid = tid;
+    record->signal = signum;
+    if (info != NULL) {
+        record->info = *info;
+    }
+    if (context != NULL) {
+        record->registers = reinterpret_cast<ucontext*>(context)->uc_mcontext;
+        crash_record_unwind(record);
+    }
+
+    abort_msg_t* abort_message = gAbortMessage;
+    if (abort_message != NULL) {
+        size_t size = safe_copy(record->abort_message,
+                                reinterpret_cast<uintptr_t>(abort_message->msg),
+                                sizeof(record->abort_message) - 1);
+        record->abort_message[size] = '\0';
+    }
+    return reinterpret_cast<uintptr_t>(record);
+}
+
 /*
  * Catches fatal signals so we can ask debuggerd to ptrace us before
  * we crash.
  */
-void debuggerd_signal_handler(int n, siginfo_t* info, void*) {
+void debuggerd_signal_handler(int n, siginfo_t* info, void* context) {
     /*
      * It's possible somebody cleared the SA_SIGINFO flag, which would mean
      * our "info" arg holds an undefined value.
@@ -188,6 +317,7 @@ void debuggerd_signal_handler(int n, siginfo_t* info, void*) {
     log_signal_summary(n, info);
 
     pid_t tid = gettid();
+    uintptr_t crash_record_address = crash_record_capture(n, info, context, tid);
     int s = socket_abstract_client(DEBUGGER_SOCKET_NAME, SOCK_STREAM);
 
     if (s >= 0) {
@@ -199,6 +329,7 @@ void debuggerd_signal_handler(int n, siginfo_t* info, void*) {
         msg.action = DEBUGGER_ACTION_CRASH;
         msg.tid = tid;
         msg.abort_msg_address = reinterpret_cast<uintptr_t>(gAbortMessage);
+        msg.crash_record_address = crash_record_address;
         int ret = TEMP_FAILURE_RETRY(write(s, &msg, sizeof(msg)));
         if (ret == sizeof(msg)) {
             // if the write failed, there is no point trying to read a response.
@@ -246,6 +377,14 @@ void debuggerd_signal_handler(int n, siginfo_t* info, void*) {
 }
 
 void debuggerd_init() {
+    // Made now because the handler can't. Losing it only costs debuggerd time.
+    void* map = mmap(NULL, sizeof(crash_record_t), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map != MAP_FAILED) {
+        __bionic_name_mem(map, sizeof(crash_record_t), "linker_alloc");
+        gCrashRecord = reinterpret_cast<crash_record_t*>(map);
+    }
+
     struct sigaction action;
     memset(&action, 0, sizeof(action));
     sigemptyset(&action.sa_mask);
@@ -17,12 +17,16 @@
 #include "linker.h"
 
 #include <dlfcn.h>
+#include <errno.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <bionic/pthread_internal.h>
+#include <private/bionic_counters.h>
 #include <private/bionic_tls.h>
+#include <private/bionic_trace.h>
 #include <private/ScopedPthreadMutexLocker.h>
 #include <private/ThreadLocalBuffer.h>
 
@@ -60,16 +64,46 @@ void android_update_LD_LIBRARY_PATH(const char* ld_library_path) {
   do_android_update_LD_LIBRARY_PATH(ld_library_path);
 }
 
-void* dlopen(const char* filename, int flags) {
-  ScopedPthreadMutexLocker locker(&gDlMutex);
-  soinfo* result = do_dlopen(filename, flags);
+// Our copy of libc can't tell whether tracing is on, but the buffers libc
+// gives threads while it is are in the threads themselves.
+static void trace_dl_event(uint32_t type, void* handle) {
+  pthread_internal_t* thread = __get_thread();
+  if (__predict_false(thread->trace_buffer != NULL)) {
+    __bionic_trace_append(thread->trace_buffer, thread->tid, type, reinterpret_cast<uintptr_t>(handle));
+  }
+}
+
+static uint64_t monotonic_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static void* dlopen_ext(const char* filename, int flags, const android_dlextinfo* extinfo) {
+  uint64_t start = monotonic_ns();
+  soinfo* result = do_dlopen_loaded(filename, flags, extinfo);
   if (result == NULL) {
-    __bionic_format_dlerror("dlopen failed", linker_get_error_buffer());
-    return NULL;
+    ScopedPthreadMutexLocker locker(&gDlMutex);
+    result = do_dlopen(filename, flags, extinfo);
+    if (result == NULL) {
+      __bionic_format_dlerror("dlopen failed", linker_get_error_buffer());
+    }
   }
+  trace_dl_event(ANDROID_TRACE_DLOPEN, result);
+  // The counters are in the thread, so these show up in libc's totals.
+  __libc_counter_add(ANDROID_LIBC_COUNTER_DLOPEN, 1);
+  __libc_counter_add(ANDROID_LIBC_COUNTER_DLOPEN_NS, monotonic_ns() - start);
   return result;
 }
 
+void* android_dlopen_ext(const char* filename, int flags, const android_dlextinfo* extinfo) {
+  return dlopen_ext(filename, flags, extinfo);
+}
+
+void* dlopen(const char* filename, int flags) {
+  return dlopen_ext(filename, flags, NULL);
+}
+
 void* dlsym(void* handle, const char* symbol) {
   ScopedPthreadMutexLocker locker(&gDlMutex);
 
@@ -116,7 +150,8 @@ void* dlsym(void* handle, const char* symbol) {
 }
 
 int dladdr(const void* addr, Dl_info* info) {
-  ScopedPthreadMutexLocker locker(&gDlMutex);
+  // Unwinders and profilers call this a lot, so it doesn't take gDlMutex.
+  ScopedLoadedObjectsReader reader;
 
   // Determine if this address can be found in any library currently mapped.
   soinfo* si = find_containing_library(addr);
@@ -140,22 +175,49 @@ int dladdr(const void* addr, Dl_info* info) {
   return 1;
 }
 
+size_t android_dl_get_stats(android_dl_library_stats* stats, size_t count, size_t* linker_bytes) {
+  ScopedPthreadMutexLocker locker(&gDlMutex);
+  return do_android_dl_get_stats(stats, count, linker_bytes);
+}
+
+void android_dl_dump_stats(int fd) {
+  ScopedPthreadMutexLocker locker(&gDlMutex);
+  do_android_dl_dump_stats(fd);
+}
+
 int dlclose(void* handle) {
+  trace_dl_event(ANDROID_TRACE_DLCLOSE, handle);
   ScopedPthreadMutexLocker locker(&gDlMutex);
   return do_dlclose(reinterpret_cast<soinfo*>(handle));
 }
 
+#if defined(ANDROID_ARM_LINKER) || defined(ANDROID_X86_LINKER)
+// Called from linker_lazy_bind_trampoline the first time a lazily-bound PLT
+// entry is used. The caller is in the middle of an ordinary function call,
+// so don't let symbol resolution leak into errno.
+extern "C" Elf32_Addr linker_lazy_bind(soinfo* si, Elf32_Word rel_offset) {
+  int saved_errno = errno;
+  Elf32_Addr result;
+  {
+    ScopedPthreadMutexLocker locker(&gDlMutex);
+    result = soinfo_lazy_bind(si, rel_offset);
+  }
+  errno = saved_errno;
+  return result;
+}
+#endif
+
 #if defined(ANDROID_ARM_LINKER)
-//   0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667
-//   0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890
+//   0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888 888899999999990000000 000111111111122222222 2233333333334444444444 55555555556666666666777777
+//   0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345 678901234567890123456 789012345678901234567 8901234567890123456789 01234567890123456789012345
 #define ANDROID_LIBDL_STRTAB \
-    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0dl_unwind_find_exidx\0"
+    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_dlopen_ext\0dl_unwind_find_exidx\0android_dl_get_stats\0android_dl_dump_stats\0android_dl_get_generation\0"
 
 #elif defined(ANDROID_X86_LINKER) || defined(ANDROID_MIPS_LINKER)
-//   0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667
-//   0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890
+//   0000000 00011111 111112 22222222 2333333 3333444444444455555555556666666 6667777777777888888 8888999999999900 000000001111111111222 2222222333333333344444 44444555555555566666666667
+//   0123456 78901234 567890 12345678 9012345 6789012345678901234567890123456 7890123456789012345 6789012345678901 234567890123456789012 3456789012345678901234 56789012345678901234567890
 #define ANDROID_LIBDL_STRTAB \
-    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0dl_iterate_phdr\0"
+    "dlopen\0dlclose\0dlsym\0dlerror\0dladdr\0android_update_LD_LIBRARY_PATH\0android_dlopen_ext\0dl_iterate_phdr\0android_dl_get_stats\0android_dl_dump_stats\0android_dl_get_generation\0"
 #else
 #error Unsupported architecture. Only ARM, MIPS, and x86 are presently supported.
 #endif
@@ -181,10 +243,17 @@ static Elf32_Sym gLibDlSymtab[] = {
   ELF32_SYM_INITIALIZER(21, &dlerror, 1),
   ELF32_SYM_INITIALIZER(29, &dladdr, 1),
   ELF32_SYM_INITIALIZER(36, &android_update_LD_LIBRARY_PATH, 1),
+  ELF32_SYM_INITIALIZER(67, &android_dlopen_ext, 1),
 #if defined(ANDROID_ARM_LINKER)
-  ELF32_SYM_INITIALIZER(67, &dl_unwind_find_exidx, 1),
+  ELF32_SYM_INITIALIZER(86, &dl_unwind_find_exidx, 1),
+  ELF32_SYM_INITIALIZER(107, &android_dl_get_stats, 1),
+  ELF32_SYM_INITIALIZER(128, &android_dl_dump_stats, 1),
+  ELF32_SYM_INITIALIZER(150, &android_dl_get_generation, 1),
 #elif defined(ANDROID_X86_LINKER) || defined(ANDROID_MIPS_LINKER)
-  ELF32_SYM_INITIALIZER(67, &dl_iterate_phdr, 1),
+  ELF32_SYM_INITIALIZER(86, &dl_iterate_phdr, 1),
+  ELF32_SYM_INITIALIZER(102, &android_dl_get_stats, 1),
+  ELF32_SYM_INITIALIZER(123, &android_dl_dump_stats, 1),
+  ELF32_SYM_INITIALIZER(145, &android_dl_get_generation, 1),
 #endif
 };
 
@@ -207,7 +276,7 @@ static Elf32_Sym gLibDlSymtab[] = {
 // Note that adding any new symbols here requires
 // stubbing them out in libdl.
 static unsigned gLibDlBuckets[1] = { 1 };
-static unsigned gLibDlChains[8] = { 0, 2, 3, 4, 5, 6, 7, 0 };
+static unsigned gLibDlChains[12] = { 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0 };
 
 // This is used by the dynamic linker. Every process gets these symbols for free.
 soinfo libdl_info = {
@@ -224,7 +293,7 @@ soinfo libdl_info = {
     symtab: gLibDlSymtab,
 
     nbucket: 1,
-    nchain: 8,
+    nchain: 12,
     bucket: gLibDlBuckets,
     chain: gLibDlChains,
 
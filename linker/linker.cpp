@@ -26,23 +26,29 @@
  * SUCH DAMAGE.
  */
 
+#include <dirent.h>
 #include <dlfcn.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/auxvec.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/atomics.h>
 #include <sys/mman.h>
+#include <sys/param.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 // Private C library headers.
+#include <bionic/pthread_internal.h>
+#include <private/bionic_name_mem.h>
 #include <private/bionic_tls.h>
 #include <private/KernelArgumentBlock.h>
 #include <private/ScopedPthreadMutexLocker.h>
+#include <private/StartupTrace.h>
 
 #include "linker.h"
 #include "linker_debug.h"
@@ -56,6 +62,12 @@
 #define LDPRELOAD_BUFSIZE 512
 #define LDPRELOAD_MAX 8
 
+#define LDLAZYNEEDED_BUFSIZE 512
+#define LDLAZYNEEDED_MAX 16
+
+#define LDMANIFEST_BUFSIZE 8192
+#define LDMANIFEST_MAX 256
+
 /* >>> IMPORTANT NOTE - READ ME BEFORE MODIFYING <<<
  *
  * Do NOT use malloc() and friends or pthread_*() code here.
@@ -72,7 +84,9 @@
  *   and NOEXEC
  */
 
-static bool soinfo_link_image(soinfo* si);
+static bool soinfo_link_image(soinfo* si, int rtld_flags, const android_dlextinfo* extinfo);
+static void symbol_cache_flush();
+static void dlsym_cache_remove(soinfo* si);
 
 // We can't use malloc(3) in the dynamic linker. We use a linked list of anonymous
 // maps, each a single page in size. The pages are broken up into as many struct soinfo
@@ -82,6 +96,14 @@ struct soinfo_pool_t {
   soinfo_pool_t* next;
   soinfo info[SOINFO_PER_POOL];
 };
+
+// References to a pool's soinfos that dlopen(3) handed out without taking
+// the dl lock (see do_dlopen_loaded). This lives on the page after the pool,
+// which stays writable while the pool itself is read-only. A count of -1
+// means the library is being unloaded and can't gain references this way.
+struct soinfo_pool_refs_t {
+  volatile int count[SOINFO_PER_POOL];
+};
 static struct soinfo_pool_t* gSoInfoPools = NULL;
 static soinfo* gSoInfoFreeList = NULL;
 
@@ -103,10 +125,32 @@ static const char* gLdPreloadNames[LDPRELOAD_MAX + 1];
 
 static soinfo* gLdPreloads[LDPRELOAD_MAX + 1];
 
+// LD_LAZY_NEEDED: DT_NEEDED libraries to treat as if marked DF_P1_LAZYLOAD.
+static char gLdLazyNeededBuffer[LDLAZYNEEDED_BUFSIZE];
+static const char* gLdLazyNeededNames[LDLAZYNEEDED_MAX + 1];
+
+// The libraries listed by LD_LIBRARY_MANIFEST, opened ahead of time.
+struct manifest_entry_t {
+  const char* name;
+  int fd; // -1 once open_library() has taken it.
+};
+
+static char gLdManifestBuffer[LDMANIFEST_BUFSIZE];
+static manifest_entry_t gLdManifest[LDMANIFEST_MAX];
+static size_t gLdManifestCount;
+
 __LIBC_HIDDEN__ int gLdDebugVerbosity;
 
+// Set by LD_BIND_NOW to ignore RTLD_LAZY and resolve every PLT entry at load time.
+// This also loads every DT_NEEDED library up front, deferred or not.
+static bool gLdBindNow;
+
 __LIBC_HIDDEN__ abort_msg_t* gAbortMessage = NULL; // For debuggerd.
 
+// The ELF TLS modules of every loaded object with a PT_TLS segment. libc's
+// __tls_get_addr reads this directly (see KernelArgumentBlock::tls_modules).
+static bionic_tls_modules_t gTlsModules = { 1, };
+
 enum RelocationKind {
     kRelocAbsolute = 0,
     kRelocRelative,
@@ -115,20 +159,30 @@ enum RelocationKind {
     kRelocMax
 };
 
-#if STATS
+__LIBC_HIDDEN__ bool gLdStats;
+
+__LIBC_HIDDEN__ bool gLdReadahead;
+
+// LD_STARTUP_TRACE: libc logs these phases, and its own, before calling main().
+static StartupTrace gStartupTrace;
+
+// Running totals for LD_STATS. Per-library figures are differences between
+// snapshots of these.
 struct linker_stats_t {
     int count[kRelocMax];
+    int lookups;        // soinfo_elf_lookup() calls...
+    int lookup_misses;  // ...and how many of them didn't find the symbol.
+    int cache_hits;     // Lookups answered by the symbol cache.
+    long long constructors_us; // Time spent in constructors, however they were ordered.
 };
 
 static linker_stats_t linker_stats;
 
-static void count_relocation(RelocationKind kind) {
-    ++linker_stats.count[kind];
-}
-#else
-static void count_relocation(RelocationKind) {
+static void count_relocation(RelocationKind kind, int n = 1) {
+    if (__predict_false(gLdStats)) {
+        linker_stats.count[kind] += n;
+    }
 }
-#endif
 
 #if COUNT_PAGES
 static unsigned bitmask[4096];
@@ -263,13 +317,14 @@ static bool ensure_free_list_non_empty() {
     return true;
   }
 
-  // Allocate a new pool.
-  soinfo_pool_t* pool = reinterpret_cast<soinfo_pool_t*>(mmap(NULL, sizeof(*pool),
+  // Allocate a new pool, followed by its page of lock-free reference counts.
+  soinfo_pool_t* pool = reinterpret_cast<soinfo_pool_t*>(mmap(NULL, 2 * PAGE_SIZE,
                                                               PROT_READ|PROT_WRITE,
                                                               MAP_PRIVATE|MAP_ANONYMOUS, 0, 0));
   if (pool == MAP_FAILED) {
     return false;
   }
+  __bionic_name_mem(pool, 2 * PAGE_SIZE, "linker_alloc");
 
   // Add the pool to our list of pools.
   pool->next = gSoInfoPools;
@@ -286,6 +341,17 @@ static bool ensure_free_list_non_empty() {
   return true;
 }
 
+// Returns the lock-free reference count for 'si', or NULL for the statically
+// allocated libdl_info, which is never unloaded anyway.
+static volatile int* soinfo_fast_refs(soinfo* si) {
+  if (si == &libdl_info) {
+    return NULL;
+  }
+  soinfo_pool_t* pool = reinterpret_cast<soinfo_pool_t*>(PAGE_START(reinterpret_cast<Elf32_Addr>(si)));
+  soinfo_pool_refs_t* refs = reinterpret_cast<soinfo_pool_refs_t*>(reinterpret_cast<char*>(pool) + PAGE_SIZE);
+  return &refs->count[si - pool->info];
+}
+
 static void set_soinfo_pool_protection(int protection) {
   for (soinfo_pool_t* p = gSoInfoPools; p != NULL; p = p->next) {
     if (mprotect(p, sizeof(*p), protection) == -1) {
@@ -294,6 +360,347 @@ static void set_soinfo_pool_protection(int protection) {
   }
 }
 
+// A symbol name together with its SysV and GNU hashes. The hashes are computed
+// on first use, so a lookup that visits many libraries only hashes the name
+// once per hash style it actually needs.
+class SymbolName {
+ public:
+  // 'version' is the version a versioned reference requires, or NULL.
+  explicit SymbolName(const char* name, const version_info* version = NULL)
+      : name_(name), version_(version), has_elf_hash_(false), has_gnu_hash_(false),
+        elf_hash_(0), gnu_hash_(0) {
+  }
+
+  const char* get_name() const {
+    return name_;
+  }
+
+  const version_info* get_version() const {
+    return version_;
+  }
+
+  uint32_t elf_hash() {
+    if (!has_elf_hash_) {
+      const unsigned char* name = reinterpret_cast<const unsigned char*>(name_);
+      uint32_t h = 0, g;
+
+      while (*name) {
+        h = (h << 4) + *name++;
+        g = h & 0xf0000000;
+        h ^= g;
+        h ^= g >> 24;
+      }
+
+      elf_hash_ = h;
+      has_elf_hash_ = true;
+    }
+    return elf_hash_;
+  }
+
+  uint32_t gnu_hash() {
+    if (!has_gnu_hash_) {
+      const unsigned char* name = reinterpret_cast<const unsigned char*>(name_);
+      uint32_t h = 5381;
+
+      while (*name != 0) {
+        h += (h << 5) + *name++; // h*33 + c = h + h * 32 + c = h + h << 5 + c
+      }
+
+      gnu_hash_ = h;
+      has_gnu_hash_ = true;
+    }
+    return gnu_hash_;
+  }
+
+ private:
+  const char* name_;
+  const version_info* version_;
+  bool has_elf_hash_;
+  bool has_gnu_hash_;
+  uint32_t elf_hash_;
+  uint32_t gnu_hash_;
+};
+
+// Indexes over the loaded objects.
+//
+// find_loaded_library() looks libraries up by name in a chained hash table,
+// and find_containing_library() by address in an array of the loaded objects
+// sorted by base address. Both are maintained by soinfo_alloc() and
+// soinfo_free(), except that an object only joins the address index once
+// soinfo_index_add_address() is called after its base and size are known.
+#define SOINFO_NAME_BUCKETS 512 // Must be a power of two.
+
+static soinfo* gSoInfoNameBuckets[SOINFO_NAME_BUCKETS];
+
+// Loaded objects sorted by base, in memory from mmap(2) so it can grow.
+static soinfo** gSoInfoAddressIndex;
+static size_t gSoInfoAddressIndexCount;
+static size_t gSoInfoAddressIndexCapacity;
+
+static soinfo** soinfo_name_bucket(const char* name) {
+  return &gSoInfoNameBuckets[SymbolName(name).gnu_hash() & (SOINFO_NAME_BUCKETS - 1)];
+}
+
+static void soinfo_index_add_name(soinfo* si) {
+  // Append, so that lookups find the oldest of any objects with the same
+  // name, as a walk of solist would.
+  soinfo** p = soinfo_name_bucket(si->name);
+  while (*p != NULL) {
+    p = &(*p)->name_hash_next;
+  }
+  si->name_hash_next = NULL;
+  *p = si;
+}
+
+// Returns the position of the first of the 'count' objects in 'index', which
+// is sorted by base, whose base is greater than 'address'.
+static size_t soinfo_address_index_upper_bound(soinfo* const index[], size_t count,
+                                               Elf32_Addr address) {
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (index[mid]->base <= address) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static bool soinfo_index_add_address(soinfo* si) {
+  if (si->size == 0) {
+    return true;
+  }
+
+  if (gSoInfoAddressIndexCount == gSoInfoAddressIndexCapacity) {
+    size_t new_capacity = (gSoInfoAddressIndexCapacity == 0) ?
+        PAGE_SIZE / sizeof(soinfo*) : gSoInfoAddressIndexCapacity * 2;
+    void* new_index = mmap(NULL, new_capacity * sizeof(soinfo*), PROT_READ|PROT_WRITE,
+                           MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (new_index == MAP_FAILED) {
+      DL_ERR("out of memory when loading \"%s\"", si->name);
+      return false;
+    }
+    __bionic_name_mem(new_index, new_capacity * sizeof(soinfo*), "linker_alloc");
+    if (gSoInfoAddressIndex != NULL) {
+      memcpy(new_index, gSoInfoAddressIndex, gSoInfoAddressIndexCount * sizeof(soinfo*));
+      munmap(gSoInfoAddressIndex, gSoInfoAddressIndexCapacity * sizeof(soinfo*));
+    }
+    gSoInfoAddressIndex = reinterpret_cast<soinfo**>(new_index);
+    gSoInfoAddressIndexCapacity = new_capacity;
+  }
+
+  size_t i = soinfo_address_index_upper_bound(gSoInfoAddressIndex, gSoInfoAddressIndexCount,
+                                               si->base);
+  memmove(&gSoInfoAddressIndex[i + 1], &gSoInfoAddressIndex[i],
+          (gSoInfoAddressIndexCount - i) * sizeof(soinfo*));
+  gSoInfoAddressIndex[i] = si;
+  ++gSoInfoAddressIndexCount;
+  return true;
+}
+
+static void soinfo_index_remove(soinfo* si) {
+  for (soinfo** p = soinfo_name_bucket(si->name); *p != NULL; p = &(*p)->name_hash_next) {
+    if (*p == si) {
+      *p = si->name_hash_next;
+      break;
+    }
+  }
+
+  size_t i = soinfo_address_index_upper_bound(gSoInfoAddressIndex, gSoInfoAddressIndexCount,
+                                               si->base);
+  for (; i > 0; --i) {
+    if (gSoInfoAddressIndex[i - 1] == si) {
+      memmove(&gSoInfoAddressIndex[i - 1], &gSoInfoAddressIndex[i],
+              (gSoInfoAddressIndexCount - i) * sizeof(soinfo*));
+      --gSoInfoAddressIndexCount;
+      break;
+    }
+    if (gSoInfoAddressIndex[i - 1]->base != si->base) {
+      break;
+    }
+  }
+}
+
+// Lock-free readers.
+//
+// dladdr(3), dl_iterate_phdr(3) and dl_unwind_find_exidx(3) are called by
+// unwinders and profilers on every frame, from many threads at once, so they
+// don't take gDlMutex. Instead they see an immutable snapshot of the loaded
+// objects, which dlopen(3) and dlclose(3) replace wholesale. A replaced
+// snapshot, or a library that's no longer in the current one, is only
+// unmapped after a grace period in which every reader that might have seen
+// it has finished.
+//
+// Readers register in one of two epochs. To wait for a grace period, the
+// writer flips the current epoch, so that new readers register in the other
+// one, and then waits until the old epoch has no readers left, not counting
+// the writer itself: a dl_iterate_phdr(3) callback may call dlopen(3). In that
+// case the old snapshot is still in use by our own caller, so we leak it.
+struct loaded_objects_t {
+  size_t mmap_size;
+  size_t count;          // Everything in solist, in order...
+  soinfo** objects;
+  size_t address_count;  // ...and those with an address range, sorted by base.
+  soinfo** by_address;
+  size_t name_mask;      // An open-addressed hash table of them all, by name.
+  soinfo** by_name;
+};
+
+static loaded_objects_t* volatile gLoadedObjects;
+static bool gLoadedObjectsChanged;
+// Bumped with every new snapshot, for android_dl_get_generation().
+static volatile unsigned gLoadedObjectsGeneration;
+static volatile int gReaderEpoch;
+static volatile int gReaderCount[2];
+
+ScopedLoadedObjectsReader::ScopedLoadedObjectsReader() {
+  // A writer may flip the epoch between our reading it and registering, and
+  // then find no readers left in the old one. So retry until we're registered
+  // in the current epoch: the next writer waits for that one, and any snapshot
+  // an earlier writer is about to free has already been replaced.
+  while (true) {
+    epoch_ = gReaderEpoch;
+    __atomic_inc(&gReaderCount[epoch_]);
+    __sync_synchronize();
+    if (gReaderEpoch == epoch_) {
+      break;
+    }
+    __atomic_dec(&gReaderCount[epoch_]);
+  }
+  ++__get_thread()->dl_reader_count[epoch_];
+}
+
+ScopedLoadedObjectsReader::~ScopedLoadedObjectsReader() {
+  --__get_thread()->dl_reader_count[epoch_];
+  __atomic_dec(&gReaderCount[epoch_]);
+}
+
+// Waits for a grace period. Returns false if the calling thread is itself a
+// reader, so the grace period doesn't cover it.
+static bool loaded_objects_synchronize() {
+  int old_epoch = gReaderEpoch;
+  __sync_synchronize();
+  gReaderEpoch = old_epoch ^ 1;
+  __sync_synchronize();
+  const int* own_count = __get_thread()->dl_reader_count;
+  while (gReaderCount[old_epoch] != own_count[old_epoch]) {
+    sched_yield();
+  }
+  return own_count[0] == 0 && own_count[1] == 0;
+}
+
+// Publishes a new snapshot of the loaded objects, leaving out 'unloading' if
+// it isn't NULL. Returns once no other reader can still see the old snapshot.
+static void loaded_objects_publish(const soinfo* unloading) {
+  size_t count = 0;
+  for (soinfo* si = solist; si != NULL; si = si->next) {
+    ++count;
+  }
+  // Keep the name table at most half full.
+  size_t name_slots = 8;
+  while (name_slots < 2 * count) {
+    name_slots *= 2;
+  }
+  size_t mmap_size = PAGE_END(sizeof(loaded_objects_t) +
+                              (count + gSoInfoAddressIndexCount + name_slots) * sizeof(soinfo*));
+  void* map = mmap(NULL, mmap_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+  loaded_objects_t* snapshot = NULL;
+  if (map != MAP_FAILED) {
+    __bionic_name_mem(map, mmap_size, "linker_alloc");
+    snapshot = reinterpret_cast<loaded_objects_t*>(map);
+    snapshot->mmap_size = mmap_size;
+    snapshot->objects = reinterpret_cast<soinfo**>(snapshot + 1);
+    snapshot->count = 0;
+    for (soinfo* si = solist; si != NULL; si = si->next) {
+      if (si != unloading) {
+        snapshot->objects[snapshot->count++] = si;
+      }
+    }
+    snapshot->by_address = snapshot->objects + snapshot->count;
+    snapshot->address_count = 0;
+    for (size_t i = 0; i < gSoInfoAddressIndexCount; ++i) {
+      if (gSoInfoAddressIndex[i] != unloading) {
+        snapshot->by_address[snapshot->address_count++] = gSoInfoAddressIndex[i];
+      }
+    }
+    // Insert in solist order, so that probing finds the oldest of any objects
+    // with the same name, as find_loaded_library() does.
+    snapshot->by_name = snapshot->by_address + snapshot->address_count;
+    snapshot->name_mask = name_slots - 1;
+    for (size_t i = 0; i < snapshot->count; ++i) {
+      soinfo* si = snapshot->objects[i];
+      size_t slot = SymbolName(si->name).gnu_hash() & snapshot->name_mask;
+      while (snapshot->by_name[slot] != NULL) {
+        slot = (slot + 1) & snapshot->name_mask;
+      }
+      snapshot->by_name[slot] = si;
+    }
+    mprotect(map, mmap_size, PROT_READ);
+  } else {
+    // Readers will see nothing until the next dlopen(3) or dlclose(3), but
+    // we can't leave them looking at a library we're about to unmap.
+    DEBUG("couldn't allocate a new snapshot of the loaded objects");
+  }
+
+  loaded_objects_t* old_snapshot = gLoadedObjects;
+  __sync_synchronize();
+  gLoadedObjects = snapshot;
+  ++gLoadedObjectsGeneration;
+  if (loaded_objects_synchronize() && old_snapshot != NULL) {
+    munmap(old_snapshot, old_snapshot->mmap_size);
+  }
+  gLoadedObjectsChanged = false;
+}
+
+static soinfo* loaded_objects_find_by_name(const loaded_objects_t* snapshot, const char* bname) {
+  size_t slot = SymbolName(bname).gnu_hash() & snapshot->name_mask;
+  for (soinfo* si; (si = snapshot->by_name[slot]) != NULL; slot = (slot + 1) & snapshot->name_mask) {
+    if (strcmp(bname, si->name) == 0) {
+      return si;
+    }
+  }
+  return NULL;
+}
+
+// Gives 'si' a TLS module id for its PT_TLS segment 'tls'.
+static bool tls_module_register(soinfo* si, const Elf32_Phdr* tls) {
+  if (tls->p_align > PAGE_SIZE) {
+    DL_ERR("\"%s\" has unsupported TLS alignment %d", si->name, tls->p_align);
+    return false;
+  }
+  for (size_t id = 1; id < BIONIC_TLS_MODULES_MAX; ++id) {
+    bionic_tls_module_t* m = &gTlsModules.modules[id];
+    if (m->generation == 0) {
+      m->init_image = reinterpret_cast<const void*>(si->load_bias + tls->p_vaddr);
+      m->init_size = tls->p_filesz;
+      m->block_size = tls->p_memsz;
+      m->align = tls->p_align;
+      // Never 0, which means the id is free.
+      m->generation = gTlsModules.next_generation++;
+      if (gTlsModules.next_generation == 0) {
+        gTlsModules.next_generation = 1;
+      }
+      si->tls_module_id = id;
+      TRACE("name %s: TLS module %d, %d bytes", si->name, id, tls->p_memsz);
+      return true;
+    }
+  }
+  DL_ERR("\"%s\" has a TLS segment, but there are already %d TLS modules",
+         si->name, BIONIC_TLS_MODULES_MAX - 1);
+  return false;
+}
+
+static void tls_module_unregister(soinfo* si) {
+  if (si->tls_module_id != 0) {
+    memset(&gTlsModules.modules[si->tls_module_id], 0, sizeof(bionic_tls_module_t));
+    si->tls_module_id = 0;
+  }
+}
+
 static soinfo* soinfo_alloc(const char* name) {
   if (strlen(name) >= SOINFO_NAME_LEN) {
     DL_ERR("library name \"%s\" too long", name);
@@ -311,9 +718,12 @@ static soinfo* soinfo_alloc(const char* name) {
 
   // Initialize the new element.
   memset(si, 0, sizeof(soinfo));
+  *soinfo_fast_refs(si) = 0;
   strlcpy(si->name, name, sizeof(si->name));
   sonext->next = si;
   sonext = si;
+  soinfo_index_add_name(si);
+  gLoadedObjectsChanged = true;
 
   TRACE("name %s: allocated soinfo @ %p", name, si);
   return si;
@@ -347,8 +757,14 @@ static void soinfo_free(soinfo* si)
     if (si == sonext) {
         sonext = prev;
     }
+    soinfo_index_remove(si);
+    tls_module_unregister(si);
+    gLoadedObjectsChanged = true;
     si->next = gSoInfoFreeList;
     gSoInfoFreeList = si;
+
+    symbol_cache_flush();
+    dlsym_cache_remove(si);
 }
 
 
@@ -388,6 +804,15 @@ static void parse_LD_PRELOAD(const char* path) {
              gLdPreloadsBuffer, sizeof(gLdPreloadsBuffer), LDPRELOAD_MAX);
 }
 
+static void parse_LD_LAZY_NEEDED(const char* names) {
+  parse_path(names, " :", gLdLazyNeededNames,
+             gLdLazyNeededBuffer, sizeof(gLdLazyNeededBuffer), LDLAZYNEEDED_MAX);
+}
+
+unsigned android_dl_get_generation() {
+  return gLoadedObjectsGeneration;
+}
+
 #ifdef ANDROID_ARM_LINKER
 
 /* For a given PC, find the .so that it belongs to.
@@ -401,16 +826,13 @@ static void parse_LD_PRELOAD(const char* path) {
  */
 _Unwind_Ptr dl_unwind_find_exidx(_Unwind_Ptr pc, int *pcount)
 {
-    soinfo *si;
-    unsigned addr = (unsigned)pc;
-
-    for (si = solist; si != 0; si = si->next){
-        if ((addr >= si->base) && (addr < (si->base + si->size))) {
-            *pcount = si->ARM_exidx_count;
-            return (_Unwind_Ptr)si->ARM_exidx;
-        }
+    ScopedLoadedObjectsReader reader;
+    soinfo* si = find_containing_library(reinterpret_cast<void*>(pc));
+    if (si != NULL) {
+        *pcount = si->ARM_exidx_count;
+        return (_Unwind_Ptr)si->ARM_exidx;
     }
-   *pcount = 0;
+    *pcount = 0;
     return NULL;
 }
 
@@ -422,8 +844,14 @@ int
 dl_iterate_phdr(int (*cb)(dl_phdr_info *info, size_t size, void *data),
                 void *data)
 {
+    ScopedLoadedObjectsReader reader;
+    const loaded_objects_t* snapshot = gLoadedObjects;
+    if (snapshot == NULL) {
+        return 0;
+    }
     int rv = 0;
-    for (soinfo* si = solist; si != NULL; si = si->next) {
+    for (size_t i = 0; i < snapshot->count; ++i) {
+        soinfo* si = snapshot->objects[i];
         dl_phdr_info dl_info;
         dl_info.dlpi_addr = si->link_map.l_addr;
         dl_info.dlpi_name = si->link_map.l_name;
@@ -439,7 +867,161 @@ dl_iterate_phdr(int (*cb)(dl_phdr_info *info, size_t size, void *data),
 
 #endif
 
-static Elf32_Sym* soinfo_elf_lookup(soinfo* si, unsigned hash, const char* name) {
+/* only concern ourselves with global and weak symbol definitions */
+static bool is_symbol_global_and_defined(const Elf32_Sym* s) {
+    switch (ELF32_ST_BIND(s->st_info)) {
+    case STB_GLOBAL:
+    case STB_WEAK:
+        return s->st_shndx != SHN_UNDEF;
+    default:
+        return false;
+    }
+}
+
+// Symbol versioning.
+//
+// Each entry of DT_VERSYM gives the version index of the corresponding
+// symbol. For a reference, the index names a DT_VERNEED entry, the version
+// required. For a definition, it names a DT_VERDEF entry, with
+// VER_NDX_HIDDEN set unless this is the default version of the symbol, the
+// one unversioned references get. Indexes 0 and 1 mean unversioned.
+//
+// Versions are compared by hash, recorded in both tables so there's nothing
+// to compute, before bothering to compare names. Looking up an index is an
+// array access via the table soinfo_init_versions() builds at link time.
+
+// Finds version index 'ndx' of 'si' by walking DT_VERDEF and DT_VERNEED.
+static bool soinfo_find_version(const soinfo* si, Elf32_Half ndx, version_info* out) {
+    char* p = reinterpret_cast<char*>(si->verdef);
+    for (size_t i = 0; i < si->verdef_count; ++i) {
+        Elf32_Verdef* verdef = reinterpret_cast<Elf32_Verdef*>(p);
+        if (verdef->vd_ndx == ndx && verdef->vd_cnt != 0) {
+            Elf32_Verdaux* verdaux = reinterpret_cast<Elf32_Verdaux*>(p + verdef->vd_aux);
+            out->hash = verdef->vd_hash;
+            out->name = si->strtab + verdaux->vda_name;
+            return true;
+        }
+        p += verdef->vd_next;
+    }
+
+    p = reinterpret_cast<char*>(si->verneed);
+    for (size_t i = 0; i < si->verneed_count; ++i) {
+        Elf32_Verneed* verneed = reinterpret_cast<Elf32_Verneed*>(p);
+        char* q = p + verneed->vn_aux;
+        for (size_t j = 0; j < verneed->vn_cnt; ++j) {
+            Elf32_Vernaux* vernaux = reinterpret_cast<Elf32_Vernaux*>(q);
+            if (VER_NDX(vernaux->vna_other) == ndx) {
+                out->hash = vernaux->vna_hash;
+                out->name = si->strtab + vernaux->vna_name;
+                return true;
+            }
+            q += vernaux->vna_next;
+        }
+        p += verneed->vn_next;
+    }
+    return false;
+}
+
+static void soinfo_init_versions(soinfo* si) {
+    for (Elf32_Half ndx = 0; ndx < SOINFO_VERSION_MAX; ++ndx) {
+        if (ndx <= VER_NDX_GLOBAL || !soinfo_find_version(si, ndx, &si->versions[ndx])) {
+            si->versions[ndx].hash = 0;
+            si->versions[ndx].name = NULL;
+        }
+    }
+}
+
+// Returns version index 'ndx' of 'si', using 'storage' if it's not in the
+// precomputed table, or NULL if there's no such version.
+static const version_info* soinfo_get_version(const soinfo* si, Elf32_Half ndx,
+                                              version_info* storage) {
+    if (ndx < SOINFO_VERSION_MAX) {
+        return (si->versions[ndx].name != NULL) ? &si->versions[ndx] : NULL;
+    }
+    return soinfo_find_version(si, ndx, storage) ? storage : NULL;
+}
+
+// Returns the version required by a reference to symbol 'n' of 'si', or
+// NULL if the reference is unversioned.
+static const version_info* soinfo_symbol_version(const soinfo* si, size_t n,
+                                                 version_info* storage) {
+    if (si->versym == NULL) {
+        return NULL;
+    }
+    Elf32_Half ndx = VER_NDX(si->versym[n]);
+    if (ndx <= VER_NDX_GLOBAL) {
+        return NULL;
+    }
+    return soinfo_get_version(si, ndx, storage);
+}
+
+// Whether symbol 'n' of 'si' is the definition a reference to 'version'
+// (NULL for an unversioned reference) should bind to.
+static bool soinfo_symbol_version_matches(const soinfo* si, size_t n,
+                                          const version_info* version) {
+    if (si->versym == NULL) {
+        return true;
+    }
+    Elf32_Half versym = si->versym[n];
+    if (VER_NDX(versym) <= VER_NDX_GLOBAL) {
+        return true;
+    }
+    if (version == NULL) {
+        return (versym & VER_NDX_HIDDEN) == 0;
+    }
+    version_info storage;
+    const version_info* defined = soinfo_get_version(si, VER_NDX(versym), &storage);
+    return defined != NULL && defined->hash == version->hash &&
+        strcmp(defined->name, version->name) == 0;
+}
+
+static Elf32_Sym* soinfo_gnu_lookup(soinfo* si, SymbolName& symbol_name) {
+    uint32_t hash = symbol_name.gnu_hash();
+    uint32_t h2 = hash >> si->gnu_shift2;
+
+    const uint32_t bloom_mask_bits = sizeof(Elf32_Addr) * 8;
+    uint32_t word_num = (hash / bloom_mask_bits) & si->gnu_maskwords;
+    Elf32_Addr bloom_word = si->gnu_bloom_filter[word_num];
+
+    TRACE_TYPE(LOOKUP, "SEARCH %s in %s@0x%08x (gnu)",
+               symbol_name.get_name(), si->name, si->base);
+
+    // Test against the Bloom filter. Most lookups are misses, and this
+    // rejects nearly all of them without touching the string table.
+    if ((1 & (bloom_word >> (hash % bloom_mask_bits)) & (bloom_word >> (h2 % bloom_mask_bits))) == 0) {
+        TRACE_TYPE(LOOKUP, "NOT FOUND %s in %s@0x%08x (bloom)",
+                   symbol_name.get_name(), si->name, si->base);
+        return NULL;
+    }
+
+    // The Bloom filter says "probably yes"...
+    uint32_t n = si->gnu_bucket[hash % si->gnu_nbucket];
+    if (n == 0) {
+        return NULL;
+    }
+
+    Elf32_Sym* symtab = si->symtab;
+    const char* strtab = si->strtab;
+    do {
+        Elf32_Sym* s = symtab + n;
+        // The low bit of each chain entry marks the end of the chain, the
+        // rest is the hash; compare that before bothering with strcmp(3).
+        if (((si->gnu_chain[n] ^ hash) >> 1) == 0 &&
+            strcmp(strtab + s->st_name, symbol_name.get_name()) == 0 &&
+            is_symbol_global_and_defined(s) &&
+            soinfo_symbol_version_matches(si, n, symbol_name.get_version())) {
+            TRACE_TYPE(LOOKUP, "FOUND %s in %s (%08x) %d",
+                       symbol_name.get_name(), si->name, s->st_value, s->st_size);
+            return s;
+        }
+    } while ((si->gnu_chain[n++] & 1) == 0);
+
+    return NULL;
+}
+
+static Elf32_Sym* soinfo_sysv_lookup(soinfo* si, SymbolName& symbol_name) {
+    unsigned hash = symbol_name.elf_hash();
+    const char* name = symbol_name.get_name();
     Elf32_Sym* symtab = si->symtab;
     const char* strtab = si->strtab;
 
@@ -450,14 +1032,8 @@ static Elf32_Sym* soinfo_elf_lookup(soinfo* si, unsigned hash, const char* name)
         Elf32_Sym* s = symtab + n;
         if (strcmp(strtab + s->st_name, name)) continue;
 
-            /* only concern ourselves with global and weak symbol definitions */
-        switch(ELF32_ST_BIND(s->st_info)){
-        case STB_GLOBAL:
-        case STB_WEAK:
-            if (s->st_shndx == SHN_UNDEF) {
-                continue;
-            }
-
+        if (is_symbol_global_and_defined(s) &&
+            soinfo_symbol_version_matches(si, n, symbol_name.get_version())) {
             TRACE_TYPE(LOOKUP, "FOUND %s in %s (%08x) %d",
                        name, si->name, s->st_value, s->st_size);
             return s;
@@ -467,21 +1043,219 @@ static Elf32_Sym* soinfo_elf_lookup(soinfo* si, unsigned hash, const char* name)
     return NULL;
 }
 
-static unsigned elfhash(const char* _name) {
-    const unsigned char* name = (const unsigned char*) _name;
-    unsigned h = 0, g;
+static Elf32_Sym* soinfo_elf_lookup(soinfo* si, SymbolName& symbol_name) {
+    Elf32_Sym* s;
+    if ((si->flags & FLAG_GNU_HASH) != 0) {
+        s = soinfo_gnu_lookup(si, symbol_name);
+    } else {
+        s = soinfo_sysv_lookup(si, symbol_name);
+    }
 
-    while(*name) {
-        h = (h << 4) + *name++;
-        g = h & 0xf0000000;
-        h ^= g;
-        h ^= g >> 24;
+    if (__predict_false(gLdStats)) {
+        ++linker_stats.lookups;
+        if (s == NULL) {
+            ++linker_stats.lookup_misses;
+        }
     }
-    return h;
+    return s;
+}
+
+// Symbol resolution cache.
+//
+// soinfo_relocate() resolves the same popular imports (memcpy, malloc,
+// __stack_chk_guard, ...) for nearly every library. The tail of
+// soinfo_do_lookup() that searches the LD_PRELOAD libraries and then the
+// DT_NEEDED libraries depends only on the DT_NEEDED list, and most libraries
+// share a handful of such lists. So we intern each distinct DT_NEEDED list as
+// a "lookup scope" and remember the result of the tail search keyed by
+// (name, scope).
+//
+// Entries point into the string and symbol tables of loaded libraries, so the
+// whole cache is invalidated whenever a soinfo is freed, and whenever the
+// LD_PRELOAD list changes. Invalidation just bumps a generation number.
+#define SYMBOL_CACHE_SIZE        2048 // Must be a power of two.
+#define SYMBOL_CACHE_MAX_PROBES  8
+#define LOOKUP_SCOPE_MAX         128
+#define LOOKUP_SCOPE_MAX_SLOTS   1024
+
+static const int kNoLookupScope = -1;
+
+struct symbol_cache_entry_t {
+  uint32_t generation; // The entry is empty unless this matches gSymbolCacheGeneration.
+  uint32_t hash;
+  int scope;
+  const char* name;
+  Elf32_Sym* sym; // NULL if the symbol wasn't found in this scope.
+  soinfo* lsi;
+};
+
+struct lookup_scope_t {
+  size_t start; // Index of this scope's first library in gLookupScopeSlots.
+  size_t count;
+};
+
+static symbol_cache_entry_t gSymbolCache[SYMBOL_CACHE_SIZE];
+static uint32_t gSymbolCacheGeneration = 1;
+
+static lookup_scope_t gLookupScopes[LOOKUP_SCOPE_MAX];
+static size_t gLookupScopeCount;
+static soinfo* gLookupScopeSlots[LOOKUP_SCOPE_MAX_SLOTS];
+static size_t gLookupScopeSlotCount;
+
+static void symbol_cache_flush() {
+  ++gSymbolCacheGeneration;
+  gLookupScopeCount = 0;
+  gLookupScopeSlotCount = 0;
 }
 
-static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, soinfo* needed[]) {
-    unsigned elf_hash = elfhash(name);
+// Returns the id of the lookup scope corresponding to the NULL-terminated
+// DT_NEEDED list 'needed', or kNoLookupScope if we've run out of room.
+static int lookup_scope_intern(soinfo* needed[]) {
+  size_t count = 0;
+  while (needed[count] != NULL) {
+    ++count;
+  }
+
+  for (size_t i = 0; i < gLookupScopeCount; ++i) {
+    const lookup_scope_t& scope = gLookupScopes[i];
+    if (scope.count == count &&
+        memcmp(&gLookupScopeSlots[scope.start], needed, count * sizeof(soinfo*)) == 0) {
+      return i;
+    }
+  }
+
+  if (gLookupScopeCount == LOOKUP_SCOPE_MAX ||
+      LOOKUP_SCOPE_MAX_SLOTS - gLookupScopeSlotCount < count) {
+    return kNoLookupScope;
+  }
+
+  lookup_scope_t& scope = gLookupScopes[gLookupScopeCount];
+  scope.start = gLookupScopeSlotCount;
+  scope.count = count;
+  memcpy(&gLookupScopeSlots[scope.start], needed, count * sizeof(soinfo*));
+  gLookupScopeSlotCount += count;
+  return gLookupScopeCount++;
+}
+
+static symbol_cache_entry_t* symbol_cache_find(SymbolName& symbol_name, int scope) {
+  uint32_t hash = symbol_name.gnu_hash();
+  for (size_t probe = 0; probe < SYMBOL_CACHE_MAX_PROBES; ++probe) {
+    symbol_cache_entry_t* entry = &gSymbolCache[(hash + probe) & (SYMBOL_CACHE_SIZE - 1)];
+    if (entry->generation != gSymbolCacheGeneration) {
+      return NULL;
+    }
+    if (entry->hash == hash && entry->scope == scope &&
+        strcmp(entry->name, symbol_name.get_name()) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void symbol_cache_insert(SymbolName& symbol_name, int scope, Elf32_Sym* s, soinfo* lsi) {
+  uint32_t hash = symbol_name.gnu_hash();
+  // Take the first free slot in the probe sequence. If there isn't one,
+  // overwrite the home slot; the cache is only ever a hint.
+  symbol_cache_entry_t* entry = &gSymbolCache[hash & (SYMBOL_CACHE_SIZE - 1)];
+  for (size_t probe = 0; probe < SYMBOL_CACHE_MAX_PROBES; ++probe) {
+    symbol_cache_entry_t* candidate = &gSymbolCache[(hash + probe) & (SYMBOL_CACHE_SIZE - 1)];
+    if (candidate->generation != gSymbolCacheGeneration) {
+      entry = candidate;
+      break;
+    }
+  }
+  entry->generation = gSymbolCacheGeneration;
+  entry->hash = hash;
+  entry->scope = scope;
+  entry->name = symbol_name.get_name();
+  entry->sym = s;
+  entry->lsi = lsi;
+}
+
+// dlsym(3) results for (handle, name) pairs. This is direct-mapped, so each
+// handle gets a bounded share of it. An entry points into its handle's own
+// symbol table, which is also where the name is compared, and soinfo_free()
+// drops a handle's entries. Failed lookups aren't cached.
+#define DLSYM_CACHE_SIZE 256 // Must be a power of two.
+
+struct dlsym_cache_entry_t {
+  soinfo* si;
+  uint32_t hash;
+  Elf32_Sym* sym; // The entry is empty if this is NULL.
+};
+
+static dlsym_cache_entry_t gDlsymCache[DLSYM_CACHE_SIZE];
+
+static dlsym_cache_entry_t* dlsym_cache_slot(soinfo* si, uint32_t hash) {
+  uint32_t key = hash ^ (reinterpret_cast<uintptr_t>(si) >> 4);
+  return &gDlsymCache[key & (DLSYM_CACHE_SIZE - 1)];
+}
+
+static void dlsym_cache_remove(soinfo* si) {
+  for (size_t i = 0; i < DLSYM_CACHE_SIZE; ++i) {
+    if (gDlsymCache[i].si == si) {
+      gDlsymCache[i].si = NULL;
+      gDlsymCache[i].sym = NULL;
+    }
+  }
+}
+
+// Searches the LD_PRELOAD libraries and then the DT_NEEDED libraries.
+static Elf32_Sym* soinfo_scope_lookup(soinfo* si, SymbolName& symbol_name, soinfo** lsi,
+                                      soinfo* needed[], int scope) {
+    // The cache is keyed by name alone, so versioned references (which are
+    // rare) bypass it.
+    if (symbol_name.get_version() != NULL) {
+        scope = kNoLookupScope;
+    }
+    if (scope != kNoLookupScope) {
+        symbol_cache_entry_t* entry = symbol_cache_find(symbol_name, scope);
+        if (entry != NULL) {
+            if (__predict_false(gLdStats)) {
+                ++linker_stats.cache_hits;
+            }
+            TRACE_TYPE(LOOKUP, "CACHED %s in scope %d: %s",
+                       symbol_name.get_name(), scope, (entry->lsi != NULL) ? entry->lsi->name : "(none)");
+            *lsi = entry->lsi;
+            return entry->sym;
+        }
+    }
+
+    Elf32_Sym* s = NULL;
+    soinfo* found = NULL;
+
+    /* Next, look for it in the preloads list */
+    for (int i = 0; gLdPreloads[i] != NULL; i++) {
+        s = soinfo_elf_lookup(gLdPreloads[i], symbol_name);
+        if (s != NULL) {
+            found = gLdPreloads[i];
+            goto done;
+        }
+    }
+
+    for (int i = 0; needed[i] != NULL; i++) {
+        DEBUG("%s: looking up %s in %s",
+              si->name, symbol_name.get_name(), needed[i]->name);
+        s = soinfo_elf_lookup(needed[i], symbol_name);
+        if (s != NULL) {
+            found = needed[i];
+            goto done;
+        }
+    }
+
+done:
+    if (scope != kNoLookupScope) {
+        symbol_cache_insert(symbol_name, scope, s, found);
+    }
+    if (s != NULL) {
+        *lsi = found;
+    }
+    return s;
+}
+
+static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, const version_info* version,
+                                   soinfo** lsi, soinfo* needed[], int scope) {
+    SymbolName symbol_name(name, version);
     Elf32_Sym* s = NULL;
 
     if (si != NULL && somain != NULL) {
@@ -492,7 +1266,7 @@ static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, s
          */
 
         if (si == somain) {
-            s = soinfo_elf_lookup(si, elf_hash, name);
+            s = soinfo_elf_lookup(si, symbol_name);
             if (s != NULL) {
                 *lsi = si;
                 goto done;
@@ -509,7 +1283,7 @@ static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, s
             if (!si->has_DT_SYMBOLIC) {
                 DEBUG("%s: looking up %s in executable %s",
                       si->name, name, somain->name);
-                s = soinfo_elf_lookup(somain, elf_hash, name);
+                s = soinfo_elf_lookup(somain, symbol_name);
                 if (s != NULL) {
                     *lsi = somain;
                     goto done;
@@ -526,7 +1300,7 @@ static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, s
              * and some the first non-weak definition.   This is system dependent.
              * Here we return the first definition found for simplicity.  */
 
-            s = soinfo_elf_lookup(si, elf_hash, name);
+            s = soinfo_elf_lookup(si, symbol_name);
             if (s != NULL) {
                 *lsi = si;
                 goto done;
@@ -540,7 +1314,7 @@ static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, s
             if (si->has_DT_SYMBOLIC) {
                 DEBUG("%s: looking up %s in executable %s after local scope",
                       si->name, name, somain->name);
-                s = soinfo_elf_lookup(somain, elf_hash, name);
+                s = soinfo_elf_lookup(somain, symbol_name);
                 if (s != NULL) {
                     *lsi = somain;
                     goto done;
@@ -549,24 +1323,7 @@ static Elf32_Sym* soinfo_do_lookup(soinfo* si, const char* name, soinfo** lsi, s
         }
     }
 
-    /* Next, look for it in the preloads list */
-    for (int i = 0; gLdPreloads[i] != NULL; i++) {
-        s = soinfo_elf_lookup(gLdPreloads[i], elf_hash, name);
-        if (s != NULL) {
-            *lsi = gLdPreloads[i];
-            goto done;
-        }
-    }
-
-    for (int i = 0; needed[i] != NULL; i++) {
-        DEBUG("%s: looking up %s in %s",
-              si->name, name, needed[i]->name);
-        s = soinfo_elf_lookup(needed[i], elf_hash, name);
-        if (s != NULL) {
-            *lsi = needed[i];
-            goto done;
-        }
-    }
+    s = soinfo_scope_lookup(si, symbol_name, lsi, needed, scope);
 
 done:
     if (s != NULL) {
@@ -591,7 +1348,27 @@ done:
  */
 Elf32_Sym* dlsym_handle_lookup(soinfo* si, const char* name)
 {
-    return soinfo_elf_lookup(si, elfhash(name), name);
+    SymbolName symbol_name(name);
+
+    // JNI registration and plugin hosts ask for the same names over and over,
+    // so check the cache before walking the handle's hash table.
+    dlsym_cache_entry_t* entry = dlsym_cache_slot(si, symbol_name.gnu_hash());
+    Elf32_Sym* s = entry->sym;
+    if (s != NULL && entry->si == si && entry->hash == symbol_name.gnu_hash() &&
+        strcmp(si->strtab + s->st_name, name) == 0) {
+        if (__predict_false(gLdStats)) {
+            ++linker_stats.cache_hits;
+        }
+        return s;
+    }
+
+    s = soinfo_elf_lookup(si, symbol_name);
+    if (s != NULL) {
+        entry->si = si;
+        entry->hash = symbol_name.gnu_hash();
+        entry->sym = s;
+    }
+    return s;
 }
 
 /* This is used by dlsym(3) to performs a global symbol lookup. If the
@@ -600,7 +1377,7 @@ Elf32_Sym* dlsym_handle_lookup(soinfo* si, const char* name)
    specified soinfo (for RTLD_NEXT).
  */
 Elf32_Sym* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start) {
-  unsigned elf_hash = elfhash(name);
+  SymbolName symbol_name(name);
 
   if (start == NULL) {
     start = solist;
@@ -608,7 +1385,7 @@ Elf32_Sym* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start)
 
   Elf32_Sym* s = NULL;
   for (soinfo* si = start; (s == NULL) && (si != NULL); si = si->next) {
-    s = soinfo_elf_lookup(si, elf_hash, name);
+    s = soinfo_elf_lookup(si, symbol_name);
     if (s != NULL) {
       *found = si;
       break;
@@ -624,25 +1401,60 @@ Elf32_Sym* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start)
 }
 
 soinfo* find_containing_library(const void* p) {
+  const loaded_objects_t* snapshot = gLoadedObjects;
+  if (snapshot == NULL) {
+    return NULL;
+  }
   Elf32_Addr address = reinterpret_cast<Elf32_Addr>(p);
-  for (soinfo* si = solist; si != NULL; si = si->next) {
-    if (address >= si->base && address - si->base < si->size) {
+  size_t i = soinfo_address_index_upper_bound(snapshot->by_address, snapshot->address_count,
+                                              address);
+  if (i > 0) {
+    soinfo* si = snapshot->by_address[i - 1];
+    if (address - si->base < si->size) {
       return si;
     }
   }
   return NULL;
 }
 
+static bool symbol_matches_soaddr(const Elf32_Sym* sym, Elf32_Addr soaddr) {
+  return sym->st_shndx != SHN_UNDEF &&
+      soaddr >= sym->st_value &&
+      soaddr < sym->st_value + sym->st_size;
+}
+
+static Elf32_Sym* gnu_addr_lookup(soinfo* si, Elf32_Addr soaddr) {
+  // A GNU hash table doesn't record the number of symbols, but every defined
+  // symbol is reachable from exactly one bucket's chain.
+  for (size_t i = 0; i < si->gnu_nbucket; ++i) {
+    uint32_t n = si->gnu_bucket[i];
+    if (n == 0) {
+      continue;
+    }
+
+    do {
+      Elf32_Sym* sym = &si->symtab[n];
+      if (symbol_matches_soaddr(sym, soaddr)) {
+        return sym;
+      }
+    } while ((si->gnu_chain[n++] & 1) == 0);
+  }
+
+  return NULL;
+}
+
 Elf32_Sym* dladdr_find_symbol(soinfo* si, const void* addr) {
   Elf32_Addr soaddr = reinterpret_cast<Elf32_Addr>(addr) - si->base;
 
+  if ((si->flags & FLAG_GNU_HASH) != 0) {
+    return gnu_addr_lookup(si, soaddr);
+  }
+
   // Search the library's symbol table for any defined symbol which
   // contains this address.
   for (size_t i = 0; i < si->nchain; ++i) {
     Elf32_Sym* sym = &si->symtab[i];
-    if (sym->st_shndx != SHN_UNDEF &&
-        soaddr >= sym->st_value &&
-        soaddr < sym->st_value + sym->st_size) {
+    if (symbol_matches_soaddr(sym, soaddr)) {
       return sym;
     }
   }
@@ -663,15 +1475,19 @@ static void dump(soinfo* si)
 }
 #endif
 
-static int open_library_on_path(const char* name, const char* const paths[]) {
+static int open_library_in_dir(const char* dir, const char* name) {
   char buf[512];
+  int n = __libc_format_buffer(buf, sizeof(buf), "%s/%s", dir, name);
+  if (n < 0 || n >= static_cast<int>(sizeof(buf))) {
+    PRINT("Warning: ignoring very long library path: %s/%s", dir, name);
+    return -1;
+  }
+  return TEMP_FAILURE_RETRY(open(buf, O_RDONLY | O_CLOEXEC));
+}
+
+static int open_library_on_path(const char* name, const char* const paths[]) {
   for (size_t i = 0; paths[i] != NULL; ++i) {
-    int n = __libc_format_buffer(buf, sizeof(buf), "%s/%s", paths[i], name);
-    if (n < 0 || n >= static_cast<int>(sizeof(buf))) {
-      PRINT("Warning: ignoring very long library path: %s/%s", paths[i], name);
-      continue;
-    }
-    int fd = TEMP_FAILURE_RETRY(open(buf, O_RDONLY | O_CLOEXEC));
+    int fd = open_library_in_dir(paths[i], name);
     if (fd != -1) {
       return fd;
     }
@@ -679,9 +1495,174 @@ static int open_library_on_path(const char* name, const char* const paths[]) {
   return -1;
 }
 
+// Library directory cache.
+//
+// Probing every search directory with open(2) means that finding a library
+// in /system/lib costs a failed open in /vendor/lib and in every
+// LD_LIBRARY_PATH entry first. Instead we list the search directories once,
+// with getdents(2), and remember which of them contain each name, so a lookup
+// is a hash probe followed by a single open(2).
+//
+// Directories are assumed not to change while we're using them, except that
+// a name we don't know about falls back to probing, so a library added after
+// the listing is still found. android_update_LD_LIBRARY_PATH() changes the
+// search path, so it invalidates the cache. If the listing doesn't fit in the
+// cache, we give up and always probe.
+#define LIBRARY_DIR_CACHE_SIZE        2048 // Must be a power of two.
+#define LIBRARY_DIR_CACHE_NAMES_SIZE  (64 * 1024)
+#define LIBRARY_DIR_MAX               (LDPATH_MAX + 2) // LD_LIBRARY_PATH and gSoPaths.
+
+struct library_dir_cache_entry_t {
+  uint32_t hash;
+  uint32_t name_offset; // Offset of the name in gLibraryDirCacheNames.
+  uint32_t dirs;        // Bit i is set if gLibraryDirs[i] contains the name; 0 if unused.
+};
+
+enum LibraryDirCacheState {
+  kLibraryDirCacheStale = 0,
+  kLibraryDirCacheValid,
+  kLibraryDirCacheDisabled,
+};
+
+static LibraryDirCacheState gLibraryDirCacheState;
+static library_dir_cache_entry_t gLibraryDirCache[LIBRARY_DIR_CACHE_SIZE];
+static char gLibraryDirCacheNames[LIBRARY_DIR_CACHE_NAMES_SIZE];
+static size_t gLibraryDirCacheNamesUsed;
+// The search path, in order, at the time the cache was built.
+static const char* gLibraryDirs[LIBRARY_DIR_MAX + 1];
+
+static inline void library_dir_cache_invalidate() {
+  gLibraryDirCacheState = kLibraryDirCacheStale;
+}
+
+// Returns the entry for 'name', or the empty slot where it belongs, or NULL
+// if the table is full.
+static library_dir_cache_entry_t* library_dir_cache_probe(const char* name, uint32_t hash) {
+  for (size_t probe = 0; probe < LIBRARY_DIR_CACHE_SIZE; ++probe) {
+    library_dir_cache_entry_t* entry =
+        &gLibraryDirCache[(hash + probe) & (LIBRARY_DIR_CACHE_SIZE - 1)];
+    if (entry->dirs == 0 ||
+        (entry->hash == hash && strcmp(&gLibraryDirCacheNames[entry->name_offset], name) == 0)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static bool library_dir_cache_add(const char* name, size_t dir_index) {
+  uint32_t hash = SymbolName(name).gnu_hash();
+  library_dir_cache_entry_t* entry = library_dir_cache_probe(name, hash);
+  if (entry == NULL) {
+    return false;
+  }
+  if (entry->dirs == 0) {
+    size_t size = strlen(name) + 1;
+    if (sizeof(gLibraryDirCacheNames) - gLibraryDirCacheNamesUsed < size) {
+      return false;
+    }
+    memcpy(&gLibraryDirCacheNames[gLibraryDirCacheNamesUsed], name, size);
+    entry->hash = hash;
+    entry->name_offset = gLibraryDirCacheNamesUsed;
+    gLibraryDirCacheNamesUsed += size;
+  }
+  entry->dirs |= (1U << dir_index);
+  return true;
+}
+
+// Adds the contents of gLibraryDirs[dir_index] to the cache. A directory
+// that doesn't exist is simply empty.
+static bool library_dir_cache_scan(size_t dir_index) {
+  int fd = TEMP_FAILURE_RETRY(open(gLibraryDirs[dir_index], O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  if (fd == -1) {
+    return (errno == ENOENT || errno == ENOTDIR);
+  }
+
+  bool ok = true;
+  char buf[4096] __attribute__((aligned(8)));
+  int n;
+  while (ok && (n = getdents(fd, reinterpret_cast<dirent*>(buf), sizeof(buf))) > 0) {
+    for (int offset = 0; ok && offset < n; ) {
+      dirent* entry = reinterpret_cast<dirent*>(buf + offset);
+      offset += entry->d_reclen;
+      if (entry->d_type != DT_DIR) {
+        ok = library_dir_cache_add(entry->d_name, dir_index);
+      }
+    }
+  }
+  close(fd);
+  return ok && n == 0;
+}
+
+static void library_dir_cache_build() {
+  memset(gLibraryDirCache, 0, sizeof(gLibraryDirCache));
+  gLibraryDirCacheNamesUsed = 0;
+
+  size_t count = 0;
+  for (size_t i = 0; gLdPaths[i] != NULL; ++i) {
+    gLibraryDirs[count++] = gLdPaths[i];
+  }
+  for (size_t i = 0; gSoPaths[i] != NULL; ++i) {
+    gLibraryDirs[count++] = gSoPaths[i];
+  }
+  gLibraryDirs[count] = NULL;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!library_dir_cache_scan(i)) {
+      DEBUG("couldn't cache the contents of \"%s\"; searching without a cache",
+            gLibraryDirs[i]);
+      gLibraryDirCacheState = kLibraryDirCacheDisabled;
+      return;
+    }
+  }
+  gLibraryDirCacheState = kLibraryDirCacheValid;
+}
+
+// Returns an fd for 'name' from the first search directory the cache says
+// contains it, or -1 if the cache doesn't know about it.
+static int library_dir_cache_open(const char* name) {
+  if (gLibraryDirCacheState == kLibraryDirCacheStale) {
+    library_dir_cache_build();
+  }
+  if (gLibraryDirCacheState != kLibraryDirCacheValid) {
+    return -1;
+  }
+
+  library_dir_cache_entry_t* entry = library_dir_cache_probe(name, SymbolName(name).gnu_hash());
+  if (entry == NULL || entry->dirs == 0) {
+    return -1;
+  }
+  for (size_t i = 0; gLibraryDirs[i] != NULL; ++i) {
+    if ((entry->dirs & (1U << i)) != 0) {
+      int fd = open_library_in_dir(gLibraryDirs[i], name);
+      if (fd != -1) {
+        return fd;
+      }
+    }
+  }
+  return -1;
+}
+
+// Returns the fd opened for 'name' by library_manifest_prefetch, or -1. The
+// caller owns the fd.
+static int library_manifest_take(const char* name) {
+  for (size_t i = 0; i < gLdManifestCount; ++i) {
+    if (gLdManifest[i].fd != -1 && strcmp(gLdManifest[i].name, name) == 0) {
+      int fd = gLdManifest[i].fd;
+      gLdManifest[i].fd = -1;
+      return fd;
+    }
+  }
+  return -1;
+}
+
 static int open_library(const char* name) {
   TRACE("[ opening %s ]", name);
 
+  int fd = library_manifest_take(name);
+  if (fd != -1) {
+    return fd;
+  }
+
   // If the name contains a slash, we should attempt to open it directly and not search the paths.
   if (strchr(name, '/') != NULL) {
     int fd = TEMP_FAILURE_RETRY(open(name, O_RDONLY | O_CLOEXEC));
@@ -692,26 +1673,148 @@ static int open_library(const char* name) {
   }
 
   // Otherwise we try LD_LIBRARY_PATH first, and fall back to the built-in well known paths.
-  int fd = open_library_on_path(name, gLdPaths);
+  // Usually the directory cache knows which one to open.
+  fd = library_dir_cache_open(name);
+  if (fd == -1) {
+    fd = open_library_on_path(name, gLdPaths);
+  }
   if (fd == -1) {
     fd = open_library_on_path(name, gSoPaths);
   }
   return fd;
 }
 
-static soinfo* load_library(const char* name) {
-    // Open the file.
+// LD_LIBRARY_MANIFEST names a file listing the libraries the process is going
+// to load, one per line, spelled as they'll be asked for (usually just the
+// name, as in DT_NEEDED). Blank lines and lines starting with '#' are ignored.
+//
+// Loading is otherwise a sequence of opens and reads that each wait for the
+// disk in turn. So before linking the executable we open every library in the
+// manifest and ask the kernel to start reading all of them in. The readahead
+// is asynchronous, so the I/O for different libraries overlaps, and by the
+// time DT_NEEDED processing gets to a library it's usually in the page cache.
+// open_library() then reuses the fd we already have.
+static void library_manifest_prefetch(const char* path) {
+  if (path == NULL || *path == '\0') {
+    return;
+  }
+
+  long long start_us = gLdStats ? linker_stats_now_us() : 0;
+
+  int manifest_fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+  if (manifest_fd == -1) {
+    DL_WARN("couldn't open LD_LIBRARY_MANIFEST \"%s\": %s", path, strerror(errno));
+    return;
+  }
+  size_t len = 0;
+  while (len < sizeof(gLdManifestBuffer) - 1) {
+    ssize_t n = TEMP_FAILURE_RETRY(read(manifest_fd, gLdManifestBuffer + len,
+                                        sizeof(gLdManifestBuffer) - 1 - len));
+    if (n <= 0) {
+      break;
+    }
+    len += n;
+  }
+  close(manifest_fd);
+  gLdManifestBuffer[len] = '\0';
+
+  size_t listed = 0;
+  char* line = gLdManifestBuffer;
+  while (line != NULL) {
+    char* end = strchr(line, '\n');
+    if (end != NULL) {
+      *end++ = '\0';
+    }
+    const char* name = line;
+    line = end;
+
+    if (*name == '\0' || *name == '#') {
+      continue;
+    }
+    ++listed;
+    if (gLdManifestCount == LDMANIFEST_MAX) {
+      continue;
+    }
+
     int fd = open_library(name);
     if (fd == -1) {
-        DL_ERR("library \"%s\" not found", name);
-        return NULL;
+      DEBUG("LD_LIBRARY_MANIFEST library \"%s\" not found", name);
+      continue;
+    }
+
+    // Mapping the whole file and dropping the mapping again is the cheapest
+    // way to start asynchronous readahead of it.
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+      void* map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        madvise(map, sb.st_size, MADV_WILLNEED);
+        munmap(map, sb.st_size);
+      }
+    }
+
+    gLdManifest[gLdManifestCount].name = name;
+    gLdManifest[gLdManifestCount].fd = fd;
+    ++gLdManifestCount;
+  }
+
+  STATS_PRINT("%s: opened %d of %d manifest libraries in %lld us",
+              path, gLdManifestCount, listed, linker_stats_now_us() - start_us);
+}
+
+// Closes the fds of any manifest libraries that weren't loaded at startup.
+static void library_manifest_close() {
+  for (size_t i = 0; i < gLdManifestCount; ++i) {
+    if (gLdManifest[i].fd != -1) {
+      DEBUG("LD_LIBRARY_MANIFEST library \"%s\" wasn't needed", gLdManifest[i].name);
+      close(gLdManifest[i].fd);
+    }
+  }
+  gLdManifestCount = 0;
+}
+
+// Releases the address space occupied by a library. If it was reserved by
+// the caller of android_dlopen_ext(3), it is replaced by an inaccessible
+// anonymous mapping instead, so the reservation stays in place.
+static void soinfo_unmap(soinfo* si) {
+  // Make sure no lock-free reader is still looking at it first.
+  loaded_objects_publish(si);
+
+  void* start = reinterpret_cast<void*>(si->base);
+  if ((si->flags & FLAG_RESERVED) != 0) {
+    mmap(start, si->size, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  } else {
+    munmap(start, si->size);
+  }
+}
+
+static soinfo* load_library(const char* name, const android_dlextinfo* extinfo) {
+    // Open the file, unless the caller of android_dlopen_ext(3) already did.
+    int fd;
+    bool own_fd = true;
+    if (extinfo != NULL && (extinfo->flags & ANDROID_DLEXT_USE_LIBRARY_FD) != 0) {
+        fd = extinfo->library_fd;
+        own_fd = false;
+    } else {
+        fd = open_library(name);
+        if (fd == -1) {
+            DL_ERR("library \"%s\" not found", name);
+            return NULL;
+        }
     }
 
     // Read the ELF header and load the segments.
     ElfReader elf_reader(name, fd);
-    if (!elf_reader.Load()) {
+    bool loaded = elf_reader.Load(extinfo);
+    if (own_fd) {
+        close(fd);
+    }
+    if (!loaded) {
         return NULL;
     }
+    STATS_PRINT("%s: read ELF header %lld us, reserve address space %lld us, load segments %lld us",
+                name, elf_reader.read_time_us(), elf_reader.reserve_time_us(),
+                elf_reader.load_time_us());
 
     const char* bname = strrchr(name, '/');
     soinfo* si = soinfo_alloc(bname ? bname + 1 : name);
@@ -721,11 +1824,16 @@ static soinfo* load_library(const char* name) {
     si->base = elf_reader.load_start();
     si->size = elf_reader.load_size();
     si->load_bias = elf_reader.load_bias();
-    si->flags = 0;
+    si->flags = elf_reader.loaded_in_reserved_space() ? FLAG_RESERVED : 0;
     si->entry = 0;
     si->dynamic = NULL;
     si->phnum = elf_reader.phdr_count();
     si->phdr = elf_reader.loaded_phdr();
+    if (!soinfo_index_add_address(si)) {
+        soinfo_unmap(si);
+        soinfo_free(si);
+        return NULL;
+    }
     return si;
 }
 
@@ -740,7 +1848,7 @@ static soinfo *find_loaded_library(const char *name)
     bname = strrchr(name, '/');
     bname = bname ? bname + 1 : name;
 
-    for (si = solist; si != NULL; si = si->next) {
+    for (si = *soinfo_name_bucket(bname); si != NULL; si = si->name_hash_next) {
         if (!strcmp(bname, si->name)) {
             return si;
         }
@@ -748,7 +1856,8 @@ static soinfo *find_loaded_library(const char *name)
     return NULL;
 }
 
-static soinfo* find_library_internal(const char* name) {
+static soinfo* find_library_internal(const char* name, int rtld_flags,
+                                     const android_dlextinfo* extinfo) {
   if (name == NULL) {
     return somain;
   }
@@ -763,7 +1872,7 @@ static soinfo* find_library_internal(const char* name) {
   }
 
   TRACE("[ '%s' has not been loaded yet.  Locating...]", name);
-  si = load_library(name);
+  si = load_library(name, extinfo);
   if (si == NULL) {
     return NULL;
   }
@@ -773,37 +1882,127 @@ static soinfo* find_library_internal(const char* name) {
   TRACE("[ init_library base=0x%08x sz=0x%08x name='%s' ]",
         si->base, si->size, si->name);
 
-  if (!soinfo_link_image(si)) {
-    munmap(reinterpret_cast<void*>(si->base), si->size);
-    soinfo_free(si);
-    return NULL;
+  if (!soinfo_link_image(si, rtld_flags, extinfo)) {
+    soinfo_unmap(si);
+    soinfo_free(si);
+    return NULL;
+  }
+
+  return si;
+}
+
+static soinfo* find_library(const char* name, int rtld_flags,
+                            const android_dlextinfo* extinfo) {
+  soinfo* si = find_library_internal(name, rtld_flags, extinfo);
+  if (si != NULL) {
+    si->ref_count++;
+  }
+  return si;
+}
+
+// Only the first 32 DT_NEEDED entries of an object can be deferred.
+#define LAZY_NEEDED_MAX 32
+
+// Returns true if 'si''s 'index'th DT_NEEDED library was deferred and hasn't been loaded yet.
+static bool soinfo_needed_is_pending(const soinfo* si, size_t index) {
+  return index < LAZY_NEEDED_MAX && (si->lazy_needed & (1U << index)) != 0;
+}
+
+static bool is_lazy_needed_name(const char* name) {
+  const char* bname = strrchr(name, '/');
+  bname = bname ? bname + 1 : name;
+  for (size_t i = 0; gLdLazyNeededNames[i] != NULL; ++i) {
+    if (strcmp(bname, gLdLazyNeededNames[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Called when a non-weak reference from 'si' can't be resolved but some of
+ * its DT_NEEDED libraries were deferred. Loads them in DT_NEEDED order until
+ * one of them lets the lookup succeed, appending each to 'needed' (which must
+ * have room for all of si's DT_NEEDED libraries) and updating 'scope' to
+ * match. Libraries loaded after si's constructors ran are constructed here.
+ * Returns false if a library couldn't be loaded; otherwise '*s' is the symbol
+ * or NULL if even the last deferred library didn't define it.
+ */
+static bool soinfo_load_lazy_needed(soinfo* si, const char* name, const version_info* version,
+                                    Elf32_Sym** s, soinfo** lsi, soinfo* needed[], int* scope) {
+  size_t count = 0;
+  while (needed[count] != NULL) {
+    ++count;
   }
 
-  return si;
-}
+  *s = NULL;
+  size_t needed_index = 0;
+  for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL && si->lazy_needed != 0; ++d) {
+    if (d->d_tag != DT_NEEDED || !soinfo_needed_is_pending(si, needed_index++)) {
+      continue;
+    }
+    si->lazy_needed &= ~(1U << (needed_index - 1));
 
-static soinfo* find_library(const char* name) {
-  soinfo* si = find_library_internal(name);
-  if (si != NULL) {
-    si->ref_count++;
+    const char* library_name = si->strtab + d->d_un.d_val;
+    DEBUG("%s: loading deferred %s to look for %s", si->name, library_name, name);
+    soinfo* lazy_si = find_library(library_name, RTLD_NOW, NULL);
+    if (lazy_si == NULL) {
+      strlcpy(tmp_err_buf, linker_get_error_buffer(), sizeof(tmp_err_buf));
+      DL_ERR("could not load library \"%s\" needed by \"%s\"; caused by %s",
+             library_name, si->name, tmp_err_buf);
+      return false;
+    }
+    needed[count++] = lazy_si;
+    needed[count] = NULL;
+    *scope = lookup_scope_intern(needed);
+
+    if (si->constructors_called) {
+      if (gLoadedObjectsChanged) {
+        loaded_objects_publish(NULL);
+      }
+      lazy_si->CallConstructors();
+    }
+
+    *s = soinfo_do_lookup(si, name, version, lsi, needed, *scope);
+    if (*s != NULL) {
+      return true;
+    }
   }
-  return si;
+  return true;
 }
 
 static int soinfo_unload(soinfo* si) {
+  // References are interchangeable, so drop a lock-free one if there is one.
+  volatile int* fast_refs = soinfo_fast_refs(si);
+  if (fast_refs != NULL) {
+    int count;
+    while ((count = *fast_refs) > 0) {
+      if (__atomic_cmpxchg(count, count - 1, fast_refs) == 0) {
+        TRACE("not unloading '%s', decrementing lock-free ref_count to %d", si->name, count - 1);
+        return 0;
+      }
+    }
+  }
+
   if (si->ref_count == 1) {
+    // Stop do_dlopen_loaded() handing out new references. If it got one in
+    // first, drop that instead.
+    if (fast_refs != NULL && __atomic_cmpxchg(0, -1, fast_refs) != 0) {
+      return soinfo_unload(si);
+    }
+
     TRACE("unloading '%s'", si->name);
     si->CallDestructors();
 
+    size_t needed_index = 0;
     for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
-      if (d->d_tag == DT_NEEDED) {
+      if (d->d_tag == DT_NEEDED && !soinfo_needed_is_pending(si, needed_index++)) {
         const char* library_name = si->strtab + d->d_un.d_val;
         TRACE("%s needs to unload %s", si->name, library_name);
         soinfo_unload(find_loaded_library(library_name));
       }
     }
 
-    munmap(reinterpret_cast<void*>(si->base), si->size);
+    soinfo_unmap(si);
     notify_gdb_of_unload(si);
     soinfo_free(si);
     si->ref_count = 0;
@@ -817,16 +2016,59 @@ static int soinfo_unload(soinfo* si) {
 void do_android_update_LD_LIBRARY_PATH(const char* ld_library_path) {
   if (!get_AT_SECURE()) {
     parse_LD_LIBRARY_PATH(ld_library_path);
+    library_dir_cache_invalidate();
+  }
+}
+
+// dlopen(3) of a library that's already loaded and constructed only needs
+// another reference, so it doesn't take the dl lock and wait behind genuine
+// loads. Returns NULL if the caller should take the lock and call do_dlopen.
+soinfo* do_dlopen_loaded(const char* name, int flags, const android_dlextinfo* extinfo) {
+  if (name == NULL || extinfo != NULL ||
+      (flags & ~(RTLD_NOW|RTLD_LAZY|RTLD_LOCAL|RTLD_GLOBAL)) != 0) {
+    return NULL;
+  }
+
+  ScopedLoadedObjectsReader reader;
+  const loaded_objects_t* snapshot = gLoadedObjects;
+  if (snapshot == NULL) {
+    return NULL;
+  }
+
+  const char* bname = strrchr(name, '/');
+  soinfo* si = loaded_objects_find_by_name(snapshot, bname ? bname + 1 : name);
+  if (si == NULL || (si->flags & FLAG_CONSTRUCTED) == 0) {
+    return NULL;
+  }
+
+  volatile int* fast_refs = soinfo_fast_refs(si);
+  if (fast_refs == NULL) {
+    return NULL;
   }
+  int count;
+  do {
+    count = *fast_refs;
+    if (count < 0) {
+      return NULL; // It's being unloaded.
+    }
+  } while (__atomic_cmpxchg(count, count + 1, fast_refs) != 0);
+  return si;
 }
 
-soinfo* do_dlopen(const char* name, int flags) {
+soinfo* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo) {
   if ((flags & ~(RTLD_NOW|RTLD_LAZY|RTLD_LOCAL|RTLD_GLOBAL)) != 0) {
     DL_ERR("invalid flags to dlopen: %x", flags);
     return NULL;
   }
+  if (extinfo != NULL && ((extinfo->flags & ~(ANDROID_DLEXT_VALID_FLAG_BITS)) != 0)) {
+    DL_ERR("invalid extended flags to android_dlopen_ext: %llx", extinfo->flags);
+    return NULL;
+  }
   set_soinfo_pool_protection(PROT_READ | PROT_WRITE);
-  soinfo* si = find_library(name);
+  soinfo* si = find_library(name, flags, extinfo);
+  if (gLoadedObjectsChanged) {
+    loaded_objects_publish(NULL);
+  }
   if (si != NULL) {
     si->CallConstructors();
   }
@@ -841,12 +2083,46 @@ int do_dlclose(soinfo* si) {
   return result;
 }
 
+#if defined(ANDROID_ARM_LINKER)
+#define R_RELATIVE R_ARM_RELATIVE
+#elif defined(ANDROID_X86_LINKER)
+#define R_RELATIVE R_386_RELATIVE
+#endif
+
+#if defined(R_RELATIVE)
+/* Applies the run of symbol-less RELATIVE relocations starting at 'rel',
+ * stopping at the first other relocation or after 'count' entries, and
+ * returns how many it applied. Static linkers sort RELATIVE relocations to
+ * the front of DT_REL (-z combreloc), and they're most of the relocations in
+ * a typical library, so this avoids the general path's per-relocation
+ * dispatch and bookkeeping for them. The targets are scattered, so there's
+ * nothing for SIMD to do: the loop is bound by the stores.
+ */
+static size_t soinfo_relocate_relative_run(soinfo* si, const Elf32_Rel* rel, size_t count) {
+    const Elf32_Addr load_bias = si->load_bias;
+    size_t n = 0;
+    while (n < count && rel[n].r_info == R_RELATIVE) {
+        ++n;
+    }
+    // Nothing to do (and no page to dirty) at the link address.
+    if (load_bias != 0) {
+        for (size_t i = 0; i < n; ++i) {
+            MARK(rel[i].r_offset);
+            *reinterpret_cast<Elf32_Addr*>(rel[i].r_offset + load_bias) += load_bias;
+        }
+    }
+    TRACE_TYPE(RELO, "RELO RELATIVE x%d <- +%08x", n, load_bias);
+    count_relocation(kRelocRelative, n);
+    return n;
+}
+#endif
+
 /* TODO: don't use unsigned for addrs below. It works, but is not
  * ideal. They should probably be either uint32_t, Elf32_Addr, or unsigned
  * long.
  */
 static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
-                           soinfo* needed[])
+                           soinfo* needed[], int* scope)
 {
     Elf32_Sym* symtab = si->symtab;
     const char* strtab = si->strtab;
@@ -855,6 +2131,14 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
     soinfo* lsi;
 
     for (size_t idx = 0; idx < count; ++idx, ++rel) {
+#if defined(R_RELATIVE)
+        if (rel->r_info == R_RELATIVE) {
+            size_t n = soinfo_relocate_relative_run(si, rel, count - idx);
+            idx += n - 1;
+            rel += n - 1;
+            continue;
+        }
+#endif
         unsigned type = ELF32_R_TYPE(rel->r_info);
         unsigned sym = ELF32_R_SYM(rel->r_info);
         Elf32_Addr reloc = static_cast<Elf32_Addr>(rel->r_offset + si->load_bias);
@@ -867,7 +2151,15 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
         }
         if (sym != 0) {
             sym_name = (char *)(strtab + symtab[sym].st_name);
-            s = soinfo_do_lookup(si, sym_name, &lsi, needed);
+            version_info version_storage;
+            const version_info* version = soinfo_symbol_version(si, sym, &version_storage);
+            s = soinfo_do_lookup(si, sym_name, version, &lsi, needed, *scope);
+            if (s == NULL && si->lazy_needed != 0 &&
+                ELF32_ST_BIND(symtab[sym].st_info) != STB_WEAK) {
+                if (!soinfo_load_lazy_needed(si, sym_name, version, &s, &lsi, needed, scope)) {
+                    return -1;
+                }
+            }
             if (s == NULL) {
                 /* We only allow an undefined symbol if this is a weak
                    reference..   */
@@ -992,7 +2284,7 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
             if (s) {
                 *reinterpret_cast<Elf32_Addr*>(reloc) += sym_addr;
             } else {
-                *reinterpret_cast<Elf32_Addr*>(reloc) += si->base;
+                *reinterpret_cast<Elf32_Addr*>(reloc) += si->load_bias;
             }
             break;
 #endif /* ANDROID_*_LINKER */
@@ -1008,8 +2300,11 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
                 DL_ERR("odd RELATIVE form...");
                 return -1;
             }
-            TRACE_TYPE(RELO, "RELO RELATIVE %08x <- +%08x", reloc, si->base);
-            *reinterpret_cast<Elf32_Addr*>(reloc) += si->base;
+            TRACE_TYPE(RELO, "RELO RELATIVE %08x <- +%08x", reloc, si->load_bias);
+            // Nothing to do (and no page to dirty) at the link address.
+            if (si->load_bias != 0) {
+                *reinterpret_cast<Elf32_Addr*>(reloc) += si->load_bias;
+            }
             break;
 
 #if defined(ANDROID_X86_LINKER)
@@ -1030,6 +2325,62 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
             break;
 #endif /* ANDROID_X86_LINKER */
 
+        // General- and local-dynamic TLS: the module id and the offset in its
+        // block passed to __tls_get_addr. A local-dynamic DTPMOD32 has no symbol
+        // and refers to this object's own module.
+#if defined(ANDROID_ARM_LINKER)
+        case R_ARM_TLS_DTPMOD32:
+#elif defined(ANDROID_X86_LINKER)
+        case R_386_TLS_DTPMOD32:
+#endif
+#if defined(ANDROID_ARM_LINKER) || defined(ANDROID_X86_LINKER)
+            {
+                soinfo* tls_si = (sym != 0) ? lsi : si;
+                count_relocation(kRelocAbsolute);
+                MARK(rel->r_offset);
+                if (tls_si->tls_module_id == 0) {
+                    DL_ERR("TLS relocation in \"%s\" against \"%s\", which has no TLS segment",
+                           si->name, tls_si->name);
+                    return -1;
+                }
+                TRACE_TYPE(RELO, "RELO TLS_DTPMOD32 %08x <- %d %s",
+                           reloc, tls_si->tls_module_id, sym_name);
+                *reinterpret_cast<Elf32_Addr*>(reloc) = tls_si->tls_module_id;
+            }
+            break;
+#endif
+
+#if defined(ANDROID_ARM_LINKER)
+        case R_ARM_TLS_DTPOFF32:
+#elif defined(ANDROID_X86_LINKER)
+        case R_386_TLS_DTPOFF32:
+#endif
+#if defined(ANDROID_ARM_LINKER) || defined(ANDROID_X86_LINKER)
+            count_relocation(kRelocAbsolute);
+            MARK(rel->r_offset);
+            // A TLS symbol's value is its offset in its module's block, not an address.
+            TRACE_TYPE(RELO, "RELO TLS_DTPOFF32 %08x <- +%08x %s",
+                       reloc, (s != NULL) ? s->st_value : 0, sym_name);
+            if (s != NULL) {
+                *reinterpret_cast<Elf32_Addr*>(reloc) += s->st_value;
+            }
+            break;
+#endif
+
+        // Initial- and local-exec TLS need a static TLS block at a fixed
+        // offset from the thread pointer, which we don't have.
+#if defined(ANDROID_ARM_LINKER)
+        case R_ARM_TLS_TPOFF32:
+#elif defined(ANDROID_X86_LINKER)
+        case R_386_TLS_TPOFF:
+        case R_386_TLS_TPOFF32:
+#endif
+#if defined(ANDROID_ARM_LINKER) || defined(ANDROID_X86_LINKER)
+            DL_ERR("\"%s\" uses static TLS (reloc type %d), which isn't supported; "
+                   "build it with -ftls-model=global-dynamic", si->name, type);
+            return -1;
+#endif
+
 #ifdef ANDROID_ARM_LINKER
         case R_ARM_COPY:
             if ((si->flags & FLAG_EXE) == 0) {
@@ -1051,7 +2402,9 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
             MARK(rel->r_offset);
             TRACE_TYPE(RELO, "RELO %08x <- %d @ %08x %s", reloc, s->st_size, sym_addr, sym_name);
             if (reloc == sym_addr) {
-                Elf32_Sym *src = soinfo_do_lookup(NULL, sym_name, &lsi, needed);
+                version_info version_storage;
+                const version_info* version = soinfo_symbol_version(si, sym, &version_storage);
+                Elf32_Sym *src = soinfo_do_lookup(NULL, sym_name, version, &lsi, needed, *scope);
 
                 if (src == NULL) {
                     DL_ERR("%s R_ARM_COPY relocation source cannot be resolved", si->name);
@@ -1084,8 +2437,169 @@ static int soinfo_relocate(soinfo* si, Elf32_Rel* rel, unsigned count,
     return 0;
 }
 
+/* Apply the compact relative relocations in DT_RELR. Each entry is either
+ * an even word, which is the address of a word to relocate, or an odd word,
+ * which is a bitmap: bit i (counting from 1) set means relocate the i-th
+ * word after the last address, and the next bitmap carries on 31 words
+ * further along. There's no symbol involved, so -- unlike DT_REL --
+ * this is just a tight loop adding the load bias.
+ */
+static void soinfo_relocate_relr(soinfo* si) {
+    const Elf32_Addr load_bias = si->load_bias;
+    const size_t bits_per_entry = 8 * sizeof(Elf32_Relr) - 1;
+    Elf32_Addr* where = NULL;
+
+    for (size_t idx = 0; idx < si->relr_count; ++idx) {
+        Elf32_Relr entry = si->relr[idx];
+        if ((entry & 1) == 0) {
+            where = reinterpret_cast<Elf32_Addr*>(load_bias + entry);
+            *where++ += load_bias;
+            count_relocation(kRelocRelative);
+            MARK(entry);
+        } else {
+            Elf32_Addr* p = where;
+            for (Elf32_Relr bitmap = entry >> 1; bitmap != 0; bitmap >>= 1, ++p) {
+                if ((bitmap & 1) != 0) {
+                    *p += load_bias;
+                    count_relocation(kRelocRelative);
+                }
+            }
+            where += bits_per_entry;
+        }
+    }
+}
+
+#if defined(ANDROID_ARM_LINKER) || defined(ANDROID_X86_LINKER)
+
+#if defined(ANDROID_ARM_LINKER)
+#define R_JUMP_SLOT R_ARM_JUMP_SLOT
+#elif defined(ANDROID_X86_LINKER)
+#define R_JUMP_SLOT R_386_JMP_SLOT
+#endif
+
+// In arch/*/lazy_bind.S. PLT0 jumps here via GOT[2] the first time any PLT
+// entry is called.
+extern "C" void linker_lazy_bind_trampoline();
+
+/* Lazy binding works only if every PLT relocation is a JUMP_SLOT (whose GOT
+ * entry initially points back into the PLT) and the GOT stays writable after
+ * linking. An object linked with -z now has its GOT in the PT_GNU_RELRO
+ * segment, but it should also have DT_BIND_NOW, which we check separately.
+ */
+static bool soinfo_can_bind_lazily(soinfo* si) {
+    if (si->plt_got == NULL) {
+        return false;
+    }
+    for (size_t idx = 0; idx < si->plt_rel_count; ++idx) {
+        Elf32_Rel* rel = &si->plt_rel[idx];
+        if (ELF32_R_TYPE(rel->r_info) != R_JUMP_SLOT) {
+            return false;
+        }
+        if (phdr_table_is_in_gnu_relro(si->phdr, si->phnum, si->load_bias,
+                                       rel->r_offset + si->load_bias)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Point each JUMP_SLOT at its PLT stub, and fill in the two reserved GOT
+ * entries PLT0 uses: GOT[1] is passed to the trampoline to identify the
+ * object, and GOT[2] is the trampoline itself.
+ */
+static bool soinfo_prepare_lazy_plt(soinfo* si) {
+    for (size_t idx = 0; idx < si->plt_rel_count; ++idx) {
+        Elf32_Rel* rel = &si->plt_rel[idx];
+        Elf32_Addr reloc = static_cast<Elf32_Addr>(rel->r_offset + si->load_bias);
+        count_relocation(kRelocRelative);
+        MARK(rel->r_offset);
+        *reinterpret_cast<Elf32_Addr*>(reloc) += si->load_bias;
+    }
+    si->plt_got[1] = reinterpret_cast<unsigned>(si);
+    si->plt_got[2] = reinterpret_cast<unsigned>(&linker_lazy_bind_trampoline);
+    return true;
+}
+
+/* Resolves the PLT relocation 'rel_offset' bytes into si->plt_rel, patches
+ * the corresponding GOT entry, and returns the address to jump to. Called
+ * with the dlopen(3) lock held, which keeps the soinfo list stable; the GOT
+ * entry is a single aligned word, so other threads calling through the same
+ * PLT entry see either the PLT stub or the final address. If the symbol
+ * is in one of si's deferred DT_NEEDED libraries, this is where it's loaded
+ * and constructed; the lock is recursive, so its constructors can dlopen(3).
+ */
+Elf32_Addr soinfo_lazy_bind(soinfo* si, Elf32_Word rel_offset) {
+    if (rel_offset % sizeof(Elf32_Rel) != 0 ||
+        rel_offset / sizeof(Elf32_Rel) >= si->plt_rel_count) {
+        __libc_fatal("\"%s\": invalid lazy binding relocation offset %d", si->name, rel_offset);
+    }
+    Elf32_Rel* rel = reinterpret_cast<Elf32_Rel*>(reinterpret_cast<char*>(si->plt_rel) + rel_offset);
+    unsigned sym = ELF32_R_SYM(rel->r_info);
+    Elf32_Addr reloc = static_cast<Elf32_Addr>(rel->r_offset + si->load_bias);
+    const char* sym_name = si->strtab + si->symtab[sym].st_name;
+
+    // We didn't keep the DT_NEEDED list from soinfo_link_image(), so rebuild it.
+    size_t needed_count = 0;
+    for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
+        if (d->d_tag == DT_NEEDED) {
+            ++needed_count;
+        }
+    }
+    soinfo** needed = reinterpret_cast<soinfo**>(alloca((1 + needed_count) * sizeof(soinfo*)));
+    soinfo** pneeded = needed;
+    size_t needed_index = 0;
+    for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
+        if (d->d_tag == DT_NEEDED && !soinfo_needed_is_pending(si, needed_index++)) {
+            soinfo* lsi = find_loaded_library(si->strtab + d->d_un.d_val);
+            if (lsi != NULL) {
+                *pneeded++ = lsi;
+            }
+        }
+    }
+    *pneeded = NULL;
+
+    soinfo* lsi;
+    Elf32_Addr sym_addr = 0;
+    version_info version_storage;
+    const version_info* version = soinfo_symbol_version(si, sym, &version_storage);
+    int scope = lookup_scope_intern(needed);
+    Elf32_Sym* s = soinfo_do_lookup(si, sym_name, version, &lsi, needed, scope);
+    if (s == NULL && si->lazy_needed != 0 &&
+        ELF32_ST_BIND(si->symtab[sym].st_info) != STB_WEAK) {
+        set_soinfo_pool_protection(PROT_READ | PROT_WRITE);
+        bool loaded = soinfo_load_lazy_needed(si, sym_name, version, &s, &lsi, needed, &scope);
+        set_soinfo_pool_protection(PROT_READ);
+        if (!loaded) {
+            __libc_fatal("%s", linker_get_error_buffer());
+        }
+    }
+    if (s != NULL) {
+        sym_addr = static_cast<Elf32_Addr>(s->st_value + lsi->load_bias);
+    } else if (ELF32_ST_BIND(si->symtab[sym].st_info) != STB_WEAK) {
+        // There's no caller to return an error to.
+        __libc_fatal("cannot locate symbol \"%s\" referenced by \"%s\"...", sym_name, si->name);
+    }
+    count_relocation(kRelocSymbol);
+
+    TRACE_TYPE(RELO, "RELO LAZY JMP_SLOT %08x <- %08x %s", reloc, sym_addr, sym_name);
+    *reinterpret_cast<volatile Elf32_Addr*>(reloc) = sym_addr;
+    return sym_addr;
+}
+
+#else
+
+static bool soinfo_can_bind_lazily(soinfo*) {
+    return false;
+}
+
+static bool soinfo_prepare_lazy_plt(soinfo*) {
+    return false;
+}
+
+#endif
+
 #ifdef ANDROID_MIPS_LINKER
-static bool mips_relocate_got(soinfo* si, soinfo* needed[]) {
+static bool mips_relocate_got(soinfo* si, soinfo* needed[], int scope) {
     unsigned* got = si->plt_got;
     if (got == NULL) {
         return true;
@@ -1127,7 +2641,9 @@ static bool mips_relocate_got(soinfo* si, soinfo* needed[]) {
 
         /* This is an undefined reference... try to locate it */
         sym_name = si->strtab + sym->st_name;
-        s = soinfo_do_lookup(si, sym_name, &lsi, needed);
+        version_info version_storage;
+        const version_info* version = soinfo_symbol_version(si, g, &version_storage);
+        s = soinfo_do_lookup(si, sym_name, version, &lsi, needed, scope);
         if (s == NULL) {
             /* We only allow an undefined symbol if this is a weak
                reference..   */
@@ -1212,21 +2728,43 @@ void soinfo::CallConstructors() {
           name, preinit_array_count);
   }
 
+  // For LD_STATS: the longest chain of DT_NEEDED constructors ours wait for.
+  long long needed_path_us = 0;
   if (dynamic != NULL) {
+    size_t needed_index = 0;
     for (Elf32_Dyn* d = dynamic; d->d_tag != DT_NULL; ++d) {
-      if (d->d_tag == DT_NEEDED) {
+      if (d->d_tag == DT_NEEDED && !soinfo_needed_is_pending(this, needed_index++)) {
         const char* library_name = strtab + d->d_un.d_val;
         TRACE("\"%s\": calling constructors in DT_NEEDED \"%s\"", name, library_name);
-        find_loaded_library(library_name)->CallConstructors();
+        soinfo* needed = find_loaded_library(library_name);
+        needed->CallConstructors();
+        if (needed->constructors_path_us > needed_path_us) {
+          needed_path_us = needed->constructors_path_us;
+        }
       }
     }
   }
 
   TRACE("\"%s\": calling constructors", name);
 
+  long long start_us = gLdStats ? linker_stats_now_us() : 0;
+
   // DT_INIT should be called before DT_INIT_ARRAY if both are present.
   CallFunction("DT_INIT", init_func);
   CallArray("DT_INIT_ARRAY", init_array, init_array_count, false);
+
+  // Make the constructors' work visible before do_dlopen_loaded() can hand
+  // the library out.
+  __sync_synchronize();
+  flags |= FLAG_CONSTRUCTED;
+
+  if (__predict_false(gLdStats)) {
+    long long constructors_us = linker_stats_now_us() - start_us;
+    linker_stats.constructors_us += constructors_us;
+    constructors_path_us = needed_path_us + constructors_us;
+    STATS_PRINT("%s: constructors %lld us, %lld us including the longest dependency chain",
+                name, constructors_us, constructors_path_us);
+  }
 }
 
 void soinfo::CallDestructors() {
@@ -1300,7 +2838,7 @@ static int nullify_closed_stdio() {
     return return_value;
 }
 
-static bool soinfo_link_image(soinfo* si) {
+static bool soinfo_link_image(soinfo* si, int rtld_flags, const android_dlextinfo* extinfo) {
     /* "base" might wrap around UINT32_MAX. */
     Elf32_Addr base = si->load_bias;
     const Elf32_Phdr *phdr = si->phdr;
@@ -1334,8 +2872,17 @@ static bool soinfo_link_image(soinfo* si) {
                                     &si->ARM_exidx, &si->ARM_exidx_count);
 #endif
 
+    /* The linker itself has no TLS, so this can't happen while it's relocating itself. */
+    const Elf32_Phdr* tls_segment = phdr_table_get_tls_segment(phdr, phnum);
+    if (tls_segment != NULL && si->tls_module_id == 0) {
+        if (!tls_module_register(si, tls_segment)) {
+            return false;
+        }
+    }
+
     // Extract useful information from dynamic section.
     uint32_t needed_count = 0;
+    bool has_DT_BIND_NOW = false;
     for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
         DEBUG("d = %p, d[0](tag) = 0x%08x d[1](val) = 0x%08x", d, d->d_tag, d->d_un.d_val);
         switch(d->d_tag){
@@ -1345,6 +2892,29 @@ static bool soinfo_link_image(soinfo* si) {
             si->bucket = (unsigned *) (base + d->d_un.d_ptr + 8);
             si->chain = (unsigned *) (base + d->d_un.d_ptr + 8 + si->nbucket * 4);
             break;
+        case DT_GNU_HASH:
+            {
+              // Header: nbucket, symndx, maskwords, shift2; followed by the
+              // Bloom filter words, the buckets and the chains.
+              unsigned* header = reinterpret_cast<unsigned*>(base + d->d_un.d_ptr);
+              si->gnu_nbucket = header[0];
+              si->gnu_maskwords = header[2];
+              si->gnu_shift2 = header[3];
+              si->gnu_bloom_filter = reinterpret_cast<Elf32_Addr*>(base + d->d_un.d_ptr + 16);
+              si->gnu_bucket = reinterpret_cast<unsigned*>(si->gnu_bloom_filter + si->gnu_maskwords);
+              // The chain array only covers symbols from symndx onwards.
+              si->gnu_chain = si->gnu_bucket + si->gnu_nbucket - header[1];
+
+              if (!powerof2(si->gnu_maskwords)) {
+                DL_ERR("invalid maskwords for DT_GNU_HASH in \"%s\": 0x%x (expected power of 2)",
+                       si->name, si->gnu_maskwords);
+                return false;
+              }
+              --si->gnu_maskwords;
+
+              si->flags |= FLAG_GNU_HASH;
+            }
+            break;
         case DT_STRTAB:
             si->strtab = (const char *) (base + d->d_un.d_ptr);
             break;
@@ -1369,6 +2939,21 @@ static bool soinfo_link_image(soinfo* si) {
         case DT_RELSZ:
             si->rel_count = d->d_un.d_val / sizeof(Elf32_Rel);
             break;
+        case DT_RELR:
+        case DT_ANDROID_RELR:
+            si->relr = (Elf32_Relr*) (base + d->d_un.d_ptr);
+            break;
+        case DT_RELRSZ:
+        case DT_ANDROID_RELRSZ:
+            si->relr_count = d->d_un.d_val / sizeof(Elf32_Relr);
+            break;
+        case DT_RELRENT:
+        case DT_ANDROID_RELRENT:
+            if (d->d_un.d_val != sizeof(Elf32_Relr)) {
+                DL_ERR("invalid DT_RELRENT %d in \"%s\"", d->d_un.d_val, si->name);
+                return false;
+            }
+            break;
         case DT_PLTGOT:
             /* Save this in case we decide to do lazy binding. We don't yet. */
             si->plt_got = (unsigned *)(base + d->d_un.d_ptr);
@@ -1418,9 +3003,32 @@ static bool soinfo_link_image(soinfo* si) {
         case DT_SYMBOLIC:
             si->has_DT_SYMBOLIC = true;
             break;
+        case DT_BIND_NOW:
+            has_DT_BIND_NOW = true;
+            break;
+        case DT_FLAGS_1:
+            if (d->d_un.d_val & DF_1_BIND_NOW) {
+                has_DT_BIND_NOW = true;
+            }
+            break;
         case DT_NEEDED:
             ++needed_count;
             break;
+        case DT_VERSYM:
+            si->versym = reinterpret_cast<Elf32_Half*>(base + d->d_un.d_ptr);
+            break;
+        case DT_VERDEF:
+            si->verdef = reinterpret_cast<Elf32_Verdef*>(base + d->d_un.d_ptr);
+            break;
+        case DT_VERDEFNUM:
+            si->verdef_count = d->d_un.d_val;
+            break;
+        case DT_VERNEED:
+            si->verneed = reinterpret_cast<Elf32_Verneed*>(base + d->d_un.d_ptr);
+            break;
+        case DT_VERNEEDNUM:
+            si->verneed_count = d->d_un.d_val;
+            break;
 #if defined DT_FLAGS
         // TODO: why is DT_FLAGS not defined?
         case DT_FLAGS:
@@ -1477,8 +3085,8 @@ static bool soinfo_link_image(soinfo* si) {
         DL_ERR("linker cannot have DT_NEEDED dependencies on other libraries");
         return false;
     }
-    if (si->nbucket == 0) {
-        DL_ERR("empty/missing DT_HASH in \"%s\" (built with --hash-style=gnu?)", si->name);
+    if (si->nbucket == 0 && si->gnu_nbucket == 0) {
+        DL_ERR("empty/missing DT_HASH/DT_GNU_HASH in \"%s\"", si->name);
         return false;
     }
     if (si->strtab == 0) {
@@ -1489,15 +3097,18 @@ static bool soinfo_link_image(soinfo* si) {
         DL_ERR("empty/missing DT_SYMTAB in \"%s\"", si->name);
         return false;
     }
+    soinfo_init_versions(si);
 
     // If this is the main executable, then load all of the libraries from LD_PRELOAD now.
     if (si->flags & FLAG_EXE) {
         memset(gLdPreloads, 0, sizeof(gLdPreloads));
         size_t preload_count = 0;
         for (size_t i = 0; gLdPreloadNames[i] != NULL; i++) {
-            soinfo* lsi = find_library(gLdPreloadNames[i]);
+            soinfo* lsi = find_library(gLdPreloadNames[i], RTLD_NOW, NULL);
             if (lsi != NULL) {
                 gLdPreloads[preload_count++] = lsi;
+                // Cached lookups made without this library in the search order are now stale.
+                symbol_cache_flush();
             } else {
                 // As with glibc, failure to load an LD_PRELOAD library is just a warning.
                 DL_WARN("could not load library \"%s\" from LD_PRELOAD for \"%s\"; caused by %s",
@@ -1506,14 +3117,37 @@ static bool soinfo_link_image(soinfo* si) {
         }
     }
 
+    /* A DT_NEEDED library marked DF_P1_LAZYLOAD or listed in LD_LAZY_NEEDED
+     * isn't loaded until a non-weak reference from this object can't be
+     * resolved without it, usually when a PLT entry is first called. That
+     * needs lazy binding, so LD_BIND_NOW and -z now turn deferral off, as
+     * does a PLT we can't bind lazily. A deferred library is searched after
+     * the ones that were loaded, and weak references never load one.
+     */
+    bool can_defer = !relocating_linker && !gLdBindNow && !has_DT_BIND_NOW &&
+                     soinfo_can_bind_lazily(si);
+    bool posflag_lazy = false;
+    size_t needed_index = 0;
+
     soinfo** needed = (soinfo**) alloca((1 + needed_count) * sizeof(soinfo*));
     soinfo** pneeded = needed;
 
     for (Elf32_Dyn* d = si->dynamic; d->d_tag != DT_NULL; ++d) {
+        // DT_POSFLAG_1 applies to the entry immediately after it.
+        bool lazy = posflag_lazy;
+        posflag_lazy = (d->d_tag == DT_POSFLAG_1 && (d->d_un.d_val & DF_P1_LAZYLOAD) != 0);
         if (d->d_tag == DT_NEEDED) {
             const char* library_name = si->strtab + d->d_un.d_val;
+            if (can_defer && needed_index < LAZY_NEEDED_MAX &&
+                (lazy || is_lazy_needed_name(library_name)) &&
+                find_loaded_library(library_name) == NULL) {
+                DEBUG("%s needs %s later", si->name, library_name);
+                si->lazy_needed |= 1U << needed_index++;
+                continue;
+            }
+            ++needed_index;
             DEBUG("%s needs %s", si->name, library_name);
-            soinfo* lsi = find_library(library_name);
+            soinfo* lsi = find_library(library_name, rtld_flags, NULL);
             if (lsi == NULL) {
                 strlcpy(tmp_err_buf, linker_get_error_buffer(), sizeof(tmp_err_buf));
                 DL_ERR("could not load library \"%s\" needed by \"%s\"; caused by %s",
@@ -1525,6 +3159,9 @@ static bool soinfo_link_image(soinfo* si) {
     }
     *pneeded = NULL;
 
+    // The linker relocates itself before it can safely use the symbol cache.
+    int scope = relocating_linker ? kNoLookupScope : lookup_scope_intern(needed);
+
     if (si->has_text_relocations) {
         /* Unprotect the segments, i.e. make them writable, to allow
          * text relocations to work properly. We will later call
@@ -1540,25 +3177,60 @@ static bool soinfo_link_image(soinfo* si) {
         }
     }
 
+    linker_stats_t stats_before = linker_stats;
+    long long relocation_start_us = gLdStats ? linker_stats_now_us() : 0;
+
     if (si->plt_rel != NULL) {
-        DEBUG("[ relocating %s plt ]", si->name );
-        if (soinfo_relocate(si, si->plt_rel, si->plt_rel_count, needed)) {
-            return false;
+        // Deferred libraries are loaded when a PLT entry first needs them,
+        // so their users' PLTs are always bound lazily.
+        if (si->lazy_needed != 0 ||
+            ((rtld_flags & RTLD_LAZY) != 0 && !gLdBindNow && !has_DT_BIND_NOW &&
+             soinfo_can_bind_lazily(si))) {
+            DEBUG("[ preparing %s plt for lazy binding ]", si->name);
+            if (!soinfo_prepare_lazy_plt(si)) {
+                return false;
+            }
+        } else {
+            DEBUG("[ relocating %s plt ]", si->name );
+            if (soinfo_relocate(si, si->plt_rel, si->plt_rel_count, needed, &scope)) {
+                return false;
+            }
         }
     }
     if (si->rel != NULL) {
         DEBUG("[ relocating %s ]", si->name );
-        if (soinfo_relocate(si, si->rel, si->rel_count, needed)) {
+        if (soinfo_relocate(si, si->rel, si->rel_count, needed, &scope)) {
             return false;
         }
     }
+    if (si->load_bias == 0) {
+        // We landed at the address the library was linked (or prelinked)
+        // for, so every relative relocation would add zero.
+        DEBUG("[ %s is at its link address; skipping relative relocations ]", si->name);
+    } else if (si->relr != NULL) {
+        DEBUG("[ relocating %s relr ]", si->name );
+        soinfo_relocate_relr(si);
+    }
 
 #ifdef ANDROID_MIPS_LINKER
-    if (!mips_relocate_got(si, needed)) {
+    if (!mips_relocate_got(si, needed, scope)) {
         return false;
     }
 #endif
 
+    if (__predict_false(gLdStats) && !relocating_linker) {
+        STATS_PRINT("%s: relocation %lld us: %d abs, %d rel, %d copy, %d symbol; "
+                    "%d lookups, %d misses, %d cached",
+                    si->name, linker_stats_now_us() - relocation_start_us,
+                    linker_stats.count[kRelocAbsolute] - stats_before.count[kRelocAbsolute],
+                    linker_stats.count[kRelocRelative] - stats_before.count[kRelocRelative],
+                    linker_stats.count[kRelocCopy] - stats_before.count[kRelocCopy],
+                    linker_stats.count[kRelocSymbol] - stats_before.count[kRelocSymbol],
+                    linker_stats.lookups - stats_before.lookups,
+                    linker_stats.lookup_misses - stats_before.lookup_misses,
+                    linker_stats.cache_hits - stats_before.cache_hits);
+    }
+
     si->flags |= FLAG_LINKED;
     DEBUG("[ finished linking %s ]", si->name);
 
@@ -1579,10 +3251,190 @@ static bool soinfo_link_image(soinfo* si) {
         return false;
     }
 
+    /* Handle serializing/sharing the RELRO segment */
+    if (extinfo && (extinfo->flags & ANDROID_DLEXT_WRITE_RELRO)) {
+        if (phdr_table_serialize_gnu_relro(si->phdr, si->phnum, si->load_bias,
+                                           extinfo->relro_fd) < 0) {
+            DL_ERR("failed serializing GNU RELRO section for \"%s\": %s",
+                   si->name, strerror(errno));
+            return false;
+        }
+    } else if (extinfo && (extinfo->flags & ANDROID_DLEXT_USE_RELRO)) {
+        if (phdr_table_map_gnu_relro(si->phdr, si->phnum, si->load_bias,
+                                     extinfo->relro_fd) < 0) {
+            DL_ERR("failed mapping GNU RELRO section for \"%s\": %s",
+                   si->name, strerror(errno));
+            return false;
+        }
+    }
+
     notify_gdb_of_load(si);
     return true;
 }
 
+// Memory accounting for android_dl_get_stats(3).
+
+// Counts the pages with relocations to apply. The relocation tables are
+// normally sorted by address, so this counts runs rather than remembering
+// every page, which may overcount a little for unsorted ones.
+class RelocatedPageCounter {
+ public:
+  explicit RelocatedPageCounter(Elf32_Addr load_bias)
+      : load_bias_(load_bias), last_page_(1), count_(0) {
+  }
+
+  void Add(Elf32_Addr offset) {
+    Elf32_Addr page = PAGE_START(offset + load_bias_);
+    if (page != last_page_) {
+      last_page_ = page;
+      ++count_;
+    }
+  }
+
+  size_t count() const {
+    return count_;
+  }
+
+ private:
+  const Elf32_Addr load_bias_;
+  Elf32_Addr last_page_; // Never a page address, until we've seen one.
+  size_t count_;
+};
+
+static size_t soinfo_count_relocated_pages(const soinfo* si) {
+  RelocatedPageCounter counter(si->load_bias);
+  for (size_t i = 0; i < si->rel_count; ++i) {
+    counter.Add(si->rel[i].r_offset);
+  }
+  for (size_t i = 0; i < si->plt_rel_count; ++i) {
+    counter.Add(si->plt_rel[i].r_offset);
+  }
+  Elf32_Addr where = 0;
+  for (size_t i = 0; i < si->relr_count; ++i) {
+    Elf32_Relr entry = si->relr[i];
+    if ((entry & 1) == 0) {
+      where = entry;
+      counter.Add(where);
+      where += sizeof(Elf32_Addr);
+    } else {
+      Elf32_Addr p = where;
+      for (Elf32_Relr bitmap = entry >> 1; bitmap != 0; bitmap >>= 1, p += sizeof(Elf32_Addr)) {
+        if ((bitmap & 1) != 0) {
+          counter.Add(p);
+        }
+      }
+      where += (8 * sizeof(Elf32_Relr) - 1) * sizeof(Elf32_Addr);
+    }
+  }
+  return counter.count();
+}
+
+// Bits in a /proc/self/pagemap entry.
+#define PAGEMAP_PRESENT    (1ULL << 63)
+#define PAGEMAP_FILE_PAGE  (1ULL << 61) // File-backed or shared anonymous.
+
+// Counts the resident pages in [start, start + size) that are private to
+// this process and those that are backed by the file. Both are left at 0
+// if /proc/self/pagemap isn't readable.
+static void count_resident_pages(int pagemap_fd, Elf32_Addr start, size_t size,
+                                 size_t* private_dirty, size_t* clean) {
+  *private_dirty = 0;
+  *clean = 0;
+  if (pagemap_fd == -1) {
+    return;
+  }
+
+  uint64_t entries[128];
+  size_t page = start / PAGE_SIZE;
+  size_t end_page = (start + size + PAGE_SIZE - 1) / PAGE_SIZE;
+  while (page < end_page) {
+    size_t n = end_page - page;
+    if (n > sizeof(entries)/sizeof(entries[0])) {
+      n = sizeof(entries)/sizeof(entries[0]);
+    }
+    ssize_t bytes = TEMP_FAILURE_RETRY(pread64(pagemap_fd, entries, n * sizeof(uint64_t),
+                                               static_cast<off64_t>(page) * sizeof(uint64_t)));
+    if (bytes <= 0) {
+      return;
+    }
+    n = bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < n; ++i) {
+      if ((entries[i] & PAGEMAP_PRESENT) != 0) {
+        if ((entries[i] & PAGEMAP_FILE_PAGE) != 0) {
+          ++*clean;
+        } else {
+          ++*private_dirty;
+        }
+      }
+    }
+    page += n;
+  }
+}
+
+// The memory the linker itself has mapped to keep track of what's loaded.
+static size_t linker_bookkeeping_bytes() {
+  size_t bytes = 0;
+  for (soinfo_pool_t* pool = gSoInfoPools; pool != NULL; pool = pool->next) {
+    bytes += 2 * PAGE_SIZE; // The pool and its lock-free reference counts.
+  }
+  bytes += gSoInfoAddressIndexCapacity * sizeof(soinfo*);
+  if (gLoadedObjects != NULL) {
+    bytes += gLoadedObjects->mmap_size;
+  }
+  return bytes;
+}
+
+size_t do_android_dl_get_stats(android_dl_library_stats* stats, size_t count,
+                               size_t* linker_bytes) {
+  int pagemap_fd = TEMP_FAILURE_RETRY(open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC));
+
+  size_t total = 0;
+  for (soinfo* si = solist; si != NULL; si = si->next) {
+    if (si->size == 0) {
+      continue; // There's nothing mapped to account for (libdl.so).
+    }
+    if (total < count) {
+      android_dl_library_stats* entry = &stats[total];
+      entry->name = si->name;
+      entry->base = reinterpret_cast<void*>(si->base);
+      entry->size = si->size;
+      count_resident_pages(pagemap_fd, si->base, si->size,
+                           &entry->private_dirty_pages, &entry->clean_pages);
+      entry->relocated_pages = soinfo_count_relocated_pages(si);
+    }
+    ++total;
+  }
+
+  if (pagemap_fd != -1) {
+    close(pagemap_fd);
+  }
+  if (linker_bytes != NULL) {
+    *linker_bytes = linker_bookkeeping_bytes();
+  }
+  return total;
+}
+
+void do_android_dl_dump_stats(int fd) {
+  int pagemap_fd = TEMP_FAILURE_RETRY(open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC));
+
+  __libc_format_fd(fd, "linker: %d bytes of bookkeeping\n", linker_bookkeeping_bytes());
+  __libc_format_fd(fd, "    base     size  dirty  clean  reloc  name\n");
+  for (soinfo* si = solist; si != NULL; si = si->next) {
+    if (si->size == 0) {
+      continue;
+    }
+    size_t private_dirty;
+    size_t clean;
+    count_resident_pages(pagemap_fd, si->base, si->size, &private_dirty, &clean);
+    __libc_format_fd(fd, "%08x %8d %6d %6d %6d  %s\n", si->base, si->size,
+                     private_dirty, clean, soinfo_count_relocated_pages(si), si->name);
+  }
+
+  if (pagemap_fd != -1) {
+    close(pagemap_fd);
+  }
+}
+
 /*
  * This function add vdso to internal dso list.
  * It helps to stack unwinding through signal handlers.
@@ -1642,18 +3494,32 @@ static Elf32_Addr __linker_init_post_relocation(KernelArgumentBlock& args, Elf32
     if (LD_DEBUG != NULL) {
       gLdDebugVerbosity = atoi(LD_DEBUG);
     }
+    gLdBindNow = (linker_env_get("LD_BIND_NOW") != NULL);
+    gLdStats = (linker_env_get("LD_STATS") != NULL);
+    gLdReadahead = (linker_env_get("LD_READAHEAD") != NULL);
+    if (linker_env_get("LD_STARTUP_TRACE") != NULL) {
+      gStartupTrace.Mark("linker");
+      args.startup_trace = &gStartupTrace;
+    }
 
     // Normally, these are cleaned by linker_env_init, but the test
     // doesn't cost us anything.
     const char* ldpath_env = NULL;
     const char* ldpreload_env = NULL;
+    const char* ldmanifest_env = NULL;
+    const char* ldlazyneeded_env = NULL;
     if (!get_AT_SECURE()) {
       ldpath_env = linker_env_get("LD_LIBRARY_PATH");
       ldpreload_env = linker_env_get("LD_PRELOAD");
+      ldmanifest_env = linker_env_get("LD_LIBRARY_MANIFEST");
+      ldlazyneeded_env = linker_env_get("LD_LAZY_NEEDED");
     }
 
     INFO("[ android linker & debugger ]");
 
+    // libdl_info is statically allocated, so soinfo_alloc() never saw it.
+    soinfo_index_add_name(&libdl_info);
+
     soinfo* si = soinfo_alloc(args.argv[0]);
     if (si == NULL) {
         exit(EXIT_FAILURE);
@@ -1718,20 +3584,32 @@ static Elf32_Addr __linker_init_post_relocation(KernelArgumentBlock& args, Elf32
     }
     si->dynamic = NULL;
     si->ref_count = 1;
+    if (!soinfo_index_add_address(si)) {
+        __libc_format_fd(2, "CANNOT LINK EXECUTABLE: %s\n", linker_get_error_buffer());
+        exit(EXIT_FAILURE);
+    }
 
     // Use LD_LIBRARY_PATH and LD_PRELOAD (but only if we aren't setuid/setgid).
     parse_LD_LIBRARY_PATH(ldpath_env);
     parse_LD_PRELOAD(ldpreload_env);
+    parse_LD_LAZY_NEEDED(ldlazyneeded_env);
+    library_manifest_prefetch(ldmanifest_env);
 
     somain = si;
 
-    if (!soinfo_link_image(si)) {
+    if (!soinfo_link_image(si, RTLD_NOW, NULL)) {
         __libc_format_fd(2, "CANNOT LINK EXECUTABLE: %s\n", linker_get_error_buffer());
         exit(EXIT_FAILURE);
     }
+    library_manifest_close();
+    if (args.startup_trace != NULL) {
+      args.startup_trace->Mark("linked");
+    }
 
     add_vdso(args);
 
+    loaded_objects_publish(NULL);
+
     si->CallPreInitConstructors();
 
     for (size_t i = 0; gLdPreloads[i] != NULL; ++i) {
@@ -1745,6 +3623,9 @@ static Elf32_Addr __linker_init_post_relocation(KernelArgumentBlock& args, Elf32
      */
     map->l_addr = si->load_bias;
     si->CallConstructors();
+    if (args.startup_trace != NULL) {
+      args.startup_trace->Mark("constructors");
+    }
 
 #if TIMING
     gettimeofday(&t1,NULL);
@@ -1753,13 +3634,20 @@ static Elf32_Addr __linker_init_post_relocation(KernelArgumentBlock& args, Elf32
                (((long long)t0.tv_sec * 1000000LL) + (long long)t0.tv_usec)
                ));
 #endif
-#if STATS
-    PRINT("RELO STATS: %s: %d abs, %d rel, %d copy, %d symbol", args.argv[0],
-           linker_stats.count[kRelocAbsolute],
-           linker_stats.count[kRelocRelative],
-           linker_stats.count[kRelocCopy],
-           linker_stats.count[kRelocSymbol]);
-#endif
+    // Constructors of independent DT_NEEDED subtrees could in principle run
+    // concurrently, so the difference between these two figures bounds what
+    // parallel initialization could save.
+    STATS_PRINT("%s: constructors: %lld us, %lld us on the critical path",
+                args.argv[0], linker_stats.constructors_us, si->constructors_path_us);
+    STATS_PRINT("%s: total: %d abs, %d rel, %d copy, %d symbol; %d lookups, %d misses, %d cached",
+                args.argv[0],
+                linker_stats.count[kRelocAbsolute],
+                linker_stats.count[kRelocRelative],
+                linker_stats.count[kRelocCopy],
+                linker_stats.count[kRelocSymbol],
+                linker_stats.lookups,
+                linker_stats.lookup_misses,
+                linker_stats.cache_hits);
 #if COUNT_PAGES
     {
         unsigned n;
@@ -1780,7 +3668,7 @@ static Elf32_Addr __linker_init_post_relocation(KernelArgumentBlock& args, Elf32
     }
 #endif
 
-#if TIMING || STATS || COUNT_PAGES
+#if TIMING || COUNT_PAGES
     fflush(stdout);
 #endif
 
@@ -1839,7 +3727,7 @@ extern "C" Elf32_Addr __linker_init(void* raw_args) {
   linker_so.phnum = elf_hdr->e_phnum;
   linker_so.flags |= FLAG_LINKER;
 
-  if (!soinfo_link_image(&linker_so)) {
+  if (!soinfo_link_image(&linker_so, RTLD_NOW, NULL)) {
     // It would be nice to print an error message, but if the linker
     // can't link itself, there's no guarantee that we'll be able to
     // call write() (because it involves a GOT reference).
@@ -1852,6 +3740,7 @@ extern "C" Elf32_Addr __linker_init(void* raw_args) {
   // We have successfully fixed our own relocations. It's safe to run
   // the main part of the linker now.
   args.abort_message_ptr = &gAbortMessage;
+  args.tls_modules = &gTlsModules;
   Elf32_Addr start_address = __linker_init_post_relocation(args, linker_addr);
 
   set_soinfo_pool_protection(PROT_READ);
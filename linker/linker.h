@@ -36,6 +36,8 @@
 
 #include <link.h>
 
+#include <android/dlext.h>
+
 #include "private/libc_logging.h"
 
 #define DL_ERR(fmt, x...) \
@@ -92,11 +94,27 @@ struct r_debug {
 #define FLAG_LINKED     0x00000001
 #define FLAG_EXE        0x00000004 // The main executable
 #define FLAG_LINKER     0x00000010 // The linker itself
+#define FLAG_GNU_HASH   0x00000040 // uses gnu hash
+#define FLAG_RESERVED   0x00000080 // loaded into address space reserved by the caller
+#define FLAG_CONSTRUCTED 0x00000100 // constructors have returned
 
 #define SOINFO_NAME_LEN 128
 
+// How many symbol version indexes each soinfo keeps a precomputed entry for.
+// Objects rarely define or need more versions than this; lookups of any
+// further indexes walk DT_VERDEF and DT_VERNEED instead.
+#define SOINFO_VERSION_MAX 16
+
 typedef void (*linker_function_t)();
 
+// A symbol version, as recorded in DT_VERDEF or DT_VERNEED: the ELF hash of
+// its name, so that versions can nearly always be told apart by an integer
+// compare, and the name itself.
+struct version_info {
+  Elf32_Word hash;
+  const char* name; // NULL if the object doesn't define or need this index.
+};
+
 struct soinfo {
  public:
   char name[SOINFO_NAME_LEN];
@@ -165,6 +183,40 @@ struct soinfo {
   bool has_text_relocations;
   bool has_DT_SYMBOLIC;
 
+  // DT_GNU_HASH. Only valid if FLAG_GNU_HASH is set in flags.
+  size_t gnu_nbucket;
+  unsigned* gnu_bucket;
+  unsigned* gnu_chain;
+  uint32_t gnu_maskwords;  // Stored as (maskwords - 1) for use as a mask.
+  uint32_t gnu_shift2;
+  Elf32_Addr* gnu_bloom_filter;
+
+  Elf32_Relr* relr;
+  size_t relr_count;
+
+  // Next soinfo in the same find_loaded_library() hash bucket.
+  soinfo* name_hash_next;
+
+  // For LD_STATS: time spent in our constructors plus the longest chain of
+  // DT_NEEDED constructors they had to wait for.
+  long long constructors_path_us;
+
+  // Symbol versioning. versym is NULL if the object isn't versioned.
+  Elf32_Half* versym;
+  Elf32_Verdef* verdef;
+  size_t verdef_count;
+  Elf32_Verneed* verneed;
+  size_t verneed_count;
+  // The versions defined or needed by this object, by version index.
+  version_info versions[SOINFO_VERSION_MAX];
+
+  // This object's ELF TLS module id (see bionic_tls.h), or 0 if it has no PT_TLS segment.
+  size_t tls_module_id;
+
+  // Bit n is set if the nth DT_NEEDED library was deferred by
+  // soinfo_link_image() and hasn't been loaded yet.
+  uint32_t lazy_needed;
+
   void CallConstructors();
   void CallDestructors();
   void CallPreInitConstructors();
@@ -184,14 +236,65 @@ extern soinfo libdl_info;
 #define DT_PREINIT_ARRAYSZ 33
 #endif
 
+// Compact relative relocations (see soinfo_relocate_relr).
+#ifndef DT_RELRSZ
+#define DT_RELRSZ 35
+#endif
+#ifndef DT_RELR
+#define DT_RELR 36
+#endif
+#ifndef DT_RELRENT
+#define DT_RELRENT 37
+#endif
+// The same format, under the tags used before DT_RELR was standardized.
+#define DT_ANDROID_RELR     0x6fffe000
+#define DT_ANDROID_RELRSZ   0x6fffe001
+#define DT_ANDROID_RELRENT  0x6fffe003
+
+typedef Elf32_Word Elf32_Relr;
+
+// Solaris' per-dependency flags: DF_P1_LAZYLOAD in a DT_POSFLAG_1 entry
+// marks the DT_NEEDED entry that follows it as one to load on first use.
+#ifndef DT_POSFLAG_1
+#define DT_POSFLAG_1 0x6ffffdfd
+#endif
+#ifndef DF_P1_LAZYLOAD
+#define DF_P1_LAZYLOAD 0x00000001
+#endif
+
+// Set by LD_READAHEAD to prefetch every library's segments when they're mapped.
+__LIBC_HIDDEN__ extern bool gLdReadahead;
+
 void do_android_update_LD_LIBRARY_PATH(const char* ld_library_path);
-soinfo* do_dlopen(const char* name, int flags);
+soinfo* do_dlopen_loaded(const char* name, int flags, const android_dlextinfo* extinfo);
+soinfo* do_dlopen(const char* name, int flags, const android_dlextinfo* extinfo);
 int do_dlclose(soinfo* si);
 
+size_t do_android_dl_get_stats(android_dl_library_stats* stats, size_t count, size_t* linker_bytes);
+void do_android_dl_dump_stats(int fd);
+
 Elf32_Sym* dlsym_linear_lookup(const char* name, soinfo** found, soinfo* start);
+
+// Lets the current thread look at the loaded objects without holding the
+// dl lock. They won't be unloaded while the reader is in scope.
+class ScopedLoadedObjectsReader {
+ public:
+  ScopedLoadedObjectsReader();
+  ~ScopedLoadedObjectsReader();
+
+ private:
+  int epoch_;
+
+  // Disallow copy and assignment.
+  ScopedLoadedObjectsReader(const ScopedLoadedObjectsReader&);
+  void operator=(const ScopedLoadedObjectsReader&);
+};
+
+// Callers must hold the dl lock or a ScopedLoadedObjectsReader.
 soinfo* find_containing_library(const void* addr);
 
 Elf32_Sym* dladdr_find_symbol(soinfo* si, const void* addr);
+Elf32_Addr soinfo_lazy_bind(soinfo* si, Elf32_Word rel_offset);
 Elf32_Sym* dlsym_handle_lookup(soinfo* si, const char* name);
 
 void debuggerd_init();
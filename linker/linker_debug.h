@@ -45,7 +45,6 @@
 #define DO_TRACE_LOOKUP      1
 #define DO_TRACE_RELO        1
 #define TIMING               0
-#define STATS                0
 #define COUNT_PAGES          0
 
 /*********************************************************************
@@ -86,4 +85,27 @@ __LIBC_HIDDEN__ extern int gLdDebugVerbosity;
 
 #define TRACE_TYPE(t,x...)   do { if (DO_TRACE_##t) { TRACE(x); } } while (0)
 
+/*********************************************************************/
+
+// Setting the LD_STATS environment variable (to anything) makes the linker
+// log, for every library it loads, how long each loading phase took, how
+// many relocations of each kind it applied, how many symbol lookups missed,
+// and how long its constructors ran. Unlike the options above this is
+// always compiled in, and costs a predictable branch when it's off.
+__LIBC_HIDDEN__ extern bool gLdStats;
+
+#define STATS_PRINT(x...) \
+    do { \
+      if (gLdStats) __libc_format_log(ANDROID_LOG_INFO, "linker", "STATS: " x); \
+    } while (0)
+
+#include <time.h>
+
+// Returns the current CLOCK_MONOTONIC time in microseconds.
+static inline long long linker_stats_now_us() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<long long>(ts.tv_sec) * 1000000LL + ts.tv_nsec / 1000;
+}
+
 #endif /* _LINKER_DEBUG_H_ */
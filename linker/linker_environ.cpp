@@ -120,11 +120,15 @@ static bool __is_unsafe_environment_variable(const char* name) {
       "LD_DEBUG",
       "LD_DEBUG_OUTPUT",
       "LD_DYNAMIC_WEAK",
+      "LD_LAZY_NEEDED",
+      "LD_LIBRARY_MANIFEST",
       "LD_LIBRARY_PATH",
       "LD_ORIGIN_PATH",
       "LD_PRELOAD",
       "LD_PROFILE",
       "LD_SHOW_AUXV",
+      "LD_STARTUP_TRACE",
+      "LD_STATS",
       "LD_USE_LOAD_BIAS",
       "LOCALDOMAIN",
       "LOCPATH",
@@ -29,7 +29,9 @@
 #include "linker_phdr.h"
 
 #include <errno.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "linker.h"
 #include "linker_debug.h"
@@ -116,40 +118,71 @@
                                       MAYBE_MAP_FLAG((x), PF_W, PROT_WRITE))
 
 ElfReader::ElfReader(const char* name, int fd)
-    : name_(name), fd_(fd),
+    : name_(name), fd_(fd), file_head_size_(0),
       phdr_num_(0), phdr_mmap_(NULL), phdr_table_(NULL), phdr_size_(0),
       load_start_(NULL), load_size_(0), load_bias_(0),
-      loaded_phdr_(NULL) {
+      loaded_in_reserved_space_(false),
+      loaded_phdr_(NULL),
+      read_time_us_(0), reserve_time_us_(0), load_time_us_(0) {
 }
 
+// The caller owns 'fd' and is responsible for closing it.
 ElfReader::~ElfReader() {
-  if (fd_ != -1) {
-    close(fd_);
-  }
   if (phdr_mmap_ != NULL) {
     munmap(phdr_mmap_, phdr_size_);
   }
 }
 
-bool ElfReader::Load() {
+bool ElfReader::Load(const android_dlextinfo* extinfo) {
+  if (__predict_false(gLdStats)) {
+    return LoadWithStats(extinfo);
+  }
   return ReadElfHeader() &&
          VerifyElfHeader() &&
          ReadProgramHeader() &&
-         ReserveAddressSpace() &&
-         LoadSegments() &&
+         ReserveAddressSpace(extinfo) &&
+         LoadSegments(extinfo) &&
          FindPhdr();
 }
 
+// The same as Load(), but records how long each phase took.
+bool ElfReader::LoadWithStats(const android_dlextinfo* extinfo) {
+  long long t0 = linker_stats_now_us();
+  if (!ReadElfHeader() || !VerifyElfHeader() || !ReadProgramHeader()) {
+    return false;
+  }
+  long long t1 = linker_stats_now_us();
+  if (!ReserveAddressSpace(extinfo)) {
+    return false;
+  }
+  long long t2 = linker_stats_now_us();
+  if (!LoadSegments(extinfo) || !FindPhdr()) {
+    return false;
+  }
+  long long t3 = linker_stats_now_us();
+
+  read_time_us_ = t1 - t0;
+  reserve_time_us_ = t2 - t1;
+  load_time_us_ = t3 - t2;
+  return true;
+}
+
+// Reads the first page of the file, so that ReadProgramHeader() can usually
+// find the program header table there too. Uses pread(2) so we don't depend
+// on (or disturb) the offset of a file descriptor passed in with
+// ANDROID_DLEXT_USE_LIBRARY_FD.
 bool ElfReader::ReadElfHeader() {
-  ssize_t rc = TEMP_FAILURE_RETRY(read(fd_, &header_, sizeof(header_)));
+  ssize_t rc = TEMP_FAILURE_RETRY(pread(fd_, file_head_, sizeof(file_head_), 0));
   if (rc < 0) {
     DL_ERR("can't read file \"%s\": %s", name_, strerror(errno));
     return false;
   }
-  if (rc != sizeof(header_)) {
+  if (rc < static_cast<ssize_t>(sizeof(header_))) {
     DL_ERR("\"%s\" is too small to be an ELF executable", name_);
     return false;
   }
+  file_head_size_ = rc;
+  memcpy(&header_, file_head_, sizeof(header_));
   return true;
 }
 
@@ -197,8 +230,9 @@ bool ElfReader::VerifyElfHeader() {
   return true;
 }
 
-// Loads the program header table from an ELF file into a read-only private
-// anonymous mmap-ed block.
+// Finds the program header table in the first page of the file read by
+// ReadElfHeader(), where linkers put it, or failing that maps it in a
+// read-only private mmap-ed block.
 bool ElfReader::ReadProgramHeader() {
   phdr_num_ = header_.e_phnum;
 
@@ -209,6 +243,14 @@ bool ElfReader::ReadProgramHeader() {
     return false;
   }
 
+  size_t phdr_table_size = phdr_num_ * sizeof(Elf32_Phdr);
+  if ((header_.e_phoff % sizeof(Elf32_Word)) == 0 &&
+      header_.e_phoff <= file_head_size_ &&
+      phdr_table_size <= file_head_size_ - header_.e_phoff) {
+    phdr_table_ = reinterpret_cast<Elf32_Phdr*>(&file_head_[header_.e_phoff]);
+    return true;
+  }
+
   Elf32_Addr page_min = PAGE_START(header_.e_phoff);
   Elf32_Addr page_max = PAGE_END(header_.e_phoff + (phdr_num_ * sizeof(Elf32_Phdr)));
   Elf32_Addr page_offset = PAGE_OFFSET(header_.e_phoff);
@@ -279,8 +321,9 @@ size_t phdr_table_get_load_size(const Elf32_Phdr* phdr_table,
 
 // Reserve a virtual address range big enough to hold all loadable
 // segments of a program header table. This is done by creating a
-// private anonymous mmap() with PROT_NONE.
-bool ElfReader::ReserveAddressSpace() {
+// private anonymous mmap() with PROT_NONE, unless the caller of
+// android_dlopen_ext(3) has already reserved a big enough range.
+bool ElfReader::ReserveAddressSpace(const android_dlextinfo* extinfo) {
   Elf32_Addr min_vaddr;
   load_size_ = phdr_table_get_load_size(phdr_table_, phdr_num_, &min_vaddr);
   if (load_size_ == 0) {
@@ -289,11 +332,34 @@ bool ElfReader::ReserveAddressSpace() {
   }
 
   uint8_t* addr = reinterpret_cast<uint8_t*>(min_vaddr);
-  int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS;
-  void* start = mmap(addr, load_size_, PROT_NONE, mmap_flags, -1, 0);
-  if (start == MAP_FAILED) {
-    DL_ERR("couldn't reserve %d bytes of address space for \"%s\"", load_size_, name_);
-    return false;
+  void* start;
+  size_t reserved_size = 0;
+  bool reserved_hint = true;
+
+  if (extinfo != NULL) {
+    if (extinfo->flags & ANDROID_DLEXT_RESERVED_ADDRESS) {
+      reserved_size = extinfo->reserved_size;
+      reserved_hint = false;
+    } else if (extinfo->flags & ANDROID_DLEXT_RESERVED_ADDRESS_HINT) {
+      reserved_size = extinfo->reserved_size;
+    }
+  }
+
+  if (load_size_ > reserved_size) {
+    if (!reserved_hint) {
+      DL_ERR("reserved address space %d smaller than %d bytes needed for \"%s\"",
+             reserved_size, load_size_, name_);
+      return false;
+    }
+    int mmap_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    start = mmap(addr, load_size_, PROT_NONE, mmap_flags, -1, 0);
+    if (start == MAP_FAILED) {
+      DL_ERR("couldn't reserve %d bytes of address space for \"%s\"", load_size_, name_);
+      return false;
+    }
+  } else {
+    start = extinfo->reserved_addr;
+    loaded_in_reserved_space_ = true;
   }
 
   load_start_ = start;
@@ -305,7 +371,13 @@ bool ElfReader::ReserveAddressSpace() {
 // This assumes you already called phdr_table_reserve_memory to
 // reserve the address space range for the library.
 // TODO: assert assumption.
-bool ElfReader::LoadSegments() {
+bool ElfReader::LoadSegments(const android_dlextinfo* extinfo) {
+  // Relocation goes on to touch most of the data segment and constructors
+  // much of the text, so on request we have the kernel read each segment
+  // in as one sequential I/O rather than faulting it in a page at a time.
+  bool readahead = gLdReadahead ||
+      (extinfo != NULL && (extinfo->flags & ANDROID_DLEXT_READAHEAD) != 0);
+
   for (size_t i = 0; i < phdr_num_; ++i) {
     const Elf32_Phdr* phdr = &phdr_table_[i];
 
@@ -340,6 +412,10 @@ bool ElfReader::LoadSegments() {
         DL_ERR("couldn't map \"%s\" segment %d: %s", name_, i, strerror(errno));
         return false;
       }
+      if (readahead) {
+        // Only a hint, so failure doesn't matter.
+        madvise(seg_addr, file_length, MADV_WILLNEED);
+      }
     }
 
     // if the segment is writable, and does not end on a page boundary,
@@ -518,6 +594,182 @@ phdr_table_protect_gnu_relro(const Elf32_Phdr* phdr_table,
                                           PROT_READ);
 }
 
+/* Serialize the GNU relro segments to the given file descriptor. This can be
+ * performed after relocations to allow another process to later share the
+ * relocated segment, if it was loaded at the same address.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ *   fd          -> writable file descriptor to use
+ * Return:
+ *   0 on error, -1 on failure (error code in errno).
+ */
+int
+phdr_table_serialize_gnu_relro(const Elf32_Phdr* phdr_table,
+                               int               phdr_count,
+                               Elf32_Addr        load_bias,
+                               int               fd)
+{
+    const Elf32_Phdr* phdr = phdr_table;
+    const Elf32_Phdr* phdr_limit = phdr + phdr_count;
+    ssize_t file_offset = 0;
+
+    for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+        if (phdr->p_type != PT_GNU_RELRO)
+            continue;
+
+        Elf32_Addr seg_page_start = PAGE_START(phdr->p_vaddr) + load_bias;
+        Elf32_Addr seg_page_end   = PAGE_END(phdr->p_vaddr + phdr->p_memsz) + load_bias;
+        ssize_t size = seg_page_end - seg_page_start;
+
+        ssize_t written = TEMP_FAILURE_RETRY(write(fd, reinterpret_cast<void*>(seg_page_start), size));
+        if (written != size) {
+            return -1;
+        }
+        /* Replace our private copy with the file, so this process shares
+         * the pages too.
+         */
+        void* map = mmap(reinterpret_cast<void*>(seg_page_start), size, PROT_READ,
+                         MAP_PRIVATE|MAP_FIXED, fd, file_offset);
+        if (map == MAP_FAILED) {
+            return -1;
+        }
+        file_offset += size;
+    }
+    return 0;
+}
+
+/* Where possible, replace the GNU relro segments with mappings of the given
+ * file descriptor. This can be performed after relocations to allow a file
+ * previously created by phdr_table_serialize_gnu_relro in another process to
+ * replace the dirty relocated pages, saving memory, if it was loaded at the
+ * same address. We have to compare the data before we map over it, since some
+ * parts of the relro segment may not be identical due to other libraries in
+ * the process being loaded at different addresses.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ *   fd          -> readable file descriptor to use
+ * Return:
+ *   0 on error, -1 on failure (error code in errno).
+ */
+int
+phdr_table_map_gnu_relro(const Elf32_Phdr* phdr_table,
+                         int               phdr_count,
+                         Elf32_Addr        load_bias,
+                         int               fd)
+{
+    /* Map the file at a temporary location so we can compare its contents. */
+    struct stat file_stat;
+    if (TEMP_FAILURE_RETRY(fstat(fd, &file_stat)) != 0) {
+        return -1;
+    }
+    off_t file_size = file_stat.st_size;
+    void* temp_mapping = NULL;
+    if (file_size > 0) {
+        temp_mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (temp_mapping == MAP_FAILED) {
+            return -1;
+        }
+    }
+    size_t file_offset = 0;
+
+    /* Iterate over the relro segments and compare/remap the pages. */
+    const Elf32_Phdr* phdr = phdr_table;
+    const Elf32_Phdr* phdr_limit = phdr + phdr_count;
+
+    for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+        if (phdr->p_type != PT_GNU_RELRO)
+            continue;
+
+        Elf32_Addr seg_page_start = PAGE_START(phdr->p_vaddr) + load_bias;
+        Elf32_Addr seg_page_end   = PAGE_END(phdr->p_vaddr + phdr->p_memsz) + load_bias;
+
+        char* file_base = static_cast<char*>(temp_mapping) + file_offset;
+        char* mem_base = reinterpret_cast<char*>(seg_page_start);
+        size_t match_offset = 0;
+        size_t size = seg_page_end - seg_page_start;
+
+        if (file_size - file_offset < size) {
+            /* File is too short to compare to this segment. The contents are
+             * likely to be different as well (it's probably for a different
+             * library version) so just don't bother checking.
+             */
+            break;
+        }
+
+        while (match_offset < size) {
+            /* Skip over dissimilar pages. */
+            while (match_offset < size &&
+                   memcmp(mem_base + match_offset, file_base + match_offset, PAGE_SIZE) != 0) {
+                match_offset += PAGE_SIZE;
+            }
+
+            /* Count similar pages. */
+            size_t mismatch_offset = match_offset;
+            while (mismatch_offset < size &&
+                   memcmp(mem_base + mismatch_offset, file_base + mismatch_offset, PAGE_SIZE) == 0) {
+                mismatch_offset += PAGE_SIZE;
+            }
+
+            /* Map over similar pages. */
+            if (mismatch_offset > match_offset) {
+                void* map = mmap(mem_base + match_offset, mismatch_offset - match_offset,
+                                 PROT_READ, MAP_PRIVATE|MAP_FIXED, fd, file_offset + match_offset);
+                if (map == MAP_FAILED) {
+                    munmap(temp_mapping, file_size);
+                    return -1;
+                }
+            }
+
+            match_offset = mismatch_offset;
+        }
+
+        /* Add to the base file offset in case there are multiple relro segments. */
+        file_offset += size;
+    }
+    munmap(temp_mapping, file_size);
+    return 0;
+}
+
+/* Returns true if 'addr' is in a page that phdr_table_protect_gnu_relro()
+ * will make read-only.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ *   load_bias   -> load bias
+ *   addr        -> address in memory
+ * Return:
+ *   true if the address will be read-only after relocation.
+ */
+bool
+phdr_table_is_in_gnu_relro(const Elf32_Phdr* phdr_table,
+                           int               phdr_count,
+                           Elf32_Addr        load_bias,
+                           Elf32_Addr        addr)
+{
+    const Elf32_Phdr* phdr = phdr_table;
+    const Elf32_Phdr* phdr_limit = phdr + phdr_count;
+
+    for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+        if (phdr->p_type != PT_GNU_RELRO)
+            continue;
+
+        /* Use the same over-protective page rounding as above. */
+        Elf32_Addr seg_page_start = PAGE_START(phdr->p_vaddr) + load_bias;
+        Elf32_Addr seg_page_end   = PAGE_END(phdr->p_vaddr + phdr->p_memsz) + load_bias;
+        if (addr >= seg_page_start && addr < seg_page_end) {
+            return true;
+        }
+    }
+    return false;
+}
+
 #ifdef ANDROID_ARM_LINKER
 
 #  ifndef PT_ARM_EXIDX
@@ -561,6 +813,30 @@ phdr_table_get_arm_exidx(const Elf32_Phdr* phdr_table,
 }
 #endif /* ANDROID_ARM_LINKER */
 
+/* Return the program header of the ELF file's PT_TLS segment, which
+ * describes its thread-local storage initialization image.
+ *
+ * Input:
+ *   phdr_table  -> program header table
+ *   phdr_count  -> number of entries in tables
+ * Return:
+ *   pointer to the PT_TLS program header, or NULL if there isn't one.
+ */
+const Elf32_Phdr*
+phdr_table_get_tls_segment(const Elf32_Phdr* phdr_table,
+                           int               phdr_count)
+{
+    const Elf32_Phdr* phdr = phdr_table;
+    const Elf32_Phdr* phdr_limit = phdr + phdr_count;
+
+    for (phdr = phdr_table; phdr < phdr_limit; phdr++) {
+        if (phdr->p_type == PT_TLS) {
+            return phdr;
+        }
+    }
+    return NULL;
+}
+
 /* Return the address and size of the ELF file's .dynamic section in memory,
  * or NULL if missing.
  *
@@ -42,26 +42,39 @@ class ElfReader {
   ElfReader(const char* name, int fd);
   ~ElfReader();
 
-  bool Load();
+  bool Load(const android_dlextinfo* extinfo);
 
   size_t phdr_count() { return phdr_num_; }
   Elf32_Addr load_start() { return reinterpret_cast<Elf32_Addr>(load_start_); }
   Elf32_Addr load_size() { return load_size_; }
   Elf32_Addr load_bias() { return load_bias_; }
   const Elf32_Phdr* loaded_phdr() { return loaded_phdr_; }
+  // True if the library was loaded into address space reserved by the caller.
+  bool loaded_in_reserved_space() { return loaded_in_reserved_space_; }
+
+  // Time spent in each phase of Load(), for LD_STATS. Zero unless gLdStats is set.
+  long long read_time_us() { return read_time_us_; }
+  long long reserve_time_us() { return reserve_time_us_; }
+  long long load_time_us() { return load_time_us_; }
 
  private:
+  bool LoadWithStats(const android_dlextinfo* extinfo);
   bool ReadElfHeader();
   bool VerifyElfHeader();
   bool ReadProgramHeader();
-  bool ReserveAddressSpace();
-  bool LoadSegments();
+  bool ReserveAddressSpace(const android_dlextinfo* extinfo);
+  bool LoadSegments(const android_dlextinfo* extinfo);
   bool FindPhdr();
   bool CheckPhdr(Elf32_Addr);
 
   const char* name_;
   int fd_;
 
+  // The start of the file, which usually holds the program header table
+  // as well as the ELF header.
+  uint8_t file_head_[PAGE_SIZE] __attribute__((aligned(8)));
+  size_t file_head_size_;
+
   Elf32_Ehdr header_;
   size_t phdr_num_;
 
@@ -75,9 +88,14 @@ class ElfReader {
   Elf32_Addr load_size_;
   // Load bias.
   Elf32_Addr load_bias_;
+  bool loaded_in_reserved_space_;
 
   // Loaded phdr.
   const Elf32_Phdr* loaded_phdr_;
+
+  long long read_time_us_;
+  long long reserve_time_us_;
+  long long load_time_us_;
 };
 
 size_t
@@ -101,6 +119,24 @@ phdr_table_protect_gnu_relro(const Elf32_Phdr* phdr_table,
                              int               phdr_count,
                              Elf32_Addr        load_bias);
 
+int
+phdr_table_serialize_gnu_relro(const Elf32_Phdr* phdr_table,
+                               int               phdr_count,
+                               Elf32_Addr        load_bias,
+                               int               fd);
+
+int
+phdr_table_map_gnu_relro(const Elf32_Phdr* phdr_table,
+                         int               phdr_count,
+                         Elf32_Addr        load_bias,
+                         int               fd);
+
+bool
+phdr_table_is_in_gnu_relro(const Elf32_Phdr* phdr_table,
+                           int               phdr_count,
+                           Elf32_Addr        load_bias,
+                           Elf32_Addr        addr);
+
 
 #ifdef ANDROID_ARM_LINKER
 int
@@ -111,6 +147,10 @@ phdr_table_get_arm_exidx(const Elf32_Phdr* phdr_table,
                          unsigned*         arm_exidix_count);
 #endif
 
+const Elf32_Phdr*
+phdr_table_get_tls_segment(const Elf32_Phdr* phdr_table,
+                           int               phdr_count);
+
 void
 phdr_table_get_dynamic_section(const Elf32_Phdr* phdr_table,
                                int               phdr_count,
@@ -30,8 +30,13 @@ benchmark_c_flags = \
 
 benchmark_src_files = \
     benchmark_main.cpp \
+    inet_benchmark.cpp \
+    malloc_benchmark.cpp \
     math_benchmark.cpp \
     property_benchmark.cpp \
+    pthread_benchmark.cpp \
+    stdio_benchmark.cpp \
+    stdlib_benchmark.cpp \
     string_benchmark.cpp \
     time_benchmark.cpp \
 
@@ -58,20 +63,30 @@ test_c_flags = \
     -fno-builtin \
 
 test_src_files = \
+    copy_fd_test.cpp \
+    cpu_topology_test.cpp \
     dirent_test.cpp \
     eventfd_test.cpp \
+    fcntl_test.cpp \
     fenv_test.cpp \
+    futex_test.cpp \
     getauxval_test.cpp \
     getcwd_test.cpp \
     inttypes_test.cpp \
+    libc_counters_test.cpp \
     libc_logging_test.cpp \
     libgen_test.cpp \
     malloc_test.cpp \
     math_test.cpp \
     netdb_test.cpp \
     pthread_test.cpp \
+    realpath_cache_test.cpp \
+    remote_memory_test.cpp \
     regex_test.cpp \
+    search_test.cpp \
+    semaphore_test.cpp \
     signal_test.cpp \
+    spawn_test.cpp \
     stack_protector_test.cpp \
     stack_unwinding_test.cpp \
     statvfs_test.cpp \
@@ -80,13 +95,22 @@ test_src_files = \
     string_test.cpp \
     strings_test.cpp \
     stubs_test.cpp \
+    sys_aio_abi_test.cpp \
+    sys_sha1_test.cpp \
+    sys_socket_test.cpp \
     sys_stat_test.cpp \
+    sys_uio_test.cpp \
     system_properties_test.cpp \
     time_test.cpp \
+    trace_events_test.cpp \
+    tree_walk_test.cpp \
     unistd_test.cpp \
+    vmath_test.cpp \
+    wchar_test.cpp \
 
 test_dynamic_ldflags = -Wl,--export-dynamic -Wl,-u,DlSymTestFunction
 test_dynamic_src_files = \
+    dlext_test.cpp \
     dlfcn_test.cpp \
 
 test_fortify_static_libraries = \
@@ -167,6 +191,42 @@ LOCAL_LDFLAGS := -Wl,--hash-style=gnu
 include $(BUILD_SHARED_LIBRARY)
 endif
 
+# Build libdlext_test.so to test android_dlopen_ext(3).
+include $(CLEAR_VARS)
+LOCAL_MODULE := libdlext_test
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
+LOCAL_SRC_FILES := dlext_test_library.cpp
+LOCAL_LDFLAGS := -Wl,-z,relro
+include $(BUILD_SHARED_LIBRARY)
+
+# Build libtest_lazy_binding.so to test dlopen(3) with RTLD_LAZY. It's linked
+# with -z lazy so that it doesn't have DT_BIND_NOW and its PLT GOT entries
+# stay writable.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libtest_lazy_binding
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
+LOCAL_SRC_FILES := lazy_binding_library.cpp
+LOCAL_CFLAGS := -fno-builtin
+LOCAL_LDFLAGS := -Wl,-z,lazy
+include $(BUILD_SHARED_LIBRARY)
+
+# Build libtest_versioned.so to test symbol versioning. It defines two
+# versions of the same symbol.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libtest_versioned
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk $(LOCAL_PATH)/versioned_library.map
+LOCAL_SRC_FILES := versioned_library.cpp
+LOCAL_LDFLAGS := -Wl,--version-script,$(LOCAL_PATH)/versioned_library.map
+include $(BUILD_SHARED_LIBRARY)
+
+# Build libtest_elf_tls.so to test ELF TLS in dlopen(3)ed libraries.
+include $(CLEAR_VARS)
+LOCAL_MODULE := libtest_elf_tls
+LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/Android.mk
+LOCAL_SRC_FILES := elf_tls_library.cpp
+LOCAL_CFLAGS := -ftls-model=global-dynamic
+include $(BUILD_SHARED_LIBRARY)
+
 # -----------------------------------------------------------------------------
 # Unit tests built against glibc.
 # -----------------------------------------------------------------------------
@@ -32,6 +32,10 @@ class Benchmark {
 
   Benchmark* Arg(int x);
 
+  // Also runs the benchmark in 'n' threads at once, each doing the full
+  // number of iterations. Without any calls to this, it runs in one thread.
+  Benchmark* Threads(int n);
+
   const char* Name();
 
   bool ShouldRun(int argc, char* argv[]);
@@ -44,10 +48,14 @@ class Benchmark {
   void (*fn_range_)(int, int);
 
   std::vector<int> args_;
+  std::vector<int> threads_;
 
   void Register(const char* name, void (*fn)(int), void (*fn_range)(int, int));
-  void RunRepeatedlyWithArg(int iterations, int arg);
-  void RunWithArg(int arg);
+  void RunOnce(int iterations, int arg);
+  void RunRepeatedlyWithArg(int iterations, int arg, int threads);
+  void RunWithArg(int arg, int threads);
+
+  static void* RunThread(void* args);
 };
 
 }  // namespace testing
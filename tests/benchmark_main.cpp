@@ -16,21 +16,35 @@
 
 #include "benchmark.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <regex.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include <algorithm>
 #include <string>
 #include <map>
 
-static int64_t gBytesProcessed;
-static int64_t gBenchmarkTotalTimeNs;
-static int64_t gBenchmarkStartTimeNs;
+// Per-thread, so that each thread of a Threads(n) run times itself.
+static __thread int64_t gBytesProcessed;
+static __thread int64_t gBenchmarkTotalTimeNs;
+static __thread int64_t gBenchmarkStartTimeNs;
 
 typedef std::map<std::string, ::testing::Benchmark*> BenchmarkMap;
 typedef BenchmarkMap::iterator BenchmarkMapIt;
 static BenchmarkMap gBenchmarks;
 
+// Command-line options; see Usage.
+enum OutputFormat { kOutputText, kOutputCsv, kOutputJson };
+static OutputFormat gOutputFormat = kOutputText;
+static int gRepetitions = 1;
+static std::vector<int> gCpus;
+static int gWarmupMs = 0;
+static bool gNeedSeparator = false; // Between JSON objects.
+
 static int Round(int n) {
   int base = 1;
   while (base*10 < n) {
@@ -52,13 +66,58 @@ static int64_t NanoTime() {
   return static_cast<int64_t>(t.tv_sec) * 1000000000LL + t.tv_nsec;
 }
 
+// Pins the calling thread to 'cpu', so that a run isn't disturbed by migrations
+// (or by landing on a slower core of a big.LITTLE part).
+static void PinToCpu(int cpu) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+    fprintf(stderr, "couldn't pin to cpu %d: %s\n", cpu, strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Keeps the CPU busy for a while, so the governor has ramped the clock up
+// before the first benchmark rather than during it.
+static void Warmup(int ms) {
+  int64_t end = NanoTime() + static_cast<int64_t>(ms) * 1000000LL;
+  volatile int64_t spin = 0;
+  while (NanoTime() < end) {
+    for (int i = 0; i < 1000; ++i) {
+      spin += i;
+    }
+  }
+}
+
+// The nearest-rank 'p'th percentile of the sorted 'samples'.
+static int64_t Percentile(const std::vector<int64_t>& samples, int p) {
+  size_t rank = (samples.size() * p + 99) / 100;
+  return samples[(rank == 0) ? 0 : rank - 1];
+}
+
 namespace testing {
 
+struct BenchmarkThreadArgs {
+  Benchmark* benchmark;
+  int iterations;
+  int arg;
+  int cpu;
+  pthread_barrier_t* start_barrier;
+  int64_t total_time_ns;
+  int64_t bytes_processed;
+};
+
 Benchmark* Benchmark::Arg(int arg) {
   args_.push_back(arg);
   return this;
 }
 
+Benchmark* Benchmark::Threads(int n) {
+  threads_.push_back(n);
+  return this;
+}
+
 const char* Benchmark::Name() {
   return name_;
 }
@@ -98,20 +157,26 @@ void Benchmark::Register(const char* name, void (*fn)(int), void (*fn_range)(int
 }
 
 void Benchmark::Run() {
-  if (fn_ != NULL) {
-    RunWithArg(0);
-  } else {
-    if (args_.empty()) {
-      fprintf(stderr, "%s: no args!\n", name_);
-      exit(EXIT_FAILURE);
-    }
-    for (size_t i = 0; i < args_.size(); ++i) {
-      RunWithArg(args_[i]);
+  std::vector<int> threads(threads_);
+  if (threads.empty()) {
+    threads.push_back(1);
+  }
+  for (size_t t = 0; t < threads.size(); ++t) {
+    if (fn_ != NULL) {
+      RunWithArg(0, threads[t]);
+    } else {
+      if (args_.empty()) {
+        fprintf(stderr, "%s: no args!\n", name_);
+        exit(EXIT_FAILURE);
+      }
+      for (size_t i = 0; i < args_.size(); ++i) {
+        RunWithArg(args_[i], threads[t]);
+      }
     }
   }
 }
 
-void Benchmark::RunRepeatedlyWithArg(int iterations, int arg) {
+void Benchmark::RunOnce(int iterations, int arg) {
   gBytesProcessed = 0;
   gBenchmarkTotalTimeNs = 0;
   gBenchmarkStartTimeNs = NanoTime();
@@ -125,10 +190,58 @@ void Benchmark::RunRepeatedlyWithArg(int iterations, int arg) {
   }
 }
 
-void Benchmark::RunWithArg(int arg) {
+void* Benchmark::RunThread(void* raw_args) {
+  BenchmarkThreadArgs* args = reinterpret_cast<BenchmarkThreadArgs*>(raw_args);
+  if (args->cpu != -1) {
+    PinToCpu(args->cpu);
+  }
+  pthread_barrier_wait(args->start_barrier);
+  args->benchmark->RunOnce(args->iterations, args->arg);
+  args->total_time_ns = gBenchmarkTotalTimeNs;
+  args->bytes_processed = gBytesProcessed;
+  return NULL;
+}
+
+void Benchmark::RunRepeatedlyWithArg(int iterations, int arg, int threads) {
+  if (threads == 1) {
+    RunOnce(iterations, arg);
+    return;
+  }
+
+  // Each thread does all the iterations, so the time is the mean of the threads'
+  // times (the latency each saw), and the bytes are the total over all of them.
+  std::vector<BenchmarkThreadArgs> args(threads);
+  std::vector<pthread_t> ids(threads);
+  pthread_barrier_t start_barrier;
+  pthread_barrier_init(&start_barrier, NULL, threads);
+  for (int i = 0; i < threads; ++i) {
+    args[i].benchmark = this;
+    args[i].iterations = iterations;
+    args[i].arg = arg;
+    args[i].cpu = gCpus.empty() ? -1 : gCpus[i % gCpus.size()];
+    args[i].start_barrier = &start_barrier;
+    int rc = pthread_create(&ids[i], NULL, RunThread, &args[i]);
+    if (rc != 0) {
+      fprintf(stderr, "%s: couldn't create thread: %s\n", name_, strerror(rc));
+      exit(EXIT_FAILURE);
+    }
+  }
+  int64_t total_time_ns = 0;
+  int64_t bytes_processed = 0;
+  for (int i = 0; i < threads; ++i) {
+    pthread_join(ids[i], NULL);
+    total_time_ns += args[i].total_time_ns;
+    bytes_processed += args[i].bytes_processed;
+  }
+  pthread_barrier_destroy(&start_barrier);
+  gBenchmarkTotalTimeNs = total_time_ns / threads;
+  gBytesProcessed = bytes_processed;
+}
+
+void Benchmark::RunWithArg(int arg, int threads) {
   // run once in case it's expensive
   int iterations = 1;
-  RunRepeatedlyWithArg(iterations, arg);
+  RunRepeatedlyWithArg(iterations, arg, threads);
   while (gBenchmarkTotalTimeNs < 1e9 && iterations < 1e9) {
     int last = iterations;
     if (gBenchmarkTotalTimeNs/iterations == 0) {
@@ -138,15 +251,30 @@ void Benchmark::RunWithArg(int arg) {
     }
     iterations = std::max(last + 1, std::min(iterations + iterations/2, 100*last));
     iterations = Round(iterations);
-    RunRepeatedlyWithArg(iterations, arg);
+    RunRepeatedlyWithArg(iterations, arg, threads);
+  }
+
+  // The run that found the iteration count is the first sample. Timing each
+  // iteration would cost more than many of the things we measure, so the
+  // percentiles are of whole runs' ns/op.
+  std::vector<int64_t> samples;
+  samples.push_back(gBenchmarkTotalTimeNs/iterations);
+  int64_t total_time_ns = gBenchmarkTotalTimeNs;
+  int64_t bytes_processed = gBytesProcessed;
+  for (int i = 1; i < gRepetitions; ++i) {
+    RunRepeatedlyWithArg(iterations, arg, threads);
+    samples.push_back(gBenchmarkTotalTimeNs/iterations);
+    total_time_ns += gBenchmarkTotalTimeNs;
+    bytes_processed += gBytesProcessed;
   }
+  std::sort(samples.begin(), samples.end());
+  int64_t ns_per_op = total_time_ns / (static_cast<int64_t>(iterations) * gRepetitions);
 
-  char throughput[100];
-  throughput[0] = '\0';
-  if (gBenchmarkTotalTimeNs > 0 && gBytesProcessed > 0) {
-    double mib_processed = static_cast<double>(gBytesProcessed)/1e6;
-    double seconds = static_cast<double>(gBenchmarkTotalTimeNs)/1e9;
-    snprintf(throughput, sizeof(throughput), " %8.2f MiB/s", mib_processed/seconds);
+  double mib_per_s = 0.0;
+  if (total_time_ns > 0 && bytes_processed > 0) {
+    double mib_processed = static_cast<double>(bytes_processed)/1e6;
+    double seconds = static_cast<double>(total_time_ns)/1e9;
+    mib_per_s = mib_processed/seconds;
   }
 
   char full_name[100];
@@ -161,9 +289,37 @@ void Benchmark::RunWithArg(int arg) {
   } else {
     snprintf(full_name, sizeof(full_name), "%s", name_);
   }
+  if (threads != 1) {
+    size_t length = strlen(full_name);
+    snprintf(full_name + length, sizeof(full_name) - length, "/threads:%d", threads);
+  }
 
-  printf("%-20s %10lld %10lld%s\n", full_name,
-         static_cast<int64_t>(iterations), gBenchmarkTotalTimeNs/iterations, throughput);
+  int64_t p50 = Percentile(samples, 50);
+  int64_t p90 = Percentile(samples, 90);
+  int64_t p99 = Percentile(samples, 99);
+  if (gOutputFormat == kOutputCsv) {
+    printf("%s,%d,%lld,%lld,%lld,%lld,%lld,%.2f\n", full_name, threads,
+           static_cast<int64_t>(iterations), ns_per_op, p50, p90, p99, mib_per_s);
+  } else if (gOutputFormat == kOutputJson) {
+    printf("%s\n  {\"name\": \"%s\", \"threads\": %d, \"iterations\": %lld, \"ns_per_op\": %lld, "
+           "\"p50_ns\": %lld, \"p90_ns\": %lld, \"p99_ns\": %lld, \"mib_per_s\": %.2f}",
+           gNeedSeparator ? "," : "", full_name, threads, static_cast<int64_t>(iterations),
+           ns_per_op, p50, p90, p99, mib_per_s);
+    gNeedSeparator = true;
+  } else {
+    char throughput[100];
+    throughput[0] = '\0';
+    if (mib_per_s > 0.0) {
+      snprintf(throughput, sizeof(throughput), " %8.2f MiB/s", mib_per_s);
+    }
+    char percentiles[100];
+    percentiles[0] = '\0';
+    if (gRepetitions > 1) {
+      snprintf(percentiles, sizeof(percentiles), " %10lld %10lld %10lld", p50, p90, p99);
+    }
+    printf("%-20s %10lld %10lld%s%s\n", full_name,
+           static_cast<int64_t>(iterations), ns_per_op, percentiles, throughput);
+  }
   fflush(stdout);
 }
 
@@ -186,19 +342,91 @@ void StartBenchmarkTiming() {
   }
 }
 
+static void Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [OPTION]... [REGEX]...\n"
+          "Runs the benchmarks whose names match any REGEX (default: all of them).\n"
+          "  --cpus=N[,N]...    pin the benchmark (thread i of a multithreaded one to the\n"
+          "                     i'th cpu in the list, going round again if need be)\n"
+          "  --format=FORMAT    text (the default), csv, or json\n"
+          "  --repetitions=N    run each benchmark N times, and report percentiles\n"
+          "  --warmup=MS        keep the cpu busy for MS milliseconds first\n",
+          program);
+  exit(EXIT_FAILURE);
+}
+
+// Removes the options from argv, leaving the program name and the regular expressions.
+static int ParseOptions(int argc, char* argv[]) {
+  int new_argc = 1;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--", 2) != 0) {
+      argv[new_argc++] = argv[i];
+    } else if (strncmp(arg, "--cpus=", 7) == 0) {
+      char* p = const_cast<char*>(arg + 7);
+      do {
+        char* end;
+        long cpu = strtol(p, &end, 10);
+        if (end == p || cpu < 0 || cpu >= CPU_SETSIZE || (*end != ',' && *end != '\0')) {
+          Usage(argv[0]);
+        }
+        gCpus.push_back(cpu);
+        p = (*end == ',') ? end + 1 : end;
+      } while (*p != '\0');
+    } else if (strcmp(arg, "--format=text") == 0) {
+      gOutputFormat = kOutputText;
+    } else if (strcmp(arg, "--format=csv") == 0) {
+      gOutputFormat = kOutputCsv;
+    } else if (strcmp(arg, "--format=json") == 0) {
+      gOutputFormat = kOutputJson;
+    } else if (strncmp(arg, "--repetitions=", 14) == 0) {
+      gRepetitions = atoi(arg + 14);
+      if (gRepetitions < 1) {
+        Usage(argv[0]);
+      }
+    } else if (strncmp(arg, "--warmup=", 9) == 0) {
+      gWarmupMs = atoi(arg + 9);
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  argv[new_argc] = NULL;
+  return new_argc;
+}
+
+static void PrintHeader() {
+  if (gOutputFormat == kOutputCsv) {
+    printf("name,threads,iterations,ns_per_op,p50_ns,p90_ns,p99_ns,mib_per_s\n");
+  } else if (gOutputFormat == kOutputJson) {
+    printf("[");
+  } else if (gRepetitions > 1) {
+    printf("%-20s %10s %10s %10s %10s %10s\n", "", "iterations", "ns/op", "p50", "p90", "p99");
+  } else {
+    printf("%-20s %10s %10s\n", "", "iterations", "ns/op");
+  }
+  fflush(stdout);
+}
+
 int main(int argc, char* argv[]) {
   if (gBenchmarks.empty()) {
     fprintf(stderr, "No benchmarks registered!\n");
     exit(EXIT_FAILURE);
   }
 
+  argc = ParseOptions(argc, argv);
+  if (!gCpus.empty()) {
+    PinToCpu(gCpus[0]);
+  }
+  if (gWarmupMs > 0) {
+    Warmup(gWarmupMs);
+  }
+
   bool need_header = true;
   for (BenchmarkMapIt it = gBenchmarks.begin(); it != gBenchmarks.end(); ++it) {
     ::testing::Benchmark* b = it->second;
     if (b->ShouldRun(argc, argv)) {
       if (need_header) {
-        printf("%-20s %10s %10s\n", "", "iterations", "ns/op");
-        fflush(stdout);
+        PrintHeader();
         need_header = false;
       }
       b->Run();
@@ -214,5 +442,8 @@ int main(int argc, char* argv[]) {
     exit(EXIT_FAILURE);
   }
 
+  if (gOutputFormat == kOutputJson) {
+    printf("\n]\n");
+  }
   return 0;
 }
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/copy_fd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+// More than one pipe's worth, and not a multiple of a page.
+static const size_t kSize = 300 * 1024 + 17;
+
+class CopyFdTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    data_.resize(kSize);
+    for (size_t i = 0; i < kSize; ++i) {
+      data_[i] = static_cast<char>(i * 7 + (i >> 11));
+    }
+    char in_template[] = "/data/local/tmp/copy_fd-XXXXXX";
+    in_fd_ = mkstemp(in_template);
+    ASSERT_NE(-1, in_fd_);
+    in_path_ = in_template;
+    ASSERT_EQ(static_cast<ssize_t>(kSize), write(in_fd_, data_.data(), kSize));
+    ASSERT_EQ(0, lseek(in_fd_, 0, SEEK_SET));
+    char out_template[] = "/data/local/tmp/copy_fd-XXXXXX";
+    out_fd_ = mkstemp(out_template);
+    ASSERT_NE(-1, out_fd_);
+    out_path_ = out_template;
+  }
+
+  virtual void TearDown() {
+    close(in_fd_);
+    close(out_fd_);
+    unlink(in_path_.c_str());
+    unlink(out_path_.c_str());
+  }
+
+  // What's in 'fd' from its current offset on.
+  static std::string ReadAll(int fd) {
+    std::string result;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      result.append(buf, n);
+    }
+    return result;
+  }
+
+  std::string data_;
+  int in_fd_;
+  int out_fd_;
+  std::string in_path_;
+  std::string out_path_;
+};
+
+TEST_F(CopyFdTest, file_to_file) {
+  uint64_t copied = 0;
+  ASSERT_EQ(0, android_copy_fd(out_fd_, in_fd_, UINT64_MAX, &copied));
+  ASSERT_EQ(kSize, copied);
+  ASSERT_EQ(0, lseek(out_fd_, 0, SEEK_SET));
+  ASSERT_TRUE(ReadAll(out_fd_) == data_);
+}
+
+TEST_F(CopyFdTest, count) {
+  ASSERT_EQ(100, lseek(in_fd_, 100, SEEK_SET));
+  uint64_t copied = 0;
+  ASSERT_EQ(0, android_copy_fd(out_fd_, in_fd_, 1000, &copied));
+  ASSERT_EQ(1000U, copied);
+  // Both offsets moved on.
+  ASSERT_EQ(1100, lseek(in_fd_, 0, SEEK_CUR));
+  ASSERT_EQ(1000, lseek(out_fd_, 0, SEEK_CUR));
+}
+
+TEST_F(CopyFdTest, socket_to_file) {
+  // sendfile can't read from a socket, so this is spliced through a pipe.
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    close(fds[0]);
+    _exit(android_copy_fd(fds[1], in_fd_, UINT64_MAX, NULL) == 0 ? 0 : 1);
+  }
+  close(fds[1]);
+  uint64_t copied = 0;
+  ASSERT_EQ(0, android_copy_fd(out_fd_, fds[0], UINT64_MAX, &copied));
+  ASSERT_EQ(kSize, copied);
+  close(fds[0]);
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  ASSERT_EQ(0, lseek(out_fd_, 0, SEEK_SET));
+  ASSERT_TRUE(ReadAll(out_fd_) == data_);
+}
+
+TEST_F(CopyFdTest, errors) {
+  uint64_t copied = 123;
+  errno = 0;
+  ASSERT_EQ(-1, android_copy_fd(out_fd_, -1, 10, &copied));
+  ASSERT_EQ(EBADF, errno);
+  ASSERT_EQ(0U, copied);
+
+  // Nothing can copy from a directory.
+  int dir_fd = open("/data/local/tmp", O_RDONLY | O_DIRECTORY);
+  ASSERT_NE(-1, dir_fd);
+  errno = 0;
+  ASSERT_EQ(-1, android_copy_fd(out_fd_, dir_fd, 10, NULL));
+  ASSERT_EQ(EISDIR, errno);
+  close(dir_fd);
+}
+
+#endif // __BIONIC__
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/cpu_topology.h>
+#include <errno.h>
+#include <sched.h>
+
+TEST(cpu_topology, android_get_cpu_topology) {
+  android_cpu_topology_t t;
+  ASSERT_EQ(0, android_get_cpu_topology(&t));
+  ASSERT_GT(t.cpu_count, 0);
+  ASSERT_GT(t.cluster_count, 0U);
+  ASSERT_LE(t.cluster_count, static_cast<size_t>(ANDROID_CPU_CLUSTERS_MAX));
+  ASSERT_TRUE(CPU_ISSET(0, &t.online));
+
+  // Every CPU belongs to exactly one cluster, and shares an L2 with itself.
+  for (int cpu = 0; cpu < t.cpu_count; ++cpu) {
+    int cluster = t.cluster_of_cpu[cpu];
+    ASSERT_GE(cluster, 0);
+    ASSERT_LT(cluster, static_cast<int>(t.cluster_count));
+    ASSERT_TRUE(CPU_ISSET(cpu, &t.clusters[cluster].cpus));
+    ASSERT_TRUE(CPU_ISSET(cpu, &t.l2_shared[cpu]));
+  }
+  for (size_t i = 1; i < t.cluster_count; ++i) {
+    ASSERT_LE(t.clusters[i - 1].capacity, t.clusters[i].capacity);
+  }
+
+  ASSERT_EQ(0, android_refresh_cpu_topology());
+}
+
+TEST(cpu_topology, android_set_thread_cluster) {
+  android_cpu_topology_t t;
+  ASSERT_EQ(0, android_get_cpu_topology(&t));
+
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+
+  size_t cluster = t.cluster_of_cpu[0];
+  ASSERT_EQ(0, android_set_thread_cluster(0, cluster));
+  cpu_set_t now;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(now), &now));
+  for (int cpu = 0; cpu < t.cpu_count; ++cpu) {
+    if (CPU_ISSET(cpu, &now)) {
+      ASSERT_TRUE(CPU_ISSET(cpu, &t.clusters[cluster].cpus));
+    }
+  }
+
+  errno = 0;
+  ASSERT_EQ(-1, android_set_thread_cluster(0, t.cluster_count));
+  ASSERT_EQ(EINVAL, errno);
+
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+}
+
+#endif // __BIONIC__
@@ -20,6 +20,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -179,3 +181,35 @@ TEST(dirent, rewinddir) {
     ASSERT_EQ(pass1[i], pass2[i]);
   }
 }
+
+TEST(dirent, readdir_many_entries) {
+  // Enough entries to take several getdents(2) calls to read.
+  char dir_template[] = "/data/local/tmp/dirent-XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir_template) != NULL);
+  std::string dir(dir_template);
+  const size_t count = 3000;
+  for (size_t i = 0; i < count; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "/file-with-a-longish-name-%zu", i);
+    int fd = open((dir + name).c_str(), O_CREAT | O_WRONLY, 0600);
+    ASSERT_NE(-1, fd);
+    close(fd);
+  }
+
+  DIR* d = opendir(dir.c_str());
+  ASSERT_TRUE(d != NULL);
+  std::set<std::string> name_set;
+  dirent* e;
+  while ((e = readdir(d)) != NULL) {
+    ASSERT_TRUE(name_set.insert(e->d_name).second) << e->d_name;
+  }
+  ASSERT_EQ(closedir(d), 0);
+
+  ASSERT_EQ(count + 2, name_set.size());
+  for (std::set<std::string>::iterator it = name_set.begin(); it != name_set.end(); ++it) {
+    if (*it != "." && *it != "..") {
+      ASSERT_EQ(0, unlink((dir + "/" + *it).c_str()));
+    }
+  }
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+}
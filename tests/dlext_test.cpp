@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BIONIC__)
+#include <android/dlext.h>
+
+#define ASSERT_DL_NOTNULL(ptr) \
+    ASSERT_TRUE(ptr != NULL) << "dlerror: " << dlerror()
+
+#define ASSERT_DL_ZERO(i) \
+    ASSERT_EQ(0, i) << "dlerror: " << dlerror()
+
+typedef int (*fn)(void);
+#define LIBNAME "libdlext_test.so"
+#define LIBPATH "/system/lib/" LIBNAME
+#define LIBSIZE 1024*1024 // how much address space to reserve for it
+
+class DlExtTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    handle_ = NULL;
+    dlerror(); // Clear any pending errors.
+  }
+
+  virtual void TearDown() {
+    if (handle_ != NULL) {
+      ASSERT_DL_ZERO(dlclose(handle_));
+    }
+  }
+
+  void CheckLibrary() {
+    fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+    ASSERT_DL_NOTNULL(f);
+    EXPECT_EQ(4, f());
+  }
+
+  void* handle_;
+};
+
+TEST_F(DlExtTest, ExtInfoNull) {
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, NULL);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+}
+
+TEST_F(DlExtTest, ExtInfoNoFlags) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+}
+
+TEST_F(DlExtTest, ExtInfoInvalidFlags) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ~ANDROID_DLEXT_VALID_FLAG_BITS;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_TRUE(handle_ == NULL);
+  ASSERT_TRUE(strstr(dlerror(), "invalid extended flags") != NULL);
+}
+
+TEST_F(DlExtTest, Readahead) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_READAHEAD;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+}
+
+TEST_F(DlExtTest, Reserved) {
+  void* start = mmap(NULL, LIBSIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_TRUE(start != MAP_FAILED);
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_RESERVED_ADDRESS;
+  extinfo.reserved_addr = start;
+  extinfo.reserved_size = LIBSIZE;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_GE(reinterpret_cast<char*>(f), reinterpret_cast<char*>(start));
+  EXPECT_LT(reinterpret_cast<char*>(f), reinterpret_cast<char*>(start) + LIBSIZE);
+  EXPECT_EQ(4, f());
+
+  // Unloading must leave the range reserved for us, rather than unmapping it.
+  ASSERT_DL_ZERO(dlclose(handle_));
+  handle_ = NULL;
+  ASSERT_EQ(0, munmap(start, LIBSIZE));
+}
+
+TEST_F(DlExtTest, ReservedTooSmall) {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  void* start = mmap(NULL, page_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_TRUE(start != MAP_FAILED);
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_RESERVED_ADDRESS;
+  extinfo.reserved_addr = start;
+  extinfo.reserved_size = page_size;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  EXPECT_EQ(NULL, handle_);
+  munmap(start, page_size);
+}
+
+TEST_F(DlExtTest, ReservedHint) {
+  void* start = mmap(NULL, LIBSIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_TRUE(start != MAP_FAILED);
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_RESERVED_ADDRESS_HINT;
+  extinfo.reserved_addr = start;
+  extinfo.reserved_size = LIBSIZE;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_GE(reinterpret_cast<char*>(f), reinterpret_cast<char*>(start));
+  EXPECT_LT(reinterpret_cast<char*>(f), reinterpret_cast<char*>(start) + LIBSIZE);
+  EXPECT_EQ(4, f());
+  ASSERT_DL_ZERO(dlclose(handle_));
+  handle_ = NULL;
+  munmap(start, LIBSIZE);
+}
+
+TEST_F(DlExtTest, ReservedHintTooSmall) {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  void* start = mmap(NULL, page_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_TRUE(start != MAP_FAILED);
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_RESERVED_ADDRESS_HINT;
+  extinfo.reserved_addr = start;
+  extinfo.reserved_size = page_size;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+  EXPECT_TRUE(reinterpret_cast<char*>(f) < reinterpret_cast<char*>(start) ||
+              reinterpret_cast<char*>(f) >= reinterpret_cast<char*>(start) + page_size);
+  EXPECT_EQ(4, f());
+  munmap(start, page_size);
+}
+
+TEST_F(DlExtTest, LibraryFd) {
+  int fd = open(LIBPATH, O_RDONLY | O_CLOEXEC);
+  ASSERT_NE(-1, fd) << strerror(errno);
+  // Move the offset to check that the linker doesn't depend on it.
+  ASSERT_EQ(1, lseek(fd, 1, SEEK_SET));
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_USE_LIBRARY_FD;
+  extinfo.library_fd = fd;
+  // The name need not be a path the linker could find on its own.
+  handle_ = android_dlopen_ext("/does/not/exist/" LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+  // The linker must leave the caller's fd, and its offset, alone.
+  EXPECT_EQ(1, lseek(fd, 0, SEEK_CUR));
+  close(fd);
+}
+
+TEST_F(DlExtTest, GetStats) {
+  handle_ = dlopen(LIBNAME, RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle_);
+  fn f = reinterpret_cast<fn>(dlsym(handle_, "getRandomNumber"));
+  ASSERT_DL_NOTNULL(f);
+
+  // Asking for nothing still says how many libraries there are.
+  size_t linker_bytes = 0;
+  size_t count = android_dl_get_stats(NULL, 0, &linker_bytes);
+  ASSERT_GT(count, 0U);
+  EXPECT_GT(linker_bytes, 0U);
+
+  android_dl_library_stats stats[count];
+  ASSERT_EQ(count, android_dl_get_stats(stats, count, NULL));
+  bool found = false;
+  for (size_t i = 0; i < count; ++i) {
+    if (strcmp(stats[i].name, LIBNAME) == 0) {
+      found = true;
+      char* base = reinterpret_cast<char*>(stats[i].base);
+      EXPECT_TRUE(reinterpret_cast<char*>(f) >= base &&
+                  reinterpret_cast<char*>(f) < base + stats[i].size);
+      size_t page_size = sysconf(_SC_PAGESIZE);
+      EXPECT_LE(stats[i].private_dirty_pages + stats[i].clean_pages,
+                (stats[i].size + page_size - 1) / page_size);
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST_F(DlExtTest, DumpStats) {
+  handle_ = dlopen(LIBNAME, RTLD_NOW);
+  ASSERT_DL_NOTNULL(handle_);
+
+  char file[] = "/data/local/tmp/dlext_test.stats.XXXXXX";
+  int fd = mkstemp(file);
+  ASSERT_NE(-1, fd) << strerror(errno);
+  unlink(file);
+  android_dl_dump_stats(fd);
+
+  char buf[4096];
+  ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+  close(fd);
+  ASSERT_GT(n, 0);
+  buf[n] = '\0';
+  EXPECT_TRUE(strstr(buf, "linker: ") == buf);
+}
+
+class DlExtRelroSharingTest : public DlExtTest {
+ protected:
+  virtual void SetUp() {
+    DlExtTest::SetUp();
+    strcpy(relro_file_, "/data/local/tmp/libdlext_test.relro.XXXXXX");
+    relro_fd_ = mkstemp(relro_file_);
+    ASSERT_NE(-1, relro_fd_) << strerror(errno);
+  }
+
+  virtual void TearDown() {
+    close(relro_fd_);
+    unlink(relro_file_);
+    DlExtTest::TearDown();
+  }
+
+  char relro_file_[PATH_MAX];
+  int relro_fd_;
+};
+
+TEST_F(DlExtRelroSharingTest, WriteRelro) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_WRITE_RELRO;
+  extinfo.relro_fd = relro_fd_;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+
+  struct stat sb;
+  ASSERT_EQ(0, fstat(relro_fd_, &sb));
+  ASSERT_GT(sb.st_size, 0);
+  ASSERT_EQ(0, sb.st_size % sysconf(_SC_PAGESIZE));
+}
+
+TEST_F(DlExtRelroSharingTest, UseRelro) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_WRITE_RELRO;
+  extinfo.relro_fd = relro_fd_;
+  void* writer = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(writer);
+  ASSERT_DL_ZERO(dlclose(writer));
+
+  // The library may well come back at a different address, in which case
+  // nothing gets shared, but it must still work.
+  extinfo.flags = ANDROID_DLEXT_USE_RELRO;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+}
+
+TEST_F(DlExtRelroSharingTest, UseEmptyRelro) {
+  android_dlextinfo extinfo;
+  memset(&extinfo, 0, sizeof(extinfo));
+  extinfo.flags = ANDROID_DLEXT_USE_RELRO;
+  extinfo.relro_fd = relro_fd_;
+  handle_ = android_dlopen_ext(LIBNAME, RTLD_NOW, &extinfo);
+  ASSERT_DL_NOTNULL(handle_);
+  CheckLibrary();
+}
+
+#endif
@@ -17,10 +17,13 @@
 #include <gtest/gtest.h>
 
 #include <dlfcn.h>
+#include <errno.h>
 #include <libgen.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <string>
 
@@ -50,6 +53,22 @@ TEST(dlfcn, dlsym_in_self) {
   ASSERT_EQ(0, dlclose(self));
 }
 
+TEST(dlfcn, dlsym_repeated) {
+  void* self = dlopen(NULL, RTLD_NOW);
+  ASSERT_TRUE(self != NULL);
+
+  // Repeated lookups of the same name, interleaved with other names, must
+  // keep giving the same answers.
+  void* sym = dlsym(self, "DlSymTestFunction");
+  ASSERT_TRUE(sym != NULL);
+  for (size_t i = 0; i < 64; ++i) {
+    ASSERT_EQ(sym, dlsym(self, "DlSymTestFunction"));
+    ASSERT_TRUE(dlsym(self, "dlsym_repeated_does_not_exist") == NULL);
+  }
+
+  ASSERT_EQ(0, dlclose(self));
+}
+
 TEST(dlfcn, dlopen_failure) {
   void* self = dlopen("/does/not/exist", RTLD_NOW);
   ASSERT_TRUE(self == NULL);
@@ -188,7 +207,28 @@ TEST(dlfcn, dladdr_invalid) {
   ASSERT_TRUE(dlerror() == NULL); // dladdr(3) doesn't set dlerror(3).
 }
 
-// Our dynamic linker doesn't support GNU hash tables.
+#if defined(__BIONIC__)
+TEST(dlfcn, dlopen_already_loaded) {
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  // Loaded libraries are found by basename, however they're named.
+  void* handle2 = dlopen("/system/lib/libc.so", RTLD_NOW);
+  ASSERT_EQ(handle, handle2);
+
+  // ...and by address.
+  void* sym = dlsym(handle, "strlen");
+  ASSERT_TRUE(sym != NULL) << dlerror();
+  Dl_info info;
+  ASSERT_NE(0, dladdr(sym, &info));
+  ASSERT_STREQ("libc.so", info.dli_fname);
+  ASSERT_STREQ("strlen", info.dli_sname);
+
+  ASSERT_EQ(0, dlclose(handle2));
+  ASSERT_EQ(0, dlclose(handle));
+}
+#endif
+
 #if defined(__BIONIC__)
 // GNU-style ELF hash tables are incompatible with the MIPS ABI.
 // MIPS requires .dynsym to be sorted to match the GOT but GNU-style requires sorting by hash code.
@@ -196,12 +236,172 @@ TEST(dlfcn, dladdr_invalid) {
 TEST(dlfcn, dlopen_library_with_only_gnu_hash) {
   dlerror(); // Clear any pending errors.
   void* handle = dlopen("no-elf-hash-table-library.so", RTLD_NOW);
-  ASSERT_TRUE(handle == NULL);
-  ASSERT_STREQ("dlopen failed: empty/missing DT_HASH in \"no-elf-hash-table-library.so\" (built with --hash-style=gnu?)", dlerror());
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  // A miss should be rejected (by the Bloom filter or the chain walk) cleanly.
+  void* sym = dlsym(handle, "this_symbol_does_not_exist");
+  ASSERT_TRUE(sym == NULL);
+  ASSERT_SUBSTR("undefined symbol: this_symbol_does_not_exist", dlerror());
+
+  ASSERT_EQ(0, dlclose(handle));
 }
 #endif
 #endif
 
+#if defined(__BIONIC__)
+TEST(dlfcn, dlopen_lazy) {
+  dlerror(); // Clear any pending errors.
+  void* handle = dlopen("libtest_lazy_binding.so", RTLD_LAZY);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  typedef size_t (*LazyBindingStrlenFn)(const char*);
+  LazyBindingStrlenFn fn = reinterpret_cast<LazyBindingStrlenFn>(dlsym(handle, "LazyBindingStrlen"));
+  ASSERT_TRUE(fn != NULL) << dlerror();
+
+  // The first call binds strlen; the second goes straight through the GOT.
+  errno = 1234;
+  ASSERT_EQ(5U, fn("hello"));
+  ASSERT_EQ(1234, errno);
+  ASSERT_EQ(3U, fn("abc"));
+
+  ASSERT_EQ(0, dlclose(handle));
+}
+
+TEST(dlfcn, dlsym_versioned) {
+  void* handle = dlopen("libtest_versioned.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  // An unversioned lookup gets the default version, not the hidden old one.
+  typedef int (*VersionedFn)();
+  VersionedFn fn = reinterpret_cast<VersionedFn>(dlsym(handle, "versioned_function"));
+  ASSERT_TRUE(fn != NULL) << dlerror();
+  ASSERT_EQ(2, fn());
+
+  ASSERT_EQ(0, dlclose(handle));
+}
+
+// The linker doesn't handle MIPS TLS relocations.
+#if !defined(__mips__)
+typedef int (*ElfTlsIncrementFn)();
+typedef void* (*ElfTlsBufferFn)();
+
+struct elf_tls_thread_arg_t {
+  ElfTlsIncrementFn increment;
+  ElfTlsBufferFn buffer;
+  void* main_buffer;
+  bool ok;
+};
+
+static void* ElfTlsThread(void* p) {
+  elf_tls_thread_arg_t* arg = reinterpret_cast<elf_tls_thread_arg_t*>(p);
+  // A new thread gets freshly initialized copies of the variables.
+  void* buffer = arg->buffer();
+  arg->ok = (arg->increment() == 43 && buffer != NULL && buffer != arg->main_buffer);
+  return NULL;
+}
+
+TEST(dlfcn, elf_tls) {
+  void* handle = dlopen("libtest_elf_tls.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+  elf_tls_thread_arg_t arg;
+  arg.increment = reinterpret_cast<ElfTlsIncrementFn>(dlsym(handle, "elf_tls_increment"));
+  ASSERT_TRUE(arg.increment != NULL) << dlerror();
+  arg.buffer = reinterpret_cast<ElfTlsBufferFn>(dlsym(handle, "elf_tls_buffer"));
+  ASSERT_TRUE(arg.buffer != NULL) << dlerror();
+
+  ASSERT_EQ(43, arg.increment());
+  ASSERT_EQ(44, arg.increment());
+  arg.main_buffer = arg.buffer();
+  ASSERT_TRUE(arg.main_buffer != NULL);
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ElfTlsThread, &arg));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_TRUE(arg.ok);
+  // The other thread didn't touch our copy.
+  ASSERT_EQ(45, arg.increment());
+  ASSERT_EQ(0, dlclose(handle));
+
+  // Reloading the library starts again from its initial values.
+  handle = dlopen("libtest_elf_tls.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+  arg.increment = reinterpret_cast<ElfTlsIncrementFn>(dlsym(handle, "elf_tls_increment"));
+  ASSERT_TRUE(arg.increment != NULL) << dlerror();
+  ASSERT_EQ(43, arg.increment());
+  ASSERT_EQ(0, dlclose(handle));
+}
+#endif
+
+static volatile bool gDladdrThreadsStop;
+
+static void* DladdrThread(void*) {
+  while (!gDladdrThreadsStop) {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&DlSymTestFunction), &info) == 0 ||
+        strcmp(info.dli_sname, "DlSymTestFunction") != 0) {
+      return reinterpret_cast<void*>(1);
+    }
+  }
+  return NULL;
+}
+
+// dladdr(3) doesn't take the dl lock, so check it copes with libraries
+// coming and going underneath it.
+TEST(dlfcn, dladdr_concurrent_with_dlopen) {
+  gDladdrThreadsStop = false;
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, DladdrThread, NULL));
+  }
+
+  for (size_t i = 0; i < 100; ++i) {
+    void* handle = dlopen("libtest_lazy_binding.so", RTLD_NOW);
+    ASSERT_TRUE(handle != NULL) << dlerror();
+    ASSERT_EQ(0, dlclose(handle));
+  }
+
+  gDladdrThreadsStop = true;
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_TRUE(result == NULL);
+  }
+}
+#endif
+
+#if defined(__BIONIC__)
+static void* DlopenLoadedThread(void*) {
+  for (size_t i = 0; i < 1000; ++i) {
+    void* handle = dlopen("libtest_lazy_binding.so", RTLD_NOW);
+    if (handle == NULL || dlsym(handle, "LazyBindingStrlen") == NULL || dlclose(handle) != 0) {
+      return reinterpret_cast<void*>(1);
+    }
+  }
+  return NULL;
+}
+
+// dlopen(3) of a library that's already loaded doesn't take the dl lock, so
+// check that the reference counting holds up with several threads at once.
+TEST(dlfcn, dlopen_already_loaded_concurrent) {
+  void* handle = dlopen("libtest_lazy_binding.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL) << dlerror();
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, DlopenLoadedThread, NULL));
+  }
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_TRUE(result == NULL);
+  }
+
+  // Our reference is still good.
+  ASSERT_TRUE(dlsym(handle, "LazyBindingStrlen") != NULL) << dlerror();
+  ASSERT_EQ(0, dlclose(handle));
+}
+#endif
+
 TEST(dlfcn, dlopen_bad_flags) {
   dlerror(); // Clear any pending errors.
   void* handle;
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+// Thread-local variables in a dlopen(3)ed library, accessed through
+// __tls_get_addr: one initialized from .tdata, one zero-filled in .tbss.
+static __thread int tls_counter = 42;
+static __thread char tls_buffer[256];
+
+extern "C" int elf_tls_increment() {
+  return ++tls_counter;
+}
+
+extern "C" void* elf_tls_buffer() {
+  // Every thread sees its own zeroed buffer the first time.
+  for (size_t i = 0; i < sizeof(tls_buffer); ++i) {
+    if (tls_buffer[i] != 0) {
+      return 0;
+    }
+  }
+  tls_buffer[0] = 1;
+  return tls_buffer;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+TEST(fcntl, splice) {
+  int in[2];
+  int out[2];
+  ASSERT_EQ(0, pipe(in));
+  ASSERT_EQ(0, pipe(out));
+  ASSERT_EQ(5, write(in[1], "hello", 5));
+  ASSERT_EQ(5, splice(in[0], NULL, out[1], NULL, 5, SPLICE_F_MOVE));
+  char buf[8];
+  ASSERT_EQ(5, read(out[0], buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp("hello", buf, 5));
+
+  // Neither end a pipe.
+  int in_fd = open("/proc/version", O_RDONLY);
+  ASSERT_NE(-1, in_fd);
+  int out_fd = open("/dev/null", O_WRONLY);
+  ASSERT_NE(-1, out_fd);
+  errno = 0;
+  ASSERT_EQ(-1, splice(in_fd, NULL, out_fd, NULL, 5, 0));
+  ASSERT_EQ(EINVAL, errno);
+  close(in_fd);
+  close(out_fd);
+
+  close(in[0]);
+  close(in[1]);
+  close(out[0]);
+  close(out[1]);
+}
+
+TEST(fcntl, tee) {
+  int in[2];
+  int out[2];
+  ASSERT_EQ(0, pipe(in));
+  ASSERT_EQ(0, pipe(out));
+  ASSERT_EQ(5, write(in[1], "hello", 5));
+  ASSERT_EQ(5, tee(in[0], out[1], 5, 0));
+  // Both pipes have the data now.
+  char buf[8];
+  ASSERT_EQ(5, read(out[0], buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp("hello", buf, 5));
+  ASSERT_EQ(5, read(in[0], buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp("hello", buf, 5));
+  close(in[0]);
+  close(in[1]);
+  close(out[0]);
+  close(out[1]);
+}
+
+TEST(fcntl, vmsplice) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  char hello[] = "hello";
+  char world[] = " world";
+  iovec iov[2];
+  iov[0].iov_base = hello;
+  iov[0].iov_len = 5;
+  iov[1].iov_base = world;
+  iov[1].iov_len = 6;
+  ASSERT_EQ(11, vmsplice(fds[1], iov, 2, 0));
+  char buf[16];
+  ASSERT_EQ(11, read(fds[0], buf, sizeof(buf)));
+  ASSERT_EQ(0, memcmp("hello world", buf, 11));
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(fcntl, fallocate) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  int fd = fileno(fp);
+
+  // Past 4GiB, so a lost high word shows up in the size.
+  off64_t offset = 0x100000000LL;
+  int rc = fallocate64(fd, 0, offset, 4096);
+  if (rc == -1 && errno == EOPNOTSUPP) {
+    GTEST_LOG_(INFO) << "fallocate unsupported on this file system";
+  } else {
+    ASSERT_EQ(0, rc);
+    struct stat64 sb;
+    ASSERT_EQ(0, fstat64(fd, &sb));
+    ASSERT_EQ(offset + 4096, sb.st_size);
+
+    // KEEP_SIZE allocates without moving EOF.
+    ASSERT_EQ(0, fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, 8192));
+    ASSERT_EQ(0, fstat64(fd, &sb));
+    ASSERT_EQ(offset + 4096, sb.st_size);
+
+    ASSERT_EQ(0, posix_fallocate(fd, 0, 1));
+  }
+
+  // posix_fallocate reports its error rather than setting errno.
+  errno = 0;
+  ASSERT_EQ(EINVAL, posix_fallocate(fd, 0, -1));
+  ASSERT_EQ(0, errno);
+
+  fclose(fp);
+}
+
+TEST(fcntl, posix_fadvise) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  int fd = fileno(fp);
+
+  ASSERT_EQ(0, posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL));
+  ASSERT_EQ(0, posix_fadvise64(fd, 0x100000000LL, 4096, POSIX_FADV_DONTNEED));
+
+  errno = 0;
+  ASSERT_EQ(EINVAL, posix_fadvise(fd, 0, 0, -1));
+  ASSERT_EQ(EBADF, posix_fadvise(-1, 0, 0, POSIX_FADV_NORMAL));
+  ASSERT_EQ(0, errno);
+
+  fclose(fp);
+}
+
+TEST(fcntl, sync_file_range) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  int fd = fileno(fp);
+  ASSERT_EQ(5, write(fd, "hello", 5));
+
+  ASSERT_EQ(0, sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE));
+  ASSERT_EQ(0, sync_file_range(fd, 0x100000000LL, 4096,
+                               SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER));
+
+  ASSERT_EQ(-1, sync_file_range(fd, -1, 0, 0));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(-1, sync_file_range(fd, 0, 0, ~0U));
+  ASSERT_EQ(EINVAL, errno);
+
+  fclose(fp);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/futex.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+static const timespec k10ms = { 0, 10000000 };
+
+TEST(futex, android_futex_wait_mismatch_and_timeout) {
+  volatile int32_t word = 1;
+  ASSERT_EQ(EAGAIN, android_futex_wait(&word, 0, NULL));
+  ASSERT_EQ(ETIMEDOUT, android_futex_wait(&word, 1, &k10ms));
+  timespec bad = { 0, 1000000000 };
+  ASSERT_EQ(EINVAL, android_futex_wait(&word, 1, &bad));
+  ASSERT_EQ(0, android_futex_wake(&word, INT_MAX));
+}
+
+static void* FutexWaiterFn(void* arg) {
+  volatile int32_t* word = reinterpret_cast<volatile int32_t*>(arg);
+  while (*word == 0) {
+    android_futex_wait(word, 0, NULL);
+  }
+  return NULL;
+}
+
+TEST(futex, android_futex_wake) {
+  volatile int32_t word = 0;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, FutexWaiterFn, const_cast<int32_t*>(&word)));
+  usleep(10000);
+  word = 1;
+  android_futex_wake(&word, 1);
+  ASSERT_EQ(0, pthread_join(t, NULL));
+}
+
+static volatile int32_t gEventWaitersReleased = 0;
+
+static void* EventWaiterFn(void* arg) {
+  android_event_wait(reinterpret_cast<android_event_t*>(arg));
+  __sync_fetch_and_add(&gEventWaitersReleased, 1);
+  return NULL;
+}
+
+TEST(futex, android_event_manual_reset) {
+  android_event_t event;
+  android_event_init(&event, ANDROID_EVENT_MANUAL_RESET, 0);
+  ASSERT_EQ(ETIMEDOUT, android_event_timedwait(&event, &k10ms));
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, EventWaiterFn, &event));
+  }
+  usleep(10000);
+  android_event_set(&event);
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+
+  // A manual-reset event stays set until it's reset.
+  ASSERT_EQ(0, android_event_wait(&event));
+  android_event_reset(&event);
+  ASSERT_EQ(ETIMEDOUT, android_event_timedwait(&event, &k10ms));
+}
+
+TEST(futex, android_event_auto_reset) {
+  android_event_t event = ANDROID_EVENT_INITIALIZER(ANDROID_EVENT_AUTO_RESET);
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, EventWaiterFn, &event));
+  }
+  usleep(10000);
+  // Each set releases exactly one waiter.
+  gEventWaitersReleased = 0;
+  for (int i = 0; i < 4; ++i) {
+    android_event_set(&event);
+    while (gEventWaitersReleased < i + 1) {
+      usleep(1000);
+    }
+    usleep(1000);
+    ASSERT_EQ(i + 1, gEventWaitersReleased);
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(ETIMEDOUT, android_event_timedwait(&event, &k10ms));
+
+  android_event_set(&event);
+  ASSERT_EQ(0, android_event_wait(&event));
+  ASSERT_EQ(ETIMEDOUT, android_event_timedwait(&event, &k10ms));
+}
+
+static void* LatchFn(void* arg) {
+  android_latch_t* latch = reinterpret_cast<android_latch_t*>(arg);
+  android_latch_count_down(latch);
+  android_latch_wait(latch);
+  return NULL;
+}
+
+TEST(futex, android_latch) {
+  android_latch_t latch = ANDROID_LATCH_INITIALIZER(5);
+  ASSERT_EQ(ETIMEDOUT, android_latch_timedwait(&latch, &k10ms));
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, LatchFn, &latch));
+  }
+  ASSERT_EQ(ETIMEDOUT, android_latch_timedwait(&latch, &k10ms));
+  android_latch_count_down(&latch);
+  ASSERT_EQ(0, android_latch_wait(&latch));
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+
+  // An open latch stays open.
+  android_latch_count_down(&latch);
+  ASSERT_EQ(0, android_latch_wait(&latch));
+}
+
+#endif // __BIONIC__
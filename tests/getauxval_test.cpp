@@ -32,7 +32,9 @@
 
 #if defined(GETAUXVAL_CAN_COMPILE)
 
+#include <fcntl.h>
 #include <sys/auxv.h>
+#include <unistd.h>
 
 TEST(getauxval, expected_values) {
   ASSERT_EQ((unsigned long int) 0, getauxval(AT_SECURE));
@@ -52,4 +54,26 @@ TEST(getauxval, unexpected_values) {
   ASSERT_EQ((unsigned long int) 0, getauxval(0xdeadbeef));
 }
 
+TEST(getauxval, matches_proc_self_auxv) {
+  int fd = open("/proc/self/auxv", O_RDONLY);
+  ASSERT_NE(-1, fd);
+  // Each entry is a type and a value, both word-sized.
+  struct { unsigned long type; unsigned long value; } entries[64];
+  ssize_t byte_count = read(fd, entries, sizeof(entries));
+  close(fd);
+  ASSERT_GT(byte_count, 0);
+
+  // Every type the kernel passed, not just the ones above.
+  size_t count = byte_count / sizeof(entries[0]);
+  for (size_t i = 0; i < count && entries[i].type != AT_NULL; ++i) {
+#if !defined(__BIONIC__)
+    // glibc reports its own idea of the hwcaps on some architectures.
+    if (entries[i].type == AT_HWCAP) {
+      continue;
+    }
+#endif
+    ASSERT_EQ(entries[i].value, getauxval(entries[i].type)) << entries[i].type;
+  }
+}
+
 #endif /* GETAUXVAL_CAN_COMPILE */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// Avoid optimization.
+static int result;
+
+static void BM_inet_addr(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    result += inet_addr("192.168.100.254");
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_inet_addr);
+
+static void BM_inet_pton_ipv4(int iters) {
+  in_addr addr;
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    result += inet_pton(AF_INET, "192.168.100.254", &addr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_inet_pton_ipv4);
+
+static void BM_inet_pton_ipv6(int iters) {
+  in6_addr addr;
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    result += inet_pton(AF_INET6, "2001:db8:85a3::8a2e:370:7334", &addr);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_inet_pton_ipv6);
+
+static void BM_inet_ntop_ipv4(int iters) {
+  static const unsigned char addr[4] = { 192, 168, 100, 254 };
+  char buf[INET_ADDRSTRLEN];
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    result += (inet_ntop(AF_INET, addr, buf, sizeof(buf)) != NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_inet_ntop_ipv4);
+
+static void BM_inet_ntop_ipv6(int iters) {
+  static const unsigned char addr[16] = {
+    0x20, 0x01, 0x0d, 0xb8, 0x85, 0xa3, 0, 0, 0, 0, 0x8a, 0x2e, 0x03, 0x70, 0x73, 0x34
+  };
+  char buf[INET6_ADDRSTRLEN];
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    result += (inet_ntop(AF_INET6, addr, buf, sizeof(buf)) != NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_inet_ntop_ipv6);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/libc_counters.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/system_properties.h>
+#include <unistd.h>
+
+static uint64_t read_counter(int counter) {
+  uint64_t values[ANDROID_LIBC_COUNTER_COUNT];
+  EXPECT_EQ(static_cast<size_t>(ANDROID_LIBC_COUNTER_COUNT),
+            android_libc_counters_read(values, ANDROID_LIBC_COUNTER_COUNT));
+  return values[counter];
+}
+
+static void* LookUpProperties(void*) {
+  char value[PROP_VALUE_MAX];
+  for (size_t i = 0; i < 10; ++i) {
+    __system_property_get("ro.build.version.sdk", value);
+  }
+  return NULL;
+}
+
+TEST(libc_counters, exited_threads_still_count) {
+  uint64_t before = read_counter(ANDROID_LIBC_COUNTER_PROPERTY_LOOKUPS);
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, LookUpProperties, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_LE(before + 10, read_counter(ANDROID_LIBC_COUNTER_PROPERTY_LOOKUPS));
+}
+
+TEST(libc_counters, dlopen) {
+  uint64_t before = read_counter(ANDROID_LIBC_COUNTER_DLOPEN);
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL);
+  ASSERT_LE(before + 1, read_counter(ANDROID_LIBC_COUNTER_DLOPEN));
+  dlclose(handle);
+}
+
+TEST(libc_counters, names_and_dump) {
+  for (int i = 0; i < ANDROID_LIBC_COUNTER_COUNT; ++i) {
+    ASSERT_TRUE(android_libc_counter_name(i) != NULL);
+  }
+  ASSERT_TRUE(android_libc_counter_name(ANDROID_LIBC_COUNTER_COUNT) == NULL);
+  ASSERT_TRUE(android_libc_counter_name(-1) == NULL);
+
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(0, android_libc_counters_dump(fileno(fp)));
+  rewind(fp);
+  char line[128];
+  int lines = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    ++lines;
+  }
+  ASSERT_EQ(ANDROID_LIBC_COUNTER_COUNT, lines);
+  fclose(fp);
+
+  ASSERT_EQ(-1, android_libc_counters_dump(-1));
+}
+
+#endif // __BIONIC__
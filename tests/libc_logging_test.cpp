@@ -142,4 +142,62 @@ TEST(libc_logging, lld_LLONG_MIN) {
   EXPECT_STREQ("-9223372036854775808", buf);
 }
 
+TEST(libc_logging, f) {
+  char buf[BUFSIZ];
+  __libc_format_buffer(buf, sizeof(buf), "%f", 1.5);
+  EXPECT_STREQ("1.500000", buf);
+  __libc_format_buffer(buf, sizeof(buf), "%.3f", -0.125);
+  EXPECT_STREQ("-0.125", buf);
+  __libc_format_buffer(buf, sizeof(buf), "%.2f", 0.999);
+  EXPECT_STREQ("1.00", buf);
+  __libc_format_buffer(buf, sizeof(buf), "%06.2f", -3.14159);
+  EXPECT_STREQ("-03.14", buf);
+  __libc_format_buffer(buf, sizeof(buf), "%+.0f", 2.0);
+  EXPECT_STREQ("+2", buf);
+  __libc_format_buffer(buf, sizeof(buf), "%f,%f", 1.0 / 0.0, -1.0 / 0.0);
+  EXPECT_STREQ("inf,-inf", buf);
+}
+
+TEST(libc_logging, sign_and_padding) {
+  char buf[BUFSIZ];
+  __libc_format_buffer(buf, sizeof(buf), "a%05dz", -42);
+  EXPECT_STREQ("a-0042z", buf);
+  __libc_format_buffer(buf, sizeof(buf), "a%+dz% dz", 42, 42);
+  EXPECT_STREQ("a+42z 42z", buf);
+  __libc_format_buffer(buf, sizeof(buf), "a%*dz%-*dz", 4, 1, 3, 2);
+  EXPECT_STREQ("a   1z2  z", buf);
+}
+
+TEST(libc_logging, s_precision) {
+  char buf[BUFSIZ];
+  __libc_format_buffer(buf, sizeof(buf), "a%.3sz", "bcdef");
+  EXPECT_STREQ("abcdz", buf);
+  __libc_format_buffer(buf, sizeof(buf), "a%5.2sz", "bcdef");
+  EXPECT_STREQ("a   bcz", buf);
+  // The string needn't be terminated within the precision.
+  char unterminated[3] = { 'x', 'y', 'z' };
+  __libc_format_buffer(buf, sizeof(buf), "a%.*sz", 2, unterminated);
+  EXPECT_STREQ("axyz", buf);
+}
+
+TEST(libc_logging, android_format_buffer_truncates) {
+  char buf[8];
+  EXPECT_EQ(11, android_format_buffer(buf, sizeof(buf), "%s %s", "hello", "world"));
+  EXPECT_STREQ("hello w", buf);
+  EXPECT_EQ(4, android_format_buffer(NULL, 0, "%d", 1234));
+}
+
+TEST(libc_logging, android_format_append) {
+  char buf[12];
+  size_t length = 0;
+  EXPECT_EQ(3, android_format_append(buf, sizeof(buf), &length, "%s", "abc"));
+  EXPECT_EQ(3, android_format_append(buf, sizeof(buf), &length, "-%d", 42));
+  EXPECT_EQ(6U, length);
+  EXPECT_STREQ("abc-42", buf);
+  android_format_append(buf, sizeof(buf), &length, "%s", "0123456789");
+  android_format_append(buf, sizeof(buf), &length, "%s", "more");
+  EXPECT_EQ(20U, length);
+  EXPECT_STREQ("abc-4201234", buf);
+}
+
 #endif
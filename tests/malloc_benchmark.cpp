@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KB 1024
+#define MB 1024*KB
+
+#define AT_COMMON_SIZES \
+    Arg(8)->Arg(16)->Arg(64)->Arg(256)->Arg(512)->Arg(1*KB)->Arg(8*KB)->Arg(64*KB)->Arg(256*KB)
+
+static void BM_malloc_free(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    void* p = malloc(nbytes);
+    free(p);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_free)->AT_COMMON_SIZES;
+
+// Allocate a batch before freeing any, so that the allocator can't just
+// hand the same block back every time.
+#define BATCH 256
+
+static void BM_malloc_free_batch(int iters, int nbytes) {
+  void* ptrs[BATCH];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; i += BATCH) {
+    for (int j = 0; j < BATCH; ++j) {
+      ptrs[j] = malloc(nbytes);
+    }
+    for (int j = 0; j < BATCH; ++j) {
+      free(ptrs[j]);
+    }
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_free_batch)->AT_COMMON_SIZES;
+
+// One thread allocates and another frees, through a single-producer,
+// single-consumer ring.
+#define RING_SIZE 1024
+
+struct ring_t {
+  void* volatile slots[RING_SIZE];
+  volatile int head; // Written only by the producer.
+  volatile int tail; // Written only by the consumer.
+  int count;
+};
+
+static void* RingConsumer(void* arg) {
+  ring_t* ring = reinterpret_cast<ring_t*>(arg);
+  for (int i = 0; i < ring->count; ++i) {
+    while (ring->tail == ring->head) {
+      sched_yield();
+    }
+    __sync_synchronize();
+    free(ring->slots[ring->tail % RING_SIZE]);
+    __sync_synchronize();
+    ring->tail = ring->tail + 1;
+  }
+  return NULL;
+}
+
+static void BM_malloc_free_cross_thread(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  ring_t* ring = new ring_t;
+  ring->head = ring->tail = 0;
+  ring->count = iters;
+  pthread_t consumer;
+  pthread_create(&consumer, NULL, RingConsumer, ring);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    while (ring->head - ring->tail == RING_SIZE) {
+      sched_yield();
+    }
+    ring->slots[ring->head % RING_SIZE] = malloc(nbytes);
+    __sync_synchronize();
+    ring->head = ring->head + 1;
+  }
+  pthread_join(consumer, NULL);
+
+  StopBenchmarkTiming();
+  delete ring;
+}
+BENCHMARK(BM_malloc_free_cross_thread)->Arg(16)->Arg(64)->Arg(256)->Arg(1*KB)->Arg(8*KB);
+
+static void BM_malloc_realloc_growth(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    char* p = NULL;
+    // Double from 16 bytes up to nbytes, touching the end each time as a
+    // growable buffer being appended to would.
+    for (int size = 16; size <= nbytes; size *= 2) {
+      p = reinterpret_cast<char*>(realloc(p, size));
+      p[size - 1] = 1;
+    }
+    free(p);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_malloc_realloc_growth)->Arg(1*KB)->Arg(64*KB)->Arg(1*MB)->Arg(16*MB);
+
+// N threads all hammering the allocator at once. Each thread does 'iters'
+// iterations, so with perfect scaling the time per iteration is constant.
+struct contention_arg_t {
+  int iters;
+  volatile bool start;
+};
+
+static void* ContentionThread(void* arg) {
+  contention_arg_t* a = reinterpret_cast<contention_arg_t*>(arg);
+  void* ptrs[16];
+  while (!a->start) {
+    sched_yield();
+  }
+  for (int i = 0; i < a->iters; i += 16) {
+    for (int j = 0; j < 16; ++j) {
+      ptrs[j] = malloc(16 + 48 * j);
+    }
+    for (int j = 0; j < 16; ++j) {
+      free(ptrs[j]);
+    }
+  }
+  return NULL;
+}
+
+static void BM_malloc_threads(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  contention_arg_t arg = { iters, false };
+  pthread_t* threads = new pthread_t[nthreads];
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_create(&threads[i], NULL, ContentionThread, &arg);
+  }
+  StartBenchmarkTiming();
+
+  __sync_synchronize();
+  arg.start = true;
+  for (int i = 0; i < nthreads; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+}
+BENCHMARK(BM_malloc_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+static void BM_malloc_calloc_large(int iters, int nbytes) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    char* p = reinterpret_cast<char*>(calloc(1, nbytes));
+    // Touch a little of it, as a decoder filling in the first rows would.
+    p[0] = 1;
+    free(p);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+}
+BENCHMARK(BM_malloc_calloc_large)->Arg(64*KB)->Arg(256*KB)->Arg(1*MB)->Arg(4*MB);
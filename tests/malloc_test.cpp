@@ -16,7 +16,12 @@
 
 #include <gtest/gtest.h>
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <malloc.h>
 
 TEST(malloc, malloc_std) {
@@ -233,3 +238,247 @@ TEST(malloc, calloc_multiple_realloc) {
 
   free(ptr);
 }
+
+static void* SmallAllocationsThread(void* arg) {
+  // Allocate and free enough of every small size to move chunks between
+  // the thread's cache and the heap in both directions.
+  void* ptrs[256];
+  for (size_t iteration = 0; iteration < 4; ++iteration) {
+    for (size_t i = 0; i < sizeof(ptrs)/sizeof(ptrs[0]); ++i) {
+      size_t size = i + 1;
+      ptrs[i] = (i % 2 == 0) ? malloc(size) : calloc(1, size);
+      if (ptrs[i] == NULL || malloc_usable_size(ptrs[i]) < size) {
+        return reinterpret_cast<void*>(1);
+      }
+      if (i % 2 != 0) {
+        for (size_t j = 0; j < size; ++j) {
+          if (reinterpret_cast<char*>(ptrs[i])[j] != 0) {
+            return reinterpret_cast<void*>(1);
+          }
+        }
+      }
+      memset(ptrs[i], 0xaa, size);
+    }
+    for (size_t i = 0; i < sizeof(ptrs)/sizeof(ptrs[0]); ++i) {
+      free(ptrs[i]);
+    }
+  }
+  // Leave something for another thread to free.
+  return (arg != NULL) ? malloc(32) : NULL;
+}
+
+TEST(malloc, small_allocations_threads) {
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, SmallAllocationsThread,
+                                reinterpret_cast<void*>(i % 2)));
+  }
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_NE(reinterpret_cast<void*>(1), result);
+    free(result);
+  }
+  ASSERT_TRUE(SmallAllocationsThread(NULL) == NULL);
+}
+
+TEST(malloc, small_realloc_and_mallinfo) {
+  // Growing a small allocation a byte at a time must keep its contents, and
+  // what it reports as usable must really be usable.
+  char* ptr = static_cast<char*>(malloc(1));
+  ASSERT_TRUE(ptr != NULL);
+  ptr[0] = 0;
+  for (size_t size = 2; size <= 512; ++size) {
+    ptr = static_cast<char*>(realloc(ptr, size));
+    ASSERT_TRUE(ptr != NULL);
+    ASSERT_LE(size, malloc_usable_size(ptr));
+    for (size_t i = 0; i < size - 1; ++i) {
+      ASSERT_EQ(static_cast<char>(i), ptr[i]);
+    }
+    ptr[size - 1] = static_cast<char>(size - 1);
+    memset(ptr + size, 0xaa, malloc_usable_size(ptr) - size);
+  }
+  free(ptr);
+
+  struct mallinfo before = mallinfo();
+  void* small = malloc(24);
+  ASSERT_TRUE(small != NULL);
+  struct mallinfo after = mallinfo();
+  ASSERT_LE(static_cast<size_t>(before.uordblks) + 24, static_cast<size_t>(after.uordblks));
+  free(small);
+}
+
+TEST(malloc, free_sized) {
+  // Small objects freed with their size go back to their own class, so the
+  // next allocation of that size can reuse them.
+  for (size_t size = 0; size <= 512; size += 7) {
+    void* ptr = malloc(size);
+    ASSERT_TRUE(ptr != NULL);
+    free_sized(ptr, size);
+    void* again = malloc(size);
+    ASSERT_TRUE(again != NULL);
+    ASSERT_LE(size, malloc_usable_size(again));
+    free_sized(again, size);
+  }
+  free_sized(NULL, 16);
+}
+
+TEST(malloc, mallopt) {
+  ASSERT_EQ(0, mallopt(0, 0));
+  ASSERT_EQ(0, mallopt(M_GRANULARITY, 3));
+
+  // Raise the mmap threshold so that a large buffer comes from the heap and
+  // is reused rather than mapped and unmapped every time.
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 1024 * 1024));
+  struct mallinfo before = mallinfo();
+  void* ptr = malloc(512 * 1024);
+  ASSERT_TRUE(ptr != NULL);
+  struct mallinfo after = mallinfo();
+  ASSERT_EQ(before.hblkhd, after.hblkhd);
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 64 * 1024));
+}
+
+#if defined(__BIONIC__)
+static void* TouchStackFn(void*) {
+  char buf[64 * 1024];
+  memset(buf, 0, sizeof(buf));
+  return reinterpret_cast<void*>(buf[sizeof(buf) - 1]);
+}
+#endif
+
+TEST(malloc, mallopt_hugepages) {
+#if defined(__BIONIC__)
+  const size_t kHugePage = 2 * 1024 * 1024;
+  ASSERT_EQ(1, mallopt(M_HUGEPAGES, 1));
+
+  // A chunk with its own mapping starts just past a huge page boundary.
+  char* ptr = static_cast<char*>(malloc(4 * kHugePage));
+  ASSERT_TRUE(ptr != NULL);
+  ASSERT_LT(reinterpret_cast<uintptr_t>(ptr) & (kHugePage - 1), 4096U);
+  memset(ptr, 0xaa, 4 * kHugePage);
+  free(ptr);
+
+  // Big explicitly sized stacks are mapped the same way.
+  pthread_attr_t attr;
+  ASSERT_EQ(0, pthread_attr_init(&attr));
+  ASSERT_EQ(0, pthread_attr_setstacksize(&attr, 2 * kHugePage));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, &attr, TouchStackFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  ASSERT_EQ(1, mallopt(M_HUGEPAGES, 0));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
+TEST(malloc, malloc_trim) {
+  // Free a large chunk in the middle of the heap, where automatic trimming
+  // can't reach it, and check that everything else survives the purge.
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 1024 * 1024));
+  char* before = static_cast<char*>(malloc(64));
+  void* middle = malloc(256 * 1024);
+  char* after = static_cast<char*>(malloc(64));
+  ASSERT_TRUE(before != NULL && middle != NULL && after != NULL);
+  memset(before, 0x11, 64);
+  memset(after, 0x22, 64);
+  free(middle);
+  ASSERT_EQ(1, malloc_trim(0));
+  for (size_t i = 0; i < 64; ++i) {
+    ASSERT_EQ(0x11, before[i]);
+    ASSERT_EQ(0x22, after[i]);
+  }
+  free(before);
+  free(after);
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 64 * 1024));
+}
+
+TEST(malloc, malloc_dump_stats) {
+  void* ptr = malloc(24);
+  ASSERT_TRUE(ptr != NULL);
+
+  char file[] = "/data/local/tmp/malloc_test.stats.XXXXXX";
+  int fd = mkstemp(file);
+  ASSERT_NE(-1, fd) << strerror(errno);
+  unlink(file);
+  malloc_dump_stats(fd);
+  free(ptr);
+
+  char buf[4096];
+  ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+  close(fd);
+  ASSERT_GT(n, 0);
+  buf[n] = '\0';
+  EXPECT_TRUE(strstr(buf, "heap: ") == buf);
+  EXPECT_TRUE(strstr(buf, "\n  32 ") != NULL);
+}
+
+TEST(malloc, calloc_large_reused) {
+  // Dirty a large chunk of the heap, free it, and check that a calloc that
+  // reuses it still sees only zeroes.
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 4 * 1024 * 1024));
+  const size_t size = 1024 * 1024 + 123;
+  char* dirty = static_cast<char*>(malloc(size));
+  ASSERT_TRUE(dirty != NULL);
+  memset(dirty, 0xaa, size);
+  free(dirty);
+
+  char* ptr = static_cast<char*>(calloc(1, size));
+  ASSERT_TRUE(ptr != NULL);
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_EQ(0, ptr[i]);
+  }
+  free(ptr);
+  ASSERT_EQ(1, mallopt(M_MMAP_THRESHOLD, 64 * 1024));
+}
+
+TEST(malloc, realloc_large_growth) {
+  // Double a big mmapped buffer repeatedly, as a growable byte buffer would,
+  // checking that the contents survive each move or in-place growth.
+  size_t size = 256 * 1024;
+  uint32_t* ptr = static_cast<uint32_t*>(malloc(size));
+  ASSERT_TRUE(ptr != NULL);
+  for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+    ptr[i] = i;
+  }
+  for (; size < 16 * 1024 * 1024; size *= 2) {
+    ptr = static_cast<uint32_t*>(realloc(ptr, size * 2));
+    ASSERT_TRUE(ptr != NULL);
+    for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+      ASSERT_EQ(i, ptr[i]);
+    }
+    for (size_t i = size / sizeof(uint32_t); i < 2 * size / sizeof(uint32_t); ++i) {
+      ptr[i] = i;
+    }
+  }
+  // And shrink it again.
+  ptr = static_cast<uint32_t*>(realloc(ptr, 128 * 1024));
+  ASSERT_TRUE(ptr != NULL);
+  for (size_t i = 0; i < 128 * 1024 / sizeof(uint32_t); ++i) {
+    ASSERT_EQ(i, ptr[i]);
+  }
+  free(ptr);
+}
+
+static int CountLeakRecord(const malloc_leak_record* record, void* arg) {
+  EXPECT_LE(record->frame_count, 32U);
+  ++*static_cast<size_t*>(arg);
+  return 0;
+}
+
+TEST(malloc, malloc_iterate_leaks) {
+  // Without libc.debug.malloc=1 nothing is tracked, but the walk must still
+  // finish and agree with itself.
+  void* ptr = malloc(24);
+  ASSERT_TRUE(ptr != NULL);
+  unsigned generation = malloc_leak_generation();
+  size_t count = 0;
+  ASSERT_EQ(0, malloc_iterate_leaks(CountLeakRecord, &count));
+  if (malloc_leak_generation() == generation) {
+    size_t again = 0;
+    ASSERT_EQ(0, malloc_iterate_leaks(CountLeakRecord, &again));
+    ASSERT_EQ(count, again);
+  }
+  free(ptr);
+}
@@ -17,6 +17,11 @@
 #include "benchmark.h"
 
 #include <math.h>
+#include <stdint.h>
+
+#if defined(__BIONIC__)
+#include <android/vmath.h>
+#endif
 
 // Avoid optimization.
 double d;
@@ -60,3 +65,240 @@ static void BM_math_logb(int iters) {
   StopBenchmarkTiming();
 }
 BENCHMARK(BM_math_logb);
+
+// The three kinds of argument take different paths through most functions,
+// with argument reduction costing the most for large ones, so each function
+// is measured on each kind separately. The arguments are cycled through so
+// that the same branches aren't always predicted right.
+#define ARG_COUNT 8
+
+static const double kNormalDoubles[ARG_COUNT] = {
+  0.1, 0.4, 0.7, 1.0, 1.3, 2.5, 3.9, 7.8,
+};
+static const double kSubnormalDoubles[ARG_COUNT] = {
+  4.9e-324, 1e-322, 1e-320, 1e-318, 1e-315, 1e-312, 1e-310, 2e-308,
+};
+static const double kLargeDoubles[ARG_COUNT] = {
+  1e6, 1e9, 1e15, 1e22, 1e50, 1e100, 1e200, 1e300,
+};
+
+static const float kNormalFloats[ARG_COUNT] = {
+  0.1f, 0.4f, 0.7f, 1.0f, 1.3f, 2.5f, 3.9f, 7.8f,
+};
+static const float kSubnormalFloats[ARG_COUNT] = {
+  1.4e-45f, 1e-44f, 1e-43f, 1e-42f, 1e-41f, 1e-40f, 1e-39f, 1e-38f,
+};
+static const float kLargeFloats[ARG_COUNT] = {
+  1e4f, 1e5f, 1e6f, 1e9f, 1e15f, 1e22f, 1e30f, 3e38f,
+};
+
+#define BENCHMARK_MATH(name, type, args, expr) \
+  static void BM_math_##name(int iters) { \
+    StartBenchmarkTiming(); \
+    type sum = 0; \
+    for (int i = 0; i < iters; ++i) { \
+      type x = args[i % ARG_COUNT]; \
+      sum += (expr); \
+    } \
+    d = sum; \
+    StopBenchmarkTiming(); \
+  } \
+  BENCHMARK(BM_math_##name)
+
+#define BENCHMARK_MATH_DOUBLE(fn, expr) \
+  BENCHMARK_MATH(fn##_normal, double, kNormalDoubles, expr); \
+  BENCHMARK_MATH(fn##_subnormal, double, kSubnormalDoubles, expr); \
+  BENCHMARK_MATH(fn##_large, double, kLargeDoubles, expr)
+
+#define BENCHMARK_MATH_FLOAT(fn, expr) \
+  BENCHMARK_MATH(fn##_normal, float, kNormalFloats, expr); \
+  BENCHMARK_MATH(fn##_subnormal, float, kSubnormalFloats, expr); \
+  BENCHMARK_MATH(fn##_large, float, kLargeFloats, expr)
+
+static double sincos_sum(double x) {
+  double s, c;
+  sincos(x, &s, &c);
+  return s + c;
+}
+
+static float sincosf_sum(float x) {
+  float s, c;
+  sincosf(x, &s, &c);
+  return s + c;
+}
+
+BENCHMARK_MATH_DOUBLE(sin, sin(x));
+BENCHMARK_MATH_DOUBLE(cos, cos(x));
+BENCHMARK_MATH_DOUBLE(sincos, sincos_sum(x));
+BENCHMARK_MATH_DOUBLE(exp, exp(x));
+BENCHMARK_MATH_DOUBLE(log, log(x));
+BENCHMARK_MATH_DOUBLE(pow, pow(x, 1.5));
+BENCHMARK_MATH_DOUBLE(floor, floor(x));
+BENCHMARK_MATH_DOUBLE(ceil, ceil(x));
+BENCHMARK_MATH_DOUBLE(rint, rint(x));
+BENCHMARK_MATH_DOUBLE(fma, fma(x, 1.5, 0.25));
+BENCHMARK_MATH_DOUBLE(atan2, atan2(x, 1.5));
+
+BENCHMARK_MATH_FLOAT(sinf, sinf(x));
+BENCHMARK_MATH_FLOAT(cosf, cosf(x));
+BENCHMARK_MATH_FLOAT(sincosf, sincosf_sum(x));
+BENCHMARK_MATH_FLOAT(expf, expf(x));
+BENCHMARK_MATH_FLOAT(logf, logf(x));
+BENCHMARK_MATH_FLOAT(powf, powf(x, 1.5f));
+
+#if defined(__BIONIC__)
+#define AT_VMATH_SIZES Arg(4)->Arg(16)->Arg(64)->Arg(1024)->Arg(16*1024)
+
+// Fills 'x' with n values spread over [lo, hi).
+static void FillArgs(float* x, int n, float lo, float hi) {
+  for (int i = 0; i < n; ++i) {
+    x[i] = lo + (hi - lo) * i / n;
+  }
+}
+
+// Each array function against a loop over its scalar version, on the same
+// arguments, with items counted as bytes of output.
+#define BENCHMARK_VMATH_UNARY(fn, lo, hi) \
+  static void BM_math_v##fn(int iters, int n) { \
+    StopBenchmarkTiming(); \
+    float* x = new float[n]; \
+    float* out = new float[n]; \
+    FillArgs(x, n, lo, hi); \
+    StartBenchmarkTiming(); \
+    for (int i = 0; i < iters; ++i) { \
+      v##fn(x, out, n); \
+    } \
+    StopBenchmarkTiming(); \
+    SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float)); \
+    delete[] x; \
+    delete[] out; \
+  } \
+  BENCHMARK(BM_math_v##fn)->AT_VMATH_SIZES; \
+  static void BM_math_##fn##_loop(int iters, int n) { \
+    StopBenchmarkTiming(); \
+    float* x = new float[n]; \
+    float* out = new float[n]; \
+    FillArgs(x, n, lo, hi); \
+    StartBenchmarkTiming(); \
+    for (int i = 0; i < iters; ++i) { \
+      for (int j = 0; j < n; ++j) { \
+        out[j] = fn(x[j]); \
+      } \
+    } \
+    StopBenchmarkTiming(); \
+    SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float)); \
+    delete[] x; \
+    delete[] out; \
+  } \
+  BENCHMARK(BM_math_##fn##_loop)->AT_VMATH_SIZES
+
+BENCHMARK_VMATH_UNARY(expf, -80.0f, 80.0f);
+BENCHMARK_VMATH_UNARY(logf, 1e-3f, 1e3f);
+BENCHMARK_VMATH_UNARY(sinf, -100.0f, 100.0f);
+BENCHMARK_VMATH_UNARY(cosf, -100.0f, 100.0f);
+
+static void BM_math_vpowf(int iters, int n) {
+  StopBenchmarkTiming();
+  float* x = new float[n];
+  float* y = new float[n];
+  float* out = new float[n];
+  FillArgs(x, n, 0.1f, 10.0f);
+  FillArgs(y, n, -20.0f, 20.0f);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    vpowf(x, y, out, n);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float));
+  delete[] x;
+  delete[] y;
+  delete[] out;
+}
+BENCHMARK(BM_math_vpowf)->AT_VMATH_SIZES;
+
+static void BM_math_powf_loop(int iters, int n) {
+  StopBenchmarkTiming();
+  float* x = new float[n];
+  float* y = new float[n];
+  float* out = new float[n];
+  FillArgs(x, n, 0.1f, 10.0f);
+  FillArgs(y, n, -20.0f, 20.0f);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < n; ++j) {
+      out[j] = powf(x[j], y[j]);
+    }
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float));
+  delete[] x;
+  delete[] y;
+  delete[] out;
+}
+BENCHMARK(BM_math_powf_loop)->AT_VMATH_SIZES;
+
+// The 16-bit conversions against the lrintf() and clamping loop they replace,
+// with items counted as bytes of float samples.
+static void BM_math_vftoi16(int iters, int n) {
+  StopBenchmarkTiming();
+  float* x = new float[n];
+  int16_t* out = new int16_t[n];
+  FillArgs(x, n, -1.2f, 1.2f);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    vftoi16(x, 32768.0f, out, n);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float));
+  delete[] x;
+  delete[] out;
+}
+BENCHMARK(BM_math_vftoi16)->AT_VMATH_SIZES;
+
+static void BM_math_ftoi16_loop(int iters, int n) {
+  StopBenchmarkTiming();
+  float* x = new float[n];
+  int16_t* out = new int16_t[n];
+  FillArgs(x, n, -1.2f, 1.2f);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    for (int j = 0; j < n; ++j) {
+      long v = lrintf(x[j] * 32768.0f);
+      out[j] = (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : v;
+    }
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float));
+  delete[] x;
+  delete[] out;
+}
+BENCHMARK(BM_math_ftoi16_loop)->AT_VMATH_SIZES;
+
+static void BM_math_vi16tof(int iters, int n) {
+  StopBenchmarkTiming();
+  int16_t* x = new int16_t[n];
+  float* out = new float[n];
+  for (int j = 0; j < n; ++j) {
+    x[j] = static_cast<int16_t>(j * 37);
+  }
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    vi16tof(x, 1.0f / 32768, out, n);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(n) * sizeof(float));
+  delete[] x;
+  delete[] out;
+}
+BENCHMARK(BM_math_vi16tof)->AT_VMATH_SIZES;
+#endif
@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include <fenv.h>
+#include <float.h>
 #include <limits.h>
 #include <math.h>
 #include <stdint.h>
@@ -301,6 +302,60 @@ TEST(math, sinl) {
   ASSERT_FLOAT_EQ(0.0, sinl(0.0));
 }
 
+// Arguments big enough to need the full-precision reduction, including
+// 6381956970095103 * 2^797, the double closest to a multiple of pi/2.
+TEST(math, sin_cos_large_arguments) {
+  ASSERT_DOUBLE_EQ(-0.85220084976718879, sin(1e22));
+  ASSERT_DOUBLE_EQ(0.52321478539513899, cos(1e22));
+  ASSERT_DOUBLE_EQ(-1.6287782256068988, tan(1e22));
+  ASSERT_DOUBLE_EQ(0.004961954789184062, sin(DBL_MAX));
+  ASSERT_DOUBLE_EQ(-0.99998768942655991, cos(DBL_MAX));
+  ASSERT_DOUBLE_EQ(-0.15920170308624243, sin(ldexp(1.0, 1000)));
+  ASSERT_DOUBLE_EQ(-4.687165924254628e-19, cos(ldexp(6381956970095103.0, 797)));
+  ASSERT_DOUBLE_EQ(-2.133485385753704e+18, tan(ldexp(6381956970095103.0, 797)));
+  ASSERT_FLOAT_EQ(-0.791163445f, sinf(1e30f));
+  ASSERT_FLOAT_EQ(0.853021026f, cosf(FLT_MAX));
+  ASSERT_FLOAT_EQ(-0.487506032f, sinf(1e10f));
+}
+
+// sincos shares sin's and cos's argument reduction, so it should agree with
+// them exactly, in every range that reduction has.
+static const double kSinCosArgs[] = {
+  0.0, -0.0, 1e-30, 0.5, -0.75, 2.0, -3.0, 4.5, 6.0, -7.5, 100.0, 1e7, -1e22, 1e30,
+};
+
+TEST(math, sincos) {
+  for (size_t i = 0; i < sizeof(kSinCosArgs)/sizeof(kSinCosArgs[0]); ++i) {
+    double s, c;
+    sincos(kSinCosArgs[i], &s, &c);
+    ASSERT_EQ(sin(kSinCosArgs[i]), s) << kSinCosArgs[i];
+    ASSERT_EQ(cos(kSinCosArgs[i]), c) << kSinCosArgs[i];
+  }
+  double s, c;
+  sincos(HUGE_VAL, &s, &c);
+  ASSERT_TRUE(isnan(s) && isnan(c));
+}
+
+TEST(math, sincosf) {
+  for (size_t i = 0; i < sizeof(kSinCosArgs)/sizeof(kSinCosArgs[0]); ++i) {
+    float x = kSinCosArgs[i];
+    float s, c;
+    sincosf(x, &s, &c);
+    ASSERT_EQ(sinf(x), s) << x;
+    ASSERT_EQ(cosf(x), c) << x;
+  }
+  float s, c;
+  sincosf(HUGE_VALF, &s, &c);
+  ASSERT_TRUE(isnan(s) && isnan(c));
+}
+
+TEST(math, sincosl) {
+  long double s, c;
+  sincosl(0.0, &s, &c);
+  ASSERT_FLOAT_EQ(0.0, s);
+  ASSERT_FLOAT_EQ(1.0, c);
+}
+
 TEST(math, tan) {
   ASSERT_FLOAT_EQ(0.0, tan(0.0));
 }
@@ -389,10 +444,59 @@ TEST(math, log) {
   ASSERT_FLOAT_EQ(1.0, log(M_E));
 }
 
+TEST(math, log_special_cases) {
+  ASSERT_EQ(0.0, log(1.0));
+  ASSERT_EQ(-HUGE_VAL, log(0.0));
+  ASSERT_EQ(-HUGE_VAL, log(-0.0));
+  ASSERT_EQ(HUGE_VAL, log(HUGE_VAL));
+  ASSERT_TRUE(isnan(log(-1.0)));
+  ASSERT_TRUE(isnan(log(-HUGE_VAL)));
+  ASSERT_TRUE(isnan(log(nan(""))));
+  // Correctly rounded, including the ones next to 1 and the subnormal one.
+  ASSERT_EQ(M_LN2, log(2.0));
+  ASSERT_EQ(M_LN10, log(10.0));
+  ASSERT_EQ(2.2204460492503128e-16, log(1.0 + DBL_EPSILON));
+  ASSERT_EQ(-1.1102230246251565e-16, log(1.0 - DBL_EPSILON / 2));
+  ASSERT_EQ(-744.4400719213812, log(4.9e-324));
+  ASSERT_EQ(709.782712893384, log(DBL_MAX));
+}
+
 TEST(math, logf) {
   ASSERT_FLOAT_EQ(1.0f, logf(static_cast<float>(M_E)));
 }
 
+TEST(math, logf_special_cases) {
+  ASSERT_EQ(0.0f, logf(1.0f));
+  ASSERT_EQ(-HUGE_VALF, logf(0.0f));
+  ASSERT_EQ(-HUGE_VALF, logf(-0.0f));
+  ASSERT_EQ(HUGE_VALF, logf(HUGE_VALF));
+  ASSERT_TRUE(isnan(logf(-1.0f)));
+  ASSERT_TRUE(isnan(logf(-HUGE_VALF)));
+  ASSERT_TRUE(isnan(logf(nanf(""))));
+  ASSERT_FLOAT_EQ(-149.0f * static_cast<float>(M_LN2), logf(ldexpf(1.0f, -149)));
+}
+
+// The largest difference between a float function and the double one, in units
+// in the last place of the result, over 'count' arguments spread over [lo, hi].
+static double MaxUlpError(float (*f)(float), double (*d)(double), float lo, float hi, int count) {
+  double max_error = 0.0;
+  for (int i = 0; i <= count; ++i) {
+    float x = lo + (hi - lo) * i / count;
+    double expected = d(x);
+    int exponent;
+    frexp(expected, &exponent);
+    double error = fabs(f(x) - expected) / ldexp(1.0, (exponent - 24 < -149) ? -149 : exponent - 24);
+    max_error = fmax(max_error, error);
+  }
+  return max_error;
+}
+
+TEST(math, logf_accuracy) {
+  ASSERT_LT(MaxUlpError(logf, log, 0x1p-126f, 4.0f, 100000), 1.0);
+  ASSERT_LT(MaxUlpError(logf, log, 0.9f, 1.1f, 100000), 1.0);
+  ASSERT_LT(MaxUlpError(logf, log, 1.0f, 1e38f, 100000), 1.0);
+}
+
 TEST(math, logl) {
   ASSERT_FLOAT_EQ(1.0, logl(M_E));
 }
@@ -450,11 +554,43 @@ TEST(math, exp) {
   ASSERT_FLOAT_EQ(M_E, exp(1.0));
 }
 
+TEST(math, exp_special_cases) {
+  ASSERT_EQ(1.0, exp(-0.0));
+  ASSERT_EQ(HUGE_VAL, exp(HUGE_VAL));
+  ASSERT_EQ(0.0, exp(-HUGE_VAL));
+  ASSERT_TRUE(isnan(exp(nan(""))));
+  ASSERT_EQ(M_E, exp(1.0));
+  ASSERT_EQ(0.36787944117144233, exp(-1.0));
+  ASSERT_EQ(HUGE_VAL, exp(709.79));
+  ASSERT_EQ(1.7928227943945155e+308, exp(709.78));
+  ASSERT_EQ(1.0142320547350045e+304, exp(700.0));
+  // Subnormal results are rounded once, to their own precision.
+  ASSERT_EQ(4.2e-322, exp(-740.0));
+  ASSERT_EQ(4.9e-324, exp(-745.1));
+  ASSERT_EQ(0.0, exp(-745.2));
+}
+
 TEST(math, expf) {
   ASSERT_FLOAT_EQ(1.0f, expf(0.0f));
   ASSERT_FLOAT_EQ(static_cast<float>(M_E), expf(1.0f));
 }
 
+TEST(math, expf_special_cases) {
+  ASSERT_EQ(1.0f, expf(-0.0f));
+  ASSERT_EQ(HUGE_VALF, expf(HUGE_VALF));
+  ASSERT_EQ(0.0f, expf(-HUGE_VALF));
+  ASSERT_TRUE(isnan(expf(nanf(""))));
+  ASSERT_EQ(HUGE_VALF, expf(88.8f));
+  ASSERT_TRUE(isfinite(expf(88.72f)));
+  ASSERT_EQ(0.0f, expf(-104.0f));
+  ASSERT_LT(0.0f, expf(-103.9f));
+}
+
+TEST(math, expf_accuracy) {
+  ASSERT_LT(MaxUlpError(expf, exp, -103.9f, 88.7f, 100000), 1.0);
+  ASSERT_LT(MaxUlpError(expf, exp, -1e-3f, 1e-3f, 100000), 1.0);
+}
+
 TEST(math, expl) {
   ASSERT_FLOAT_EQ(1.0, expl(0.0));
   ASSERT_FLOAT_EQ(M_E, expl(1.0));
@@ -492,6 +628,63 @@ TEST(math, powf) {
   ASSERT_FLOAT_EQ(8.0f, powf(2.0f, 3.0f));
 }
 
+TEST(math, powf_special_cases) {
+  // The cases of C99 Annex F.9.4.4.
+  ASSERT_EQ(HUGE_VALF, powf(0.0f, -3.0f));
+  ASSERT_EQ(-HUGE_VALF, powf(-0.0f, -3.0f));
+  ASSERT_EQ(HUGE_VALF, powf(-0.0f, -2.0f));
+  ASSERT_EQ(HUGE_VALF, powf(-0.0f, -0.5f));
+  ASSERT_EQ(0.0f, powf(0.0f, 3.0f));
+  ASSERT_TRUE(signbit(powf(-0.0f, 3.0f)));
+  ASSERT_FALSE(signbit(powf(-0.0f, 2.0f)));
+  ASSERT_FALSE(signbit(powf(-0.0f, 0.5f)));
+  ASSERT_EQ(1.0f, powf(-1.0f, HUGE_VALF));
+  ASSERT_EQ(1.0f, powf(-1.0f, -HUGE_VALF));
+  ASSERT_EQ(1.0f, powf(1.0f, nanf("")));
+  ASSERT_EQ(1.0f, powf(nanf(""), 0.0f));
+  ASSERT_EQ(1.0f, powf(nanf(""), -0.0f));
+  ASSERT_TRUE(isnan(powf(-2.0f, 0.5f)));
+  ASSERT_EQ(HUGE_VALF, powf(0.5f, -HUGE_VALF));
+  ASSERT_EQ(0.0f, powf(2.0f, -HUGE_VALF));
+  ASSERT_EQ(0.0f, powf(0.5f, HUGE_VALF));
+  ASSERT_EQ(HUGE_VALF, powf(2.0f, HUGE_VALF));
+  ASSERT_TRUE(signbit(powf(-HUGE_VALF, -3.0f)));
+  ASSERT_FALSE(signbit(powf(-HUGE_VALF, -2.0f)));
+  ASSERT_EQ(-HUGE_VALF, powf(-HUGE_VALF, 3.0f));
+  ASSERT_EQ(HUGE_VALF, powf(-HUGE_VALF, 2.0f));
+  ASSERT_EQ(0.0f, powf(HUGE_VALF, -1.0f));
+  ASSERT_EQ(HUGE_VALF, powf(HUGE_VALF, 1.0f));
+  ASSERT_TRUE(isnan(powf(nanf(""), 1.0f)));
+  ASSERT_TRUE(isnan(powf(2.0f, nanf(""))));
+
+  // Negative x to integer powers, and results that overflow or underflow.
+  ASSERT_EQ(-8.0f, powf(-2.0f, 3.0f));
+  ASSERT_EQ(16.0f, powf(-2.0f, 4.0f));
+  ASSERT_EQ(-HUGE_VALF, powf(-2.0f, 129.0f));
+  ASSERT_EQ(HUGE_VALF, powf(2.0f, 128.0f));
+  ASSERT_EQ(ldexpf(1.0f, 127), powf(2.0f, 127.0f));
+  ASSERT_EQ(ldexpf(1.0f, -149), powf(2.0f, -149.0f));
+  ASSERT_EQ(0.0f, powf(2.0f, -151.0f));
+}
+
+TEST(math, powf_accuracy) {
+  double max_error = 0.0;
+  for (int i = 0; i <= 1000; ++i) {
+    for (int j = 0; j <= 100; ++j) {
+      float x = 0.01f + 9.99f * i / 1000;
+      float y = -30.0f + 60.0f * j / 100;
+      double expected = pow(static_cast<double>(x), y);
+      if (expected > FLT_MAX || expected < FLT_MIN) {
+        continue;
+      }
+      int exponent;
+      frexp(expected, &exponent);
+      max_error = fmax(max_error, fabs(powf(x, y) - expected) / ldexp(1.0, exponent - 24));
+    }
+  }
+  ASSERT_LT(max_error, 1.0);
+}
+
 TEST(math, powl) {
   ASSERT_FLOAT_EQ(8.0, powl(2.0, 3.0));
 }
@@ -520,6 +713,34 @@ TEST(math, floorl) {
   ASSERT_FLOAT_EQ(1.0, floorl(1.1));
 }
 
+TEST(math, rounding_special_cases) {
+  static const int modes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+    fesetround(modes[i]); // Only rint/nearbyint obey the rounding mode.
+    ASSERT_EQ(-1.0, floor(-0.5));
+    ASSERT_TRUE(signbit(ceil(-0.5)));
+    ASSERT_TRUE(signbit(trunc(-0.5)));
+    ASSERT_FALSE(signbit(floor(0.5)));
+    ASSERT_TRUE(signbit(floorf(-0.0f)));
+    ASSERT_TRUE(signbit(ceilf(-0.75f)));
+    ASSERT_EQ(4503599627370497.0, floor(4503599627370497.0)); // 2^52 + 1.
+    ASSERT_EQ(-8388609.0f, ceilf(-8388609.0f)); // -(2^23 + 1).
+    ASSERT_EQ(HUGE_VAL, floor(HUGE_VAL));
+    ASSERT_EQ(-HUGE_VALF, ceilf(-HUGE_VALF));
+    ASSERT_TRUE(isnan(trunc(nan(""))));
+    ASSERT_TRUE(signbit(rint(-0.25)));
+    ASSERT_TRUE(signbit(nearbyintf(-0.25f)));
+    ASSERT_EQ(3000000000LL, llrint(3000000000.0));
+  }
+  fesetround(FE_TONEAREST); // Ties go to even.
+  ASSERT_EQ(2.0, rint(2.5));
+  ASSERT_EQ(-2.0f, rintf(-2.5f));
+  ASSERT_EQ(4.0, nearbyint(3.5));
+  ASSERT_EQ(2, lrint(2.5));
+  ASSERT_EQ(-4, lrintf(-3.5f));
+  ASSERT_EQ(2147483648LL, llrint(2147483647.5));
+}
+
 TEST(math, fabs) {
   ASSERT_FLOAT_EQ(1.0, fabs(-1.0));
 }
@@ -614,10 +835,15 @@ TEST(math, fminl) {
 
 TEST(math, fma) {
   ASSERT_FLOAT_EQ(10.0, fma(2.0, 3.0, 4.0));
+  // Only a single rounding leaves anything of (1 + 2^-30)^2 - (1 + 2^-29).
+  ASSERT_EQ(ldexp(1.0, -60), fma(1.0 + ldexp(1.0, -30), 1.0 + ldexp(1.0, -30), -(1.0 + ldexp(1.0, -29))));
+  ASSERT_TRUE(isnan(fma(HUGE_VAL, 0.0, 1.0)));
 }
 
 TEST(math, fmaf) {
   ASSERT_FLOAT_EQ(10.0f, fmaf(2.0f, 3.0f, 4.0f));
+  ASSERT_EQ(ldexpf(1.0f, -24), fmaf(1.0f + ldexpf(1.0f, -12), 1.0f + ldexpf(1.0f, -12), -(1.0f + ldexpf(1.0f, -11))));
+  ASSERT_TRUE(isnan(fmaf(HUGE_VALF, 0.0f, 1.0f)));
 }
 
 TEST(math, fmal) {
@@ -678,6 +904,16 @@ TEST(math, lrint) {
   ASSERT_EQ(1234L, llrint(1234.01));
   ASSERT_EQ(1234L, llrintf(1234.01f));
   ASSERT_EQ(1234L, llrintl(1234.01));
+
+  fesetround(FE_DOWNWARD);
+  ASSERT_EQ(-1235, lrint(-1234.01));
+  ASSERT_EQ(-1235L, llrintf(-1234.01f));
+  fesetround(FE_TONEAREST);
+  feclearexcept(FE_ALL_EXCEPT); // Only results that differ from the argument are inexact.
+  ASSERT_EQ(1234, lrint(1234.0));
+  ASSERT_EQ(0, fetestexcept(FE_INEXACT));
+  ASSERT_EQ(1234, lrintf(1234.01f));
+  ASSERT_NE(0, fetestexcept(FE_INEXACT));
 }
 
 TEST(math, rint) {
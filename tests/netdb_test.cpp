@@ -16,6 +16,8 @@
 
 #include <gtest/gtest.h>
 
+#include <android/getaddrinfo_async.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
@@ -55,3 +57,68 @@ TEST(netdb, getnameinfo_salen) {
   ASSERT_STREQ("::", tmp);
   ASSERT_EQ(EAI_FAMILY, getnameinfo(sa, too_little, tmp, sizeof(tmp), NULL, 0, NI_NUMERICHOST));
 }
+
+TEST(netdb, android_getaddrinfo_async_numeric) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  android_getaddrinfo_request_t* request = NULL;
+  ASSERT_EQ(0, android_getaddrinfo_async("127.0.0.1", "80", &hints, NULL, 0, &request));
+  ASSERT_TRUE(request != NULL);
+
+  // A numeric host needs no DNS, so the result is ready at once.
+  pollfd pfd = { android_getaddrinfo_fd(request), POLLIN, 0 };
+  ASSERT_EQ(1, poll(&pfd, 1, 0));
+
+  addrinfo* ai = NULL;
+  ASSERT_EQ(0, android_getaddrinfo_result(request, &ai));
+  ASSERT_TRUE(ai != NULL);
+  ASSERT_EQ(AF_INET, ai->ai_family);
+  ASSERT_EQ(htonl(INADDR_LOOPBACK), reinterpret_cast<sockaddr_in*>(ai->ai_addr)->sin_addr.s_addr);
+  ASSERT_EQ(htons(80), reinterpret_cast<sockaddr_in*>(ai->ai_addr)->sin_port);
+  freeaddrinfo(ai);
+}
+
+TEST(netdb, android_getaddrinfo_async_errors) {
+  android_getaddrinfo_request_t* request = NULL;
+  ASSERT_EQ(EAI_NONAME, android_getaddrinfo_async(NULL, NULL, NULL, NULL, 0, &request));
+  ASSERT_TRUE(request == NULL);
+}
+
+TEST(netdb, android_getaddrinfo_async_cancel) {
+  android_getaddrinfo_request_t* request = NULL;
+  ASSERT_EQ(0, android_getaddrinfo_async("localhost", "9999", NULL, NULL, 0, &request));
+  android_getaddrinfo_cancel(request);
+
+  // Cancelling mustn't leave a half-read reply on a pooled connection.
+  addrinfo* ai = NULL;
+  ASSERT_EQ(0, getaddrinfo("localhost", "9999", NULL, &ai));
+  freeaddrinfo(ai);
+}
+
+TEST(netdb, getservbyname) {
+  servent* s = getservbyname("domain", "udp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_EQ(htons(53), s->s_port);
+  ASSERT_STREQ("udp", s->s_proto);
+
+  // Aliases match too.
+  s = getservbyname("http", "tcp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("www", s->s_name);
+  ASSERT_EQ(htons(80), s->s_port);
+
+  ASSERT_TRUE(getservbyname("domain", "sctp") == NULL);
+  ASSERT_TRUE(getservbyname("no-such-service", "tcp") == NULL);
+}
+
+TEST(netdb, getservbyport) {
+  servent* s = getservbyport(htons(22), "tcp");
+  ASSERT_TRUE(s != NULL);
+  ASSERT_STREQ("ssh", s->s_name);
+  ASSERT_STREQ("tcp", s->s_proto);
+
+  ASSERT_TRUE(getservbyport(htons(1), "udp") == NULL);
+}
@@ -15,6 +15,7 @@
  */
 
 #include "benchmark.h"
+#include <pthread.h>
 #include <unistd.h>
 
 #define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
@@ -146,3 +147,187 @@ static void BM_property_find(int iters, int nprops)
     StopBenchmarkTiming();
 }
 BENCHMARK(BM_property_find)->TEST_NUM_PROPS;
+
+static void BM_property_cached_read(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    prop_cache_t* caches = new prop_cache_t[nprops];
+    for (int i = 0; i < nprops; i++) {
+        __system_property_cache_init(&caches[i], pa.names[i]);
+    }
+
+    srandom(iters * nprops);
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < iters; i++) {
+        __system_property_cached_read(&caches[random() % nprops]);
+    }
+    StopBenchmarkTiming();
+
+    delete[] caches;
+}
+BENCHMARK(BM_property_cached_read)->TEST_NUM_PROPS;
+
+struct PropertyUpdater {
+    const prop_info* pi;
+    volatile bool stop;
+};
+
+static void* PropertyUpdaterFn(void* arg)
+{
+    PropertyUpdater* updater = reinterpret_cast<PropertyUpdater*>(arg);
+    prop_info* pi = const_cast<prop_info*>(updater->pi);
+    while (!updater->stop) {
+        __system_property_update(pi, "value1", 6);
+        __system_property_update(pi, "value_22", 8);
+    }
+    return NULL;
+}
+
+// Reads a property that another thread keeps rewriting, so that readers
+// regularly find it dirty and have to retry or wait.
+static void BM_property_read_while_updating(int iters)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(1);
+    char value[PROP_VALUE_MAX];
+
+    if (!pa.valid)
+        return;
+
+    PropertyUpdater updater;
+    updater.pi = __system_property_find(pa.names[0]);
+    updater.stop = false;
+    if (updater.pi == NULL)
+        return;
+
+    pthread_t t;
+    pthread_create(&t, NULL, PropertyUpdaterFn, &updater);
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < iters; i++) {
+        __system_property_read(updater.pi, NULL, value);
+    }
+    StopBenchmarkTiming();
+
+    updater.stop = true;
+    pthread_join(t, NULL);
+}
+BENCHMARK(BM_property_read_while_updating);
+
+struct PropertyPingPong {
+    const prop_info* pi;
+    int iters;
+    unsigned serial;
+};
+
+static void* PropertyPongFn(void* arg)
+{
+    PropertyPingPong* ping_pong = reinterpret_cast<PropertyPingPong*>(arg);
+    prop_info* pi = const_cast<prop_info*>(ping_pong->pi);
+    unsigned serial = ping_pong->serial;
+    for (int i = 0; i < ping_pong->iters; i++) {
+        // Wait for the ping, then answer.
+        serial = __system_property_wait_any(serial);
+        __system_property_update(pi, "pong", 4);
+        serial++;
+    }
+    return NULL;
+}
+
+// Measures the round trip of a property change waking a waiter, and the
+// waiter's change waking us in turn.
+static void BM_property_wait_wake(int iters)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(1);
+
+    if (!pa.valid)
+        return;
+
+    PropertyPingPong ping_pong;
+    ping_pong.pi = __system_property_find(pa.names[0]);
+    ping_pong.iters = iters;
+    if (ping_pong.pi == NULL)
+        return;
+    prop_info* pi = const_cast<prop_info*>(ping_pong.pi);
+
+    // The area serial is never zero once a property has been added, so this
+    // returns at once.
+    unsigned serial = __system_property_wait_any(0);
+    ping_pong.serial = serial;
+    pthread_t t;
+    pthread_create(&t, NULL, PropertyPongFn, &ping_pong);
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < iters; i++) {
+        __system_property_update(pi, "ping", 4);
+        serial = __system_property_wait_any(serial + 1);
+    }
+    StopBenchmarkTiming();
+
+    pthread_join(t, NULL);
+}
+BENCHMARK(BM_property_wait_wake);
+
+static void PropertyForeachFn(const prop_info* pi, void* cookie)
+{
+    char name[PROP_NAME_MAX];
+    char value[PROP_VALUE_MAX];
+    __system_property_read(pi, name, value);
+    ++*reinterpret_cast<int*>(cookie);
+}
+
+static void BM_property_foreach(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < iters; i++) {
+        int count = 0;
+        __system_property_foreach(PropertyForeachFn, &count);
+    }
+    StopBenchmarkTiming();
+}
+BENCHMARK(BM_property_foreach)->Arg(1024);
+
+static void PropertyForeachViewFn(const prop_view_t* view, void* cookie)
+{
+    *reinterpret_cast<size_t*>(cookie) += view->name_len + view->value_len;
+}
+
+static void BM_property_foreach_view(int iters, int nprops)
+{
+    StopBenchmarkTiming();
+
+    LocalPropertyTestState pa(nprops);
+
+    if (!pa.valid)
+        return;
+
+    StartBenchmarkTiming();
+
+    for (int i = 0; i < iters; i++) {
+        size_t bytes = 0;
+        __system_property_foreach_view(PropertyForeachViewFn, &bytes);
+    }
+    StopBenchmarkTiming();
+}
+BENCHMARK(BM_property_foreach_view)->Arg(1024);
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <pthread.h>
+#include <signal.h>
+
+static void BM_pthread_mutex_lock(int iters) {
+  StopBenchmarkTiming();
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_mutex_lock(&mutex);
+    pthread_mutex_unlock(&mutex);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_mutex_lock);
+
+// One mutex shared by every thread of the run.
+static pthread_mutex_t gContendedMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void BM_pthread_mutex_lock_contended(int iters) {
+  for (int i = 0; i < iters; ++i) {
+    pthread_mutex_lock(&gContendedMutex);
+    pthread_mutex_unlock(&gContendedMutex);
+  }
+}
+BENCHMARK(BM_pthread_mutex_lock_contended)->Threads(1)->Threads(2)->Threads(4);
+
+static void BM_pthread_spin_lock(int iters) {
+  StopBenchmarkTiming();
+  pthread_spinlock_t lock;
+  pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_spin_lock(&lock);
+    pthread_spin_unlock(&lock);
+  }
+
+  StopBenchmarkTiming();
+  pthread_spin_destroy(&lock);
+}
+BENCHMARK(BM_pthread_spin_lock);
+
+static void DummyOnceInit() {
+}
+
+static void BM_pthread_once(int iters) {
+  StopBenchmarkTiming();
+  pthread_once_t once = PTHREAD_ONCE_INIT;
+  pthread_once(&once, DummyOnceInit);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_once(&once, DummyOnceInit);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_once);
+
+struct barrier_arg_t {
+  pthread_barrier_t barrier;
+  int iters;
+};
+
+static void* BarrierThread(void* p) {
+  barrier_arg_t* arg = reinterpret_cast<barrier_arg_t*>(p);
+  for (int i = 0; i < arg->iters; ++i) {
+    pthread_barrier_wait(&arg->barrier);
+  }
+  return NULL;
+}
+
+// Each iteration is one phase: every thread arrives and all are released.
+static void BM_pthread_barrier_wait(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  barrier_arg_t arg;
+  pthread_barrier_init(&arg.barrier, NULL, nthreads);
+  arg.iters = iters;
+  pthread_t* threads = new pthread_t[nthreads - 1];
+  for (int i = 0; i < nthreads - 1; ++i) {
+    pthread_create(&threads[i], NULL, BarrierThread, &arg);
+  }
+  StartBenchmarkTiming();
+
+  BarrierThread(&arg);
+
+  StopBenchmarkTiming();
+  for (int i = 0; i < nthreads - 1; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  delete[] threads;
+  pthread_barrier_destroy(&arg.barrier);
+}
+BENCHMARK(BM_pthread_barrier_wait)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+static void* IdleThread(void*) {
+  return NULL;
+}
+
+static void BM_pthread_create_join(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, IdleThread, NULL);
+    pthread_join(thread, NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_pthread_create_join);
+
+// Entering a critical section that's already protected, as nested code does.
+static void BM_pthread_sigmask_already_blocked(int iters) {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  sigset_t old_set;
+  pthread_sigmask(SIG_BLOCK, &set, &old_set);
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+  }
+  StopBenchmarkTiming();
+
+  pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+}
+BENCHMARK(BM_pthread_sigmask_already_blocked);
@@ -16,11 +16,20 @@
 
 #include <gtest/gtest.h>
 
+#include <dlfcn.h>
 #include <errno.h>
 #include <limits.h>
 #include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
+#if __BIONIC__
+#include <libc/private/bionic_thread_table.h>
+#endif
+
 TEST(pthread, pthread_key_create) {
   pthread_key_t key;
   ASSERT_EQ(0, pthread_key_create(&key, NULL));
@@ -51,6 +60,86 @@ TEST(pthread, pthread_key_create_lots) {
 }
 #endif
 
+struct many_keys_arg_t {
+  std::vector<pthread_key_t>* keys;
+  bool ok;
+};
+
+static void* ManyKeysFn(void* p) {
+  many_keys_arg_t* arg = reinterpret_cast<many_keys_arg_t*>(p);
+  std::vector<pthread_key_t>& keys = *arg->keys;
+  arg->ok = true;
+  // A new thread sees NULL for every key, set or not in other threads.
+  for (size_t i = 0; i < keys.size(); ++i) {
+    arg->ok = arg->ok && (pthread_getspecific(keys[i]) == NULL);
+    pthread_setspecific(keys[i], &keys[i]);
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    arg->ok = arg->ok && (pthread_getspecific(keys[i]) == &keys[i]);
+  }
+  return NULL;
+}
+
+static int gManyKeysDestructorCalls = 0;
+
+static void ManyKeysDestructor(void*) {
+  __sync_fetch_and_add(&gManyKeysDestructorCalls, 1);
+}
+
+TEST(pthread, pthread_key_create_more_than_posix_minimum) {
+  // More keys than fit in the first level on bionic.
+  std::vector<pthread_key_t> keys;
+  for (size_t i = 0; i < 2 * _POSIX_THREAD_KEYS_MAX; ++i) {
+    pthread_key_t key;
+    ASSERT_EQ(0, pthread_key_create(&key, ManyKeysDestructor));
+    keys.push_back(key);
+    ASSERT_EQ(0, pthread_setspecific(key, &keys));
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(&keys, pthread_getspecific(keys[i]));
+  }
+
+  many_keys_arg_t arg;
+  arg.keys = &keys;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ManyKeysFn, &arg));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_TRUE(arg.ok);
+  // The thread's values were destroyed when it exited, and ours are untouched.
+  ASSERT_EQ(static_cast<int>(keys.size()), gManyKeysDestructorCalls);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(&keys, pthread_getspecific(keys[i]));
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(0, pthread_key_delete(keys[i]));
+  }
+}
+
+static pthread_key_t gRearmKey;
+static int gRearmDestructorCalls = 0;
+
+static void RearmDestructor(void* value) {
+  // Setting the key again from its own destructor gets it destroyed again
+  // in the next round, up to PTHREAD_DESTRUCTOR_ITERATIONS rounds.
+  ++gRearmDestructorCalls;
+  pthread_setspecific(gRearmKey, value);
+}
+
+static void* RearmFn(void*) {
+  pthread_setspecific(gRearmKey, &gRearmKey);
+  return NULL;
+}
+
+TEST(pthread, pthread_key_destructor_sets_key) {
+  ASSERT_EQ(0, pthread_key_create(&gRearmKey, RearmDestructor));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, RearmFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_EQ(PTHREAD_DESTRUCTOR_ITERATIONS, gRearmDestructorCalls);
+  ASSERT_EQ(0, pthread_key_delete(gRearmKey));
+}
+
 static void* IdFn(void* arg) {
   return arg;
 }
@@ -234,6 +323,42 @@ TEST(pthread, pthread_setname_np__other) {
 }
 #endif
 
+#if __BIONIC__
+static void* NameStackFn(void*) {
+  if (pthread_setname_np(pthread_self(), "stack test") != 0) {
+    return const_cast<char*>("pthread_setname_np failed");
+  }
+  FILE* fp = fopen("/proc/self/maps", "r");
+  if (fp == NULL) {
+    return const_cast<char*>("couldn't open /proc/self/maps");
+  }
+  bool named_anything = false;
+  bool named_stack = false;
+  char line[BUFSIZ];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    named_anything |= (strstr(line, "[anon:") != NULL);
+    named_stack |= (strstr(line, "[anon:thread stack:stack test]") != NULL);
+  }
+  fclose(fp);
+  if (!named_anything) {
+    return const_cast<char*>("skip");
+  }
+  return const_cast<char*>(named_stack ? "ok" : "stack not named");
+}
+
+TEST(pthread, pthread_setname_np__names_stack) {
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, NameStackFn, NULL));
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  if (strcmp(reinterpret_cast<char*>(result), "skip") == 0) {
+    fprintf(stderr, "skipping test: this kernel can't name anonymous memory!\n");
+  } else {
+    ASSERT_STREQ("ok", reinterpret_cast<char*>(result));
+  }
+}
+#endif
+
 #if __BIONIC__ // Not all build servers have a new enough glibc? TODO: remove when they're on gprecise.
 TEST(pthread, pthread_setname_np__no_such_thread) {
   pthread_t dead_thread;
@@ -351,6 +476,49 @@ TEST(pthread, pthread_join__multijoin) {
   ASSERT_EQ(0, reinterpret_cast<int>(join_result));
 }
 
+static void* ReturnArgFn(void* arg) {
+  return arg;
+}
+
+TEST(pthread, pthread_join__exited_thread) {
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ReturnArgFn, reinterpret_cast<void*>(123)));
+  usleep(100000); // (Give t a chance to be completely gone.)
+
+  void* join_result;
+  ASSERT_EQ(0, pthread_join(t, &join_result));
+  ASSERT_EQ(123, reinterpret_cast<int>(join_result));
+}
+
+#if defined(__BIONIC__)
+static void* JoinAndExitFn(void* arg) {
+  void* join_result;
+  int rc = pthread_join(reinterpret_cast<pthread_t>(arg), &join_result);
+  _exit((rc == 0 && join_result == reinterpret_cast<void*>(123)) ? 0 : 1);
+}
+#endif
+
+TEST(pthread, pthread_join__forking_thread) {
+#if defined(__BIONIC__) // glibc's pthread_exit unwinds, and gtest catches that.
+  // In a fork child, the thread that called fork can still be joined.
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, JoinAndExitFn, reinterpret_cast<void*>(pthread_self())) != 0) {
+      _exit(2);
+    }
+    pthread_exit(reinterpret_cast<void*>(123));
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
+
 static void* GetActualGuardSizeFn(void* arg) {
   pthread_attr_t attributes;
   pthread_getattr_np(pthread_self(), &attributes);
@@ -442,3 +610,419 @@ TEST(pthread, pthread_attr_setstacksize) {
   ASSERT_EQ(GetActualStackSize(attributes), 32*1024U);
 #endif
 }
+
+static pthread_mutex_t gAdaptiveMutex;
+static int gAdaptiveCounter;
+
+static void* AdaptiveMutexFn(void*) {
+  for (int i = 0; i < 10000; ++i) {
+    pthread_mutex_lock(&gAdaptiveMutex);
+    ++gAdaptiveCounter;
+    pthread_mutex_unlock(&gAdaptiveMutex);
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_mutex_adaptive) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP));
+  int type;
+  ASSERT_EQ(0, pthread_mutexattr_gettype(&attr, &type));
+  ASSERT_EQ(PTHREAD_MUTEX_ADAPTIVE_NP, type);
+  ASSERT_EQ(0, pthread_mutex_init(&gAdaptiveMutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+
+  // Uncontended lock, trylock and unlock.
+  ASSERT_EQ(0, pthread_mutex_lock(&gAdaptiveMutex));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&gAdaptiveMutex));
+  ASSERT_EQ(0, pthread_mutex_unlock(&gAdaptiveMutex));
+  ASSERT_EQ(0, pthread_mutex_trylock(&gAdaptiveMutex));
+  ASSERT_EQ(0, pthread_mutex_unlock(&gAdaptiveMutex));
+
+  // Contended: the counter must come out exact.
+  gAdaptiveCounter = 0;
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, AdaptiveMutexFn, NULL));
+  }
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(4 * 10000, gAdaptiveCounter);
+  ASSERT_EQ(0, pthread_mutex_destroy(&gAdaptiveMutex));
+}
+
+static pthread_mutex_t gPiMutex;
+static int gPiCounter;
+
+static void* PiMutexFn(void*) {
+  for (int i = 0; i < 10000; ++i) {
+    pthread_mutex_lock(&gPiMutex);
+    ++gPiCounter;
+    pthread_mutex_unlock(&gPiMutex);
+  }
+  return NULL;
+}
+
+static void* PiMutexUnlockFn(void*) {
+  return reinterpret_cast<void*>(pthread_mutex_unlock(&gPiMutex));
+}
+
+TEST(pthread, pthread_mutex_prio_inherit) {
+  pthread_mutexattr_t attr;
+  ASSERT_EQ(0, pthread_mutexattr_init(&attr));
+  int protocol;
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_NONE, protocol);
+  ASSERT_EQ(0, pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT));
+  ASSERT_EQ(0, pthread_mutexattr_getprotocol(&attr, &protocol));
+  ASSERT_EQ(PTHREAD_PRIO_INHERIT, protocol);
+  ASSERT_EQ(0, pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK));
+  ASSERT_EQ(0, pthread_mutex_init(&gPiMutex, &attr));
+  ASSERT_EQ(0, pthread_mutexattr_destroy(&attr));
+
+  ASSERT_EQ(0, pthread_mutex_lock(&gPiMutex));
+  ASSERT_EQ(EDEADLK, pthread_mutex_lock(&gPiMutex));
+  ASSERT_EQ(EBUSY, pthread_mutex_trylock(&gPiMutex));
+
+  // Only the owner may unlock.
+  pthread_t t;
+  void* result;
+  ASSERT_EQ(0, pthread_create(&t, NULL, PiMutexUnlockFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(EPERM, reinterpret_cast<int>(result));
+  ASSERT_EQ(0, pthread_mutex_unlock(&gPiMutex));
+
+  gPiCounter = 0;
+  pthread_t threads[4];
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, PiMutexFn, NULL));
+  }
+  for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(4 * 10000, gPiCounter);
+  ASSERT_EQ(0, pthread_mutex_destroy(&gPiMutex));
+}
+
+TEST(pthread, pthread_rwlock_smoke) {
+  pthread_rwlock_t l;
+  ASSERT_EQ(0, pthread_rwlock_init(&l, NULL));
+
+  // Readers share the lock and keep writers out.
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_tryrdlock(&l));
+  ASSERT_EQ(EBUSY, pthread_rwlock_trywrlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+
+  // A writer keeps everyone else out.
+  ASSERT_EQ(0, pthread_rwlock_wrlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_trywrlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+}
+
+static pthread_rwlock_t gRwlock = PTHREAD_RWLOCK_INITIALIZER;
+static int gRwlockValue;
+
+static void* RwlockTimedRdlockFn(void*) {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_nsec += 10 * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  return reinterpret_cast<void*>(pthread_rwlock_timedrdlock(&gRwlock, &ts));
+}
+
+static void* RwlockReaderFn(void*) {
+  for (int i = 0; i < 10000; ++i) {
+    pthread_rwlock_rdlock(&gRwlock);
+    // Writers always leave the value even.
+    if ((gRwlockValue & 1) != 0) {
+      pthread_rwlock_unlock(&gRwlock);
+      return reinterpret_cast<void*>(1);
+    }
+    pthread_rwlock_unlock(&gRwlock);
+  }
+  return NULL;
+}
+
+static void* RwlockWriterFn(void*) {
+  for (int i = 0; i < 1000; ++i) {
+    pthread_rwlock_wrlock(&gRwlock);
+    ++gRwlockValue;
+    ++gRwlockValue;
+    pthread_rwlock_unlock(&gRwlock);
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_rwlock_contended) {
+  // A reader times out while a writer holds the lock.
+  ASSERT_EQ(0, pthread_rwlock_wrlock(&gRwlock));
+  pthread_t t;
+  void* result;
+  ASSERT_EQ(0, pthread_create(&t, NULL, RwlockTimedRdlockFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_EQ(ETIMEDOUT, reinterpret_cast<int>(result));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&gRwlock));
+
+  gRwlockValue = 0;
+  pthread_t threads[6];
+  for (size_t i = 0; i < 6; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, (i < 4) ? RwlockReaderFn : RwlockWriterFn, NULL));
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_TRUE(result == NULL);
+  }
+  ASSERT_EQ(2 * 2 * 1000, gRwlockValue);
+}
+
+#if __BIONIC__
+TEST(pthread, pthread_rwlockattr_setkind_np) {
+  pthread_rwlockattr_t attr;
+  ASSERT_EQ(0, pthread_rwlockattr_init(&attr));
+  int kind;
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_PREFER_WRITER_NP, kind);
+  ASSERT_EQ(0, pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_READER_NP));
+  ASSERT_EQ(0, pthread_rwlockattr_getkind_np(&attr, &kind));
+  ASSERT_EQ(PTHREAD_RWLOCK_PREFER_READER_NP, kind);
+  ASSERT_EQ(EINVAL, pthread_rwlockattr_setkind_np(&attr, 42));
+
+  pthread_rwlock_t l;
+  ASSERT_EQ(0, pthread_rwlock_init(&l, &attr));
+  ASSERT_EQ(0, pthread_rwlock_rdlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_unlock(&l));
+  ASSERT_EQ(0, pthread_rwlock_destroy(&l));
+  ASSERT_EQ(0, pthread_rwlockattr_destroy(&attr));
+}
+#endif
+
+static pthread_mutex_t gBroadcastMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gBroadcastCond = PTHREAD_COND_INITIALIZER;
+static int gBroadcastWaiting;
+static int gBroadcastGeneration;
+
+static void* CondBroadcastFn(void*) {
+  pthread_mutex_lock(&gBroadcastMutex);
+  int generation = gBroadcastGeneration;
+  ++gBroadcastWaiting;
+  while (generation == gBroadcastGeneration) {
+    pthread_cond_wait(&gBroadcastCond, &gBroadcastMutex);
+  }
+  --gBroadcastWaiting;
+  pthread_mutex_unlock(&gBroadcastMutex);
+  return NULL;
+}
+
+TEST(pthread, pthread_cond_broadcast__wakes_all) {
+  pthread_t threads[16];
+  for (size_t i = 0; i < 16; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, CondBroadcastFn, NULL));
+  }
+
+  // Wait for everyone to block, then release them all at once.
+  for (;;) {
+    pthread_mutex_lock(&gBroadcastMutex);
+    bool all_waiting = (gBroadcastWaiting == 16);
+    if (all_waiting) {
+      ++gBroadcastGeneration;
+      ASSERT_EQ(0, pthread_cond_broadcast(&gBroadcastCond));
+    }
+    pthread_mutex_unlock(&gBroadcastMutex);
+    if (all_waiting) {
+      break;
+    }
+    usleep(1000);
+  }
+
+  // Every waiter must get the mutex in turn and leave.
+  for (size_t i = 0; i < 16; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(0, gBroadcastWaiting);
+}
+
+static pthread_barrier_t gBarrier;
+static int gBarrierSerialCount;
+
+static void* BarrierFn(void*) {
+  for (int i = 0; i < 100; ++i) {
+    int result = pthread_barrier_wait(&gBarrier);
+    if (result == PTHREAD_BARRIER_SERIAL_THREAD) {
+      __sync_fetch_and_add(&gBarrierSerialCount, 1);
+    } else if (result != 0) {
+      return reinterpret_cast<void*>(result);
+    }
+  }
+  return NULL;
+}
+
+TEST(pthread, pthread_barrier) {
+  ASSERT_EQ(EINVAL, pthread_barrier_init(&gBarrier, NULL, 0));
+  ASSERT_EQ(0, pthread_barrier_init(&gBarrier, NULL, 4));
+
+  gBarrierSerialCount = 0;
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, BarrierFn, NULL));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    ASSERT_TRUE(result == NULL);
+  }
+  // Exactly one thread per cycle gets the serial return value.
+  ASSERT_EQ(100, gBarrierSerialCount);
+  ASSERT_EQ(0, pthread_barrier_destroy(&gBarrier));
+}
+
+TEST(pthread, pthread_spin) {
+  pthread_spinlock_t lock;
+  ASSERT_EQ(0, pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE));
+  ASSERT_EQ(0, pthread_spin_lock(&lock));
+  ASSERT_EQ(EBUSY, pthread_spin_trylock(&lock));
+  ASSERT_EQ(0, pthread_spin_unlock(&lock));
+  ASSERT_EQ(0, pthread_spin_trylock(&lock));
+  ASSERT_EQ(0, pthread_spin_unlock(&lock));
+  ASSERT_EQ(0, pthread_spin_destroy(&lock));
+}
+
+static void* StackUserFn(void*) {
+  // Dirty a fair amount of stack, so that a reused stack has stale data on it.
+  volatile char buf[16 * 1024];
+  for (size_t i = 0; i < sizeof(buf); ++i) {
+    buf[i] = 'x';
+  }
+  return reinterpret_cast<void*>(buf[sizeof(buf) - 1] == 'x');
+}
+
+TEST(pthread, pthread_create__reuses_stacks) {
+  // Alternate between two stack sizes, so that creations both hit and miss the cache.
+  for (size_t i = 0; i < 200; ++i) {
+    pthread_attr_t attr;
+    ASSERT_EQ(0, pthread_attr_init(&attr));
+    ASSERT_EQ(0, pthread_attr_setstacksize(&attr, (i % 2) ? 64*1024 : 128*1024));
+    pthread_t t;
+    ASSERT_EQ(0, pthread_create(&t, &attr, StackUserFn, NULL));
+    void* result;
+    ASSERT_EQ(0, pthread_join(t, &result));
+    ASSERT_TRUE(result != NULL);
+  }
+}
+
+static pthread_once_t gSlowOnce = PTHREAD_ONCE_INIT;
+static volatile int gSlowOnceCalls = 0;
+static volatile int gSlowOnceDone = 0;
+
+static void SlowOnceInit() {
+  ++gSlowOnceCalls;
+  // Give the other threads time to start waiting.
+  usleep(50000);
+  gSlowOnceDone = 1;
+}
+
+static void* SlowOnceFn(void*) {
+  pthread_once(&gSlowOnce, SlowOnceInit);
+  return reinterpret_cast<void*>(gSlowOnceDone);
+}
+
+TEST(pthread, pthread_once__contended) {
+  pthread_t threads[8];
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, SlowOnceFn, NULL));
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    void* result;
+    ASSERT_EQ(0, pthread_join(threads[i], &result));
+    // Nobody returned before the initialization had completed.
+    ASSERT_EQ(1, reinterpret_cast<int>(result));
+  }
+  ASSERT_EQ(1, gSlowOnceCalls);
+}
+
+static void* LockUnlockFn(void* arg) {
+  pthread_mutex_t* lock = reinterpret_cast<pthread_mutex_t*>(arg);
+  pthread_mutex_lock(lock);
+  pthread_mutex_unlock(lock);
+  return NULL;
+}
+
+TEST(pthread, pthread_mutex_contention_dump_np) {
+#if __BIONIC__
+  // Profiling is off unless debug.libc.pthread.contention is set, but the
+  // contended lock path has to work either way.
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  ASSERT_EQ(0, pthread_mutex_lock(&lock));
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, LockUnlockFn, &lock));
+  usleep(10000);
+  ASSERT_EQ(0, pthread_mutex_unlock(&lock));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  int rc = pthread_mutex_contention_dump_np(-1);
+  ASSERT_TRUE(rc == 0 || rc == ENOTSUP);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+#if __BIONIC__
+static bool ThreadTableHas(pid_t tid) {
+  bionic_thread_table* table =
+      reinterpret_cast<bionic_thread_table*>(dlsym(RTLD_DEFAULT, "__bionic_thread_table"));
+  if (table == NULL) {
+    return false;
+  }
+  for (uint32_t i = 0; i < table->used; ++i) {
+    if (table->records[i].tid == tid) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct ThreadTableArg {
+  pthread_mutex_t lock;
+  pid_t tid;
+};
+
+static void* ThreadTableFn(void* arg) {
+  ThreadTableArg* table_arg = reinterpret_cast<ThreadTableArg*>(arg);
+  table_arg->tid = gettid();
+  pthread_mutex_lock(&table_arg->lock);
+  pthread_mutex_unlock(&table_arg->lock);
+  return NULL;
+}
+#endif // __BIONIC__
+
+TEST(pthread, thread_table) {
+#if __BIONIC__
+  // The table libthread_db reads holds every running thread, and only those.
+  ASSERT_TRUE(ThreadTableHas(gettid()));
+
+  ThreadTableArg arg;
+  pthread_mutex_init(&arg.lock, NULL);
+  arg.tid = 0;
+  pthread_mutex_lock(&arg.lock);
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ThreadTableFn, &arg));
+  while (arg.tid == 0) {
+    usleep(1000);
+  }
+  ASSERT_TRUE(ThreadTableHas(arg.tid));
+  pthread_mutex_unlock(&arg.lock);
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_FALSE(ThreadTableHas(arg.tid));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/realpath_cache.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+TEST(realpath_cache, android_realpath_cached) {
+  char dir_template[] = "/data/local/tmp/realpath_cache-XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir_template) != NULL);
+  std::string dir(dir_template);
+  ASSERT_EQ(0, mkdir((dir + "/a").c_str(), 0700));
+  ASSERT_EQ(0, symlink("a", (dir + "/link").c_str()));
+  ASSERT_EQ(0, symlink("loop", (dir + "/loop").c_str()));
+
+  const char* paths[] = {
+    "/", "/proc/self/..", "/system/bin/sh", "a", "link", "link/", "link/..", "./a//", "loop", "a/missing",
+  };
+  char cwd[PATH_MAX];
+  ASSERT_TRUE(getcwd(cwd, sizeof(cwd)) != NULL);
+  ASSERT_EQ(0, chdir(dir.c_str()));
+  android_realpath_cache_t* cache = android_realpath_cache_create();
+  ASSERT_TRUE(cache != NULL);
+  // Twice, so the second pass comes out of the cache.
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+      char expected[PATH_MAX];
+      errno = 0;
+      bool ok = (realpath(paths[i], expected) != NULL);
+      int expected_errno = errno;
+      char actual[PATH_MAX];
+      errno = 0;
+      if (ok) {
+        ASSERT_TRUE(android_realpath_cached(cache, paths[i], actual) != NULL) << paths[i];
+        ASSERT_STREQ(expected, actual);
+      } else {
+        ASSERT_TRUE(android_realpath_cached(cache, paths[i], actual) == NULL) << paths[i];
+        ASSERT_EQ(expected_errno, errno) << paths[i];
+      }
+    }
+  }
+
+  // With no buffer, the result is allocated.
+  char* resolved = android_realpath_cached(cache, "link", NULL);
+  ASSERT_TRUE(resolved != NULL);
+  ASSERT_EQ(dir + "/a", resolved);
+  free(resolved);
+  android_realpath_cache_destroy(cache);
+
+  ASSERT_EQ(0, chdir(cwd));
+  ASSERT_EQ(0, unlink((dir + "/loop").c_str()));
+  ASSERT_EQ(0, unlink((dir + "/link").c_str()));
+  ASSERT_EQ(0, rmdir((dir + "/a").c_str()));
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+}
+
+#endif // __BIONIC__
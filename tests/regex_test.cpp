@@ -36,3 +36,40 @@ TEST(regex, smoke) {
 
   regfree(&re);
 }
+
+TEST(regex, anchors_and_word_boundaries) {
+  // Each regexec call reuses and extends what earlier ones on the same regex_t learned.
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "^(error|warn)[^\n]*[[:<:]]timeout[[:>:]]", REG_EXTENDED | REG_NEWLINE));
+  for (size_t i = 0; i < 2; ++i) {
+    ASSERT_EQ(0, regexec(&re, "error: request timeout", 0, NULL, 0));
+    ASSERT_EQ(0, regexec(&re, "ok\nwarn: timeout after 5s", 0, NULL, 0));
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "error: timeouts", 0, NULL, 0));
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "info: error timeout", 0, NULL, 0));
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "error: request\ntimeout", 0, NULL, 0));
+    ASSERT_EQ(REG_NOMATCH, regexec(&re, "error: timeout", 0, NULL, REG_NOTBOL));
+  }
+
+  regmatch_t match;
+  ASSERT_EQ(0, regexec(&re, "x\nwarn: timeout!", 1, &match, 0));
+  ASSERT_EQ(2, match.rm_so);
+  ASSERT_EQ(15, match.rm_eo);
+  regfree(&re);
+}
+
+TEST(regex, many_states) {
+  // More distinct state sets than are cached, so some steps fall back to the NFA.
+  regex_t re;
+  ASSERT_EQ(0, regcomp(&re, "a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)c", REG_EXTENDED));
+  char s[64];
+  for (unsigned i = 0; i < 4096; ++i) {
+    for (size_t j = 0; j < 12; ++j) {
+      s[j] = (i & (1 << j)) ? 'a' : 'b';
+    }
+    s[12] = 'c';
+    s[13] = '\0';
+    // A match needs an 'a' eleven characters before the 'c'.
+    ASSERT_EQ((i & 2) ? 0 : REG_NOMATCH, regexec(&re, s, 0, NULL, 0)) << s;
+  }
+  regfree(&re);
+}
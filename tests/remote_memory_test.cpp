@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/remote_memory.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static char gData[20000];
+
+TEST(remote_memory, read_and_write) {
+  for (size_t i = 0; i < sizeof(gData); ++i) {
+    gData[i] = static_cast<char>(i * 7);
+  }
+  // A page with a hole after it, to see a read stop short.
+  char* map = reinterpret_cast<char*>(mmap(NULL, 2 * PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(MAP_FAILED, map);
+  ASSERT_EQ(0, munmap(map + PAGE_SIZE, PAGE_SIZE));
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    while (true) {
+      pause();
+    }
+  }
+
+  // Neither end aligned, spanning several pages.
+  char buf[sizeof(gData)];
+  ASSERT_EQ(19000, android_read_remote(pid, buf + 1, gData + 3, 19000));
+  ASSERT_EQ(0, memcmp(buf + 1, gData + 3, 19000));
+
+  ASSERT_EQ(96, android_read_remote(pid, buf, map + PAGE_SIZE - 96, 200));
+  errno = 0;
+  ASSERT_EQ(-1, android_read_remote(pid, buf, map + PAGE_SIZE, 10));
+  ASSERT_NE(0, errno);
+
+  const char* hello = "hello, world";
+  ASSERT_EQ(13, android_write_remote(pid, gData + 5, hello, 13));
+  ASSERT_EQ(15, android_read_remote(pid, buf, gData + 4, 15));
+  ASSERT_EQ(gData[4], buf[0]);
+  ASSERT_STREQ(hello, buf + 1);
+  ASSERT_EQ(gData[18], buf[14]);
+
+  kill(pid, SIGKILL);
+  ASSERT_EQ(pid, waitpid(pid, NULL, 0));
+  munmap(map, PAGE_SIZE);
+}
+
+#endif // __BIONIC__
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <search.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+static int compare_ids(const void* lhs, const void* rhs) {
+  intptr_t a = reinterpret_cast<intptr_t>(lhs);
+  intptr_t b = reinterpret_cast<intptr_t>(rhs);
+  return (a > b) - (a < b);
+}
+
+static std::vector<intptr_t> gWalked;
+static int gDeepest;
+
+static void record_in_order(const void* node, VISIT which, int depth) {
+  if (which == postorder || which == leaf) {
+    gWalked.push_back(*reinterpret_cast<intptr_t const*>(node));
+  }
+  if (depth > gDeepest) {
+    gDeepest = depth;
+  }
+}
+
+TEST(search, tsearch_sorted_insertions_stay_shallow) {
+  void* root = NULL;
+  for (intptr_t id = 1; id <= 4096; ++id) {
+    void* node = tsearch(reinterpret_cast<void*>(id), &root, compare_ids);
+    ASSERT_TRUE(node != NULL);
+    ASSERT_EQ(id, *reinterpret_cast<intptr_t*>(node));
+  }
+  // Searching for an existing key returns its node rather than adding one.
+  void* node = tfind(reinterpret_cast<void*>(100), &root, compare_ids);
+  ASSERT_TRUE(node != NULL);
+  ASSERT_EQ(node, tsearch(reinterpret_cast<void*>(100), &root, compare_ids));
+
+  gWalked.clear();
+  gDeepest = 0;
+  twalk(root, record_in_order);
+  ASSERT_EQ(4096U, gWalked.size());
+  for (size_t i = 0; i < gWalked.size(); ++i) {
+    ASSERT_EQ(static_cast<intptr_t>(i + 1), gWalked[i]);
+  }
+  // A balanced tree of 4096 nodes is 12 or 13 levels deep; an unbalanced one would be 4096.
+  ASSERT_LT(gDeepest, 16);
+
+  for (intptr_t id = 1; id <= 4096; id += 2) {
+    ASSERT_TRUE(tdelete(reinterpret_cast<void*>(id), &root, compare_ids) != NULL);
+  }
+  ASSERT_TRUE(tdelete(reinterpret_cast<void*>(1), &root, compare_ids) == NULL);
+  ASSERT_TRUE(tfind(reinterpret_cast<void*>(1), &root, compare_ids) == NULL);
+  ASSERT_TRUE(tfind(reinterpret_cast<void*>(2), &root, compare_ids) != NULL);
+  for (intptr_t id = 2; id <= 4096; id += 2) {
+    ASSERT_TRUE(tdelete(reinterpret_cast<void*>(id), &root, compare_ids) != NULL);
+  }
+  ASSERT_TRUE(root == NULL);
+}
+
+TEST(search, hsearch_r_grows_and_keeps_entries) {
+  hsearch_data table;
+  memset(&table, 0, sizeof(table));
+  ASSERT_NE(0, hcreate_r(4, &table));
+
+  // Many more entries than asked for: the table grows, but entries don't move.
+  static char keys[1000][8];
+  ENTRY* entries[1000];
+  for (size_t i = 0; i < 1000; ++i) {
+    snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+    ENTRY item = { keys[i], reinterpret_cast<void*>(i) };
+    ASSERT_NE(0, hsearch_r(item, ENTER, &entries[i], &table));
+  }
+  for (size_t i = 0; i < 1000; ++i) {
+    char key[8];
+    snprintf(key, sizeof(key), "k%zu", i);
+    ENTRY item = { key, NULL };
+    ENTRY* found;
+    ASSERT_NE(0, hsearch_r(item, FIND, &found, &table));
+    ASSERT_EQ(entries[i], found);
+    ASSERT_EQ(reinterpret_cast<void*>(i), found->data);
+  }
+
+  // ENTER of an existing key returns the existing entry; FIND of a missing one fails.
+  ENTRY item = { keys[5], reinterpret_cast<void*>(12345) };
+  ENTRY* found;
+  ASSERT_NE(0, hsearch_r(item, ENTER, &found, &table));
+  ASSERT_EQ(reinterpret_cast<void*>(5), found->data);
+  item.key = const_cast<char*>("missing");
+  errno = 0;
+  ASSERT_EQ(0, hsearch_r(item, FIND, &found, &table));
+  ASSERT_TRUE(found == NULL);
+  ASSERT_EQ(ESRCH, errno);
+
+  hdestroy_r(&table);
+}
+
+TEST(search, hcreate_hsearch) {
+  ASSERT_NE(0, hcreate(16));
+  ENTRY item = { const_cast<char*>("answer"), reinterpret_cast<void*>(42) };
+  ASSERT_TRUE(hsearch(item, ENTER) != NULL);
+  item.data = NULL;
+  ENTRY* found = hsearch(item, FIND);
+  ASSERT_TRUE(found != NULL);
+  ASSERT_EQ(reinterpret_cast<void*>(42), found->data);
+  hdestroy();
+}
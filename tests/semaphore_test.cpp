@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+TEST(semaphore, sem_trywait) {
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 2));
+  ASSERT_EQ(0, sem_trywait(&s));
+  ASSERT_EQ(0, sem_trywait(&s));
+  ASSERT_EQ(-1, sem_trywait(&s));
+  ASSERT_EQ(EAGAIN, errno);
+  ASSERT_EQ(0, sem_post(&s));
+  int value;
+  ASSERT_EQ(0, sem_getvalue(&s, &value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(0, sem_destroy(&s));
+}
+
+TEST(semaphore, sem_timedwait) {
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 1));
+
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_REALTIME, &ts));
+  ASSERT_EQ(0, sem_timedwait(&s, &ts));
+
+  // The deadline has already passed by the time we sleep.
+  ASSERT_EQ(-1, sem_timedwait(&s, &ts));
+  ASSERT_EQ(ETIMEDOUT, errno);
+
+  ts.tv_nsec = -1;
+  ASSERT_EQ(-1, sem_timedwait(&s, &ts));
+  ASSERT_EQ(EINVAL, errno);
+  ASSERT_EQ(0, sem_destroy(&s));
+}
+
+#if __BIONIC__
+TEST(semaphore, sem_timedwait_monotonic_np) {
+  sem_t s;
+  ASSERT_EQ(0, sem_init(&s, 0, 0));
+
+  timespec ts;
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &ts));
+  ts.tv_nsec += 10000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  ASSERT_EQ(-1, sem_timedwait_monotonic_np(&s, &ts));
+  ASSERT_EQ(ETIMEDOUT, errno);
+
+  timespec now;
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &now));
+  ASSERT_TRUE(now.tv_sec > ts.tv_sec || (now.tv_sec == ts.tv_sec && now.tv_nsec >= ts.tv_nsec));
+  ASSERT_EQ(0, sem_destroy(&s));
+}
+#endif
+
+struct ping_pong_arg_t {
+  sem_t ping;
+  sem_t pong;
+  int rounds;
+};
+
+static void* PongFn(void* p) {
+  ping_pong_arg_t* arg = reinterpret_cast<ping_pong_arg_t*>(p);
+  for (int i = 0; i < arg->rounds; ++i) {
+    sem_wait(&arg->ping);
+    sem_post(&arg->pong);
+  }
+  return NULL;
+}
+
+TEST(semaphore, sem_post_wait_contended) {
+  ping_pong_arg_t arg;
+  arg.rounds = 10000;
+  ASSERT_EQ(0, sem_init(&arg.ping, 0, 0));
+  ASSERT_EQ(0, sem_init(&arg.pong, 0, 0));
+
+  pthread_t threads[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, PongFn, &arg));
+  }
+  // Every post must eventually be matched by a wait, even though
+  // several threads are sleeping on the same semaphore.
+  for (int i = 0; i < 4 * arg.rounds; ++i) {
+    ASSERT_EQ(0, sem_post(&arg.ping));
+    ASSERT_EQ(0, sem_wait(&arg.pong));
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(0, pthread_join(threads[i], NULL));
+  }
+  ASSERT_EQ(0, sem_destroy(&arg.ping));
+  ASSERT_EQ(0, sem_destroy(&arg.pong));
+}
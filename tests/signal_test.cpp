@@ -17,7 +17,12 @@
 #include <gtest/gtest.h>
 
 #include <errno.h>
+#include <poll.h>
+#include <setjmp.h>
 #include <signal.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
 
 template <typename Fn>
 static void TestSigSet1(Fn fn) {
@@ -153,3 +158,123 @@ TEST(signal, sigwait) {
   ASSERT_EQ(0, errno);
   ASSERT_EQ(SIGALRM, received_signal);
 }
+
+static int g_sigusr1_count;
+
+static void HandleSIGUSR1(int signal_number) {
+  ASSERT_EQ(SIGUSR1, signal_number);
+  ++g_sigusr1_count;
+}
+
+// Leaves SIGUSR1 blocked and pending, and returns the mask that unblocks it.
+static void BlockAndRaiseSIGUSR1(sigset_t* old_set, sigset_t* wait_set) {
+  sigset_t block_set;
+  sigemptyset(&block_set);
+  sigaddset(&block_set, SIGUSR1);
+  ASSERT_EQ(0, sigprocmask(SIG_BLOCK, &block_set, old_set));
+  *wait_set = *old_set;
+  sigdelset(wait_set, SIGUSR1);
+
+  g_sigusr1_count = 0;
+  raise(SIGUSR1);
+  ASSERT_EQ(0, g_sigusr1_count);
+}
+
+TEST(signal, ppoll) {
+  ScopedSignalHandler ssh(SIGUSR1, HandleSIGUSR1);
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pollfd pfd = { fds[0], POLLIN, 0 };
+
+  // With no sigset_t, ppoll is just poll with a timespec.
+  timespec ts = { 0, 1000000 };
+  ASSERT_EQ(0, ppoll(&pfd, 1, &ts, NULL));
+  ASSERT_EQ(1000000, ts.tv_nsec);
+
+  // The pending signal is delivered inside the call, atomically unblocked.
+  sigset_t old_set, wait_set;
+  BlockAndRaiseSIGUSR1(&old_set, &wait_set);
+  ASSERT_EQ(-1, ppoll(&pfd, 1, NULL, &wait_set));
+  ASSERT_EQ(EINTR, errno);
+  ASSERT_EQ(1, g_sigusr1_count);
+  ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &old_set, NULL));
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(signal, epoll_pwait) {
+  ScopedSignalHandler ssh(SIGUSR1, HandleSIGUSR1);
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  ASSERT_NE(-1, epoll_fd);
+  epoll_event events[1];
+
+  ASSERT_EQ(0, epoll_pwait(epoll_fd, events, 1, 1, NULL));
+
+  sigset_t old_set, wait_set;
+  BlockAndRaiseSIGUSR1(&old_set, &wait_set);
+  ASSERT_EQ(-1, epoll_pwait(epoll_fd, events, 1, -1, &wait_set));
+  ASSERT_EQ(EINTR, errno);
+  ASSERT_EQ(1, g_sigusr1_count);
+  ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &old_set, NULL));
+
+  close(epoll_fd);
+}
+
+static sigjmp_buf g_jump_buffer;
+
+static void BlockSIGUSR2(int) {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR2);
+  sigprocmask(SIG_BLOCK, &set, NULL);
+}
+
+static void BlockSIGUSR2AndJump(int signal_number) {
+  BlockSIGUSR2(signal_number);
+  siglongjmp(g_jump_buffer, 1);
+}
+
+static bool IsBlocked(int signal_number) {
+  sigset_t set;
+  sigprocmask(SIG_BLOCK, NULL, &set);
+  return sigismember(&set, signal_number) == 1;
+}
+
+// Signal delivery and sigreturn change the mask without going through
+// sigprocmask, and sigprocmask mustn't be fooled by that.
+TEST(signal, sigprocmask_around_signal_handlers) {
+  sigset_t old_set;
+  ASSERT_EQ(0, sigprocmask(SIG_SETMASK, NULL, &old_set));
+  sigset_t usr2;
+  sigemptyset(&usr2);
+  sigaddset(&usr2, SIGUSR2);
+
+  {
+    // What the handler blocks is unblocked again when it returns.
+    ScopedSignalHandler ssh(SIGUSR1, BlockSIGUSR2);
+    raise(SIGUSR1);
+    ASSERT_FALSE(IsBlocked(SIGUSR2));
+    ASSERT_EQ(0, sigprocmask(SIG_BLOCK, &usr2, NULL));
+    ASSERT_TRUE(IsBlocked(SIGUSR2));
+    ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &old_set, NULL));
+  }
+
+  {
+    // Jumping out leaves it, and the handler's own signal, blocked until the mask is restored.
+    ScopedSignalHandler ssh(SIGUSR1, BlockSIGUSR2AndJump);
+    if (sigsetjmp(g_jump_buffer, 0) == 0) {
+      raise(SIGUSR1);
+      FAIL();
+    }
+    ASSERT_TRUE(IsBlocked(SIGUSR1));
+    ASSERT_TRUE(IsBlocked(SIGUSR2));
+    ASSERT_EQ(0, sigprocmask(SIG_SETMASK, &old_set, NULL));
+    ASSERT_FALSE(IsBlocked(SIGUSR1));
+    ASSERT_FALSE(IsBlocked(SIGUSR2));
+  }
+
+  // system(3) blocks SIGCHLD, and its vfork child unblocks it in memory it shares with us.
+  ASSERT_EQ(0, system("true"));
+  ASSERT_FALSE(IsBlocked(SIGCHLD));
+}
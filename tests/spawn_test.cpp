@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2012 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__BIONIC__)
+#define SH_PATH "/system/bin/sh"
+#else
+#define SH_PATH "/bin/sh"
+#endif
+
+extern char** environ;
+
+static int wait_for(pid_t pid) {
+  int status;
+  EXPECT_EQ(pid, TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)));
+  return status;
+}
+
+TEST(spawn, posix_spawn_exit_status_and_failures) {
+  pid_t pid;
+  char* argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"), const_cast<char*>("exit 7"), NULL };
+  ASSERT_EQ(0, posix_spawn(&pid, SH_PATH, NULL, NULL, argv, environ));
+  int status = wait_for(pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(7, WEXITSTATUS(status));
+
+  // exec failures come back as the error, not as a child exiting with 127.
+  ASSERT_EQ(ENOENT, posix_spawn(&pid, "/does/not/exist", NULL, NULL, argv, environ));
+  ASSERT_EQ(ENOENT, posix_spawnp(&pid, "does-not-exist", NULL, NULL, argv, environ));
+}
+
+TEST(spawn, posix_spawnp_file_actions_and_environment) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  posix_spawn_file_actions_t actions;
+  ASSERT_EQ(0, posix_spawn_file_actions_init(&actions));
+  ASSERT_EQ(0, posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO));
+  ASSERT_EQ(0, posix_spawn_file_actions_addclose(&actions, fds[0]));
+  ASSERT_EQ(0, posix_spawn_file_actions_addopen(&actions, 5, "/dev/null", O_RDONLY, 0));
+
+  pid_t pid;
+  char* argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"),
+                   const_cast<char*>("echo $SPAWN_TEST; test -e /proc/self/fd/5 && echo open"), NULL };
+  char* envp[] = { const_cast<char*>("SPAWN_TEST=hello"), NULL };
+  ASSERT_EQ(0, posix_spawnp(&pid, "sh", &actions, NULL, argv, envp));
+  ASSERT_EQ(0, posix_spawn_file_actions_destroy(&actions));
+  close(fds[1]);
+
+  char buf[64];
+  size_t n = 0;
+  ssize_t rc;
+  while ((rc = TEMP_FAILURE_RETRY(read(fds[0], buf + n, sizeof(buf) - 1 - n))) > 0) {
+    n += rc;
+  }
+  buf[n] = '\0';
+  close(fds[0]);
+  ASSERT_STREQ("hello\nopen\n", buf);
+  ASSERT_TRUE(WIFEXITED(wait_for(pid)));
+}
+
+TEST(spawn, posix_spawnattr_setsigdefault) {
+  sighandler_t old_handler = signal(SIGTERM, SIG_IGN);
+
+  posix_spawnattr_t attr;
+  ASSERT_EQ(0, posix_spawnattr_init(&attr));
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGTERM);
+  ASSERT_EQ(0, posix_spawnattr_setsigdefault(&attr, &defaults));
+  ASSERT_EQ(0, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF));
+  short flags;
+  ASSERT_EQ(0, posix_spawnattr_getflags(&attr, &flags));
+  ASSERT_EQ(POSIX_SPAWN_SETSIGDEF, flags);
+
+  pid_t pid;
+  char* argv[] = { const_cast<char*>("sh"), const_cast<char*>("-c"), const_cast<char*>("kill -TERM $$; exit 0"), NULL };
+  ASSERT_EQ(0, posix_spawn(&pid, SH_PATH, NULL, &attr, argv, environ));
+  ASSERT_EQ(0, posix_spawnattr_destroy(&attr));
+  int status = wait_for(pid);
+  signal(SIGTERM, old_handler);
+  ASSERT_TRUE(WIFSIGNALED(status));
+  ASSERT_EQ(SIGTERM, WTERMSIG(status));
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>
+
+#if defined(__BIONIC__)
+#include <android/format.h>
+#endif
+
+// A mix like a metrics or JSON emitter's: integers, short decimals, and
+// values with a full 17 digits.
+static const double kDoubles[] = {
+  0.0, 1.0, 42.0, 0.5, 3.25, 1234.5678, 0.1, 2.0 / 3.0, 6.02214076e23,
+  1e-7, 299792458.0, 0.30000000000000004, 123456.789e-3, 9.999999,
+};
+static const size_t kDoubleCount = sizeof(kDoubles) / sizeof(kDoubles[0]);
+
+// Avoid optimization.
+static char snprintf_buf[64];
+
+static void BenchmarkSnprintfDouble(int iters, const char* fmt) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    snprintf(snprintf_buf, sizeof(snprintf_buf), fmt,
+             kDoubles[i % kDoubleCount]);
+  }
+
+  StopBenchmarkTiming();
+}
+
+static void BM_stdio_snprintf_g(int iters) {
+  BenchmarkSnprintfDouble(iters, "%g");
+}
+BENCHMARK(BM_stdio_snprintf_g);
+
+static void BM_stdio_snprintf_17g(int iters) {
+  BenchmarkSnprintfDouble(iters, "%.17g");
+}
+BENCHMARK(BM_stdio_snprintf_17g);
+
+static void BM_stdio_snprintf_e(int iters) {
+  BenchmarkSnprintfDouble(iters, "%e");
+}
+BENCHMARK(BM_stdio_snprintf_e);
+
+static void BM_stdio_snprintf_f(int iters) {
+  BenchmarkSnprintfDouble(iters, "%.3f");
+}
+BENCHMARK(BM_stdio_snprintf_f);
+
+// More digits than the fast path does: always __dtoa, for comparison.
+static void BM_stdio_snprintf_20g(int iters) {
+  BenchmarkSnprintfDouble(iters, "%.20g");
+}
+BENCHMARK(BM_stdio_snprintf_20g);
+
+// A typical log line's integers and strings, through snprintf and, where
+// there is one, the allocation-free formatter.
+static void BM_stdio_snprintf_log_line(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    snprintf(snprintf_buf, sizeof(snprintf_buf), "%s: pid %d fd %d size %zu at %p",
+             "open", 1234, i & 0xff, static_cast<size_t>(i), snprintf_buf);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_snprintf_log_line);
+
+#if defined(__BIONIC__)
+static void BM_stdio_android_format_log_line(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_format_buffer(snprintf_buf, sizeof(snprintf_buf), "%s: pid %d fd %d size %zu at %p",
+                          "open", 1234, i & 0xff, static_cast<size_t>(i), snprintf_buf);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_android_format_log_line);
+
+static void BM_stdio_android_format_f(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    android_format_buffer(snprintf_buf, sizeof(snprintf_buf), "%.3f",
+                          kDoubles[i % kDoubleCount]);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdio_android_format_f);
+#endif
+
+// A small header followed by a large payload, flushed after every record.
+static void BM_stdio_fwrite_large(int iters) {
+  FILE* fp = fopen("/dev/null", "w");
+  static char payload[64 * 1024];
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    fputs("record\n", fp);
+    fwrite(payload, sizeof(payload), 1, fp);
+  }
+
+  StopBenchmarkTiming();
+  fclose(fp);
+}
+BENCHMARK(BM_stdio_fwrite_large);
@@ -18,10 +18,15 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdio_ext.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <vector>
+
 TEST(stdio, tmpfile_fileno_fprintf_rewind_fgets) {
   FILE* fp = tmpfile();
   ASSERT_TRUE(fp != NULL);
@@ -211,3 +216,181 @@ TEST(stdio, putc) {
   ASSERT_EQ(EOF, putc('x', fp));
   fclose(fp);
 }
+
+TEST(stdio, fflush_NULL_many_streams) {
+  // Interleave readers and writers, then swap some of each so their FILEs
+  // get reused the other way round; fflush(NULL) must still find every
+  // writer.
+  const size_t kCount = 200;
+  FILE* fps[kCount];
+  bool writer[kCount];
+  for (size_t i = 0; i < kCount; ++i) {
+    writer[i] = (i % 2 == 0);
+    fps[i] = writer[i] ? tmpfile() : fopen("/proc/version", "r");
+    ASSERT_TRUE(fps[i] != NULL);
+  }
+  ASSERT_EQ(0, fflush(NULL));
+  for (size_t i = 0; i < kCount; i += 3) {
+    fclose(fps[i]);
+    writer[i] = !writer[i];
+    fps[i] = writer[i] ? tmpfile() : fopen("/proc/version", "r");
+    ASSERT_TRUE(fps[i] != NULL);
+  }
+
+  for (size_t i = 0; i < kCount; ++i) {
+    if (writer[i]) {
+      ASSERT_EQ('x', fputc('x', fps[i]));
+    }
+  }
+  ASSERT_EQ(0, fflush(NULL));
+  for (size_t i = 0; i < kCount; ++i) {
+    if (writer[i]) {
+      struct stat sb;
+      ASSERT_EQ(0, fstat(fileno(fps[i]), &sb));
+      ASSERT_EQ(1, sb.st_size);
+    }
+    fclose(fps[i]);
+  }
+}
+
+TEST(stdio, unlocked) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(FSETLOCKING_INTERNAL, __fsetlocking(fp, FSETLOCKING_BYCALLER));
+  ASSERT_EQ(FSETLOCKING_BYCALLER, __fsetlocking(fp, FSETLOCKING_QUERY));
+
+  ASSERT_GE(fputs_unlocked("hello\n", fp), 0);
+  ASSERT_EQ(1U, fwrite_unlocked("world", 5, 1, fp));
+  rewind(fp);
+
+  char buf[16];
+  ASSERT_STREQ("hello\n", fgets_unlocked(buf, sizeof(buf), fp));
+  ASSERT_EQ(5U, fread_unlocked(buf, 1, sizeof(buf), fp));
+  ASSERT_EQ(0, memcmp("world", buf, 5));
+
+  ASSERT_EQ(FSETLOCKING_BYCALLER, __fsetlocking(fp, FSETLOCKING_INTERNAL));
+  fclose(fp);
+}
+
+TEST(stdio, fmemopen) {
+  char buf[8];
+  FILE* fp = fmemopen(buf, sizeof(buf), "w");
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(3, fprintf(fp, "abc"));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_STREQ("abc", buf);
+  fclose(fp);
+
+  fp = fmemopen(buf, sizeof(buf), "r");
+  ASSERT_TRUE(fp != NULL);
+  char line[16];
+  ASSERT_TRUE(fgets(line, sizeof(line), fp) != NULL);
+  ASSERT_EQ(0, memcmp("abc", line, 3));
+  fclose(fp);
+}
+
+TEST(stdio, open_memstream) {
+  char* p = NULL;
+  size_t size = 0;
+  FILE* fp = open_memstream(&p, &size);
+  ASSERT_TRUE(fp != NULL);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(2, fprintf(fp, "%d,", i % 10));
+  }
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(2000U, size);
+  ASSERT_EQ(2000U, strlen(p));
+  ASSERT_EQ(0, memcmp("0,1,2,", p, 6));
+
+  // Seeking back reports the size up to the new position.
+  ASSERT_EQ(0, fseek(fp, 10, SEEK_SET));
+  ASSERT_EQ(0, fflush(fp));
+  ASSERT_EQ(10U, size);
+  fclose(fp);
+  ASSERT_EQ(10U, size);
+  free(p);
+}
+
+TEST(stdio, snprintf_double) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%g %g %g %g", 0.0, 1.0, 0.1, 1234567.0);
+  ASSERT_STREQ("0 1 0.1 1.23457e+06", buf);
+  snprintf(buf, sizeof(buf), "%.17g", 0.1);
+  ASSERT_STREQ("0.10000000000000001", buf);
+  // Rounding that carries into a new leading digit.
+  snprintf(buf, sizeof(buf), "%.2f %.3e %g", 9.996, 9.9996, 999999.5);
+  ASSERT_STREQ("10.00 1.000e+01 1e+06", buf);
+  // Exact ties round to even.
+  snprintf(buf, sizeof(buf), "%.2g %.1f %.0f", 0.125, 0.25, 2.5);
+  ASSERT_STREQ("0.12 0.2 2", buf);
+  snprintf(buf, sizeof(buf), "%e %.3g", 5e-324, 1.7976931348623157e308);
+  ASSERT_STREQ("4.940656e-324 1.8e+308", buf);
+}
+
+TEST(stdio, fgetln) {
+#if defined(__BIONIC__)
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  // The second line is longer than any stdio buffer, so fgetln has to
+  // assemble it in the stream's line buffer instead of pointing into the
+  // stream buffer.
+  const size_t kLongLine = 128 * 1024;
+  fputs("short\n", fp);
+  for (size_t i = 0; i < kLongLine; ++i) {
+    fputc('x', fp);
+  }
+  fputs("\nlast", fp);
+  rewind(fp);
+
+  size_t length;
+  char* line = fgetln(fp, &length);
+  ASSERT_TRUE(line != NULL);
+  ASSERT_EQ(6U, length);
+  ASSERT_EQ(0, memcmp("short\n", line, length));
+
+  line = fgetln(fp, &length);
+  ASSERT_TRUE(line != NULL);
+  ASSERT_EQ(kLongLine + 1, length);
+  ASSERT_EQ('x', line[0]);
+  ASSERT_EQ('\n', line[kLongLine]);
+
+  // A final line without a newline still comes back, without one.
+  line = fgetln(fp, &length);
+  ASSERT_TRUE(line != NULL);
+  ASSERT_EQ(4U, length);
+  ASSERT_EQ(0, memcmp("last", line, length));
+
+  ASSERT_TRUE(fgetln(fp, &length) == NULL);
+  fclose(fp);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(stdio, fwrite_large_after_buffered) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(0, setvbuf(fp, NULL, _IOFBF, 1024));
+
+  // Large writes after something is already buffered go straight to the
+  // file along with the buffer; make sure the order and the leftovers
+  // that end up buffered are right.
+  std::vector<char> expected;
+  std::vector<char> payload(10000);
+  for (size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<char>(i * 7);
+  }
+  for (size_t prefix = 1; prefix < 1500; prefix += 499) {
+    ASSERT_EQ(prefix, fwrite(&payload[0], 1, prefix, fp));
+    expected.insert(expected.end(), payload.begin(), payload.begin() + prefix);
+    ASSERT_EQ(payload.size(), fwrite(&payload[0], 1, payload.size(), fp));
+    expected.insert(expected.end(), payload.begin(), payload.end());
+  }
+  ASSERT_EQ(0, fflush(fp));
+
+  std::vector<char> actual(expected.size() + 1);
+  rewind(fp);
+  ASSERT_EQ(expected.size(), fread(&actual[0], 1, actual.size(), fp));
+  ASSERT_EQ(0, memcmp(&expected[0], &actual[0], expected.size()));
+  fclose(fp);
+}
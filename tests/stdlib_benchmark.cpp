@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A mix like CSV or JSON input's: short decimals, a few with exponents,
+// and some printed with a full 17 digits.
+static const char* kNumbers[] = {
+  "0", "42", "3.14159", "-0.5", "123.456", "0.1", "99.99", "1e-7",
+  "6.02214076e23", "2.718281828459045", "0.30000000000000004",
+  "-1234.5678e-3", "1.7976931348623157e308", "4.9406564584124654e-324",
+};
+static const size_t kNumberCount = sizeof(kNumbers) / sizeof(kNumbers[0]);
+
+// Avoid optimization.
+static double strtod_result;
+
+static void BM_stdlib_strtod(int iters) {
+  StartBenchmarkTiming();
+
+  strtod_result = 0.0;
+  for (int i = 0; i < iters; ++i) {
+    strtod_result += strtod(kNumbers[i % kNumberCount], NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtod);
+
+// More than 19 significant digits: always the bignum code.
+static void BM_stdlib_strtod_long(int iters) {
+  StartBenchmarkTiming();
+
+  strtod_result = 0.0;
+  for (int i = 0; i < iters; ++i) {
+    strtod_result += strtod("3.14159265358979323846264338327950288", NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtod_long);
+
+// Config-file sized integers, and the same at full width.
+static const char* kIntegers[] = { "0", "7", "42", "-1", "1024", "65535", "-32768", "2000000" };
+static const size_t kIntegerCount = sizeof(kIntegers) / sizeof(kIntegers[0]);
+
+// Avoid optimization.
+static long long strtol_result;
+
+static void BM_stdlib_strtol(int iters) {
+  StartBenchmarkTiming();
+
+  strtol_result = 0;
+  for (int i = 0; i < iters; ++i) {
+    strtol_result += strtol(kIntegers[i % kIntegerCount], NULL, 10);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtol);
+
+static void BM_stdlib_strtoll_19_digits(int iters) {
+  StartBenchmarkTiming();
+
+  strtol_result = 0;
+  for (int i = 0; i < iters; ++i) {
+    strtol_result += strtoll("-9223372036854775807", NULL, 10);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtoll_19_digits);
+
+static void BM_stdlib_strtoul_hex(int iters) {
+  StartBenchmarkTiming();
+
+  strtol_result = 0;
+  for (int i = 0; i < iters; ++i) {
+    strtol_result += strtoul("0xdeadbeef", NULL, 16);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_strtoul_hex);
+
+static void BM_stdlib_atoi(int iters) {
+  StartBenchmarkTiming();
+
+  strtol_result = 0;
+  for (int i = 0; i < iters; ++i) {
+    strtol_result += atoi(kIntegers[i % kIntegerCount]);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_atoi);
+
+// Avoid optimization.
+static uint32_t arc4random_result;
+
+static void BM_stdlib_arc4random(int iters) {
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    arc4random_result ^= arc4random();
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_stdlib_arc4random);
+
+static void BM_stdlib_arc4random_buf(int iters) {
+  char buf[4096];
+
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    arc4random_buf(buf, sizeof(buf));
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(sizeof(buf)));
+}
+BENCHMARK(BM_stdlib_arc4random_buf);
+
+static int compare_ints(const void* lhs, const void* rhs) {
+  int a = *reinterpret_cast<const int*>(lhs);
+  int b = *reinterpret_cast<const int*>(rhs);
+  return (a > b) - (a < b);
+}
+
+static int compare_strings(const void* lhs, const void* rhs) {
+  return strcmp(*reinterpret_cast<char* const*>(lhs), *reinterpret_cast<char* const*>(rhs));
+}
+
+// Each iteration sorts a fresh copy of the same shuffled ints.
+static void BM_stdlib_qsort_int(int iters, int n) {
+  int* original = new int[n];
+  int* values = new int[n];
+  srand48(n);
+  for (int i = 0; i < n; ++i) {
+    original[i] = lrand48();
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    memcpy(values, original, n * sizeof(int));
+    StartBenchmarkTiming();
+    qsort(values, n, sizeof(int), compare_ints);
+    StopBenchmarkTiming();
+  }
+
+  delete[] values;
+  delete[] original;
+}
+BENCHMARK(BM_stdlib_qsort_int)->Arg(16)->Arg(256)->Arg(4096)->Arg(65536);
+
+static void BM_stdlib_qsort_int_sorted(int iters, int n) {
+  int* values = new int[n];
+  for (int i = 0; i < n; ++i) {
+    values[i] = i;
+  }
+
+  StartBenchmarkTiming();
+  for (int i = 0; i < iters; ++i) {
+    qsort(values, n, sizeof(int), compare_ints);
+  }
+  StopBenchmarkTiming();
+
+  delete[] values;
+}
+BENCHMARK(BM_stdlib_qsort_int_sorted)->Arg(4096)->Arg(65536);
+
+// Sorting an array of pointers to strings, as scandir(3) does.
+static void BM_stdlib_qsort_strings(int iters, int n) {
+  char* strings = new char[n * 16];
+  char** original = new char*[n];
+  char** values = new char*[n];
+  srand48(n);
+  for (int i = 0; i < n; ++i) {
+    original[i] = strings + i * 16;
+    snprintf(original[i], 16, "file%08lx", lrand48());
+  }
+
+  for (int i = 0; i < iters; ++i) {
+    memcpy(values, original, n * sizeof(char*));
+    StartBenchmarkTiming();
+    qsort(values, n, sizeof(char*), compare_strings);
+    StopBenchmarkTiming();
+  }
+
+  delete[] values;
+  delete[] original;
+  delete[] strings;
+}
+BENCHMARK(BM_stdlib_qsort_strings)->Arg(256)->Arg(4096);
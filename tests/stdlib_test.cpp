@@ -19,8 +19,14 @@
 #include <errno.h>
 #include <libgen.h>
 #include <limits.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
 
 TEST(stdlib, drand48) {
   srand48(0x01020304);
@@ -62,6 +68,40 @@ TEST(stdlib, mrand48) {
   EXPECT_EQ(264732262, mrand48());
 }
 
+#if __BIONIC__
+TEST(stdlib, arc4random_fork) {
+  uint32_t buffered = arc4random();  // Leaves the rest of a block behind to be replayed.
+  (void) buffered;
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    uint32_t values[4];
+    arc4random_buf(values, sizeof(values));
+    write(fds[1], values, sizeof(values));
+    _exit(0);
+  }
+  uint32_t parent[4];
+  uint32_t child[4];
+  arc4random_buf(parent, sizeof(parent));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(child)), read(fds[0], child, sizeof(child)));
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  close(fds[0]);
+  close(fds[1]);
+  ASSERT_NE(0, memcmp(parent, child, sizeof(parent)));
+}
+
+TEST(stdlib, arc4random_uniform) {
+  ASSERT_EQ(0U, arc4random_uniform(0));
+  ASSERT_EQ(0U, arc4random_uniform(1));
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_LT(arc4random_uniform(10), 10U);
+  }
+}
+#endif
+
 TEST(stdlib, posix_memalign) {
   void* p;
 
@@ -132,3 +172,134 @@ TEST(stdlib, qsort) {
   ASSERT_STREQ("bravo", entries[1].name);
   ASSERT_STREQ("charlie", entries[2].name);
 }
+
+extern char** environ;
+
+TEST(stdlib, getenv_after_environment_changes) {
+  // Enough lookups to be answered from an index, between each kind of change.
+  ASSERT_EQ(0, setenv("STDLIB_TEST_A", "1", 1));
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_STREQ("1", getenv("STDLIB_TEST_A"));
+    ASSERT_TRUE(getenv("STDLIB_TEST_B") == NULL);
+  }
+  ASSERT_EQ(0, setenv("STDLIB_TEST_B", "2", 1));
+  ASSERT_EQ(0, setenv("STDLIB_TEST_A", "longer than before", 1));
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_STREQ("longer than before", getenv("STDLIB_TEST_A"));
+    ASSERT_STREQ("2", getenv("STDLIB_TEST_B"));
+    ASSERT_STREQ("2", getenv("STDLIB_TEST_B=ignored"));
+  }
+  ASSERT_EQ(0, unsetenv("STDLIB_TEST_A"));
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(getenv("STDLIB_TEST_A") == NULL);
+  }
+
+  // Replacing environ wholesale, and putting it back.
+  char** saved_environ = environ;
+  char* replacement[] = { const_cast<char*>("STDLIB_TEST_A=replaced"), NULL };
+  environ = replacement;
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_STREQ("replaced", getenv("STDLIB_TEST_A"));
+    ASSERT_TRUE(getenv("STDLIB_TEST_B") == NULL);
+  }
+  environ = saved_environ;
+  ASSERT_TRUE(getenv("STDLIB_TEST_A") == NULL);
+  ASSERT_STREQ("2", getenv("STDLIB_TEST_B"));
+  ASSERT_EQ(0, unsetenv("STDLIB_TEST_B"));
+}
+
+static int compare_ints_r(const void* lhs, const void* rhs, void* context) {
+  ++*reinterpret_cast<size_t*>(context);
+  int a = *reinterpret_cast<const int*>(lhs);
+  int b = *reinterpret_cast<const int*>(rhs);
+  return (a > b) - (a < b);
+}
+
+TEST(stdlib, qsort_r) {
+  // Enough for the partitioning (not just insertion sort), with duplicates and a sorted run.
+  int values[200];
+  for (size_t i = 0; i < 200; ++i) {
+    values[i] = (i < 50) ? i : (i * 7919) % 61;
+  }
+  size_t comparisons = 0;
+  qsort_r(values, 200, sizeof(int), compare_ints_r, &comparisons);
+  ASSERT_NE(0U, comparisons);
+  for (size_t i = 1; i < 200; ++i) {
+    ASSERT_LE(values[i - 1], values[i]);
+  }
+}
+
+extern "C" int __cxa_atexit(void (*)(void*), void*, void*);
+extern "C" void __cxa_finalize(void*);
+
+static std::vector<int> gFinalized;
+
+static void record_finalized(void* arg) {
+  gFinalized.push_back(reinterpret_cast<intptr_t>(arg));
+}
+
+TEST(stdlib, __cxa_finalize_one_dso) {
+  // Enough handlers to spill over several tables, interleaved between two fake dsos.
+  static char dso_a, dso_b;
+  for (intptr_t i = 0; i < 5000; ++i) {
+    ASSERT_EQ(0, __cxa_atexit(record_finalized, reinterpret_cast<void*>(i), (i % 2) ? &dso_a : &dso_b));
+  }
+
+  __cxa_finalize(&dso_a);
+  ASSERT_EQ(2500U, gFinalized.size());
+  for (size_t i = 0; i < gFinalized.size(); ++i) {
+    ASSERT_EQ(4999 - 2 * static_cast<int>(i), gFinalized[i]);
+  }
+  __cxa_finalize(&dso_a);
+  ASSERT_EQ(2500U, gFinalized.size());
+
+  gFinalized.clear();
+  __cxa_finalize(&dso_b);
+  ASSERT_EQ(2500U, gFinalized.size());
+  ASSERT_EQ(4998, gFinalized[0]);
+}
+
+TEST(stdlib, strtol_bases_and_overflow) {
+  char* end;
+  // Long decimal runs are converted eight digits at a time; check the joins.
+  ASSERT_EQ(1234567890123456789LL, strtoll("1234567890123456789xyz", &end, 10));
+  ASSERT_STREQ("xyz", end);
+  ASSERT_EQ(-9223372036854775807LL - 1, strtoll("-9223372036854775808", NULL, 10));
+  ASSERT_EQ(18446744073709551615ULL, strtoull("  +18446744073709551615", NULL, 10));
+  ASSERT_EQ(0xdeadbeefUL, strtoul("0xDEADbeef", NULL, 16));
+  ASSERT_EQ(0755, strtol("0755", NULL, 0));
+  ASSERT_EQ(35, strtol("z", NULL, 36));
+
+  errno = 0;
+  ASSERT_EQ(LLONG_MAX, strtoll("9223372036854775808", &end, 10));
+  ASSERT_EQ(ERANGE, errno);
+  ASSERT_EQ('\0', *end);
+  errno = 0;
+  ASSERT_EQ(ULLONG_MAX, strtoull("123456789012345678901234567890", NULL, 10));
+  ASSERT_EQ(ERANGE, errno);
+
+  const char* no_digits = " -x";
+  ASSERT_EQ(0, strtol(no_digits, &end, 10));
+  ASSERT_EQ(no_digits, end);
+  errno = 0;
+  ASSERT_EQ(0, strtol("10", &end, 1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(stdlib, strtod) {
+  ASSERT_DOUBLE_EQ(0.1, strtod("0.1", NULL));
+  ASSERT_EQ(1e23, strtod("1e23", NULL));
+  ASSERT_EQ(123456789012345678.0, strtod("123456789012345678", NULL));
+  // Halfway between two doubles: ties go to even.
+  ASSERT_EQ(9007199254740992.0, strtod("9007199254740993", NULL));
+  ASSERT_EQ(9007199254740996.0, strtod("9007199254740995", NULL));
+  // Smallest normal and subnormal.
+  ASSERT_EQ(2.2250738585072014e-308, strtod("2.2250738585072014e-308", NULL));
+  ASSERT_EQ(4.9406564584124654e-324, strtod("4.9406564584124654e-324", NULL));
+
+  char* end;
+  errno = 0;
+  ASSERT_EQ(HUGE_VAL, strtod("1.7976931348623159e308x", &end));
+  ASSERT_EQ(ERANGE, errno);
+  ASSERT_EQ('x', *end);
+}
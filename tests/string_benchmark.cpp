@@ -16,7 +16,9 @@
 
 #include "benchmark.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <wchar.h>
 
 #define KB 1024
 #define MB 1024*KB
@@ -24,7 +26,13 @@
 #define AT_COMMON_SIZES \
     Arg(8)->Arg(64)->Arg(512)->Arg(1*KB)->Arg(8*KB)->Arg(16*KB)->Arg(32*KB)->Arg(64*KB)
 
-// TODO: test unaligned operation too? (currently everything will be 8-byte aligned by malloc.)
+// From the size at which x86's memcpy and memset switch to non-temporal stores
+// (see arch-x86/string/cache.h) to well past any L2.
+#define AT_LARGE_SIZES \
+    Arg(256*KB)->Arg(1*MB)->Arg(8*MB)->Arg(32*MB)
+
+// Everything above is only as aligned as malloc makes it; the misalignment
+// sweeps at the end of this file control it exactly.
 
 static void BM_string_memcmp(int iters, int nbytes) {
   StopBenchmarkTiming();
@@ -45,6 +53,24 @@ static void BM_string_memcmp(int iters, int nbytes) {
 }
 BENCHMARK(BM_string_memcmp)->AT_COMMON_SIZES;
 
+static void BM_string_memchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 'y';
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += (memchr(s, 'y', nbytes) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_memchr)->AT_COMMON_SIZES;
+
 static void BM_string_memcpy(int iters, int nbytes) {
   StopBenchmarkTiming();
   char* src = new char[nbytes]; char* dst = new char[nbytes];
@@ -60,7 +86,7 @@ static void BM_string_memcpy(int iters, int nbytes) {
   delete[] src;
   delete[] dst;
 }
-BENCHMARK(BM_string_memcpy)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memcpy)->AT_COMMON_SIZES->AT_LARGE_SIZES;
 
 static void BM_string_memmove(int iters, int nbytes) {
   StopBenchmarkTiming();
@@ -78,6 +104,24 @@ static void BM_string_memmove(int iters, int nbytes) {
 }
 BENCHMARK(BM_string_memmove)->AT_COMMON_SIZES;
 
+static void BM_string_memrchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[0] = 'y';
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += (memrchr(s, 'y', nbytes) != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_memrchr)->AT_COMMON_SIZES;
+
 static void BM_string_memset(int iters, int nbytes) {
   StopBenchmarkTiming();
   char* dst = new char[nbytes];
@@ -91,7 +135,64 @@ static void BM_string_memset(int iters, int nbytes) {
   SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
   delete[] dst;
 }
-BENCHMARK(BM_string_memset)->AT_COMMON_SIZES;
+BENCHMARK(BM_string_memset)->AT_COMMON_SIZES->AT_LARGE_SIZES;
+
+static void BM_string_strchr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += (strchr(s, 'y') != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strchr)->AT_COMMON_SIZES;
+
+static void BM_string_strcmp(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s1 = new char[nbytes]; char* s2 = new char[nbytes];
+  memset(s1, 'x', nbytes);
+  memset(s2, 'x', nbytes);
+  s1[nbytes - 1] = 0;
+  s2[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strcmp(s1, s2);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s1;
+  delete[] s2;
+}
+BENCHMARK(BM_string_strcmp)->AT_COMMON_SIZES;
+
+static void BM_string_strcpy(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* src = new char[nbytes]; char* dst = new char[nbytes];
+  memset(src, 'x', nbytes);
+  src[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    strcpy(dst, src);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_strcpy)->AT_COMMON_SIZES;
 
 static void BM_string_strlen(int iters, int nbytes) {
   StopBenchmarkTiming();
@@ -110,3 +211,377 @@ static void BM_string_strlen(int iters, int nbytes) {
   delete[] s;
 }
 BENCHMARK(BM_string_strlen)->AT_COMMON_SIZES;
+
+static void BM_string_strstr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  // A partial match at every position: the case a naive search is quadratic in.
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += (strstr(s, "xxxxxxxy") != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strstr)->AT_COMMON_SIZES;
+
+// A tokenizer-sized delimiter set, none of which appears in the string.
+static const char kDelimiters[] = " \t\r\n,;:=&|<>()[]{}";
+
+static void BM_string_strcspn(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  memset(s, 'x', nbytes);
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strcspn(s, kDelimiters);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strcspn)->AT_COMMON_SIZES;
+
+static void BM_string_strspn(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[nbytes];
+  for (int i = 0; i < nbytes - 1; ++i) {
+    s[i] = kDelimiters[i % (sizeof(kDelimiters) - 1)];
+  }
+  s[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strspn(s, kDelimiters);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strspn)->AT_COMMON_SIZES;
+
+// The wide-character benchmarks take nbytes to be the size of the string in
+// bytes, so that their throughput compares with the byte versions'.
+static void BM_string_wcslen(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  int nchars = nbytes / sizeof(wchar_t);
+  wchar_t* s = new wchar_t[nchars];
+  wmemset(s, L'x', nchars);
+  s[nchars - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += wcslen(s);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_wcslen)->AT_COMMON_SIZES;
+
+static void BM_string_wcschr(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  int nchars = nbytes / sizeof(wchar_t);
+  wchar_t* s = new wchar_t[nchars];
+  wmemset(s, L'x', nchars);
+  s[nchars - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += (wcschr(s, L'y') != NULL);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_wcschr)->AT_COMMON_SIZES;
+
+static void BM_string_wcscmp(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  int nchars = nbytes / sizeof(wchar_t);
+  wchar_t* s1 = new wchar_t[nchars];
+  wchar_t* s2 = new wchar_t[nchars];
+  wmemset(s1, L'x', nchars);
+  wmemset(s2, L'x', nchars);
+  s1[nchars - 1] = 0;
+  s2[nchars - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += wcscmp(s1, s2);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s1;
+  delete[] s2;
+}
+BENCHMARK(BM_string_wcscmp)->AT_COMMON_SIZES;
+
+static void BM_string_wmemcpy(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  int nchars = nbytes / sizeof(wchar_t);
+  wchar_t* src = new wchar_t[nchars];
+  wchar_t* dst = new wchar_t[nchars];
+  wmemset(src, L'x', nchars);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    wmemcpy(dst, src, nchars);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_wmemcpy)->AT_COMMON_SIZES;
+
+// Misalignment sweeps: BM_string_memcpy_misaligned_1_0 copies from one byte
+// past a 64-byte boundary to a 64-byte boundary, and so on.
+#define AT_MISALIGNED_SIZES \
+    Arg(16)->Arg(64)->Arg(512)->Arg(4*KB)
+
+#define BENCHMARK_MISALIGNED(fn, align1, align2) \
+    static void BM_string_##fn##_misaligned_##align1##_##align2(int iters, int nbytes) { \
+      fn##_misaligned(iters, nbytes, align1, align2); \
+    } \
+    BENCHMARK(BM_string_##fn##_misaligned_##align1##_##align2)->AT_MISALIGNED_SIZES
+
+#define BENCHMARK_MISALIGNMENTS(fn) \
+    BENCHMARK_MISALIGNED(fn, 0, 0); \
+    BENCHMARK_MISALIGNED(fn, 1, 0); \
+    BENCHMARK_MISALIGNED(fn, 0, 1); \
+    BENCHMARK_MISALIGNED(fn, 4, 0); \
+    BENCHMARK_MISALIGNED(fn, 0, 4); \
+    BENCHMARK_MISALIGNED(fn, 3, 13)
+
+// Returns the address 'align' bytes past the first 64-byte boundary in 'buf',
+// which needs 128 bytes more than the caller wants to use.
+static char* Misalign(char* buf, int align) {
+  uintptr_t p = (reinterpret_cast<uintptr_t>(buf) + 63) & ~static_cast<uintptr_t>(63);
+  return reinterpret_cast<char*>(p + align);
+}
+
+static void memcpy_misaligned(int iters, int nbytes, int src_align, int dst_align) {
+  StopBenchmarkTiming();
+  char* src_buf = new char[nbytes + 128]; char* dst_buf = new char[nbytes + 128];
+  char* src = Misalign(src_buf, src_align);
+  char* dst = Misalign(dst_buf, dst_align);
+  memset(src, 'x', nbytes);
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    memcpy(dst, src, nbytes);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] src_buf;
+  delete[] dst_buf;
+}
+BENCHMARK_MISALIGNMENTS(memcpy);
+
+static void memcmp_misaligned(int iters, int nbytes, int lhs_align, int rhs_align) {
+  StopBenchmarkTiming();
+  char* lhs_buf = new char[nbytes + 128]; char* rhs_buf = new char[nbytes + 128];
+  char* lhs = Misalign(lhs_buf, lhs_align);
+  char* rhs = Misalign(rhs_buf, rhs_align);
+  memset(lhs, 'x', nbytes);
+  memset(rhs, 'x', nbytes);
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += memcmp(lhs, rhs, nbytes);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] lhs_buf;
+  delete[] rhs_buf;
+}
+BENCHMARK_MISALIGNMENTS(memcmp);
+
+static void strcmp_misaligned(int iters, int nbytes, int lhs_align, int rhs_align) {
+  StopBenchmarkTiming();
+  char* lhs_buf = new char[nbytes + 128]; char* rhs_buf = new char[nbytes + 128];
+  char* lhs = Misalign(lhs_buf, lhs_align);
+  char* rhs = Misalign(rhs_buf, rhs_align);
+  memset(lhs, 'x', nbytes);
+  memset(rhs, 'x', nbytes);
+  lhs[nbytes - 1] = 0;
+  rhs[nbytes - 1] = 0;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strcmp(lhs, rhs);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] lhs_buf;
+  delete[] rhs_buf;
+}
+BENCHMARK_MISALIGNMENTS(strcmp);
+
+// Random sizes up to the argument, through a fixed table so that every run
+// sees the same ones. Each power-of-two range is as likely as any other, so
+// most calls are short while most bytes are in long calls, and the branches
+// that pick a size class can't learn a single length.
+#define AT_MAX_SIZES \
+    Arg(16)->Arg(256)->Arg(4*KB)
+
+static const int kRandomSizeCount = 1024;
+
+static void RandomSizes(int max_size, int* sizes) {
+  int log2_max = 0;
+  while ((2 << log2_max) <= max_size) {
+    ++log2_max;
+  }
+  srandom(1);
+  for (int i = 0; i < kRandomSizeCount; ++i) {
+    int log2_size = random() % (log2_max + 1);
+    int size = (1 << log2_size) + random() % (1 << log2_size);
+    sizes[i] = (size < max_size) ? size : max_size;
+  }
+}
+
+static void BM_string_memcpy_random_sizes(int iters, int max_size) {
+  StopBenchmarkTiming();
+  int sizes[kRandomSizeCount];
+  RandomSizes(max_size, sizes);
+  char* src = new char[max_size]; char* dst = new char[max_size];
+  memset(src, 'x', max_size);
+  StartBenchmarkTiming();
+
+  int64_t bytes = 0;
+  for (int i = 0; i < iters; ++i) {
+    int size = sizes[i % kRandomSizeCount];
+    memcpy(dst, src, size);
+    bytes += size;
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(bytes);
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_memcpy_random_sizes)->AT_MAX_SIZES;
+
+static void BM_string_memcmp_random_sizes(int iters, int max_size) {
+  StopBenchmarkTiming();
+  int sizes[kRandomSizeCount];
+  RandomSizes(max_size, sizes);
+  char* lhs = new char[max_size]; char* rhs = new char[max_size];
+  memset(lhs, 'x', max_size);
+  memset(rhs, 'x', max_size);
+  StartBenchmarkTiming();
+
+  int64_t bytes = 0;
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    int size = sizes[i % kRandomSizeCount];
+    c += memcmp(lhs, rhs, size);
+    bytes += size;
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(bytes);
+  delete[] lhs;
+  delete[] rhs;
+}
+BENCHMARK(BM_string_memcmp_random_sizes)->AT_MAX_SIZES;
+
+// Cold-cache modes: each call works on a randomly chosen block of a buffer
+// much bigger than any cache here, so it starts with none of its data cached,
+// as calls on freshly read data do. Blocks are 64-byte aligned, or as aligned
+// as the size is for strlen, which needs a NUL at the end of each.
+static const size_t kColdBufferSize = 32*MB;
+
+static size_t NextColdBlock(uint32_t* state, size_t stride) {
+  *state = *state * 1664525 + 1013904223;
+  return ((*state >> 8) % (kColdBufferSize / stride)) * stride;
+}
+
+static void BM_string_memcpy_cold(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* src = new char[kColdBufferSize]; char* dst = new char[kColdBufferSize];
+  memset(src, 'x', kColdBufferSize);
+  memset(dst, 'x', kColdBufferSize);
+  size_t stride = (nbytes + 63) & ~63;
+  uint32_t state = 1;
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    size_t offset = NextColdBlock(&state, stride);
+    memcpy(dst + offset, src + offset, nbytes);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] src;
+  delete[] dst;
+}
+BENCHMARK(BM_string_memcpy_cold)->AT_COMMON_SIZES;
+
+static void BM_string_memcmp_cold(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* lhs = new char[kColdBufferSize]; char* rhs = new char[kColdBufferSize];
+  memset(lhs, 'x', kColdBufferSize);
+  memset(rhs, 'x', kColdBufferSize);
+  size_t stride = (nbytes + 63) & ~63;
+  uint32_t state = 1;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    size_t offset = NextColdBlock(&state, stride);
+    c += memcmp(lhs + offset, rhs + offset, nbytes);
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] lhs;
+  delete[] rhs;
+}
+BENCHMARK(BM_string_memcmp_cold)->AT_COMMON_SIZES;
+
+static void BM_string_strlen_cold(int iters, int nbytes) {
+  StopBenchmarkTiming();
+  char* s = new char[kColdBufferSize];
+  memset(s, 'x', kColdBufferSize);
+  for (size_t end = nbytes - 1; end < kColdBufferSize; end += nbytes) {
+    s[end] = 0;
+  }
+  uint32_t state = 1;
+  StartBenchmarkTiming();
+
+  volatile int c __attribute__((unused)) = 0;
+  for (int i = 0; i < iters; ++i) {
+    c += strlen(s + NextColdBlock(&state, nbytes));
+  }
+
+  StopBenchmarkTiming();
+  SetBenchmarkBytesProcessed(int64_t(iters) * int64_t(nbytes));
+  delete[] s;
+}
+BENCHMARK(BM_string_strlen_cold)->AT_COMMON_SIZES;
@@ -19,6 +19,10 @@
 #include <errno.h>
 #include <math.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <string>
 
 #define KB 1024
 #define SMALL 1*KB
@@ -707,6 +711,98 @@ TEST(string, memrchr) {
   }
 }
 
+TEST(string, memchr_memrchr_strchr_at_page_end) {
+  // Buffers that end right before an inaccessible page, and start right
+  // after one, mustn't be read past.
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  char* map = reinterpret_cast<char*>(mmap(NULL, 3 * page_size, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  ASSERT_NE(MAP_FAILED, map);
+  ASSERT_EQ(0, mprotect(map, page_size, PROT_NONE));
+  ASSERT_EQ(0, mprotect(map + 2 * page_size, page_size, PROT_NONE));
+  char* page = map + page_size;
+  memset(page, 'x', page_size);
+  page[page_size - 1] = '\0';
+
+  for (size_t len = 1; len < 64; ++len) {
+    char* s = page + page_size - len;
+    ASSERT_TRUE(memchr(s, 'y', len) == NULL);
+    ASSERT_TRUE(memchr(s, 'x', len) == (len > 1 ? s : NULL));
+    ASSERT_TRUE(memrchr(page, 'y', len) == NULL);
+    ASSERT_TRUE(memrchr(page, 'x', len) == page + len - 1);
+    ASSERT_TRUE(strchr(s, 'y') == NULL);
+    ASSERT_TRUE(strchr(s, '\0') == page + page_size - 1);
+  }
+  // A length that runs off the end of memory is fine as long as there's a
+  // match: memchr() is often used that way.
+  ASSERT_TRUE(memchr(page + 1, '\0', ~static_cast<size_t>(0)) == page + page_size - 1);
+
+  munmap(map, 3 * page_size);
+}
+
+TEST(string, memmem) {
+  const char* haystack = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab";
+  size_t n = strlen(haystack);
+  ASSERT_TRUE(memmem(haystack, n, "aaab", 4) == haystack + n - 4);
+  ASSERT_TRUE(memmem(haystack, n, "aaaa", 4) == haystack);
+  ASSERT_TRUE(memmem(haystack, n, "aaba", 4) == NULL);
+  ASSERT_TRUE(memmem(haystack, n, "b", 1) == haystack + n - 1);
+  ASSERT_TRUE(memmem(haystack, 3, "aaaa", 4) == NULL);
+  ASSERT_TRUE(memmem("abcabd", 6, "abd", 3) != NULL);
+}
+
+TEST(string, strstr) {
+  const char* haystack = "GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\n";
+  ASSERT_TRUE(strstr(haystack, "") == haystack);
+  ASSERT_TRUE(strstr(haystack, "G") == haystack);
+  ASSERT_TRUE(strstr(haystack, "\r\n\r\n") == haystack + strlen(haystack) - 4);
+  ASSERT_TRUE(strstr(haystack, "Host: example.net") == NULL);
+
+  // A match straddling two of the windows strstr() hands to memmem().
+  std::string long_haystack(10000, 'n');
+  long_haystack.insert(4093, "needle");
+  ASSERT_TRUE(strstr(long_haystack.c_str(), "needle") == long_haystack.c_str() + 4093);
+  ASSERT_TRUE(strstr(long_haystack.c_str(), "needles") == NULL);
+}
+
+TEST(string, strspn_strcspn_strpbrk) {
+  ASSERT_EQ(0U, strspn("abc", ""));
+  ASSERT_EQ(3U, strcspn("abc", ""));
+  ASSERT_TRUE(strpbrk("abc", "") == NULL);
+  ASSERT_EQ(3U, strspn("cabd", "abc"));
+  ASSERT_EQ(3U, strcspn("cabd", "d"));
+  ASSERT_EQ(4U, strspn("cabc", "abc"));
+  const char* s = "key=value;other";
+  ASSERT_TRUE(strpbrk(s, ";=") == s + 3);
+  ASSERT_TRUE(strpbrk(s, "#") == NULL);
+
+  // Every byte value, at every alignment and on either side of a 16-byte
+  // block, both in and out of the set.
+  char set[256];
+  for (int c = 1; c < 256; ++c) {
+    set[c - 1] = c;
+  }
+  set[255] = '\0';
+  char buf[64 + 40];
+  for (int c = 1; c < 256; ++c) {
+    char one[2] = { static_cast<char>(c), '\0' };
+    for (size_t align = 0; align < 16; ++align) {
+      for (size_t len = 0; len < 40; ++len) {
+        char* p = buf + align;
+        memset(p, c, len);
+        p[len] = static_cast<char>(c == 1 ? 2 : 1);
+        p[len + 1] = '\0';
+        ASSERT_EQ(len, strspn(p, one));
+        ASSERT_EQ(len + 1, strspn(p, set));
+        ASSERT_EQ(0U, strcspn(p, set));
+        // p + len is the string holding just the byte that ends the span.
+        ASSERT_EQ(len, strcspn(p, p + len));
+        ASSERT_TRUE(strpbrk(p, p + len) == p + len);
+      }
+    }
+  }
+}
+
 TEST(string, memcmp) {
   StringTestState<char> state(SMALL);
   for (size_t i = 0; i < state.n; i++) {
@@ -729,6 +825,30 @@ TEST(string, memcmp) {
   }
 }
 
+TEST(string, memcmp_every_length) {
+  // Every length either side of the block sizes, with the difference at
+  // every position, in both directions, and at a few relative alignments.
+  char lhs[96 + 16], rhs[96 + 16];
+  for (size_t lhs_align = 0; lhs_align < 16; lhs_align += 5) {
+    for (size_t rhs_align = 0; rhs_align < 16; rhs_align += 3) {
+      char* l = lhs + lhs_align;
+      char* r = rhs + rhs_align;
+      for (size_t len = 0; len <= 96; ++len) {
+        memset(l, 'a', len);
+        memset(r, 'a', len);
+        ASSERT_EQ(0, memcmp(l, r, len));
+        for (size_t pos = 0; pos < len; ++pos) {
+          r[pos] = '\xff';
+          ASSERT_LT(memcmp(l, r, len), 0);
+          ASSERT_GT(memcmp(r, l, len), 0);
+          ASSERT_EQ(0, memcmp(l, r, pos));
+          r[pos] = 'a';
+        }
+      }
+    }
+  }
+}
+
 #if defined(__BIONIC__)
 extern "C" int __memcmp16(const unsigned short *ptr1, const unsigned short *ptr2, size_t n);
 
@@ -105,4 +105,25 @@ TEST(getpwnam, app_id_u1_i0) {
   CHECK_GETPWNAM_FOR("u1_i0", 199000, TYPE_APP);
 }
 
+TEST(getpwnam, repeated_and_interleaved_lookups) {
+  // The last result is reused, so make sure alternating lookups still see the right entry.
+  for (size_t i = 0; i < 3; ++i) {
+    CHECK_GETPWNAM_FOR("root", 0, TYPE_SYSTEM);
+    CHECK_GETPWNAM_FOR("root", 0, TYPE_SYSTEM);
+    CHECK_GETPWNAM_FOR("u1_a0", 110000, TYPE_APP);
+    CHECK_GETPWNAM_FOR("system", 1000, TYPE_SYSTEM);
+  }
+
+  passwd* pwd = getpwnam("u0_a1234");
+  ASSERT_TRUE(pwd != NULL);
+  EXPECT_EQ(11234U, pwd->pw_uid);
+  pwd = getpwnam("u0_a1234");
+  ASSERT_TRUE(pwd != NULL);
+  EXPECT_EQ(11234U, pwd->pw_uid);
+  EXPECT_TRUE(getpwnam("no_such_user") == NULL);
+  pwd = getpwnam("system");
+  ASSERT_TRUE(pwd != NULL);
+  EXPECT_EQ(1000U, pwd->pw_uid);
+}
+
 #endif /* __BIONIC__ */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/aio_abi.h>
+#include <unistd.h>
+
+TEST(sys_aio_abi, io_submit_io_getevents) {
+  aio_context_t ctx = 0;
+  ASSERT_EQ(0, io_setup(8, &ctx));
+
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  int fd = fileno(fp);
+  ASSERT_EQ(10, pwrite(fd, "0123456789", 10, 0));
+
+  // Two reads in flight from one thread, one submit and one wait.
+  char buf[2][4];
+  iocb cbs[2];
+  iocb* cb_ptrs[2] = { &cbs[0], &cbs[1] };
+  for (size_t i = 0; i < 2; ++i) {
+    memset(&cbs[i], 0, sizeof(cbs[i]));
+    cbs[i].aio_data = i;
+    cbs[i].aio_lio_opcode = IOCB_CMD_PREAD;
+    cbs[i].aio_fildes = fd;
+    cbs[i].aio_buf = reinterpret_cast<uintptr_t>(buf[i]);
+    cbs[i].aio_nbytes = sizeof(buf[i]);
+    cbs[i].aio_offset = i * 6;
+  }
+  ASSERT_EQ(2, io_submit(ctx, 2, cb_ptrs));
+
+  io_event events[2];
+  ASSERT_EQ(2, io_getevents(ctx, 2, 2, events, NULL));
+  for (size_t i = 0; i < 2; ++i) {
+    ASSERT_EQ(4, events[i].res);
+  }
+  ASSERT_EQ(0, memcmp("0123", buf[0], 4));
+  ASSERT_EQ(0, memcmp("6789", buf[1], 4));
+
+  // Nothing outstanding, so a zero timeout returns straight away.
+  timespec ts = { 0, 0 };
+  ASSERT_EQ(0, io_getevents(ctx, 1, 2, events, &ts));
+
+  fclose(fp);
+  ASSERT_EQ(0, io_destroy(ctx));
+  ASSERT_EQ(-1, io_destroy(ctx));
+  ASSERT_EQ(EINVAL, errno);
+}
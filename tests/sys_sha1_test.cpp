@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#if defined(__BIONIC__)
+#include <sys/sha1.h>
+#endif
+
+TEST(sys_sha1, SHA1Update4) {
+#if defined(__BIONIC__)
+  // Lane 0 gets the FIPS 180-1 million 'a's; every lane is also checked
+  // against SHA1Update. 1000 isn't a multiple of 64, so most calls start
+  // and end part way through a block.
+  u_char chunk[4][1000];
+  for (int i = 0; i < 4; ++i) {
+    memset(chunk[i], 'a' + i, sizeof(chunk[i]));
+  }
+
+  SHA1_CTX multi[4];
+  SHA1_CTX single[4];
+  SHA1_CTX* ctx[4];
+  const u_char* data[4];
+  for (int i = 0; i < 4; ++i) {
+    SHA1Init(&multi[i]);
+    SHA1Init(&single[i]);
+    ctx[i] = &multi[i];
+    data[i] = chunk[i];
+  }
+  for (int n = 0; n < 1000; ++n) {
+    SHA1Update4(ctx, data, 1000);
+    for (int i = 0; i < 4; ++i) {
+      SHA1Update(&single[i], chunk[i], 1000);
+    }
+  }
+
+  static const u_char kMillionAs[SHA1_DIGEST_LENGTH] = {
+    0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+    0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f,
+  };
+  u_char expected[SHA1_DIGEST_LENGTH];
+  u_char actual[SHA1_DIGEST_LENGTH];
+  for (int i = 0; i < 4; ++i) {
+    SHA1Final(expected, &single[i]);
+    SHA1Final(actual, &multi[i]);
+    ASSERT_EQ(0, memcmp(expected, actual, sizeof(actual))) << i;
+    if (i == 0) {
+      ASSERT_EQ(0, memcmp(kMillionAs, actual, sizeof(actual)));
+    }
+  }
+#else
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif
+}
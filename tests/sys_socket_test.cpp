@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+TEST(sys_socket, sendmmsg_recvmmsg) {
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+
+  const char* messages[] = { "one", "two", "three" };
+  mmsghdr out[3];
+  iovec out_iov[3];
+  memset(out, 0, sizeof(out));
+  for (size_t i = 0; i < 3; ++i) {
+    out_iov[i].iov_base = const_cast<char*>(messages[i]);
+    out_iov[i].iov_len = strlen(messages[i]);
+    out[i].msg_hdr.msg_iov = &out_iov[i];
+    out[i].msg_hdr.msg_iovlen = 1;
+  }
+  ASSERT_EQ(3, sendmmsg(fds[0], out, 3, 0));
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(strlen(messages[i]), out[i].msg_len);
+  }
+
+  // Only what's there already is returned, one datagram per mmsghdr.
+  char buf[4][16];
+  mmsghdr in[4];
+  iovec in_iov[4];
+  memset(in, 0, sizeof(in));
+  for (size_t i = 0; i < 4; ++i) {
+    in_iov[i].iov_base = buf[i];
+    in_iov[i].iov_len = sizeof(buf[i]);
+    in[i].msg_hdr.msg_iov = &in_iov[i];
+    in[i].msg_hdr.msg_iovlen = 1;
+  }
+  ASSERT_EQ(3, recvmmsg(fds[1], in, 4, MSG_DONTWAIT, NULL));
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(strlen(messages[i]), in[i].msg_len);
+    ASSERT_EQ(0, memcmp(messages[i], buf[i], in[i].msg_len));
+  }
+
+  ASSERT_EQ(-1, recvmmsg(fds[1], in, 4, MSG_DONTWAIT, NULL));
+  ASSERT_EQ(EAGAIN, errno);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(sys_socket, accept4) {
+  int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_NE(-1, listener);
+  ASSERT_EQ(FD_CLOEXEC, fcntl(listener, F_GETFD));
+
+  // An abstract name, so there's nothing to clean up.
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "bionic_accept4_%d", getpid());
+  socklen_t addr_len = offsetof(sockaddr_un, sun_path) + 1 + strlen(addr.sun_path + 1);
+  ASSERT_EQ(0, bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len));
+  ASSERT_EQ(0, listen(listener, 1));
+
+  int client = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_NE(-1, client);
+  ASSERT_EQ(0, connect(client, reinterpret_cast<sockaddr*>(&addr), addr_len));
+
+  int fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  ASSERT_NE(-1, fd);
+  ASSERT_EQ(FD_CLOEXEC, fcntl(fd, F_GETFD));
+  ASSERT_EQ(O_NONBLOCK, fcntl(fd, F_GETFL) & O_NONBLOCK);
+
+  ASSERT_EQ(-1, accept4(listener, NULL, NULL, -1));
+  ASSERT_EQ(EINVAL, errno);
+
+  close(fd);
+  close(client);
+  close(listener);
+}
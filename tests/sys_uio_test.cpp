@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static char gRemoteData[8192];
+
+TEST(sys_uio, process_vm_readv_writev) {
+  for (size_t i = 0; i < sizeof(gRemoteData); ++i) {
+    gRemoteData[i] = static_cast<char>(i * 7);
+  }
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    while (true) {
+      pause();
+    }
+  }
+
+  char buf[sizeof(gRemoteData)];
+  iovec local = { buf, sizeof(buf) };
+  iovec remote = { gRemoteData, sizeof(gRemoteData) };
+  ssize_t n = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+  if (n == -1 && errno == ENOSYS) {
+    GTEST_LOG_(INFO) << "This kernel has no process_vm_readv.\n";
+  } else {
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(buf)), n) << strerror(errno);
+    ASSERT_EQ(0, memcmp(buf, gRemoteData, sizeof(buf)));
+
+    // Write into the child and read it back; our own copy is untouched.
+    memset(buf, 'x', 100);
+    local.iov_len = remote.iov_len = 100;
+    ASSERT_EQ(100, process_vm_writev(pid, &local, 1, &remote, 1, 0));
+    memset(buf, 0, 100);
+    ASSERT_EQ(100, process_vm_readv(pid, &local, 1, &remote, 1, 0));
+    ASSERT_EQ('x', buf[99]);
+    ASSERT_NE('x', gRemoteData[99]);
+  }
+
+  kill(pid, SIGKILL);
+  ASSERT_EQ(pid, waitpid(pid, NULL, 0));
+}
+
+TEST(sys_uio, preadv_pwritev) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  int fd = fileno(fp);
+
+  char hello[] = "hello";
+  char world[] = "world";
+  iovec out[] = { { hello, 5 }, { world, 5 } };
+  ASSERT_EQ(10, pwritev(fd, out, 2, 100));
+  ASSERT_EQ(0, lseek(fd, 0, SEEK_CUR));  // The file offset isn't used or moved.
+
+  char buf1[4];
+  char buf2[6];
+  iovec in[] = { { buf1, sizeof(buf1) }, { buf2, sizeof(buf2) } };
+  ASSERT_EQ(10, preadv(fd, in, 2, 100));
+  ASSERT_EQ(0, memcmp(buf1, "hell", 4));
+  ASSERT_EQ(0, memcmp(buf2, "oworld", 6));
+
+  // Past 4GiB, the high word of the offset has to make it to the kernel.
+  off64_t big = (1LL << 32) + 123;
+  if (pwritev64(fd, out, 2, big) == -1 && errno == EFBIG) {
+    GTEST_LOG_(INFO) << "This file system can't hold a file that big.\n";
+  } else {
+    char buf[10];
+    ASSERT_EQ(10, pread64(fd, buf, sizeof(buf), big));
+    ASSERT_EQ(0, memcmp(buf, "helloworld", 10));
+    ASSERT_EQ(10, preadv64(fd, in, 2, big));
+    ASSERT_EQ(0, memcmp(buf2, "oworld", 6));
+    ASSERT_EQ(0, preadv64(fd, in, 2, big + 10));
+  }
+  fclose(fp);
+}
@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <algorithm>
 #include <string>
 
 #if __BIONIC__
@@ -158,6 +159,35 @@ TEST(properties, fill) {
     }
 }
 
+TEST(properties, fill_short_names) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    char prop_name[PROP_NAME_MAX];
+    char prop_value[PROP_VALUE_MAX];
+    int count = 0;
+
+    // Enough small properties to outgrow the lookup index, so that the
+    // later ones can only be found through the trie.
+    while (true) {
+        int namelen = snprintf(prop_name, sizeof(prop_name), "p%d", count);
+        int valuelen = snprintf(prop_value, sizeof(prop_value), "%d", count);
+        if (__system_property_add(prop_name, namelen, prop_value, valuelen) < 0)
+            break;
+        count++;
+    }
+    ASSERT_GE(count, 247);
+
+    for (int i = 0; i < count; i++) {
+        snprintf(prop_name, sizeof(prop_name), "p%d", i);
+        snprintf(prop_value, sizeof(prop_value), "%d", i);
+        char prop_value_ret[PROP_VALUE_MAX];
+        ASSERT_EQ((int) strlen(prop_value), __system_property_get(prop_name, prop_value_ret));
+        ASSERT_STREQ(prop_value, prop_value_ret);
+    }
+    ASSERT_EQ((const prop_info *)NULL, __system_property_find("p"));
+    ASSERT_EQ((const prop_info *)NULL, __system_property_find("p0.x"));
+}
+
 static void foreach_test_callback(const prop_info *pi, void* cookie) {
     size_t *count = static_cast<size_t *>(cookie);
 
@@ -178,6 +208,50 @@ TEST(properties, foreach) {
     ASSERT_EQ(3U, count);
 }
 
+static void foreach_view_test_callback(const prop_view_t *view, void* cookie) {
+    std::string *dump = static_cast<std::string *>(cookie);
+
+    dump->append(view->name, view->name_len);
+    dump->append("=");
+    dump->append(view->value, view->value_len);
+    dump->append(";");
+    ASSERT_TRUE(__system_property_view_valid(view));
+}
+
+TEST(properties, foreach_view) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    std::string dump;
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("a.property", 10, "value22", 7));
+    ASSERT_EQ(0, __system_property_add("empty", 5, "", 0));
+
+    ASSERT_EQ(0, __system_property_foreach_view(foreach_view_test_callback, &dump));
+    ASSERT_EQ(3U, std::count(dump.begin(), dump.end(), ';'));
+    ASSERT_NE(std::string::npos, dump.find("property=value1;"));
+    ASSERT_NE(std::string::npos, dump.find("a.property=value22;"));
+    ASSERT_NE(std::string::npos, dump.find("empty=;"));
+}
+
+static void foreach_view_stale_callback(const prop_view_t *view, void* cookie) {
+    *static_cast<prop_view_t *>(cookie) = *view;
+}
+
+TEST(properties, foreach_view_stale) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    prop_view_t view;
+
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(0, __system_property_foreach_view(foreach_view_stale_callback, &view));
+    ASSERT_TRUE(__system_property_view_valid(&view));
+
+    prop_info *pi = (prop_info *)__system_property_find("property");
+    ASSERT_EQ(0, __system_property_update(pi, "value2", 6));
+    ASSERT_FALSE(__system_property_view_valid(&view));
+}
+
 TEST(properties, find_nth) {
     LocalPropertyTestState pa;
     ASSERT_TRUE(pa.valid);
@@ -293,6 +367,65 @@ TEST(properties, errors) {
     ASSERT_EQ(-1, __system_property_update(NULL, "value", PROP_VALUE_MAX));
 }
 
+TEST(properties, long_value) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    std::string long_value(1000, 'x');
+    std::string longer_value(3000, 'y');
+    char propvalue[PROP_VALUE_MAX];
+    char buf[PROP_LONG_VALUE_MAX + 1];
+
+    ASSERT_EQ(0, __system_property_add_long("long", 4, long_value.c_str(), long_value.size()));
+    ASSERT_EQ(1000, __system_property_get_long("long", buf, sizeof(buf)));
+    ASSERT_EQ(long_value, buf);
+    // Readers that only know about short values see an empty property.
+    ASSERT_EQ(0, __system_property_get("long", propvalue));
+    ASSERT_STREQ("", propvalue);
+
+    // A short buffer gets a truncated copy, but the full length.
+    ASSERT_EQ(1000, __system_property_get_long("long", buf, 11));
+    ASSERT_STREQ("xxxxxxxxxx", buf);
+
+    prop_info *pi = (prop_info *)__system_property_find("long");
+    ASSERT_NE((prop_info *)NULL, pi);
+    ASSERT_EQ(0, __system_property_update_long(pi, longer_value.c_str(), longer_value.size()));
+    ASSERT_EQ(3000, __system_property_read_long(pi, buf, sizeof(buf)));
+    ASSERT_EQ(longer_value, buf);
+    ASSERT_EQ(0, __system_property_update_long(pi, long_value.c_str(), long_value.size()));
+    ASSERT_EQ(1000, __system_property_read_long(pi, buf, sizeof(buf)));
+    ASSERT_EQ(long_value, buf);
+
+    // Going back to a short value stores it inline again.
+    ASSERT_EQ(0, __system_property_update_long(pi, "", 0));
+    ASSERT_EQ(0, __system_property_read_long(pi, buf, sizeof(buf)));
+    ASSERT_STREQ("", buf);
+    ASSERT_EQ(0, __system_property_update_long(pi, "short", 5));
+    ASSERT_EQ(5, __system_property_get("long", propvalue));
+    ASSERT_STREQ("short", propvalue);
+    ASSERT_EQ(5, __system_property_get_long("long", buf, sizeof(buf)));
+    ASSERT_STREQ("short", buf);
+
+    std::string too_long(PROP_LONG_VALUE_MAX + 1, 'z');
+    ASSERT_EQ(-1, __system_property_update_long(pi, too_long.c_str(), too_long.size()));
+    ASSERT_EQ(0, __system_property_get_long("missing", buf, sizeof(buf)));
+    ASSERT_STREQ("", buf);
+}
+
+TEST(properties, set_batch_errors) {
+    char long_name[PROP_NAME_MAX + 1];
+    memset(long_name, 'a', PROP_NAME_MAX);
+    long_name[PROP_NAME_MAX] = 0;
+
+    const char* keys[] = { "test.batch.ok", long_name };
+    const char* values[] = { "1", "2" };
+    ASSERT_EQ(-1, __system_property_set_batch(keys, values, 2));
+
+    const char* null_keys[] = { NULL };
+    ASSERT_EQ(-1, __system_property_set_batch(null_keys, values, 1));
+
+    ASSERT_EQ(0, __system_property_set_batch(NULL, NULL, 0));
+}
+
 TEST(properties, serial) {
     LocalPropertyTestState pa;
     ASSERT_TRUE(pa.valid);
@@ -306,6 +439,36 @@ TEST(properties, serial) {
     ASSERT_NE(serial, __system_property_serial(pi));
 }
 
+TEST(properties, cached_read) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    prop_cache_t cache = PROP_CACHE_INITIALIZER("property");
+    prop_cache_t other;
+    __system_property_cache_init(&other, "other_property");
+
+    // Properties that don't exist yet read as empty, and are found once added.
+    ASSERT_EQ(0, __system_property_cached_read(&cache));
+    ASSERT_STREQ("", cache.value);
+    ASSERT_EQ(0, __system_property_add("property", 8, "value1", 6));
+    ASSERT_EQ(6, __system_property_cached_read(&cache));
+    ASSERT_STREQ("value1", cache.value);
+
+    // Changing another property doesn't disturb the cached value.
+    ASSERT_EQ(0, __system_property_add("other_property", 14, "value2", 6));
+    ASSERT_EQ(6, __system_property_cached_read(&other));
+    ASSERT_STREQ("value2", other.value);
+    ASSERT_EQ(6, __system_property_cached_read(&cache));
+    ASSERT_STREQ("value1", cache.value);
+
+    prop_info *pi = (prop_info *)__system_property_find("property");
+    ASSERT_NE((prop_info *)NULL, pi);
+    ASSERT_EQ(0, __system_property_update(pi, "newvalue3", 9));
+    ASSERT_EQ(9, __system_property_cached_read(&cache));
+    ASSERT_STREQ("newvalue3", cache.value);
+    ASSERT_EQ(6, __system_property_cached_read(&other));
+    ASSERT_STREQ("value2", other.value);
+}
+
 static void *PropertyWaitHelperFn(void *arg)
 {
     int *flag = (int *)arg;
@@ -343,6 +506,43 @@ TEST(properties, wait) {
     ASSERT_EQ(0, pthread_join(t, &result));
 }
 
+static void *PropertyWaitPrefixHelperFn(void *arg)
+{
+    int *flag = (int *)arg;
+    prop_info *other = (prop_info *)__system_property_find("other.property");
+    prop_info *watched = (prop_info *)__system_property_find("watched.sub.property");
+    usleep(100000);
+
+    // Neither of these is under "watched.sub".
+    __system_property_update(other, "value2", 6);
+    __system_property_add("watched.subtle", 14, "value", 5);
+    usleep(100000);
+
+    *flag = 1;
+    __system_property_update(watched, "value2", 6);
+
+    return NULL;
+}
+
+TEST(properties, wait_prefix) {
+    LocalPropertyTestState pa;
+    ASSERT_TRUE(pa.valid);
+    pthread_t t;
+    int flag = 0;
+
+    ASSERT_EQ(0, __system_property_add("other.property", 14, "value1", 6));
+    ASSERT_EQ(0, __system_property_add("watched.sub.property", 20, "value1", 6));
+    unsigned int serial = __system_property_wait_prefix("watched.sub", 0);
+
+    ASSERT_EQ(0, pthread_create(&t, NULL, PropertyWaitPrefixHelperFn, &flag));
+    ASSERT_EQ(flag, 0);
+    serial = __system_property_wait_prefix("watched.sub.", serial);
+    ASSERT_EQ(flag, 1);
+
+    void* result;
+    ASSERT_EQ(0, pthread_join(t, &result));
+}
+
 class KilledByFault {
     public:
         explicit KilledByFault() {};
@@ -16,6 +16,8 @@
 
 #include "benchmark.h"
 
+#include <pthread.h>
+#include <sys/time.h>
 #include <time.h>
 
 #if defined(__BIONIC__)
@@ -36,3 +38,115 @@ static void BM_time_localtime_tz(int iters) {
 }
 BENCHMARK(BM_time_localtime_tz);
 #endif
+
+static void* LocaltimeThread(void* p) {
+  int iters = *reinterpret_cast<int*>(p);
+  time_t now(time(NULL));
+  tm broken_down_time;
+  for (int i = 0; i < iters; ++i) {
+    localtime_r(&now, &broken_down_time);
+  }
+  return NULL;
+}
+
+// Each iteration is one localtime_r on every thread, as from a logger timestamping each line.
+static void BM_time_localtime_r(int iters, int nthreads) {
+  StopBenchmarkTiming();
+  tzset();
+  pthread_t* threads = new pthread_t[nthreads - 1];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < nthreads - 1; ++i) {
+    pthread_create(&threads[i], NULL, LocaltimeThread, &iters);
+  }
+  LocaltimeThread(&iters);
+  for (int i = 0; i < nthreads - 1; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  StopBenchmarkTiming();
+  delete[] threads;
+}
+BENCHMARK(BM_time_localtime_r)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+static void StrftimeBenchmark(int iters, const char* format) {
+  StopBenchmarkTiming();
+  time_t now(1380000000);
+  tm broken_down_time;
+  localtime_r(&now, &broken_down_time);
+  char buf[128];
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    strftime(buf, sizeof(buf), format, &broken_down_time);
+  }
+
+  StopBenchmarkTiming();
+}
+
+// ISO 8601 and RFC 1123, as from loggers and servers, are among the formats strftime has compiled in.
+static void BM_time_strftime_iso8601(int iters) {
+  StrftimeBenchmark(iters, "%Y-%m-%dT%H:%M:%S");
+}
+BENCHMARK(BM_time_strftime_iso8601);
+
+static void BM_time_strftime_rfc1123(int iters) {
+  StrftimeBenchmark(iters, "%a, %d %b %Y %H:%M:%S GMT");
+}
+BENCHMARK(BM_time_strftime_rfc1123);
+
+// The common log format isn't, so this is interpreted each time.
+static void BM_time_strftime_clf(int iters) {
+  StrftimeBenchmark(iters, "%d/%b/%Y:%H:%M:%S %z");
+}
+BENCHMARK(BM_time_strftime_clf);
+
+#if defined(__BIONIC__)
+struct strftime_format;
+struct strftime_locale;
+extern "C" struct strftime_format* strftime_compile(const char* format);
+extern "C" size_t strftime_compiled(char* s, size_t max, const struct strftime_format* format, const struct tm* tm, const struct strftime_locale* lc);
+extern "C" void strftime_compiled_free(struct strftime_format* format);
+
+static void BM_time_strftime_compiled_clf(int iters) {
+  StopBenchmarkTiming();
+  time_t now(1380000000);
+  tm broken_down_time;
+  localtime_r(&now, &broken_down_time);
+  char buf[128];
+  strftime_format* format = strftime_compile("%d/%b/%Y:%H:%M:%S %z");
+  StartBenchmarkTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    strftime_compiled(buf, sizeof(buf), format, &broken_down_time, NULL);
+  }
+
+  StopBenchmarkTiming();
+  strftime_compiled_free(format);
+}
+BENCHMARK(BM_time_strftime_compiled_clf);
+#endif
+
+static void BM_time_clock_gettime(int iters) {
+  StartBenchmarkTiming();
+
+  timespec t;
+  for (int i = 0; i < iters; ++i) {
+    clock_gettime(CLOCK_MONOTONIC, &t);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_clock_gettime);
+
+static void BM_time_gettimeofday(int iters) {
+  StartBenchmarkTiming();
+
+  timeval tv;
+  for (int i = 0; i < iters; ++i) {
+    gettimeofday(&tv, NULL);
+  }
+
+  StopBenchmarkTiming();
+}
+BENCHMARK(BM_time_gettimeofday);
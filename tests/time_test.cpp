@@ -18,7 +18,14 @@
 #include <features.h>
 #include <gtest/gtest.h>
 
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
 
 #ifdef __BIONIC__ // mktime_tz is a bionic extension.
 #include <libc/private/bionic_time.h>
@@ -40,6 +47,61 @@ TEST(time, mktime_tz) {
 
   // Missing. Falls back to UTC.
   ASSERT_EQ(2678400, mktime_tz(&epoch, "PST"));
+
+  // A prefix or an extension of an id isn't that id.
+  ASSERT_EQ(2678400, mktime_tz(&epoch, "America/Los"));
+  ASSERT_EQ(2678400, mktime_tz(&epoch, "America/Los_AngelesX"));
+}
+
+TEST(time, localtime_tz_many_zones) {
+  // More zones than are kept cached, twice over, so some are evicted and reloaded.
+  static const struct { const char* id; long gmtoff; } kZones[] = {
+    { "Africa/Abidjan", 0 }, { "America/Los_Angeles", -28800 }, { "Asia/Tokyo", 32400 },
+    { "Asia/Kolkata", 19800 }, { "America/New_York", -18000 }, { "Europe/Paris", 3600 },
+    { "Africa/Cairo", 7200 }, { "Asia/Shanghai", 28800 }, { "Pacific/Honolulu", -36000 },
+    { "America/Sao_Paulo", -10800 },
+  };
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < sizeof(kZones) / sizeof(kZones[0]); ++i) {
+      time_t t = 0;
+      struct tm tm;
+      localtime_tz(&t, &tm, kZones[i].id);
+      ASSERT_EQ(kZones[i].gmtoff, tm.tm_gmtoff) << kZones[i].id;
+      ASSERT_EQ(t, mktime_tz(&tm, kZones[i].id)) << kZones[i].id;
+    }
+  }
+}
+
+TEST(time, strftime_compiled) {
+  // The formats strftime has compiled in already, and ones with the conversions compiled formats leave to strftime.
+  static const char* kFormats[] = {
+    "%Y-%m-%dT%H:%M:%S", "%FT%T", "%a, %d %b %Y %H:%M:%S GMT", "%A %B %e %j %h", "%_d %-m %^a %#b",
+    "%c %x %X %D %R %T %r", "%C%y %G %g %V %U %W %u %w", "%I %l %k %p %P", "%s %z %n%t%% %q %", "",
+  };
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_year = 2013 - 1900;
+  tm.tm_mon = 8;
+  tm.tm_mday = 4;
+  tm.tm_hour = 5;
+  tm.tm_min = 6;
+  tm.tm_sec = 7;
+  tm.tm_wday = 3;
+  tm.tm_yday = 246;
+  for (size_t i = 0; i < sizeof(kFormats) / sizeof(kFormats[0]); ++i) {
+    char expected[128];
+    size_t length = strftime(expected, sizeof(expected), kFormats[i], &tm);
+    struct strftime_format* format = strftime_compile(kFormats[i]);
+    ASSERT_TRUE(format != NULL);
+    char actual[128];
+    ASSERT_EQ(length, strftime_compiled(actual, sizeof(actual), format, &tm, NULL)) << kFormats[i];
+    ASSERT_STREQ(expected, actual) << kFormats[i];
+    // Too small a buffer gets nothing, as with strftime.
+    if (length > 0) {
+      ASSERT_EQ(0U, strftime_compiled(actual, length, format, &tm, NULL)) << kFormats[i];
+    }
+    strftime_compiled_free(format);
+  }
 }
 #endif
 
@@ -66,4 +128,122 @@ TEST(time, mktime_10310929) {
   ASSERT_EQ(-1, mktime(&t));
   ASSERT_EQ(-1, mktime_tz(&t, "UTC"));
 }
+
+static time_t MktimeLosAngeles(int year, int mon, int mday, int hour, int min, int isdst) {
+  struct tm t;
+  memset(&t, 0, sizeof(tm));
+  t.tm_year = year - 1900;
+  t.tm_mon = mon;
+  t.tm_mday = mday;
+  t.tm_hour = hour;
+  t.tm_min = min;
+  t.tm_isdst = isdst;
+  return mktime_tz(&t, "America/Los_Angeles");
+}
+
+TEST(time, mktime_tz_transitions) {
+  // An ordinary time, in the summer.
+  ASSERT_EQ(1372705200, MktimeLosAngeles(2013, 6, 1, 12, 0, -1));
+  // In the hour skipped in the spring.
+  ASSERT_EQ(-1, MktimeLosAngeles(2013, 2, 10, 2, 30, -1));
+  // The hour repeated in the fall happens once in daylight time and once in standard.
+  ASSERT_EQ(1383467400, MktimeLosAngeles(2013, 10, 3, 1, 30, 1));
+  ASSERT_EQ(1383471000, MktimeLosAngeles(2013, 10, 3, 1, 30, 0));
+  // Daylight time in the winter is an hour before standard time.
+  ASSERT_EQ(1357023600, MktimeLosAngeles(2013, 0, 1, 0, 0, 1));
+}
+
+// glibc's localtime_r only looks at TZ the first time; bionic's sees each change.
+TEST(time, localtime_r_TZ_changes) {
+  const char* old_tz = getenv("TZ");
+  char* saved_tz = (old_tz != NULL) ? strdup(old_tz) : NULL;
+
+  static const struct { const char* tz; int hour; } kZones[] = {
+    { "America/Los_Angeles", 16 }, { "Asia/Tokyo", 9 }, { "UTC", 0 }, { "Asia/Tokyo", 9 },
+  };
+  for (size_t i = 0; i < sizeof(kZones) / sizeof(kZones[0]); ++i) {
+    ASSERT_EQ(0, setenv("TZ", kZones[i].tz, 1));
+    // Enough calls that any cached answer would be used.
+    for (int j = 0; j < 3; ++j) {
+      time_t t = 0;
+      struct tm broken_down;
+      ASSERT_TRUE(localtime_r(&t, &broken_down) != NULL);
+      ASSERT_EQ(kZones[i].hour, broken_down.tm_hour) << kZones[i].tz;
+      ASSERT_EQ(0, mktime(&broken_down)) << kZones[i].tz;
+    }
+  }
+
+  if (saved_tz != NULL) {
+    setenv("TZ", saved_tz, 1);
+    free(saved_tz);
+  } else {
+    unsetenv("TZ");
+  }
+}
 #endif
+
+static void CountNotification(sigval_t value) {
+  __sync_fetch_and_add(reinterpret_cast<int*>(value.sival_ptr), 1);
+}
+
+TEST(time, timer_create_SIGEV_THREAD_many) {
+  // Far more SIGEV_THREAD timers than we'd want threads.
+  const size_t kTimerCount = 64;
+  timer_t timers[kTimerCount];
+  int counts[kTimerCount];
+
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    counts[i] = 0;
+    sigevent se;
+    memset(&se, 0, sizeof(se));
+    se.sigev_notify = SIGEV_THREAD;
+    se.sigev_notify_function = CountNotification;
+    se.sigev_value.sival_ptr = &counts[i];
+    ASSERT_EQ(0, timer_create(CLOCK_MONOTONIC, &se, &timers[i]));
+
+    itimerspec ts;
+    ts.it_value.tv_sec = 0;
+    ts.it_value.tv_nsec = 1000000 + i * 10000;
+    ts.it_interval.tv_sec = 0;
+    ts.it_interval.tv_nsec = 5000000;
+    ASSERT_EQ(0, timer_settime(timers[i], 0, &ts, NULL));
+  }
+
+  usleep(200000);
+
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    ASSERT_EQ(0, timer_delete(timers[i]));
+  }
+  for (size_t i = 0; i < kTimerCount; ++i) {
+    ASSERT_GT(counts[i], 1) << "timer " << i;
+  }
+}
+
+TEST(time, clock_gettime) {
+  // clock_gettime may go through the vDSO; check it agrees with the kernel.
+  timespec ts0;
+  timespec ts1;
+  timespec ts2;
+  ASSERT_EQ(0, syscall(__NR_clock_gettime, CLOCK_MONOTONIC, &ts0));
+  ASSERT_EQ(0, clock_gettime(CLOCK_MONOTONIC, &ts1));
+  ASSERT_EQ(0, syscall(__NR_clock_gettime, CLOCK_MONOTONIC, &ts2));
+  int64_t ns0 = ts0.tv_sec * 1000000000LL + ts0.tv_nsec;
+  int64_t ns1 = ts1.tv_sec * 1000000000LL + ts1.tv_nsec;
+  int64_t ns2 = ts2.tv_sec * 1000000000LL + ts2.tv_nsec;
+  ASSERT_LE(ns0, ns1);
+  ASSERT_LE(ns1, ns2);
+
+  // Errors come back through errno, whichever path reported them.
+  errno = 0;
+  ASSERT_EQ(-1, clock_gettime(-1, &ts1));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(time, gettimeofday) {
+  timeval tv0;
+  timeval tv1;
+  ASSERT_EQ(0, syscall(__NR_gettimeofday, &tv0, NULL));
+  ASSERT_EQ(0, gettimeofday(&tv1, NULL));
+  // The realtime clock can be set, but not so often that this should fail.
+  ASSERT_LT(llabs((tv1.tv_sec - tv0.tv_sec) * 1000000LL + (tv1.tv_usec - tv0.tv_usec)), 1000000);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/trace_events.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+static std::vector<android_trace_event> ReadEvents() {
+  std::vector<android_trace_event> events;
+  android_trace_event buffer[16];
+  size_t n;
+  while ((n = android_trace_read(buffer, 16)) > 0) {
+    events.insert(events.end(), buffer, buffer + n);
+  }
+  return events;
+}
+
+static bool HasEvent(const std::vector<android_trace_event>& events, uint32_t type,
+                     pid_t tid, uint64_t arg) {
+  for (size_t i = 0; i < events.size(); ++i) {
+    if (events[i].type == type && events[i].tid == tid && events[i].arg == arg) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static pid_t gChildTid;
+
+static void* ChildFn(void*) {
+  gChildTid = gettid();
+  return reinterpret_cast<void*>(123);
+}
+
+struct MutexHolder {
+  pthread_mutex_t mutex;
+  volatile bool waiting;
+};
+
+static void* WaitForMutexFn(void* arg) {
+  MutexHolder* holder = reinterpret_cast<MutexHolder*>(arg);
+  holder->waiting = true;
+  pthread_mutex_lock(&holder->mutex);
+  pthread_mutex_unlock(&holder->mutex);
+  return NULL;
+}
+
+TEST(trace_events, start_invalid) {
+  errno = 0;
+  ASSERT_EQ(-1, android_trace_start(0));
+  ASSERT_EQ(EINVAL, errno);
+}
+
+TEST(trace_events, threads) {
+  ReadEvents();
+  ASSERT_EQ(0, android_trace_start(256));
+
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, ChildFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  android_trace_stop();
+  std::vector<android_trace_event> events = ReadEvents();
+  ASSERT_TRUE(HasEvent(events, ANDROID_TRACE_THREAD_CREATE, gettid(), gChildTid));
+  ASSERT_TRUE(HasEvent(events, ANDROID_TRACE_THREAD_EXIT, gChildTid, 123));
+
+  // Nothing's recorded once tracing is stopped.
+  ASSERT_EQ(0, pthread_create(&t, NULL, ChildFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  ASSERT_EQ(0U, ReadEvents().size());
+}
+
+TEST(trace_events, mutex_wait) {
+  ReadEvents();
+  ASSERT_EQ(0, android_trace_start(256));
+
+  MutexHolder holder;
+  pthread_mutex_init(&holder.mutex, NULL);
+  holder.waiting = false;
+  pthread_mutex_lock(&holder.mutex);
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, WaitForMutexFn, &holder));
+  while (!holder.waiting) {
+    usleep(1000);
+  }
+  usleep(100000);
+  pthread_mutex_unlock(&holder.mutex);
+  ASSERT_EQ(0, pthread_join(t, NULL));
+
+  android_trace_stop();
+  std::vector<android_trace_event> events = ReadEvents();
+  bool found = false;
+  for (size_t i = 0; i < events.size(); ++i) {
+    found = found || (events[i].type == ANDROID_TRACE_MUTEX_WAIT &&
+                      events[i].arg == reinterpret_cast<uintptr_t>(&holder.mutex));
+  }
+  ASSERT_TRUE(found);
+}
+
+TEST(trace_events, dlopen) {
+  ReadEvents();
+  ASSERT_EQ(0, android_trace_start(256));
+  void* handle = dlopen("libc.so", RTLD_NOW);
+  ASSERT_TRUE(handle != NULL);
+  ASSERT_EQ(0, dlclose(handle));
+  android_trace_stop();
+
+  std::vector<android_trace_event> events = ReadEvents();
+  ASSERT_TRUE(HasEvent(events, ANDROID_TRACE_DLOPEN, gettid(), reinterpret_cast<uintptr_t>(handle)));
+  ASSERT_TRUE(HasEvent(events, ANDROID_TRACE_DLCLOSE, gettid(), reinterpret_cast<uintptr_t>(handle)));
+}
+
+TEST(trace_events, dropped_and_dump) {
+  ReadEvents();
+  ASSERT_EQ(0, android_trace_start(16));
+
+  // More events than this thread's buffer holds, however big it is from
+  // earlier tests.
+  pthread_t t;
+  for (int i = 0; i < 600; ++i) {
+    ASSERT_EQ(0, pthread_create(&t, NULL, ChildFn, NULL));
+    ASSERT_EQ(0, pthread_join(t, NULL));
+  }
+
+  char path[] = "/data/local/tmp/trace_events_testXXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  unlink(path);
+  ssize_t count = android_trace_dump(fd);
+  ASSERT_GT(count, 0);
+  struct stat sb;
+  ASSERT_EQ(0, fstat(fd, &sb));
+  ASSERT_EQ(count * static_cast<ssize_t>(sizeof(android_trace_event)), sb.st_size);
+  std::vector<android_trace_event> dumped(count);
+  ASSERT_EQ(sb.st_size, pread(fd, &dumped[0], sb.st_size, 0));
+  close(fd);
+  ASSERT_EQ(0U, ReadEvents().size());
+
+  // Now that there's room, the next event is preceded by a count of those lost.
+  ASSERT_EQ(0, pthread_create(&t, NULL, ChildFn, NULL));
+  ASSERT_EQ(0, pthread_join(t, NULL));
+  android_trace_stop();
+
+  std::vector<android_trace_event> events = ReadEvents();
+  bool found = false;
+  for (size_t i = 0; i < events.size(); ++i) {
+    if (events[i].type == ANDROID_TRACE_DROPPED && events[i].tid == gettid()) {
+      ASSERT_GE(events[i].arg, 600U - 256U);
+      found = true;
+    }
+  }
+  ASSERT_TRUE(found);
+  ASSERT_TRUE(HasEvent(events, ANDROID_TRACE_THREAD_CREATE, gettid(), gChildTid));
+}
+
+#endif // __BIONIC__
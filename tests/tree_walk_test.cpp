@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#if defined(__BIONIC__)
+
+#include <android/tree_walk.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <set>
+#include <string>
+
+// Makes a tree of 'width' directories 'depth' deep, each holding 'width' files
+// and a symbolic link, under a new temporary directory.
+class TreeWalkTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    char dir_template[] = "/data/local/tmp/tree_walk-XXXXXX";
+    ASSERT_TRUE(mkdtemp(dir_template) != NULL);
+    root_ = dir_template;
+    expected_.insert(root_);
+    Make(root_, 3, 4);
+  }
+
+  virtual void TearDown() {
+    for (std::set<std::string>::reverse_iterator it = expected_.rbegin(); it != expected_.rend(); ++it) {
+      remove(it->c_str());
+    }
+  }
+
+  void Make(const std::string& dir, int depth, int width) {
+    for (int i = 0; i < width; ++i) {
+      char name[16];
+      snprintf(name, sizeof(name), "/file%d", i);
+      std::string path(dir + name);
+      int fd = open(path.c_str(), O_CREAT | O_WRONLY, 0600);
+      ASSERT_NE(-1, fd);
+      close(fd);
+      expected_.insert(path);
+    }
+    std::string link(dir + "/link");
+    ASSERT_EQ(0, symlink("..", link.c_str()));
+    expected_.insert(link);
+    if (depth > 0) {
+      for (int i = 0; i < width; ++i) {
+        char name[16];
+        snprintf(name, sizeof(name), "/dir%d", i);
+        std::string path(dir + name);
+        ASSERT_EQ(0, mkdir(path.c_str(), 0700));
+        expected_.insert(path);
+        Make(path, depth - 1, width);
+      }
+    }
+  }
+
+  std::string root_;
+  std::set<std::string> expected_;
+};
+
+struct Walked {
+  pthread_mutex_t mutex;
+  std::set<std::string> paths;
+  size_t stats;
+  bool bad_type;
+  const char* skip;
+};
+
+static int Collect(const android_tree_walk_entry* entry, void* arg) {
+  Walked* walked = reinterpret_cast<Walked*>(arg);
+  pthread_mutex_lock(&walked->mutex);
+  walked->paths.insert(entry->path);
+  if (entry->stat != NULL) {
+    ++walked->stats;
+  }
+  if (strncmp(entry->name, "file", 4) == 0 && entry->type != DT_REG) {
+    walked->bad_type = true;
+  }
+  if (strcmp(entry->name, "link") == 0 && entry->type != DT_LNK) {
+    walked->bad_type = true;
+  }
+  bool skip = walked->skip != NULL && strcmp(entry->name, walked->skip) == 0;
+  pthread_mutex_unlock(&walked->mutex);
+  return skip ? ANDROID_TREE_WALK_SKIP : 0;
+}
+
+TEST_F(TreeWalkTest, android_tree_walk) {
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    Walked walked = { PTHREAD_MUTEX_INITIALIZER, std::set<std::string>(), 0, false, NULL };
+    ASSERT_EQ(0, android_tree_walk(root_.c_str(), 0, threads, Collect, &walked));
+    ASSERT_TRUE(walked.paths == expected_) << threads;
+    ASSERT_FALSE(walked.bad_type);
+  }
+}
+
+TEST_F(TreeWalkTest, android_tree_walk_STAT) {
+  Walked walked = { PTHREAD_MUTEX_INITIALIZER, std::set<std::string>(), 0, false, NULL };
+  ASSERT_EQ(0, android_tree_walk(root_.c_str(), ANDROID_TREE_WALK_STAT, 4, Collect, &walked));
+  ASSERT_TRUE(walked.paths == expected_);
+  ASSERT_EQ(expected_.size(), walked.stats);
+}
+
+TEST_F(TreeWalkTest, android_tree_walk_SKIP) {
+  Walked walked = { PTHREAD_MUTEX_INITIALIZER, std::set<std::string>(), 0, false, "dir0" };
+  ASSERT_EQ(0, android_tree_walk(root_.c_str(), 0, 4, Collect, &walked));
+  for (std::set<std::string>::iterator it = walked.paths.begin(); it != walked.paths.end(); ++it) {
+    ASSERT_TRUE(it->find("/dir0/") == std::string::npos) << *it;
+  }
+  ASSERT_TRUE(walked.paths.find(root_ + "/dir0") != walked.paths.end());
+  ASSERT_TRUE(walked.paths.find(root_ + "/dir1/dir2/file3") != walked.paths.end());
+}
+
+static int StopAtFile(const android_tree_walk_entry* entry, void*) {
+  return (entry->type == DT_REG) ? 123 : 0;
+}
+
+TEST_F(TreeWalkTest, android_tree_walk_stop) {
+  ASSERT_EQ(123, android_tree_walk(root_.c_str(), 0, 4, StopAtFile, NULL));
+}
+
+TEST(tree_walk, android_tree_walk_missing_root) {
+  errno = 0;
+  ASSERT_EQ(-1, android_tree_walk("/does-not-exist", 0, 2, StopAtFile, NULL));
+  ASSERT_EQ(ENOENT, errno);
+}
+
+#endif // __BIONIC__
@@ -16,13 +16,38 @@
 
 #include <gtest/gtest.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 TEST(unistd, sysconf_SC_MONOTONIC_CLOCK) {
   ASSERT_GT(sysconf(_SC_MONOTONIC_CLOCK), 0);
 }
 
+TEST(unistd, sysconf_SC_NPROCESSORS) {
+  long conf = sysconf(_SC_NPROCESSORS_CONF);
+  long onln = sysconf(_SC_NPROCESSORS_ONLN);
+  ASSERT_GT(conf, 0);
+  ASSERT_GT(onln, 0);
+  ASSERT_LE(onln, conf);
+  // Repeated calls are answered from the cache.
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(conf, sysconf(_SC_NPROCESSORS_CONF));
+  }
+}
+
+TEST(unistd, sysconf_SC_PHYS_PAGES) {
+  long phys = sysconf(_SC_PHYS_PAGES);
+  long avphys = sysconf(_SC_AVPHYS_PAGES);
+  ASSERT_GT(phys, 0);
+  ASSERT_GT(avphys, 0);
+  ASSERT_LE(avphys, phys);
+}
+
 TEST(unistd, sbrk) {
   void* initial_break = sbrk(0);
 
@@ -32,3 +57,56 @@ TEST(unistd, sbrk) {
   void* final_break = sbrk(0);
   ASSERT_EQ(final_break, new_break);
 }
+
+TEST(unistd, dup3) {
+  int fd = open("/proc/version", O_RDONLY);
+  ASSERT_NE(-1, fd);
+  int new_fd = dup(fd);
+  ASSERT_NE(-1, new_fd);
+  ASSERT_EQ(0, fcntl(new_fd, F_GETFD));
+
+  // dup3 atomically replaces what was at new_fd.
+  ASSERT_EQ(new_fd, dup3(fd, new_fd, O_CLOEXEC));
+  ASSERT_EQ(FD_CLOEXEC, fcntl(new_fd, F_GETFD));
+  ASSERT_EQ(0, fcntl(fd, F_GETFD));
+
+  // Unlike dup2, dup3 refuses to dup an fd onto itself.
+  ASSERT_EQ(-1, dup3(fd, fd, 0));
+  ASSERT_EQ(EINVAL, errno);
+
+  close(new_fd);
+  close(fd);
+}
+
+static pid_t kernel_gettid() {
+  return syscall(__NR_gettid);
+}
+
+static void* GettidFn(void* arg) {
+  *reinterpret_cast<pid_t*>(arg) = kernel_gettid();
+  return reinterpret_cast<void*>(gettid());
+}
+
+// gettid returns a cached tid, which has to be right in new threads and fork children too.
+TEST(unistd, gettid) {
+  ASSERT_EQ(getpid(), gettid());
+  ASSERT_EQ(kernel_gettid(), gettid());
+
+  pid_t thread_tid = 0;
+  pthread_t t;
+  ASSERT_EQ(0, pthread_create(&t, NULL, GettidFn, &thread_tid));
+  void* result;
+  ASSERT_EQ(0, pthread_join(t, &result));
+  ASSERT_NE(getpid(), thread_tid);
+  ASSERT_EQ(thread_tid, static_cast<pid_t>(reinterpret_cast<intptr_t>(result)));
+
+  pid_t pid = fork();
+  ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    _exit((gettid() == kernel_gettid() && gettid() == getpid()) ? 0 : 1);
+  }
+  int status;
+  ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+}
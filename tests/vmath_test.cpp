@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__BIONIC__)
+#include <android/vmath.h>
+
+// Every kind of lane: ordinary arguments, ones near the edges of the ranges
+// the vector code covers, and the special ones left to the scalar functions.
+static const float kArgs[] = {
+  0.0f, -0.0f, 1e-40f, 1e-30f, 1e-5f, 0.1f, 0.5f, 0.75f, 1.0f, -1.0f, 1.5f, 2.0f, 3.0f,
+  3.14159265f, -3.14159265f, 10.0f, -10.0f, 85.9f, -85.9f, 88.7f, -103.0f, 1000.0f,
+  8191.5f, -8192.0f, 1e6f, 1e30f, HUGE_VALF, -HUGE_VALF, NAN,
+};
+static const size_t kArgCount = sizeof(kArgs) / sizeof(kArgs[0]);
+
+// The difference between 'actual' and 'expected', in units in the last place of
+// a float of the size of 'expected'.
+static double UlpError(float actual, double expected) {
+  if (isnan(expected)) {
+    return isnan(actual) ? 0.0 : HUGE_VAL;
+  }
+  if (isinf(expected) || isinf(actual) || expected == 0.0) {
+    return (actual == static_cast<float>(expected)) ? 0.0 : HUGE_VAL;
+  }
+  int exponent;
+  frexp(expected, &exponent);
+  double ulp = ldexp(1.0, (exponent - 24 < -149) ? -149 : exponent - 24);
+  return fabs(actual - expected) / ulp;
+}
+
+// Runs 'vfn' over every prefix of kArgs, so that each length of tail is covered,
+// and checks each result against 'fn' in double precision. The special lanes get
+// the scalar function's result, so only its one ulp bound holds for all of them.
+static void CheckUnary(void (*vfn)(const float*, float*, size_t), double (*fn)(double),
+                       double max_ulp) {
+  for (size_t n = 0; n <= kArgCount; ++n) {
+    float out[kArgCount + 1];
+    out[n] = 123.0f;
+    vfn(kArgs, out, n);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_LE(UlpError(out[i], fn(kArgs[i])), 1.0) << "n=" << n << " x=" << kArgs[i];
+    }
+    ASSERT_EQ(123.0f, out[n]);
+  }
+
+  // In place, over a range that only the vector code handles.
+  float data[1000];
+  float x[1000];
+  for (size_t i = 0; i < 1000; ++i) {
+    data[i] = x[i] = 0.01f * (i + 1);
+  }
+  vfn(data, data, 1000);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_LE(UlpError(data[i], fn(x[i])), max_ulp) << "x=" << x[i];
+  }
+}
+#endif
+
+TEST(vmath, vexpf) {
+#if defined(__BIONIC__)
+  CheckUnary(vexpf, exp, 0.6);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vlogf) {
+#if defined(__BIONIC__)
+  CheckUnary(vlogf, log, 0.6);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vsinf) {
+#if defined(__BIONIC__)
+  CheckUnary(vsinf, sin, 0.8);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vcosf) {
+#if defined(__BIONIC__)
+  CheckUnary(vcosf, cos, 0.8);
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vpowf) {
+#if defined(__BIONIC__)
+  float x[kArgCount * kArgCount];
+  float y[kArgCount * kArgCount];
+  for (size_t i = 0; i < kArgCount; ++i) {
+    for (size_t j = 0; j < kArgCount; ++j) {
+      x[i * kArgCount + j] = kArgs[i];
+      y[i * kArgCount + j] = kArgs[j];
+    }
+  }
+  // Odd, so that there's a tail.
+  const size_t n = kArgCount * kArgCount;
+  float out[n];
+  vpowf(x, y, out, n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_LE(UlpError(out[i], pow(static_cast<double>(x[i]), y[i])), 1.0) << "x=" << x[i] << " y=" << y[i];
+  }
+
+  // Random arguments whose results are neither overflows nor underflows.
+  srandom(1);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = ldexpf(1.0f + random() / (float) RAND_MAX, random() % 64 - 32);
+    y[i] = (random() / (float) RAND_MAX - 0.5f) * 8.0f;
+  }
+  vpowf(x, y, out, n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_LE(UlpError(out[i], pow(static_cast<double>(x[i]), y[i])), 0.6) << "x=" << x[i] << " y=" << y[i];
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vftoi16) {
+#if defined(__BIONIC__)
+  // Ties go to even, out-of-range values saturate and NaNs give 0. Odd, so that there's a tail.
+  const float x[] = {
+    0.0f, -0.0f, 0.5f, 1.5f, 2.5f, -2.5f, 0.49999997f, 32766.5f, 32767.5f, -32768.5f,
+    1e10f, -1e10f, HUGE_VALF, -HUGE_VALF, NAN, 1e-40f, 1234.7f,
+  };
+  const int16_t expected[] = {
+    0, 0, 0, 2, 2, -2, 0, 32766, 32767, -32768,
+    32767, -32768, 32767, -32768, 0, 0, 1235,
+  };
+  const size_t n = sizeof(x) / sizeof(x[0]);
+  int16_t out[n + 1];
+  out[n] = 123;
+  vftoi16(x, 1.0f, out, n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(expected[i], out[i]) << "x=" << x[i];
+  }
+  ASSERT_EQ(123, out[n]);
+
+  float samples[1001];
+  int16_t pcm[1001];
+  for (size_t i = 0; i < 1001; ++i) {
+    samples[i] = (i - 500.0f) / 400.0f;
+  }
+  vftoi16(samples, 32768.0f, pcm, 1001);
+  for (size_t i = 0; i < 1001; ++i) {
+    long v = lrintf(samples[i] * 32768.0f);
+    ASSERT_EQ((v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : v, pcm[i]) << "x=" << samples[i];
+  }
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
+
+TEST(vmath, vi16tof) {
+#if defined(__BIONIC__)
+  // Every 16-bit value, each back to the sample it came from.
+  int16_t x[65536];
+  float out[65536];
+  for (int i = 0; i < 65536; ++i) {
+    x[i] = static_cast<int16_t>(i - 32768);
+  }
+  vi16tof(x, 1.0f / 32768, out, 65536);
+  for (int i = 0; i < 65536; ++i) {
+    ASSERT_EQ((i - 32768) / 32768.0f, out[i]);
+  }
+  int16_t round_trip[65536];
+  vftoi16(out, 32768.0f, round_trip, 65536);
+  ASSERT_EQ(0, memcmp(x, round_trip, sizeof(x)));
+#else // __BIONIC__
+  GTEST_LOG_(INFO) << "This test does nothing.\n";
+#endif // __BIONIC__
+}
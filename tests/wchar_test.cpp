@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+TEST(wchar, swprintf) {
+  wchar_t buf[64];
+  ASSERT_EQ(17, swprintf(buf, 64, L"%d %5s|%-4ls|%x", -12, "ab", L"cd", 255));
+  ASSERT_STREQ(L"-12    ab|cd  |ff", buf);
+
+  ASSERT_EQ(8, swprintf(buf, 64, L"%.3f %lc%c", 3.14159, L'w', 'n'));
+  ASSERT_STREQ(L"3.142 wn", buf);
+}
+
+TEST(wchar, swprintf_overflow) {
+  // Unlike snprintf, it's an error for the output not to fit.
+  wchar_t buf[4];
+  ASSERT_EQ(-1, swprintf(buf, 4, L"%d", 12345));
+  ASSERT_EQ(3, swprintf(buf, 4, L"%d", 123));
+  ASSERT_STREQ(L"123", buf);
+}
+
+TEST(wchar, fwprintf) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(9, fwprintf(fp, L"%ls=%d %s", L"key", 42, "ok"));
+  ASSERT_EQ(0, fflush(fp));
+
+  // Read underneath stdio, as the stream is now a wide one.
+  char buf[16];
+  ASSERT_EQ(9, pread(fileno(fp), buf, sizeof(buf), 0));
+  ASSERT_EQ(0, memcmp("key=42 ok", buf, 9));
+  fclose(fp);
+}
+
+TEST(wchar, swscanf) {
+  int i;
+  double d;
+  char s[16];
+  wchar_t ws[16];
+  ASSERT_EQ(4, swscanf(L" 42 2.5 name=value", L"%d %lf %[a-z]=%ls", &i, &d, s, ws));
+  ASSERT_EQ(42, i);
+  ASSERT_EQ(2.5, d);
+  ASSERT_STREQ("name", s);
+  ASSERT_STREQ(L"value", ws);
+
+  ASSERT_EQ(0, swscanf(L"y:1", L"x:%d", &i));
+  ASSERT_EQ(EOF, swscanf(L"", L"%d", &i));
+}
+
+TEST(wchar, fwscanf) {
+  FILE* fp = tmpfile();
+  ASSERT_TRUE(fp != NULL);
+  // Write underneath stdio, because glibc won't read wide characters
+  // from a stream that has been used for bytes.
+  ASSERT_EQ(6, write(fileno(fp), "17 abc", 6));
+  ASSERT_EQ(0, lseek(fileno(fp), 0, SEEK_SET));
+
+  int i;
+  wchar_t ws[16];
+  ASSERT_EQ(2, fwscanf(fp, L"%d %ls", &i, ws));
+  ASSERT_EQ(17, i);
+  ASSERT_STREQ(L"abc", ws);
+  fclose(fp);
+}
+
+TEST(wchar, wcslen_wcschr_wcscmp) {
+  // Every length and alignment either side of a 16-byte block.
+  wchar_t buf[48];
+  wchar_t other[48];
+  for (size_t align = 0; align < 4; ++align) {
+    for (size_t len = 0; len < 40; ++len) {
+      wchar_t* s = buf + align;
+      wmemset(s, L'x', len);
+      s[len] = 0;
+      ASSERT_EQ(len, wcslen(s));
+      ASSERT_TRUE(wcschr(s, L'y') == NULL);
+      ASSERT_TRUE(wcschr(s, 0) == s + len);
+      if (len > 0) {
+        s[len - 1] = L'y';
+        ASSERT_TRUE(wcschr(s, L'y') == s + len - 1);
+      }
+
+      for (size_t other_align = 0; other_align < 4; ++other_align) {
+        wchar_t* t = other + other_align;
+        wmemcpy(t, s, len + 1);
+        ASSERT_EQ(0, wcscmp(s, t));
+        if (len > 0) {
+          t[len - 1] = L'z';
+          ASSERT_LT(wcscmp(s, t), 0);
+          ASSERT_GT(wcscmp(t, s), 0);
+          t[len - 1] = 0;
+          ASSERT_GT(wcscmp(s, t), 0);
+          ASSERT_LT(wcscmp(t, s), 0);
+        }
+      }
+    }
+  }
+}